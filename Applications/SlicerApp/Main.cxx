@@ -185,6 +185,11 @@ int SlicerAppMain(int argc, char* argv[])
     {
     qDebug() << "Number of instantiated modules:"
              << moduleFactoryManager->instantiatedModuleNames().count();
+    if (moduleFactoryManager->deferInstantiation())
+      {
+      qDebug() << "Number of deferred modules:"
+               << moduleFactoryManager->deferredModuleNames().count();
+      }
     }
   // Create main window
   splashMessage(splashScreen, "Initializing user interface...");
@@ -233,6 +238,11 @@ int SlicerAppMain(int argc, char* argv[])
     splashScreen->finish(window.data());
     }
 
+  if (!app.commandOptions()->moduleStartupTrace().isEmpty())
+    {
+    moduleFactoryManager->writeStartupTrace(app.commandOptions()->moduleStartupTrace());
+    }
+
   // Process command line argument after the event loop is started
   QTimer::singleShot(0, &app, SLOT(handleCommandLineArguments()));
 
@@ -19,14 +19,402 @@
 ==============================================================================*/
 
 // QT includes
+#include <QDir>
+#include <QFile>
+#include <QVariant>
+
+// CTK includes
+#include <ctkAbstractFileBasedFactory.h>
 
 // SlicerApp includes
 #include <qSlicerModuleFactoryManager.h>
 #include <qSlicerCoreModuleFactory.h>
 #include <qSlicerCoreApplication.h>
+#include <qSlicerEventBrokerModule.h>
 
 // STD includes
 
+namespace
+{
+
+int TestModuleInstantiationCount = 0;
+
+//----------------------------------------------------------------------------
+/// Minimal JSON parser, enough to read the startup trace.
+/// Objects are parsed into QVariantMap, arrays into QVariantList.
+class JSONParser
+{
+public:
+  JSONParser(const QString& text) : Text(text), Position(0), Valid(true) {}
+
+  /// Return an invalid QVariant if \a text is not a single JSON value
+  QVariant parse()
+    {
+    QVariant value = this->parseValue();
+    this->skipWhitespaces();
+    return (this->Valid && this->Position == this->Text.size()) ? value : QVariant();
+    }
+
+protected:
+  void skipWhitespaces()
+    {
+    while (this->Position < this->Text.size() && this->Text.at(this->Position).isSpace())
+      {
+      ++this->Position;
+      }
+    }
+
+  bool accept(const QString& token)
+    {
+    this->skipWhitespaces();
+    if (this->Text.mid(this->Position, token.size()) != token)
+      {
+      return false;
+      }
+    this->Position += token.size();
+    return true;
+    }
+
+  QVariant parseValue()
+    {
+    this->skipWhitespaces();
+    if (this->Position >= this->Text.size())
+      {
+      this->Valid = false;
+      return QVariant();
+      }
+    QChar c = this->Text.at(this->Position);
+    if (c == '{')
+      {
+      return this->parseObject();
+      }
+    if (c == '[')
+      {
+      return this->parseArray();
+      }
+    if (c == '"')
+      {
+      return this->parseString();
+      }
+    if (this->accept("true"))
+      {
+      return QVariant(true);
+      }
+    if (this->accept("false"))
+      {
+      return QVariant(false);
+      }
+    if (this->accept("null"))
+      {
+      return QVariant();
+      }
+    return this->parseNumber();
+    }
+
+  QVariant parseObject()
+    {
+    QVariantMap object;
+    this->accept("{");
+    if (this->accept("}"))
+      {
+      return object;
+      }
+    do
+      {
+      this->skipWhitespaces();
+      QString key = this->parseString();
+      if (!this->accept(":"))
+        {
+        this->Valid = false;
+        return QVariant();
+        }
+      object[key] = this->parseValue();
+      }
+    while (this->Valid && this->accept(","));
+    this->Valid = this->Valid && this->accept("}");
+    return object;
+    }
+
+  QVariant parseArray()
+    {
+    QVariantList array;
+    this->accept("[");
+    if (this->accept("]"))
+      {
+      return array;
+      }
+    do
+      {
+      array << this->parseValue();
+      }
+    while (this->Valid && this->accept(","));
+    this->Valid = this->Valid && this->accept("]");
+    return array;
+    }
+
+  QString parseString()
+    {
+    QString value;
+    if (this->Position >= this->Text.size() || this->Text.at(this->Position) != '"')
+      {
+      this->Valid = false;
+      return value;
+      }
+    for (++this->Position; this->Position < this->Text.size(); ++this->Position)
+      {
+      QChar c = this->Text.at(this->Position);
+      if (c == '"')
+        {
+        ++this->Position;
+        return value;
+        }
+      if (c == '\\' && ++this->Position < this->Text.size())
+        {
+        c = this->Text.at(this->Position);
+        switch (c.toLatin1())
+          {
+          case 'n': c = '\n'; break;
+          case 't': c = '\t'; break;
+          case 'r': c = '\r'; break;
+          case 'b': c = '\b'; break;
+          case 'f': c = '\f'; break;
+          case 'u':
+            c = QChar(this->Text.mid(this->Position + 1, 4).toUShort(0, 16));
+            this->Position += 4;
+            break;
+          default: break;
+          }
+        }
+      value += c;
+      }
+    this->Valid = false;
+    return value;
+    }
+
+  QVariant parseNumber()
+    {
+    int start = this->Position;
+    while (this->Position < this->Text.size() &&
+           (this->Text.at(this->Position).isDigit() ||
+            QString("+-.eE").contains(this->Text.at(this->Position))))
+      {
+      ++this->Position;
+      }
+    bool ok = false;
+    double number = this->Text.mid(start, this->Position - start).toDouble(&ok);
+    this->Valid = this->Valid && ok;
+    return QVariant(number);
+    }
+
+  QString Text;
+  int Position;
+  bool Valid;
+};
+
+//----------------------------------------------------------------------------
+/// Check that the startup trace is valid JSON and that it has an event of
+/// each phase and a summary for \a moduleName.
+bool checkStartupTrace(const QString& startupTrace, const QString& moduleName)
+{
+  QVariantMap trace = JSONParser(startupTrace).parse().toMap();
+  if (!trace.contains("traceEvents") || !trace.contains("modules"))
+    {
+    std::cerr << "Invalid startup trace:" << std::endl << qPrintable(startupTrace) << std::endl;
+    return false;
+    }
+  QVariantMap summary = trace["modules"].toMap()[moduleName].toMap();
+  foreach(const QString& phase, QStringList() << "register" << "instantiate" << "setup")
+    {
+    bool found = false;
+    foreach(const QVariant& eventVariant, trace["traceEvents"].toList())
+      {
+      QVariantMap event = eventVariant.toMap();
+      if (event["name"].toString() == moduleName && event["cat"].toString() == phase)
+        {
+        found = event["ph"].toString() == "X"
+          && event["ts"].type() == QVariant::Double && event["ts"].toDouble() >= 0.
+          && event["dur"].type() == QVariant::Double && event["dur"].toDouble() >= 0.;
+        break;
+        }
+      }
+    if (!found)
+      {
+      std::cerr << "No valid " << qPrintable(phase) << " event for module "
+                << qPrintable(moduleName) << " in startup trace:" << std::endl
+                << qPrintable(startupTrace) << std::endl;
+      return false;
+      }
+    if (summary[phase].type() != QVariant::Double || summary[phase].toDouble() < 0.)
+      {
+      std::cerr << "No " << qPrintable(phase) << " time in the summary of module "
+                << qPrintable(moduleName) << std::endl;
+      return false;
+      }
+    }
+  if (summary["deferred"].type() != QVariant::Bool || summary["deferred"].toBool())
+    {
+    std::cerr << "Module " << qPrintable(moduleName) << " is not reported as instantiated" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// File based module item: every "*.testmodule" file is an event broker
+/// module named after the file.
+class qSlicerTestModuleFactoryItem
+  : public ctkAbstractFactoryFileBasedItem<qSlicerAbstractCoreModule>
+{
+public:
+  virtual bool load()
+    {
+    return true;
+    }
+protected:
+  virtual qSlicerAbstractCoreModule* instanciator()
+    {
+    ++TestModuleInstantiationCount;
+    return new qSlicerEventBrokerModule;
+    }
+};
+
+//----------------------------------------------------------------------------
+class qSlicerTestModuleFactory
+  : public ctkAbstractFileBasedFactory<qSlicerAbstractCoreModule>
+{
+public:
+  typedef ctkAbstractFileBasedFactory<qSlicerAbstractCoreModule> Superclass;
+  virtual QString fileNameToKey(const QString& fileName)const
+    {
+    return QFileInfo(fileName).baseName();
+    }
+protected:
+  virtual bool isValidFile(const QFileInfo& file)const
+    {
+    return this->Superclass::isValidFile(file) && file.suffix() == "testmodule";
+    }
+  virtual ctkAbstractFactoryItem<qSlicerAbstractCoreModule>* createFactoryFileBasedItem()
+    {
+    return new qSlicerTestModuleFactoryItem;
+    }
+};
+
+//----------------------------------------------------------------------------
+void setupTestModuleFactoryManager(qSlicerModuleFactoryManager& moduleFactoryManager,
+                                   const QString& cacheFilePath,
+                                   const QStringList& moduleFilePaths,
+                                   const QString& moduleToDefer)
+{
+  moduleFactoryManager.registerFactory(new qSlicerTestModuleFactory);
+  moduleFactoryManager.setModuleMetadataCacheFilePath(cacheFilePath);
+  moduleFactoryManager.setDeferInstantiation(true);
+  moduleFactoryManager.setModulesToDefer(QStringList() << moduleToDefer);
+  foreach(const QString& moduleFilePath, moduleFilePaths)
+    {
+    moduleFactoryManager.registerModule(QFileInfo(moduleFilePath));
+    }
+  moduleFactoryManager.instantiateModules();
+}
+
+//----------------------------------------------------------------------------
+int deferredInstantiationTest()
+{
+  // Only the modules listed in modulesToDefer are deferred
+  const QString deferredModuleName = "qSlicerModuleFactoryManagerTest1Deferred";
+  const QString moduleName = "qSlicerModuleFactoryManagerTest1NotDeferred";
+  QDir tempDir(QDir::tempPath());
+  const QString cacheFilePath = tempDir.filePath("qSlicerModuleFactoryManagerTest1-ModuleMetadata.ini");
+  QStringList moduleFilePaths;
+  moduleFilePaths << tempDir.filePath(deferredModuleName + ".testmodule")
+                  << tempDir.filePath(moduleName + ".testmodule");
+  QFile::remove(cacheFilePath);
+  foreach(const QString& moduleFilePath, moduleFilePaths)
+    {
+    QFile moduleFile(moduleFilePath);
+    if (!moduleFile.open(QIODevice::WriteOnly))
+      {
+      std::cerr << __LINE__ << " - Failed to write " << qPrintable(moduleFilePath) << std::endl;
+      return EXIT_FAILURE;
+      }
+    moduleFile.write("test module");
+    }
+
+  // No metadata is cached yet: all the modules are instantiated
+  QString title;
+  {
+  qSlicerModuleFactoryManager moduleFactoryManager;
+  setupTestModuleFactoryManager(moduleFactoryManager, cacheFilePath, moduleFilePaths, deferredModuleName);
+  if (!moduleFactoryManager.deferredModuleNames().isEmpty() ||
+      !moduleFactoryManager.isInstantiated(deferredModuleName) ||
+      !moduleFactoryManager.isInstantiated(moduleName) ||
+      TestModuleInstantiationCount != 2)
+    {
+    moduleFactoryManager.printAdditionalInfo();
+    std::cerr << __LINE__ << " - Error in instantiateModules(): modules without cached metadata are deferred" << std::endl;
+    return EXIT_FAILURE;
+    }
+  title = moduleFactoryManager.moduleMetadata(deferredModuleName).value("title").toString();
+  if (title.isEmpty())
+    {
+    std::cerr << __LINE__ << " - Error in moduleMetadata(): no title is cached" << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  // Metadata is cached: the module to defer is not instantiated
+  qSlicerModuleFactoryManager moduleFactoryManager;
+  setupTestModuleFactoryManager(moduleFactoryManager, cacheFilePath, moduleFilePaths, deferredModuleName);
+  if (moduleFactoryManager.deferredModuleNames() != QStringList(deferredModuleName) ||
+      !moduleFactoryManager.isDeferred(deferredModuleName) ||
+      moduleFactoryManager.isInstantiated(deferredModuleName) ||
+      !moduleFactoryManager.isInstantiated(moduleName) ||
+      TestModuleInstantiationCount != 3)
+    {
+    moduleFactoryManager.printAdditionalInfo();
+    std::cerr << __LINE__ << " - Error in instantiateModules(): "
+              << qPrintable(deferredModuleName) << " is not the only deferred module" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (moduleFactoryManager.moduleMetadata(deferredModuleName).value("title").toString() != title)
+    {
+    std::cerr << __LINE__ << " - Error in moduleMetadata(): invalid cached title" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The deferred module is created on demand
+  moduleFactoryManager.loadModules();
+  if (moduleFactoryManager.isLoaded(deferredModuleName))
+    {
+    std::cerr << __LINE__ << " - Error in loadModules(): deferred module is loaded" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!moduleFactoryManager.loadModule(deferredModuleName) ||
+      moduleFactoryManager.isDeferred(deferredModuleName) ||
+      !moduleFactoryManager.isInstantiated(deferredModuleName) ||
+      !moduleFactoryManager.loadedModule(deferredModuleName) ||
+      TestModuleInstantiationCount != 4)
+    {
+    moduleFactoryManager.printAdditionalInfo();
+    std::cerr << __LINE__ << " - Error in loadModule(): deferred module is not instantiated on demand" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (moduleFactoryManager.loadedModule(deferredModuleName)->title() != title)
+    {
+    std::cerr << __LINE__ << " - Error in loadModule(): title differs from the cached title" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  moduleFactoryManager.unloadModules();
+  QFile::remove(cacheFilePath);
+  foreach(const QString& moduleFilePath, moduleFilePaths)
+    {
+    QFile::remove(moduleFilePath);
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
 
 int qSlicerModuleFactoryManagerTest1(int argc, char * argv[])
 {
@@ -64,10 +452,23 @@ int qSlicerModuleFactoryManagerTest1(int argc, char * argv[])
     return EXIT_FAILURE;
     }
 
+  // Register, instantiate and setup times are traced
+  if (!checkStartupTrace(moduleFactoryManager.startupTrace(), moduleName))
+    {
+    std::cerr << __LINE__ << " - Error in startupTrace()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   moduleFactoryManager.unloadModules();
 
-  // Instantiate again
+  // Instantiate again, core modules are never deferred
+  moduleFactoryManager.setDeferInstantiation(true);
   moduleFactoryManager.instantiateModules();
+  if (!moduleFactoryManager.deferredModuleNames().isEmpty())
+    {
+    std::cerr << __LINE__ << " - Error in instantiateModules(): core modules are deferred" << std::endl;
+    return EXIT_FAILURE;
+    }
   moduleFactoryManager.loadModules();
   abstractModule = moduleFactoryManager.moduleInstance(moduleName);
 
@@ -104,6 +505,6 @@ int qSlicerModuleFactoryManagerTest1(int argc, char * argv[])
 
   moduleFactoryManager.unloadModules();
 
-  return EXIT_SUCCESS;
+  return deferredInstantiationTest();
 }
 
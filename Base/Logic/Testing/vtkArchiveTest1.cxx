@@ -166,6 +166,55 @@ int vtkArchiveTest1(int argc, char * argv[] )
     std::cerr << "failed to extract archive : " << "extractedArchiveTest" << std::endl;
     return EXIT_FAILURE;
     }
+  vtksys::SystemTools::ChangeDirectory("..");
+
+  //
+  // read a single entry into memory
+  //
+  std::string content;
+  if (!read_archive_entry(zipFilePath.c_str(), "archiveTest/vol.mrml", content)
+      || content.size() != vtksys::SystemTools::FileLength("archiveTest/vol.mrml")
+      || content.find("<MRML") == std::string::npos)
+    {
+    std::cerr << "failed to read entry vol.mrml of " << zipFilePath << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (read_archive_entry(zipFilePath.c_str(), "archiveTest/missing.mrml", content))
+    {
+    std::cerr << "reading a missing entry did not fail" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // extract only some entries, in parallel
+  //
+  std::cout << "extracting selected entries into selectedArchiveTest" << std::endl;
+  if ( vtksys::SystemTools::FileExists("selectedArchiveTest") )
+    {
+    vtksys::SystemTools::RemoveADirectory("selectedArchiveTest");
+    }
+  vtksys::SystemTools::MakeDirectory("selectedArchiveTest");
+  std::vector<std::string> selectedEntries;
+  selectedEntries.push_back("archiveTest/vol_and_cube.mrml");
+  if (!unzip_entries(zipFilePath.c_str(), "selectedArchiveTest", selectedEntries, 4)
+      || !vtksys::SystemTools::FileExists("selectedArchiveTest/archiveTest/vol_and_cube.mrml", true)
+      || vtksys::SystemTools::FileExists("selectedArchiveTest/archiveTest/vol.mrml"))
+    {
+    std::cerr << "failed to extract selected entries of " << zipFilePath << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (vtksys::SystemTools::FilesDiffer("selectedArchiveTest/archiveTest/vol_and_cube.mrml",
+                                       "archiveTest/vol_and_cube.mrml"))
+    {
+    std::cerr << "extracted entry differs from original file" << std::endl;
+    return EXIT_FAILURE;
+    }
+  selectedEntries.push_back("archiveTest/missing.nhdr");
+  if (unzip_entries(zipFilePath.c_str(), "selectedArchiveTest", selectedEntries, 4))
+    {
+    std::cerr << "extracting a missing entry did not fail" << std::endl;
+    return EXIT_FAILURE;
+    }
 
   return EXIT_SUCCESS;
 }
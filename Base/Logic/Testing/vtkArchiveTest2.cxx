@@ -0,0 +1,289 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// SlicerLib includes
+#include "vtkArchive.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkType.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const size_t MiB = 1 << 20;
+
+//----------------------------------------------------------------------------
+bool WriteFile(const std::string& filePath, const std::string& content)
+{
+  std::ofstream file(filePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write(content.data(), content.size());
+  return file.good();
+}
+
+//----------------------------------------------------------------------------
+std::string ReadFile(const std::string& filePath)
+{
+  std::ifstream file(filePath.c_str(), std::ios::in | std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+//----------------------------------------------------------------------------
+/// Pseudo-random bytes, deflate cannot compress them
+std::string RandomData(size_t size, unsigned int seed)
+{
+  std::string data(size, '\0');
+  for (size_t i = 0; i < size; ++i)
+    {
+    seed = seed * 1103515245u + 12345u;
+    data[i] = static_cast<char>(seed >> 24);
+    }
+  return data;
+}
+
+//----------------------------------------------------------------------------
+/// Text made of randomly chosen words: compressible, but not a short repeated pattern
+std::string CompressibleData(size_t size, unsigned int seed)
+{
+  const char* words[] = { "segment ", "volume ", "model ", "markup ", "transform ", "table ",
+                          "0.125 ", "-42 ", "\n", "scene " };
+  std::string data;
+  data.reserve(size + 16);
+  while (data.size() < size)
+    {
+    seed = seed * 1103515245u + 12345u;
+    data += words[(seed >> 16) % 10];
+    }
+  data.resize(size);
+  return data;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 GetLittleEndian(const std::string& data, size_t position, int numberOfBytes)
+{
+  vtkTypeUInt64 value = 0;
+  for (int i = numberOfBytes - 1; i >= 0; --i)
+    {
+    value = (value << 8) | static_cast<unsigned char>(data[position + i]);
+    }
+  return value;
+}
+
+//----------------------------------------------------------------------------
+/// Read the compression method of each entry from the central directory,
+/// through the zip64 end of central directory record if there is one.
+bool GetEntryMethods(const std::string& zipFilePath, std::map<std::string, int>& methods)
+{
+  std::string zip = ReadFile(zipFilePath);
+  methods.clear();
+  std::string::size_type end = zip.rfind(std::string("PK\5\6", 4));
+  if (end == std::string::npos || end + 22 > zip.size())
+    {
+    std::cerr << "No end of central directory in " << zipFilePath << std::endl;
+    return false;
+    }
+  vtkTypeUInt64 numberOfEntries = GetLittleEndian(zip, end + 10, 2);
+  vtkTypeUInt64 directoryOffset = GetLittleEndian(zip, end + 16, 4);
+  if (numberOfEntries == 0xffff || directoryOffset == 0xffffffff)
+    {
+    // zip64 locator is right before the end of central directory
+    if (end < 20 || zip.compare(end - 20, 4, std::string("PK\6\7", 4)) != 0)
+      {
+      std::cerr << "No zip64 end of central directory locator in " << zipFilePath << std::endl;
+      return false;
+      }
+    vtkTypeUInt64 zip64End = GetLittleEndian(zip, end - 20 + 8, 8);
+    if (zip64End + 56 > zip.size() || zip.compare(zip64End, 4, std::string("PK\6\6", 4)) != 0)
+      {
+      std::cerr << "Invalid zip64 end of central directory in " << zipFilePath << std::endl;
+      return false;
+      }
+    numberOfEntries = GetLittleEndian(zip, zip64End + 32, 8);
+    directoryOffset = GetLittleEndian(zip, zip64End + 48, 8);
+    }
+  size_t position = directoryOffset;
+  for (vtkTypeUInt64 entry = 0; entry < numberOfEntries; ++entry)
+    {
+    if (position + 46 > zip.size() || zip.compare(position, 4, std::string("PK\1\2", 4)) != 0)
+      {
+      std::cerr << "Invalid central directory record " << entry << " in " << zipFilePath << std::endl;
+      return false;
+      }
+    int method = static_cast<int>(GetLittleEndian(zip, position + 10, 2));
+    size_t nameLength = GetLittleEndian(zip, position + 28, 2);
+    size_t extraLength = GetLittleEndian(zip, position + 30, 2);
+    size_t commentLength = GetLittleEndian(zip, position + 32, 2);
+    methods[zip.substr(position + 46, nameLength)] = method;
+    position += 46 + nameLength + extraLength + commentLength;
+    }
+  return methods.size() == numberOfEntries;
+}
+
+//----------------------------------------------------------------------------
+bool ResetDirectory(const std::string& directory)
+{
+  if (vtksys::SystemTools::FileExists(directory.c_str())
+      && !vtksys::SystemTools::RemoveADirectory(directory.c_str()))
+    {
+    std::cerr << "Cannot remove " << directory << std::endl;
+    return false;
+    }
+  return vtksys::SystemTools::MakeDirectory(directory.c_str());
+}
+
+//----------------------------------------------------------------------------
+/// Zip the directory, unzip it and compare the extracted files with the originals
+bool RoundTrip(const std::string& tempDirectory, const std::string& directoryName,
+               const std::map<std::string, std::string>& files, int numberOfThreads,
+               std::map<std::string, int>& methods)
+{
+  std::string zipFilePath = tempDirectory + "/" + directoryName + ".zip";
+  std::string extractDirectory = tempDirectory + "/" + directoryName + "Extracted";
+  vtksys::SystemTools::RemoveFile(zipFilePath.c_str());
+  if (!zip(zipFilePath.c_str(), (tempDirectory + "/" + directoryName).c_str(), numberOfThreads))
+    {
+    std::cerr << "Failed to zip " << directoryName << " with " << numberOfThreads << " threads" << std::endl;
+    return false;
+    }
+  if (!GetEntryMethods(zipFilePath, methods) || methods.size() != files.size() + 1
+      || methods.find(directoryName + "/") == methods.end())
+    {
+    std::cerr << "Unexpected entries in " << zipFilePath << std::endl;
+    return false;
+    }
+  if (!ResetDirectory(extractDirectory) || !unzip(zipFilePath.c_str(), extractDirectory.c_str()))
+    {
+    std::cerr << "Failed to unzip " << zipFilePath << std::endl;
+    return false;
+    }
+  for (std::map<std::string, std::string>::const_iterator fileIt = files.begin(); fileIt != files.end(); ++fileIt)
+    {
+    std::string extractedFilePath = extractDirectory + "/" + directoryName + "/" + fileIt->first;
+    if (!vtksys::SystemTools::FileExists(extractedFilePath.c_str(), true) || ReadFile(extractedFilePath) != fileIt->second)
+      {
+      std::cerr << "Extracted " << fileIt->first << " differs from the original file" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkArchiveTest2(int argc, char * argv[] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: vtkArchiveTest2 /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string tempDirectory = argv[1];
+
+  //
+  // Files spanning several deflate blocks and batches, stored and deflated entries
+  //
+  std::map<std::string, std::string> files;
+  // 8 blocks are deflated per batch with 2 threads: 2 full batches and a partial one
+  files["large.txt"] = CompressibleData(16 * MiB + 300000, 1);
+  // exactly one full batch
+  files["batch.txt"] = CompressibleData(8 * MiB, 2);
+  files["empty.txt"] = std::string();
+  // deflate expands incompressible data a little
+  files["random.bin"] = RandomData(3 * MiB + 17, 3);
+  files["data.gz"] = std::string("\x1f\x8b\x08\x00", 4) + RandomData(2 * MiB + 5, 4);
+  files["image.png"] = std::string("\x89PNG\r\n\x1a\n", 8) + RandomData(MiB / 2, 5);
+  files["compressed.nrrd"] = "NRRD0004\ntype: short\ndimension: 1\nsizes: 1000\nencoding: gzip\n\n"
+    + RandomData(MiB + 3, 6);
+  files["raw.nrrd"] = "NRRD0004\ntype: short\ndimension: 1\nsizes: 1000\nencoding: raw\n\n"
+    + CompressibleData(2 * MiB + 11, 7);
+  files["sub/dir/nested.txt"] = CompressibleData(1000, 8);
+
+  const std::string directoryName = "vtkArchiveTest2";
+  CHECK_BOOL(ResetDirectory(tempDirectory + "/" + directoryName), true);
+  CHECK_BOOL(vtksys::SystemTools::MakeDirectory((tempDirectory + "/" + directoryName + "/sub/dir").c_str()), true);
+  for (std::map<std::string, std::string>::iterator fileIt = files.begin(); fileIt != files.end(); ++fileIt)
+    {
+    CHECK_BOOL(WriteFile(tempDirectory + "/" + directoryName + "/" + fileIt->first, fileIt->second), true);
+    }
+
+  std::map<std::string, int> methods;
+  CHECK_BOOL(RoundTrip(tempDirectory, directoryName, files, 2, methods), true);
+  // already compressed content is stored, the rest is deflated
+  CHECK_INT(methods[directoryName + "/data.gz"], 0);
+  CHECK_INT(methods[directoryName + "/image.png"], 0);
+  CHECK_INT(methods[directoryName + "/compressed.nrrd"], 0);
+  CHECK_INT(methods[directoryName + "/large.txt"], 8);
+  CHECK_INT(methods[directoryName + "/batch.txt"], 8);
+  CHECK_INT(methods[directoryName + "/empty.txt"], 8);
+  CHECK_INT(methods[directoryName + "/random.bin"], 8);
+  CHECK_INT(methods[directoryName + "/raw.nrrd"], 8);
+  CHECK_INT(methods[directoryName + "/sub/dir/nested.txt"], 8);
+  CHECK_BOOL(vtksys::SystemTools::FileLength((tempDirectory + "/" + directoryName + ".zip").c_str())
+    < files["large.txt"].size() / 2, true);
+
+  // Block boundaries and deflate dictionaries do not depend on the number of threads
+  std::string archiveWithTwoThreads = ReadFile(tempDirectory + "/" + directoryName + ".zip");
+  CHECK_BOOL(RoundTrip(tempDirectory, directoryName, files, 1, methods), true);
+  CHECK_BOOL(ReadFile(tempDirectory + "/" + directoryName + ".zip") == archiveWithTwoThreads, true);
+  CHECK_BOOL(RoundTrip(tempDirectory, directoryName, files, 5, methods), true);
+  CHECK_BOOL(ReadFile(tempDirectory + "/" + directoryName + ".zip") == archiveWithTwoThreads, true);
+
+  //
+  // More entries than a zip end of central directory record can count
+  //
+  std::map<std::string, std::string> manyFiles;
+  const std::string manyDirectoryName = "vtkArchiveTest2Many";
+  CHECK_BOOL(ResetDirectory(tempDirectory + "/" + manyDirectoryName), true);
+  for (int directoryIndex = 0; directoryIndex < 66; ++directoryIndex)
+    {
+    std::stringstream subdirectoryName;
+    subdirectoryName << "d" << directoryIndex;
+    CHECK_BOOL(vtksys::SystemTools::MakeDirectory(
+      (tempDirectory + "/" + manyDirectoryName + "/" + subdirectoryName.str()).c_str()), true);
+    for (int fileIndex = 0; fileIndex < 1000; ++fileIndex)
+      {
+      std::stringstream fileName;
+      fileName << subdirectoryName.str() << "/f" << fileIndex << ".txt";
+      std::stringstream content;
+      content << "entry " << directoryIndex << " " << fileIndex << "\n";
+      manyFiles[fileName.str()] = content.str();
+      CHECK_BOOL(WriteFile(tempDirectory + "/" + manyDirectoryName + "/" + fileName.str(), content.str()), true);
+      }
+    }
+  CHECK_BOOL(manyFiles.size() + 1 > 0xffff, true);
+  CHECK_BOOL(RoundTrip(tempDirectory, manyDirectoryName, manyFiles, 0, methods), true);
+
+  vtksys::SystemTools::RemoveADirectory((tempDirectory + "/" + directoryName).c_str());
+  vtksys::SystemTools::RemoveADirectory((tempDirectory + "/" + directoryName + "Extracted").c_str());
+  vtksys::SystemTools::RemoveFile((tempDirectory + "/" + directoryName + ".zip").c_str());
+  vtksys::SystemTools::RemoveADirectory((tempDirectory + "/" + manyDirectoryName).c_str());
+  vtksys::SystemTools::RemoveADirectory((tempDirectory + "/" + manyDirectoryName + "Extracted").c_str());
+  vtksys::SystemTools::RemoveFile((tempDirectory + "/" + manyDirectoryName + ".zip").c_str());
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
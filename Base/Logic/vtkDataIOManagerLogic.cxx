@@ -695,13 +695,6 @@ void vtkDataIOManagerLogic::ApplyTransfer( void *clientdata )
     }
 
 
-  vtkMRMLNode *node = this->GetMRMLScene()->GetNodeByID ((dt->GetTransferNodeID() ));
-  if ( node == NULL )
-    {
-    vtkErrorMacro("ApplyTransfer: can't get mrml node from transfer node id " << dt->GetTransferNodeID());
-    return;
-    }
-
   const char *source = dt->GetSourceURI();
   const char *dest = dt->GetDestinationURI();
   if ( dt->GetTransferType() == vtkDataTransfer::RemoteDownload  )
@@ -720,40 +713,9 @@ void vtkDataIOManagerLogic::ApplyTransfer( void *clientdata )
         dt->SetTransferStatusNoModify ( vtkDataTransfer::Completed );
         this->GetApplicationLogic()->RequestModified( dt );
 
-        vtkMRMLStorableNode *storableNode = vtkMRMLStorableNode::SafeDownCast( node );
-        if ( !storableNode )
-          {
-          vtkErrorMacro( "ApplyTransfer: could not get storable node for scheduled data transfer" );
-          return;
-          }
-        // find the storage node that's been scheduled  and we're working on it
-        int storageNodeIndex = -1;
-        for (int i = 0; i < storableNode->GetNumberOfStorageNodes(); i++)
-          {
-          if (storableNode->GetNthStorageNode(i)->GetReadState() == vtkMRMLStorageNode::Transferring &&
-              strcmp(storableNode->GetNthStorageNode(i)->GetURI(),source) == 0)
-            {
-            vtkDebugMacro("ApplyTransfer: found a working storage node who's uri matches source " << source << " at " << i);
-            storageNodeIndex = i;
-            break;
-            }
-          }
-        if (storageNodeIndex == -1)
-          {
-          vtkErrorMacro("ApplyTransfer: unable to find a storage node in scheduled state.");
-          }
-        vtkMRMLStorageNode *storageNode = storableNode->GetNthStorageNode(storageNodeIndex);
-        if ( !storageNode )
-          {
-          vtkErrorMacro( "ApplyTransfer: no storage node for scheduled data transfer" );
-          return;
-          }
-        storageNode->SetDisableModifiedEvent( 1 );
-        // let the storage node know that the remote transfer is done
-        vtkDebugMacro("ApplyTransfer: setting storage node read state to transfer done for uri " << storageNode->GetURI());
-        storageNode->SetReadStateTransferDone();
-        storageNode->SetDisableModifiedEvent( 0 );
-        this->GetApplicationLogic()->RequestReadData( node->GetID(), dest, 0, 0 );
+        // Networking threads must not touch the scene: the storage node
+        // is updated and the data is read in the main thread.
+        this->GetApplicationLogic()->RequestReadData( dt->GetTransferNodeID(), dest, 0, 0 );
         }
       else
         {
@@ -778,34 +740,8 @@ void vtkDataIOManagerLogic::ApplyTransfer( void *clientdata )
         dt->SetTransferStatusNoModify ( vtkDataTransfer::Completed );
         this->GetApplicationLogic()->RequestModified( dt );
 
-        vtkMRMLStorableNode *storableNode = vtkMRMLStorableNode::SafeDownCast( node );
-        if ( !storableNode )
-          {
-          vtkErrorMacro( "ApplyTransfer: Upload: could not get storable node for scheduled data transfer" );
-          return;
-          }
-        // find the storage node that's scheduled
-        int storageNodeIndex = -1;
-        for (int i = 0; i < storableNode->GetNumberOfStorageNodes(); i++)
-          {
-          if (storableNode->GetNthStorageNode(i)->GetWriteState() == vtkMRMLStorageNode::Scheduled)
-            {
-            storageNodeIndex = i;
-            }
-          }
-        if (storageNodeIndex == -1)
-          {
-          vtkErrorMacro("ApplyTransfer: upload: unable to find a storage node in scheduled state.");
-          }
-        vtkMRMLStorageNode *storageNode = storableNode->GetNthStorageNode(storageNodeIndex);
-        if ( !storageNode )
-          {
-          vtkErrorMacro( "ApplyTransfer: Upload: no storage node for scheduled data transfer" );
-          return;
-          }
-        storageNode->SetDisableModifiedEvent( 1 );
-        storageNode->SetWriteStateTransferDone();
-        storageNode->SetDisableModifiedEvent( 0 );
+        // The storage node write state is updated in the main thread
+        this->GetApplicationLogic()->RequestWriteData( dt->GetTransferNodeID(), dest, 0, 0 );
         }
       else
         {
@@ -42,7 +42,11 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkDataIOManagerLogic : public vtkSlicerModul
   virtual int QueueWrite ( vtkMRMLNode *node );
 
   ///
-  /// The method that executes the data transfer in another thread
+  /// The method that executes the data transfer in another thread.
+  /// It is run concurrently by the networking threads of the application
+  /// logic, so it does not access the scene: the storage nodes are updated
+  /// and the data is read by the application logic in the main thread
+  /// (see vtkSlicerApplicationLogic::RequestReadData() and RequestWriteData()).
   virtual void ApplyTransfer(void *clientdata);
 
   /// Description
@@ -334,24 +334,19 @@ void vtkSlicerApplicationLogic::CreateProcessingThread()
                     this);
 
     // Start four network threads (TODO: make the number of threads a setting)
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
-    /*
-     * TODO: it looks like curl is not thread safe by default
-     * - maybe there's a setting that cmcurl can have
-     *   similar to the --enable-threading of the standard curl build
-     *
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
-    */
+    // Remote handlers (see vtkHTTPHandler) funnel the transfers of all the
+    // threads into one shared curl multi handle, so the threads only
+    // wait on their downloads while connections are reused between them.
+    // The tasks run concurrently: the transfer engine and the handler
+    // uploads are locked, and the tasks do not access the scene, they
+    // request the main thread to update it (RequestReadData(),
+    // RequestWriteData() and RequestModified()).
+    for (int i = 0; i < 4; ++i)
+      {
+      this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
+            ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
+                      this) );
+      }
 
     // Setup the communication channel back to the main thread
     this->ModifiedQueueActiveLock->Lock();
@@ -860,6 +855,12 @@ void vtkSlicerApplicationLogic::ProcessReadNodeData(ReadDataRequest& req)
   // appropriate storage and display node.
 
   vtkMRMLNode *nd = this->GetMRMLScene()->GetNodeByID( req.GetNode().c_str() );
+  if (nd == NULL)
+    {
+    // The node may have been removed while its data was downloaded
+    vtkErrorMacro("ProcessReadNodeData: can't get mrml node " << req.GetNode());
+    return;
+    }
   vtkDebugMacro("ProcessReadNodeData: read data request node id = " << nd->GetID());
 
   vtkSmartPointer<vtkMRMLStorageNode> storageNode;
@@ -919,6 +920,14 @@ void vtkSlicerApplicationLogic::ProcessReadNodeData(ReadDataRequest& req)
       try
         {
         vtkDebugMacro("ProcessReadNodeData: about to call read data, storage node's read state is " << storageNode->GetReadStateAsString());
+        if (storageNode->GetReadState() == vtkMRMLStorageNode::Transferring)
+          {
+          // The file was downloaded by a networking thread
+          // (see vtkDataIOManagerLogic::ApplyTransfer())
+          storageNode->SetDisableModifiedEvent(1);
+          storageNode->SetReadStateTransferDone();
+          storageNode->SetDisableModifiedEvent(0);
+          }
         if (useURI)
           {
           storageNode->SetURI(req.GetFilename().c_str());
@@ -1028,9 +1037,35 @@ void vtkSlicerApplicationLogic::ProcessReadNodeData(ReadDataRequest& req)
 }
 
 //----------------------------------------------------------------------------
-void vtkSlicerApplicationLogic::ProcessWriteNodeData(WriteDataRequest& vtkNotUsed(req))
+void vtkSlicerApplicationLogic::ProcessWriteNodeData(WriteDataRequest& req)
 {
-    vtkWarningMacro("ProcessWriteNodeData: we just wrote out, not doing anything here...");
+  // The file was uploaded by a networking thread
+  // (see vtkDataIOManagerLogic::ApplyTransfer()), let the scheduled
+  // storage node know that the transfer is done.
+  vtkMRMLStorableNode *storableNode = vtkMRMLStorableNode::SafeDownCast(
+    this->GetMRMLScene()->GetNodeByID( req.GetNode().c_str() ));
+  if (storableNode == NULL)
+    {
+    vtkErrorMacro("ProcessWriteNodeData: can't get storable node " << req.GetNode());
+    return;
+    }
+  vtkMRMLStorageNode *storageNode = NULL;
+  for (int n = 0; n < storableNode->GetNumberOfStorageNodes(); n++)
+    {
+    vtkMRMLStorageNode *testStorageNode = storableNode->GetNthStorageNode(n);
+    if (testStorageNode && testStorageNode->GetWriteState() == vtkMRMLStorageNode::Scheduled)
+      {
+      storageNode = testStorageNode;
+      }
+    }
+  if (storageNode == NULL)
+    {
+    vtkErrorMacro("ProcessWriteNodeData: unable to find a storage node in scheduled state for " << req.GetFilename());
+    return;
+    }
+  storageNode->SetDisableModifiedEvent(1);
+  storageNode->SetWriteStateTransferDone();
+  storageNode->SetDisableModifiedEvent(0);
 }
 
 //----------------------------------------------------------------------------
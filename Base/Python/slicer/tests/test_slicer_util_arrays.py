@@ -0,0 +1,132 @@
+import unittest
+import numpy
+import vtk
+import vtk.util.numpy_support
+import slicer
+
+
+class SlicerUtilArraysTests(unittest.TestCase):
+
+  def setUp(self):
+    slicer.mrmlScene.Clear(0)
+
+  def _countModifiedEvents(self, obj):
+    counter = {'count': 0}
+    def onModified(caller, event):
+      counter['count'] += 1
+    obj.AddObserver(vtk.vtkCommand.ModifiedEvent, onModified)
+    return counter
+
+  def test_volume(self):
+    volumeNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLScalarVolumeNode')
+    voxels = numpy.arange(4*5*6, dtype=numpy.int16).reshape(6, 5, 4)
+    slicer.util.updateVolumeFromArray(volumeNode, voxels)
+    self.assertEqual(volumeNode.GetImageData().GetDimensions(), (4, 5, 6))
+
+    # array is a view of the image data
+    narray = slicer.util.arrayFromVolume(volumeNode)
+    numpy.testing.assert_array_equal(narray, voxels)
+    counter = self._countModifiedEvents(volumeNode)
+    with slicer.util.NodeModify(volumeNode):
+      narray[0, 0, 0] = 100
+      slicer.util.arrayFromVolumeModified(volumeNode)
+      narray[1, 0, 0] = 200
+      slicer.util.arrayFromVolumeModified(volumeNode)
+    self.assertEqual(counter['count'], 1)
+    self.assertEqual(volumeNode.GetImageData().GetScalarComponentAsDouble(0, 0, 1, 0), 200)
+
+    # same image data is kept when the array is retyped
+    imageData = volumeNode.GetImageData()
+    slicer.util.updateVolumeFromArray(volumeNode, voxels.astype(numpy.float32))
+    self.assertIs(volumeNode.GetImageData(), imageData)
+    self.assertEqual(imageData.GetScalarType(), vtk.VTK_FLOAT)
+
+  def test_modelPoints(self):
+    sphere = vtk.vtkSphereSource()
+    sphere.Update()
+    modelNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLModelNode')
+    modelNode.SetAndObservePolyData(sphere.GetOutput())
+    narray = slicer.util.arrayFromModelPoints(modelNode)
+    self.assertEqual(narray.shape, (sphere.GetOutput().GetNumberOfPoints(), 3))
+    counter = self._countModifiedEvents(modelNode)
+    narray[0] = [1.0, 2.0, 3.0]
+    slicer.util.arrayFromModelPointsModified(modelNode)
+    self.assertEqual(counter['count'], 1)
+    self.assertEqual(modelNode.GetPolyData().GetPoint(0), (1.0, 2.0, 3.0))
+
+  def test_tableColumn(self):
+    tableNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLTableNode')
+    column = vtk.vtkDoubleArray()
+    column.SetName('values')
+    column.SetNumberOfTuples(10)
+    tableNode.AddColumn(column)
+    narray = slicer.util.arrayFromTableColumn(tableNode, 'values')
+    counter = self._countModifiedEvents(tableNode)
+    narray[:] = numpy.arange(10)
+    slicer.util.arrayFromTableColumnModified(tableNode, 'values')
+    self.assertEqual(counter['count'], 1)
+    self.assertEqual(tableNode.GetTable().GetValueByName(9, 'values'), 9)
+
+  def test_gridTransform(self):
+    transformNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLGridTransformNode')
+    narray = slicer.util.arrayFromGridTransform(transformNode)
+    self.assertEqual(narray.shape, (1, 1, 1, 3))
+    counter = self._countModifiedEvents(transformNode)
+    with slicer.util.NodeModify(transformNode):
+      narray[0, 0, 0] = [1.0, 2.0, 3.0]
+      slicer.util.arrayFromGridTransformModified(transformNode)
+      slicer.util.arrayFromGridTransformModified(transformNode)
+    self.assertEqual(counter['count'], 1)
+    displacementGrid = transformNode.GetTransformFromParent().GetDisplacementGrid()
+    self.assertEqual(displacementGrid.GetScalarComponentAsDouble(0, 0, 0, 2), 3.0)
+
+  def test_segment(self):
+    import vtkSegmentationCorePython as vtkSegmentationCore
+    segmentationNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLSegmentationNode')
+    segmentIds = []
+    for label in range(2):
+      # two segments that fill the lower and the upper half of the same lattice
+      labelmap = vtkSegmentationCore.vtkOrientedImageData()
+      labelmap.SetExtent(0, 3, 0, 4, 0, 5)
+      labelmap.AllocateScalars(vtk.VTK_UNSIGNED_CHAR, 1)
+      voxels = vtk.util.numpy_support.vtk_to_numpy(labelmap.GetPointData().GetScalars()).reshape(6, 5, 4)
+      voxels[:] = 0
+      voxels[label * 3:label * 3 + 3] = 1
+      segmentIds.append(segmentationNode.AddSegmentFromBinaryLabelmapRepresentation(labelmap, 'segment%d' % label))
+    segmentation = segmentationNode.GetSegmentation()
+    self.assertEqual(segmentation.CollapseBinaryLabelmaps(), 1)
+    otherSegment = segmentation.GetSegment(segmentIds[1])
+    self.assertIsNotNone(otherSegment.GetSharedLabelmap())
+
+    # shared segment is moved to a separate labelmap, the array only contains this segment
+    narray = slicer.util.arrayFromSegment(segmentationNode, segmentIds[0])
+    self.assertIsNone(segmentation.GetSegment(segmentIds[0]).GetSharedLabelmap())
+    self.assertEqual(numpy.count_nonzero(narray), 3*5*4)
+    self.assertEqual(numpy.count_nonzero(narray[3:]), 0)
+
+    # array is a view of the labelmap
+    counter = {'count': 0}
+    def onMasterRepresentationModified(caller, event):
+      counter['count'] += 1
+    segmentation.AddObserver(vtkSegmentationCore.vtkSegmentation.MasterRepresentationModified, onMasterRepresentationModified)
+    with slicer.util.NodeModify(segmentationNode):
+      narray[1:] = 0
+      slicer.util.arrayFromSegmentModified(segmentationNode, segmentIds[0])
+      slicer.util.arrayFromSegmentModified(segmentationNode, segmentIds[0])
+    self.assertTrue(counter['count'] >= 1)
+    labelmap = segmentationNode.GetBinaryLabelmapRepresentation(segmentIds[0])
+    self.assertEqual(labelmap.GetScalarComponentAsDouble(0, 0, 0, 0), 1)
+    self.assertEqual(labelmap.GetScalarComponentAsDouble(0, 0, 1, 0), 0)
+
+    # the other segment is not affected
+    otherLabelmap = vtkSegmentationCore.vtkOrientedImageData()
+    self.assertTrue(otherSegment.ExtractBinaryLabelmapRepresentation(otherLabelmap))
+    otherVoxels = vtk.util.numpy_support.vtk_to_numpy(otherLabelmap.GetPointData().GetScalars())
+    self.assertEqual(numpy.count_nonzero(otherVoxels), 3*5*4)
+
+  def test_markupsControlPoints(self):
+    markupsNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLMarkupsFiducialNode')
+    points = numpy.array([[0.0, 1.0, 2.0], [3.0, 4.0, 5.0]])
+    slicer.util.updateMarkupsControlPointsFromArray(markupsNode, points)
+    self.assertEqual(markupsNode.GetNumberOfFiducials(), 2)
+    numpy.testing.assert_array_equal(slicer.util.arrayFromMarkupsControlPoints(markupsNode), points)
@@ -649,45 +649,220 @@ class NodeModify:
 # MRML-numpy
 #
 
+_arrayVolumeScalarTypes = ('vtkMRMLScalarVolumeNode', 'vtkMRMLLabelMapVolumeNode')
+_arrayVolumeVectorTypes = ('vtkMRMLVectorVolumeNode', 'vtkMRMLMultiVolumeNode')
+_arrayVolumeTensorTypes = ('vtkMRMLDiffusionTensorVolumeNode',)
+
 def array(pattern = "", index = 0):
   """Return the array you are "most likely to want" from the indexth
   MRML node that matches the pattern.  Meant to be used in the python
   console for quick debugging/testing.  More specific API should be
   used in scripts to be sure you get exactly what you want.
   """
-  scalarTypes = ('vtkMRMLScalarVolumeNode', 'vtkMRMLLabelMapVolumeNode')
-  vectorTypes = ('vtkMRMLVectorVolumeNode', 'vtkMRMLMultiVolumeNode')
-  tensorTypes = ('vtkMRMLDiffusionTensorVolumeNode',)
+  volumeTypes = _arrayVolumeScalarTypes + _arrayVolumeVectorTypes + _arrayVolumeTensorTypes
   pointTypes = ('vtkMRMLModelNode',)
-  import vtk.util.numpy_support
   n = getNode(pattern=pattern, index=index)
-  if n.GetClassName() in scalarTypes:
-    i = n.GetImageData()
-    shape = list(n.GetImageData().GetDimensions())
-    shape.reverse()
-    a = vtk.util.numpy_support.vtk_to_numpy(i.GetPointData().GetScalars()).reshape(shape)
-    return a
-  elif n.GetClassName() in vectorTypes:
-    i = n.GetImageData()
-    shape = list(n.GetImageData().GetDimensions())
-    shape.reverse()
-    components = i.GetNumberOfScalarComponents()
-    if components > 1:
-      shape.append(components)
-    a = vtk.util.numpy_support.vtk_to_numpy(i.GetPointData().GetScalars()).reshape(shape)
-    return a
-  elif n.GetClassName() in tensorTypes:
-    i = n.GetImageData()
-    shape = list(n.GetImageData().GetDimensions())
-    shape.reverse()
-    a = vtk.util.numpy_support.vtk_to_numpy(i.GetPointData().GetTensors()).reshape(shape+[3,3])
-    return a
+  if n.GetClassName() in volumeTypes:
+    return arrayFromVolume(n)
   elif n.GetClassName() in pointTypes:
-    p = n.GetPolyData().GetPoints().GetData()
-    a = vtk.util.numpy_support.vtk_to_numpy(p)
-    return a
+    return arrayFromModelPoints(n)
   # TODO: accessors for other node types: polydata (verts, polys...), colors
 
+def arrayFromVolume(volumeNode):
+  """Return voxel array of a volume node as numpy array.
+
+  Voxels values are not copied: the numpy array is a view of the image data
+  of the volume node, indexed as ``[k, j, i]`` (plus component indices for
+  vector and tensor volumes). After the voxels have been changed through the
+  array, call :py:meth:`arrayFromVolumeModified` to update the views.
+
+  Several modifications (of this or other arrays of the node) can be
+  notified by a single modified event by doing them in a
+  ``with slicer.util.NodeModify(volumeNode):`` block.
+
+  .. warning:: Memory of the returned array is owned by VTK: values may be
+    changed but the array must not be resized. Use :py:meth:`updateVolumeFromArray`
+    to set voxels of a different size or type.
+  """
+  import vtk.util.numpy_support
+  imageData = volumeNode.GetImageData()
+  shape = list(imageData.GetDimensions())
+  shape.reverse()
+  className = volumeNode.GetClassName()
+  if className in _arrayVolumeScalarTypes:
+    vtkArray = imageData.GetPointData().GetScalars()
+  elif className in _arrayVolumeVectorTypes:
+    vtkArray = imageData.GetPointData().GetScalars()
+    components = imageData.GetNumberOfScalarComponents()
+    if components > 1:
+      shape.append(components)
+  elif className in _arrayVolumeTensorTypes:
+    vtkArray = imageData.GetPointData().GetTensors()
+    shape += [3, 3]
+  else:
+    raise RuntimeError("Unsupported volume type: " + className)
+  return vtk.util.numpy_support.vtk_to_numpy(vtkArray).reshape(shape)
+
+def arrayFromVolumeModified(volumeNode):
+  """Indicate that modification of a numpy array returned by :py:meth:`arrayFromVolume` has been completed."""
+  volumeNode.ImageDataModified()
+
+def updateVolumeFromArray(volumeNode, narray):
+  """Set voxels of a scalar or vector volume node from a numpy array.
+
+  The array is indexed as ``[k, j, i]`` (``[k, j, i, component]`` for vector
+  volumes). Voxels are copied into the existing image data when the array
+  has the same shape and type; otherwise the image data is reshaped or
+  retyped in place (see vtkMRMLVolumeNode::ReshapeImageData), so the
+  geometry and display of the volume and the pipelines connected to it are
+  preserved. A single modified event is invoked.
+  """
+  import numpy
+  import vtk.util.numpy_support
+  narray = numpy.asarray(narray)
+  if narray.ndim == 3:
+    components = 1
+  elif narray.ndim == 4 and volumeNode.GetClassName() not in _arrayVolumeScalarTypes:
+    components = narray.shape[3]
+  else:
+    raise ValueError("Unsupported array shape for %s: %s" % (volumeNode.GetClassName(), narray.shape))
+  dimensions = (narray.shape[2], narray.shape[1], narray.shape[0])
+  scalarType = vtk.util.numpy_support.get_vtk_array_type(narray.dtype)
+  with NodeModify(volumeNode):
+    imageData = volumeNode.GetImageData()
+    if (imageData is None or imageData.GetPointData().GetScalars() is None
+      or imageData.GetDimensions() != dimensions
+      or imageData.GetScalarType() != scalarType
+      or imageData.GetNumberOfScalarComponents() != components):
+      if not volumeNode.ReshapeImageData(dimensions, scalarType, components):
+        raise RuntimeError("Failed to reshape image data of %s" % volumeNode.GetName())
+      imageData = volumeNode.GetImageData()
+    voxels = vtk.util.numpy_support.vtk_to_numpy(imageData.GetPointData().GetScalars())
+    numpy.copyto(voxels.reshape(narray.shape), narray)
+    volumeNode.ImageDataModified()
+
+def arrayFromModelPoints(modelNode):
+  """Return point positions of a model node as numpy array.
+
+  Point coordinates are not copied: the numpy array (one row per point) is
+  a view of the points of the model mesh. After the points have been changed
+  through the array, call :py:meth:`arrayFromModelPointsModified` to update
+  the views.
+  """
+  import vtk.util.numpy_support
+  pointData = modelNode.GetMesh().GetPoints().GetData()
+  return vtk.util.numpy_support.vtk_to_numpy(pointData)
+
+def arrayFromModelPointsModified(modelNode):
+  """Indicate that modification of a numpy array returned by :py:meth:`arrayFromModelPoints` has been completed."""
+  modelNode.MeshModified()
+
+def arrayFromSegment(segmentationNode, segmentId):
+  """Return voxel array of a segment's binary labelmap representation as numpy array.
+
+  Voxels values are not copied: the numpy array (indexed as ``[k, j, i]``)
+  is a view of the labelmap, which covers the labelmap extent and not
+  necessarily the whole reference geometry. If the segment is stored in a
+  labelmap shared with other segments then it is moved to a separate
+  labelmap first, so writing the array only affects this segment. After the
+  voxels have been changed through the array, call
+  :py:meth:`arrayFromSegmentModified` to update the views.
+  """
+  import vtk.util.numpy_support
+  import vtkSegmentationCorePython as vtkSegmentationCore
+  segmentation = segmentationNode.GetSegmentation()
+  segment = segmentation.GetSegment(segmentId)
+  if segment is not None and segment.GetSharedLabelmap() is not None:
+    # Setting a separate binary labelmap removes the segment from the shared labelmap.
+    # Master representation observations are updated when modified events are re-enabled.
+    separateLabelmap = vtkSegmentationCore.vtkOrientedImageData()
+    segment.ExtractBinaryLabelmapRepresentation(separateLabelmap)
+    wasMasterRepresentationModifiedEnabled = segmentation.SetMasterRepresentationModifiedEnabled(False)
+    segment.AddRepresentation(vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName(), separateLabelmap)
+    segmentation.SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled)
+  labelmap = segmentationNode.GetBinaryLabelmapRepresentation(segmentId)
+  if labelmap is None:
+    raise ValueError("Segment has no binary labelmap representation: " + segmentId)
+  shape = list(labelmap.GetDimensions())
+  shape.reverse()
+  return vtk.util.numpy_support.vtk_to_numpy(labelmap.GetPointData().GetScalars()).reshape(shape)
+
+def arrayFromSegmentModified(segmentationNode, segmentId):
+  """Indicate that modification of a numpy array returned by :py:meth:`arrayFromSegment` has been completed."""
+  segmentationNode.BinaryLabelmapRepresentationModified(segmentId)
+
+def arrayFromTableColumn(tableNode, columnName):
+  """Return values of a numeric table column as numpy array.
+
+  Values are not copied: the numpy array is a view of the column. After the
+  values have been changed through the array, call
+  :py:meth:`arrayFromTableColumnModified` to update the views.
+  """
+  import vtk
+  import vtk.util.numpy_support
+  column = tableNode.GetTable().GetColumnByName(columnName)
+  if column is None or not column.IsNumeric() or column.GetDataType() == vtk.VTK_BIT:
+    raise ValueError("Table has no numeric column: " + columnName)
+  return vtk.util.numpy_support.vtk_to_numpy(column)
+
+def arrayFromTableColumnModified(tableNode, columnName):
+  """Indicate that modification of a numpy array returned by :py:meth:`arrayFromTableColumn` has been completed."""
+  tableNode.ColumnModified(columnName)
+
+def arrayFromGridTransform(gridTransformNode):
+  """Return displacement vectors of a grid transform node as numpy array.
+
+  Vectors are not copied: the numpy array (indexed as ``[k, j, i, component]``)
+  is a view of the displacement grid, in the direction the transform is stored
+  in. After the vectors have been changed through the array, call
+  :py:meth:`arrayFromGridTransformModified` to update the transform.
+  """
+  import vtk.util.numpy_support
+  gridTransform = gridTransformNode.GetTransformFromParentAs('vtkOrientedGridTransform', False, True)
+  if gridTransform is None:
+    gridTransform = gridTransformNode.GetTransformToParentAs('vtkOrientedGridTransform', False, True)
+  if gridTransform is None or gridTransform.GetDisplacementGrid() is None:
+    raise ValueError("Node does not store a displacement grid")
+  displacementGrid = gridTransform.GetDisplacementGrid()
+  shape = list(displacementGrid.GetDimensions())
+  shape.reverse()
+  shape.append(displacementGrid.GetNumberOfScalarComponents())
+  return vtk.util.numpy_support.vtk_to_numpy(displacementGrid.GetPointData().GetScalars()).reshape(shape)
+
+def arrayFromGridTransformModified(gridTransformNode):
+  """Indicate that modification of a numpy array returned by :py:meth:`arrayFromGridTransform` has been completed."""
+  gridTransformNode.DisplacementGridModified()
+
+def arrayFromMarkupsControlPoints(markupsNode):
+  """Return positions of all points of all markups as numpy array (one row per point).
+
+  Markups store their points individually, so positions are copied.
+  Use :py:meth:`updateMarkupsControlPointsFromArray` to write them back.
+  """
+  import vtk
+  import vtk.util.numpy_support
+  points = vtk.vtkPoints()
+  points.SetDataTypeToDouble()
+  markupsNode.GetMarkupPoints(points)
+  return vtk.util.numpy_support.vtk_to_numpy(points.GetData())
+
+def updateMarkupsControlPointsFromArray(markupsNode, narray):
+  """Set positions of all points of all markups from a numpy array (one row per point).
+
+  Positions are updated in place if the number of points is unchanged,
+  otherwise the markups are replaced by one markup per point. A single
+  modified event is invoked.
+  """
+  import numpy
+  import vtk
+  import vtk.util.numpy_support
+  narray = numpy.ascontiguousarray(narray, dtype=numpy.float64)
+  if narray.ndim != 2 or narray.shape[1] != 3:
+    raise ValueError("Expected an array of shape (numberOfPoints, 3), got %s" % (narray.shape,))
+  points = vtk.vtkPoints()
+  points.SetData(vtk.util.numpy_support.numpy_to_vtk(narray))
+  markupsNode.SetMarkupPoints(points)
+
 
 #
 # VTK
@@ -21,6 +21,8 @@
 #include "qSlicerApplicationHelper.h"
 
 // Qt includes
+#include <QDir>
+#include <QFileInfo>
 #include <QSettings>
 
 // Slicer includes
@@ -161,6 +163,27 @@ void qSlicerApplicationHelper::setupModuleFactoryManager(qSlicerModuleFactoryMan
   moduleFactoryManager->setModulesToIgnore(modulesToIgnore);
 
   moduleFactoryManager->setVerboseModuleDiscovery(app->commandOptions()->verboseModuleDiscovery());
+
+  // Module metadata is cached next to the revision specific settings so that
+  // the instantiation of the modules can be deferred at the next startup.
+  QFileInfo revisionUserSettings(app->slicerRevisionUserSettingsFilePath());
+  moduleFactoryManager->setModuleMetadataCacheFilePath(
+    revisionUserSettings.dir().filePath(revisionUserSettings.completeBaseName() + "-ModuleMetadata.ini"));
+  moduleFactoryManager->setDeferInstantiation(
+    options->deferModuleInstantiation() ||
+    app->userSettings()->value("Modules/DeferInstantiation", false).toBool());
+  // Deferral is opt-in: modules (scripted modules in particular) may expect
+  // to be instantiated at startup, e.g. to be available in slicer.modules.
+  QStringList modulesToDefer =
+    app->userSettings()->value("Modules/ModulesToDefer").toStringList();
+  // Modules shown at startup are not deferred
+  foreach(const QString& moduleName,
+          app->userSettings()->value("Modules/FavoriteModules").toStringList() +
+          (QStringList() << app->userSettings()->value("Modules/HomeModule").toString()))
+    {
+    modulesToDefer.removeAll(moduleName);
+    }
+  moduleFactoryManager->setModulesToDefer(modulesToDefer);
 }
 
 //----------------------------------------------------------------------------
@@ -19,7 +19,13 @@
 ==============================================================================*/
 
 // Qt includes
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSet>
+#include <QSettings>
+#include <QTextStream>
 
 // SlicerQt includes
 #include "qSlicerCoreApplication.h"
@@ -52,6 +58,23 @@ public:
   // the risk of creating a NULL entry if the module is not registered.
   qSlicerModuleFactory* registeredModuleFactory(const QString& moduleName)const;
 
+  void addModuleDependees(const QString& moduleName, const QStringList& dependencies);
+
+  /// Return the cached metadata of the module if it is up-to-date with the
+  /// module file, an empty map otherwise.
+  QVariantMap cachedModuleMetadata(const QString& moduleName)const;
+  void cacheModuleMetadata(const QString& moduleName, qSlicerAbstractCoreModule* module);
+
+  bool shouldDeferModule(const QString& moduleName)const;
+
+  struct TraceEvent
+    {
+    QString ModuleName;
+    QString Phase;
+    qint64 StartTime;
+    qint64 Duration;
+    };
+
   QStringList SearchPaths;
   QStringList ExplicitModules;
   QStringList ModulesToIgnore;
@@ -59,16 +82,50 @@ public:
   QMap<qSlicerModuleFactory*, int> Factories;
   QMap<QString, qSlicerModuleFactory*> RegisteredModules;
   QMap<QString, QStringList> ModuleDependees;
+  QMap<QString, QFileInfo> RegisteredModuleFiles;
+
+  bool DeferInstantiation;
+  QStringList ModulesToDefer;
+  QSet<QString> DeferredModules;
+  QString ModuleMetadataCacheFilePath;
+  QScopedPointer<QSettings> ModuleMetadataCache;
+
+  QElapsedTimer StartupTimer;
+  QList<TraceEvent> TraceEvents;
 
   bool Verbose;
 };
 
+namespace
+{
+
+//-----------------------------------------------------------------------------
+QString toJSONString(const QString& value)
+{
+  QString escapedValue = value;
+  escapedValue.replace('\\', "\\\\");
+  escapedValue.replace('"', "\\\"");
+  escapedValue.replace('\n', "\\n");
+  escapedValue.replace('\t', "\\t");
+  return QString("\"%1\"").arg(escapedValue);
+}
+
+//-----------------------------------------------------------------------------
+QStringList metadataListKeys()
+{
+  return QStringList() << "categories" << "dependencies" << "associatedNodeTypes";
+}
+
+}
+
 //-----------------------------------------------------------------------------
 // qSlicerAbstractModuleFactoryManagerPrivate methods
 qSlicerAbstractModuleFactoryManagerPrivate::qSlicerAbstractModuleFactoryManagerPrivate(qSlicerAbstractModuleFactoryManager& object)
   : q_ptr(&object)
 {
+  this->DeferInstantiation = false;
   this->Verbose = false;
+  this->StartupTimer.start();
 }
 
 //-----------------------------------------------------------------------------
@@ -87,6 +144,7 @@ void qSlicerAbstractModuleFactoryManagerPrivate::printAdditionalInfo()
   qDebug() << "Registered modules:" << q->registeredModuleNames();
   qDebug() << "Ignored modules:" << q->ignoredModuleNames();
   qDebug() << "Instantiated modules:" << q->instantiatedModuleNames();
+  qDebug() << "Deferred modules:" << q->deferredModuleNames();
 }
 
 //-----------------------------------------------------------------------------
@@ -116,6 +174,104 @@ qSlicerAbstractModuleFactoryManagerPrivate
   return this->RegisteredModules[moduleName];
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerAbstractModuleFactoryManagerPrivate
+::addModuleDependees(const QString& moduleName, const QStringList& dependencies)
+{
+  foreach(const QString& dependency, dependencies)
+    {
+    QStringList dependees = this->ModuleDependees.value(dependency);
+    if (!dependees.contains(moduleName))
+      {
+      this->ModuleDependees.insert(dependency, dependees << moduleName);
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+QVariantMap qSlicerAbstractModuleFactoryManagerPrivate
+::cachedModuleMetadata(const QString& moduleName)const
+{
+  QVariantMap metadata;
+  if (this->ModuleMetadataCache.isNull() ||
+      !this->RegisteredModuleFiles.contains(moduleName))
+    {
+    return metadata;
+    }
+  const QFileInfo file = this->RegisteredModuleFiles.value(moduleName);
+  QSettings* cache = this->ModuleMetadataCache.data();
+  cache->beginGroup(moduleName);
+  // The entry is out of date if the module has been moved or rebuilt
+  if (cache->value("path").toString() == file.absoluteFilePath() &&
+      cache->value("lastModified").toDateTime() == file.lastModified())
+    {
+    foreach(const QString& key, cache->childKeys())
+      {
+      metadata[key] = cache->value(key);
+      }
+    metadata.remove("path");
+    metadata.remove("lastModified");
+    // INI files don't distinguish lists of one element from strings
+    foreach(const QString& key, metadataListKeys())
+      {
+      metadata[key] = metadata.value(key).toStringList();
+      }
+    }
+  cache->endGroup();
+  return metadata;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerAbstractModuleFactoryManagerPrivate
+::cacheModuleMetadata(const QString& moduleName, qSlicerAbstractCoreModule* module)
+{
+  if (this->ModuleMetadataCache.isNull() ||
+      !this->RegisteredModuleFiles.contains(moduleName))
+    {
+    return;
+    }
+  const QFileInfo file = this->RegisteredModuleFiles.value(moduleName);
+  QSettings* cache = this->ModuleMetadataCache.data();
+  cache->remove(moduleName);
+  cache->beginGroup(moduleName);
+  cache->setValue("path", file.absoluteFilePath());
+  cache->setValue("lastModified", file.lastModified());
+  cache->setValue("title", module->title());
+  cache->setValue("categories", module->categories());
+  cache->setValue("dependencies", module->dependencies());
+  cache->setValue("index", module->index());
+  cache->setValue("hidden", module->isHidden());
+  cache->setValue("builtIn", module->isBuiltIn());
+  cache->setValue("associatedNodeTypes", module->associatedNodeTypes());
+  // The icon is a property of GUI modules (qSlicerAbstractModule)
+  QVariant icon = module->property("icon");
+  if (icon.isValid())
+    {
+    cache->setValue("icon", icon);
+    }
+  cache->endGroup();
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerAbstractModuleFactoryManagerPrivate
+::shouldDeferModule(const QString& moduleName)const
+{
+  if (!this->DeferInstantiation ||
+      !this->ModulesToDefer.contains(moduleName))
+    {
+    return false;
+    }
+  QVariantMap metadata = this->cachedModuleMetadata(moduleName);
+  if (metadata.isEmpty())
+    {
+    return false;
+    }
+  // Hidden modules and modules with associated node types usually register
+  // readers, writers or node types that must be available at startup.
+  return !metadata.value("hidden").toBool() &&
+    metadata.value("associatedNodeTypes").toStringList().isEmpty();
+}
+
 //-----------------------------------------------------------------------------
 QVector<qSlicerAbstractModuleFactoryManagerPrivate::qSlicerModuleFactory*>
 qSlicerAbstractModuleFactoryManagerPrivate
@@ -257,11 +413,14 @@ void qSlicerAbstractModuleFactoryManager::registerModules()
     factory->registerItems();
     foreach(const QString& moduleName, factory->itemKeys())
       {
+      qint64 startTime = this->startupTraceTime();
       if (d->Verbose)
         {
         qDebug() << "Registering: " << moduleName;
         }
       d->RegisteredModules[moduleName] = factory;
+      this->addModuleTraceEvent(moduleName, "register",
+                                startTime, this->startupTraceTime() - startTime);
       emit moduleRegistered(moduleName);
       }
     }
@@ -294,6 +453,7 @@ void qSlicerAbstractModuleFactoryManager::registerModule(const QFileInfo& file)
 {
   Q_D(qSlicerAbstractModuleFactoryManager);
 
+  qint64 startTime = this->startupTraceTime();
   qSlicerFileBasedModuleFactory* moduleFactory = 0;
   foreach(qSlicerFileBasedModuleFactory* factory, d->fileBasedFactories())
     {
@@ -361,6 +521,9 @@ void qSlicerAbstractModuleFactoryManager::registerModule(const QFileInfo& file)
     return;
     }
   d->RegisteredModules[moduleName] = moduleFactory;
+  d->RegisteredModuleFiles[moduleName] = file;
+  this->addModuleTraceEvent(moduleName, "register",
+                            startTime, this->startupTraceTime() - startTime);
   if (!dontEmitSignal)
     {
     emit moduleRegistered(moduleName);
@@ -373,6 +536,22 @@ void qSlicerAbstractModuleFactoryManager::instantiateModules()
   Q_D(qSlicerAbstractModuleFactoryManager);
   foreach (const QString& moduleName, d->RegisteredModules.keys())
     {
+    if (this->isInstantiated(moduleName))
+      {
+      continue;
+      }
+    if (d->shouldDeferModule(moduleName))
+      {
+      if (d->Verbose)
+        {
+        qDebug() << "Deferring instantiation of: " << moduleName;
+        }
+      d->DeferredModules.insert(moduleName);
+      d->addModuleDependees(
+        moduleName, d->cachedModuleMetadata(moduleName).value("dependencies").toStringList());
+      emit moduleDeferred(moduleName);
+      continue;
+      }
     this->instantiateModule(moduleName);
     }
 
@@ -400,6 +579,7 @@ qSlicerAbstractCoreModule* qSlicerAbstractModuleFactoryManager
     qCritical() << "Fail to instantiate module " << moduleName << " (not registered)";
     return 0;
     }
+  qint64 startTime = this->startupTraceTime();
   qSlicerAbstractCoreModule* module = factory->instantiate(moduleName);
   if (!module)
     {
@@ -412,14 +592,11 @@ qSlicerAbstractCoreModule* qSlicerAbstractModuleFactoryManager
     {
     qSlicerCoreApplication::application()->addModuleAssociatedNodeType(associatedNodeType, moduleName);
     }
-  foreach(const QString& dependency, module->dependencies())
-    {
-    QStringList dependees = d->ModuleDependees.value(dependency);
-    if (!dependees.contains(moduleName))
-      {
-      d->ModuleDependees.insert(dependency, dependees << moduleName);
-      }
-    }
+  d->addModuleDependees(moduleName, module->dependencies());
+  d->DeferredModules.remove(moduleName);
+  d->cacheModuleMetadata(moduleName, module);
+  this->addModuleTraceEvent(moduleName, "instantiate",
+                            startTime, this->startupTraceTime() - startTime);
   emit moduleInstantiated(moduleName);
   return module;
 }
@@ -554,3 +731,164 @@ void qSlicerAbstractModuleFactoryManager::setIsVerbose(bool flag)
   d->Verbose = flag;
 }
 
+
+//---------------------------------------------------------------------------
+void qSlicerAbstractModuleFactoryManager::setDeferInstantiation(bool defer)
+{
+  Q_D(qSlicerAbstractModuleFactoryManager);
+  d->DeferInstantiation = defer;
+}
+
+//---------------------------------------------------------------------------
+bool qSlicerAbstractModuleFactoryManager::deferInstantiation()const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+  return d->DeferInstantiation;
+}
+
+//---------------------------------------------------------------------------
+void qSlicerAbstractModuleFactoryManager::setModulesToDefer(const QStringList& moduleNames)
+{
+  Q_D(qSlicerAbstractModuleFactoryManager);
+  d->ModulesToDefer = moduleNames;
+}
+
+//---------------------------------------------------------------------------
+QStringList qSlicerAbstractModuleFactoryManager::modulesToDefer()const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+  return d->ModulesToDefer;
+}
+
+//---------------------------------------------------------------------------
+void qSlicerAbstractModuleFactoryManager::setModuleMetadataCacheFilePath(const QString& filePath)
+{
+  Q_D(qSlicerAbstractModuleFactoryManager);
+  if (d->ModuleMetadataCacheFilePath == filePath)
+    {
+    return;
+    }
+  d->ModuleMetadataCacheFilePath = filePath;
+  d->ModuleMetadataCache.reset(
+    filePath.isEmpty() ? 0 : new QSettings(filePath, QSettings::IniFormat));
+}
+
+//---------------------------------------------------------------------------
+QString qSlicerAbstractModuleFactoryManager::moduleMetadataCacheFilePath()const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+  return d->ModuleMetadataCacheFilePath;
+}
+
+//---------------------------------------------------------------------------
+QStringList qSlicerAbstractModuleFactoryManager::deferredModuleNames()const
+{
+  QStringList deferredModules;
+  foreach(const QString& moduleName, this->registeredModuleNames())
+    {
+    if (this->isDeferred(moduleName))
+      {
+      deferredModules << moduleName;
+      }
+    }
+  return deferredModules;
+}
+
+//---------------------------------------------------------------------------
+bool qSlicerAbstractModuleFactoryManager::isDeferred(const QString& moduleName)const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+  return d->DeferredModules.contains(moduleName) &&
+    this->isRegistered(moduleName) &&
+    !this->isInstantiated(moduleName);
+}
+
+//---------------------------------------------------------------------------
+QVariantMap qSlicerAbstractModuleFactoryManager::moduleMetadata(const QString& moduleName)const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+  return d->cachedModuleMetadata(moduleName);
+}
+
+//---------------------------------------------------------------------------
+qint64 qSlicerAbstractModuleFactoryManager::startupTraceTime()const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+#if QT_VERSION >= 0x040800
+  return d->StartupTimer.nsecsElapsed() / 1000;
+#else
+  return d->StartupTimer.elapsed() * 1000;
+#endif
+}
+
+//---------------------------------------------------------------------------
+void qSlicerAbstractModuleFactoryManager::addModuleTraceEvent(
+  const QString& moduleName, const QString& phase, qint64 startTime, qint64 duration)
+{
+  Q_D(qSlicerAbstractModuleFactoryManager);
+  qSlicerAbstractModuleFactoryManagerPrivate::TraceEvent event;
+  event.ModuleName = moduleName;
+  event.Phase = phase;
+  event.StartTime = startTime;
+  event.Duration = duration;
+  d->TraceEvents << event;
+}
+
+//---------------------------------------------------------------------------
+QString qSlicerAbstractModuleFactoryManager::startupTrace()const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+  // Total duration of each phase for each module
+  QMap<QString, QMap<QString, qint64> > moduleDurations;
+  foreach(const QString& moduleName, this->registeredModuleNames())
+    {
+    moduleDurations[moduleName];
+    }
+
+  QString trace;
+  QTextStream stream(&trace);
+  stream << "{\n\"traceEvents\": [";
+  for (int i = 0; i < d->TraceEvents.count(); ++i)
+    {
+    const qSlicerAbstractModuleFactoryManagerPrivate::TraceEvent& event = d->TraceEvents.at(i);
+    moduleDurations[event.ModuleName][event.Phase] += event.Duration;
+    stream << (i > 0 ? ",\n" : "\n")
+           << "  {\"name\": " << toJSONString(event.ModuleName)
+           << ", \"cat\": " << toJSONString(event.Phase)
+           << ", \"ph\": \"X\", \"ts\": " << event.StartTime
+           << ", \"dur\": " << event.Duration
+           << ", \"pid\": 1, \"tid\": 1}";
+    }
+  stream << "\n],\n\"modules\": {";
+  bool firstModule = true;
+  foreach(const QString& moduleName, moduleDurations.keys())
+    {
+    stream << (firstModule ? "\n" : ",\n")
+           << "  " << toJSONString(moduleName) << ": {";
+    firstModule = false;
+    const QMap<QString, qint64>& durations = moduleDurations[moduleName];
+    foreach(const QString& phase, durations.keys())
+      {
+      stream << toJSONString(phase) << ": "
+             << QString::number(durations[phase] / 1000., 'f', 3) << ", ";
+      }
+    stream << "\"deferred\": " << (this->isDeferred(moduleName) ? "true" : "false") << "}";
+    }
+  stream << "\n}\n}\n";
+  stream.flush();
+  return trace;
+}
+
+//---------------------------------------------------------------------------
+bool qSlicerAbstractModuleFactoryManager::writeStartupTrace(const QString& fileName)const
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate))
+    {
+    qWarning() << "Failed to write startup trace into" << fileName;
+    return false;
+    }
+  QTextStream stream(&file);
+  stream << this->startupTrace();
+  return true;
+}
@@ -24,6 +24,7 @@
 // Qt includes
 #include <QObject>
 #include <QString>
+#include <QVariantMap>
 
 // CTK includes
 #include <ctkAbstractFileBasedFactory.h>
@@ -62,6 +63,22 @@ class qSlicerAbstractModuleFactoryManagerPrivate;
 /// The order of initialization is defined with the dependencies of the modules.
 /// If module B depends of module A, it is assured that module B is initialized/setup after A.
 ///   factoryManager->loadModules();
+///
+/// To speed up startup, the instantiation of selected modules can be deferred
+/// (see \a deferInstantiation and \a modulesToDefer). The metadata of the
+/// modules (title, categories, dependencies, icon...) is saved into a cache
+/// file (see \a moduleMetadataCacheFilePath) when the modules are
+/// instantiated. At the next startup, instantiateModules() skips the modules
+/// to defer that have an up-to-date metadata entry; they are instantiated
+/// when first used or when a loaded module depends on them.
+/// Deferred modules are not available in python (slicer.modules) until
+/// they are loaded.
+/// Deferral is opt-in: \a modulesToDefer is empty by default, so no module
+/// is deferred and startup time is unchanged until modules are listed
+/// (the application reads them from the Modules/ModulesToDefer setting).
+///
+/// The time spent registering, instantiating and setting up each module is
+/// recorded and can be exported as JSON with writeStartupTrace().
 class Q_SLICER_BASE_QTCORE_EXPORT qSlicerAbstractModuleFactoryManager : public QObject
 {
   Q_OBJECT
@@ -82,6 +99,27 @@ class Q_SLICER_BASE_QTCORE_EXPORT qSlicerAbstractModuleFactoryManager : public Q
   /// Due to the large amount of modules to load, it can be faster (and less
   /// overwhelming) to load only a subset of the modules.
   Q_PROPERTY(QStringList modulesToIgnore READ modulesToIgnore WRITE setModulesToIgnore NOTIFY modulesToIgnoreChanged)
+
+  /// This property controls whether instantiateModules() defers the
+  /// instantiation of the modules listed in \a modulesToDefer that have
+  /// up-to-date cached metadata.
+  ///
+  /// Modules that are not file based (core modules), hidden modules and
+  /// modules with associated node types are always instantiated.
+  /// False by default.
+  /// \sa isDeferred(), moduleMetadata()
+  Q_PROPERTY(bool deferInstantiation READ deferInstantiation WRITE setDeferInstantiation)
+
+  /// This property holds the names of the modules whose instantiation can
+  /// be deferred when \a deferInstantiation is enabled. Other modules are
+  /// always instantiated by instantiateModules().
+  /// Empty by default.
+  Q_PROPERTY(QStringList modulesToDefer READ modulesToDefer WRITE setModulesToDefer)
+
+  /// This property holds the path of the file (INI format) where the
+  /// metadata of the instantiated modules is cached.
+  /// If empty (default), no metadata is cached and no module is deferred.
+  Q_PROPERTY(QString moduleMetadataCacheFilePath READ moduleMetadataCacheFilePath WRITE setModuleMetadataCacheFilePath)
 public:
   typedef ctkAbstractFileBasedFactory<qSlicerAbstractCoreModule> qSlicerFileBasedModuleFactory;
   typedef ctkAbstractFactory<qSlicerAbstractCoreModule> qSlicerModuleFactory;
@@ -183,6 +221,43 @@ public:
   /// Uninstantiate all instantiated modules
   void uninstantiateModules();
 
+  void setDeferInstantiation(bool defer);
+  bool deferInstantiation()const;
+
+  void setModulesToDefer(const QStringList& moduleNames);
+  QStringList modulesToDefer()const;
+
+  void setModuleMetadataCacheFilePath(const QString& filePath);
+  QString moduleMetadataCacheFilePath()const;
+
+  /// List of registered modules whose instantiation has been deferred and
+  /// that have not been instantiated yet.
+  Q_INVOKABLE QStringList deferredModuleNames()const;
+
+  /// Return true if the instantiation of the module has been deferred and
+  /// the module has not been instantiated yet.
+  Q_INVOKABLE bool isDeferred(const QString& name)const;
+
+  /// Return the metadata of a module: "title", "categories", "dependencies",
+  /// "index", "hidden", "builtIn", "associatedNodeTypes" and "icon" (if the
+  /// module has an icon property).
+  /// The metadata is read from the cache if it is up-to-date with the module
+  /// file, an empty map is returned otherwise.
+  Q_INVOKABLE QVariantMap moduleMetadata(const QString& name)const;
+
+  /// Return the startup trace as a JSON document.
+  /// The "traceEvents" array follows the Trace Event Format (it can be opened
+  /// in chrome://tracing), times are in microseconds since the creation of
+  /// the factory manager. The "modules" object gives for each module the
+  /// "register", "instantiate" and "setup" durations in milliseconds and
+  /// whether its instantiation is "deferred".
+  QString startupTrace()const;
+
+  /// Write the startup trace into \a fileName.
+  /// Return false if the file can't be written.
+  /// \sa startupTrace()
+  bool writeStartupTrace(const QString& fileName)const;
+
   /// Enable/Disable verbose output during module discovery process
   void setVerboseModuleDiscovery(bool value);
 
@@ -207,6 +282,8 @@ signals:
   void modulesToIgnoreChanged(const QStringList& moduleNames);
   void moduleIgnored(const QString& moduleName);
 
+  void moduleDeferred(const QString& moduleName);
+
   void modulesInstantiated(const QStringList& moduleNames);
   void moduleInstantiated(const QString& moduleName);
 
@@ -233,6 +310,15 @@ protected:
   /// Uninstantiate a module given its \a moduleName
   virtual void uninstantiateModule(const QString& moduleName);
 
+  /// Time in microseconds since the creation of the factory manager
+  qint64 startupTraceTime()const;
+
+  /// Add an event to the startup trace.
+  /// \a phase is "register", "instantiate" or "setup".
+  /// \sa startupTraceTime(), startupTrace()
+  void addModuleTraceEvent(const QString& moduleName, const QString& phase,
+                           qint64 startTime, qint64 duration);
+
 private:
   Q_DECLARE_PRIVATE(qSlicerAbstractModuleFactoryManager);
   Q_DISABLE_COPY(qSlicerAbstractModuleFactoryManager);
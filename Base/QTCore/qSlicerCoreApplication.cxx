@@ -86,6 +86,7 @@
 
 // MRML includes
 #include <vtkCacheManager.h>
+#include <vtkEventBroker.h>
 #include <vtkMRMLCrosshairNode.h>
 #ifdef Slicer_BUILD_CLI_SUPPORT
 # include <vtkMRMLCommandLineModuleNode.h>
@@ -291,6 +292,11 @@ void qSlicerCoreApplicationPrivate::init()
   vtkMRMLSliceViewDisplayableManagerFactory::GetInstance()->SetMRMLApplicationLogic(
     this->AppLogic.GetPointer());
 
+  // Events deferred or posted from other threads by the event broker are
+  // delivered at the next iteration of the event loop.
+  vtkEventBroker::GetInstance()->SetDispatchRequestHandler(
+    qSlicerCoreApplicationPrivate::requestEventBrokerDispatch, q);
+
   // pass through event handling once without observing the scene
   // -- allows any dependent nodes to be created
   // Note that Interaction and Selection Node are now created
@@ -371,6 +377,14 @@ void qSlicerCoreApplicationPrivate::init()
     }
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerCoreApplicationPrivate::requestEventBrokerDispatch(void* clientData)
+{
+  qSlicerCoreApplication* q = reinterpret_cast<qSlicerCoreApplication*>(clientData);
+  // queued invocation is thread-safe
+  QMetaObject::invokeMethod(q, "processEventBrokerQueue", Qt::QueuedConnection);
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerCoreApplicationPrivate::initDataIO()
 {
@@ -636,6 +650,7 @@ qSlicerCoreApplication::qSlicerCoreApplication(
 //-----------------------------------------------------------------------------
 qSlicerCoreApplication::~qSlicerCoreApplication()
 {
+  vtkEventBroker::GetInstance()->SetDispatchRequestHandler(0, 0);
 }
 
 //-----------------------------------------------------------------------------
@@ -1519,6 +1534,12 @@ void qSlicerCoreApplication::processAppLogicWriteData()
   d->AppLogic->ProcessWriteData();
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerCoreApplication::processEventBrokerQueue()
+{
+  vtkEventBroker::GetInstance()->ProcessEventQueue();
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerCoreApplication::terminate(int returnCode)
 {
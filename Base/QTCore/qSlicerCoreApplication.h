@@ -390,6 +390,11 @@ protected slots:
   void processAppLogicReadData();
   void processAppLogicWriteData();
 
+  /// Invoke the events queued or posted from other threads in the event broker.
+  /// Called once per event loop iteration when the broker requests it.
+  /// \sa vtkEventBroker::SetDispatchRequestHandler()
+  void processEventBrokerQueue();
+
   /// Set the ReturnCode flag and call QCoreApplication::exit()
   void terminate(int exitCode = qSlicerCoreApplication::ExitSuccess);
 
@@ -65,6 +65,11 @@ public:
 
   virtual void init();
 
+  /// Called by the event broker (from any thread) to schedule the processing
+  /// of its event queue in the main thread.
+  /// \sa qSlicerCoreApplication::processEventBrokerQueue()
+  static void requestEventBrokerDispatch(void* clientData);
+
   /// Set up the local and remote data input/output for this application.
   /// Use this as a template for creating stand alone scenes, then call
   /// vtkSlicerApplicationLogic::SetMRMLSceneDataIO to hook it into a scene.
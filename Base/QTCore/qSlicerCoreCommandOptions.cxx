@@ -305,6 +305,20 @@ bool qSlicerCoreCommandOptions::verboseModuleDiscovery() const
   return d->ParsedArgs.value("verbose-module-discovery").toBool();
 }
 
+//-----------------------------------------------------------------------------
+bool qSlicerCoreCommandOptions::deferModuleInstantiation() const
+{
+  Q_D(const qSlicerCoreCommandOptions);
+  return d->ParsedArgs.value("defer-module-instantiation").toBool();
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerCoreCommandOptions::moduleStartupTrace() const
+{
+  Q_D(const qSlicerCoreCommandOptions);
+  return d->ParsedArgs.value("module-startup-trace").toString();
+}
+
 //-----------------------------------------------------------------------------
 bool qSlicerCoreCommandOptions::verbose()const
 {
@@ -454,6 +468,12 @@ void qSlicerCoreCommandOptions::addArguments()
   this->addArgument("verbose-module-discovery", "", QVariant::Bool,
                     "Enable verbose output during module discovery process.");
 
+  this->addArgument("defer-module-instantiation", "", QVariant::Bool,
+                    "Instantiate the modules listed in the Modules/ModulesToDefer setting only when they are used.");
+
+  this->addArgument("module-startup-trace", "", QVariant::String,
+                    "Write the register, instantiate and setup time of each module into the given JSON file.");
+
   this->addArgument("disable-settings", "", QVariant::Bool,
                     "Start application ignoring user settings and using new temporary settings.");
 
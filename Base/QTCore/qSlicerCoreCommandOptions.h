@@ -53,6 +53,8 @@ class Q_SLICER_BASE_QTCORE_EXPORT qSlicerCoreCommandOptions : public ctkCommandL
   Q_PROPERTY(bool displayTemporaryPathAndExit READ displayTemporaryPathAndExit CONSTANT)
   Q_PROPERTY(bool displayMessageAndExit READ displayMessageAndExit STORED false CONSTANT)
   Q_PROPERTY(bool verboseModuleDiscovery READ verboseModuleDiscovery CONSTANT)
+  Q_PROPERTY(bool deferModuleInstantiation READ deferModuleInstantiation CONSTANT)
+  Q_PROPERTY(QString moduleStartupTrace READ moduleStartupTrace CONSTANT)
   Q_PROPERTY(bool disableMessageHandlers READ disableMessageHandlers CONSTANT)
   Q_PROPERTY(bool testingEnabled READ isTestingEnabled CONSTANT)
 #ifdef Slicer_USE_PYTHONQT
@@ -157,6 +159,16 @@ public:
   /// Return True if slicer should display details regarding the module discovery process
   bool verboseModuleDiscovery()const;
 
+  /// Return True if the instantiation of the modules listed in the
+  /// Modules/ModulesToDefer setting should be deferred until they are used.
+  /// \sa qSlicerAbstractModuleFactoryManager::deferInstantiation
+  bool deferModuleInstantiation()const;
+
+  /// Return the file where the per-module register, instantiate and setup
+  /// times should be written (JSON) once the application has started.
+  /// \sa qSlicerAbstractModuleFactoryManager::writeStartupTrace()
+  QString moduleStartupTrace()const;
+
   /// Return True if slicer should display information at startup
   bool verbose()const;
 
@@ -91,7 +91,10 @@ bool qSlicerModuleFactoryManager::loadModules(const QStringList& modules)
   // Ensure requested modules are instantiated
   foreach(const QString& moduleKey, modules)
     {
-    this->instantiateModule(moduleKey);
+    if (!this->isInstantiated(moduleKey))
+      {
+      this->instantiateModule(moduleKey);
+      }
     }
 
   // Load requested modules
@@ -124,6 +127,13 @@ bool qSlicerModuleFactoryManager::loadModule(const QString& name, const QString&
     return false;
     }
 
+  // Deferred modules are instantiated on first use or when a module
+  // depending on them is loaded.
+  if (this->isDeferred(name))
+    {
+    this->instantiateModule(name);
+    }
+
   // A module should be registered when attempting to load it
   if (!this->isRegistered(name) ||
       !this->isInstantiated(name))
@@ -169,6 +179,7 @@ bool qSlicerModuleFactoryManager::loadModule(const QString& name, const QString&
   d->LoadedModules << name;
 
   // Initialize module
+  qint64 setupStartTime = this->startupTraceTime();
   instance->initialize(d->AppLogic);
 
   // Check the module has a title (required)
@@ -181,6 +192,8 @@ bool qSlicerModuleFactoryManager::loadModule(const QString& name, const QString&
 
   // Set the MRML scene
   instance->setMRMLScene(d->MRMLScene);
+  this->addModuleTraceEvent(name, "setup",
+                            setupStartTime, this->startupTraceTime() - setupStartTime);
 
   // Module should also be aware if current MRML scene has changed
   this->connect(this,SIGNAL(mrmlSceneChanged(vtkMRMLScene*)),
@@ -85,6 +85,8 @@ public:
   Q_INVOKABLE bool loadModules(const QStringList& modules);
 
   /// Load module identified by \a name
+  /// If the instantiation of the module has been deferred, the module is
+  /// instantiated first.
   /// \todo move it as protected
   bool loadModule(const QString& name);
 
@@ -72,6 +72,10 @@ qSlicerModuleFactoryManager* qSlicerModuleManager::factoryManager()const
 qSlicerAbstractCoreModule* qSlicerModuleManager::module(const QString& name)const
 {
   Q_D(const qSlicerModuleManager);
+  if (d->ModuleFactoryManager->isDeferred(name))
+    {
+    d->ModuleFactoryManager->loadModule(name);
+    }
   return d->ModuleFactoryManager->loadedModule(name);
 }
 
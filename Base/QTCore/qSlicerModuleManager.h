@@ -53,6 +53,9 @@ public:
   Q_INVOKABLE QStringList modulesNames()const;
 
   /// Return the loaded module identified by \a name
+  /// A module whose instantiation has been deferred is instantiated and
+  /// loaded on first request.
+  /// \sa qSlicerAbstractModuleFactoryManager::deferInstantiation
   Q_INVOKABLE qSlicerAbstractCoreModule* module(const QString& name)const;
 
 signals:
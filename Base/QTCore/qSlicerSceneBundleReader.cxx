@@ -84,7 +84,7 @@ bool qSlicerSceneBundleReader::load(const qSlicerIO::IOProperties& properties)
                         QString("/__BundleLoadTemp") +
                           QDateTime::currentDateTime().toString("yyyy-MM-dd_hh+mm+ss.zzz") );
 
-  qDebug() << "Unpacking bundle " << file << " to " << unpackPath;
+  qDebug() << "Loading bundle " << file << " using " << unpackPath;
 
   if (QFileInfo(unpackPath).isDir())
     {
@@ -99,27 +99,18 @@ bool qSlicerSceneBundleReader::load(const qSlicerIO::IOProperties& properties)
     return false;
     }
 
-  vtkNew<vtkMRMLApplicationLogic> appLogic;
-  appLogic->SetMRMLScene( this->mrmlScene() );
-  std::string mrmlFile = appLogic->UnpackSlicerDataBundle(
-                                          file.toLatin1(), unpackPath.toLatin1() );
-
-  this->mrmlScene()->SetURL(mrmlFile.c_str());
-
   bool clear = false;
   if (properties.contains("clear"))
     {
     clear = properties["clear"].toBool();
     }
-  int res = 0;
-  if (clear)
-    {
-    res = this->mrmlScene()->Connect();
-    }
-  else
-    {
-    res = this->mrmlScene()->Import();
-    }
+
+  // The scene is read from the archive in memory and only the data files
+  // it references are extracted (in parallel) for the storage nodes.
+  vtkNew<vtkMRMLApplicationLogic> appLogic;
+  appLogic->SetMRMLScene( this->mrmlScene() );
+  int res = appLogic->LoadSlicerDataBundle(
+    file.toLatin1(), unpackPath.toLatin1(), clear);
 
   if (!ctk::removeDirRecursively(unpackPath))
     {
@@ -20,10 +20,13 @@
 
 // Qt includes
 #include <QDebug>
+#include <QHash>
+#include <QIcon>
 #include <QSettings>
 
 // CTK includes
 #include "qSlicerAbstractModule.h"
+#include "qSlicerModuleFactoryManager.h"
 #include "qSlicerModuleManager.h"
 
 // SlicerQt includes
@@ -42,6 +45,14 @@ public:
   void addModuleAction(QMenu* menu, QAction* moduleAction, bool useIndex = true, bool builtIn = true);
   QMenu* menu(QMenu* parentMenu, QStringList subCategories, bool builtIn = true);
 
+  /// Return true if a module with the given properties should be listed.
+  bool isModuleShown(bool hidden, const QStringList& categories)const;
+  /// Add the module action into the category submenus and "All Modules".
+  void insertModuleAction(QAction* moduleAction, const QStringList& categories, bool builtIn);
+  /// Remove the action added for a deferred module.
+  /// Return true if there was an action for the module.
+  bool removeDeferredModuleAction(const QString& moduleName);
+
   QAction* action(const QVariant& actionData, const QMenu* parentMenu)const;
   QAction* action(const QString& text, const QMenu* parentMenu)const;
   QMenu*   actionMenu(QAction* action, QMenu* parentMenu)const;
@@ -53,6 +64,10 @@ public:
   bool                  DuplicateActions;
   bool                  ShowHiddenModules;
   QStringList           TopLevelCategoryOrder;
+  /// Actions created from the metadata of the modules whose instantiation
+  /// has been deferred. They are replaced by the module actions once the
+  /// modules are loaded.
+  QHash<QString, QAction*> DeferredModuleActions;
 };
 
 //---------------------------------------------------------------------------
@@ -96,6 +111,72 @@ void qSlicerModulesMenuPrivate::addDefaultCategories()
   // after the separator are the predefined categories
 }
 
+//---------------------------------------------------------------------------
+bool qSlicerModulesMenuPrivate::isModuleShown(bool hidden, const QStringList& categories)const
+{
+  if (hidden && !this->ShowHiddenModules)
+    {
+    // ignore hidden modules
+    return false;
+    }
+
+  // Only show modules in Testing category if developer mode is enabled
+  // to not clutter the module list for regular users with tests
+  QSettings settings;
+  bool developerModeEnabled = settings.value("Developer/DeveloperMode", false).toBool();
+  if (!developerModeEnabled)
+    {
+    bool testOnlyModule = true;
+    foreach(const QString& category, categories)
+      {
+      if (category.split('.').takeFirst()!="Testing")
+        {
+        testOnlyModule = false;
+        }
+      }
+    if (testOnlyModule)
+      {
+      // This module only appears in the Testing category but we are not in developer mode,
+      // so do not add this module to the module menu
+      return false;
+      }
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void qSlicerModulesMenuPrivate::insertModuleAction(QAction* moduleAction, const QStringList& categories, bool builtIn)
+{
+  Q_Q(qSlicerModulesMenu);
+  QObject::connect(moduleAction, SIGNAL(triggered(bool)),
+                   q, SLOT(onActionTriggered()));
+
+  foreach(const QString& category, categories)
+    {
+    QMenu* menu = this->menu(q, category.split('.'), builtIn);
+    this->addModuleAction(menu, moduleAction, true, builtIn);
+    }
+  // Add in "All Modules" as well
+  this->addModuleAction(this->AllModulesMenu, moduleAction, false, true);
+}
+
+//---------------------------------------------------------------------------
+bool qSlicerModulesMenuPrivate::removeDeferredModuleAction(const QString& moduleName)
+{
+  QAction* moduleAction = this->DeferredModuleActions.take(moduleName);
+  if (!moduleAction)
+    {
+    return false;
+    }
+  foreach(QWidget* widget, moduleAction->associatedWidgets())
+    {
+    widget->removeAction(moduleAction);
+    }
+  // The action may be the one being triggered
+  moduleAction->deleteLater();
+  return true;
+}
+
 //---------------------------------------------------------------------------
 QAction* qSlicerModulesMenuPrivate::action(const QVariant& actionData, const QMenu* parentMenu)const
 {
@@ -365,8 +446,15 @@ void qSlicerModulesMenu::setModuleManager(qSlicerModuleManager* moduleManager)
     QObject::disconnect(d->ModuleManager,
                         SIGNAL(moduleAboutToBeUnloaded(QString)),
                         this, SLOT(removeModule(QString)));
+    QObject::disconnect(d->ModuleManager->factoryManager(),
+                        SIGNAL(moduleDeferred(QString)),
+                        this, SLOT(addDeferredModule(QString)));
     }
 
+  foreach(const QString& moduleName, d->DeferredModuleActions.keys())
+    {
+    d->removeDeferredModuleAction(moduleName);
+    }
   this->clear();
   d->addDefaultCategories();
 
@@ -383,7 +471,15 @@ void qSlicerModulesMenu::setModuleManager(qSlicerModuleManager* moduleManager)
   QObject::connect(d->ModuleManager,
                    SIGNAL(moduleAboutToBeUnloaded(QString)),
                    this, SLOT(removeModule(QString)));
+  QObject::connect(d->ModuleManager->factoryManager(),
+                   SIGNAL(moduleDeferred(QString)),
+                   this, SLOT(addDeferredModule(QString)));
   this->addModules(d->ModuleManager->modulesNames());
+  foreach(const QString& moduleName,
+          d->ModuleManager->factoryManager()->deferredModuleNames())
+    {
+    this->addDeferredModule(moduleName);
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -417,34 +513,14 @@ void qSlicerModulesMenu::addModule(qSlicerAbstractCoreModule* moduleToAdd)
     qWarning() << "A module needs a QAction to be handled by qSlicerModulesMenu";
     return;
     }
-  if (module->isHidden() && !d->ShowHiddenModules)
+  // A deferred module is selected from its placeholder action, it is
+  // already current when it gets loaded.
+  bool wasDeferred = d->removeDeferredModuleAction(module->name());
+  if (!d->isModuleShown(module->isHidden(), module->categories()))
     {
-    // ignore hidden modules
     return;
     }
 
-  // Only show modules in Testing category if developer mode is enabled
-  // to not clutter the module list for regular users with tests
-  QSettings settings;
-  bool developerModeEnabled = settings.value("Developer/DeveloperMode", false).toBool();
-  if (!developerModeEnabled)
-    {
-    bool testOnlyModule = true;
-    foreach(const QString& category, module->categories())
-      {
-      if (category.split('.').takeFirst()!="Testing")
-        {
-        testOnlyModule = false;
-        }
-      }
-    if (testOnlyModule)
-      {
-      // This module only appears in the Testing category but we are not in developer mode,
-      // so do not add this module to the module menu
-      return;
-      }
-    }
-
   QAction* moduleAction = module->action();
   Q_ASSERT(moduleAction);
   if (d->DuplicateActions)
@@ -455,25 +531,45 @@ void qSlicerModulesMenu::addModule(qSlicerAbstractCoreModule* moduleToAdd)
     duplicateAction->setProperty("index", moduleAction->property("index"));
     moduleAction = duplicateAction;
     }
-  QObject::connect(moduleAction, SIGNAL(triggered(bool)),
-                   this, SLOT(onActionTriggered()));
-
-  foreach(const QString& category, module->categories())
-    {
-    QMenu* menu = d->menu(this, category.split('.'), module->isBuiltIn());
-    d->addModuleAction(menu, moduleAction, true, module->isBuiltIn());
-    }
-  // Add in "All Modules" as well
-  d->addModuleAction(d->AllModulesMenu, moduleAction, false, true);
+  d->insertModuleAction(moduleAction, module->categories(), module->isBuiltIn());
 
   // Maybe the module was set current before it was added into the menu
-  if (d->CurrentModule == moduleAction->data().toString())
+  if (!wasDeferred && d->CurrentModule == moduleAction->data().toString())
     {
     moduleAction->trigger();
     emit currentModuleChanged(d->CurrentModule);
     }
 }
 
+//---------------------------------------------------------------------------
+void qSlicerModulesMenu::addDeferredModule(const QString& moduleName)
+{
+  Q_D(qSlicerModulesMenu);
+  if (!d->ModuleManager || d->DeferredModuleActions.contains(moduleName))
+    {
+    return;
+    }
+  QVariantMap metadata = d->ModuleManager->factoryManager()->moduleMetadata(moduleName);
+  if (metadata.isEmpty())
+    {
+    return;
+    }
+  QStringList categories = metadata.value("categories").toStringList();
+  if (!d->isModuleShown(metadata.value("hidden").toBool(), categories))
+    {
+    return;
+    }
+  // Same properties as qSlicerAbstractModule::action()
+  QAction* moduleAction = new QAction(metadata.value("icon").value<QIcon>(),
+                                      metadata.value("title").toString(), this);
+  moduleAction->setObjectName(QString("action%1").arg(moduleName));
+  moduleAction->setData(moduleName);
+  moduleAction->setIconVisibleInMenu(true);
+  moduleAction->setProperty("index", metadata.value("index"));
+  d->DeferredModuleActions[moduleName] = moduleAction;
+  d->insertModuleAction(moduleAction, categories, metadata.value("builtIn").toBool());
+}
+
 //---------------------------------------------------------------------------
 void qSlicerModulesMenu::removeModule(const QString& moduleName)
 {
@@ -98,6 +98,13 @@ public slots:
   /// \sa qSlicerAbstractCoreModule::isHidden()
   void addModule(const QString& moduleName);
 
+  /// Add a module whose instantiation has been deferred into the menu.
+  /// The action is created from the cached metadata of the module and
+  /// selecting it loads the module. It is replaced by the module action
+  /// when the module is loaded.
+  /// \sa qSlicerAbstractModuleFactoryManager::moduleMetadata()
+  void addDeferredModule(const QString& moduleName);
+
   /// Remove the module from the list of available module
   void removeModule(const QString& moduleName);
 
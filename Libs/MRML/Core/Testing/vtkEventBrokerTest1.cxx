@@ -0,0 +1,197 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkObservation.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct CallbackData
+{
+  int ID;
+  std::vector<int>* Invocations;
+  vtkObject* SubjectToModify;
+};
+
+//----------------------------------------------------------------------------
+void RecordCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                    void* clientData, void* vtkNotUsed(callData))
+{
+  CallbackData* data = reinterpret_cast<CallbackData*>(clientData);
+  data->Invocations->push_back(data->ID);
+  if (data->SubjectToModify)
+    {
+    data->SubjectToModify->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int DispatchRequestCount = 0;
+void CountDispatchRequest(void* vtkNotUsed(clientData))
+{
+  ++DispatchRequestCount;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE PostEventsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkObject* subject = static_cast<vtkObject*>(info->UserData);
+  for (int i = 0; i < 1000; ++i)
+    {
+    vtkEventBroker::GetInstance()->PostEvent(subject, vtkCommand::ModifiedEvent);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+bool CheckInvocations(int line, const std::vector<int>& invocations, int expectedCount, const int* expected)
+{
+  bool same = (static_cast<int>(invocations.size()) == expectedCount);
+  for (int i = 0; same && i < expectedCount; ++i)
+    {
+    same = (invocations[i] == expected[i]);
+    }
+  if (!same)
+    {
+    std::cerr << "Line " << line << ": unexpected invocations:";
+    for (size_t i = 0; i < invocations.size(); ++i)
+      {
+      std::cerr << " " << invocations[i];
+      }
+    std::cerr << std::endl;
+    }
+  return same;
+}
+
+//----------------------------------------------------------------------------
+int TestDeferredMode()
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  vtkNew<vtkObject> lowPrioritySubject;
+  vtkNew<vtkObject> highPrioritySubject;
+  vtkNew<vtkObject> cascadedSubject;
+  vtkNew<vtkObject> observer;
+
+  // the low priority observation modifies cascadedSubject
+  std::vector<int> invocations;
+  CallbackData lowPriorityData = { 1, &invocations, cascadedSubject.GetPointer() };
+  CallbackData highPriorityData = { 2, &invocations, NULL };
+  CallbackData cascadedData = { 3, &invocations, NULL };
+  vtkNew<vtkCallbackCommand> lowPriorityCallback;
+  lowPriorityCallback->SetCallback(RecordCallback);
+  lowPriorityCallback->SetClientData(&lowPriorityData);
+  vtkNew<vtkCallbackCommand> highPriorityCallback;
+  highPriorityCallback->SetCallback(RecordCallback);
+  highPriorityCallback->SetClientData(&highPriorityData);
+  vtkNew<vtkCallbackCommand> cascadedCallback;
+  cascadedCallback->SetCallback(RecordCallback);
+  cascadedCallback->SetClientData(&cascadedData);
+
+  broker->AddObservation(lowPrioritySubject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), lowPriorityCallback.GetPointer(), -1.0f);
+  broker->AddObservation(highPrioritySubject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), highPriorityCallback.GetPointer(), 1.0f);
+  broker->AddObservation(cascadedSubject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), cascadedCallback.GetPointer());
+
+  broker->SetDispatchRequestHandler(CountDispatchRequest, NULL);
+  DispatchRequestCount = 0;
+  broker->SetEventModeToDeferred();
+
+  // repeated events are coalesced and a single dispatch is requested
+  for (int i = 0; i < 10; ++i)
+    {
+    lowPrioritySubject->Modified();
+    highPrioritySubject->Modified();
+    }
+  if (!CheckInvocations(__LINE__, invocations, 0, NULL)
+      || broker->GetNumberOfQueuedObservations() != 2 || DispatchRequestCount != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": events are not deferred: "
+              << broker->GetNumberOfQueuedObservations() << " queued observations, "
+              << DispatchRequestCount << " dispatch requests" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // observations are invoked once, by priority
+  // and the cascaded event waits for the next dispatch
+  broker->ProcessEventQueue();
+  const int expectedFirstFrame[] = { 2, 1 };
+  if (!CheckInvocations(__LINE__, invocations, 2, expectedFirstFrame)
+      || broker->GetNumberOfQueuedObservations() != 1 || DispatchRequestCount != 2)
+    {
+    std::cerr << "Line " << __LINE__ << ": cascaded event is not deferred: "
+              << broker->GetNumberOfQueuedObservations() << " queued observations, "
+              << DispatchRequestCount << " dispatch requests" << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->ProcessEventQueue();
+  const int expectedSecondFrame[] = { 2, 1, 3 };
+  if (!CheckInvocations(__LINE__, invocations, 3, expectedSecondFrame)
+      || broker->GetNumberOfQueuedObservations() != 0)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // events posted from other threads are coalesced and invoked from the main thread
+  invocations.clear();
+  lowPriorityData.SubjectToModify = NULL;
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(4);
+  threader->SetSingleMethod(PostEventsThread, highPrioritySubject.GetPointer());
+  threader->SingleMethodExecute();
+  // the first thread of the threader is the main thread: its events are
+  // invoked immediately (and queued because of the deferred mode)
+  if (!CheckInvocations(__LINE__, invocations, 0, NULL)
+      || broker->GetNumberOfPostedEvents() != 3000
+      || broker->GetNumberOfQueuedObservations() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": posted events are not queued: "
+              << broker->GetNumberOfPostedEvents() << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->ProcessEventQueue();
+  const int expectedPosted[] = { 2 };
+  if (!CheckInvocations(__LINE__, invocations, 1, expectedPosted)
+      || broker->GetNumberOfPostedEvents() != 0)
+    {
+    return EXIT_FAILURE;
+    }
+
+  broker->SetEventModeToSynchronous();
+  broker->SetDispatchRequestHandler(NULL, NULL);
+  broker->RemoveObservations(observer.GetPointer());
+  return EXIT_SUCCESS;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[] )
+{
+  if (TestDeferredMode() != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -18,5 +18,9 @@ int vtkMRMLDiffusionTensorVolumeSliceDisplayNodeTest1(int , char * [] )
   vtkNew<vtkMRMLDiffusionTensorVolumeSliceDisplayNode> node1;
   // EXERCISE_BASIC_DISPLAY_MRML_METHODS is failing due to set/get ScalarVisibility
   CHECK_EXIT_SUCCESS(vtkMRMLCoreTestingUtilities::ExerciseBasicMRMLMethods( node1.GetPointer() ));
+  // Tensor glyphs are rendered with instancing in 3D views by default
+  CHECK_INT(node1->GetGlyphInstancing(), 1);
+  node1->SetGlyphInstancing(0);
+  CHECK_NULL(node1->GetOutputGlyphSourceConnection());
   return EXIT_SUCCESS;
 }
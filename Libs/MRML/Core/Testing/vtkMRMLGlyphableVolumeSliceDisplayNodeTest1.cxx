@@ -17,5 +17,8 @@ int vtkMRMLGlyphableVolumeSliceDisplayNodeTest1(int , char * [] )
 {
   vtkNew<vtkMRMLGlyphableVolumeSliceDisplayNode> node1;
   EXERCISE_ALL_BASIC_MRML_METHODS(node1.GetPointer());
+  // Glyph instancing is only enabled by subclasses that can output instances
+  CHECK_INT(node1->GetGlyphInstancing(), 0);
+  CHECK_NULL(node1->GetOutputGlyphSourceConnection());
   return EXIT_SUCCESS;
 }
@@ -13,9 +13,35 @@
 #include "vtkMRMLCoreTestingMacros.h"
 #include "vtkMRMLGridTransformNode.h"
 
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkOrientedGridTransform.h>
+
 int vtkMRMLGridTransformNodeTest1(int , char * [] )
 {
   vtkNew<vtkMRMLGridTransformNode> node1;
   EXERCISE_ALL_BASIC_MRML_METHODS(node1.GetPointer());
+
+  // Displacement grid modified in place
+  vtkNew<vtkMRMLGridTransformNode> node2;
+  vtkOrientedGridTransform* gridTransform =
+    vtkOrientedGridTransform::SafeDownCast(node2->GetTransformFromParent());
+  CHECK_NOT_NULL(gridTransform);
+  vtkImageData* displacementGrid = gridTransform->GetDisplacementGrid();
+  CHECK_NOT_NULL(displacementGrid);
+  vtkNew<vtkMRMLCoreTestingUtilities::vtkMRMLNodeCallback> callback;
+  node2->AddObserver(vtkCommand::AnyEvent, callback.GetPointer());
+  vtkMTimeType transformMTime = gridTransform->GetMTime();
+  static_cast<double*>(displacementGrid->GetScalarPointer(0, 0, 0))[0] = 5.0;
+  int wasModifying = node2->StartModify();
+  CHECK_BOOL(node2->DisplacementGridModified(), true);
+  CHECK_BOOL(node2->DisplacementGridModified(), true);
+  CHECK_INT(callback->GetNumberOfEvents(vtkCommand::ModifiedEvent), 0);
+  CHECK_INT(callback->GetNumberOfEvents(vtkMRMLTransformableNode::TransformModifiedEvent), 0);
+  node2->EndModify(wasModifying);
+  CHECK_INT(callback->GetNumberOfEvents(vtkCommand::ModifiedEvent), 1);
+  CHECK_INT(callback->GetNumberOfEvents(vtkMRMLTransformableNode::TransformModifiedEvent), 1);
+  CHECK_BOOL(gridTransform->GetMTime() > transformMTime, true);
+
   return EXIT_SUCCESS;
 }
@@ -23,6 +23,7 @@
 #include "vtkMRMLTableNode.h"
 #include "vtkMRMLTableStorageNode.h"
 
+#include "vtkDoubleArray.h"
 #include "vtkStringArray.h"
 #include "vtkTable.h"
 #include "vtkTestErrorObserver.h"
@@ -171,6 +172,27 @@ int vtkMRMLTableNodeTest1(int , char * [] )
   CHECK_STD_STRING(node2->GetColumnProperty(0, "type"), "");
   TESTING_OUTPUT_ASSERT_ERRORS_END();
 
+  // Column values modified in place
+  vtkNew<vtkMRMLTableNode> node3;
+  vtkNew<vtkDoubleArray> values;
+  values->SetName("values");
+  values->SetNumberOfTuples(5);
+  values->FillComponent(0, 0.0);
+  CHECK_NOT_NULL(node3->AddColumn(values.GetPointer()));
+  vtkNew<vtkMRMLCoreTestingUtilities::vtkMRMLNodeCallback> callback;
+  node3->AddObserver(vtkCommand::AnyEvent, callback.GetPointer());
+  values->GetPointer(0)[3] = 7.0;
+  int wasModifying = node3->StartModify();
+  CHECK_BOOL(node3->ColumnModified("values"), true);
+  CHECK_BOOL(node3->ColumnModified("values"), true);
+  CHECK_INT(callback->GetNumberOfEvents(vtkCommand::ModifiedEvent), 0);
+  node3->EndModify(wasModifying);
+  CHECK_INT(callback->GetNumberOfEvents(vtkCommand::ModifiedEvent), 1);
+  CHECK_STD_STRING(node3->GetCellText(3, 0), "7");
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(node3->ColumnModified("nonexisting"), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
   std::cout << "vtkMRMLTableNodeTest1 completed successfully" << std::endl;
   return EXIT_SUCCESS;
 }
@@ -24,9 +24,13 @@
 #include "vtkMRMLTableNode.h"
 #include "vtkMRMLTableSQLiteStorageNode.h"
 
+#include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
+#include "vtkIntArray.h"
+#include "vtkStringArray.h"
 #include "vtkTable.h"
 #include "vtkTestErrorObserver.h"
+#include "vtkTypeInt64Array.h"
 
 // ITKSYS includes
 #include <itksys/SystemTools.hxx>
@@ -61,11 +65,23 @@ int vtkMRMLTableSQLiteStorageNodeTest(int , char * [] )
   arrX->SetName("X_Axis");
   table->AddColumn(arrX.GetPointer());
   vtkNew<vtkFloatArray> arrC;
-  arrC->SetName("Cosine");
+  // names that must be quoted in SQL statements
+  arrC->SetName("Cosine \"cos\"");
   table->AddColumn(arrC.GetPointer());
   vtkNew<vtkFloatArray> arrS;
   arrS->SetName("Sine");
   table->AddColumn(arrS.GetPointer());
+  vtkNew<vtkIntArray> arrIndex;
+  arrIndex->SetName("Index");
+  table->AddColumn(arrIndex.GetPointer());
+  vtkNew<vtkStringArray> arrLabel;
+  arrLabel->SetName("Label");
+  table->AddColumn(arrLabel.GetPointer());
+  vtkNew<vtkTypeInt64Array> arrLarge;
+  arrLarge->SetName("Large");
+  table->AddColumn(arrLarge.GetPointer());
+  // not representable as int nor as double
+  const vtkTypeInt64 largeValue = (static_cast<vtkTypeInt64>(1) << 60) + 1;
 
   // add few  points...
   int numPoints = 29;
@@ -76,12 +92,15 @@ int vtkMRMLTableSQLiteStorageNodeTest(int , char * [] )
     table->SetValue(i, 0, i * inc);
     table->SetValue(i, 1, cos(i * inc) + 0.0);
     table->SetValue(i, 2, sin(i * inc) + 0.0);
+    arrIndex->SetValue(i, i * 1000);
+    arrLabel->SetValue(i, i % 2 ? "it's odd" : "even");
+    arrLarge->SetValue(i, largeValue + i);
     }
 
   tableNode->SetAndObserveTable(table.GetPointer());
 
   storageNode->SetFileName("testSQLite.db");
-  storageNode->SetTableName("SinCos");
+  storageNode->SetTableName("Sin Cos");
   removeFile(storageNode->GetFileName());
 
   storageNode->WriteData(tableNode.GetPointer());
@@ -97,7 +116,7 @@ int vtkMRMLTableSQLiteStorageNodeTest(int , char * [] )
   // read table from the database
   storageNode->ReadData(tableNode.GetPointer());
 
-  if (tableNode->GetNumberOfColumns() != 3)
+  if (tableNode->GetNumberOfColumns() != 6)
     {
     std::cerr << "Unable to read table columns from the database " << storageNode->GetFileName() <<std::endl;
     removeFile(storageNode->GetFileName());
@@ -111,6 +130,34 @@ int vtkMRMLTableSQLiteStorageNodeTest(int , char * [] )
     return EXIT_FAILURE;
     }
 
+  // check that values are read back into typed columns
+  vtkTable* readTable = tableNode->GetTable();
+  vtkDoubleArray* readSine = vtkDoubleArray::SafeDownCast(readTable->GetColumnByName("Sine"));
+  vtkDoubleArray* readCosine = vtkDoubleArray::SafeDownCast(readTable->GetColumnByName("Cosine \"cos\""));
+  vtkTypeInt64Array* readIndex = vtkTypeInt64Array::SafeDownCast(readTable->GetColumnByName("Index"));
+  vtkStringArray* readLabel = vtkStringArray::SafeDownCast(readTable->GetColumnByName("Label"));
+  vtkTypeInt64Array* readLarge = vtkTypeInt64Array::SafeDownCast(readTable->GetColumnByName("Large"));
+  if (!readSine || !readCosine || !readIndex || !readLabel || !readLarge)
+    {
+    std::cerr << "Unexpected column types read from the database " << storageNode->GetFileName() <<std::endl;
+    removeFile(storageNode->GetFileName());
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < numPoints; ++i)
+    {
+    if (fabs(readSine->GetValue(i) - arrS->GetValue(i)) > 1e-6
+        || fabs(readCosine->GetValue(i) - arrC->GetValue(i)) > 1e-6
+        || readIndex->GetValue(i) != i * 1000
+        || readLabel->GetValue(i) != arrLabel->GetValue(i)
+        || readLarge->GetValue(i) != largeValue + i)
+      {
+      std::cerr << "Unexpected values in row " << i << " read from the database "
+                << storageNode->GetFileName() <<std::endl;
+      removeFile(storageNode->GetFileName());
+      return EXIT_FAILURE;
+      }
+    }
+
   // clean up
   removeFile(storageNode->GetFileName());
 
@@ -25,6 +25,7 @@
 #include "vtkMRMLTableNode.h"
 #include "vtkMRMLTableStorageNode.h"
 #include "vtkDoubleArray.h"
+#include "vtkIntArray.h"
 #include "vtkStringArray.h"
 #include "vtkTable.h"
 
@@ -33,6 +34,7 @@
 //---------------------------------------------------------------------------
 int TestReadWriteWithoutSchema(vtkMRMLScene* scene);
 int TestReadWriteWithSchema(vtkMRMLScene* scene);
+int TestReadWriteBinary(vtkMRMLScene* scene);
 int TestReadWriteData(vtkMRMLScene* scene, const char *extension, vtkTable* table, bool schemaExpected);
 
 int vtkMRMLTableStorageNodeTest1(int argc, char * argv[])
@@ -52,6 +54,7 @@ int vtkMRMLTableStorageNodeTest1(int argc, char * argv[])
 
   CHECK_EXIT_SUCCESS(TestReadWriteWithoutSchema(scene.GetPointer()));
   CHECK_EXIT_SUCCESS(TestReadWriteWithSchema(scene.GetPointer()));
+  CHECK_EXIT_SUCCESS(TestReadWriteBinary(scene.GetPointer()));
 
   std::cout << "Test passed." << std::endl;
   return EXIT_SUCCESS;
@@ -104,6 +107,100 @@ int TestReadWriteWithSchema(vtkMRMLScene* scene)
   return EXIT_SUCCESS;
 }
 
+//---------------------------------------------------------------------------
+int TestReadWriteBinary(vtkMRMLScene* scene)
+{
+  // Create a table with string, real and integer columns
+  vtkNew<vtkStringArray> col1;
+  col1->SetName("col1");
+  vtkNew<vtkDoubleArray> col2;
+  col2->SetName("col2");
+  vtkNew<vtkIntArray> col3;
+  col3->SetName("col3");
+  col3->SetNumberOfComponents(3);
+  const int numberOfRows = 1000;
+  for (int row = 0; row < numberOfRows; ++row)
+    {
+    col1->InsertNextValue(row % 3 ? "" : "value, with\ttab");
+    col2->InsertNextValue(row * 0.25);
+    col3->InsertNextTuple3(row, -row, row * 2);
+    }
+  vtkNew<vtkTable> table;
+  table->AddColumn(col1.GetPointer());
+  table->AddColumn(col2.GetPointer());
+  table->AddColumn(col3.GetPointer());
+
+  std::string fileName = std::string(scene->GetRootDirectory()) +
+    std::string("/vtkMRMLTableStorageNodeTest1.stbl");
+  vtksys::SystemTools::RemoveFile(fileName);
+
+  vtkNew<vtkMRMLTableNode> tableNode;
+  tableNode->SetAndObserveTable(table.GetPointer());
+  CHECK_NOT_NULL(scene->AddNode(tableNode.GetPointer()));
+  tableNode->AddDefaultStorageNode();
+  vtkMRMLStorageNode* storageNode = tableNode->GetStorageNode();
+  CHECK_NOT_NULL(storageNode);
+  // .ctbl is the color table extension, it is not read as a table
+  CHECK_BOOL(storageNode->SupportedFileType("colors.ctbl") != 0, false);
+  CHECK_BOOL(storageNode->SupportedFileType(fileName.c_str()) != 0, true);
+  storageNode->SetFileName(fileName.c_str());
+  CHECK_BOOL(storageNode->WriteData(tableNode.GetPointer()) != 0, true);
+
+  // Schema is embedded, no separate file
+  CHECK_BOOL(vtksys::SystemTools::FileExists(std::string(scene->GetRootDirectory()) +
+    std::string("/vtkMRMLTableStorageNodeTest1.schema.stbl")), false);
+  CHECK_INT(storageNode->GetNumberOfFileNames(), 0);
+
+  tableNode->SetAndObserveTable(NULL);
+  CHECK_BOOL(storageNode->ReadData(tableNode.GetPointer()) != 0, true);
+  vtkTable* table2 = tableNode->GetTable();
+  CHECK_INT(table2->GetNumberOfRows(), numberOfRows);
+  vtkStringArray* readCol1 = vtkStringArray::SafeDownCast(table2->GetColumnByName("col1"));
+  vtkDoubleArray* readCol2 = vtkDoubleArray::SafeDownCast(table2->GetColumnByName("col2"));
+  vtkIntArray* readCol3 = vtkIntArray::SafeDownCast(table2->GetColumnByName("col3"));
+  CHECK_NOT_NULL(readCol1);
+  CHECK_NOT_NULL(readCol2);
+  CHECK_NOT_NULL(readCol3);
+  CHECK_INT(readCol3->GetNumberOfComponents(), 3);
+  for (int row = 0; row < numberOfRows; ++row)
+    {
+    CHECK_STD_STRING(readCol1->GetValue(row), col1->GetValue(row));
+    CHECK_DOUBLE(readCol2->GetValue(row), col2->GetValue(row));
+    CHECK_INT(readCol3->GetComponent(row, 1), -row);
+    }
+  CHECK_STD_STRING(tableNode->GetColumnProperty("col2", "type"), "double");
+
+  // Another node maps the same file
+  vtkNew<vtkMRMLTableNode> otherTableNode;
+  CHECK_NOT_NULL(scene->AddNode(otherTableNode.GetPointer()));
+  otherTableNode->AddDefaultStorageNode();
+  otherTableNode->GetStorageNode()->SetFileName(fileName.c_str());
+  CHECK_BOOL(otherTableNode->GetStorageNode()->ReadData(otherTableNode.GetPointer()) != 0, true);
+  vtkIntArray* otherCol3 = vtkIntArray::SafeDownCast(otherTableNode->GetTable()->GetColumnByName("col3"));
+  CHECK_NOT_NULL(otherCol3);
+
+  // Load, edit and save the same file: the file can be replaced while its
+  // columns are still mapped (and modified in memory). The columns of both
+  // nodes are copied to memory and keep their values.
+  readCol2->SetValue(0, 12.5);
+  CHECK_BOOL(storageNode->WriteData(tableNode.GetPointer()) != 0, true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(fileName + ".part"), false);
+  CHECK_DOUBLE(readCol2->GetValue(0), 12.5);
+  CHECK_DOUBLE(readCol2->GetValue(numberOfRows - 1), (numberOfRows - 1) * 0.25);
+  CHECK_INT(otherCol3->GetNumberOfTuples(), numberOfRows);
+  CHECK_INT(otherCol3->GetComponent(numberOfRows - 1, 2), (numberOfRows - 1) * 2);
+  readCol2->SetValue(1, 13.5);
+  CHECK_BOOL(storageNode->WriteData(tableNode.GetPointer()) != 0, true);
+  CHECK_BOOL(storageNode->ReadData(tableNode.GetPointer()) != 0, true);
+  readCol2 = vtkDoubleArray::SafeDownCast(tableNode->GetTable()->GetColumnByName("col2"));
+  CHECK_NOT_NULL(readCol2);
+  CHECK_DOUBLE(readCol2->GetValue(0), 12.5);
+  CHECK_DOUBLE(readCol2->GetValue(1), 13.5);
+  CHECK_DOUBLE(readCol2->GetValue(numberOfRows - 1), (numberOfRows - 1) * 0.25);
+
+  return EXIT_SUCCESS;
+}
+
 //---------------------------------------------------------------------------
 int TestReadWriteData(vtkMRMLScene* scene, const char *extension, vtkTable* table, bool schemaExpected)
 {
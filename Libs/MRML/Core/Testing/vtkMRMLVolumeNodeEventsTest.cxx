@@ -23,9 +23,11 @@
 #include "vtkMRMLVolumeNode.h"
 
 // VTK includes
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
 
 //---------------------------------------------------------------------------
 class vtkMRMLTestVolumeNode
@@ -193,5 +195,139 @@ int vtkMRMLVolumeNodeEventsTest(int , char * [] )
     }
   callback->ResetNumberOfEvents();
 
+  // Reshape creates the image data
+  int dimensions[3] = {4, 5, 6};
+  bool bufferReused = true;
+  bool reshaped = volumeNode->ReshapeImageData(dimensions, VTK_SHORT, 1, &bufferReused);
+  vtkImageData* reshapedImageData = volumeNode->GetImageData();
+  if (!reshaped || bufferReused ||
+      !reshapedImageData ||
+      reshapedImageData->GetPointData()->GetScalars()->GetDataType() != VTK_SHORT ||
+      reshapedImageData->GetNumberOfPoints() != 4*5*6 ||
+      !callback->GetErrorString().empty() ||
+      callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) != 1 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) != 1)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::ReshapeImageData failed: "
+              << callback->GetErrorString().c_str() << " "
+              << "Number of ModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) << " "
+              << "Number of ImageDataModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent)
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  callback->ResetNumberOfEvents();
+
+  // Reshape to the same number of values reuses the buffer
+  void* buffer = reshapedImageData->GetScalarPointer();
+  int reshapedDimensions[3] = {6, 5, 4};
+  if (!volumeNode->ReshapeImageData(reshapedDimensions, VTK_SHORT, 1, &bufferReused) ||
+      !bufferReused ||
+      volumeNode->GetImageData() != reshapedImageData ||
+      reshapedImageData->GetScalarPointer() != buffer)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::ReshapeImageData did not reuse the buffer" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Retype keeps the image data
+  if (!volumeNode->ReshapeImageData(reshapedDimensions, VTK_FLOAT, 3, &bufferReused) ||
+      bufferReused ||
+      volumeNode->GetImageData() != reshapedImageData ||
+      reshapedImageData->GetScalarType() != VTK_FLOAT ||
+      reshapedImageData->GetNumberOfScalarComponents() != 3 ||
+      reshapedImageData->GetPointData()->GetScalars()->GetNumberOfTuples() != 6*5*4)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::ReshapeImageData failed to change the scalar type" << std::endl;
+    return EXIT_FAILURE;
+    }
+  callback->ResetNumberOfEvents();
+
+  // Invalid number of components is reported and leaves the image data unchanged
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  bool reshapedWithoutComponents = volumeNode->ReshapeImageData(reshapedDimensions, VTK_FLOAT, 0, &bufferReused);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  if (reshapedWithoutComponents || bufferReused ||
+      reshapedImageData->GetNumberOfScalarComponents() != 3 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) != 0)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::ReshapeImageData did not fail with invalid number of components" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Modifications within a modify scope invoke events only once
+  int wasModifying = volumeNode->StartModify();
+  volumeNode->ImageDataModified();
+  volumeNode->ImageDataModified();
+  volumeNode->ReshapeImageData(reshapedDimensions, VTK_FLOAT, 3);
+  if (callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) != 0 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) != 0)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::ImageDataModified invoked events within a modify scope" << std::endl;
+    return EXIT_FAILURE;
+    }
+  volumeNode->EndModify(wasModifying);
+  if (!callback->GetErrorString().empty() ||
+      callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) != 1 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) != 1)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::ImageDataModified failed: "
+              << callback->GetErrorString().c_str() << " "
+              << "Number of ModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) << " "
+              << "Number of ImageDataModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent)
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  callback->ResetNumberOfEvents();
+
+  // Other image data changes are notified immediately within a modify scope
+  wasModifying = volumeNode->StartModify();
+  reshapedImageData->Modified();
+  if (!callback->GetErrorString().empty() ||
+      callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) != 0 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) != 1)
+    {
+    std::cerr << __LINE__ << ": vtkImageData::Modified within a modify scope failed: "
+              << callback->GetErrorString().c_str() << " "
+              << "Number of ModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) << " "
+              << "Number of ImageDataModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent)
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+  if (!callback->GetErrorString().empty() ||
+      callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) != 0 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) != 2)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::SetAndObserveImageData within a modify scope failed: "
+              << callback->GetErrorString().c_str() << " "
+              << "Number of ModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) << " "
+              << "Number of ImageDataModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent)
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  volumeNode->EndModify(wasModifying);
+  if (!callback->GetErrorString().empty() ||
+      callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) != 1 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) != 2)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::EndModify failed: "
+              << callback->GetErrorString().c_str() << " "
+              << "Number of ModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) << " "
+              << "Number of ImageDataModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent)
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  callback->ResetNumberOfEvents();
+
   return EXIT_SUCCESS;
 }
@@ -307,7 +307,7 @@ int vtkCacheManager::GetCachedFileList ( const char *dirname )
               return (0);
               }
             }
-          else
+          else if ( !vtkCacheManager::IsPartialDownloadFile ( fullName ) )
             {
             this->CachedFileList.push_back ( dir.GetFile(static_cast<unsigned long>(fileNum) ));
             }
@@ -597,7 +597,48 @@ void vtkCacheManager::DeleteFromCache( const char *target )
         }
       }
     this->DeleteFromCachedFileList ( str.c_str() );
+    this->RemovePartialDownload ( str.c_str() );
+    }
+}
+
+//----------------------------------------------------------------------------
+const char* vtkCacheManager::GetPartialDownloadSuffix()
+{
+  return ".part";
+}
+
+//----------------------------------------------------------------------------
+const char* vtkCacheManager::GetPartialDownloadRangesSuffix()
+{
+  return ".part.ranges";
+}
+
+//----------------------------------------------------------------------------
+bool vtkCacheManager::IsPartialDownloadFile(const std::string& filename)
+{
+  return vtksys::SystemTools::StringEndsWith(filename, vtkCacheManager::GetPartialDownloadSuffix())
+    || vtksys::SystemTools::StringEndsWith(filename, vtkCacheManager::GetPartialDownloadRangesSuffix());
+}
+
+//----------------------------------------------------------------------------
+bool vtkCacheManager::RemovePartialDownload(const char* destination)
+{
+  if (destination == NULL)
+    {
+    return false;
+    }
+  bool removed = false;
+  std::string partialFile = std::string(destination) + vtkCacheManager::GetPartialDownloadSuffix();
+  if (vtksys::SystemTools::FileExists(partialFile.c_str(), true))
+    {
+    removed = vtksys::SystemTools::RemoveFile(partialFile.c_str()) || removed;
+    }
+  std::string rangesFile = std::string(destination) + vtkCacheManager::GetPartialDownloadRangesSuffix();
+  if (vtksys::SystemTools::FileExists(rangesFile.c_str(), true))
+    {
+    removed = vtksys::SystemTools::RemoveFile(rangesFile.c_str()) || removed;
     }
+  return removed;
 }
 
 
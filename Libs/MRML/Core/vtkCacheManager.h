@@ -116,6 +116,21 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
 
   std::vector< std::string > GetCachedFiles()const;
 
+  ///
+  /// Suffix appended to a cache file name while its download is in progress.
+  /// Interrupted downloads leave the partial file (and, for ranged downloads,
+  /// a ".ranges" sidecar) next to the final destination so that the transfer
+  /// can resume instead of restarting. Partial files are not reported as
+  /// cached files.
+  static const char* GetPartialDownloadSuffix();
+  static const char* GetPartialDownloadRangesSuffix();
+  static bool IsPartialDownloadFile(const std::string& filename);
+
+  ///
+  /// Removes the partial download files left for the specified
+  /// destination, if any. Returns true if something was removed.
+  bool RemovePartialDownload(const char* destination);
+
   ///
   vtkGetMacro ( RemoteCacheLimit, int );
   vtkSetMacro ( RemoteCacheLimit, int );
@@ -22,8 +22,29 @@
 #include <vtkObjectFactory.h>
 #include <vtkTimerLog.h>
 
+// VTKsys includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+
 vtkCxxSetObjectMacro(vtkEventBroker, TimerLog, vtkTimerLog);
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Size of the ring buffer of posted events
+const int MaximumNumberOfPostedEvents = 4096;
+
+//----------------------------------------------------------------------------
+bool ObservationHasHigherPriority(vtkObservation* observation1, vtkObservation* observation2)
+{
+  return observation1->GetPriority() > observation2->GetPriority();
+}
+
+}
+
 //----------------------------------------------------------------------------
 // The IO manager singleton.
 // This MUST be default initialized to zero by the compiler and is
@@ -99,6 +120,20 @@ vtkEventBroker::vtkEventBroker()
   this->LogFileName = NULL;
   this->ScriptHandler = NULL;
   this->ScriptHandlerClientData = NULL;
+  this->DispatchRequestHandler = NULL;
+  this->DispatchRequestHandlerClientData = NULL;
+  this->DispatchRequested = 0;
+
+  this->PostedEvents = new PostedEvent[MaximumNumberOfPostedEvents];
+  for (int i = 0; i < MaximumNumberOfPostedEvents; i++)
+    {
+    this->PostedEvents[i].Sequence = i;
+    this->PostedEvents[i].Subject = NULL;
+    this->PostedEvents[i].Event = 0;
+    }
+  this->PostedEventsWriteTicket = 0;
+  this->PostedEventsReadTicket = 0;
+  this->MainThreadID = vtkMultiThreader::GetCurrentThreadID();
 }
 
 //----------------------------------------------------------------------------
@@ -118,6 +153,16 @@ vtkEventBroker::~vtkEventBroker()
     {
     this->TimerLog->Delete();
     }
+
+  // release the subjects of the events that have not been processed
+  for (int i = 0; i < MaximumNumberOfPostedEvents; i++)
+    {
+    if (this->PostedEvents[i].Subject)
+      {
+      this->PostedEvents[i].Subject->UnRegister(NULL);
+      }
+    }
+  delete [] this->PostedEvents;
   //cout << "vtkEventBroker singleton Deleted" << endl;
 }
 
@@ -686,7 +731,8 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
       {
       this->InvokeObservation( observation, eid, callData );
       }
-    else if ( this->EventMode == vtkEventBroker::Asynchronous )
+    else if ( this->EventMode == vtkEventBroker::Asynchronous
+              || this->EventMode == vtkEventBroker::Deferred )
       {
       this->QueueObservation( observation, eid, callData );
       }
@@ -779,6 +825,10 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
     {
     this->EventQueue.push_back( observation );
     observation->SetInEventQueue(1);
+    if ( this->EventMode == vtkEventBroker::Deferred )
+      {
+      this->RequestDispatch();
+      }
     }
 }
 
@@ -852,6 +902,17 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
 //----------------------------------------------------------------------------
 void vtkEventBroker::ProcessEventQueue ()
 {
+  // requests made from now on need another dispatch
+  this->DispatchRequested = 0;
+
+  this->ProcessPostedEvents();
+
+  if ( this->EventMode == vtkEventBroker::Deferred )
+    {
+    this->ProcessDeferredEventQueue();
+    return;
+    }
+
   //
   // for each observation on the event queue,
   // invoke it with each of the stored callData pointers
@@ -883,6 +944,151 @@ void vtkEventBroker::ProcessEventQueue ()
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkEventBroker::ProcessDeferredEventQueue ()
+{
+  //
+  // invoke the observations queued so far in decreasing order of priority
+  // - observations queued while invoking them (including the ones being
+  //   invoked) are kept in the event queue for the next dispatch, this way
+  //   cascading events are delivered once per frame
+  // - observations are registered so that they can be tested after being
+  //   removed (and detached) by a callback
+  //
+  std::deque< vtkObservation * > frameQueue;
+  frameQueue.swap( this->EventQueue );
+  std::stable_sort( frameQueue.begin(), frameQueue.end(), ObservationHasHigherPriority );
+
+  std::deque< vtkObservation * >::iterator obsIter;
+  for ( obsIter = frameQueue.begin(); obsIter != frameQueue.end(); ++obsIter )
+    {
+    (*obsIter)->Register( this );
+    }
+  for ( obsIter = frameQueue.begin(); obsIter != frameQueue.end(); ++obsIter )
+    {
+    vtkObservation *observation = (*obsIter);
+    if ( !observation->GetInEventQueue() )
+      {
+      // removed by a previous callback
+      continue;
+      }
+    std::deque< vtkObservation::CallType > calls;
+    calls.swap( *observation->GetCallDataList() );
+    observation->SetInEventQueue(0);
+    std::deque< vtkObservation::CallType >::const_iterator callIter;
+    for ( callIter = calls.begin(); callIter != calls.end(); ++callIter )
+      {
+      if ( observation->GetEventTag() == 0 )
+        {
+        // removed by its own callback
+        break;
+        }
+      this->InvokeObservation( observation, callIter->EventID, callIter->CallData );
+      }
+    }
+  for ( obsIter = frameQueue.begin(); obsIter != frameQueue.end(); ++obsIter )
+    {
+    (*obsIter)->UnRegister( this );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::PostEvent ( vtkObject *subject, unsigned long event )
+{
+  if ( subject == NULL )
+    {
+    return;
+    }
+  if ( vtkMultiThreader::ThreadsEqual( this->MainThreadID, vtkMultiThreader::GetCurrentThreadID() ) )
+    {
+    subject->InvokeEvent( event );
+    return;
+    }
+
+  // the subject is unregistered by the main thread after the event is invoked
+  subject->Register( NULL );
+
+  // take a ticket and wait for its slot to be free (only if the ring buffer is full)
+  vtkTypeInt64 ticket = this->PostedEventsWriteTicket++;
+  PostedEvent& slot = this->PostedEvents[ticket % MaximumNumberOfPostedEvents];
+  while ( slot.Sequence.load() != ticket )
+    {
+    this->RequestDispatch();
+    vtksys::SystemTools::Delay(1);
+    }
+  slot.Subject = subject;
+  slot.Event = event;
+  // publish the slot to the main thread
+  slot.Sequence.store( ticket + 1 );
+
+  this->RequestDispatch();
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::GetNumberOfPostedEvents ()
+{
+  return static_cast<int>( this->PostedEventsWriteTicket.load() - this->PostedEventsReadTicket );
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::GetMaximumNumberOfPostedEvents ()
+{
+  return MaximumNumberOfPostedEvents;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ProcessPostedEvents ()
+{
+  //
+  // take the events published so far out of the ring buffer
+  // - stop at the first slot that is not published yet (it will be
+  //   processed at the next dispatch)
+  // - keep only the first of the events posted on the same subject
+  //
+  typedef std::pair< vtkObject *, unsigned long > SubjectEventType;
+  std::vector< SubjectEventType > events;
+  std::set< SubjectEventType > uniqueEvents;
+  while ( true )
+    {
+    vtkTypeInt64 ticket = this->PostedEventsReadTicket;
+    PostedEvent& slot = this->PostedEvents[ticket % MaximumNumberOfPostedEvents];
+    if ( slot.Sequence.load() != ticket + 1 )
+      {
+      break;
+      }
+    SubjectEventType subjectEvent( slot.Subject, slot.Event );
+    slot.Subject = NULL;
+    // free the slot for the producer that will take the ticket of the next round
+    slot.Sequence.store( ticket + MaximumNumberOfPostedEvents );
+    this->PostedEventsReadTicket++;
+
+    if ( uniqueEvents.insert( subjectEvent ).second )
+      {
+      events.push_back( subjectEvent );
+      }
+    else
+      {
+      subjectEvent.first->UnRegister( NULL );
+      }
+    }
+
+  std::vector< SubjectEventType >::iterator eventIter;
+  for ( eventIter = events.begin(); eventIter != events.end(); ++eventIter )
+    {
+    eventIter->first->InvokeEvent( eventIter->second );
+    eventIter->first->UnRegister( NULL );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::RequestDispatch ()
+{
+  if ( this->DispatchRequestHandler && ++this->DispatchRequested == 1 )
+    {
+    (*(this->DispatchRequestHandler)) ( this->DispatchRequestHandlerClientData );
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -890,6 +1096,7 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "NumberOfObservations: " << this->GetNumberOfObservations() << "\n";
   os << indent << "NumberOfQueueObservations: " << this->GetNumberOfQueuedObservations() << "\n";
+  os << indent << "NumberOfPostedEvents: " << this->GetNumberOfPostedEvents() << "\n";
   os << indent << "EventMode: " << this->GetEventModeAsString() << "\n";
   os << indent << "EventLogging: " << this->EventLogging << "\n";
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
@@ -19,6 +19,8 @@
 #include "vtkMRML.h"
 
 // VTK includes
+#include <vtkAtomic.h>
+#include <vtkMultiThreader.h>
 #include <vtkObject.h>
 class vtkTimerLog;
 
@@ -179,9 +181,15 @@ public:
   /// In synchronous mode, observations are invoked immediately when the
   /// event takes place.  In asynchronous mode, observations are added
   /// to the event queue for later invocation.
+  /// Deferred mode is an asynchronous mode meant to deliver events once per
+  /// GUI frame: a dispatch is requested (see SetDispatchRequestHandler) when
+  /// the first observation is queued, repeated events of an observation are
+  /// coalesced, queued observations are invoked in decreasing order of
+  /// priority and events they trigger are queued for the next dispatch.
   enum EventMode {
     Synchronous,
-    Asynchronous
+    Asynchronous,
+    Deferred
   };
   vtkGetMacro(EventMode, int);
   void SetEventMode(int eventMode)
@@ -196,9 +204,11 @@ public:
 
   void SetEventModeToSynchronous() {this->SetEventMode(vtkEventBroker::Synchronous);};
   void SetEventModeToAsynchronous() {this->SetEventMode(vtkEventBroker::Asynchronous);};
+  void SetEventModeToDeferred() {this->SetEventMode(vtkEventBroker::Deferred);};
   const char * GetEventModeAsString() {
     if (this->EventMode == vtkEventBroker::Synchronous) return ("Synchronous");
     if (this->EventMode == vtkEventBroker::Asynchronous) return ("Asynchronous");
+    if (this->EventMode == vtkEventBroker::Deferred) return ("Deferred");
     return "Undefined";
   }
 
@@ -220,8 +230,38 @@ public:
   vtkObservation *DequeueObservation ();
   void InvokeObservation (vtkObservation *observation, unsigned long eid,
                           void *callData);
+  /// Invoke the posted events and the queued observations.
+  /// Must be called from the main thread.
   void ProcessEventQueue ();
 
+  /// Thread-safe event posting
+  ///
+  /// Request that \a event is invoked on \a subject (without call data) from
+  /// the main thread, at the next ProcessEventQueue. It can be called from any
+  /// thread, e.g. by background IO or processing to notify the scene.
+  /// Posting is lock-free: the subject is registered and stored in a ring
+  /// buffer (a worker thread only waits if MaximumNumberOfPostedEvents
+  /// events are pending). Events posted multiple times on the same subject
+  /// before they are processed are invoked once.
+  /// When called from the main thread, the event is invoked immediately.
+  void PostEvent (vtkObject *subject, unsigned long event);
+  int GetNumberOfPostedEvents ();
+  /// Number of events that can be posted before ProcessEventQueue is called.
+  static int GetMaximumNumberOfPostedEvents();
+
+  ///
+  /// Sets the method to be called when the event queue needs to be processed
+  /// (when an observation is queued in Deferred mode or an event is posted).
+  /// The handler may be called from any thread and must call
+  /// ProcessEventQueue asynchronously from the main thread (e.g. at the next
+  /// iteration of the GUI event loop). Requests are coalesced until
+  /// ProcessEventQueue is called.
+  void SetDispatchRequestHandler ( void (*dispatchRequestHandler) (void *clientData), void *clientData )
+    {
+    this->DispatchRequestHandler = dispatchRequestHandler;
+    this->DispatchRequestHandlerClientData = clientData;
+    }
+
   ///
   /// two modes -
   ///  - CompressCallDataOn: only keep the most recent call data.  this means that if the
@@ -261,6 +301,16 @@ protected:
   void AttachObservation (vtkObservation *observation);
   void DetachObservation (vtkObservation *observation);
 
+  ///
+  /// Invoke the events posted by PostEvent
+  void ProcessPostedEvents ();
+  ///
+  /// Invoke the observations queued in Deferred mode
+  void ProcessDeferredEventQueue ();
+  ///
+  /// Call the dispatch request handler unless a request is already pending
+  void RequestDispatch ();
+
   friend class vtkEventBrokerInitialize;
   typedef vtkEventBroker Self;
 
@@ -286,6 +336,25 @@ protected:
   int EventMode;
   int CompressCallData;
 
+  void (*DispatchRequestHandler) (void* clientData);
+  void *DispatchRequestHandlerClientData;
+  vtkAtomic<int> DispatchRequested;
+
+  /// Ring buffer of posted events. Each slot has a sequence number that tells
+  /// whether it is free for the producer that took the ticket of the slot
+  /// (Sequence == ticket) or filled for the consumer (Sequence == ticket + 1).
+  struct PostedEvent
+    {
+    vtkAtomic<vtkTypeInt64> Sequence;
+    vtkObject *Subject;
+    unsigned long Event;
+    };
+  PostedEvent *PostedEvents;
+  /// Thread that created the broker, the only one allowed to process events
+  vtkMultiThreaderIDType MainThreadID;
+  vtkAtomic<vtkTypeInt64> PostedEventsWriteTicket;
+  vtkTypeInt64 PostedEventsReadTicket;
+
   std::ofstream LogFile;
 private:
   /// DetachObservations is a fast (but dangerous) method to delete all the
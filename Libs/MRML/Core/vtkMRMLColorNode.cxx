@@ -42,6 +42,7 @@ vtkMRMLColorNode::vtkMRMLColorNode()
   this->SetNoName("(none)");
 
   this->NamesInitialised = 0;
+  this->Placeholder = false;
 }
 
 //----------------------------------------------------------------------------
@@ -138,20 +139,35 @@ void vtkMRMLColorNode::Copy(vtkMRMLNode *anode)
   Superclass::Copy(anode);
   vtkMRMLColorNode *node = (vtkMRMLColorNode *) anode;
 
-  if (node->Type != -1)
+  if (node->Placeholder)
     {
-    // not using SetType, as that will basically recreate a new color node,
-    // very slow
-    this->Type = node->Type;
+    // Default color nodes are copied into the scene singletons when they are
+    // added again. Keep the colours if they are already built for the same
+    // type, otherwise build them on first access.
+    if (this->Placeholder || this->Type != node->Type)
+      {
+      this->SetTypeAsPlaceholder(node->Type);
+      this->Names.clear();
+      this->NamesInitialised = 0;
+      }
+    }
+  else
+    {
+    this->Placeholder = false;
+    if (node->Type != -1)
+      {
+      // not using SetType, as that will basically recreate a new color node,
+      // very slow
+      this->Type = node->Type;
+      }
+    // copy names
+    this->Names = node->Names;
+
+    this->NamesInitialised = node->NamesInitialised;
     }
   this->SetFileName(node->FileName);
   this->SetNoName(node->NoName);
 
-  // copy names
-  this->Names = node->Names;
-
-  this->NamesInitialised = node->NamesInitialised;
-
   this->EndModify(disabledModify);
 
 }
@@ -173,6 +189,8 @@ void vtkMRMLColorNode::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "Names array initialised: " << (this->GetNamesInitialised() ? "true" : "false") << "\n";
 
+  os << indent << "Placeholder: " << (this->Placeholder ? "true" : "false") << "\n";
+
   if (this->Names.size() > 0)
     {
     os << indent << "Color Names:\n";
@@ -267,9 +285,57 @@ void vtkMRMLColorNode::SetType(int type)
   this->InvokeEvent(vtkMRMLColorNode::TypeModifiedEvent);
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLColorNode::SetTypeAsPlaceholder(int type)
+{
+  this->Type = type;
+  this->Placeholder = true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLColorNode::IsPlaceholder()const
+{
+  return this->Placeholder;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLColorNode::MaterializePlaceholder()
+{
+  if (!this->Placeholder)
+    {
+    return true;
+    }
+  // reset the flag first, building the colours accesses them
+  this->Placeholder = false;
+
+  int disabledModify = this->GetDisableModifiedEvent();
+  this->DisableModifiedEventOn();
+  bool success = true;
+  if (this->Type == vtkMRMLColorNode::File)
+    {
+    vtkMRMLStorageNode* storageNode = this->GetStorageNode();
+    success = (storageNode != NULL && storageNode->ReadData(this) != 0);
+    if (!success)
+      {
+      vtkErrorMacro("MaterializePlaceholder: unable to read colors of " << (this->GetName() ? this->GetName() : "(null)")
+                    << " from " << (storageNode && storageNode->GetFileName() ? storageNode->GetFileName() : "(no file)"));
+      }
+    }
+  else
+    {
+    int type = this->Type;
+    // SetType() does nothing if the type doesn't change
+    this->Type = -1;
+    this->SetType(type);
+    }
+  this->SetDisableModifiedEvent(disabledModify);
+  return success;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLColorNode::SetNamesFromColors()
 {
+  this->MaterializePlaceholder();
   const int numPoints = this->GetNumberOfColors();
   // reset the names
   this->Names.resize(numPoints);
@@ -349,6 +415,7 @@ bool vtkMRMLColorNode::HasNameFromColor(int index)
 //---------------------------------------------------------------------------
 const char *vtkMRMLColorNode::GetColorName(int ind)
 {
+  this->MaterializePlaceholder();
   if (!this->GetNamesInitialised())
     {
     this->SetNamesFromColors();
@@ -381,6 +448,7 @@ int vtkMRMLColorNode::GetColorIndexByName(const char *name)
     return -1;
     }
 
+  this->MaterializePlaceholder();
   if (!this->GetNamesInitialised())
     {
     this->SetNamesFromColors();
@@ -440,6 +508,7 @@ std::string vtkMRMLColorNode::GetColorNameAsFileName(int colorIndex, const char
 //---------------------------------------------------------------------------
 int vtkMRMLColorNode::SetColorName(int ind, const char *name)
 {
+  this->MaterializePlaceholder();
   if (ind >= static_cast<int>(this->Names.size()) || ind < 0)
     {
     vtkErrorMacro("ERROR: SetColorName, index was out of bounds: "<< ind << ", current size is " << this->Names.size() << ", table name = " << (this->GetName() == NULL ? "null" : this->GetName()));
@@ -477,6 +546,7 @@ int vtkMRMLColorNode::SetColorNameWithSpaces(int ind, const char *name, const ch
 //---------------------------------------------------------------------------
 int vtkMRMLColorNode::GetNumberOfColors()
 {
+  this->MaterializePlaceholder();
   return static_cast<int>(this->Names.size());
 }
 
@@ -497,6 +567,11 @@ void vtkMRMLColorNode::Reset(vtkMRMLNode* vtkNotUsed(defaultNode))
 //---------------------------------------------------------------------------
 bool vtkMRMLColorNode::GetModifiedSinceRead()
 {
+  if (this->Placeholder)
+    {
+    // colours have not even been read
+    return false;
+    }
   return this->Superclass::GetModifiedSinceRead() ||
     (this->GetScalarsToColors() &&
      this->GetScalarsToColors()->GetMTime() > this->GetStoredTime());
@@ -94,6 +94,22 @@ public:
   void SetTypeToUser();
   void SetTypeToFile();
 
+  ///
+  /// Set Type to type without building the colours and names. The node is a
+  /// placeholder: the colours are built (or read from the storage node for
+  /// the File type) the first time they are accessed.
+  /// Used by vtkMRMLColorLogic to add the default color nodes cheaply.
+  /// \sa IsPlaceholder(), MaterializePlaceholder()
+  void SetTypeAsPlaceholder(int type);
+  ///
+  /// Return true if the colours have not been built yet
+  bool IsPlaceholder()const;
+  ///
+  /// Build the colours of a placeholder node. No modified event is invoked as
+  /// the node content does not change for the observers.
+  /// Return false if the colours could not be read from the storage node.
+  bool MaterializePlaceholder();
+
   void ProcessMRMLEvents ( vtkObject *caller, unsigned long event, void *callData );
 
   /// Return the lowest and highest integers, for use in looping.
@@ -235,6 +251,11 @@ protected:
   ///
   /// Have the colour names been set? Used to do lazy copy of the Names array.
   int NamesInitialised;
+
+  ///
+  /// Colours have not been built yet
+  /// \sa SetTypeAsPlaceholder()
+  bool Placeholder;
 };
 
 #endif
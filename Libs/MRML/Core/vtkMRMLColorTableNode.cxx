@@ -184,6 +184,13 @@ void vtkMRMLColorTableNode::Copy(vtkMRMLNode *anode)
 
 }
 
+//----------------------------------------------------------------------------
+vtkLookupTable* vtkMRMLColorTableNode::GetLookupTable()
+{
+  this->MaterializePlaceholder();
+  return this->LookupTable;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLColorTableNode::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -52,7 +52,10 @@ public:
   /// Get node XML tag name (like Volume, Model)
   virtual const char* GetNodeTagName() {return "ColorTable";};
 
-  vtkGetObjectMacro(LookupTable, vtkLookupTable);
+  ///
+  /// Get the lookup table, build it first if the node is a placeholder.
+  /// \sa vtkMRMLColorNode::SetTypeAsPlaceholder()
+  virtual vtkLookupTable* GetLookupTable();
   virtual void SetLookupTable(vtkLookupTable* newLookupTable);
 
   ///
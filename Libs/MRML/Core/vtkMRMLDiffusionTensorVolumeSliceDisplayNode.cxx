@@ -45,6 +45,15 @@ vtkMRMLDiffusionTensorVolumeSliceDisplayNode::vtkMRMLDiffusionTensorVolumeSliceD
   this->DiffusionTensorGlyphFilter->SetInputConnection(this->SliceImagePort);
   this->DiffusionTensorGlyphFilter->SetResolution (1);
 
+  this->DiffusionTensorGlyphInstancesFilter = vtkDiffusionTensorGlyph::New();
+  this->DiffusionTensorGlyphInstancesFilter->SetInputConnection(this->SliceImagePort);
+  this->DiffusionTensorGlyphInstancesFilter->SetResolution (1);
+  this->DiffusionTensorGlyphInstancesFilter->OutputGlyphInstancesOn();
+
+  // tensor glyphs can be output as instances, use them in 3D views
+  this->GlyphInstancing = 1;
+  this->MinimumGlyphSpacing = 3;
+
   this->ColorMode = this->colorModeScalar;
 
   this->UpdateAssignedAttribute();
@@ -57,6 +66,7 @@ vtkMRMLDiffusionTensorVolumeSliceDisplayNode::~vtkMRMLDiffusionTensorVolumeSlice
   this->RemoveObservers ( vtkCommand::ModifiedEvent, this->MRMLCallbackCommand );
   this->SetAndObserveDiffusionTensorDisplayPropertiesNodeID(NULL);
   this->DiffusionTensorGlyphFilter->Delete();
+  this->DiffusionTensorGlyphInstancesFilter->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -70,6 +80,7 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::WriteXML(ostream& of, int nIn
     {
     of << " DiffusionTensorDisplayPropertiesNodeRef=\"" << this->DiffusionTensorDisplayPropertiesNodeID << "\"";
     }
+  of << " minimumGlyphSpacing=\"" << this->MinimumGlyphSpacing << "\"";
 }
 
 
@@ -90,6 +101,10 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::ReadXMLAttributes(const char*
       {
       this->SetAndObserveDiffusionTensorDisplayPropertiesNodeID(attValue);
       }
+    else if (!strcmp(attName, "minimumGlyphSpacing"))
+      {
+      this->SetMinimumGlyphSpacing(atoi(attValue));
+      }
     }
 
   this->EndModify(disabledModify);
@@ -107,6 +122,7 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::Copy(vtkMRMLNode *anode)
   vtkMRMLDiffusionTensorVolumeSliceDisplayNode *node = (vtkMRMLDiffusionTensorVolumeSliceDisplayNode *) anode;
 
   this->SetDiffusionTensorDisplayPropertiesNodeID(node->DiffusionTensorDisplayPropertiesNodeID);
+  this->SetMinimumGlyphSpacing(node->MinimumGlyphSpacing);
 
   this->EndModify(disabledModify);
 }
@@ -118,11 +134,13 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::PrintSelf(ostream& os, vtkInd
 
   Superclass::PrintSelf(os,indent);
 //  os << indent << "ColorMode:             " << this->ColorMode << "\n";
+  os << indent << "MinimumGlyphSpacing:   " << this->MinimumGlyphSpacing << "\n";
 }
 //----------------------------------------------------------------------------
 void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::SetSliceGlyphRotationMatrix(vtkMatrix4x4 *matrix)
 {
   this->DiffusionTensorGlyphFilter->SetTensorRotationMatrix(matrix);
+  this->DiffusionTensorGlyphInstancesFilter->SetTensorRotationMatrix(matrix);
   this->Modified();
 }
 
@@ -134,6 +152,7 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::SetSlicePositionMatrix(vtkMat
   // because the later fire the even Modified() wich will update the pipeline
   // and execute the filter that needs to be up-to-date.
   this->DiffusionTensorGlyphFilter->SetVolumePositionMatrix(matrix);
+  this->DiffusionTensorGlyphInstancesFilter->SetVolumePositionMatrix(matrix);
   Superclass::SetSlicePositionMatrix(matrix);
 }
 
@@ -141,6 +160,7 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::SetSlicePositionMatrix(vtkMat
 void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::SetSliceImagePort(vtkAlgorithmOutput *imagePort)
 {
   this->DiffusionTensorGlyphFilter->SetInputConnection(imagePort);
+  this->DiffusionTensorGlyphInstancesFilter->SetInputConnection(imagePort);
   this->Superclass::SetSliceImagePort(imagePort);
 }
 
@@ -148,13 +168,32 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::SetSliceImagePort(vtkAlgorith
 vtkAlgorithmOutput* vtkMRMLDiffusionTensorVolumeSliceDisplayNode
 ::GetOutputMeshConnection()
 {
+  if (this->GlyphInstancing)
+    {
+    return this->DiffusionTensorGlyphInstancesFilter->GetOutputPort();
+    }
   return this->DiffusionTensorGlyphFilter->GetOutputPort();
 }
 
+//----------------------------------------------------------------------------
+vtkAlgorithmOutput* vtkMRMLDiffusionTensorVolumeSliceDisplayNode
+::GetOutputGlyphSourceConnection()
+{
+  if (!this->GlyphInstancing)
+    {
+    return 0;
+    }
+  return this->DiffusionTensorGlyphFilter->GetNumberOfInputConnections(1) > 0 ?
+    this->DiffusionTensorGlyphFilter->GetInputConnection(1, 0) : 0;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::UpdateAssignedAttribute()
 {
   this->Superclass::UpdateAssignedAttribute();
+  // Slice views display the glyph geometry, even if 3D views use instancing
+  this->SliceToXYTransformer->SetInputConnection(
+    this->DiffusionTensorGlyphFilter->GetOutputPort());
 
   // set display properties according to the tensor-specific display properties node for glyphs
   vtkMRMLDiffusionTensorDisplayPropertiesNode * dtDPN =
@@ -169,6 +208,7 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::UpdateAssignedAttribute()
       dtDPN->GetGlyphGeometry( ) == vtkMRMLDiffusionTensorDisplayPropertiesNode::Superquadrics)
     {
     this->ScalarVisibilityOff();
+    this->UpdateGlyphInstancesFilter();
     return;
     }
 
@@ -183,6 +223,9 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::UpdateAssignedAttribute()
   this->DiffusionTensorGlyphFilter->SetResolution(1);
   this->DiffusionTensorGlyphFilter->SetDimensionResolution( dtDPN->GetLineGlyphResolution(), dtDPN->GetLineGlyphResolution());
   this->DiffusionTensorGlyphFilter->SetScaleFactor( dtDPN->GetGlyphScaleFactor( ) );
+  // The slice image has one pixel per screen pixel
+  this->DiffusionTensorGlyphFilter->SetMaximumGlyphDensity( this->MinimumGlyphSpacing > 1 ?
+    1.0 / (this->MinimumGlyphSpacing * this->MinimumGlyphSpacing) : 0.0 );
 
   vtkDebugMacro("setting glyph geometry" << dtDPN->GetGlyphGeometry( ) );
 
@@ -272,6 +315,8 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::UpdateAssignedAttribute()
       }
     }
 
+  this->UpdateGlyphInstancesFilter();
+
   // Updating the filter can be time consuming, we want to refrain from updating
   // as much as possible. Not updating the filter may result into an out-of-date
   // scalar range if AutoScalarRange is true. We infer here that the user doesn't
@@ -302,6 +347,21 @@ void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::UpdateAssignedAttribute()
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLDiffusionTensorVolumeSliceDisplayNode::UpdateGlyphInstancesFilter()
+{
+  vtkDiffusionTensorGlyph* glyphFilter = this->DiffusionTensorGlyphFilter;
+  vtkDiffusionTensorGlyph* instancesFilter = this->DiffusionTensorGlyphInstancesFilter;
+  instancesFilter->SetSourceConnection(glyphFilter->GetNumberOfInputConnections(1) > 0 ?
+    glyphFilter->GetInputConnection(1, 0) : 0);
+  instancesFilter->SetClampScaling(glyphFilter->GetClampScaling());
+  instancesFilter->SetResolution(glyphFilter->GetResolution());
+  instancesFilter->SetDimensionResolution(glyphFilter->GetDimensionResolution());
+  instancesFilter->SetScaleFactor(glyphFilter->GetScaleFactor());
+  instancesFilter->SetMaximumGlyphDensity(glyphFilter->GetMaximumGlyphDensity());
+  instancesFilter->ColorGlyphsBy(glyphFilter->GetScalarInvariant());
+}
+
 //----------------------------------------------------------------------------
 vtkMRMLDiffusionTensorDisplayPropertiesNode* vtkMRMLDiffusionTensorVolumeSliceDisplayNode::GetDiffusionTensorDisplayPropertiesNode ( )
 {
@@ -79,9 +79,20 @@ class VTK_MRML_EXPORT vtkMRMLDiffusionTensorVolumeSliceDisplayNode
                                    void * /*callData*/ );
 
   /// Return the glyph producer output for the input image data.
-  /// \sa GetOutputPolyData()
+  /// If GlyphInstancing is enabled, the output contains glyph instances.
+  /// \sa GetOutputPolyData(), GetOutputGlyphSourceConnection()
   virtual vtkAlgorithmOutput* GetOutputMeshConnection();
 
+  /// Return the glyph geometry if GlyphInstancing is enabled (default), 0 otherwise.
+  virtual vtkAlgorithmOutput* GetOutputGlyphSourceConnection();
+
+  ///
+  /// Minimum distance between glyphs on screen (in pixels). If the glyph
+  /// spacing of the display properties is smaller, glyphs are sampled more
+  /// coarsely. Default is 3.
+  vtkGetMacro(MinimumGlyphSpacing, int);
+  vtkSetMacro(MinimumGlyphSpacing, int);
+
   ///
   /// Update the pipeline based on this node attributes
   virtual void UpdateAssignedAttribute();
@@ -192,6 +203,10 @@ class VTK_MRML_EXPORT vtkMRMLDiffusionTensorVolumeSliceDisplayNode
   void operator= ( const vtkMRMLDiffusionTensorVolumeSliceDisplayNode& );
 
   vtkDiffusionTensorGlyph  *DiffusionTensorGlyphFilter;
+  /// Same glyphs as DiffusionTensorGlyphFilter, as instances
+  vtkDiffusionTensorGlyph  *DiffusionTensorGlyphInstancesFilter;
+
+  int MinimumGlyphSpacing;
 
   /// ALL MRML nodes
   vtkMRMLDiffusionTensorDisplayPropertiesNode *DiffusionTensorDisplayPropertiesNode;
@@ -199,6 +214,9 @@ class VTK_MRML_EXPORT vtkMRMLDiffusionTensorVolumeSliceDisplayNode
 
   void SetDiffusionTensorDisplayPropertiesNodeID(const char* id);
 
+  /// Apply the settings of DiffusionTensorGlyphFilter to DiffusionTensorGlyphInstancesFilter
+  void UpdateGlyphInstancesFilter();
+
   static std::vector<int> GetSupportedColorModes();
 
 };
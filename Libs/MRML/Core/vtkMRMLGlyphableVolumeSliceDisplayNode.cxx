@@ -31,6 +31,7 @@ vtkMRMLNodeNewMacro(vtkMRMLGlyphableVolumeSliceDisplayNode);
 vtkMRMLGlyphableVolumeSliceDisplayNode::vtkMRMLGlyphableVolumeSliceDisplayNode()
 {
   this->ColorMode = this->colorModeScalar;
+  this->GlyphInstancing = 0;
 
   this->SliceImagePort = NULL;
 
@@ -71,6 +72,7 @@ void vtkMRMLGlyphableVolumeSliceDisplayNode::WriteXML(ostream& of, int nIndent)
   Superclass::WriteXML(of, nIndent);
 
   of << " colorMode =\"" << this->ColorMode << "\"";
+  of << " glyphInstancing=\"" << (this->GlyphInstancing ? "true" : "false") << "\"";
 }
 
 
@@ -94,6 +96,10 @@ void vtkMRMLGlyphableVolumeSliceDisplayNode::ReadXMLAttributes(const char** atts
       ss << attValue;
       ss >> ColorMode;
       }
+    else if (!strcmp(attName, "glyphInstancing"))
+      {
+      this->SetGlyphInstancing(strcmp(attValue, "true") == 0 ? 1 : 0);
+      }
 
     }
 
@@ -113,6 +119,7 @@ void vtkMRMLGlyphableVolumeSliceDisplayNode::Copy(vtkMRMLNode *anode)
   vtkMRMLGlyphableVolumeSliceDisplayNode *node = (vtkMRMLGlyphableVolumeSliceDisplayNode *) anode;
 
   this->SetColorMode(node->ColorMode);
+  this->SetGlyphInstancing(node->GlyphInstancing);
 
   this->EndModify(disabledModify);
 }
@@ -124,6 +131,7 @@ void vtkMRMLGlyphableVolumeSliceDisplayNode::PrintSelf(ostream& os, vtkIndent in
 
   Superclass::PrintSelf(os,indent);
   os << indent << "ColorMode:             " << this->ColorMode << "\n";
+  os << indent << "GlyphInstancing:       " << this->GlyphInstancing << "\n";
 }
 //----------------------------------------------------------------------------
 void vtkMRMLGlyphableVolumeSliceDisplayNode::SetSliceGlyphRotationMatrix(vtkMatrix4x4 *vtkNotUsed(matrix))
@@ -179,6 +187,13 @@ vtkAlgorithmOutput* vtkMRMLGlyphableVolumeSliceDisplayNode
   return 0;
 }
 
+//----------------------------------------------------------------------------
+vtkAlgorithmOutput* vtkMRMLGlyphableVolumeSliceDisplayNode
+::GetOutputGlyphSourceConnection()
+{
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLGlyphableVolumeSliceDisplayNode::UpdateAssignedAttribute()
 {
@@ -99,6 +99,25 @@ class VTK_MRML_EXPORT vtkMRMLGlyphableVolumeSliceDisplayNode : public vtkMRMLMod
   /// \sa GetOutputPolyData(), GetSliceOutputPort()
   virtual vtkPolyData* GetSliceOutputPolyData();
 
+  /// Return the glyph geometry if the output mesh contains glyph instances
+  /// (one point per glyph with its scale and orientation, see
+  /// vtkDiffusionTensorGlyph::OutputGlyphInstances) instead of the glyphs.
+  /// Views render the instances with this geometry.
+  /// Return 0 (default) if the output mesh contains the glyphs.
+  /// \sa GetOutputMeshConnection()
+  virtual vtkAlgorithmOutput* GetOutputGlyphSourceConnection();
+
+  ///
+  /// If enabled, glyphs are rendered in 3D views with instancing:
+  /// GetOutputMeshConnection() only contains the position, orientation and scale
+  /// of each glyph instead of the glyph geometry. Slice views always display
+  /// the glyph geometry (see GetSliceOutputPort()).
+  /// Disabled by default, subclasses that can output glyph instances enable it.
+  /// \sa GetOutputGlyphSourceConnection()
+  vtkGetMacro(GlyphInstancing, int);
+  vtkSetMacro(GlyphInstancing, int);
+  vtkBooleanMacro(GlyphInstancing, int);
+
   ///
   /// Update the pipeline based on this node attributes
   virtual void UpdateAssignedAttribute();
@@ -208,6 +227,8 @@ class VTK_MRML_EXPORT vtkMRMLGlyphableVolumeSliceDisplayNode : public vtkMRMLMod
     /// Enumerated
     int ColorMode;
 
+    int GlyphInstancing;
+
 
 };
 
@@ -17,9 +17,11 @@ Version:   $Revision: 1.14 $
 
 // VTK includes
 #include <vtkOrientedGridTransform.h>
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
 
 // STD includes
 #include <sstream>
@@ -76,3 +78,34 @@ void vtkMRMLGridTransformNode::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os,indent);
 }
+
+//----------------------------------------------------------------------------
+bool vtkMRMLGridTransformNode::DisplacementGridModified()
+{
+  // The grid is stored in one direction, the other one is computed from it
+  vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(
+    this->GetTransformFromParentAs("vtkOrientedGridTransform", false, true));
+  if (!gridTransform)
+    {
+    gridTransform = vtkOrientedGridTransform::SafeDownCast(
+      this->GetTransformToParentAs("vtkOrientedGridTransform", false, true));
+    }
+  vtkImageData* displacementGrid = gridTransform ? gridTransform->GetDisplacementGrid() : NULL;
+  if (!displacementGrid)
+    {
+    vtkErrorMacro("DisplacementGridModified: Node does not store a displacement grid");
+    return false;
+    }
+  int wasModifying = this->StartModify();
+  if (displacementGrid->GetPointData()->GetScalars())
+    {
+    displacementGrid->GetPointData()->GetScalars()->Modified();
+    }
+  displacementGrid->Modified();
+  gridTransform->Modified();
+  this->StorableModifiedTime.Modified();
+  this->TransformModified();
+  this->Modified();
+  this->EndModify(wasModifying);
+  return true;
+}
@@ -46,6 +46,15 @@ public:
   /// Get node XML tag name (like Volume, Model)
   virtual const char* GetNodeTagName() {return "GridTransform";};
 
+  ///
+  /// Notify that the displacement grid of the transform has been changed in place
+  /// (e.g., through a numpy array that shares the buffer of the displacement grid).
+  /// The grid and the transform are marked as modified and TransformModifiedEvent
+  /// and ModifiedEvent are invoked. Between StartModify() and EndModify() the events
+  /// are invoked only once, by EndModify().
+  /// \return False if the node does not store a grid transform.
+  virtual bool DisplacementGridModified();
+
 protected:
   vtkMRMLGridTransformNode();
   ~vtkMRMLGridTransformNode();
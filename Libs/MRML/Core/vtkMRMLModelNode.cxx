@@ -36,6 +36,7 @@ Version:   $Revision: 1.3 $
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransformFilter.h>
@@ -110,6 +111,29 @@ void vtkMRMLModelNode::ProcessMRMLEvents ( vtkObject *caller,
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLModelNode::MeshModified()
+{
+  vtkPointSet* mesh = this->GetMesh();
+  if (!mesh)
+    {
+    return;
+    }
+  int wasModifying = this->StartModify();
+  if (mesh->GetPoints())
+    {
+    if (mesh->GetPoints()->GetData())
+      {
+      mesh->GetPoints()->GetData()->Modified();
+      }
+    mesh->GetPoints()->Modified();
+    }
+  // Forwarded to the producer, which invokes MeshModifiedEvent
+  mesh->Modified();
+  this->Modified();
+  this->EndModify(wasModifying);
+}
+
 //----------------------------------------------------------------------------
 vtkMRMLModelDisplayNode* vtkMRMLModelNode::GetModelDisplayNode()
 {
@@ -100,6 +100,13 @@ public:
   /// \sa GetPolyDataConnection(), GetUnstructuredGridConnection()
   vtkGetObjectMacro(MeshConnection,vtkAlgorithmOutput)
 
+  /// Notify that the points of the mesh have been changed in place (e.g.,
+  /// through a numpy array that shares the points buffer). The points and the
+  /// mesh are marked as modified, and MeshModifiedEvent and ModifiedEvent are
+  /// invoked. Between StartModify() and EndModify() the events are invoked only
+  /// once, by EndModify().
+  virtual void MeshModified();
+
   /// Return the input mesh pipeline if the mesh
   /// is a polydata.
   /// \sa GetMeshConnection(), SetPolyDataConnection()
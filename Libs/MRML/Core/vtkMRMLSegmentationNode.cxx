@@ -39,6 +39,7 @@
 // VTK includes
 #include <vtkBoundingBox.h>
 #include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
 #include <vtkGeneralTransform.h>
 #include <vtkHomogeneousTransform.h>
 #include <vtkIntArray.h>
@@ -582,6 +583,14 @@ bool vtkMRMLSegmentationNode::GenerateMergedLabelmap(
     // Get binary labelmap from segment
     vtkOrientedImageData* representationBinaryLabelmap = vtkOrientedImageData::SafeDownCast(
       currentSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+    vtkSmartPointer<vtkOrientedImageData> extractedBinaryLabelmap;
+    if (currentSegment->GetSharedLabelmap())
+      {
+      // The shared labelmap contains other segments as well
+      extractedBinaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      currentSegment->ExtractBinaryLabelmapRepresentation(extractedBinaryLabelmap);
+      representationBinaryLabelmap = extractedBinaryLabelmap;
+      }
     // If binary labelmap is empty then skip
     if (representationBinaryLabelmap->IsEmpty())
       {
@@ -815,6 +824,26 @@ vtkOrientedImageData* vtkMRMLSegmentationNode::GetBinaryLabelmapRepresentation(c
   return vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
 }
 
+//---------------------------------------------------------------------------
+bool vtkMRMLSegmentationNode::BinaryLabelmapRepresentationModified(const std::string segmentId)
+{
+  vtkOrientedImageData* labelmap = this->GetBinaryLabelmapRepresentation(segmentId);
+  if (!labelmap)
+    {
+    vtkErrorMacro("BinaryLabelmapRepresentationModified: Segment has no binary labelmap representation");
+    return false;
+    }
+  int wasModifying = this->StartModify();
+  if (labelmap->GetPointData()->GetScalars())
+    {
+    labelmap->GetPointData()->GetScalars()->Modified();
+    }
+  // Observed by the segmentation, which invokes the segmentation events
+  labelmap->Modified();
+  this->EndModify(wasModifying);
+  return true;
+}
+
 //---------------------------------------------------------------------------
 bool vtkMRMLSegmentationNode::CreateClosedSurfaceRepresentation()
 {
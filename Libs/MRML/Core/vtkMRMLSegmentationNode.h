@@ -171,8 +171,19 @@ public:
   /// If representation does not exist yet then call CreateBinaryLabelmapRepresentation() before.
   /// If binary labelmap is the master representation then the returned object can be modified, and
   /// all other representations will be automatically udated.
+  /// If the segment uses a shared labelmap (\sa vtkSegment::SetSharedLabelmap) then the shared labelmap is returned,
+  /// which contains other segments as well.
   virtual vtkOrientedImageData* GetBinaryLabelmapRepresentation(const std::string segmentId);
 
+  /// Notify that the voxels of the binary labelmap representation of a segment have been changed
+  /// in place (e.g., through a numpy array that shares the buffer of the image returned by
+  /// GetBinaryLabelmapRepresentation()). The labelmap is marked as modified, which invokes the
+  /// segmentation events. Between StartModify() and EndModify() the events are invoked only once,
+  /// by EndModify().
+  /// If the segment uses a shared labelmap then the shared labelmap is marked as modified.
+  /// \return False if the segment has no binary labelmap representation.
+  virtual bool BinaryLabelmapRepresentationModified(const std::string segmentId);
+
   /// Generate closed surface representation for all segments.
   /// Useful for 3D visualization.
   virtual bool CreateClosedSurfaceRepresentation();
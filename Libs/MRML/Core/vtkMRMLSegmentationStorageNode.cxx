@@ -1007,6 +1007,12 @@ int vtkMRMLSegmentationStorageNode::WriteBinaryLabelmapRepresentation(vtkMRMLSeg
       vtkErrorMacro("WriteBinaryLabelmapRepresentation: Failed to retrieve master representation from segment " << currentSegmentID);
       continue;
       }
+    if (currentSegment->GetSharedLabelmap())
+      {
+      // The shared labelmap contains other segments as well, only write voxels of this segment
+      currentBinaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      currentSegment->ExtractBinaryLabelmapRepresentation(currentBinaryLabelmap);
+      }
 
     int currentBinaryLabelmapExtent[6] = { 0, -1, 0, -1, 0, -1 };
     currentBinaryLabelmap->GetExtent(currentBinaryLabelmapExtent);
@@ -622,6 +622,26 @@ bool vtkMRMLTableNode::SetCellText(int rowIndex, int columnIndex, const char* te
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLTableNode::ColumnModified(const char* columnName)
+{
+  if (!this->Table)
+    {
+    vtkErrorMacro("vtkMRMLTableNode::ColumnModified failed: invalid table");
+    return false;
+    }
+  vtkAbstractArray* column = columnName ? this->Table->GetColumnByName(columnName) : 0;
+  if (!column)
+    {
+    vtkErrorMacro("vtkMRMLTableNode::ColumnModified failed: invalid column name "<<(columnName ? columnName : "(null)"));
+    return false;
+    }
+  column->Modified();
+  // Observed by the node, which invokes ModifiedEvent
+  this->Table->Modified();
+  return true;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLTableNode::GetNumberOfRows()
 {
@@ -170,6 +170,14 @@ public:
   /// GetTable() method and manipulate that directly.
   bool SetCellText(int rowIndex, int columnIndex, const char* text);
 
+  ///
+  /// Notify that values of a column have been changed in place (e.g., through
+  /// a numpy array that shares the column buffer). The column and the table are
+  /// marked as modified and ModifiedEvent is invoked. Between StartModify() and
+  /// EndModify() the event is invoked only once, by EndModify().
+  /// Returns true on success.
+  bool ColumnModified(const char* columnName);
+
   ///
   /// Get column index of the first column by the specified name.
   /// Returns -1 if no such column is found.
@@ -30,16 +30,55 @@
 #include <vtkTable.h>
 #include <vtkStringArray.h>
 #include <vtkBitArray.h>
+#include <vtkDoubleArray.h>
 #include <vtkNew.h>
 #include <vtkSQLQuery.h>
-#include <vtkRowQueryToTable.h>
 #include <vtkSQLDatabase.h>
 #include <vtkSQLiteDatabase.h>
 #include <vtkSQLiteQuery.h>
 #include <vtkSmartPointer.h>
+#include <vtkTypeInt64Array.h>
+#include <vtk_sqlite.h>
 
 #include <vtksys/SystemTools.hxx>
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Database connection that is closed when it goes out of scope
+struct SQLiteConnection
+{
+  SQLiteConnection() : Database(NULL) {}
+  ~SQLiteConnection() { vtk_sqlite3_close(this->Database); }
+  vtk_sqlite3* Database;
+};
+
+//----------------------------------------------------------------------------
+/// Prepared statement that is finalized when it goes out of scope
+struct SQLiteStatement
+{
+  SQLiteStatement(vtk_sqlite3* database, const std::string& query) : Statement(NULL)
+    {
+    vtk_sqlite3_prepare_v2(database, query.c_str(), -1, &this->Statement, NULL);
+    }
+  ~SQLiteStatement() { vtk_sqlite3_finalize(this->Statement); }
+  vtk_sqlite3_stmt* Statement;
+};
+
+//----------------------------------------------------------------------------
+std::string GetColumnText(vtk_sqlite3_stmt* statement, int col)
+{
+  const unsigned char* text = vtk_sqlite3_column_text(statement, col);
+  if (!text)
+    {
+    return std::string();
+    }
+  return std::string(reinterpret_cast<const char*>(text), vtk_sqlite3_column_bytes(statement, col));
+}
+
+} // end of anonymous namespace
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLTableSQLiteStorageNode);
 
@@ -92,28 +131,105 @@ int vtkMRMLTableSQLiteStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  std::string dbname = std::string("sqlite://") + fullName;
-  vtkSmartPointer<vtkSQLiteDatabase> database = vtkSmartPointer<vtkSQLiteDatabase>::Take(
-                   vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str())));
+  if (!this->TableName || std::string(this->TableName).empty())
+    {
+    vtkErrorMacro("ReadData: no table name specified");
+    return 0;
+    }
 
-  if (!database.GetPointer() || !database->Open(this->GetPassword(), vtkSQLiteDatabase::USE_EXISTING))
+  // Values are read with the SQLite column accessors directly into typed arrays, because
+  // vtkSQLiteQuery::DataValue truncates integers to 32 bits.
+  SQLiteConnection connection;
+  if (vtk_sqlite3_open(fullName.c_str(), &connection.Database) != VTK_SQLITE_OK)
+    {
+    vtkErrorMacro("ReadData: database file '" << fullName << "' cannot be opened: "
+      << vtk_sqlite3_errmsg(connection.Database));
+    return 0;
+    }
+  std::string quotedTableName = QuoteIdentifier(this->TableName);
+
+  // Get the column names and declared types, so that typed arrays can be
+  // allocated upfront and filled directly (instead of growing a vtkTable
+  // row by row from variant arrays).
+  std::vector<std::string> columnNames;
+  std::vector<int> columnTypes;
+  SQLiteStatement tableInfo(connection.Database, "PRAGMA table_info(" + quotedTableName + ")");
+  if (!tableInfo.Statement)
     {
-    vtkErrorMacro("ReadData: database file '" << fullName << "cannot be openned");
+    vtkErrorMacro("ReadData: failed to get columns of table '" << this->TableName << "': "
+      << vtk_sqlite3_errmsg(connection.Database));
+    return 0;
+    }
+  while (vtk_sqlite3_step(tableInfo.Statement) == VTK_SQLITE_ROW)
+    {
+    columnNames.push_back(GetColumnText(tableInfo.Statement, 1));
+    columnTypes.push_back(GetColumnTypeFromDeclaredType(GetColumnText(tableInfo.Statement, 2)));
+    }
+  if (columnNames.empty())
+    {
+    vtkErrorMacro("ReadData: table '" << this->TableName << "' not found in " << fullName);
     return 0;
     }
 
-  vtkSmartPointer<vtkSQLiteQuery> query = vtkSmartPointer<vtkSQLiteQuery>::Take(
-                   vtkSQLiteQuery::SafeDownCast( database->GetQueryInstance()));
-  std::string queryString("select * from ");
-  queryString += std::string(this->TableName);
-  query->SetQuery(queryString.c_str());
-  query->Execute();
+  SQLiteStatement rowCount(connection.Database, "SELECT COUNT(*) FROM " + quotedTableName);
+  if (!rowCount.Statement || vtk_sqlite3_step(rowCount.Statement) != VTK_SQLITE_ROW)
+    {
+    vtkErrorMacro("ReadData: failed to count rows of table '" << this->TableName << "': "
+      << vtk_sqlite3_errmsg(connection.Database));
+    return 0;
+    }
+  vtkIdType numberOfRows = static_cast<vtkIdType>(vtk_sqlite3_column_int64(rowCount.Statement, 0));
 
-  vtkSmartPointer<vtkRowQueryToTable> queryToTable = vtkSmartPointer<vtkRowQueryToTable>::New();
-  queryToTable->SetQuery(query);
-  queryToTable->Update();
+  int numberOfColumns = static_cast<int>(columnNames.size());
+  vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::New();
+  std::vector<vtkAbstractArray*> columns(numberOfColumns);
+  for (int col = 0; col < numberOfColumns; ++col)
+    {
+    vtkSmartPointer<vtkAbstractArray> column;
+    switch (columnTypes[col])
+      {
+      // SQLite integers are 64-bit
+      case IntegerColumn: column = vtkSmartPointer<vtkTypeInt64Array>::New(); break;
+      case RealColumn: column = vtkSmartPointer<vtkDoubleArray>::New(); break;
+      default: column = vtkSmartPointer<vtkStringArray>::New(); break;
+      }
+    column->SetName(columnNames[col].c_str());
+    column->SetNumberOfValues(numberOfRows);
+    table->AddColumn(column);
+    columns[col] = column;
+    }
 
-  vtkSmartPointer<vtkTable> table = queryToTable->GetOutput();
+  SQLiteStatement rows(connection.Database, "SELECT * FROM " + quotedTableName);
+  if (!rows.Statement || vtk_sqlite3_column_count(rows.Statement) != numberOfColumns)
+    {
+    vtkErrorMacro("ReadData: failed to read table '" << this->TableName << "': "
+      << vtk_sqlite3_errmsg(connection.Database));
+    return 0;
+    }
+  vtkIdType row = 0;
+  for (; row < numberOfRows && vtk_sqlite3_step(rows.Statement) == VTK_SQLITE_ROW; ++row)
+    {
+    for (int col = 0; col < numberOfColumns; ++col)
+      {
+      switch (columnTypes[col])
+        {
+        case IntegerColumn:
+          static_cast<vtkTypeInt64Array*>(columns[col])->SetValue(row,
+            static_cast<vtkTypeInt64>(vtk_sqlite3_column_int64(rows.Statement, col)));
+          break;
+        case RealColumn:
+          static_cast<vtkDoubleArray*>(columns[col])->SetValue(row, vtk_sqlite3_column_double(rows.Statement, col));
+          break;
+        default:
+          static_cast<vtkStringArray*>(columns[col])->SetValue(row, GetColumnText(rows.Statement, col));
+          break;
+        }
+      }
+    }
+  if (row < numberOfRows)
+    {
+    table->SetNumberOfRows(row);
+    }
 
   tableNode->SetAndObserveTable(table);
 
@@ -149,27 +265,20 @@ int vtkMRMLTableSQLiteStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  std::string dbname = std::string("sqlite://") + fullName;
-
-  //vtkSmartPointer<vtkSQLiteDatabase> database = vtkSmartPointer<vtkSQLiteDatabase>::Take(vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str())));
-  vtkSQLiteDatabase *database = vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str()));
-
-  if (!database || !database->Open(this->GetPassword(), vtkSQLiteDatabase::USE_EXISTING_OR_CREATE))
-    {
-    vtkErrorMacro("ReadData: database file '" << fullName << "cannot be openned");
-    return 0;
-    }
-
   vtkTable *table = tableNode->GetTable();
   if (!table)
     {
-    vtkErrorMacro("ReadData: no table to write for the node '" << std::string(tableNode->GetName()));
+    vtkErrorMacro("WriteData: no table to write for the node '" << std::string(tableNode->GetName()));
     return 0;
     }
 
-  if (!this->TableName || std::string(this->TableName).empty())
+  std::string dbname = std::string("sqlite://") + fullName;
+  vtkSmartPointer<vtkSQLiteDatabase> database = vtkSmartPointer<vtkSQLiteDatabase>::Take(
+                   vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str())));
+
+  if (!database.GetPointer() || !database->Open(this->GetPassword(), vtkSQLiteDatabase::USE_EXISTING_OR_CREATE))
     {
-    vtkErrorMacro("ReadData: no table name for the node '" << std::string(tableNode->GetName()));
+    vtkErrorMacro("WriteData: database file '" << fullName << "cannot be openned");
     return 0;
     }
 
@@ -177,96 +286,183 @@ int vtkMRMLTableSQLiteStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   this->DropTable(this->TableName, database);
 
   //converting this table to SQLite will require two queries: one to create
-  //the table, and another to populate its rows with data.
+  //the table, and a prepared statement to populate its rows with data.
   std::string createTableQuery = "CREATE TABLE IF NOT EXISTS ";
-  createTableQuery += this->TableName;
+  createTableQuery += QuoteIdentifier(this->TableName);
   createTableQuery += "(";
 
-  std::string insertPreamble = "INSERT into ";
-  insertPreamble += this->TableName;
-  insertPreamble += "(";
+  std::string insertQuery = "INSERT into ";
+  insertQuery += QuoteIdentifier(this->TableName);
+  insertQuery += "(";
+  std::string insertValues = " VALUES (";
 
   //get the columns from the vtkTable to finish the query
-  vtkIdType numColumns = table->GetNumberOfColumns();
-  for(vtkIdType i = 0; i < numColumns; i++)
+  int numColumns = static_cast<int>(table->GetNumberOfColumns());
+  std::vector<int> columnTypes(numColumns);
+  for(int i = 0; i < numColumns; i++)
     {
-    //get this column's name
-    std::string columnName = table->GetColumn(i)->GetName();
-    createTableQuery += columnName;
-    insertPreamble += "'" + columnName + "'";
+    vtkAbstractArray* column = table->GetColumn(i);
+    std::string columnName = column->GetName() ? column->GetName() : "";
+    createTableQuery += QuoteIdentifier(columnName);
+    insertQuery += QuoteIdentifier(columnName);
+    insertValues += "?";
 
     //figure out what type of data is stored in this column
-    std::string columnType = table->GetColumn(i)->GetClassName();
-
-    if( (columnType.find("String") != std::string::npos) ||
-        (columnType.find("Data") != std::string::npos) ||
-        (columnType.find("Variant") != std::string::npos) )
+    columnTypes[i] = GetColumnTypeFromArray(column);
+    switch (columnTypes[i])
       {
-      createTableQuery += " TEXT";
-      }
-    else if( (columnType.find("Double") != std::string::npos) ||
-             (columnType.find("Float") != std::string::npos) )
-      {
-      createTableQuery += " REAL";
-      }
-    else
-      {
-      createTableQuery += " INTEGER";
+      case IntegerColumn: createTableQuery += " INTEGER"; break;
+      case RealColumn: createTableQuery += " REAL"; break;
+      default: createTableQuery += " TEXT"; break;
       }
     if(i == numColumns - 1)
       {
       createTableQuery += ");";
-      insertPreamble += ") VALUES (";
+      insertQuery += ")";
+      insertValues += ");";
       }
     else
       {
       createTableQuery += ", ";
-      insertPreamble += ", ";
+      insertQuery += ", ";
+      insertValues += ", ";
       }
     }
+  insertQuery += insertValues;
 
   //perform the create table query
-  vtkSQLiteQuery *query =
-    static_cast<vtkSQLiteQuery*>(database->GetQueryInstance());
+  vtkSmartPointer<vtkSQLiteQuery> query = vtkSmartPointer<vtkSQLiteQuery>::Take(
+                   vtkSQLiteQuery::SafeDownCast( database->GetQueryInstance()));
 
   query->SetQuery(createTableQuery.c_str());
-  cout << "creating the table" << endl;
   if(!query->Execute())
     {
-    vtkErrorMacro(<<"Error performing 'create table' query");
+    vtkErrorMacro(<<"Error performing 'create table' query: " << query->GetLastErrorText());
+    return 0;
     }
 
-  //iterate over the rows of the vtkTable to complete the insert query
+  //insert all the rows in a single transaction, reusing the same prepared
+  //statement and binding values with their native type
+  if (!query->BeginTransaction())
+    {
+    vtkErrorMacro(<<"Error starting transaction: " << query->GetLastErrorText());
+    return 0;
+    }
+  query->SetQuery(insertQuery.c_str());
   vtkIdType numRows = table->GetNumberOfRows();
   for(vtkIdType i = 0; i < numRows; i++)
     {
-    std::string insertQuery = insertPreamble;
-    for (vtkIdType j = 0; j < numColumns; j++)
+    for (int j = 0; j < numColumns; j++)
       {
-      insertQuery += "'" + table->GetValue(i, j).ToString() + "'";
-      if(j < numColumns - 1)
+      vtkAbstractArray* column = table->GetColumn(j);
+      switch (columnTypes[j])
         {
-        insertQuery += ", ";
+        case IntegerColumn:
+          if (column->GetDataTypeSize() < 8)
+            {
+            query->BindParameter(j, static_cast<vtkTypeInt64>(
+              static_cast<vtkDataArray*>(column)->GetTuple1(i)));
+            }
+          else
+            {
+            // doubles cannot represent all 64-bit integers
+            query->BindParameter(j, column->GetVariantValue(i).ToLongLong());
+            }
+          break;
+        case RealColumn:
+          query->BindParameter(j, static_cast<vtkDataArray*>(column)->GetTuple1(i));
+          break;
+        case StringColumn:
+          query->BindParameter(j, static_cast<vtkStringArray*>(column)->GetValue(i));
+          break;
+        default:
+          query->BindParameter(j, table->GetValue(i, j).ToString());
+          break;
         }
       }
-    insertQuery += ");";
     //perform the insert query for this row
-    query->SetQuery(insertQuery.c_str());
     if(!query->Execute())
       {
-      vtkErrorMacro(<<"Error performing 'insert' query");
+      vtkErrorMacro(<<"Error performing 'insert' query: " << query->GetLastErrorText());
+      query->RollbackTransaction();
+      return 0;
       }
     }
+  if (!query->CommitTransaction())
+    {
+    vtkErrorMacro(<<"Error committing rows: " << query->GetLastErrorText());
+    return 0;
+    }
 
   //cleanup and return
-  query->Delete();
+  query = NULL;
   database->Close();
-  database->Delete();
 
   vtkDebugMacro("WriteData: successfully wrote table to database: " << fullName);
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLTableSQLiteStorageNode::GetColumnTypeFromArray(vtkAbstractArray* column)
+{
+  if (vtkStringArray::SafeDownCast(column))
+    {
+    return StringColumn;
+    }
+  vtkDataArray* dataArray = vtkDataArray::SafeDownCast(column);
+  if (!dataArray || dataArray->GetNumberOfComponents() != 1)
+    {
+    return VariantColumn;
+    }
+  if (dataArray->GetDataType() == VTK_FLOAT || dataArray->GetDataType() == VTK_DOUBLE)
+    {
+    return RealColumn;
+    }
+  return IntegerColumn;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLTableSQLiteStorageNode::GetColumnTypeFromDeclaredType(const std::string& declaredType)
+{
+  // Column affinity rules of SQLite
+  std::string type = vtksys::SystemTools::UpperCase(declaredType);
+  if (type.find("INT") != std::string::npos)
+    {
+    return IntegerColumn;
+    }
+  if (type.find("CHAR") != std::string::npos
+      || type.find("CLOB") != std::string::npos
+      || type.find("TEXT") != std::string::npos)
+    {
+    return StringColumn;
+    }
+  if (type.find("REAL") != std::string::npos
+      || type.find("FLOA") != std::string::npos
+      || type.find("DOUB") != std::string::npos)
+    {
+    return RealColumn;
+    }
+  return StringColumn;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLTableSQLiteStorageNode::QuoteIdentifier(const std::string& name)
+{
+  // Identifiers are enclosed in double quotes, embedded double quotes are doubled
+  std::string quoted = "\"";
+  for (std::string::const_iterator it = name.begin(); it != name.end(); ++it)
+    {
+    if (*it == '"')
+      {
+      quoted += '"';
+      }
+    quoted += *it;
+    }
+  quoted += '"';
+  return quoted;
+}
+
+//----------------------------------------------------------------------------
 int vtkMRMLTableSQLiteStorageNode::DropTable(char *tableName, vtkSQLiteDatabase* database)
 {
   if(!tableName || std::string(tableName).empty())
@@ -290,7 +486,7 @@ int vtkMRMLTableSQLiteStorageNode::DropTable(char *tableName, vtkSQLiteDatabase*
     if (!tables->GetValue(i).compare(tableName))
       {
       std::string dropTableQuery = "DROP TABLE ";
-      dropTableQuery += tableName;
+      dropTableQuery += QuoteIdentifier(tableName);
       query->SetQuery(dropTableQuery.c_str());
       query->Execute();
       break;
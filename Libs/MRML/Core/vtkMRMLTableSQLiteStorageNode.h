@@ -32,6 +32,7 @@
 ///
 ///
 
+class vtkAbstractArray;
 class vtkSQLiteDatabase;
 
 class VTK_MRML_EXPORT vtkMRMLTableSQLiteStorageNode : public vtkMRMLStorageNode
@@ -78,6 +79,24 @@ protected:
   /// Write data from a  referenced node. Returns 0 on failure.
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
 
+  /// Storage type of a table column in the database
+  enum ColumnType
+    {
+    IntegerColumn,
+    RealColumn,
+    StringColumn,
+    VariantColumn
+    };
+
+  /// Get how the values of a table column are bound when writing
+  static int GetColumnTypeFromArray(vtkAbstractArray* column);
+
+  /// Get the array type to read a column with the given SQL declared type
+  static int GetColumnTypeFromDeclaredType(const std::string& declaredType);
+
+  /// Quote a table or column name so that it can be used in an SQL statement
+  static std::string QuoteIdentifier(const std::string& name);
+
   char *TableName;
   char *Password;
 };
@@ -27,14 +27,513 @@
 
 // VTK includes
 #include <vtkObjectFactory.h>
+#include <vtkCallbackCommand.h>
 #include <vtkDelimitedTextReader.h>
 #include <vtkDelimitedTextWriter.h>
 #include <vtkTable.h>
 #include <vtkStringArray.h>
 #include <vtkBitArray.h>
 #include <vtkNew.h>
+#include <vtkWeakPointer.h>
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Binary columnar table file layout (all offsets are from the file start):
+//   header
+//   column data blocks, each aligned on BinaryTableAlignment bytes
+//   table directory: count, number of rows, then descriptor + name per column
+//   schema column data blocks and schema directory (same layout)
+const char BinaryTableMagic[8] = { 'M', 'R', 'M', 'L', 'C', 'T', 'B', 'L' };
+const vtkTypeUInt32 BinaryTableByteOrderMark = 0x01020304;
+const vtkTypeUInt32 BinaryTableVersion = 1;
+const vtkTypeUInt64 BinaryTableAlignment = 64;
+
+struct BinaryTableHeader
+{
+  char Magic[8];
+  vtkTypeUInt32 ByteOrderMark;
+  vtkTypeUInt32 Version;
+  vtkTypeUInt64 TableDirectoryOffset;
+  vtkTypeUInt64 SchemaDirectoryOffset; // 0 if there is no schema
+};
+
+struct BinaryTableDirectoryHeader
+{
+  vtkTypeUInt32 NumberOfColumns;
+  vtkTypeUInt32 Reserved;
+  vtkTypeInt64 NumberOfRows;
+};
+
+struct BinaryColumnDescriptor
+{
+  vtkTypeInt32 DataType;
+  vtkTypeInt32 NumberOfComponents;
+  vtkTypeInt32 ValueSize; // 0 for bit and string columns
+  vtkTypeUInt32 NameLength;
+  vtkTypeInt64 NumberOfTuples;
+  vtkTypeUInt64 DataOffset;
+  vtkTypeUInt64 DataSize;
+};
+
+//----------------------------------------------------------------------------
+// Whole file mapped copy-on-write: modifying values of the mapped arrays in
+// memory does not change the file. The mapping is shared by all the columns
+// read from the file and released when the last one is deleted, or when the
+// file is about to be replaced (see Release()).
+class MappedTableFile
+{
+public:
+  static MappedTableFile* Map(const std::string& fileName)
+    {
+    MappedTableFile* mappedFile = new MappedTableFile;
+    mappedFile->FileName = vtksys::SystemTools::CollapseFullPath(fileName);
+    GetMappedFiles()[mappedFile->FileName].insert(mappedFile);
+#ifdef _WIN32
+    mappedFile->File = CreateFileA(fileName.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER fileSize;
+    if (mappedFile->File == INVALID_HANDLE_VALUE || !GetFileSizeEx(mappedFile->File, &fileSize))
+      {
+      delete mappedFile;
+      return NULL;
+      }
+    mappedFile->Size = static_cast<vtkTypeUInt64>(fileSize.QuadPart);
+    if (mappedFile->Size > 0)
+      {
+      mappedFile->Mapping = CreateFileMappingA(mappedFile->File, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+      if (mappedFile->Mapping)
+        {
+        mappedFile->Data = static_cast<char*>(MapViewOfFile(mappedFile->Mapping, FILE_MAP_COPY, 0, 0, 0));
+        }
+      }
+#else
+    int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd < 0 || fstat(fd, &fileStat) != 0)
+      {
+      if (fd >= 0)
+        {
+        close(fd);
+        }
+      delete mappedFile;
+      return NULL;
+      }
+    mappedFile->Size = static_cast<vtkTypeUInt64>(fileStat.st_size);
+    if (mappedFile->Size > 0)
+      {
+      void* data = mmap(NULL, static_cast<size_t>(mappedFile->Size),
+        PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      mappedFile->Data = (data == MAP_FAILED ? NULL : static_cast<char*>(data));
+      }
+    // the mapping remains valid after the file is closed
+    close(fd);
+#endif
+    if (!mappedFile->Data)
+      {
+      delete mappedFile;
+      return NULL;
+      }
+    return mappedFile;
+    }
+
+  void Register()
+    {
+    ++this->ReferenceCount;
+    }
+  void UnRegister()
+    {
+    if (--this->ReferenceCount == 0)
+      {
+      delete this;
+      }
+    }
+
+  char* GetData() const { return this->Data; }
+  vtkTypeUInt64 GetSize() const { return this->Size; }
+
+  /// Keep the file mapped for the lifetime of the array
+  void AttachToArray(vtkDataArray* array)
+    {
+    vtkNew<vtkCallbackCommand> releaseCallback;
+    releaseCallback->SetCallback(MappedTableFile::ArrayDeleted);
+    releaseCallback->SetClientData(this);
+    unsigned long tag = array->AddObserver(vtkCommand::DeleteEvent, releaseCallback.GetPointer());
+    this->Arrays.push_back(AttachedArray(array, tag));
+    this->Register();
+    }
+
+  /// Copy the values of the arrays still pointing into the mappings of
+  /// \a fileName to memory and unmap the file, so that it can be replaced.
+  /// A mapped file cannot be deleted or overwritten on Windows.
+  static void Release(const std::string& fileName)
+    {
+    std::map<std::string, std::set<MappedTableFile*> >::iterator it =
+      GetMappedFiles().find(vtksys::SystemTools::CollapseFullPath(fileName));
+    if (it == GetMappedFiles().end())
+      {
+      return;
+      }
+    // mappings are removed from the set when deleted
+    std::set<MappedTableFile*> mappedFiles = it->second;
+    for (std::set<MappedTableFile*>::iterator mappedFileIt = mappedFiles.begin();
+         mappedFileIt != mappedFiles.end(); ++mappedFileIt)
+      {
+      (*mappedFileIt)->DetachArrays();
+      }
+    }
+
+protected:
+  MappedTableFile()
+    : ReferenceCount(1)
+    , Data(NULL)
+    , Size(0)
+#ifdef _WIN32
+    , File(INVALID_HANDLE_VALUE)
+    , Mapping(NULL)
+#endif
+    {
+    }
+
+  ~MappedTableFile()
+    {
+    std::set<MappedTableFile*>& mappedFiles = GetMappedFiles()[this->FileName];
+    mappedFiles.erase(this);
+    if (mappedFiles.empty())
+      {
+      GetMappedFiles().erase(this->FileName);
+      }
+#ifdef _WIN32
+    if (this->Data)
+      {
+      UnmapViewOfFile(this->Data);
+      }
+    if (this->Mapping)
+      {
+      CloseHandle(this->Mapping);
+      }
+    if (this->File != INVALID_HANDLE_VALUE)
+      {
+      CloseHandle(this->File);
+      }
+#else
+    if (this->Data)
+      {
+      munmap(this->Data, static_cast<size_t>(this->Size));
+      }
+#endif
+    }
+
+  static void ArrayDeleted(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                           void* clientData, void* vtkNotUsed(callData))
+    {
+    static_cast<MappedTableFile*>(clientData)->UnRegister();
+    }
+
+  /// Mappings of each file (by full path)
+  static std::map<std::string, std::set<MappedTableFile*> >& GetMappedFiles()
+    {
+    static std::map<std::string, std::set<MappedTableFile*> > mappedFiles;
+    return mappedFiles;
+    }
+
+  void DetachArrays()
+    {
+    // the last array may release the mapping
+    this->Register();
+    std::vector<AttachedArray> arrays;
+    arrays.swap(this->Arrays);
+    for (std::vector<AttachedArray>::iterator it = arrays.begin(); it != arrays.end(); ++it)
+      {
+      vtkDataArray* array = it->first;
+      if (!array)
+        {
+        // already deleted
+        continue;
+        }
+      array->RemoveObserver(it->second);
+      char* values = static_cast<char*>(array->GetVoidPointer(0));
+      if (values >= this->Data && values < this->Data + this->Size)
+        {
+        // the array owns the copy
+        vtkIdType numberOfTuples = array->GetNumberOfTuples();
+        vtkIdType size = array->GetSize();
+        if (array->GetDataType() == VTK_BIT)
+          {
+          size_t numberOfBytes = static_cast<size_t>((size + 7) / 8);
+          unsigned char* copy = new unsigned char[numberOfBytes];
+          memcpy(copy, values, numberOfBytes);
+          static_cast<vtkBitArray*>(array)->SetArray(copy, size, 0);
+          }
+        else
+          {
+          size_t numberOfBytes = static_cast<size_t>(size) * array->GetDataTypeSize();
+          void* copy = malloc(numberOfBytes);
+          memcpy(copy, values, numberOfBytes);
+          array->SetVoidArray(copy, size, 0);
+          }
+        array->SetNumberOfTuples(numberOfTuples);
+        }
+      this->UnRegister();
+      }
+    this->UnRegister();
+    }
+
+  typedef std::pair<vtkWeakPointer<vtkDataArray>, unsigned long> AttachedArray;
+
+  std::string FileName;
+  std::vector<AttachedArray> Arrays;
+  int ReferenceCount;
+  char* Data;
+  vtkTypeUInt64 Size;
+#ifdef _WIN32
+  HANDLE File;
+  HANDLE Mapping;
+#endif
+};
+
+//----------------------------------------------------------------------------
+bool WriteBytes(FILE* file, const void* data, vtkTypeUInt64 size, vtkTypeUInt64& offset)
+{
+  if (size == 0)
+    {
+    return true;
+    }
+  if (fwrite(data, 1, static_cast<size_t>(size), file) != static_cast<size_t>(size))
+    {
+    return false;
+    }
+  offset += size;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool WritePadding(FILE* file, vtkTypeUInt64& offset)
+{
+  static const char zeros[BinaryTableAlignment] = { 0 };
+  vtkTypeUInt64 padding = (BinaryTableAlignment - offset % BinaryTableAlignment) % BinaryTableAlignment;
+  return WriteBytes(file, zeros, padding, offset);
+}
+
+//----------------------------------------------------------------------------
+// Writes the data blocks of all columns followed by the directory.
+bool WriteBinaryColumns(FILE* file, vtkTable* table, vtkTypeUInt64& offset,
+                        vtkTypeUInt64& directoryOffset)
+{
+  std::vector<BinaryColumnDescriptor> descriptors;
+  std::vector<std::string> names;
+  for (int col = 0; col < table->GetNumberOfColumns(); ++col)
+    {
+    vtkAbstractArray* column = table->GetColumn(col);
+    if (column == NULL || !column->GetName())
+      {
+      // invalid column
+      continue;
+      }
+    if (!WritePadding(file, offset))
+      {
+      return false;
+      }
+    BinaryColumnDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    descriptor.NumberOfComponents = column->GetNumberOfComponents();
+    descriptor.NumberOfTuples = column->GetNumberOfTuples();
+    descriptor.DataOffset = offset;
+    vtkTypeUInt64 numberOfValues = static_cast<vtkTypeUInt64>(descriptor.NumberOfTuples) * descriptor.NumberOfComponents;
+    vtkDataArray* dataArray = vtkDataArray::SafeDownCast(column);
+    bool success = true;
+    if (dataArray)
+      {
+      // numeric values are written as they are in memory
+      descriptor.DataType = dataArray->GetDataType();
+      vtkTypeUInt64 dataSize = 0;
+      if (descriptor.DataType == VTK_BIT)
+        {
+        dataSize = (numberOfValues + 7) / 8;
+        }
+      else
+        {
+        descriptor.ValueSize = dataArray->GetDataTypeSize();
+        dataSize = numberOfValues * descriptor.ValueSize;
+        }
+      success = (dataSize == 0 || WriteBytes(file, dataArray->GetVoidPointer(0), dataSize, offset));
+      }
+    else
+      {
+      // string (or variant) values: end offset of each value, then characters
+      descriptor.DataType = VTK_STRING;
+      vtkStringArray* stringArray = vtkStringArray::SafeDownCast(column);
+      std::vector<vtkTypeUInt64> valueEnds(static_cast<size_t>(numberOfValues));
+      std::string characters;
+      for (vtkIdType valueIndex = 0; valueIndex < static_cast<vtkIdType>(numberOfValues); ++valueIndex)
+        {
+        if (stringArray)
+          {
+          characters += stringArray->GetValue(valueIndex);
+          }
+        else
+          {
+          characters += column->GetVariantValue(valueIndex).ToString();
+          }
+        valueEnds[valueIndex] = characters.size();
+        }
+      success = (numberOfValues == 0
+        || WriteBytes(file, &valueEnds[0], numberOfValues * sizeof(vtkTypeUInt64), offset))
+        && WriteBytes(file, characters.data(), characters.size(), offset);
+      }
+    if (!success)
+      {
+      return false;
+      }
+    descriptor.DataSize = offset - descriptor.DataOffset;
+    descriptor.NameLength = static_cast<vtkTypeUInt32>(strlen(column->GetName()));
+    descriptors.push_back(descriptor);
+    names.push_back(column->GetName());
+    }
+
+  if (!WritePadding(file, offset))
+    {
+    return false;
+    }
+  directoryOffset = offset;
+  BinaryTableDirectoryHeader directoryHeader;
+  memset(&directoryHeader, 0, sizeof(directoryHeader));
+  directoryHeader.NumberOfColumns = static_cast<vtkTypeUInt32>(descriptors.size());
+  directoryHeader.NumberOfRows = table->GetNumberOfRows();
+  if (!WriteBytes(file, &directoryHeader, sizeof(directoryHeader), offset))
+    {
+    return false;
+    }
+  for (size_t col = 0; col < descriptors.size(); ++col)
+    {
+    if (!WriteBytes(file, &descriptors[col], sizeof(BinaryColumnDescriptor), offset)
+      || !WriteBytes(file, names[col].data(), names[col].size(), offset))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Creates the columns described by the directory at directoryOffset.
+// Numeric columns point directly into the mapped file.
+bool ReadBinaryColumns(MappedTableFile* mappedFile, vtkTypeUInt64 directoryOffset,
+                       vtkTable* table, std::string& errorMessage)
+{
+  const char* data = mappedFile->GetData();
+  vtkTypeUInt64 fileSize = mappedFile->GetSize();
+  if (directoryOffset + sizeof(BinaryTableDirectoryHeader) > fileSize)
+    {
+    errorMessage = "invalid directory offset";
+    return false;
+    }
+  BinaryTableDirectoryHeader directoryHeader;
+  memcpy(&directoryHeader, data + directoryOffset, sizeof(directoryHeader));
+  vtkTypeUInt64 position = directoryOffset + sizeof(directoryHeader);
+  for (vtkTypeUInt32 col = 0; col < directoryHeader.NumberOfColumns; ++col)
+    {
+    BinaryColumnDescriptor descriptor;
+    if (position + sizeof(descriptor) > fileSize)
+      {
+      errorMessage = "truncated column directory";
+      return false;
+      }
+    memcpy(&descriptor, data + position, sizeof(descriptor));
+    position += sizeof(descriptor);
+    if (position + descriptor.NameLength > fileSize
+      || descriptor.DataOffset + descriptor.DataSize > fileSize
+      || descriptor.NumberOfTuples < 0 || descriptor.NumberOfComponents < 1)
+      {
+      errorMessage = "invalid column descriptor";
+      return false;
+      }
+    std::string columnName(data + position, descriptor.NameLength);
+    position += descriptor.NameLength;
+    vtkTypeUInt64 numberOfValues = static_cast<vtkTypeUInt64>(descriptor.NumberOfTuples) * descriptor.NumberOfComponents;
+    char* columnData = mappedFile->GetData() + descriptor.DataOffset;
+
+    vtkSmartPointer<vtkAbstractArray> column;
+    if (descriptor.DataType == VTK_STRING)
+      {
+      vtkTypeUInt64 valueEndsSize = numberOfValues * sizeof(vtkTypeUInt64);
+      if (descriptor.DataSize < valueEndsSize)
+        {
+        errorMessage = "invalid size of column " + columnName;
+        return false;
+        }
+      const vtkTypeUInt64* valueEnds = reinterpret_cast<const vtkTypeUInt64*>(columnData);
+      const char* characters = columnData + valueEndsSize;
+      vtkTypeUInt64 charactersSize = descriptor.DataSize - valueEndsSize;
+      vtkSmartPointer<vtkStringArray> stringColumn = vtkSmartPointer<vtkStringArray>::New();
+      stringColumn->SetNumberOfComponents(descriptor.NumberOfComponents);
+      stringColumn->SetNumberOfValues(static_cast<vtkIdType>(numberOfValues));
+      vtkTypeUInt64 valueStart = 0;
+      for (vtkIdType valueIndex = 0; valueIndex < static_cast<vtkIdType>(numberOfValues); ++valueIndex)
+        {
+        vtkTypeUInt64 valueEnd = valueEnds[valueIndex];
+        if (valueEnd < valueStart || valueEnd > charactersSize)
+          {
+          errorMessage = "invalid string offsets in column " + columnName;
+          return false;
+          }
+        stringColumn->SetValue(valueIndex, vtkStdString(characters + valueStart, valueEnd - valueStart));
+        valueStart = valueEnd;
+        }
+      column = stringColumn;
+      }
+    else
+      {
+      vtkSmartPointer<vtkDataArray> dataColumn = vtkSmartPointer<vtkDataArray>::Take(
+        vtkDataArray::CreateDataArray(descriptor.DataType));
+      if (!dataColumn)
+        {
+        errorMessage = "unsupported data type in column " + columnName;
+        return false;
+        }
+      vtkTypeUInt64 expectedSize = (descriptor.DataType == VTK_BIT) ? (numberOfValues + 7) / 8
+        : numberOfValues * dataColumn->GetDataTypeSize();
+      if ((descriptor.DataType != VTK_BIT && descriptor.ValueSize != dataColumn->GetDataTypeSize())
+        || descriptor.DataSize != expectedSize)
+        {
+        errorMessage = "invalid size of column " + columnName;
+        return false;
+        }
+      dataColumn->SetNumberOfComponents(descriptor.NumberOfComponents);
+      if (numberOfValues > 0)
+        {
+        // the array does not own the memory, the mapping is released with the array
+        dataColumn->SetVoidArray(columnData, static_cast<vtkIdType>(numberOfValues), 1);
+        mappedFile->AttachToArray(dataColumn);
+        }
+      column = dataColumn;
+      }
+    column->SetName(columnName.c_str());
+    table->AddColumn(column);
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLTableStorageNode);
 
@@ -86,6 +585,18 @@ int vtkMRMLTableStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  if (this->IsBinaryTableFileName(fullName))
+    {
+    // schema is embedded in binary tables
+    if (!this->ReadBinaryTable(fullName, tableNode))
+      {
+      vtkErrorMacro("ReadData: failed to read table from '" << fullName << "'");
+      return 0;
+      }
+    vtkDebugMacro("ReadData: successfully read table from file: " << fullName);
+    return 1;
+    }
+
   if (this->GetSchemaFileName().empty() && this->AutoFindSchema)
     {
     this->SetSchemaFileName(this->FindSchemaFileName(fullName.c_str()).c_str());
@@ -131,6 +642,19 @@ int vtkMRMLTableStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  if (this->IsBinaryTableFileName(fullName))
+    {
+    // schema is embedded in binary tables, no separate schema file
+    this->ResetFileNameList();
+    if (!this->WriteBinaryTable(fullName, tableNode))
+      {
+      vtkErrorMacro("WriteData: failed to write table node " << refNode->GetID() << " to file " << fullName);
+      return 0;
+      }
+    vtkDebugMacro("WriteData: successfully wrote table to file: " << fullName);
+    return 1;
+    }
+
   if (!this->WriteTable(fullName, tableNode))
     {
     vtkErrorMacro("WriteData: failed to write table node " << refNode->GetID() << " to file " << fullName);
@@ -181,6 +705,7 @@ void vtkMRMLTableStorageNode::InitializeSupportedReadFileTypes()
   this->SupportedReadFileTypes->InsertNextValue("Tab-separated values (.tsv)");
   this->SupportedReadFileTypes->InsertNextValue("Comma-separated values (.csv)");
   this->SupportedReadFileTypes->InsertNextValue("Text (.txt)");
+  this->SupportedReadFileTypes->InsertNextValue("Binary columnar table (.stbl)");
 }
 
 //----------------------------------------------------------------------------
@@ -189,6 +714,7 @@ void vtkMRMLTableStorageNode::InitializeSupportedWriteFileTypes()
   this->SupportedWriteFileTypes->InsertNextValue("Tab-separated values (.tsv)");
   this->SupportedWriteFileTypes->InsertNextValue("Comma-separated values (.csv)");
   this->SupportedWriteFileTypes->InsertNextValue("Text (.txt)");
+  this->SupportedWriteFileTypes->InsertNextValue("Binary columnar table (.stbl)");
 }
 
 //----------------------------------------------------------------------------
@@ -445,7 +971,36 @@ bool vtkMRMLTableStorageNode::WriteTable(std::string filename, vtkMRMLTableNode*
 bool vtkMRMLTableStorageNode::WriteSchema(std::string filename, vtkMRMLTableNode* tableNode)
 {
   vtkNew<vtkTable> schemaTable;
+  this->FillSchemaTable(schemaTable.GetPointer(), tableNode);
+
+  vtkNew<vtkDelimitedTextWriter> writer;
+  writer->SetFileName(filename.c_str());
+  writer->SetInputData(schemaTable.GetPointer());
+
+  std::string delimiter = this->GetFieldDelimiterCharacters(filename);
+  writer->SetFieldDelimiter(delimiter.c_str());
+
+  // SetUseStringDelimiter(true) causes writing each value in double-quotes, which is not very nice,
+  // but if the delimiter character is the comma then we have to use this mode, as commas occur in
+  // string values quite often.
+  writer->SetUseStringDelimiter(delimiter == ",");
+
+  try
+    {
+    writer->Write();
+    }
+  catch (...)
+    {
+    vtkErrorMacro("vtkMRMLTableStorageNode::WriteSchema: failed to write file: " << filename);
+    return false;
+    }
 
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLTableStorageNode::FillSchemaTable(vtkTable* schemaTable, vtkMRMLTableNode* tableNode)
+{
   // Create a copy, as it is nice if writing to file has a side effect of modifying some
   // data in the node
   if (tableNode->GetSchema())
@@ -487,7 +1042,7 @@ bool vtkMRMLTableStorageNode::WriteSchema(std::string filename, vtkMRMLTableNode
         }
       if (!column->GetName())
         {
-        vtkWarningMacro("vtkMRMLTableStorageNode::WriteSchema: empty column name in file: " << filename << ", skipping column");
+        vtkWarningMacro("vtkMRMLTableStorageNode::FillSchemaTable: empty column name, skipping column");
         continue;
         }
 
@@ -500,28 +1055,130 @@ bool vtkMRMLTableStorageNode::WriteSchema(std::string filename, vtkMRMLTableNode
       columnTypeArray->SetValue(schemaRowIndex, vtkImageScalarTypeNameMacro(column->GetDataType()));
       }
     }
+}
 
-  vtkNew<vtkDelimitedTextWriter> writer;
-  writer->SetFileName(filename.c_str());
-  writer->SetInputData(schemaTable.GetPointer());
+//----------------------------------------------------------------------------
+bool vtkMRMLTableStorageNode::IsBinaryTableFileName(const std::string& filename)
+{
+  return vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(filename) == std::string(".stbl");
+}
 
-  std::string delimiter = this->GetFieldDelimiterCharacters(filename);
-  writer->SetFieldDelimiter(delimiter.c_str());
+//----------------------------------------------------------------------------
+bool vtkMRMLTableStorageNode::ReadBinaryTable(std::string filename, vtkMRMLTableNode* tableNode)
+{
+  MappedTableFile* mappedFile = MappedTableFile::Map(filename);
+  if (!mappedFile)
+    {
+    vtkErrorMacro("vtkMRMLTableStorageNode::ReadBinaryTable: failed to map file: " << filename);
+    return false;
+    }
 
-  // SetUseStringDelimiter(true) causes writing each value in double-quotes, which is not very nice,
-  // but if the delimiter character is the comma then we have to use this mode, as commas occur in
-  // string values quite often.
-  writer->SetUseStringDelimiter(delimiter == ",");
+  BinaryTableHeader header;
+  if (mappedFile->GetSize() < sizeof(header))
+    {
+    vtkErrorMacro("vtkMRMLTableStorageNode::ReadBinaryTable: file is too small: " << filename);
+    mappedFile->UnRegister();
+    return false;
+    }
+  memcpy(&header, mappedFile->GetData(), sizeof(header));
+  if (memcmp(header.Magic, BinaryTableMagic, sizeof(BinaryTableMagic)) != 0
+    || header.Version != BinaryTableVersion)
+    {
+    vtkErrorMacro("vtkMRMLTableStorageNode::ReadBinaryTable: not a binary table file: " << filename);
+    mappedFile->UnRegister();
+    return false;
+    }
+  if (header.ByteOrderMark != BinaryTableByteOrderMark)
+    {
+    vtkErrorMacro("vtkMRMLTableStorageNode::ReadBinaryTable: file was written with a different byte order: " << filename);
+    mappedFile->UnRegister();
+    return false;
+    }
 
-  try
+  std::string errorMessage;
+  vtkSmartPointer<vtkTable> schemaTable;
+  if (header.SchemaDirectoryOffset != 0)
     {
-    writer->Write();
+    schemaTable = vtkSmartPointer<vtkTable>::New();
+    if (!ReadBinaryColumns(mappedFile, header.SchemaDirectoryOffset, schemaTable, errorMessage))
+      {
+      vtkErrorMacro("vtkMRMLTableStorageNode::ReadBinaryTable: failed to read schema from file: "
+        << filename << ": " << errorMessage);
+      mappedFile->UnRegister();
+      return false;
+      }
     }
-  catch (...)
+  vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::New();
+  bool success = ReadBinaryColumns(mappedFile, header.TableDirectoryOffset, table, errorMessage);
+  // columns hold their own reference to the mapping
+  mappedFile->UnRegister();
+  if (!success)
     {
-    vtkErrorMacro("vtkMRMLTableStorageNode::WriteSchema: failed to write file: " << filename);
+    vtkErrorMacro("vtkMRMLTableStorageNode::ReadBinaryTable: failed to read table from file: "
+      << filename << ": " << errorMessage);
     return false;
     }
 
+  tableNode->SetAndObserveSchema(schemaTable);
+  tableNode->SetAndObserveTable(table);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLTableStorageNode::WriteBinaryTable(std::string filename, vtkMRMLTableNode* tableNode)
+{
+  vtkTable* table = tableNode->GetTable();
+  if (!table)
+    {
+    vtkErrorMacro("vtkMRMLTableStorageNode::WriteBinaryTable: no table to write");
+    return false;
+    }
+  vtkNew<vtkTable> schemaTable;
+  this->FillSchemaTable(schemaTable.GetPointer(), tableNode);
+
+  // Write to a temporary file then replace the destination: columns of a
+  // previously read version of the file may still be mapped in memory.
+  std::string temporaryFileName = filename + ".part";
+  FILE* file = fopen(temporaryFileName.c_str(), "wb");
+  if (!file)
+    {
+    vtkErrorMacro("vtkMRMLTableStorageNode::WriteBinaryTable: failed to open file: " << temporaryFileName);
+    return false;
+    }
+
+  BinaryTableHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.Magic, BinaryTableMagic, sizeof(BinaryTableMagic));
+  header.ByteOrderMark = BinaryTableByteOrderMark;
+  header.Version = BinaryTableVersion;
+  vtkTypeUInt64 offset = 0;
+  bool success = WriteBytes(file, &header, sizeof(header), offset)
+    && WriteBinaryColumns(file, table, offset, header.TableDirectoryOffset)
+    && WriteBinaryColumns(file, schemaTable.GetPointer(), offset, header.SchemaDirectoryOffset);
+  // now that directory offsets are known, rewrite the header
+  success = success && fseek(file, 0, SEEK_SET) == 0
+    && fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+  success = (fclose(file) == 0) && success;
+  if (!success)
+    {
+    vtkErrorMacro("vtkMRMLTableStorageNode::WriteBinaryTable: failed to write file: " << temporaryFileName);
+    vtksys::SystemTools::RemoveFile(temporaryFileName);
+    return false;
+    }
+
+  // Columns read from the file are copied to memory before the file is
+  // replaced, a mapped file cannot be replaced on Windows.
+  MappedTableFile::Release(filename);
+#ifdef _WIN32
+  bool replaced = MoveFileExA(temporaryFileName.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  bool replaced = rename(temporaryFileName.c_str(), filename.c_str()) == 0;
+#endif
+  if (!replaced)
+    {
+    vtkErrorMacro("vtkMRMLTableStorageNode::WriteBinaryTable: failed to rename " << temporaryFileName << " to " << filename);
+    vtksys::SystemTools::RemoveFile(temporaryFileName);
+    return false;
+    }
   return true;
 }
@@ -26,6 +26,7 @@
 #include "vtkMRMLStorageNode.h"
 
 class vtkMRMLTableNode;
+class vtkTable;
 
 /// \brief MRML node for handling Table node storage
 ///
@@ -40,6 +41,13 @@ class vtkMRMLTableNode;
 /// Values in comma-separated files may not contain quotation marks but may contain
 /// any other characters (including commas and tabs).
 ///
+/// If the file extension is .stbl then the table is stored in binary columnar
+/// format: each column is written as a contiguous block of values in its native
+/// type and the schema is embedded in the file, so no separate schema file is used.
+/// When reading, numeric columns are memory-mapped from the file (copy-on-write)
+/// instead of being parsed. String columns are stored as value end offsets followed
+/// by the characters of all values.
+///
 class VTK_MRML_EXPORT vtkMRMLTableStorageNode : public vtkMRMLStorageNode
 {
 public:
@@ -96,6 +104,15 @@ protected:
   bool WriteTable(std::string filename, vtkMRMLTableNode* tableNode);
   bool WriteSchema(std::string filename, vtkMRMLTableNode* tableNode);
 
+  /// Fill schemaTable with the schema of the table node, including column types
+  void FillSchemaTable(vtkTable* schemaTable, vtkMRMLTableNode* tableNode);
+
+  /// Returns true if the file name has the binary columnar table extension (.stbl)
+  bool IsBinaryTableFileName(const std::string& filename);
+
+  bool ReadBinaryTable(std::string filename, vtkMRMLTableNode* tableNode);
+  bool WriteBinaryTable(std::string filename, vtkMRMLTableNode* tableNode);
+
   bool AutoFindSchema;
 };
 
@@ -23,6 +23,7 @@ Version:   $Revision: 1.14 $
 #include <vtkAppendPolyData.h>
 #include <vtkBoundingBox.h>
 #include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
 #include <vtkEventForwarderCommand.h>
 #include <vtkGeneralTransform.h>
 #include <vtkHomogeneousTransform.h>
@@ -32,6 +33,7 @@ Version:   $Revision: 1.14 $
 #include <vtkMathUtilities.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
+#include <vtkPointData.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransform.h>
 #include <vtkTrivialProducer.h>
@@ -66,6 +68,7 @@ vtkMRMLVolumeNode::vtkMRMLVolumeNode()
 
   this->ImageDataConnection = NULL;
   this->DataEventForwarder = NULL;
+  this->ImageDataModifiedEventDeferred = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -781,7 +784,7 @@ void vtkMRMLVolumeNode
 
   this->StorableModifiedTime.Modified();
   this->Modified();
-  this->InvokeEvent( vtkMRMLVolumeNode::ImageDataModifiedEvent , this);
+  this->InvokeImageDataModifiedEvent(this);
 }
 
 //---------------------------------------------------------------------------
@@ -852,13 +855,121 @@ void vtkMRMLVolumeNode::ProcessMRMLEvents ( vtkObject *caller,
       this->ImageDataConnection->GetProducer() == vtkAlgorithm::SafeDownCast(caller) &&
     event ==  vtkCommand::ModifiedEvent)
     {
-    this->InvokeEvent(vtkMRMLVolumeNode::ImageDataModifiedEvent, NULL);
+    this->InvokeImageDataModifiedEvent(NULL);
     return;
     }
 
   return;
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeNode::InvokeImageDataModifiedEvent(void* callData)
+{
+  if (this->ImageDataModifiedEventDeferred > 0)
+    {
+    this->InvokeCustomModifiedEvent(vtkMRMLVolumeNode::ImageDataModifiedEvent, callData);
+    }
+  else
+    {
+    this->InvokeEvent(vtkMRMLVolumeNode::ImageDataModifiedEvent, callData);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeNode::ImageDataModified()
+{
+  vtkImageData* imageData = this->GetImageData();
+  if (!imageData)
+    {
+    return;
+    }
+  int wasModifying = this->StartModify();
+  ++this->ImageDataModifiedEventDeferred;
+  vtkPointData* pointData = imageData->GetPointData();
+  if (pointData->GetScalars())
+    {
+    pointData->GetScalars()->Modified();
+    }
+  if (pointData->GetTensors())
+    {
+    pointData->GetTensors()->Modified();
+    }
+  // Forwarded to the producer, which invokes ImageDataModifiedEvent
+  imageData->Modified();
+  this->Modified();
+  --this->ImageDataModifiedEventDeferred;
+  this->EndModify(wasModifying);
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLVolumeNode::ReshapeImageData(const int dimensions[3], int scalarType, int numberOfComponents,
+                                         bool* bufferReused/*=NULL*/)
+{
+  if (bufferReused)
+    {
+    *bufferReused = false;
+    }
+  if (dimensions[0] < 0 || dimensions[1] < 0 || dimensions[2] < 0 || numberOfComponents < 1)
+    {
+    vtkErrorMacro("ReshapeImageData: invalid dimensions or number of components");
+    return false;
+    }
+  vtkSmartPointer<vtkDataArray> newScalars;
+  vtkImageData* imageData = this->GetImageData();
+  vtkDataArray* scalars = imageData ? imageData->GetPointData()->GetScalars() : NULL;
+  if (!scalars || scalars->GetDataType() != scalarType)
+    {
+    newScalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(scalarType));
+    if (!newScalars)
+      {
+      vtkErrorMacro("ReshapeImageData: invalid scalar type " << scalarType);
+      return false;
+      }
+    }
+
+  int wasModifying = this->StartModify();
+  ++this->ImageDataModifiedEventDeferred;
+  if (!imageData)
+    {
+    vtkNew<vtkImageData> newImageData;
+    this->SetAndObserveImageData(newImageData.GetPointer());
+    imageData = this->GetImageData();
+    }
+
+  vtkIdType numberOfTuples = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  if (newScalars)
+    {
+    if (scalars && scalars->GetName())
+      {
+      newScalars->SetName(scalars->GetName());
+      }
+    newScalars->SetNumberOfComponents(numberOfComponents);
+    newScalars->SetNumberOfTuples(numberOfTuples);
+    imageData->GetPointData()->SetScalars(newScalars);
+    }
+  else if (static_cast<vtkIdType>(scalars->GetNumberOfComponents()) * scalars->GetNumberOfTuples()
+    == static_cast<vtkIdType>(numberOfComponents) * numberOfTuples)
+    {
+    // Same values, only the number of components may change
+    scalars->SetNumberOfComponents(numberOfComponents);
+    if (bufferReused)
+      {
+      *bufferReused = true;
+      }
+    }
+  else
+    {
+    scalars->SetNumberOfComponents(numberOfComponents);
+    scalars->SetNumberOfTuples(numberOfTuples);
+    }
+  imageData->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+
+  this->ImageDataModified();
+  --this->ImageDataModifiedEventDeferred;
+  this->EndModify(wasModifying);
+  return true;
+}
+
 //---------------------------------------------------------------------------
 vtkMRMLVolumeDisplayNode* vtkMRMLVolumeNode::GetVolumeDisplayNode()
 {
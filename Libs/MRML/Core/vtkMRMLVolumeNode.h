@@ -179,6 +179,25 @@ public:
   /// Return the input image data pipeline.
   vtkGetObjectMacro(ImageDataConnection, vtkAlgorithmOutput);
 
+  /// Notify that the voxels of the image data have been changed in place (e.g.,
+  /// through a numpy array that shares the scalars buffer). The scalars and the
+  /// image data are marked as modified, and ImageDataModifiedEvent and ModifiedEvent
+  /// are invoked. Between StartModify() and EndModify() the events are invoked only
+  /// once, by EndModify().
+  virtual void ImageDataModified();
+
+  /// Change the dimensions, scalar type and number of components of the image data
+  /// in place: the image data object is kept (an image data is created if there is none),
+  /// so pipelines and observers remain valid.
+  /// The scalars buffer is reused if the scalar type and the number of values are unchanged
+  /// (only the interpretation of the voxels changes). If the type is unchanged but the
+  /// size is different then the scalars array is resized, otherwise a new array is allocated.
+  /// Voxel values are not initialized.
+  /// Invokes events as ImageDataModified().
+  /// \param bufferReused If not NULL then it is set to true if the scalars buffer was reused.
+  /// \return false if the dimensions, scalar type or number of components are invalid.
+  bool ReshapeImageData(const int dimensions[3], int scalarType, int numberOfComponents, bool* bufferReused=NULL);
+
   ///
   /// Make sure image data of a volume node has extents that start at zero.
   /// This needs to be done for compatibility reasons, as many components assume the extent has a form of
@@ -238,6 +257,11 @@ protected:
   /// the useTransform parameter and the rasToSlice transform
   virtual void GetBoundsInternal(double bounds[6], vtkMatrix4x4* rasToSlice, bool useTransform);
 
+  /// Invoke ImageDataModifiedEvent immediately, or only once by EndModify()
+  /// when called from ImageDataModified() or ReshapeImageData() while the
+  /// node is being modified.
+  void InvokeImageDataModifiedEvent(void* callData);
+
   /// these are unit length direction cosines
   double IJKToRASDirections[3][3];
 
@@ -248,6 +272,9 @@ protected:
   vtkAlgorithmOutput* ImageDataConnection;
   vtkEventForwarderCommand* DataEventForwarder;
 
+  /// Number of nested ImageDataModified() and ReshapeImageData() calls
+  int ImageDataModifiedEventDeferred;
+
   itk::MetaDataDictionary Dictionary;
 };
 
@@ -23,6 +23,7 @@
 #include <vtkEventBroker.h>
 #include <vtkMRMLDisplayableNode.h>
 #include <vtkMRMLDisplayNode.h>
+#include <vtkMRMLGlyphableVolumeSliceDisplayNode.h>
 #include <vtkMRMLModelDisplayNode.h>
 #include <vtkMRMLModelHierarchyNode.h>
 #include <vtkMRMLModelNode.h>
@@ -49,6 +50,7 @@
 #include <vtkDataSetAttributes.h>
 #include <vtkDataSetMapper.h>
 #include <vtkGeneralTransform.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
 #include <vtkImageMapper3D.h>
@@ -963,6 +965,12 @@ void vtkMRMLModelDisplayableManager
       }
     bool hasMesh = (meshConnection != 0);
 
+    // Glyph instances are rendered with the glyph geometry
+    vtkMRMLGlyphableVolumeSliceDisplayNode* glyphDisplayNode =
+      vtkMRMLGlyphableVolumeSliceDisplayNode::SafeDownCast(modelDisplayNode);
+    vtkAlgorithmOutput* glyphSourceConnection = (glyphDisplayNode && !hdnode) ?
+      glyphDisplayNode->GetOutputGlyphSourceConnection() : NULL;
+
     if (!hasMesh)
       {
       continue;
@@ -1012,7 +1020,13 @@ void vtkMRMLModelDisplayableManager
         // caches information to skip steps if the display node has already rendered. but we
         // can have rendered a display node but not rendered its current mesh.
         vtkActor *actor = vtkActor::SafeDownCast(prop);
-        if (actor)
+        vtkGlyph3DMapper* glyphMapper = actor ? vtkGlyph3DMapper::SafeDownCast(actor->GetMapper()) : NULL;
+        bool glyphMapperChanged = (glyphMapper != NULL) != (glyphSourceConnection != NULL);
+        if (glyphMapper && glyphSourceConnection)
+          {
+          glyphMapper->SetSourceConnection(glyphSourceConnection);
+          }
+        if (actor && !glyphMapperChanged)
           {
           vtkMapper *mapper = actor->GetMapper();
 
@@ -1028,7 +1042,8 @@ void vtkMRMLModelDisplayableManager
         vtkMRMLTransformNode* tnode = displayableNode->GetParentTransformNode();
         // clipped model could be transformed
         // TODO: handle non-linear transforms
-        if (clipping == 0 || tnode == 0 || !tnode->IsTransformToWorldLinear())
+        if (!glyphMapperChanged &&
+            (clipping == 0 || tnode == 0 || !tnode->IsTransformToWorldLinear()))
           {
           continue;
           }
@@ -1046,7 +1061,19 @@ void vtkMRMLModelDisplayableManager
         }
 
       vtkMapper *mapper = NULL;
-      if (meshType == vtkMRMLModelNode::UnstructuredGridMeshType)
+      if (glyphSourceConnection)
+        {
+        // Instances generated by vtkDiffusionTensorGlyph
+        vtkGlyph3DMapper* glyphMapper = vtkGlyph3DMapper::New();
+        glyphMapper->SetSourceConnection(glyphSourceConnection);
+        glyphMapper->SetScaleModeToScaleByVectorComponents();
+        glyphMapper->SetScaleArray("GlyphScale");
+        glyphMapper->OrientOn();
+        glyphMapper->SetOrientationModeToRotation();
+        glyphMapper->SetOrientationArray("GlyphOrientation");
+        mapper = glyphMapper;
+        }
+      else if (meshType == vtkMRMLModelNode::UnstructuredGridMeshType)
         {
         mapper = vtkDataSetMapper::New();
         }
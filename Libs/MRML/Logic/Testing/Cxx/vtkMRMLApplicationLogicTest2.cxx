@@ -0,0 +1,132 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkArchive.h"
+#include "vtkMRMLApplicationLogic.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLVolumeArchetypeStorageNode.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// ITK includes
+#include <itkConfigure.h>
+#include <itkFactoryRegistration.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+
+//-----------------------------------------------------------------------------
+// Load a bundle whose volume is a detached .nhdr header: the data file it
+// refers to does not share its name. All files of the bundle are extracted,
+// including the ones that are not referenced by the scene.
+int vtkMRMLApplicationLogicTest2(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::itkFactoryRegistration();
+
+  std::string testDir = vtksys::SystemTools::CollapseFullPath(argv[1]) + "/vtkMRMLApplicationLogicTest2";
+  std::string bundleDir = testDir + "/Bundle";
+  std::string extractDir = testDir + "/Extract";
+  vtksys::SystemTools::RemoveADirectory(testDir.c_str());
+  vtksys::SystemTools::MakeDirectory((bundleDir + "/Data/voxels").c_str());
+  vtksys::SystemTools::MakeDirectory(extractDir.c_str());
+
+  {
+  std::ofstream header((bundleDir + "/Data/head.nhdr").c_str());
+  header << "NRRD0004\n"
+         << "type: unsigned char\n"
+         << "dimension: 3\n"
+         << "sizes: 2 3 4\n"
+         << "spacings: 1 1 1\n"
+         << "encoding: raw\n"
+         << "data file: voxels/head_data.raw\n";
+  std::ofstream data((bundleDir + "/Data/voxels/head_data.raw").c_str(), std::ios::binary);
+  for (int i = 0; i < 2 * 3 * 4; ++i)
+    {
+    data.put(static_cast<char>(i));
+    }
+  std::ofstream unused((bundleDir + "/Data/unused.txt").c_str());
+  unused << "not referenced by the scene\n";
+  }
+
+  {
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetRootDirectory(bundleDir.c_str());
+  scene->SetURL((bundleDir + "/Bundle.mrml").c_str());
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> storageNode;
+  storageNode->SetFileName((bundleDir + "/Data/head.nhdr").c_str());
+  scene->AddNode(storageNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetName("head");
+  scene->AddNode(volumeNode.GetPointer());
+  volumeNode->SetAndObserveStorageNodeID(storageNode->GetID());
+  CHECK_BOOL(scene->Commit() != 0, true);
+  }
+
+  std::string bundleFile = testDir + "/Bundle.mrb";
+  CHECK_BOOL(zip(bundleFile.c_str(), bundleDir.c_str()), true);
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLApplicationLogic> appLogic;
+  appLogic->SetMRMLScene(scene.GetPointer());
+  CHECK_BOOL(appLogic->LoadSlicerDataBundle(bundleFile.c_str(), extractDir.c_str()) != 0, true);
+
+  std::vector<std::string> entries;
+  CHECK_BOOL(list_archive(bundleFile.c_str(), entries), true);
+  std::string dataEntry;
+  std::string unusedEntry;
+  for (std::vector<std::string>::iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+    if (it->find("head_data.raw") != std::string::npos)
+      {
+      dataEntry = *it;
+      }
+    if (it->find("unused.txt") != std::string::npos)
+      {
+      unusedEntry = *it;
+      }
+    }
+  CHECK_BOOL(dataEntry.empty(), false);
+  CHECK_BOOL(unusedEntry.empty(), false);
+  CHECK_BOOL(vtksys::SystemTools::FileExists((extractDir + "/" + dataEntry).c_str(), true), true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists((extractDir + "/" + unusedEntry).c_str(), true), true);
+
+  vtkMRMLScalarVolumeNode* loadedVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+    scene->GetFirstNodeByClass("vtkMRMLScalarVolumeNode"));
+  CHECK_NOT_NULL(loadedVolumeNode);
+  CHECK_NOT_NULL(loadedVolumeNode->GetImageData());
+  int* dimensions = loadedVolumeNode->GetImageData()->GetDimensions();
+  CHECK_INT(dimensions[0], 2);
+  CHECK_INT(dimensions[1], 3);
+  CHECK_INT(dimensions[2], 4);
+  CHECK_INT(static_cast<int>(loadedVolumeNode->GetImageData()->GetScalarComponentAsDouble(1, 2, 3, 0)),
+            1 + 2 * 2 + 3 * 2 * 3);
+
+  return EXIT_SUCCESS;
+}
@@ -44,6 +44,7 @@ namespace
 bool TestPerformance();
 bool TestNodeIDs();
 bool TestDefaults();
+bool TestPlaceholders();
 bool TestCopy();
 bool TestProceduralCopy();
 }
@@ -55,6 +56,7 @@ int vtkMRMLColorLogicTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[] )
   res = TestPerformance() && res;
   res = TestNodeIDs() && res;
   res = TestDefaults() && res;
+  res = TestPlaceholders() && res;
   res = TestCopy() && res;
   res = TestProceduralCopy() && res;
   return res ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -201,6 +203,62 @@ bool TestDefaults()
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool TestPlaceholders()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLColorLogic> colorLogic;
+  colorLogic->SetMRMLScene(scene.GetPointer());
+
+  vtkMRMLColorTableNode* labelsNode = vtkMRMLColorTableNode::SafeDownCast(
+    scene->GetNodeByID(colorLogic->GetDefaultLabelMapColorNodeID()));
+  if (!labelsNode || !labelsNode->IsPlaceholder())
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Default color nodes should be added as placeholders" << std::endl;
+    return false;
+    }
+
+  // colors are built on first access, same as with SetType
+  vtkNew<vtkMRMLColorTableNode> expectedNode;
+  expectedNode->SetTypeToLabels();
+  if (labelsNode->GetNumberOfColors() != expectedNode->GetNumberOfColors() ||
+      labelsNode->IsPlaceholder() ||
+      strcmp(labelsNode->GetColorName(1), expectedNode->GetColorName(1)) != 0)
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Failed to build the colors of a placeholder, got "
+              << labelsNode->GetNumberOfColors() << " colors, expected "
+              << expectedNode->GetNumberOfColors() << std::endl;
+    return false;
+    }
+  double color[4];
+  double expectedColor[4];
+  labelsNode->GetColor(1, color);
+  expectedNode->GetColor(1, expectedColor);
+  if (color[0] != expectedColor[0] || color[1] != expectedColor[1] ||
+      color[2] != expectedColor[2] || color[3] != expectedColor[3])
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Placeholder colors differ from the colors set by SetType" << std::endl;
+    return false;
+    }
+
+  // default nodes are kept when the scene is cleared and copied into the
+  // singletons when they are added again, built colors are kept
+  scene->Clear(0);
+  scene->InvokeEvent(vtkMRMLScene::NewSceneEvent, NULL);
+  if (scene->GetNodeByID(colorLogic->GetDefaultLabelMapColorNodeID()) != labelsNode ||
+      labelsNode->IsPlaceholder() ||
+      labelsNode->GetNumberOfColors() != expectedNode->GetNumberOfColors())
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Clearing the scene lost the colors of a default node" << std::endl;
+    return false;
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 bool TestCopy()
 {
@@ -14,13 +14,20 @@
 #include "vtksys/Glob.hxx"
 #include "vtksys/SystemTools.hxx"
 
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtk_zlib.h>
+
 // LibArchive includes
 #include <archive.h>
 #include <archive_entry.h>
 
 // STD includes
+#include <algorithm>
 #include <cstring>
+#include <ctime>
 #include <iostream>
+#include <set>
 
 namespace
 {
@@ -214,6 +221,573 @@ long copy_data(struct archive *ar, struct archive *aw)
   return r;
 }
 
+// --------------------------------------------------------------------------
+struct archive* open_archive_for_reading(const char* archiveFileName)
+{
+  struct archive* a = archive_read_new();
+  archive_read_support_filter_all(a);
+#if defined(ARCHIVE_VERSION_NUMBER) && ARCHIVE_VERSION_NUMBER >= 3001000
+  // the seekable zip reader uses the central directory, entries that are
+  // not needed are then skipped without being decompressed
+  archive_read_support_format_zip_seekable(a);
+#endif
+  archive_read_support_format_all(a);
+  // Note: the 10240 is just a suggested block size
+  if (archive_read_open_filename(a, archiveFileName, 10240) != ARCHIVE_OK)
+    {
+    vtkArchiveTools::Error("Problem with archive_read_open_filename(): ",
+                           archive_error_string(a));
+    archive_read_free(a);
+    return NULL;
+    }
+  return a;
+}
+
+// --------------------------------------------------------------------------
+// 64-bit seek, fseek() is limited to 2GB where long is 32-bit (e.g. Windows)
+bool seek_file(FILE* file, vtkTypeInt64 position)
+{
+#if defined(_MSC_VER)
+  return _fseeki64(file, static_cast<__int64>(position), SEEK_SET) == 0;
+#else
+  return fseeko(file, static_cast<off_t>(position), SEEK_SET) == 0;
+#endif
+}
+
+// --------------------------------------------------------------------------
+// entries are only extracted below the destination directory
+bool is_safe_entry_path(const std::string& path)
+{
+  if (path.empty() || vtksys::SystemTools::FileIsFullPath(path.c_str()))
+    {
+    return false;
+    }
+  std::vector<std::string> components;
+  vtksys::SystemTools::SplitPath(path.c_str(), components);
+  return std::find(components.begin(), components.end(), std::string("..")) == components.end();
+}
+
+// --------------------------------------------------------------------------
+bool extract_current_entry(struct archive* a, struct archive_entry* entry,
+                           const std::string& destinationDirectory)
+{
+  std::string entryPath = archive_entry_pathname(entry);
+  if (!is_safe_entry_path(entryPath))
+    {
+    vtkArchiveTools::Error("Unzip: skipping unsafe entry", entryPath.c_str());
+    return false;
+    }
+  std::string path = destinationDirectory + "/" + entryPath;
+  if (archive_entry_filetype(entry) == AE_IFDIR)
+    {
+    return vtksys::SystemTools::MakeDirectory(path.c_str());
+    }
+  if (archive_entry_filetype(entry) != AE_IFREG)
+    {
+    // links and devices are not expected in bundles
+    return true;
+    }
+  std::string parentDirectory = vtksys::SystemTools::GetFilenamePath(path);
+  if (!vtksys::SystemTools::MakeDirectory(parentDirectory.c_str()))
+    {
+    vtkArchiveTools::Error("Unzip: cannot create directory", parentDirectory.c_str());
+    return false;
+    }
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file)
+    {
+    vtkArchiveTools::Error("Unzip: cannot open", path.c_str());
+    return false;
+    }
+  bool success = true;
+  const void *buff;
+  size_t size;
+#if defined(ARCHIVE_VERSION_NUMBER) && ARCHIVE_VERSION_NUMBER >= 3000000
+  __LA_INT64_T offset;
+#else
+  off_t offset;
+#endif
+  vtkTypeInt64 position = 0;
+  for (;;)
+    {
+    int result = archive_read_data_block(a, &buff, &size, &offset);
+    if (result == ARCHIVE_EOF)
+      {
+      break;
+      }
+    if (result != ARCHIVE_OK)
+      {
+      vtkArchiveTools::Error("Unzip error:", archive_error_string(a));
+      success = false;
+      break;
+      }
+    if (offset != position && !seek_file(file, offset))
+      {
+      // sparse entry
+      vtkArchiveTools::Error("Unzip: cannot seek in", path.c_str());
+      success = false;
+      break;
+      }
+    if (fwrite(buff, 1, size, file) != size)
+      {
+      vtkArchiveTools::Error("Unzip: cannot write", path.c_str());
+      success = false;
+      break;
+      }
+    position = offset + size;
+    }
+  fclose(file);
+  return success;
+}
+
+// --------------------------------------------------------------------------
+struct UnzipEntriesJob
+{
+  std::string ZipFileName;
+  std::string DestinationDirectory;
+  std::set<std::string> Entries;
+  std::vector<int> Results;
+};
+
+// --------------------------------------------------------------------------
+// Each thread reads the archive with its own reader and extracts every
+// NumberOfThreads-th selected entry.
+VTK_THREAD_RETURN_TYPE unzip_entries_thread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  UnzipEntriesJob* job = static_cast<UnzipEntriesJob*>(info->UserData);
+  int threadId = info->ThreadID;
+  int numberOfThreads = info->NumberOfThreads;
+
+  struct archive* a = open_archive_for_reading(job->ZipFileName.c_str());
+  if (!a)
+    {
+    job->Results[threadId] = 0;
+    return VTK_THREAD_RETURN_VALUE;
+    }
+  bool success = true;
+  int selectedIndex = 0;
+  struct archive_entry* entry;
+  for (;;)
+    {
+    int result = archive_read_next_header(a, &entry);
+    if (result == ARCHIVE_EOF)
+      {
+      break;
+      }
+    if (result != ARCHIVE_OK)
+      {
+      vtkArchiveTools::Error("Unzip error:", archive_error_string(a));
+      if (result < ARCHIVE_WARN)
+        {
+        success = false;
+        break;
+        }
+      }
+    bool selected = job->Entries.empty()
+      || job->Entries.count(archive_entry_pathname(entry)) > 0;
+    if (selected && (selectedIndex++ % numberOfThreads) == threadId)
+      {
+      success = extract_current_entry(a, entry, job->DestinationDirectory) && success;
+      }
+    else
+      {
+      archive_read_data_skip(a);
+      }
+    }
+  archive_read_close(a);
+  archive_read_free(a);
+  job->Results[threadId] = success ? 1 : 0;
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// --------------------------------------------------------------------------
+// Zip writer
+//
+// zip() writes the archive itself instead of going through libarchive so
+// that the data of large files can be deflated by several threads: a file
+// is cut into blocks that are compressed independently (each one primed with
+// the end of the previous block) and flushed on a byte boundary, so the
+// compressed blocks concatenate into a single valid deflate stream.
+// Files whose content is already compressed are stored as is.
+
+const size_t ZipBlockSize = 1 << 20;
+const size_t ZipWindowSize = 32768;
+const vtkTypeUInt64 ZipMax32 = 0xffffffffULL;
+// entries larger than this get zip64 sizes in their local header
+// (deflate may slightly expand incompressible data)
+const vtkTypeUInt64 ZipZip64Threshold = 0xfff00000ULL;
+
+// --------------------------------------------------------------------------
+struct ZipEntryRecord
+{
+  std::string Name;
+  bool Directory;
+  unsigned short Method; // 0: stored, 8: deflated
+  unsigned long CRC;
+  vtkTypeUInt64 CompressedSize;
+  vtkTypeUInt64 UncompressedSize;
+  vtkTypeUInt64 Offset;
+  unsigned short DosTime;
+  unsigned short DosDate;
+};
+
+// --------------------------------------------------------------------------
+void zip_put16(std::string& buffer, unsigned int value)
+{
+  buffer += static_cast<char>(value & 0xff);
+  buffer += static_cast<char>((value >> 8) & 0xff);
+}
+
+// --------------------------------------------------------------------------
+void zip_put32(std::string& buffer, vtkTypeUInt64 value)
+{
+  zip_put16(buffer, static_cast<unsigned int>(value & 0xffff));
+  zip_put16(buffer, static_cast<unsigned int>((value >> 16) & 0xffff));
+}
+
+// --------------------------------------------------------------------------
+void zip_put64(std::string& buffer, vtkTypeUInt64 value)
+{
+  zip_put32(buffer, value & ZipMax32);
+  zip_put32(buffer, value >> 32);
+}
+
+// --------------------------------------------------------------------------
+bool zip_write(FILE* file, const std::string& buffer, vtkTypeUInt64& offset)
+{
+  if (buffer.empty())
+    {
+    return true;
+    }
+  if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+    {
+    return false;
+    }
+  offset += buffer.size();
+  return true;
+}
+
+// --------------------------------------------------------------------------
+bool zip_seek(FILE* file, vtkTypeUInt64 position)
+{
+  return seek_file(file, static_cast<vtkTypeInt64>(position));
+}
+
+// --------------------------------------------------------------------------
+void zip_dos_time(long modifiedTime, unsigned short& dosTime, unsigned short& dosDate)
+{
+  time_t t = static_cast<time_t>(modifiedTime);
+  struct tm* local = localtime(&t);
+  if (!local || local->tm_year < 80)
+    {
+    // 1980-01-01 00:00, the earliest date zip can represent
+    dosTime = 0;
+    dosDate = (1 << 5) | 1;
+    return;
+    }
+  dosTime = static_cast<unsigned short>(
+    (local->tm_hour << 11) | (local->tm_min << 5) | (local->tm_sec / 2));
+  dosDate = static_cast<unsigned short>(
+    ((local->tm_year - 80) << 9) | ((local->tm_mon + 1) << 5) | local->tm_mday);
+}
+
+// --------------------------------------------------------------------------
+// Compressing gzip, zip, png or jpeg data again only costs time.
+bool zip_is_already_compressed(const std::string& fileName)
+{
+  FILE* file = fopen(fileName.c_str(), "rb");
+  if (!file)
+    {
+    return false;
+    }
+  char header[4096];
+  size_t size = fread(header, 1, sizeof(header) - 1, file);
+  fclose(file);
+  header[size] = '\0';
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(header);
+  if ((size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b)   // gzip
+      || (size >= 4 && memcmp(header, "PK\3\4", 4) == 0)     // zip
+      || (size >= 3 && memcmp(header, "BZh", 3) == 0)        // bzip2
+      || (size >= 4 && memcmp(header, "\x89PNG", 4) == 0)    // png
+      || (size >= 3 && bytes[0] == 0xff && bytes[1] == 0xd8 && bytes[2] == 0xff)) // jpeg
+    {
+    return true;
+    }
+  // nrrd and metaimage files embedding compressed data after a text header
+  std::string text(header, size);
+  if (text.compare(0, 4, "NRRD") == 0)
+    {
+    std::string::size_type headerEnd = text.find("\n\n");
+    std::string::size_type encoding = text.find("\nencoding:");
+    if (encoding != std::string::npos && (headerEnd == std::string::npos || encoding < headerEnd))
+      {
+      std::string::size_type valueStart = text.find_first_not_of(" \t", encoding + 10);
+      std::string::size_type valueEnd = text.find_first_of("\r\n", encoding + 10);
+      if (valueStart != std::string::npos && valueEnd != std::string::npos && valueStart < valueEnd)
+        {
+        std::string value = text.substr(valueStart, valueEnd - valueStart);
+        return value == "gzip" || value == "gz" || value == "bzip2" || value == "bz2";
+        }
+      }
+    return false;
+    }
+  if (text.find("ElementDataFile") != std::string::npos
+      && (text.find("CompressedData = True") != std::string::npos
+          || text.find("CompressedData=True") != std::string::npos))
+    {
+    return true;
+    }
+  return false;
+}
+
+// --------------------------------------------------------------------------
+// One batch of consecutive blocks of a file. Data holds HistorySize bytes
+// preceding the batch followed by DataSize bytes to compress.
+struct ZipDeflateJob
+{
+  const char* Data;
+  size_t HistorySize;
+  size_t DataSize;
+  size_t NumberOfBlocks;
+  bool LastBatch;
+  int Level;
+  std::vector<std::string> Output;
+  std::vector<unsigned long> CRC;
+  std::vector<int> Results;
+};
+
+// --------------------------------------------------------------------------
+bool zip_deflate_block(ZipDeflateJob* job, size_t block)
+{
+  size_t blockStart = block * ZipBlockSize;
+  size_t blockSize = std::min(ZipBlockSize, job->DataSize - blockStart);
+  const Bytef* begin = reinterpret_cast<const Bytef*>(job->Data + job->HistorySize + blockStart);
+  bool lastBlock = job->LastBatch && block == job->NumberOfBlocks - 1;
+
+  job->CRC[block] = crc32(0L, begin, static_cast<uInt>(blockSize));
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // negative window bits: raw deflate data, as stored in zip entries
+  if (deflateInit2(&stream, job->Level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+    return false;
+    }
+  size_t dictionarySize = std::min(ZipWindowSize, job->HistorySize + blockStart);
+  if (dictionarySize > 0
+      && deflateSetDictionary(&stream, begin - dictionarySize, static_cast<uInt>(dictionarySize)) != Z_OK)
+    {
+    deflateEnd(&stream);
+    return false;
+    }
+  std::string& output = job->Output[block];
+  output.resize(deflateBound(&stream, static_cast<uLong>(blockSize)) + 64);
+  stream.next_in = const_cast<Bytef*>(begin);
+  stream.avail_in = static_cast<uInt>(blockSize);
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = static_cast<uInt>(output.size());
+  // a sync flush ends the block on a byte boundary without marking it
+  // as the last one, the final block of the file finishes the stream
+  int result = deflate(&stream, lastBlock ? Z_FINISH : Z_SYNC_FLUSH);
+  bool success = lastBlock ? (result == Z_STREAM_END)
+                           : (result == Z_OK && stream.avail_in == 0 && stream.avail_out > 0);
+  output.resize(output.size() - stream.avail_out);
+  deflateEnd(&stream);
+  return success;
+}
+
+// --------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE zip_deflate_thread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ZipDeflateJob* job = static_cast<ZipDeflateJob*>(info->UserData);
+  for (size_t block = info->ThreadID; block < job->NumberOfBlocks;
+       block += info->NumberOfThreads)
+    {
+    job->Results[block] = zip_deflate_block(job, block) ? 1 : 0;
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// --------------------------------------------------------------------------
+std::string zip_local_header(const ZipEntryRecord& record, bool zip64)
+{
+  std::string header;
+  zip_put32(header, 0x04034b50);
+  zip_put16(header, zip64 ? 45 : 20);     // version needed to extract
+  zip_put16(header, 0x0800);              // file names are utf-8
+  zip_put16(header, record.Method);
+  zip_put16(header, record.DosTime);
+  zip_put16(header, record.DosDate);
+  zip_put32(header, record.CRC);
+  zip_put32(header, zip64 ? ZipMax32 : record.CompressedSize);
+  zip_put32(header, zip64 ? ZipMax32 : record.UncompressedSize);
+  zip_put16(header, static_cast<unsigned int>(record.Name.size()));
+  zip_put16(header, zip64 ? 20 : 0);
+  header += record.Name;
+  if (zip64)
+    {
+    zip_put16(header, 0x0001);
+    zip_put16(header, 16);
+    zip_put64(header, record.UncompressedSize);
+    zip_put64(header, record.CompressedSize);
+    }
+  return header;
+}
+
+// --------------------------------------------------------------------------
+std::string zip_central_header(const ZipEntryRecord& record)
+{
+  std::string extra;
+  if (record.UncompressedSize >= ZipMax32)
+    {
+    zip_put64(extra, record.UncompressedSize);
+    }
+  if (record.CompressedSize >= ZipMax32)
+    {
+    zip_put64(extra, record.CompressedSize);
+    }
+  if (record.Offset >= ZipMax32)
+    {
+    zip_put64(extra, record.Offset);
+    }
+  bool zip64 = !extra.empty();
+
+  std::string header;
+  zip_put32(header, 0x02014b50);
+  zip_put16(header, (3 << 8) | 45);        // made by unix, zip 4.5
+  zip_put16(header, zip64 ? 45 : 20);
+  zip_put16(header, 0x0800);
+  zip_put16(header, record.Method);
+  zip_put16(header, record.DosTime);
+  zip_put16(header, record.DosDate);
+  zip_put32(header, record.CRC);
+  zip_put32(header, std::min(record.CompressedSize, ZipMax32));
+  zip_put32(header, std::min(record.UncompressedSize, ZipMax32));
+  zip_put16(header, static_cast<unsigned int>(record.Name.size()));
+  zip_put16(header, zip64 ? static_cast<unsigned int>(extra.size() + 4) : 0);
+  zip_put16(header, 0);                    // comment length
+  zip_put16(header, 0);                    // disk number
+  zip_put16(header, 0);                    // internal attributes
+  // unix permissions in the high word, ms-dos directory flag in the low one
+  zip_put32(header, record.Directory ? ((040755ULL << 16) | 0x10) : (0100644ULL << 16));
+  zip_put32(header, std::min(record.Offset, ZipMax32));
+  header += record.Name;
+  if (zip64)
+    {
+    zip_put16(header, 0x0001);
+    zip_put16(header, static_cast<unsigned int>(extra.size()));
+    header += extra;
+    }
+  return header;
+}
+
+// --------------------------------------------------------------------------
+bool zip_add_file(FILE* zipFile, vtkTypeUInt64& offset, const std::string& fileName,
+                  ZipEntryRecord& record, vtkMultiThreader* threader, int numberOfThreads)
+{
+  FILE* file = fopen(fileName.c_str(), "rb");
+  if (!file)
+    {
+    vtkArchiveTools::Error("Zip: cannot open:", fileName.c_str());
+    return false;
+    }
+  record.UncompressedSize = vtksys::SystemTools::FileLength(fileName);
+  bool zip64 = record.UncompressedSize >= ZipZip64Threshold;
+  record.Offset = offset;
+  if (!zip_write(zipFile, zip_local_header(record, zip64), offset))
+    {
+    fclose(file);
+    return false;
+    }
+
+  bool success = true;
+  vtkTypeUInt64 readSize = 0;
+  unsigned long crc = crc32(0L, Z_NULL, 0);
+  if (record.Method == 0)
+    {
+    std::vector<char> buffer(ZipBlockSize);
+    size_t len;
+    while (success && (len = fread(&buffer[0], 1, buffer.size(), file)) > 0)
+      {
+      crc = crc32(crc, reinterpret_cast<const Bytef*>(&buffer[0]), static_cast<uInt>(len));
+      success = fwrite(&buffer[0], 1, len, zipFile) == len;
+      offset += len;
+      readSize += len;
+      }
+    }
+  else
+    {
+    // blocks of a batch are deflated concurrently, then written in order
+    size_t blocksPerBatch = static_cast<size_t>(numberOfThreads) * 4;
+    std::vector<char> buffer(ZipWindowSize + blocksPerBatch * ZipBlockSize);
+    size_t historySize = 0;
+    bool lastBatch = false;
+    while (success && !lastBatch)
+      {
+      size_t dataSize = fread(&buffer[historySize], 1, blocksPerBatch * ZipBlockSize, file);
+      readSize += dataSize;
+      lastBatch = (readSize >= record.UncompressedSize) || feof(file) || ferror(file);
+
+      ZipDeflateJob job;
+      job.Data = &buffer[0];
+      job.HistorySize = historySize;
+      job.DataSize = dataSize;
+      // an empty last batch still has to finish the deflate stream
+      job.NumberOfBlocks = std::max<size_t>(1, (dataSize + ZipBlockSize - 1) / ZipBlockSize);
+      job.LastBatch = lastBatch;
+      job.Level = Z_DEFAULT_COMPRESSION;
+      job.Output.resize(job.NumberOfBlocks);
+      job.CRC.resize(job.NumberOfBlocks);
+      job.Results.resize(job.NumberOfBlocks, 0);
+      if (job.NumberOfBlocks == 1)
+        {
+        job.Results[0] = zip_deflate_block(&job, 0) ? 1 : 0;
+        }
+      else
+        {
+        threader->SetNumberOfThreads(
+          static_cast<int>(std::min<size_t>(numberOfThreads, job.NumberOfBlocks)));
+        threader->SetSingleMethod(zip_deflate_thread, &job);
+        threader->SingleMethodExecute();
+        }
+
+      for (size_t block = 0; success && block < job.NumberOfBlocks; ++block)
+        {
+        size_t blockSize = std::min(ZipBlockSize, dataSize - std::min(dataSize, block * ZipBlockSize));
+        crc = crc32_combine(crc, job.CRC[block], static_cast<z_off_t>(blockSize));
+        success = job.Results[block] && zip_write(zipFile, job.Output[block], offset);
+        }
+
+      // keep the end of the batch as history for the next one
+      size_t availableHistory = historySize + dataSize;
+      size_t newHistorySize = std::min(ZipWindowSize, availableHistory);
+      memmove(&buffer[0], &buffer[availableHistory - newHistorySize], newHistorySize);
+      historySize = newHistorySize;
+      }
+    }
+  fclose(file);
+  if (!success || readSize != record.UncompressedSize)
+    {
+    vtkArchiveTools::Error("Zip: cannot add:", fileName.c_str());
+    return false;
+    }
+  record.CRC = crc;
+  record.CompressedSize = offset - record.Offset - zip_local_header(record, zip64).size();
+
+  if (!zip64 && record.CompressedSize >= ZipMax32)
+    {
+    vtkArchiveTools::Error("Zip: compressed data too large:", fileName.c_str());
+    return false;
+    }
+  // now that sizes and checksum are known, rewrite the local header
+  std::string header = zip_local_header(record, zip64);
+  return zip_seek(zipFile, record.Offset)
+    && fwrite(header.data(), 1, header.size(), zipFile) == header.size()
+    && zip_seek(zipFile, offset);
+}
+
 } // end of anonymous namespace
 
 //-----------------------------------------------------------------------------
@@ -344,24 +918,20 @@ bool extract_tar(const char* tarFileName, bool verbose, bool extract, std::vecto
 //-----------------------------------------------------------------------------
 // creates a zip file with the full contents of the directory (recurses)
 // zip entries will include relative path of including tail of directoryToZip
-bool zip(const char* zipFileName, const char* directoryToZip)
+bool zip(const char* zipFileName, const char* directoryToZip, int numberOfThreads)
 {
 
   //
   // to make a zip file:
-  // - check that libarchive supports zip writing
   // - check arguments
   // - get a list of files using vtksys Glob
   // - create the archive
-  // -- go file-by-file and add chunks of data to the archive
+  // -- go file-by-file, storing files that are already compressed and
+  //    deflating the others in parallel blocks
+  // -- write the central directory
   // - close up and return success
   //
 
-// only support the libarchive version 3.0 +
-#if !defined(ARCHIVE_VERSION_NUMBER) || ARCHIVE_VERSION_NUMBER < 3000000
-  return false;
-#endif
-
   if ( !zipFileName || !directoryToZip )
     {
     vtkArchiveTools::Error("Zip:", "Invalid zipfile or directory");
@@ -383,90 +953,102 @@ bool zip(const char* zipFileName, const char* directoryToZip)
     }
   std::vector<std::string> files = glob.GetFiles();
 
-  // now zip it up using LibArchive
-  struct archive *zipArchive;
-  struct archive_entry *entry, *dirEntry;
-  char buff[BUFSIZ];
-  size_t len;
-  // have to read the contents of the files to add them to the archive
-  FILE *fd;
-
-  zipArchive = archive_write_new();
-
-  // create a zip archive
-#ifdef HAVE_ZLIB_H
-  std::string compression_type = "deflate";
-#else
-  std::string compression_type = "store";
-#endif
-
-  archive_write_set_format_zip(zipArchive);
-
-  archive_write_set_format_option(zipArchive, "zip", "compression", compression_type.c_str());
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  numberOfThreads = std::max(1, std::min(numberOfThreads, VTK_MAX_THREADS));
+  vtkMultiThreader* threader = vtkMultiThreader::New();
 
-  archive_write_open_filename(zipArchive, zipFileName);
+  FILE* zipFile = fopen(zipFileName, "wb");
+  if (!zipFile)
+    {
+    vtkArchiveTools::Error("Zip: cannot open:", zipFileName);
+    threader->Delete();
+    return false;
+    }
+  vtkTypeUInt64 offset = 0;
+  std::vector<ZipEntryRecord> records;
+  bool success = true;
 
   // add the data directory
-  dirEntry = archive_entry_new();
-  archive_entry_set_mtime(dirEntry, 11, 110);
-  archive_entry_copy_pathname(dirEntry, directoryName.c_str());
-  archive_entry_set_mode(dirEntry, S_IFDIR | 0755);
-  archive_entry_set_size(dirEntry, 512);
-  archive_write_header(zipArchive, dirEntry);
-  archive_entry_free(dirEntry);
+  ZipEntryRecord dirEntry;
+  dirEntry.Name = directoryName + "/";
+  dirEntry.Directory = true;
+  dirEntry.Method = 0;
+  dirEntry.CRC = 0;
+  dirEntry.CompressedSize = 0;
+  dirEntry.UncompressedSize = 0;
+  dirEntry.Offset = offset;
+  zip_dos_time(vtksys::SystemTools::ModifiedTime(directoryToZip), dirEntry.DosTime, dirEntry.DosDate);
+  success = zip_write(zipFile, zip_local_header(dirEntry, false), offset);
+  records.push_back(dirEntry);
 
   // add the files
   std::vector<std::string>::const_iterator sit;
-  sit = files.begin();
-  while (sit != files.end())
+  for (sit = files.begin(); success && sit != files.end(); ++sit)
     {
     vtkArchiveTools::Message("Zip: adding:", (*sit).c_str());
-    const char *fileName = (*sit).c_str();
-    ++sit;
-
-    //
-    // add an entry for this file
-    //
-    entry = archive_entry_new();
+    ZipEntryRecord entry;
     // use a relative path for the entry file name, including the top
     // directory so it unzips into a directory of it's own
-    std::string relFileName = vtksys::SystemTools::RelativePath(
+    entry.Name = vtksys::SystemTools::RelativePath(
               vtksys::SystemTools::GetParentDirectory(directoryToZip).c_str(),
-              fileName);
-    vtkArchiveTools::Message("Zip: adding rel:", relFileName.c_str());
-    archive_entry_set_pathname(entry, relFileName.c_str());
-    // size is required, for now use the vtksys call though it uses struct stat
-    // and may not be portable
-    unsigned long fileLength = vtksys::SystemTools::FileLength(fileName);
-    archive_entry_set_size(entry, fileLength);
-    archive_entry_set_filetype(entry, AE_IFREG);
-    archive_entry_set_perm(entry, 0644);
-    archive_write_header(zipArchive, entry);
-
-    //
-    // add the data for this entry
-    //
-    fd = fopen(fileName, "rb");
-    if (!fd)
-      {
-      vtkArchiveTools::Error("Zip: cannot open:", (*sit).c_str());
-      }
-    else
-      {
-      len = fread(buff, sizeof(char), sizeof(buff), fd);
-      while ( len > 0 )
-        {
-        archive_write_data(zipArchive, buff, len);
-        len = fread(buff, sizeof(char), sizeof(buff), fd);
-        }
-      fclose(fd);
-      }
-    archive_entry_free(entry);
+              (*sit).c_str());
+    vtkArchiveTools::Message("Zip: adding rel:", entry.Name.c_str());
+    entry.Directory = false;
+    entry.Method = zip_is_already_compressed(*sit) ? 0 : 8;
+    entry.CRC = 0;
+    entry.CompressedSize = 0;
+    entry.UncompressedSize = 0;
+    zip_dos_time(vtksys::SystemTools::ModifiedTime((*sit).c_str()), entry.DosTime, entry.DosDate);
+    success = zip_add_file(zipFile, offset, *sit, entry, threader, numberOfThreads);
+    records.push_back(entry);
+    }
+  threader->Delete();
+
+  // write the central directory
+  vtkTypeUInt64 centralDirectoryOffset = offset;
+  std::vector<ZipEntryRecord>::const_iterator rit;
+  for (rit = records.begin(); success && rit != records.end(); ++rit)
+    {
+    success = zip_write(zipFile, zip_central_header(*rit), offset);
     }
+  vtkTypeUInt64 centralDirectorySize = offset - centralDirectoryOffset;
+  vtkTypeUInt64 numberOfRecords = records.size();
 
-  archive_write_close(zipArchive);
-  int retval = archive_write_free(zipArchive);
-  if (retval != ARCHIVE_OK)
+  std::string end;
+  if (numberOfRecords >= 0xffff || centralDirectoryOffset >= ZipMax32
+      || centralDirectorySize >= ZipMax32)
+    {
+    // zip64 end of central directory record and locator
+    vtkTypeUInt64 zip64EndOffset = offset;
+    zip_put32(end, 0x06064b50);
+    zip_put64(end, 44);
+    zip_put16(end, (3 << 8) | 45);
+    zip_put16(end, 45);
+    zip_put32(end, 0);
+    zip_put32(end, 0);
+    zip_put64(end, numberOfRecords);
+    zip_put64(end, numberOfRecords);
+    zip_put64(end, centralDirectorySize);
+    zip_put64(end, centralDirectoryOffset);
+    zip_put32(end, 0x07064b50);
+    zip_put32(end, 0);
+    zip_put64(end, zip64EndOffset);
+    zip_put32(end, 1);
+    }
+  zip_put32(end, 0x06054b50);
+  zip_put16(end, 0);
+  zip_put16(end, 0);
+  zip_put16(end, static_cast<unsigned int>(std::min<vtkTypeUInt64>(numberOfRecords, 0xffff)));
+  zip_put16(end, static_cast<unsigned int>(std::min<vtkTypeUInt64>(numberOfRecords, 0xffff)));
+  zip_put32(end, std::min(centralDirectorySize, ZipMax32));
+  zip_put32(end, std::min(centralDirectoryOffset, ZipMax32));
+  zip_put16(end, 0);
+  success = success && zip_write(zipFile, end, offset);
+
+  if (fclose(zipFile) != 0 || !success)
     {
     vtkArchiveTools::Error("Zip:", "error on close!");
     return false;
@@ -627,3 +1209,156 @@ bool unzip(const char* zipFileName, const char* destinationDirectory)
 
   return (result == ARCHIVE_OK);
 }
+
+//-----------------------------------------------------------------------------
+bool read_archive_entry(const char* archiveFileName, const char* entryName, std::string& content)
+{
+  content.clear();
+  if (!archiveFileName || !entryName)
+    {
+    vtkArchiveTools::Error("ReadEntry:", "Invalid archive or entry name");
+    return false;
+    }
+  struct archive* a = open_archive_for_reading(archiveFileName);
+  if (!a)
+    {
+    return false;
+    }
+  bool found = false;
+  bool success = true;
+  struct archive_entry* entry;
+  while (!found && success)
+    {
+    int result = archive_read_next_header(a, &entry);
+    if (result == ARCHIVE_EOF)
+      {
+      break;
+      }
+    if (result != ARCHIVE_OK && result < ARCHIVE_WARN)
+      {
+      vtkArchiveTools::Error("ReadEntry error:", archive_error_string(a));
+      success = false;
+      break;
+      }
+    if (strcmp(archive_entry_pathname(entry), entryName) != 0)
+      {
+      archive_read_data_skip(a);
+      continue;
+      }
+    found = true;
+    if (archive_entry_size_is_set(entry))
+      {
+      content.reserve(static_cast<size_t>(archive_entry_size(entry)));
+      }
+    const void *buff;
+    size_t size;
+#if defined(ARCHIVE_VERSION_NUMBER) && ARCHIVE_VERSION_NUMBER >= 3000000
+    __LA_INT64_T offset;
+#else
+    off_t offset;
+#endif
+    for (;;)
+      {
+      result = archive_read_data_block(a, &buff, &size, &offset);
+      if (result == ARCHIVE_EOF)
+        {
+        break;
+        }
+      if (result != ARCHIVE_OK)
+        {
+        vtkArchiveTools::Error("ReadEntry error:", archive_error_string(a));
+        success = false;
+        break;
+        }
+      if (content.size() < static_cast<size_t>(offset) + size)
+        {
+        content.resize(static_cast<size_t>(offset) + size);
+        }
+      memcpy(&content[static_cast<size_t>(offset)], buff, size);
+      }
+    }
+  archive_read_close(a);
+  archive_read_free(a);
+  if (!found && success)
+    {
+    vtkArchiveTools::Error("ReadEntry: entry not found", entryName);
+    }
+  return found && success;
+}
+
+//-----------------------------------------------------------------------------
+bool unzip_entries(const char* zipFileName, const char* destinationDirectory,
+                   const std::vector<std::string>& entries, int numberOfThreads)
+{
+  if ( !zipFileName || !destinationDirectory )
+    {
+    vtkArchiveTools::Error("Unzip:", "Invalid zipfile or directory");
+    return false;
+    }
+  if ( !vtksys::SystemTools::FileExists(zipFileName) )
+    {
+    vtkArchiveTools::Error("Unzip:", "Zip file does not exist");
+    return false;
+    }
+  if ( !vtksys::SystemTools::FileIsDirectory(destinationDirectory) )
+    {
+    vtkArchiveTools::Error("Unzip:", "Destination is not a directory");
+    return false;
+    }
+
+  UnzipEntriesJob job;
+  job.ZipFileName = zipFileName;
+  job.DestinationDirectory = destinationDirectory;
+  job.Entries.insert(entries.begin(), entries.end());
+
+  // Only random-access archives benefit from several readers, other formats
+  // would be decompressed again by each reader.
+  int numberOfEntries = 0;
+  bool seekable = false;
+  struct archive* a = open_archive_for_reading(zipFileName);
+  if (!a)
+    {
+    return false;
+    }
+  std::set<std::string> missingEntries = job.Entries;
+  struct archive_entry* entry;
+  while (archive_read_next_header(a, &entry) == ARCHIVE_OK)
+    {
+    if (job.Entries.empty() || job.Entries.count(archive_entry_pathname(entry)) > 0)
+      {
+      ++numberOfEntries;
+      missingEntries.erase(archive_entry_pathname(entry));
+      }
+    seekable = (archive_format(a) == ARCHIVE_FORMAT_ZIP) && archive_filter_count(a) <= 1;
+    archive_read_data_skip(a);
+    }
+  archive_read_close(a);
+  archive_read_free(a);
+  if (!missingEntries.empty())
+    {
+    for (std::set<std::string>::iterator it = missingEntries.begin(); it != missingEntries.end(); ++it)
+      {
+      vtkArchiveTools::Error("Unzip: entry not found", it->c_str());
+      }
+    return false;
+    }
+
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  if (!seekable)
+    {
+    numberOfThreads = 1;
+    }
+  numberOfThreads = std::max(1, std::min(numberOfThreads, std::min(numberOfEntries, VTK_MAX_THREADS)));
+  job.Results.resize(numberOfThreads, 0);
+
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(unzip_entries_thread, &job);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  return std::count(job.Results.begin(), job.Results.end(), 0) == 0;
+}
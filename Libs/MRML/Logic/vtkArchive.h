@@ -37,11 +37,31 @@ VTK_MRML_LOGIC_EXPORT bool extract_tar(const char* tarFileName, bool verbose, bo
 
 // creates a zip file with the full contents of the directory (recurses)
 // zip entries will include relative path of including tail of directoryToZip
-VTK_MRML_LOGIC_EXPORT bool zip(const char* zipFileName, const char* directoryToZip);
+// Files that are already compressed (gzip, zip, png, jpeg, compressed nrrd...)
+// are stored as is, the others are deflated by up to numberOfThreads threads
+// (0 uses the number of processors).
+VTK_MRML_LOGIC_EXPORT bool zip(const char* zipFileName, const char* directoryToZip,
+                               int numberOfThreads = 0);
 
 // unzips zip file into specified directory
 // (internally this supports many formats of archive, not just zip)
 VTK_MRML_LOGIC_EXPORT bool unzip(const char* zipFileName, const char *destinationDirectory);
+
+// reads the content of a single archive entry into memory, without
+// extracting anything to disk
+VTK_MRML_LOGIC_EXPORT bool read_archive_entry(const char* archiveFileName,
+                                              const char* entryName,
+                                              std::string& content);
+
+// extracts only the listed entries of the archive into the specified directory
+// (all entries if the list is empty), fails if a listed entry is not in the
+// archive. Entries are decompressed in parallel by
+// up to numberOfThreads independent readers of the archive (0 uses the number
+// of processors). Unlike unzip(), the current directory is not changed.
+VTK_MRML_LOGIC_EXPORT bool unzip_entries(const char* zipFileName,
+                                         const char* destinationDirectory,
+                                         const std::vector<std::string>& entries,
+                                         int numberOfThreads = 0);
 #ifdef __cplusplus
 }
 #endif
@@ -481,24 +481,64 @@ std::string vtkMRMLApplicationLogic::UnpackSlicerDataBundle(const char *sdbFileP
 }
 
 //----------------------------------------------------------------------------
-bool vtkMRMLApplicationLogic::OpenSlicerDataBundle(const char *sdbFilePath, const char *temporaryDirectory)
+int vtkMRMLApplicationLogic::LoadSlicerDataBundle(const char *sdbFilePath, const char *temporaryDirectory, bool clear)
 {
-  if (!this->GetMRMLScene())
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene)
     {
-    vtkErrorMacro("no scene");
-    return false;
+    vtkErrorMacro("LoadSlicerDataBundle: no scene");
+    return 0;
+    }
+  if (!sdbFilePath || !temporaryDirectory)
+    {
+    vtkErrorMacro("LoadSlicerDataBundle: invalid bundle file or directory");
+    return 0;
+    }
+
+  std::vector<std::string> entries;
+  if (!list_archive(sdbFilePath, entries))
+    {
+    vtkErrorMacro("LoadSlicerDataBundle: could not open bundle file " << sdbFilePath);
+    return 0;
+    }
+  std::string sceneEntry;
+  for (std::vector<std::string>::iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+    if (vtksys::SystemTools::GetFilenameLastExtension(*it) == ".mrml")
+      {
+      sceneEntry = *it;
+      break;
+      }
+    }
+  if (sceneEntry.empty())
+    {
+    vtkErrorMacro("LoadSlicerDataBundle: could not find mrml file in archive");
+    return 0;
     }
 
-  std::string mrmlFile = this->UnpackSlicerDataBundle(sdbFilePath, temporaryDirectory);
+  // All entries are extracted, because storage nodes may read any file of the bundle
+  if (!unzip_entries(sdbFilePath, temporaryDirectory, std::vector<std::string>()))
+    {
+    vtkErrorMacro("LoadSlicerDataBundle: could not extract bundle file " << sdbFilePath);
+    return 0;
+    }
 
-  if ( mrmlFile.empty() )
+  std::string sceneURL = std::string(temporaryDirectory) + "/" + sceneEntry;
+  scene->SetURL(sceneURL.c_str());
+  scene->SetRootDirectory(vtksys::SystemTools::GetFilenamePath(sceneURL).c_str());
+  return clear ? scene->Connect() : scene->Import();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLApplicationLogic::OpenSlicerDataBundle(const char *sdbFilePath, const char *temporaryDirectory)
+{
+  if (!this->GetMRMLScene())
     {
-    vtkErrorMacro("Could not unpack mrml scene");
+    vtkErrorMacro("no scene");
     return false;
     }
 
-  this->GetMRMLScene()->SetURL( mrmlFile.c_str() );
-  int success = this->GetMRMLScene()->Connect();
+  int success = this->LoadSlicerDataBundle(sdbFilePath, temporaryDirectory, true);
   if ( !success )
     {
     vtkErrorMacro("Could not connect to scene");
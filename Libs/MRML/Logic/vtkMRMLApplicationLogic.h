@@ -164,6 +164,16 @@ public:
   /// directory will be used.
   std::string UnpackSlicerDataBundle(const char *sdbFilePath, const char *temporaryDirectory);
 
+  /// Load the scene of a bundle. All entries of the archive are extracted
+  /// into \a temporaryDirectory, decompressed in parallel, then the first
+  /// mrml file of the archive is loaded.
+  /// The scene is cleared first if \a clear is true, otherwise the bundle
+  /// is imported into the current scene.
+  /// Returns the result of vtkMRMLScene::Connect() or vtkMRMLScene::Import(),
+  /// 0 on failure.
+  /// \sa UnpackSlicerDataBundle()
+  int LoadSlicerDataBundle(const char *sdbFilePath, const char *temporaryDirectory, bool clear = true);
+
   /// Load any default parameter sets into the specified scene
   /// Returns the total number of loaded parameter sets
   static int LoadDefaultParameterSets(vtkMRMLScene * scene,
@@ -474,7 +474,8 @@ vtkMRMLColorNode* vtkMRMLColorLogic::LoadColorFile(const char *fileName, const c
 vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateLabelsNode()
 {
   vtkMRMLColorTableNode *labelsNode = vtkMRMLColorTableNode::New();
-  labelsNode->SetTypeToLabels();
+  // colors are built when first accessed
+  labelsNode->SetTypeAsPlaceholder(vtkMRMLColorTableNode::Labels);
   labelsNode->SetAttribute("Category", "Discrete");
   labelsNode->SaveWithSceneOff();
   labelsNode->SetName(labelsNode->GetTypeAsString());
@@ -486,7 +487,8 @@ vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateLabelsNode()
 vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateDefaultTableNode(int type)
 {
   vtkMRMLColorTableNode *node = vtkMRMLColorTableNode::New();
-  node->SetType(type);
+  // colors are built when first accessed
+  node->SetTypeAsPlaceholder(type);
   const char* typeName = node->GetTypeAsString();
   if (strstr(typeName, "Tint") != NULL)
     {
@@ -596,7 +598,7 @@ vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateFreeSurferFileNode(const char* f
     return 0;
     }
 
-  vtkMRMLColorTableNode* node = this->CreateFileNode(fileName);
+  vtkMRMLColorTableNode* node = this->CreateFileNode(fileName, true);
 
   if (!node)
     {
@@ -659,7 +661,7 @@ vtkMRMLdGEMRICProceduralColorNode* vtkMRMLColorLogic::CreatedGEMRICColorNode(int
 //---------------------------------------------------------------------------------
 vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateDefaultFileNode(const std::string& colorFileName)
 {
-  vtkMRMLColorTableNode* ctnode = this->CreateFileNode(colorFileName.c_str());
+  vtkMRMLColorTableNode* ctnode = this->CreateFileNode(colorFileName.c_str(), true);
 
   if (!ctnode)
     {
@@ -684,7 +686,7 @@ vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateDefaultFileNode(const std::strin
 //---------------------------------------------------------------------------------
 vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateUserFileNode(const std::string& colorFileName)
 {
-  vtkMRMLColorTableNode * ctnode = this->CreateFileNode(colorFileName.c_str());
+  vtkMRMLColorTableNode * ctnode = this->CreateFileNode(colorFileName.c_str(), true);
   if (ctnode == 0)
     {
     return 0;
@@ -709,10 +711,24 @@ std::vector<std::string> vtkMRMLColorLogic::FindUserColorFiles()
 }
 
 //--------------------------------------------------------------------------------
-vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateFileNode(const char* fileName)
+vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateFileNode(const char* fileName, bool deferRead)
 {
+  if (deferRead && (fileName == NULL || !vtksys::SystemTools::FileExists(fileName, true)))
+    {
+    vtkErrorMacro("Unable to read file as color table " << (fileName ? fileName : "(null)"));
+    return 0;
+    }
+
   vtkMRMLColorTableNode * ctnode =  vtkMRMLColorTableNode::New();
-  ctnode->SetTypeToFile();
+  if (deferRead)
+    {
+    // the file is read by the storage node when the colors are first accessed
+    ctnode->SetTypeAsPlaceholder(vtkMRMLColorNode::File);
+    }
+  else
+    {
+    ctnode->SetTypeToFile();
+    }
   ctnode->SaveWithSceneOff();
   ctnode->HideFromEditorsOn();
   ctnode->SetScene(this->GetMRMLScene());
@@ -731,6 +747,13 @@ vtkMRMLColorTableNode* vtkMRMLColorLogic::CreateFileNode(const char* fileName)
   std::string uname( this->GetMRMLScene()->GetUniqueNameByString(basename.c_str()));
   ctnode->SetName(uname.c_str());
 
+  if (deferRead)
+    {
+    ctnode->SetSingletonTag(
+      this->GetFileColorNodeSingletonTag(fileName).c_str());
+    return ctnode;
+    }
+
   vtkDebugMacro("CreateFileNode: About to read user file " << fileName);
 
   if (ctnode->GetStorageNode()->ReadData(ctnode) == 0)
@@ -235,7 +235,11 @@ protected:
   vtkMRMLdGEMRICProceduralColorNode* CreatedGEMRICColorNode(int type);
   vtkMRMLColorTableNode* CreateDefaultFileNode(const std::string& colorname);
   vtkMRMLColorTableNode* CreateUserFileNode(const std::string& colorname);
-  vtkMRMLColorTableNode* CreateFileNode(const char* fileName);
+  /// Create a color table node and its storage node for the file.
+  /// If \a deferRead is true, the node is a placeholder: only the existence
+  /// of the file is checked, it is read when the colors are first accessed.
+  /// \sa vtkMRMLColorNode::SetTypeAsPlaceholder()
+  vtkMRMLColorTableNode* CreateFileNode(const char* fileName, bool deferRead = false);
   vtkMRMLProceduralColorNode* CreateProceduralFileNode(const char* fileName);
 
   void AddLabelsNode();
@@ -0,0 +1,113 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// QT includes
+#include <QApplication>
+#include <QSignalSpy>
+#include <QTimer>
+
+// CTK includes
+#include <ctkCoreTestingMacros.h>
+
+// qMRML includes
+#include "qMRMLNodeComboBox.h"
+#include "qMRMLSceneModel.h"
+
+// MRML includes
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkNew.h>
+
+// test that hidden comboboxes populate their model only when needed
+int qMRMLNodeComboBoxTest10( int argc, char * argv [] )
+{
+  QApplication app(argc, argv);
+
+  vtkNew<vtkMRMLScene> scene;
+
+  qMRMLNodeComboBox nodeSelector;
+  nodeSelector.setNodeTypes(QStringList("vtkMRMLScalarVolumeNode"));
+  nodeSelector.setMRMLScene(scene.GetPointer());
+  CHECK_POINTER(nodeSelector.mrmlScene(), scene.GetPointer());
+  CHECK_BOOL(nodeSelector.isEnabled(), true);
+  // not visible and no volume in the scene, the scene model is not populated
+  CHECK_NULL(nodeSelector.sortFilterProxyModel()->sceneModel()->mrmlScene());
+
+  // nodes added while the combobox is hidden do not populate the model
+  QSignalSpy nodeAddedSpy(&nodeSelector, SIGNAL(nodeAdded(vtkMRMLNode*)));
+  QSignalSpy currentNodeSpy(&nodeSelector, SIGNAL(currentNodeChanged(vtkMRMLNode*)));
+  vtkNew<vtkMRMLModelNode> modelNode;
+  scene->AddNode(modelNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode.GetPointer());
+  CHECK_NULL(nodeSelector.sortFilterProxyModel()->sceneModel()->mrmlScene());
+  CHECK_INT(nodeAddedSpy.count(), 0);
+  CHECK_INT(currentNodeSpy.count(), 0);
+  // querying the nodes does not populate the model either
+  CHECK_INT(nodeSelector.nodeCount(), 0);
+  CHECK_NULL(nodeSelector.currentNode());
+  CHECK_NULL(nodeSelector.sortFilterProxyModel()->sceneModel()->mrmlScene());
+
+  // showing the combobox populates the model and selects the volume
+  nodeSelector.show();
+  CHECK_POINTER(nodeSelector.sortFilterProxyModel()->sceneModel()->mrmlScene(), scene.GetPointer());
+  CHECK_BOOL(currentNodeSpy.count() > 0, true);
+  CHECK_INT(nodeSelector.nodeCount(), 1);
+  CHECK_POINTER(nodeSelector.currentNode(), volumeNode.GetPointer());
+
+  // the scene already contains a volume: the model is populated when the
+  // scene is set, even if the combobox is hidden
+  qMRMLNodeComboBox nodeSelector2;
+  nodeSelector2.setNodeTypes(QStringList("vtkMRMLScalarVolumeNode"));
+  QSignalSpy currentNodeSpy2(&nodeSelector2, SIGNAL(currentNodeChanged(vtkMRMLNode*)));
+  nodeSelector2.setMRMLScene(scene.GetPointer());
+  CHECK_POINTER(nodeSelector2.sortFilterProxyModel()->sceneModel()->mrmlScene(), scene.GetPointer());
+  CHECK_BOOL(currentNodeSpy2.count() > 0, true);
+  CHECK_POINTER(nodeSelector2.currentNode(), volumeNode.GetPointer());
+  CHECK_POINTER(nodeSelector2.nodeFromIndex(0), volumeNode.GetPointer());
+
+  // setting the current node populates the model
+  vtkNew<vtkMRMLScene> scene3;
+  qMRMLNodeComboBox nodeSelector3;
+  nodeSelector3.setNodeTypes(QStringList("vtkMRMLScalarVolumeNode"));
+  nodeSelector3.setNoneEnabled(true);
+  nodeSelector3.setMRMLScene(scene3.GetPointer());
+  CHECK_NULL(nodeSelector3.sortFilterProxyModel()->sceneModel()->mrmlScene());
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode3;
+  scene3->AddNode(volumeNode3.GetPointer());
+  nodeSelector3.setCurrentNodeID(volumeNode3->GetID());
+  CHECK_POINTER(nodeSelector3.sortFilterProxyModel()->sceneModel()->mrmlScene(), scene3.GetPointer());
+  CHECK_INT(nodeSelector3.nodeCount(), 1);
+  CHECK_POINTER(nodeSelector3.currentNode(), volumeNode3.GetPointer());
+
+  // scene deleted before the model is populated
+  qMRMLNodeComboBox nodeSelector4;
+  {
+  vtkNew<vtkMRMLScene> scene2;
+  nodeSelector4.setMRMLScene(scene2.GetPointer());
+  }
+  CHECK_NULL(nodeSelector4.mrmlScene());
+  CHECK_BOOL(nodeSelector4.isEnabled(), false);
+
+  if (argc < 2 || QString(argv[1]) != "-I")
+    {
+    QTimer::singleShot(200, &app, SLOT(quit()));
+    }
+
+  return app.exec();
+}
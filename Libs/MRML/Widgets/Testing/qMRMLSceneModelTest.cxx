@@ -47,6 +47,7 @@ private slots:
   void testSetColumns_data();
   void testSetColumnsWithScene();
   void testSetColumnsWithScene_data();
+  void testNodeItems();
 };
 
 // ----------------------------------------------------------------------------
@@ -192,6 +193,54 @@ void qMRMLSceneModelTester::testSetColumnsWithScene_data()
   this->testSetColumns_data();
 }
 
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelTester::testNodeItems()
+{
+  qMRMLSceneModel sceneModel;
+  sceneModel.setIDColumn(1);
+
+  qMRMLSceneFactoryWidget sceneFactory;
+  sceneFactory.generateScene();
+  for (int i=0; i < 50; ++i)
+    {
+    sceneFactory.generateNode();
+    }
+  // nodes added before and after the scene is set
+  sceneModel.setMRMLScene(sceneFactory.mrmlScene());
+  for (int i=0; i < 50; ++i)
+    {
+    sceneFactory.generateNode();
+    }
+
+  vtkMRMLScene* scene = sceneFactory.mrmlScene();
+  for (int i = 0; i < scene->GetNumberOfNodes(); ++i)
+    {
+    vtkMRMLNode* node = scene->GetNthNode(i);
+    QStandardItem* item = sceneModel.itemFromNode(node);
+    QVERIFY(item != 0);
+    QCOMPARE(sceneModel.mrmlNodeFromItem(item), node);
+    QCOMPARE(sceneModel.indexes(node).count(), 2);
+    QCOMPARE(sceneModel.indexFromNode(node, 1).data().toString(), QString(node->GetID()));
+    }
+
+  vtkMRMLNode* removedNode = scene->GetNthNode(10);
+  removedNode->Register(0);
+  scene->RemoveNode(removedNode);
+  QVERIFY(sceneModel.itemFromNode(removedNode) == 0);
+  QCOMPARE(sceneModel.indexes(removedNode).count(), 0);
+  removedNode->UnRegister(0);
+
+  // Items of the new column are created once all the columns are set,
+  // or as soon as a node item is requested
+  sceneModel.setCheckableColumn(2);
+  sceneModel.setVisibilityColumn(3);
+  QCOMPARE(sceneModel.columnCount(sceneModel.mrmlSceneIndex()), 4);
+  vtkMRMLNode* node = scene->GetNthNode(0);
+  QVERIFY(sceneModel.itemFromNode(node, 3) != 0);
+  QCOMPARE(sceneModel.indexes(node).count(), 4);
+  QCOMPARE(sceneModel.indexFromNode(node, 1).data().toString(), QString(node->GetID()));
+}
+
 // ----------------------------------------------------------------------------
 CTK_TEST_MAIN(qMRMLSceneModelTest)
 #include "moc_qMRMLSceneModelTest.cxx"
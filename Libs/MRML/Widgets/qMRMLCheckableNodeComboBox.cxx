@@ -182,6 +182,7 @@ Qt::CheckState qMRMLCheckableNodeComboBox::checkState(vtkMRMLNode* node)const
 void qMRMLCheckableNodeComboBox::setCheckState(vtkMRMLNode* node, Qt::CheckState check)
 {
   Q_D(qMRMLCheckableNodeComboBox);
+  d->updateSceneModel();
   ctkCheckableComboBox* checkableComboBox =
     qobject_cast<ctkCheckableComboBox*>(d->ComboBox);
   QModelIndexList indexes =
@@ -196,6 +197,8 @@ void qMRMLCheckableNodeComboBox::setCheckState(vtkMRMLNode* node, Qt::CheckState
 // --------------------------------------------------------------------------
 void qMRMLCheckableNodeComboBox::setUserCheckable(vtkMRMLNode* node, bool userCheckable)
 {
+  Q_D(qMRMLCheckableNodeComboBox);
+  d->updateSceneModel();
   QStandardItem* nodeItem = this->sceneModel()->itemFromNode(node);
   if (nodeItem)
     {
@@ -48,6 +48,9 @@ qMRMLNodeComboBoxPrivate::qMRMLNodeComboBoxPrivate(qMRMLNodeComboBox& object)
   this->ComboBox = 0;
   this->MRMLNodeFactory = 0;
   this->MRMLSceneModel = 0;
+  this->MRMLScene = 0;
+  this->ObservedScene = 0;
+  this->CallBack = vtkSmartPointer<vtkCallbackCommand>::New();
   this->NoneEnabled = false;
   this->AddEnabled = true;
   this->RemoveEnabled = true;
@@ -62,6 +65,7 @@ qMRMLNodeComboBoxPrivate::qMRMLNodeComboBoxPrivate(qMRMLNodeComboBox& object)
 // --------------------------------------------------------------------------
 qMRMLNodeComboBoxPrivate::~qMRMLNodeComboBoxPrivate()
 {
+  this->setObservedScene(0);
 }
 
 // --------------------------------------------------------------------------
@@ -91,6 +95,9 @@ void qMRMLNodeComboBoxPrivate::init(QAbstractItemModel* model)
 
   this->MRMLNodeFactory = new qMRMLNodeFactory(q);
 
+  this->CallBack->SetClientData(this);
+  this->CallBack->SetCallback(qMRMLNodeComboBoxPrivate::onMRMLSceneEvent);
+
   QAbstractItemModel* rootModel = model;
   while (qobject_cast<QAbstractProxyModel*>(rootModel) &&
          qobject_cast<QAbstractProxyModel*>(rootModel)->sourceModel())
@@ -135,6 +142,111 @@ void qMRMLNodeComboBoxPrivate::setModel(QAbstractItemModel* model)
   q->connect(model, SIGNAL(layoutChanged()), q, SLOT(refreshIfCurrentNodeHidden()));
 }
 
+// --------------------------------------------------------------------------
+void qMRMLNodeComboBoxPrivate::updateSceneModel()
+{
+  Q_Q(qMRMLNodeComboBox);
+  this->setObservedScene(0);
+  if (this->MRMLSceneModel->mrmlScene() == this->MRMLScene)
+    {
+    return;
+    }
+
+  QString oldCurrentNode = this->ComboBox->itemData(this->ComboBox->currentIndex(), qMRMLSceneModel::UIDRole).toString();
+  bool oldNodeCount = this->nodeCount();
+
+  this->MRMLSceneModel->setMRMLScene(this->MRMLScene);
+  this->updateDefaultText();
+  this->updateNoneItem(false);
+  this->updateActionItems(false);
+
+  //qDebug()<< "setMRMLScene:" << q->model()->index(0, 0);
+  // updating the action items reset the root model index. Set it back
+  // setting the rootmodel index looses the current item
+  this->ComboBox->setRootModelIndex(q->model()->index(0, 0));
+
+  // try to set the current item back
+  // if there was no node in the scene (or scene not set), then the
+  // oldCurrentNode was not meaningful and we probably don't want to
+  // set it back. Please consider make it a behavior property if it doesn't fit
+  // your need, as this behavior is currently wanted for some cases (
+  // vtkMRMLClipModels selector in the Models module)
+  if (oldNodeCount)
+    {
+    q->setCurrentNodeID(oldCurrentNode);
+    }
+  // if the new nodeCount is 0, then let's make sure to select 'invalid' node
+  // (None(0) or -1). we can't do nothing otherwise the Scene index (rootmodelIndex)
+  // would be selected and "Scene" would be displayed (see vtkMRMLNodeComboboxTest5)
+  else
+    {
+    q->setCurrentNodeID(q->currentNodeID());
+    }
+}
+
+// --------------------------------------------------------------------------
+void qMRMLNodeComboBoxPrivate::setObservedScene(vtkMRMLScene* scene)
+{
+  if (this->ObservedScene == scene)
+    {
+    return;
+    }
+  if (this->ObservedScene)
+    {
+    this->ObservedScene->RemoveObserver(this->CallBack);
+    }
+  this->ObservedScene = scene;
+  if (this->ObservedScene)
+    {
+    this->ObservedScene->AddObserver(vtkCommand::DeleteEvent, this->CallBack);
+    }
+}
+
+// --------------------------------------------------------------------------
+void qMRMLNodeComboBoxPrivate::onMRMLSceneEvent(vtkObject* vtk_obj, unsigned long event,
+                                                void* client_data, void* call_data)
+{
+  Q_UNUSED(vtk_obj);
+  Q_UNUSED(call_data);
+  qMRMLNodeComboBoxPrivate* d = reinterpret_cast<qMRMLNodeComboBoxPrivate*>(client_data);
+  Q_ASSERT(d);
+  if (event == vtkCommand::DeleteEvent)
+    {
+    d->q_ptr->setMRMLScene(0);
+    }
+}
+
+// --------------------------------------------------------------------------
+bool qMRMLNodeComboBoxPrivate::hasNodesOfDisplayedTypes(vtkMRMLScene* scene)const
+{
+  Q_Q(const qMRMLNodeComboBox);
+  QStringList nodeTypes = q->nodeTypes();
+  if (nodeTypes.isEmpty())
+    {
+    return scene->GetNumberOfNodes() > 0;
+    }
+  foreach(const QString& nodeType, nodeTypes)
+    {
+    if (scene->GetFirstNodeByClass(nodeType.toLatin1()))
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+// --------------------------------------------------------------------------
+int qMRMLNodeComboBoxPrivate::nodeCount()const
+{
+  int extraItemsCount =
+    this->MRMLSceneModel->preItems(this->MRMLSceneModel->mrmlSceneItem()).count()
+    + this->MRMLSceneModel->postItems(this->MRMLSceneModel->mrmlSceneItem()).count();
+  //qDebug() << this->MRMLSceneModel->invisibleRootItem() << this->MRMLSceneModel->mrmlSceneItem() << this->ComboBox->count() <<extraItemsCount;
+  //printStandardItem(this->MRMLSceneModel->invisibleRootItem(), "  ");
+  //qDebug() << this->ComboBox->rootModelIndex();
+  return this->MRMLSceneModel->mrmlScene() ? this->ComboBox->count() - extraItemsCount : 0;
+}
+
 // --------------------------------------------------------------------------
 vtkMRMLNode* qMRMLNodeComboBoxPrivate::mrmlNode(int row)const
 {
@@ -695,20 +807,14 @@ void qMRMLNodeComboBox::emitNodeActivated(int currentIndex)
 vtkMRMLScene* qMRMLNodeComboBox::mrmlScene()const
 {
   Q_D(const qMRMLNodeComboBox);
-  return d->MRMLSceneModel->mrmlScene();
+  return d->MRMLScene;
 }
 
 // --------------------------------------------------------------------------
 int qMRMLNodeComboBox::nodeCount()const
 {
   Q_D(const qMRMLNodeComboBox);
-  int extraItemsCount =
-    d->MRMLSceneModel->preItems(d->MRMLSceneModel->mrmlSceneItem()).count()
-    + d->MRMLSceneModel->postItems(d->MRMLSceneModel->mrmlSceneItem()).count();
-  //qDebug() << d->MRMLSceneModel->invisibleRootItem() << d->MRMLSceneModel->mrmlSceneItem() << d->ComboBox->count() <<extraItemsCount;
-  //printStandardItem(d->MRMLSceneModel->invisibleRootItem(), "  ");
-  //qDebug() << d->ComboBox->rootModelIndex();
-  return this->mrmlScene() ? d->ComboBox->count() - extraItemsCount : 0;
+  return d->nodeCount();
 }
 
 // --------------------------------------------------------------------------
@@ -732,46 +838,34 @@ void qMRMLNodeComboBox::setMRMLScene(vtkMRMLScene* scene)
   // Be careful when commenting that out. you really need a good reason for
   // forcing a new set. You should probably expose
   // qMRMLSceneModel::UpdateScene() and make sure there is no nested calls
-  if (d->MRMLSceneModel->mrmlScene() == scene)
+  if (d->MRMLScene == scene)
     {
     return ;
     }
+  d->MRMLScene = scene;
 
   // The Add button is valid only if the scene is non-empty
   //this->setAddEnabled(scene != 0);
-  QString oldCurrentNode = d->ComboBox->itemData(d->ComboBox->currentIndex(), qMRMLSceneModel::UIDRole).toString();
-  bool oldNodeCount = this->nodeCount();
 
   // Update factory
   d->MRMLNodeFactory->setMRMLScene(scene);
-  d->MRMLSceneModel->setMRMLScene(scene);
-  d->updateDefaultText();
-  d->updateNoneItem(false);
-  d->updateActionItems(false);
-
-  //qDebug()<< "setMRMLScene:" << this->model()->index(0, 0);
-  // updating the action items reset the root model index. Set it back
-  // setting the rootmodel index looses the current item
-  d->ComboBox->setRootModelIndex(this->model()->index(0, 0));
 
-  // try to set the current item back
-  // if there was no node in the scene (or scene not set), then the
-  // oldCurrentNode was not meaningful and we probably don't want to
-  // set it back. Please consider make it a behavior property if it doesn't fit
-  // your need, as this behavior is currently wanted for some cases (
-  // vtkMRMLClipModels selector in the Models module)
-  if (oldNodeCount)
-    {
-    this->setCurrentNodeID(oldCurrentNode);
-    }
-  // if the new nodeCount is 0, then let's make sure to select 'invalid' node
-  // (None(0) or -1). we can't do nothing otherwise the Scene index (rootmodelIndex)
-  // would be selected and "Scene" would be displayed (see vtkMRMLNodeComboboxTest5)
-  else
-    {
-    this->setCurrentNodeID(this->currentNodeID());
+  // Each combobox has its own scene model that processes all the node
+  // additions and removals. Comboboxes of module panels that are not shown
+  // populate their model only when they are shown or when their current node
+  // is set. If the scene already contains nodes to list, the model is
+  // populated now so that currentNodeChanged() is emitted as usual.
+  if (scene && !d->MRMLSceneModel->mrmlScene() &&
+      !this->isVisible() && !d->MRMLSceneModel->lazyUpdate() &&
+      !d->hasNodesOfDisplayedTypes(scene))
+    {
+    d->updateDefaultText();
+    d->setObservedScene(scene);
+    this->setEnabled(true);
+    return;
     }
 
+  d->updateSceneModel();
   this->setEnabled(scene != 0);
 }
 
@@ -792,6 +886,7 @@ void qMRMLNodeComboBox::setCurrentNode(const QString& nodeID)
 void qMRMLNodeComboBox::setCurrentNodeID(const QString& nodeID)
 {
   Q_D(qMRMLNodeComboBox);
+  d->updateSceneModel();
   // A straight forward implementation of setCurrentNode would be:
   //    int index = !nodeID.isEmpty() ? d->ComboBox->findData(nodeID, qMRMLSceneModel::UIDRole) : -1;
   //    if (index == -1 && d->NoneEnabled)
@@ -836,6 +931,7 @@ void qMRMLNodeComboBox::setCurrentNodeID(const QString& nodeID)
 void qMRMLNodeComboBox::setCurrentNodeIndex(int index)
 {
   Q_D(qMRMLNodeComboBox);
+  d->updateSceneModel();
   if (index >= this->nodeCount())
     {
     index = -1;
@@ -1178,6 +1274,14 @@ void qMRMLNodeComboBox::changeEvent(QEvent *event)
   this->Superclass::changeEvent(event);
 }
 
+//--------------------------------------------------------------------------
+void qMRMLNodeComboBox::showEvent(QShowEvent *event)
+{
+  Q_D(qMRMLNodeComboBox);
+  d->updateSceneModel();
+  this->Superclass::showEvent(event);
+}
+
 // --------------------------------------------------------------------------
 void qMRMLNodeComboBox::addMenuAction(QAction *newAction)
 {
@@ -261,6 +261,11 @@ public:
 public slots:
   /// Set the scene the combobox listens to. The scene is observed and when new
   /// nodes are added to the scene, the menu list is populated.
+  /// If the combobox is not visible and the scene has no node of the node
+  /// types, the list is populated only when the combobox is shown or when the
+  /// current node is set. Until then, nodes added to the scene are not
+  /// listed: nodeCount() is 0, currentNode() is 0 and no nodeAdded() or
+  /// currentNodeChanged() signal is emitted for them.
   virtual void setMRMLScene(vtkMRMLScene* scene);
 
   /// Select the node to be current
@@ -371,6 +376,7 @@ protected:
   QComboBox* comboBox()const;
 
   virtual void changeEvent(QEvent* event);
+  virtual void showEvent(QShowEvent* event);
 
 protected slots:
   void activateExtraItem(const QModelIndex& index);
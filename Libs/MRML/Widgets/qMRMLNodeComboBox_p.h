@@ -41,6 +41,10 @@ class QComboBox;
 class qMRMLNodeFactory;
 class qMRMLSceneModel;
 
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkSmartPointer.h>
+
 // -----------------------------------------------------------------------------
 class qMRMLNodeComboBoxPrivate
 {
@@ -53,6 +57,18 @@ public:
   virtual ~qMRMLNodeComboBoxPrivate();
   virtual void init(QAbstractItemModel* model);
 
+  /// Set the scene of the scene model if it has not been done yet.
+  /// \sa qMRMLNodeComboBox::setMRMLScene()
+  void updateSceneModel();
+  /// Observe the deletion of the scene until the scene model is populated
+  void setObservedScene(vtkMRMLScene* scene);
+  static void onMRMLSceneEvent(vtkObject* vtk_obj, unsigned long event,
+                               void* client_data, void* call_data);
+  /// Return true if the scene contains nodes of one of the node types
+  bool hasNodesOfDisplayedTypes(vtkMRMLScene* scene)const;
+  /// Number of nodes in the scene model
+  int nodeCount()const;
+
   vtkMRMLNode* mrmlNode(int row)const;
   vtkMRMLNode* mrmlNodeFromIndex(const QModelIndex& index)const;
   QModelIndexList indexesFromMRMLNodeID(const QString& nodeID)const;
@@ -67,6 +83,10 @@ public:
   QComboBox*        ComboBox;
   qMRMLNodeFactory* MRMLNodeFactory;
   qMRMLSceneModel*  MRMLSceneModel;
+  /// Scene set with setMRMLScene(). The scene model may not have it yet.
+  vtkMRMLScene*     MRMLScene;
+  vtkMRMLScene*     ObservedScene;
+  vtkSmartPointer<vtkCallbackCommand> CallBack;
   bool              NoneEnabled;
   bool              AddEnabled;
   bool              RemoveEnabled;
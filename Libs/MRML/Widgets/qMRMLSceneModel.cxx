@@ -61,6 +61,7 @@ qMRMLSceneModelPrivate::qMRMLSceneModelPrivate(qMRMLSceneModel& object)
 
   this->MRMLScene = 0;
   this->DraggedItem = 0;
+  this->NodeItemsUpdatePending = false;
 
   qRegisterMetaType<QStandardItem* >("QStandardItem*");
 }
@@ -81,6 +82,14 @@ void qMRMLSceneModelPrivate::init()
   this->CallBack->SetClientData(q);
   this->CallBack->SetCallback(qMRMLSceneModel::onMRMLSceneEvent);
 
+  // Connected first so that the node items are indexed before any other
+  // observer of the model is notified.
+  QObject::connect(q, SIGNAL(rowsInserted(QModelIndex,int,int)),
+                   q, SLOT(onRowsInserted(QModelIndex,int,int)));
+  QObject::connect(q, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+                   q, SLOT(onRowsAboutToBeRemoved(QModelIndex,int,int)));
+  QObject::connect(q, SIGNAL(modelAboutToBeReset()),
+                   q, SLOT(onModelAboutToBeReset()));
   QObject::connect(q, SIGNAL(itemChanged(QStandardItem*)),
                    q, SLOT(onItemChanged(QStandardItem*)));
 
@@ -92,21 +101,13 @@ void qMRMLSceneModelPrivate::init()
 QModelIndexList qMRMLSceneModelPrivate::indexes(const QString& nodeID)const
 {
   Q_Q(const qMRMLSceneModel);
-  QModelIndex scene = q->mrmlSceneIndex();
-  if (scene == QModelIndex())
-    {
-    return QModelIndexList();
-    }
-  // QAbstractItemModel::match doesn't browse through columns
-  // we need to do it manually
-  QModelIndexList nodeIndexes = q->match(
-    scene, qMRMLSceneModel::UIDRole, nodeID,
-    1, Qt::MatchExactly | Qt::MatchRecursive);
-  Q_ASSERT(nodeIndexes.size() <= 1); // we know for sure it won't be more than 1
-  if (nodeIndexes.size() == 0)
+  QModelIndexList nodeIndexes;
+  QStandardItem* nodeItem = this->NodeItems.value(nodeID, 0);
+  if (nodeItem == 0)
     {
     return nodeIndexes;
     }
+  nodeIndexes << nodeItem->index();
   // Add the QModelIndexes from the other columns
   const int row = nodeIndexes[0].row();
   QModelIndex nodeParentIndex = nodeIndexes[0].parent();
@@ -118,6 +119,93 @@ QModelIndexList qMRMLSceneModelPrivate::indexes(const QString& nodeID)const
   return nodeIndexes;
 }
 
+//------------------------------------------------------------------------------
+QString qMRMLSceneModelPrivate::nodeItemUID(const QStandardItem* item)const
+{
+  // Only node items and the scene item have a pointer
+  if (!item || !item->data(qMRMLSceneModel::PointerRole).isValid())
+    {
+    return QString();
+    }
+  QString uid = item->data(qMRMLSceneModel::UIDRole).toString();
+  return uid == "scene" ? QString() : uid;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::addNodeItems(QStandardItem* parent, int first, int last)
+{
+  for (int row = first; row <= last; ++row)
+    {
+    QStandardItem* item = parent->child(row, 0);
+    if (!item)
+      {
+      continue;
+      }
+    QString uid = this->nodeItemUID(item);
+    if (!uid.isEmpty())
+      {
+      this->NodeItems[uid] = item;
+      }
+    if (item->rowCount())
+      {
+      this->addNodeItems(item, 0, item->rowCount() - 1);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::removeNodeItems(QStandardItem* parent, int first, int last)
+{
+  for (int row = first; row <= last; ++row)
+    {
+    QStandardItem* item = parent->child(row, 0);
+    if (!item)
+      {
+      continue;
+      }
+    QString uid = this->nodeItemUID(item);
+    // With drag&drop, the row is copied before the original row is removed:
+    // the index already points to the copy.
+    QHash<QString, QStandardItem*>::iterator it = this->NodeItems.find(uid);
+    if (it != this->NodeItems.end() && it.value() == item)
+      {
+      this->NodeItems.erase(it);
+      }
+    if (item->rowCount())
+      {
+      this->removeNodeItems(item, 0, item->rowCount() - 1);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::scheduleNodeItemsUpdate()
+{
+  Q_Q(qMRMLSceneModel);
+  if (this->NodeItemsUpdatePending)
+    {
+    return;
+    }
+  this->NodeItemsUpdatePending = true;
+  QTimer::singleShot(0, q, SLOT(updatePendingNodeItems()));
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::flushNodeItemsUpdate()
+{
+  Q_Q(qMRMLSceneModel);
+  if (!this->NodeItemsUpdatePending)
+    {
+    return;
+    }
+  this->NodeItemsUpdatePending = false;
+  if (!this->MRMLScene)
+    {
+    return;
+    }
+  q->updateNodeItems();
+}
+
 //------------------------------------------------------------------------------
 void qMRMLSceneModelPrivate::listenNodeModifiedEvent()
 {
@@ -439,55 +527,20 @@ QModelIndex qMRMLSceneModel::indexFromNode(vtkMRMLNode* node, int column)const
     {
     return QModelIndex();
     }
+  // Items of new columns may not have been created yet
+  const_cast<qMRMLSceneModelPrivate*>(d)->flushNodeItemsUpdate();
 
-  QModelIndex nodeIndex;
-
-  // Try to find the nodeIndex in the cache first
-  QMap<vtkMRMLNode*,QPersistentModelIndex>::iterator rowCacheIt=d->RowCache.find(node);
-  if (rowCacheIt==d->RowCache.end())
-    {
-    // not found in cache, therefore it cannot be in the model
-    return nodeIndex;
-    }
-  if (rowCacheIt.value().isValid())
-    {
-    // An entry found in the cache. If the item at the cached index matches the requested node ID
-    // then we use it.
-    QStandardItem* nodeItem = this->itemFromIndex(rowCacheIt.value());
-    if (nodeItem!=NULL)
-      {
-      if (nodeItem->data(qMRMLSceneModel::UIDRole).toString().compare(QLatin1String(node->GetID()))==0)
-        {
-        // id matched
-        nodeIndex=rowCacheIt.value();
-        }
-      }
-    }
-
-  // The cache was not up-to-date. Do a slow linear search.
-  if (!nodeIndex.isValid())
+  QStandardItem* nodeItem = d->NodeItems.value(QString(node->GetID()), 0);
+  if (nodeItem == 0)
     {
-    // QAbstractItemModel::match doesn't browse through columns
-    // we need to do it manually
-    QModelIndexList nodeIndexes = this->match(
-      this->mrmlSceneIndex(), qMRMLSceneModel::UIDRole, QString(node->GetID()),
-      1, Qt::MatchExactly | Qt::MatchRecursive);
-    Q_ASSERT(nodeIndexes.size() <= 1); // we know for sure it won't be more than 1
-    if (nodeIndexes.size() == 0)
-      {
-      // maybe the node hasn't been added to the scene yet...
-      // (if it's called from populateScene/inserteNode)
-      d->RowCache.remove(node);
-      return QModelIndex();
-      }
-    nodeIndex=nodeIndexes[0];
-    d->RowCache[node]=nodeIndex;
+    // maybe the node hasn't been added to the scene yet...
+    // (if it's called from populateScene/inserteNode)
+    return QModelIndex();
     }
+  QModelIndex nodeIndex = nodeItem->index();
   if (column == 0)
     {
-    // QAbstractItemModel::match only search through the first column
-    // (because scene is in the first column)
-    Q_ASSERT(nodeIndex.isValid());
+    // Only the items of the first column are indexed
     return nodeIndex;
     }
   // Add the QModelIndexes from the other columns
@@ -501,6 +554,7 @@ QModelIndex qMRMLSceneModel::indexFromNode(vtkMRMLNode* node, int column)const
 QModelIndexList qMRMLSceneModel::indexes(vtkMRMLNode* node)const
 {
   Q_D(const qMRMLSceneModel);
+  const_cast<qMRMLSceneModelPrivate*>(d)->flushNodeItemsUpdate();
   return d->indexes(QString(node->GetID()));
 }
 
@@ -698,7 +752,8 @@ void qMRMLSceneModel::updateScene()
   qvtkDisconnect(0, vtkMRMLNode::IDChangedEvent,
                  this, SLOT(onMRMLNodeIDChanged(vtkObject*,void*)));
 
-  d->RowCache.clear();
+  // All the node items are recreated
+  d->NodeItemsUpdatePending = false;
 
   // Enabled so it can be interacted with
   this->invisibleRootItem()->setFlags(Qt::ItemIsEnabled);
@@ -839,13 +894,9 @@ QStandardItem* qMRMLSceneModel::insertNode(vtkMRMLNode* node, QStandardItem* par
     items.append(newNodeItem);
     }
 
-  // Insert an invalid item in the cache to indicate that the node is in the model
-  // but we don't know its index yet. This is needed because a custom widget may be notified
-  // abot row insertion before insertRow() returns (and the RowCache entry is added).
-  // For example, qSlicerPresetComboBox::setIconToPreset() is called at the end of insertRow,
-  // before the RowCache entry is added.
-  d->RowCache[node]=QModelIndex();
-
+  // The item is indexed in onRowsInserted(), before any other observer of the
+  // model is notified (e.g. qSlicerPresetComboBox::setIconToPreset() is called
+  // at the end of insertRow and looks up the node item).
   if (parent)
     {
     parent->insertRow(row, items);
@@ -855,7 +906,6 @@ QStandardItem* qMRMLSceneModel::insertNode(vtkMRMLNode* node, QStandardItem* par
     {
     this->insertRow(row,items);
     }
-  d->RowCache[node]=items[0]->index();
   // TODO: don't listen to nodes that are hidden from editors ?
   if (d->ListenNodeModifiedEvent == AllNodes)
     {
@@ -882,10 +932,21 @@ void qMRMLSceneModel::updateItemFromNode(QStandardItem* item, vtkMRMLNode* node,
   d->PendingItemModified = 0;
   item->setFlags(this->nodeFlags(node, column));
   // set UIDRole and set PointerRole need to be atomic
+  QString oldUID = item->data(qMRMLSceneModel::UIDRole).toString();
+  QString uid(node->GetID());
   bool blocked  = this->blockSignals(true);
-  item->setData(QString(node->GetID()), qMRMLSceneModel::UIDRole);
+  item->setData(uid, qMRMLSceneModel::UIDRole);
   item->setData(QVariant::fromValue(reinterpret_cast<long long>(node)), qMRMLSceneModel::PointerRole);
   this->blockSignals(blocked);
+  // The node ID has changed, reindex the item
+  if (oldUID != uid && item->column() == 0 && item->model() == this)
+    {
+    if (d->NodeItems.value(oldUID, 0) == item)
+      {
+      d->NodeItems.remove(oldUID);
+      }
+    d->NodeItems[uid] = item;
+    }
   this->updateItemDataFromNode(item, node, column);
 
   bool itemChanged = (d->PendingItemModified > 0);
@@ -1250,13 +1311,9 @@ void qMRMLSceneModel::onMRMLSceneNodeAboutToBeRemoved(vtkMRMLScene* scene, vtkMR
   // Remove all the observations on the node
   qvtkDisconnect(node, vtkCommand::NoEvent, this, 0);
 
-  // TODO: can be fasten by browsing the tree only once
-  QModelIndexList indexes = this->match(this->mrmlSceneIndex(), qMRMLSceneModel::UIDRole,
-                                        QString(node->GetID()), 1,
-                                        Qt::MatchExactly | Qt::MatchRecursive);
-  if (indexes.count())
+  QStandardItem* item = d->NodeItems.value(QString(node->GetID()), 0);
+  if (item)
     {
-    QStandardItem* item = this->itemFromIndex(indexes[0].sibling(indexes[0].row(),0));
     // The children may be lost if not reparented, we ensure they got reparented.
     while (item->rowCount())
       {
@@ -1273,7 +1330,8 @@ void qMRMLSceneModel::onMRMLSceneNodeAboutToBeRemoved(vtkMRMLScene* scene, vtkMR
         d->Orphans.removeAll(orphans);
         }
       }
-    this->removeRow(indexes[0].row(), indexes[0].parent());
+    QModelIndex index = item->index();
+    this->removeRow(index.row(), index.parent());
     }
 }
 
@@ -1347,6 +1405,8 @@ void printStandardItem(QStandardItem* item, const QString& offset)
 //------------------------------------------------------------------------------
 void qMRMLSceneModel::updateNodeItems()
 {
+  Q_D(qMRMLSceneModel);
+  d->NodeItemsUpdatePending = false;
   QStandardItem* sceneItem = this->mrmlSceneItem();
   if (sceneItem == 0)
     {
@@ -1437,6 +1497,16 @@ void qMRMLSceneModel::onItemChanged(QStandardItem * item)
 {
   Q_D(qMRMLSceneModel);
 
+  // Items dropped by drag&drop may be set after their row is inserted
+  if (item && item->column() == 0)
+    {
+    QString uid = d->nodeItemUID(item);
+    if (!uid.isEmpty() && d->NodeItems.value(uid, 0) != item)
+      {
+      d->NodeItems[uid] = item;
+      }
+    }
+
   if (d->PendingItemModified >= 0)
     {
     ++d->PendingItemModified;
@@ -1649,6 +1719,7 @@ void qMRMLSceneModel::setExtraItemColumn(int column)
 //------------------------------------------------------------------------------
 void qMRMLSceneModel::updateColumnCount()
 {
+  Q_D(qMRMLSceneModel);
   int max = this->maxColumnId();
   int oldColumnCount = this->columnCount();
   this->setColumnCount(max + 1);
@@ -1658,10 +1729,49 @@ void qMRMLSceneModel::updateColumnCount()
     }
   else
     {
-    this->updateNodeItems();
+    // Columns are typically set one after the other, update the items
+    // only once all the columns are set. Node lookups update the items
+    // right away if they are requested before.
+    if (this->mrmlSceneItem())
+      {
+      this->mrmlSceneItem()->setColumnCount(this->columnCount());
+      }
+    d->scheduleNodeItemsUpdate();
     }
 }
 
+//------------------------------------------------------------------------------
+void qMRMLSceneModel::updatePendingNodeItems()
+{
+  Q_D(qMRMLSceneModel);
+  d->flushNodeItemsUpdate();
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModel::onRowsInserted(const QModelIndex& parent, int start, int end)
+{
+  Q_D(qMRMLSceneModel);
+  QStandardItem* parentItem = parent.isValid() ?
+    this->itemFromIndex(parent) : this->invisibleRootItem();
+  d->addNodeItems(parentItem, start, end);
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModel::onRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end)
+{
+  Q_D(qMRMLSceneModel);
+  QStandardItem* parentItem = parent.isValid() ?
+    this->itemFromIndex(parent) : this->invisibleRootItem();
+  d->removeNodeItems(parentItem, start, end);
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModel::onModelAboutToBeReset()
+{
+  Q_D(qMRMLSceneModel);
+  d->NodeItems.clear();
+}
+
 //------------------------------------------------------------------------------
 int qMRMLSceneModel::maxColumnId()const
 {
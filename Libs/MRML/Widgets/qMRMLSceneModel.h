@@ -245,6 +245,16 @@ protected slots:
   /// Needs maxColumnId() to be reimplemented in subclasses
   void updateColumnCount();
 
+  /// Keep the node ID to item index in sync with the model rows
+  void onRowsInserted(const QModelIndex& parent, int start, int end);
+  void onRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end);
+  void onModelAboutToBeReset();
+
+  /// Update all the node items if an update has been requested since the
+  /// last call.
+  /// \sa updateColumnCount()
+  void updatePendingNodeItems();
+
 signals:
   /// This signal is sent when a user is about to reparent a Node by
   /// a drag and drop
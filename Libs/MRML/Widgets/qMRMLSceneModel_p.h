@@ -35,6 +35,7 @@
 // Qt includes
 class QStandardItemModel;
 #include <QFlags>
+#include <QHash>
 #include <QMap>
 
 // qMRML includes
@@ -71,6 +72,23 @@ public:
   void listenNodeModifiedEvent();
   void reparentItems(QList<QStandardItem*>& children, int newIndex, QStandardItem* newParent);
 
+  /// Add the node items of the rows [first, last] of \a parent and
+  /// of all their descendants to NodeItems.
+  void addNodeItems(QStandardItem* parent, int first, int last);
+  /// Remove the node items of the rows [first, last] of \a parent and
+  /// of all their descendants from NodeItems.
+  void removeNodeItems(QStandardItem* parent, int first, int last);
+  /// Return the node ID of the item if it is a node item, an empty
+  /// string otherwise (scene, extra items...)
+  QString nodeItemUID(const QStandardItem* item)const;
+  /// Request an update of all the node items. Multiple requests in the
+  /// same event loop iteration result in a single update.
+  void scheduleNodeItemsUpdate();
+  /// Update the node items now if an update has been requested, so that
+  /// node lookups never return items that are not up-to-date.
+  /// \sa scheduleNodeItemsUpdate()
+  void flushNodeItemsUpdate();
+
   /// This method is called by qMRMLSceneModel::populateScene() to speed up
   /// the loading of large scene. By explicitly specifying the \a index, it
   /// skips repetitive scene traversal calls caused by
@@ -101,12 +119,13 @@ public:
   // likely to be unreachable when browsing the model
   QList<QList<QStandardItem*> > Orphans;
 
-  // Map from MRML node to row.
-  // It just stores the result of the latest lookup by indexFromNode,
-  // not guaranteed to contain up-to-date information, should be just used
-  // as a search hint. If the node cannot be found at the given index then
-  // we need to browse through all model items.
-  mutable QMap<vtkMRMLNode*,QPersistentModelIndex> RowCache;
+  // Map from node ID to the item of the first column of the node row.
+  // It is updated when rows are inserted or removed (including when they
+  // are moved for reparenting) and when the node ID changes, so that node
+  // items can be found without browsing through all model items.
+  // A node is in the model if and only if its ID is in the map.
+  QHash<QString, QStandardItem*> NodeItems;
+  bool NodeItemsUpdatePending;
 };
 
 #endif
@@ -0,0 +1,652 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// RemoteIO includes
+#include "vtkHTTPTransferEngine.h"
+
+// MRML includes
+#include <vtkCacheManager.h>
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET SocketType;
+typedef int SocketLengthType;
+#define CloseSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketType;
+typedef socklen_t SocketLengthType;
+#define INVALID_SOCKET (-1)
+#define CloseSocket close
+#endif
+
+#if defined(MSG_NOSIGNAL)
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+// Local files served through file:// URLs stand in for the HTTP server:
+// curl supports ranged and resumed reads on them.
+std::string WriteSourceFile(const std::string& directory, const std::string& name, int size)
+{
+  // Content only depends on the position so that a shorter file
+  // is a valid prefix of a longer one.
+  std::string fileName = directory + "/" + name;
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  for (int i = 0; i < size; ++i)
+    {
+    file.put(static_cast<char>((i * 7 + i / 251) % 256));
+    }
+  return fileName;
+}
+
+//---------------------------------------------------------------------------
+std::string FileURL(const std::string& fileName)
+{
+  std::string url = "file://";
+  if (fileName.empty() || fileName[0] != '/')
+    {
+    url += "/";
+    }
+  return url + fileName;
+}
+
+//---------------------------------------------------------------------------
+bool SameContent(const std::string& fileName1, const std::string& fileName2)
+{
+  return vtksys::SystemTools::FileExists(fileName2.c_str(), true)
+    && !vtksys::SystemTools::FilesDiffer(fileName1, fileName2);
+}
+
+//---------------------------------------------------------------------------
+/// Minimal HTTP/1.1 server on the loopback interface, serving the same
+/// content for any path. Connections are handled one at a time and closed
+/// after each response.
+class LoopbackServer
+{
+public:
+  struct Request
+    {
+    std::string Method;
+    /// First byte of the requested range, -1 if no range was requested.
+    vtkTypeInt64 RangeBegin;
+    };
+
+  LoopbackServer(const std::string& content)
+    : HonorRanges(true)
+    , TruncatedRangeBegin(-1)
+    , RangesFileUpdateInterval(0)
+    , Content(content)
+    , CommittedDuringStall(-1)
+    , Socket(INVALID_SOCKET)
+    , Port(0)
+    , ThreadId(-1)
+    , Stopping(false)
+    {
+    }
+
+  ~LoopbackServer()
+    {
+    this->Stop();
+    }
+
+  /// If false, range requests are answered with the whole content (200).
+  bool HonorRanges;
+  /// A range request starting at this byte gets half of its data, then the
+  /// connection stalls and is closed. During the stall, the progress saved
+  /// for that range in \a RangesFile is read, see GetCommittedDuringStall().
+  vtkTypeInt64 TruncatedRangeBegin;
+  std::string RangesFile;
+  /// The stall lasts until the progress saved in \a RangesFile is within
+  /// this many bytes of the data sent, the client then has saved all it can.
+  vtkTypeInt64 RangesFileUpdateInterval;
+
+  bool Start()
+    {
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+      {
+      return false;
+      }
+#endif
+    this->Socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (this->Socket == INVALID_SOCKET)
+      {
+      return false;
+      }
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    SocketLengthType length = sizeof(address);
+    if (bind(this->Socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+      || listen(this->Socket, 16) != 0
+      || getsockname(this->Socket, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+      {
+      return false;
+      }
+    this->Port = ntohs(address.sin_port);
+    this->ThreadId = this->Threader->SpawnThread(&LoopbackServer::Run, this);
+    return this->ThreadId >= 0;
+    }
+
+  void Stop()
+    {
+    if (this->ThreadId >= 0)
+      {
+      this->Lock->Lock();
+      this->Stopping = true;
+      this->Lock->Unlock();
+      this->Threader->TerminateThread(this->ThreadId);
+      this->ThreadId = -1;
+      }
+    if (this->Socket != INVALID_SOCKET)
+      {
+      CloseSocket(this->Socket);
+      this->Socket = INVALID_SOCKET;
+#ifdef _WIN32
+      WSACleanup();
+#endif
+      }
+    }
+
+  std::string GetURL(const std::string& name)
+    {
+    std::stringstream url;
+    url << "http://127.0.0.1:" << this->Port << "/" << name;
+    return url.str();
+    }
+
+  std::vector<Request> GetRequests()
+    {
+    this->Lock->Lock();
+    std::vector<Request> requests = this->Requests;
+    this->Lock->Unlock();
+    return requests;
+    }
+
+  vtkTypeInt64 GetCommittedDuringStall()
+    {
+    this->Lock->Lock();
+    vtkTypeInt64 committed = this->CommittedDuringStall;
+    this->Lock->Unlock();
+    return committed;
+    }
+
+  void ClearRequests()
+    {
+    this->Lock->Lock();
+    this->Requests.clear();
+    this->Lock->Unlock();
+    }
+
+private:
+  static VTK_THREAD_RETURN_TYPE Run(void* arg)
+    {
+    vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    LoopbackServer* self = static_cast<LoopbackServer*>(info->UserData);
+    while (true)
+      {
+      self->Lock->Lock();
+      bool stopping = self->Stopping;
+      self->Lock->Unlock();
+      if (stopping)
+        {
+        break;
+        }
+      // Wake up regularly to check whether the server is stopped
+      fd_set sockets;
+      FD_ZERO(&sockets);
+      FD_SET(self->Socket, &sockets);
+      timeval timeout;
+      timeout.tv_sec = 0;
+      timeout.tv_usec = 50000;
+      if (select(static_cast<int>(self->Socket + 1), &sockets, NULL, NULL, &timeout) <= 0)
+        {
+        continue;
+        }
+      SocketType connection = accept(self->Socket, NULL, NULL);
+      if (connection != INVALID_SOCKET)
+        {
+        self->Serve(connection);
+        CloseSocket(connection);
+        }
+      }
+    return VTK_THREAD_RETURN_VALUE;
+    }
+
+  void Serve(SocketType connection)
+    {
+    std::string header;
+    char buffer[1024];
+    while (header.find("\r\n\r\n") == std::string::npos)
+      {
+      int received = recv(connection, buffer, sizeof(buffer), 0);
+      if (received <= 0)
+        {
+        return;
+        }
+      header.append(buffer, received);
+      }
+    Request request;
+    request.Method = header.substr(0, header.find(' '));
+    request.RangeBegin = -1;
+    vtkTypeInt64 rangeEnd = -1;
+    std::string lowerHeader = vtksys::SystemTools::LowerCase(header);
+    size_t rangePosition = lowerHeader.find("\r\nrange: bytes=");
+    if (rangePosition != std::string::npos)
+      {
+      std::stringstream range(header.substr(rangePosition + strlen("\r\nrange: bytes=")));
+      char dash = 0;
+      range >> request.RangeBegin >> dash;
+      if (!(range >> rangeEnd))
+        {
+        rangeEnd = -1;
+        }
+      }
+    this->Lock->Lock();
+    this->Requests.push_back(request);
+    this->Lock->Unlock();
+
+    vtkTypeInt64 size = static_cast<vtkTypeInt64>(this->Content.size());
+    vtkTypeInt64 begin = 0;
+    vtkTypeInt64 end = size - 1;
+    std::stringstream response;
+    if (request.RangeBegin >= 0 && this->HonorRanges)
+      {
+      begin = request.RangeBegin;
+      end = (rangeEnd >= 0 && rangeEnd < size) ? rangeEnd : size - 1;
+      response << "HTTP/1.1 206 Partial Content\r\n"
+               << "Content-Range: bytes " << begin << "-" << end << "/" << size << "\r\n";
+      }
+    else
+      {
+      response << "HTTP/1.1 200 OK\r\n";
+      }
+    response << "Content-Length: " << (end - begin + 1) << "\r\n"
+             << "Accept-Ranges: bytes\r\n"
+             << "Connection: close\r\n\r\n";
+    if (!this->Send(connection, response.str().c_str(), response.str().size())
+      || request.Method == "HEAD")
+      {
+      return;
+      }
+
+    bool truncate = (request.RangeBegin >= 0 && request.RangeBegin == this->TruncatedRangeBegin);
+    vtkTypeInt64 length = truncate ? (end - begin + 1) / 2 : end - begin + 1;
+    if (!this->Send(connection, this->Content.c_str() + begin, static_cast<size_t>(length)))
+      {
+      return;
+      }
+    if (truncate)
+      {
+      // Only truncate once, the resumed request gets the rest of the range
+      this->TruncatedRangeBegin = -1;
+      vtkTypeInt64 committed = this->WaitForCommitted(begin, length - this->RangesFileUpdateInterval + 1);
+      this->Lock->Lock();
+      this->CommittedDuringStall = committed;
+      this->Lock->Unlock();
+      }
+    }
+
+  bool Send(SocketType connection, const char* data, size_t length)
+    {
+    while (length > 0)
+      {
+      int sent = send(connection, data, static_cast<int>(std::min(length, static_cast<size_t>(65536))), SEND_FLAGS);
+      if (sent <= 0)
+        {
+        // The client aborted the transfer
+        return false;
+        }
+      data += sent;
+      length -= sent;
+      }
+    return true;
+    }
+
+  /// Wait until the progress saved for the range reaches \a expected,
+  /// at most 10 seconds, and return the last progress read.
+  vtkTypeInt64 WaitForCommitted(vtkTypeInt64 rangeBegin, vtkTypeInt64 expected)
+    {
+    vtkTypeInt64 committed = this->ReadCommitted(rangeBegin);
+    for (int i = 0; i < 1000 && committed < expected; ++i)
+      {
+      vtksys::SystemTools::Delay(10);
+      committed = this->ReadCommitted(rangeBegin);
+      }
+    return committed;
+    }
+
+  vtkTypeInt64 ReadCommitted(vtkTypeInt64 rangeBegin)
+    {
+    std::ifstream rangesFile(this->RangesFile.c_str());
+    std::string source;
+    vtkTypeInt64 size = 0;
+    std::getline(rangesFile, source);
+    rangesFile >> size;
+    vtkTypeInt64 begin = 0, end = 0, committed = 0;
+    while (rangesFile >> begin >> end >> committed)
+      {
+      if (begin == rangeBegin)
+        {
+        return committed;
+        }
+      }
+    return -1;
+    }
+
+  std::string Content;
+  vtkTypeInt64 CommittedDuringStall;
+  SocketType Socket;
+  int Port;
+  vtkNew<vtkMultiThreader> Threader;
+  int ThreadId;
+  /// Protects Stopping, Requests and CommittedDuringStall.
+  vtkNew<vtkMutexLock> Lock;
+  bool Stopping;
+  std::vector<Request> Requests;
+};
+
+//---------------------------------------------------------------------------
+std::string ReadFile(const std::string& fileName)
+{
+  std::ifstream file(fileName.c_str(), std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+//---------------------------------------------------------------------------
+int TestParallelDownloads(const std::string& sourceDir, const std::string& cacheDir);
+int TestRangedDownload(const std::string& sourceDir, const std::string& cacheDir);
+int TestResumeSingleStream(const std::string& sourceDir, const std::string& cacheDir);
+int TestResumeRanged(const std::string& sourceDir, const std::string& cacheDir);
+int TestMissingSource(const std::string& sourceDir, const std::string& cacheDir);
+int TestHTTPPartialContent(const std::string& sourceDir, const std::string& cacheDir);
+int TestHTTPRangesIgnored(const std::string& sourceDir, const std::string& cacheDir);
+int TestHTTPResumeInterruptedRange(const std::string& sourceDir, const std::string& cacheDir);
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkHTTPTransferEngineTest1(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = vtksys::SystemTools::CollapseFullPath(argv[1]);
+  std::string sourceDir = tempDir + "/vtkHTTPTransferEngineTest1/Source";
+  std::string cacheDir = tempDir + "/vtkHTTPTransferEngineTest1/Cache";
+  vtksys::SystemTools::RemoveADirectory((tempDir + "/vtkHTTPTransferEngineTest1").c_str());
+  vtksys::SystemTools::MakeDirectory(sourceDir.c_str());
+  vtksys::SystemTools::MakeDirectory(cacheDir.c_str());
+
+  vtkNew<vtkHTTPTransferEngine> engine;
+  EXERCISE_BASIC_OBJECT_METHODS(engine.GetPointer());
+
+  CHECK_EXIT_SUCCESS(TestParallelDownloads(sourceDir, cacheDir));
+  CHECK_EXIT_SUCCESS(TestRangedDownload(sourceDir, cacheDir));
+  CHECK_EXIT_SUCCESS(TestResumeSingleStream(sourceDir, cacheDir));
+  CHECK_EXIT_SUCCESS(TestResumeRanged(sourceDir, cacheDir));
+  CHECK_EXIT_SUCCESS(TestMissingSource(sourceDir, cacheDir));
+  CHECK_EXIT_SUCCESS(TestHTTPPartialContent(sourceDir, cacheDir));
+  CHECK_EXIT_SUCCESS(TestHTTPRangesIgnored(sourceDir, cacheDir));
+  CHECK_EXIT_SUCCESS(TestHTTPResumeInterruptedRange(sourceDir, cacheDir));
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+int TestParallelDownloads(const std::string& sourceDir, const std::string& cacheDir)
+{
+  vtkNew<vtkHTTPTransferEngine> engine;
+  engine->SetMaximumNumberOfParallelTransfers(4);
+  std::vector<std::string> sourceFiles;
+  std::vector<std::string> sources;
+  std::vector<std::string> destinations;
+  for (int i = 0; i < 10; ++i)
+    {
+    std::stringstream name;
+    name << "parallel" << i << ".bin";
+    sourceFiles.push_back(WriteSourceFile(sourceDir, name.str(), 1000 + i * 517));
+    sources.push_back(FileURL(sourceFiles.back()));
+    destinations.push_back(cacheDir + "/" + name.str());
+    }
+  std::vector<bool> succeeded;
+  CHECK_INT(engine->StageFilesRead(sources, destinations, &succeeded), 10);
+  CHECK_INT(static_cast<int>(succeeded.size()), 10);
+  for (size_t i = 0; i < sources.size(); ++i)
+    {
+    CHECK_BOOL(succeeded[i], true);
+    CHECK_BOOL(SameContent(sourceFiles[i], destinations[i]), true);
+    CHECK_BOOL(vtksys::SystemTools::FileExists(
+      (destinations[i] + vtkCacheManager::GetPartialDownloadSuffix()).c_str()), false);
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestRangedDownload(const std::string& sourceDir, const std::string& cacheDir)
+{
+  vtkNew<vtkHTTPTransferEngine> engine;
+  engine->SetRangedDownloadThreshold(1000);
+  engine->SetNumberOfRangedChunks(5);
+  std::string sourceFile = WriteSourceFile(sourceDir, "ranged.bin", 100003);
+  std::string destination = cacheDir + "/ranged.bin";
+  CHECK_BOOL(engine->StageFileRead(FileURL(sourceFile).c_str(), destination.c_str()), true);
+  CHECK_BOOL(SameContent(sourceFile, destination), true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(
+    (destination + vtkCacheManager::GetPartialDownloadRangesSuffix()).c_str()), false);
+
+  // Small files are not split
+  std::string smallSourceFile = WriteSourceFile(sourceDir, "small.bin", 10);
+  std::string smallDestination = cacheDir + "/small.bin";
+  CHECK_BOOL(engine->StageFileRead(FileURL(smallSourceFile).c_str(), smallDestination.c_str()), true);
+  CHECK_BOOL(SameContent(smallSourceFile, smallDestination), true);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestResumeSingleStream(const std::string& sourceDir, const std::string& cacheDir)
+{
+  vtkNew<vtkHTTPTransferEngine> engine;
+  engine->SetRangedDownloadThreshold(0);
+  std::string sourceFile = WriteSourceFile(sourceDir, "resume.bin", 50000);
+  std::string destination = cacheDir + "/resume.bin";
+
+  // Simulate an interrupted download: the first 20000 bytes are there
+  std::string partialFile = WriteSourceFile(cacheDir,
+    std::string("resume.bin") + vtkCacheManager::GetPartialDownloadSuffix(), 20000);
+
+  CHECK_BOOL(engine->StageFileRead(FileURL(sourceFile).c_str(), destination.c_str()), true);
+  CHECK_BOOL(SameContent(sourceFile, destination), true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(partialFile.c_str()), false);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestResumeRanged(const std::string& sourceDir, const std::string& cacheDir)
+{
+  vtkNew<vtkHTTPTransferEngine> engine;
+  engine->SetRangedDownloadThreshold(1000);
+  std::string sourceFile = WriteSourceFile(sourceDir, "resumeranged.bin", 40000);
+  std::string destination = cacheDir + "/resumeranged.bin";
+
+  // Simulate an interrupted ranged download: first range complete,
+  // second one half done, the others not started.
+  std::string partialFile = destination + vtkCacheManager::GetPartialDownloadSuffix();
+  vtksys::SystemTools::CopyFileAlways(sourceFile.c_str(), partialFile.c_str());
+  std::string rangesFile = destination + vtkCacheManager::GetPartialDownloadRangesSuffix();
+  {
+  std::ofstream ranges(rangesFile.c_str());
+  ranges << FileURL(sourceFile) << "\n" << 40000 << "\n";
+  ranges << "0 9999 10000\n";
+  ranges << "10000 19999 5000\n";
+  ranges << "20000 29999 0\n";
+  ranges << "30000 39999 0\n";
+  }
+  // Corrupt the parts that are not marked as received
+  {
+  std::fstream partial(partialFile.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+  partial.seekp(15000);
+  for (int i = 15000; i < 40000; ++i)
+    {
+    partial.put('x');
+    }
+  }
+
+  CHECK_BOOL(engine->StageFileRead(FileURL(sourceFile).c_str(), destination.c_str()), true);
+  CHECK_BOOL(SameContent(sourceFile, destination), true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(rangesFile.c_str()), false);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestMissingSource(const std::string& sourceDir, const std::string& cacheDir)
+{
+  vtkNew<vtkHTTPTransferEngine> engine;
+  std::string destination = cacheDir + "/missing.bin";
+  CHECK_BOOL(engine->StageFileRead(FileURL(sourceDir + "/missing.bin").c_str(), destination.c_str()), false);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(destination.c_str()), false);
+  CHECK_BOOL(engine->GetLastErrorString().empty(), false);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestHTTPPartialContent(const std::string& sourceDir, const std::string& cacheDir)
+{
+  std::string sourceFile = WriteSourceFile(sourceDir, "http206.bin", 100003);
+  LoopbackServer server(ReadFile(sourceFile));
+  CHECK_BOOL(server.Start(), true);
+
+  vtkNew<vtkHTTPTransferEngine> engine;
+  engine->SetRangedDownloadThreshold(1000);
+  engine->SetNumberOfRangedChunks(4);
+  std::string destination = cacheDir + "/http206.bin";
+  CHECK_BOOL(engine->StageFileRead(server.GetURL("http206.bin").c_str(), destination.c_str()), true);
+  CHECK_BOOL(SameContent(sourceFile, destination), true);
+
+  // A HEAD probe, then one request per range, all answered with 206
+  std::vector<LoopbackServer::Request> requests = server.GetRequests();
+  CHECK_INT(static_cast<int>(requests.size()), 5);
+  CHECK_BOOL(requests[0].Method == "HEAD", true);
+  for (size_t i = 1; i < requests.size(); ++i)
+    {
+    CHECK_BOOL(requests[i].Method == "GET", true);
+    CHECK_BOOL(requests[i].RangeBegin >= 0, true);
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestHTTPRangesIgnored(const std::string& sourceDir, const std::string& cacheDir)
+{
+  std::string sourceFile = WriteSourceFile(sourceDir, "http200.bin", 100003);
+  LoopbackServer server(ReadFile(sourceFile));
+  server.HonorRanges = false;
+  CHECK_BOOL(server.Start(), true);
+
+  vtkNew<vtkHTTPTransferEngine> engine;
+  engine->SetRangedDownloadThreshold(1000);
+  engine->SetNumberOfRangedChunks(4);
+  std::string destination = cacheDir + "/http200.bin";
+  CHECK_BOOL(engine->StageFileRead(server.GetURL("http200.bin").c_str(), destination.c_str()), true);
+  CHECK_BOOL(SameContent(sourceFile, destination), true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(
+    (destination + vtkCacheManager::GetPartialDownloadRangesSuffix()).c_str()), false);
+
+  // The ranged requests are aborted at their first 200 answer and the file
+  // is fetched again as a single stream.
+  std::vector<LoopbackServer::Request> requests = server.GetRequests();
+  CHECK_BOOL(requests.size() >= 3, true);
+  CHECK_BOOL(requests.front().Method == "HEAD", true);
+  CHECK_BOOL(requests[1].RangeBegin >= 0, true);
+  CHECK_BOOL(requests.back().Method == "GET", true);
+  CHECK_INT(static_cast<int>(requests.back().RangeBegin), -1);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestHTTPResumeInterruptedRange(const std::string& sourceDir, const std::string& cacheDir)
+{
+  const int size = 200000;
+  const int chunkSize = size / 4;
+  std::string sourceFile = WriteSourceFile(sourceDir, "httpresume.bin", size);
+  std::string destination = cacheDir + "/httpresume.bin";
+  LoopbackServer server(ReadFile(sourceFile));
+  server.TruncatedRangeBegin = chunkSize;
+  server.RangesFile = destination + vtkCacheManager::GetPartialDownloadRangesSuffix();
+  server.RangesFileUpdateInterval = 4096;
+  CHECK_BOOL(server.Start(), true);
+
+  vtkNew<vtkHTTPTransferEngine> engine;
+  engine->SetRangedDownloadThreshold(1000);
+  engine->SetNumberOfRangedChunks(4);
+  engine->SetRangesFileUpdateInterval(4096);
+
+  // The second range is interrupted in the middle
+  CHECK_BOOL(engine->StageFileRead(server.GetURL("httpresume.bin").c_str(), destination.c_str()), false);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(server.RangesFile.c_str()), true);
+  // The progress of the range was saved while its data was arriving
+  vtkTypeInt64 committed = server.GetCommittedDuringStall();
+  CHECK_BOOL(committed > chunkSize / 2 - 4096, true);
+  CHECK_BOOL(committed <= chunkSize / 2, true);
+
+  // Only the missing part of the interrupted range is fetched again
+  server.ClearRequests();
+  CHECK_BOOL(engine->StageFileRead(server.GetURL("httpresume.bin").c_str(), destination.c_str()), true);
+  CHECK_BOOL(SameContent(sourceFile, destination), true);
+  std::vector<LoopbackServer::Request> requests = server.GetRequests();
+  CHECK_INT(static_cast<int>(requests.size()), 1);
+  CHECK_BOOL(requests[0].Method == "GET", true);
+  CHECK_BOOL(requests[0].RangeBegin >= chunkSize + committed, true);
+  CHECK_BOOL(requests[0].RangeBegin < 2 * chunkSize, true);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
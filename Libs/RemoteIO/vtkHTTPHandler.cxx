@@ -1,10 +1,15 @@
 
 // RemoteIO includes
 #include "vtkHTTPHandler.h"
+#include "vtkHTTPTransferEngine.h"
 
 // MRML includes
 #include <vtkPermissionPrompter.h>
 
+// VTK includes
+#include <vtkMutexLock.h>
+#include <vtkSmartPointer.h>
+
 // CURL includes
 #include <curl/curl.h>
 
@@ -22,6 +27,11 @@ public:
   vtkHTTPHandler* External;
   CURL* CurlHandle;
   int ForbidReuse;
+  /// The handler is shared by the networking threads: downloads go through
+  /// the thread-safe transfer engine, uploads use CurlHandle and LocalFile
+  /// and are serialized by this lock.
+  vtkSmartPointer<vtkMutexLock> WriteLock;
+  vtkSmartPointer<vtkHTTPTransferEngine> TransferEngine;
 };
 
 //----------------------------------------------------------------------------
@@ -32,6 +42,8 @@ vtkHTTPHandler::vtkInternal::vtkInternal(vtkHTTPHandler* external):External(exte
 {
   this->CurlHandle = NULL;
   this->ForbidReuse = 0;
+  this->WriteLock = vtkSmartPointer<vtkMutexLock>::New();
+  this->TransferEngine = vtkSmartPointer<vtkHTTPTransferEngine>::New();
 }
 
 //-----------------------------------------------------------------------------
@@ -153,6 +165,7 @@ void vtkHTTPHandler::SetForbidReuse(int value)
     return;
     }
   this->Internal->ForbidReuse = value;
+  this->Internal->TransferEngine->SetForbidReuse(value != 0);
   this->Modified();
 }
 
@@ -182,6 +195,12 @@ int vtkHTTPHandler::CloseTransfer( )
 }
 
 
+//----------------------------------------------------------------------------
+vtkHTTPTransferEngine* vtkHTTPHandler::GetTransferEngine()
+{
+  return this->Internal->TransferEngine;
+}
+
 //----------------------------------------------------------------------------
 void vtkHTTPHandler::StageFileRead(const char * source, const char * destination)
 {
@@ -190,56 +209,32 @@ void vtkHTTPHandler::StageFileRead(const char * source, const char * destination
     vtkErrorMacro("StageFileRead: source or dest is null!");
     return;
     }
-  /*
-  if (this->LocalFile)
-    {
-    this->LocalFile->close();
-    delete this->LocalFile;
-    this->LocalFile = NULL;
-    }
-  this->LocalFile = new std::ofstream(destination, std::ios::binary);
-  */
-  this->InitTransfer( );
-
-
-  if ( this->Internal->ForbidReuse )
-    {
-    curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_FORBID_REUSE, 1);
-    }
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_HTTPGET, 1);
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_URL, source);
-//  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_NOPROGRESS, false);
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_FOLLOWLOCATION, true);
-  // use the default curl write call back
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_WRITEFUNCTION, NULL); // write_callback);
-  this->LocalFile = fopen(destination, "wb");
-  // output goes into LocalFile, must be  FILE*
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_WRITEDATA, this->LocalFile);
-//  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_PROGRESSDATA, NULL);
-//  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_PROGRESSFUNCTION, ProgressCallback);
-
-  // quick timeout during connection phase if URL is not accessible (e.g. blocked by a firewall)
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_CONNECTTIMEOUT, 3); // in seconds (type long)
-
-  vtkDebugMacro("StageFileRead: about to do the curl download... source = " << source << ", dest = " << destination);
-  CURLcode retval = curl_easy_perform(this->Internal->CurlHandle);
+  std::vector<std::string> sources(1, source);
+  std::vector<std::string> destinations(1, destination);
+  this->StageFilesRead(sources, destinations);
+}
 
-  if (retval == CURLE_OK)
-    {
-    vtkDebugMacro("StageFileRead: successful return from curl");
-    }
-  else if (retval == CURLE_BAD_FUNCTION_ARGUMENT)
-    {
-    vtkErrorMacro("StageFileRead: bad function argument to curl, did you init CurlHandle?");
-    }
-  else if (retval == CURLE_OUT_OF_MEMORY)
+//----------------------------------------------------------------------------
+int vtkHTTPHandler::StageFilesRead(const std::vector<std::string>& sources,
+                                   const std::vector<std::string>& destinations)
+{
+  vtkDebugMacro("StageFilesRead: about to do the curl download of " << sources.size() << " file(s)");
+  std::vector<bool> succeeded;
+  std::vector<std::string> errors;
+  int numberOfSucceeded = this->Internal->TransferEngine->StageFilesRead(sources, destinations, &succeeded, &errors);
+  for (size_t i = 0; i < succeeded.size(); ++i)
     {
-    vtkErrorMacro("StageFileRead: curl ran out of memory!");
+    if (succeeded[i])
+      {
+      vtkDebugMacro("StageFilesRead: successful return from curl, source = " << sources[i] << ", dest = " << destinations[i]);
+      }
+    else
+      {
+      vtkErrorMacro("StageFilesRead: error running curl for " << sources[i] << ": " << errors[i]);
+      }
     }
-  else
+  if (numberOfSucceeded != static_cast<int>(sources.size()))
     {
-    const char *stringError = curl_easy_strerror(retval);
-    vtkErrorMacro("StageFileRead: error running curl: " << stringError);
     //--- in case the permissions were not correct and that's
     //--- the reason the read command failed,
     //--- reset the 'remember check' in the permissions
@@ -249,17 +244,7 @@ void vtkHTTPHandler::StageFileRead(const char * source, const char * destination
       this->GetPermissionPrompter()->SetRemember ( 0 );
       }
     }
-  this->CloseTransfer();
-
-  /*
-  this->LocalFile->close();
-  delete this->LocalFile;
-  this->LocalFile = NULL;
-  */
-  if (this->LocalFile)
-    {
-    fclose(this->LocalFile);
-    }
+  return numberOfSucceeded;
 }
 
 
@@ -276,6 +261,7 @@ void vtkHTTPHandler::StageFileWrite(const char * source, const char * destinatio
     }
   this->LocalFile = new std::ofstream(destination, std::ios::binary);
   */
+  this->Internal->WriteLock->Lock();
   this->LocalFile = fopen(source, "r");
 
   this->InitTransfer( );
@@ -311,6 +297,8 @@ void vtkHTTPHandler::StageFileWrite(const char * source, const char * destinatio
   this->CloseTransfer();
 
   fclose(this->LocalFile);
+  this->LocalFile = NULL;
+  this->Internal->WriteLock->Unlock();
   /*
   this->LocalFile->close();
   delete this->LocalFile;
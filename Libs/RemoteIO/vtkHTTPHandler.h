@@ -12,6 +12,12 @@
 // MRML includes
 #include "vtkURIHandler.h"
 
+// STD includes
+#include <string>
+#include <vector>
+
+class vtkHTTPTransferEngine;
+
 class VTK_RemoteIO_EXPORT vtkHTTPHandler : public vtkURIHandler
 {
 public:
@@ -33,8 +39,22 @@ public:
   int GetForbidReuse();
 
   /// This function wraps curl functionality to download a specified URL to a specified dir
+  /// Downloads go through the handler's transfer engine: connections are
+  /// kept alive between calls, large files are fetched as parallel ranges
+  /// and interrupted downloads are resumed.
+  /// \sa GetTransferEngine()
   void StageFileRead(const char * source, const char * destination);
   using vtkURIHandler::StageFileRead;
+
+  /// Download several files in parallel. Returns the number of files
+  /// successfully downloaded.
+  int StageFilesRead(const std::vector<std::string>& sources,
+                     const std::vector<std::string>& destinations);
+
+  /// Engine running the downloads. It can be used to tune the number of
+  /// parallel transfers, ranged downloads and resume.
+  vtkHTTPTransferEngine* GetTransferEngine();
+
   void StageFileWrite(const char * source, const char * destination);
   using vtkURIHandler::StageFileWrite;
   virtual void InitTransfer ( );
@@ -0,0 +1,952 @@
+
+// RemoteIO includes
+#include "vtkHTTPTransferEngine.h"
+
+// MRML includes
+#include <vtkCacheManager.h>
+
+// VTK includes
+#include <vtkConditionVariable.h>
+#include <vtkMutexLock.h>
+#include <vtkObjectFactory.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// CURL includes
+#include <curl/curl.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <sstream>
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+namespace
+{
+
+struct Download;
+
+//----------------------------------------------------------------------------
+/// One curl request: a HEAD probe, a whole file or a byte range of a file.
+struct Transfer
+{
+  Transfer()
+    : Owner(NULL)
+    , Handle(NULL)
+    , File(NULL)
+    , Begin(0)
+    , End(-1)
+    , Received(0)
+    , Committed(0)
+    , Probe(false)
+    , RangeRejected(false)
+    , FirstWrite(true)
+    {
+    this->ErrorBuffer[0] = '\0';
+    }
+
+  Download* Owner;
+  CURL* Handle;
+  FILE* File;
+  /// First byte of the file covered by this transfer.
+  vtkTypeInt64 Begin;
+  /// Last byte (inclusive) requested, -1 means up to the end of the file.
+  vtkTypeInt64 End;
+  /// Number of bytes already written, including bytes of a previous session.
+  vtkTypeInt64 Received;
+  /// Number of bytes flushed to the partial file and recorded in the ranges file.
+  vtkTypeInt64 Committed;
+  bool Probe;
+  bool RangeRejected;
+  bool FirstWrite;
+  char ErrorBuffer[CURL_ERROR_SIZE];
+};
+
+//----------------------------------------------------------------------------
+struct Download
+{
+  enum StatusType
+    {
+    Pending = 0,
+    Running,
+    Completed,
+    Failed
+    };
+
+  Download()
+    : Status(Pending)
+    , Size(-1)
+    , AcceptRanges(false)
+    , Ranged(false)
+    , Resumed(false)
+    , Retried(false)
+    , FallbackToSingleStream(false)
+    , HasError(false)
+    , RemainingTransfers(0)
+    , RangesFileUpdateInterval(0)
+    {
+    }
+
+  ~Download()
+    {
+    for (std::vector<Transfer*>::iterator it = this->Transfers.begin(); it != this->Transfers.end(); ++it)
+      {
+      delete *it;
+      }
+    }
+
+  std::string Source;
+  std::string Destination;
+  std::string PartialFile;
+  std::string RangesFile;
+  StatusType Status;
+  vtkTypeInt64 Size;
+  bool AcceptRanges;
+  bool Ranged;
+  bool Resumed;
+  bool Retried;
+  bool FallbackToSingleStream;
+  bool HasError;
+  int RemainingTransfers;
+  /// Number of bytes received by a range between two updates of the ranges file.
+  vtkTypeInt64 RangesFileUpdateInterval;
+  std::string Error;
+  std::vector<Transfer*> Transfers;
+};
+
+//----------------------------------------------------------------------------
+/// Record the progress of a ranged download. Only the committed bytes are
+/// written: they are known to be in the partial file, so the ranges file
+/// never claims data that would be lost if the application stopped.
+void WriteRangesFile(Download* download)
+{
+  // An interrupted write leaves an incomplete file, which is rejected when
+  // resuming (the download then restarts).
+  std::ofstream rangesFile(download->RangesFile.c_str(), std::ios::out | std::ios::trunc);
+  rangesFile << download->Source << "\n" << download->Size << "\n";
+  for (std::vector<Transfer*>::iterator it = download->Transfers.begin(); it != download->Transfers.end(); ++it)
+    {
+    rangesFile << (*it)->Begin << " " << (*it)->End << " " << (*it)->Committed << "\n";
+    }
+}
+
+//----------------------------------------------------------------------------
+int SeekFile(FILE* file, vtkTypeInt64 offset)
+{
+#if defined(_MSC_VER)
+  return _fseeki64(file, offset, SEEK_SET);
+#else
+  return fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+//----------------------------------------------------------------------------
+size_t WriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
+{
+  Transfer* transfer = static_cast<Transfer*>(userdata);
+  if (transfer == NULL || transfer->File == NULL)
+    {
+    return 0;
+    }
+  if (transfer->FirstWrite)
+    {
+    transfer->FirstWrite = false;
+    long responseCode = 0;
+    curl_easy_getinfo(transfer->Handle, CURLINFO_RESPONSE_CODE, &responseCode);
+    // file:// reports no response code but always honors ranges.
+    // A single stream resume that the server ignores is failed by curl
+    // itself, the download is then restarted from scratch (see FinishDownload).
+    if (transfer->End >= 0 && responseCode != 0 && responseCode != 206)
+      {
+      // The server ignored the range and sends the whole file: abort,
+      // the download is restarted as a single stream.
+      transfer->RangeRejected = true;
+      return 0;
+      }
+    }
+  size_t written = fwrite(ptr, 1, size * nmemb, transfer->File);
+  transfer->Received += written;
+  Download* download = transfer->Owner;
+  if (download->Ranged && download->RangesFileUpdateInterval > 0
+    && transfer->Received - transfer->Committed >= download->RangesFileUpdateInterval)
+    {
+    // Save the progress as data arrives, a download interrupted in the
+    // middle of a range then only fetches the rest of the range again.
+    if (fflush(transfer->File) == 0)
+      {
+      transfer->Committed = transfer->Received;
+      WriteRangesFile(download);
+      }
+    }
+  return written;
+}
+
+//----------------------------------------------------------------------------
+size_t DiscardCallback(char* vtkNotUsed(ptr), size_t size, size_t nmemb, void* vtkNotUsed(userdata))
+{
+  return size * nmemb;
+}
+
+//----------------------------------------------------------------------------
+size_t ProbeHeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata)
+{
+  Transfer* transfer = static_cast<Transfer*>(userdata);
+  size_t length = size * nitems;
+  std::string header = vtksys::SystemTools::LowerCase(std::string(buffer, length));
+  if (header.find("accept-ranges:") == 0 && header.find("bytes") != std::string::npos)
+    {
+    transfer->Owner->AcceptRanges = true;
+    }
+  else if (header.find("content-length:") == 0)
+    {
+    std::stringstream value(header.substr(strlen("content-length:")));
+    vtkTypeInt64 size = -1;
+    if (value >> size)
+      {
+      transfer->Owner->Size = size;
+      }
+    }
+  return length;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkHTTPTransferEngine::vtkInternal
+{
+public:
+  vtkInternal(vtkHTTPTransferEngine* external);
+  ~vtkInternal();
+
+  /// Queue the downloads and block until they are all finished.
+  void Run(const std::vector<Download*>& downloads);
+  bool AreFinished(const std::vector<Download*>& downloads);
+  /// Run the multi handle until all \a downloads are finished.
+  void Drive(const std::vector<Download*>& downloads);
+
+  void StartDownload(Download* download);
+  void StartSingleStream(Download* download);
+  void StartRangedStreams(Download* download);
+  void QueueTransfer(Download* download, Transfer* transfer);
+  void ActivateQueuedTransfers();
+  bool ActivateTransfer(Transfer* transfer);
+  void ProcessMessages();
+  void FinishTransfer(Transfer* transfer, CURLcode result);
+  void FinishDownload(Download* download);
+  void SetStatus(Download* download, Download::StatusType status);
+
+  bool ReadRangesFile(Download* download);
+  void RemovePartialFiles(Download* download);
+
+  CURL* AcquireHandle();
+  void ReleaseHandle(CURL* handle);
+
+  vtkHTTPTransferEngine* External;
+  CURLM* MultiHandle;
+  std::vector<CURL*> IdleHandles;
+
+  /// Protects PendingDownloads, Driving, Download::Status and LastError.
+  vtkMutexLock* Lock;
+  vtkConditionVariable* Condition;
+  std::deque<Download*> PendingDownloads;
+  bool Driving;
+  std::string LastError;
+  int NumberOfConnections;
+
+  /// Only accessed by the driving thread.
+  std::deque<Transfer*> QueuedTransfers;
+  int NumberOfActiveTransfers;
+};
+
+//----------------------------------------------------------------------------
+// vtkInternal methods
+
+//----------------------------------------------------------------------------
+vtkHTTPTransferEngine::vtkInternal::vtkInternal(vtkHTTPTransferEngine* external)
+  : External(external)
+  , Driving(false)
+  , NumberOfConnections(0)
+  , NumberOfActiveTransfers(0)
+{
+  curl_global_init(CURL_GLOBAL_ALL);
+  this->MultiHandle = curl_multi_init();
+  this->Lock = vtkMutexLock::New();
+  this->Condition = vtkConditionVariable::New();
+}
+
+//----------------------------------------------------------------------------
+vtkHTTPTransferEngine::vtkInternal::~vtkInternal()
+{
+  for (std::vector<CURL*>::iterator it = this->IdleHandles.begin(); it != this->IdleHandles.end(); ++it)
+    {
+    curl_easy_cleanup(*it);
+    }
+  this->IdleHandles.clear();
+  curl_multi_cleanup(this->MultiHandle);
+  this->MultiHandle = NULL;
+  this->Condition->Delete();
+  this->Lock->Delete();
+}
+
+//----------------------------------------------------------------------------
+CURL* vtkHTTPTransferEngine::vtkInternal::AcquireHandle()
+{
+  if (this->IdleHandles.empty())
+    {
+    return curl_easy_init();
+    }
+  CURL* handle = this->IdleHandles.back();
+  this->IdleHandles.pop_back();
+  curl_easy_reset(handle);
+  return handle;
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::ReleaseHandle(CURL* handle)
+{
+  if (handle)
+    {
+    this->IdleHandles.push_back(handle);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::SetStatus(Download* download, Download::StatusType status)
+{
+  this->Lock->Lock();
+  download->Status = status;
+  if (status == Download::Failed)
+    {
+    this->LastError = download->Error;
+    }
+  if (status == Download::Completed || status == Download::Failed)
+    {
+    // Wake up the threads waiting in Run() for this download
+    this->Condition->Broadcast();
+    }
+  this->Lock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+bool vtkHTTPTransferEngine::vtkInternal::AreFinished(const std::vector<Download*>& downloads)
+{
+  for (std::vector<Download*>::const_iterator it = downloads.begin(); it != downloads.end(); ++it)
+    {
+    if ((*it)->Status != Download::Completed && (*it)->Status != Download::Failed)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::Run(const std::vector<Download*>& downloads)
+{
+  this->Lock->Lock();
+  this->PendingDownloads.insert(this->PendingDownloads.end(), downloads.begin(), downloads.end());
+  while (!this->AreFinished(downloads))
+    {
+    if (!this->Driving)
+      {
+      // Nobody is running the multi handle, this thread takes over
+      this->Driving = true;
+      this->Lock->Unlock();
+      this->Drive(downloads);
+      this->Lock->Lock();
+      this->Driving = false;
+      // Let another waiting thread drive its remaining transfers
+      this->Condition->Broadcast();
+      }
+    else
+      {
+      this->Condition->Wait(this->Lock);
+      }
+    }
+  this->Lock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::Drive(const std::vector<Download*>& downloads)
+{
+#if LIBCURL_VERSION_NUM >= 0x071e00
+  curl_multi_setopt(this->MultiHandle, CURLMOPT_MAX_HOST_CONNECTIONS,
+    static_cast<long>(this->External->MaximumNumberOfConnectionsPerHost));
+#endif
+  while (true)
+    {
+    this->Lock->Lock();
+    std::deque<Download*> newDownloads;
+    newDownloads.swap(this->PendingDownloads);
+    this->Lock->Unlock();
+
+    for (std::deque<Download*>::iterator it = newDownloads.begin(); it != newDownloads.end(); ++it)
+      {
+      this->StartDownload(*it);
+      }
+    this->ActivateQueuedTransfers();
+
+    this->Lock->Lock();
+    bool finished = this->AreFinished(downloads);
+    this->Lock->Unlock();
+    if (finished)
+      {
+      return;
+      }
+
+    int runningHandles = 0;
+    curl_multi_perform(this->MultiHandle, &runningHandles);
+    this->ProcessMessages();
+
+#if LIBCURL_VERSION_NUM >= 0x071c00
+    int numberOfEvents = 0;
+    curl_multi_wait(this->MultiHandle, NULL, 0, 100, &numberOfEvents);
+#else
+    vtksys::SystemTools::Delay(10);
+#endif
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::StartDownload(Download* download)
+{
+  this->SetStatus(download, Download::Running);
+  download->RangesFileUpdateInterval = this->External->RangesFileUpdateInterval;
+  download->PartialFile = download->Destination + vtkCacheManager::GetPartialDownloadSuffix();
+  download->RangesFile = download->Destination + vtkCacheManager::GetPartialDownloadRangesSuffix();
+
+  std::string directory = vtksys::SystemTools::GetFilenamePath(download->Destination);
+  if (!directory.empty() && !vtksys::SystemTools::FileIsDirectory(directory.c_str()))
+    {
+    vtksys::SystemTools::MakeDirectory(directory.c_str());
+    }
+
+  if (!this->External->EnableResume)
+    {
+    this->RemovePartialFiles(download);
+    }
+  else if (this->ReadRangesFile(download))
+    {
+    // Resume an interrupted ranged download
+    download->Resumed = true;
+    download->Ranged = true;
+    for (std::vector<Transfer*>::iterator it = download->Transfers.begin(); it != download->Transfers.end(); ++it)
+      {
+      if ((*it)->Begin + (*it)->Received <= (*it)->End)
+        {
+        this->QueueTransfer(download, *it);
+        }
+      }
+    if (download->RemainingTransfers == 0)
+      {
+      this->FinishDownload(download);
+      }
+    return;
+    }
+  else if (vtksys::SystemTools::FileExists(download->PartialFile.c_str(), true))
+    {
+    // Resume an interrupted single stream download
+    vtksys::SystemTools::RemoveFile(download->RangesFile.c_str());
+    download->Resumed = true;
+    this->StartSingleStream(download);
+    return;
+    }
+
+  vtkTypeInt64 threshold = this->External->RangedDownloadThreshold;
+  if (threshold > 0 && this->External->NumberOfRangedChunks > 1)
+    {
+    // Ask for the size first to decide whether to split the file
+    Transfer* probe = new Transfer;
+    probe->Probe = true;
+    this->QueueTransfer(download, probe);
+    return;
+    }
+  this->StartSingleStream(download);
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::StartSingleStream(Download* download)
+{
+  download->Ranged = false;
+  Transfer* transfer = new Transfer;
+  if (download->Resumed)
+    {
+    transfer->Received = static_cast<vtkTypeInt64>(
+      vtksys::SystemTools::FileLength(download->PartialFile.c_str()));
+    }
+  download->Transfers.push_back(transfer);
+  this->QueueTransfer(download, transfer);
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::StartRangedStreams(Download* download)
+{
+  download->Ranged = true;
+  int numberOfChunks = this->External->NumberOfRangedChunks;
+  vtkTypeInt64 chunkSize = (download->Size + numberOfChunks - 1) / numberOfChunks;
+  for (vtkTypeInt64 begin = 0; begin < download->Size; begin += chunkSize)
+    {
+    Transfer* transfer = new Transfer;
+    transfer->Begin = begin;
+    transfer->End = std::min(begin + chunkSize, download->Size) - 1;
+    download->Transfers.push_back(transfer);
+    }
+  // The ranges file is written before the partial file: a partial file
+  // without ranges file would be resumed as a single stream.
+  WriteRangesFile(download);
+
+  // Chunks are written in place into the partial file
+  FILE* file = fopen(download->PartialFile.c_str(), "wb");
+  if (file == NULL)
+    {
+    download->Error = "Unable to create file " + download->PartialFile;
+    download->HasError = true;
+    this->FinishDownload(download);
+    return;
+    }
+  fclose(file);
+
+  for (std::vector<Transfer*>::iterator it = download->Transfers.begin(); it != download->Transfers.end(); ++it)
+    {
+    this->QueueTransfer(download, *it);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::QueueTransfer(Download* download, Transfer* transfer)
+{
+  transfer->Owner = download;
+  transfer->FirstWrite = true;
+  transfer->RangeRejected = false;
+  ++download->RemainingTransfers;
+  this->QueuedTransfers.push_back(transfer);
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::ActivateQueuedTransfers()
+{
+  while (!this->QueuedTransfers.empty()
+    && this->NumberOfActiveTransfers < this->External->MaximumNumberOfParallelTransfers)
+    {
+    Transfer* transfer = this->QueuedTransfers.front();
+    this->QueuedTransfers.pop_front();
+    if (!this->ActivateTransfer(transfer))
+      {
+      this->FinishTransfer(transfer, CURLE_WRITE_ERROR);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkHTTPTransferEngine::vtkInternal::ActivateTransfer(Transfer* transfer)
+{
+  Download* download = transfer->Owner;
+  vtkTypeInt64 offset = transfer->Begin + transfer->Received;
+  if (!transfer->Probe)
+    {
+    if (download->Ranged)
+      {
+      transfer->File = fopen(download->PartialFile.c_str(), "r+b");
+      if (transfer->File != NULL && SeekFile(transfer->File, offset) != 0)
+        {
+        fclose(transfer->File);
+        transfer->File = NULL;
+        }
+      }
+    else
+      {
+      transfer->File = fopen(download->PartialFile.c_str(), offset > 0 ? "ab" : "wb");
+      }
+    if (transfer->File == NULL)
+      {
+      strncpy(transfer->ErrorBuffer, ("Unable to open file " + download->PartialFile).c_str(), CURL_ERROR_SIZE - 1);
+      transfer->ErrorBuffer[CURL_ERROR_SIZE - 1] = '\0';
+      return false;
+      }
+    }
+
+  CURL* handle = this->AcquireHandle();
+  if (handle == NULL)
+    {
+    strncpy(transfer->ErrorBuffer, "Unable to initialize curl handle", CURL_ERROR_SIZE - 1);
+    return false;
+    }
+  transfer->Handle = handle;
+  transfer->ErrorBuffer[0] = '\0';
+
+  curl_easy_setopt(handle, CURLOPT_URL, download->Source.c_str());
+  curl_easy_setopt(handle, CURLOPT_PRIVATE, transfer);
+  curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, transfer->ErrorBuffer);
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
+  curl_easy_setopt(handle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS | CURLPROTO_FILE);
+  // quick timeout during connection phase if URL is not accessible (e.g. blocked by a firewall)
+  curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, static_cast<long>(this->External->ConnectTimeout));
+  if (this->External->ForbidReuse)
+    {
+    curl_easy_setopt(handle, CURLOPT_FORBID_REUSE, 1L);
+    }
+
+  if (transfer->Probe)
+    {
+    curl_easy_setopt(handle, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, ProbeHeaderCallback);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, transfer);
+    // some protocols (e.g. file://) also pass the headers to the write function
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, DiscardCallback);
+    }
+  else
+    {
+    curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, transfer);
+    if (transfer->End >= 0)
+      {
+      std::stringstream range;
+      range << offset << "-" << transfer->End;
+      curl_easy_setopt(handle, CURLOPT_RANGE, range.str().c_str());
+      }
+    else if (offset > 0)
+      {
+      curl_easy_setopt(handle, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(offset));
+      }
+    }
+
+  curl_multi_add_handle(this->MultiHandle, handle);
+  ++this->NumberOfActiveTransfers;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::ProcessMessages()
+{
+  int messagesLeft = 0;
+  CURLMsg* message = NULL;
+  while ((message = curl_multi_info_read(this->MultiHandle, &messagesLeft)) != NULL)
+    {
+    if (message->msg != CURLMSG_DONE)
+      {
+      continue;
+      }
+    CURL* handle = message->easy_handle;
+    CURLcode result = message->data.result;
+    Transfer* transfer = NULL;
+    curl_easy_getinfo(handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&transfer));
+    long connections = 0;
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connections);
+    this->Lock->Lock();
+    this->NumberOfConnections += static_cast<int>(connections);
+    this->Lock->Unlock();
+
+    curl_multi_remove_handle(this->MultiHandle, handle);
+    --this->NumberOfActiveTransfers;
+    if (transfer == NULL)
+      {
+      curl_easy_cleanup(handle);
+      continue;
+      }
+    if (transfer->Probe && result == CURLE_OK && transfer->Owner->Size < 0)
+      {
+      double contentLength = -1.;
+      curl_easy_getinfo(handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLength);
+      transfer->Owner->Size = static_cast<vtkTypeInt64>(contentLength);
+      }
+    this->FinishTransfer(transfer, result);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::FinishTransfer(Transfer* transfer, CURLcode result)
+{
+  Download* download = transfer->Owner;
+  if (transfer->File)
+    {
+    if (fclose(transfer->File) == 0)
+      {
+      transfer->Committed = transfer->Received;
+      }
+    transfer->File = NULL;
+    }
+  this->ReleaseHandle(transfer->Handle);
+  transfer->Handle = NULL;
+  --download->RemainingTransfers;
+
+  if (transfer->Probe)
+    {
+    // A failed probe is not fatal: the file is then fetched as one stream,
+    // which reports the actual error if the source is not reachable.
+    delete transfer;
+    if (result == CURLE_OK && download->AcceptRanges
+      && download->Size >= this->External->RangedDownloadThreshold)
+      {
+      this->StartRangedStreams(download);
+      }
+    else
+      {
+      this->StartSingleStream(download);
+      }
+    return;
+    }
+
+  if (result != CURLE_OK)
+    {
+    if (transfer->RangeRejected)
+      {
+      download->FallbackToSingleStream = true;
+      }
+    else if (!download->HasError)
+      {
+      download->HasError = true;
+      download->Error = transfer->ErrorBuffer[0] != '\0' ?
+        std::string(transfer->ErrorBuffer) : std::string(curl_easy_strerror(result));
+      }
+    }
+  if (download->Ranged)
+    {
+    WriteRangesFile(download);
+    }
+  if (download->RemainingTransfers == 0)
+    {
+    this->FinishDownload(download);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::FinishDownload(Download* download)
+{
+  bool restart = false;
+  if (!download->HasError && download->FallbackToSingleStream)
+    {
+    restart = true;
+    }
+  else if (download->HasError && download->Resumed && !download->Retried)
+    {
+    // The partial file may not match the remote file anymore
+    // (e.g. it changed on the server), retry once from scratch.
+    restart = true;
+    download->Retried = true;
+    }
+  if (restart)
+    {
+    this->RemovePartialFiles(download);
+    for (std::vector<Transfer*>::iterator it = download->Transfers.begin(); it != download->Transfers.end(); ++it)
+      {
+      delete *it;
+      }
+    download->Transfers.clear();
+    download->HasError = false;
+    download->Resumed = false;
+    download->FallbackToSingleStream = false;
+    download->Error.clear();
+    this->StartSingleStream(download);
+    return;
+    }
+
+  if (download->HasError)
+    {
+    // Partial files are kept so that the next attempt resumes
+    this->SetStatus(download, Download::Failed);
+    return;
+    }
+
+  vtksys::SystemTools::RemoveFile(download->RangesFile.c_str());
+  if (vtksys::SystemTools::FileExists(download->Destination.c_str(), true))
+    {
+    vtksys::SystemTools::RemoveFile(download->Destination.c_str());
+    }
+  if (rename(download->PartialFile.c_str(), download->Destination.c_str()) != 0)
+    {
+    download->Error = "Unable to rename " + download->PartialFile + " to " + download->Destination;
+    this->SetStatus(download, Download::Failed);
+    return;
+    }
+  this->SetStatus(download, Download::Completed);
+}
+
+//----------------------------------------------------------------------------
+bool vtkHTTPTransferEngine::vtkInternal::ReadRangesFile(Download* download)
+{
+  if (!vtksys::SystemTools::FileExists(download->RangesFile.c_str(), true)
+    || !vtksys::SystemTools::FileExists(download->PartialFile.c_str(), true))
+    {
+    return false;
+    }
+  std::ifstream rangesFile(download->RangesFile.c_str());
+  std::string source;
+  vtkTypeInt64 size = -1;
+  std::getline(rangesFile, source);
+  rangesFile >> size;
+  std::vector<Transfer*> transfers;
+  vtkTypeInt64 begin = 0, end = 0, received = 0;
+  vtkTypeInt64 expectedBegin = 0;
+  bool valid = (source == download->Source && size > 0);
+  while (valid && rangesFile >> begin >> end >> received)
+    {
+    if (begin != expectedBegin || end < begin || end >= size || received < 0 || begin + received > end + 1)
+      {
+      valid = false;
+      break;
+      }
+    Transfer* transfer = new Transfer;
+    transfer->Begin = begin;
+    transfer->End = end;
+    transfer->Received = received;
+    transfer->Committed = received;
+    transfers.push_back(transfer);
+    expectedBegin = end + 1;
+    }
+  if (!valid || expectedBegin != size)
+    {
+    for (std::vector<Transfer*>::iterator it = transfers.begin(); it != transfers.end(); ++it)
+      {
+      delete *it;
+      }
+    this->RemovePartialFiles(download);
+    return false;
+    }
+  download->Size = size;
+  download->Transfers = transfers;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::vtkInternal::RemovePartialFiles(Download* download)
+{
+  vtksys::SystemTools::RemoveFile(download->PartialFile.c_str());
+  vtksys::SystemTools::RemoveFile(download->RangesFile.c_str());
+}
+
+//----------------------------------------------------------------------------
+// vtkHTTPTransferEngine methods
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkHTTPTransferEngine);
+
+//----------------------------------------------------------------------------
+vtkHTTPTransferEngine::vtkHTTPTransferEngine()
+{
+  this->MaximumNumberOfParallelTransfers = 8;
+  this->MaximumNumberOfConnectionsPerHost = 4;
+  this->RangedDownloadThreshold = 32 * 1024 * 1024;
+  this->NumberOfRangedChunks = 4;
+  this->EnableResume = true;
+  this->ForbidReuse = false;
+  this->ConnectTimeout = 3;
+  this->RangesFileUpdateInterval = 1024 * 1024;
+  this->Internal = new vtkInternal(this);
+}
+
+//----------------------------------------------------------------------------
+vtkHTTPTransferEngine::~vtkHTTPTransferEngine()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPTransferEngine::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumNumberOfParallelTransfers: " << this->MaximumNumberOfParallelTransfers << "\n";
+  os << indent << "MaximumNumberOfConnectionsPerHost: " << this->MaximumNumberOfConnectionsPerHost << "\n";
+  os << indent << "RangedDownloadThreshold: " << this->RangedDownloadThreshold << "\n";
+  os << indent << "NumberOfRangedChunks: " << this->NumberOfRangedChunks << "\n";
+  os << indent << "EnableResume: " << this->EnableResume << "\n";
+  os << indent << "ForbidReuse: " << this->ForbidReuse << "\n";
+  os << indent << "ConnectTimeout: " << this->ConnectTimeout << "\n";
+  os << indent << "RangesFileUpdateInterval: " << this->RangesFileUpdateInterval << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkHTTPTransferEngine::StageFileRead(const char* source, const char* destination)
+{
+  if (source == NULL || destination == NULL)
+    {
+    vtkErrorMacro("StageFileRead: source or destination is null!");
+    return false;
+    }
+  std::vector<std::string> sources(1, source);
+  std::vector<std::string> destinations(1, destination);
+  return this->StageFilesRead(sources, destinations) == 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkHTTPTransferEngine::StageFilesRead(const std::vector<std::string>& sources,
+                                          const std::vector<std::string>& destinations,
+                                          std::vector<bool>* succeeded,
+                                          std::vector<std::string>* errors)
+{
+  if (sources.size() != destinations.size())
+    {
+    vtkErrorMacro("StageFilesRead: number of sources and destinations mismatch");
+    return 0;
+    }
+
+  std::vector<Download*> downloads;
+  for (size_t i = 0; i < sources.size(); ++i)
+    {
+    Download* download = new Download;
+    download->Source = sources[i];
+    download->Destination = destinations[i];
+    downloads.push_back(download);
+    }
+
+  this->Internal->Run(downloads);
+
+  int numberOfSucceeded = 0;
+  if (succeeded)
+    {
+    succeeded->clear();
+    }
+  if (errors)
+    {
+    errors->clear();
+    }
+  for (std::vector<Download*>::iterator it = downloads.begin(); it != downloads.end(); ++it)
+    {
+    bool success = ((*it)->Status == Download::Completed);
+    if (success)
+      {
+      ++numberOfSucceeded;
+      }
+    else
+      {
+      vtkDebugMacro("StageFilesRead: failed to download " << (*it)->Source << ": " << (*it)->Error);
+      }
+    if (succeeded)
+      {
+      succeeded->push_back(success);
+      }
+    if (errors)
+      {
+      errors->push_back(success ? std::string() : (*it)->Error);
+      }
+    delete *it;
+    }
+  return numberOfSucceeded;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkHTTPTransferEngine::GetLastErrorString()
+{
+  this->Internal->Lock->Lock();
+  std::string error = this->Internal->LastError;
+  this->Internal->Lock->Unlock();
+  return error;
+}
+
+//----------------------------------------------------------------------------
+int vtkHTTPTransferEngine::GetNumberOfConnectionsOpened()
+{
+  this->Internal->Lock->Lock();
+  int connections = this->Internal->NumberOfConnections;
+  this->Internal->Lock->Unlock();
+  return connections;
+}
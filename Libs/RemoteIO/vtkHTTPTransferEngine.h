@@ -0,0 +1,135 @@
+#ifndef __vtkHTTPTransferEngine_h
+#define __vtkHTTPTransferEngine_h
+
+// RemoteIO includes
+#include <vtkRemoteIOConfigure.h>
+#include "vtkRemoteIO.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+#include <vector>
+
+/// \brief Pooled download engine built on a curl multi handle.
+///
+/// All transfers go through one persistent curl multi handle so that
+/// connections to the same host are kept alive and reused between files,
+/// and several files are downloaded in parallel.
+///
+/// Files larger than RangedDownloadThreshold, served by a host that accepts
+/// byte ranges, are split into NumberOfRangedChunks ranges that are fetched
+/// in parallel into the same partial file.
+///
+/// Data is first written to "<destination>.part" (see
+/// vtkCacheManager::GetPartialDownloadSuffix()) and renamed to the
+/// destination once complete. If a previous download was interrupted, the
+/// transfer resumes from what was already received. The ranges of a ranged
+/// download and their progress are saved in "<destination>.part.ranges"
+/// every RangesFileUpdateInterval bytes, as data arrives.
+///
+/// The engine is thread-safe: StageFileRead() and StageFilesRead() may be
+/// called concurrently, the transfers of all callers share the multi handle
+/// and one of the waiting threads drives it at any time. The transfers
+/// (curl handles, partial files, ranges files) are only touched by the
+/// driving thread, the list of pending downloads, their status and the
+/// last error are protected by a mutex.
+///
+/// Besides http and https, the engine accepts file:// URLs, which supports
+/// ranges and is used as a local server stand-in by the tests.
+class VTK_RemoteIO_EXPORT vtkHTTPTransferEngine : public vtkObject
+{
+public:
+  static vtkHTTPTransferEngine *New();
+  vtkTypeMacro(vtkHTTPTransferEngine, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Maximum number of transfers (files or file ranges) run at once.
+  /// Default is 8.
+  vtkSetClampMacro(MaximumNumberOfParallelTransfers, int, 1, 256);
+  vtkGetMacro(MaximumNumberOfParallelTransfers, int);
+
+  /// Maximum number of simultaneous connections opened to a single host.
+  /// Default is 4.
+  vtkSetClampMacro(MaximumNumberOfConnectionsPerHost, int, 1, 256);
+  vtkGetMacro(MaximumNumberOfConnectionsPerHost, int);
+
+  /// Files at least this large (in bytes) are downloaded as parallel ranges.
+  /// Set to 0 to disable ranged downloads. Default is 32MB.
+  vtkSetMacro(RangedDownloadThreshold, vtkTypeInt64);
+  vtkGetMacro(RangedDownloadThreshold, vtkTypeInt64);
+
+  /// Number of ranges a large file is split into. Default is 4.
+  vtkSetClampMacro(NumberOfRangedChunks, int, 1, 64);
+  vtkGetMacro(NumberOfRangedChunks, int);
+
+  /// Number of bytes received by a range between two saves of the ranges
+  /// file. The partial file is flushed before each save, at most this many
+  /// bytes per range are fetched again when an interrupted download resumes.
+  /// Set to 0 to save the ranges file only when a range is finished.
+  /// Default is 1MB.
+  vtkSetMacro(RangesFileUpdateInterval, vtkTypeInt64);
+  vtkGetMacro(RangesFileUpdateInterval, vtkTypeInt64);
+
+  /// If enabled, partial files left by interrupted downloads are resumed.
+  /// Default is on.
+  vtkSetMacro(EnableResume, bool);
+  vtkGetMacro(EnableResume, bool);
+  vtkBooleanMacro(EnableResume, bool);
+
+  /// Close the connection after each transfer instead of keeping it alive.
+  /// \sa vtkHTTPHandler::SetForbidReuse()
+  vtkSetMacro(ForbidReuse, bool);
+  vtkGetMacro(ForbidReuse, bool);
+  vtkBooleanMacro(ForbidReuse, bool);
+
+  /// Timeout of the connection phase in seconds. Default is 3.
+  vtkSetMacro(ConnectTimeout, int);
+  vtkGetMacro(ConnectTimeout, int);
+
+  /// Download a single file. Blocks until the transfer is finished.
+  /// Returns true on success, on failure the error is available from
+  /// GetLastErrorString().
+  bool StageFileRead(const char* source, const char* destination);
+
+  /// Download several files in parallel. Blocks until all transfers
+  /// are finished. Returns the number of files successfully downloaded.
+  /// If not NULL, \a succeeded is set to one flag per file and \a errors
+  /// to one error message per file (empty for successful downloads).
+  int StageFilesRead(const std::vector<std::string>& sources,
+                     const std::vector<std::string>& destinations,
+                     std::vector<bool>* succeeded = NULL,
+                     std::vector<std::string>* errors = NULL);
+
+  /// Error message of the last failed transfer, of any caller. Use the
+  /// \a errors argument of StageFilesRead() to get the errors of a call.
+  std::string GetLastErrorString();
+
+  /// Number of connections opened since the engine was created.
+  /// Lower than the number of transfers when connections are reused.
+  int GetNumberOfConnectionsOpened();
+
+protected:
+  vtkHTTPTransferEngine();
+  virtual ~vtkHTTPTransferEngine();
+
+  int MaximumNumberOfParallelTransfers;
+  int MaximumNumberOfConnectionsPerHost;
+  vtkTypeInt64 RangedDownloadThreshold;
+  int NumberOfRangedChunks;
+  vtkTypeInt64 RangesFileUpdateInterval;
+  bool EnableResume;
+  bool ForbidReuse;
+  int ConnectTimeout;
+
+private:
+  vtkHTTPTransferEngine(const vtkHTTPTransferEngine&);  // Not implemented.
+  void operator=(const vtkHTTPTransferEngine&);  // Not implemented.
+
+  class vtkInternal;
+  vtkInternal* Internal;
+  friend class vtkInternal;
+};
+
+#endif
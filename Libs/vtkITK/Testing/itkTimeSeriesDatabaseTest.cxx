@@ -0,0 +1,372 @@
+#include <itkTimeSeriesDatabase.h>
+
+// ITK includes
+#include <itkConfigure.h>
+#include <itkFactoryRegistration.h>
+#include <itkImageFileWriter.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <sstream>
+
+namespace
+{
+
+typedef short                          PixelType;
+typedef itk::Image<PixelType, 3>       ImageType;
+
+const unsigned int NumberOfImages = 6;
+
+//----------------------------------------------------------------------------
+/// Voxel values are unique within a few blocks, so misplaced blocks and
+/// voxels are detected.
+PixelType ExpectedValue(const ImageType::IndexType& index, unsigned int image)
+{
+  return static_cast<PixelType>(index[0] + 20 * index[1] + 400 * index[2] + 2000 * image);
+}
+
+//----------------------------------------------------------------------------
+/// Gives access to the internal state of the database
+template <class TPixel>
+class TimeSeriesDatabaseTester : public itk::TimeSeriesDatabase<TPixel>
+{
+public:
+  typedef TimeSeriesDatabaseTester         Self;
+  typedef itk::TimeSeriesDatabase<TPixel>  Superclass;
+  typedef itk::SmartPointer<Self>          Pointer;
+  itkNewMacro(Self);
+  itkTypeMacro(TimeSeriesDatabaseTester, TimeSeriesDatabase);
+
+  bool IsPrefetchThreadActive()
+    {
+    this->m_PrefetchLock.Lock();
+    bool active = this->m_PrefetchThreadActive;
+    this->m_PrefetchLock.Unlock();
+    return active;
+    }
+  itk::MultiThreader* GetPrefetchThreader()
+    {
+    return this->m_PrefetchThreader;
+    }
+  itk::ThreadIdType GetPrefetchThreadId()
+    {
+    return this->m_PrefetchThreadId;
+    }
+  bool IsMapped()
+    {
+    for (size_t index = 0; index < this->m_MappedFiles.size(); ++index)
+      {
+      if (!this->m_MappedFiles[index].get())
+        {
+        return false;
+        }
+      }
+    return !this->m_MappedFiles.empty();
+    }
+  /// Return true if all the blocks of the image are in the block cache
+  bool IsImageCached(unsigned int image)
+    {
+    itk::Size<3> firstBlock = {{ 0, 0, 0 }};
+    unsigned long firstIndex = this->CalculateIndex(firstBlock, image);
+    unsigned long numberOfBlocks = this->m_BlocksPerImage[0] * this->m_BlocksPerImage[1] * this->m_BlocksPerImage[2];
+    bool cached = true;
+    this->m_CacheLock.Lock();
+    for (unsigned long index = firstIndex; index < firstIndex + numberOfBlocks; ++index)
+      {
+      cached = cached && this->m_Cache.find(index) != 0;
+      }
+    this->m_CacheLock.Unlock();
+    return cached;
+    }
+
+protected:
+  TimeSeriesDatabaseTester() {}
+  ~TimeSeriesDatabaseTester() {}
+};
+
+typedef TimeSeriesDatabaseTester<PixelType> DatabaseType;
+
+//----------------------------------------------------------------------------
+bool WriteImages(const std::string& directory)
+{
+  ImageType::SizeType size = {{ 20, 17, 5 }};
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.5;
+  spacing[2] = 3.0;
+  ImageType::PointType origin;
+  origin[0] = -10.0;
+  origin[1] = 5.0;
+  origin[2] = 2.5;
+  for (unsigned int image = 0; image < NumberOfImages; ++image)
+    {
+    ImageType::Pointer volume = ImageType::New();
+    volume->SetRegions(ImageType::RegionType(size));
+    volume->SetSpacing(spacing);
+    volume->SetOrigin(origin);
+    volume->Allocate();
+    itk::ImageRegionIteratorWithIndex<ImageType> it(volume, volume->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      it.Set(ExpectedValue(it.GetIndex(), image));
+      }
+    std::ostringstream fileName;
+    fileName << directory << "/volume_" << image << ".nrrd";
+    typedef itk::ImageFileWriter<ImageType> WriterType;
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName(fileName.str());
+    writer->SetInput(volume);
+    try
+      {
+      writer->Update();
+      }
+    catch (itk::ExceptionObject& err)
+      {
+      std::cerr << "Failed to write " << fileName.str() << ": " << err << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CheckImage(DatabaseType* database, unsigned int image)
+{
+  database->SetCurrentImage(image);
+  database->Update();
+  ImageType* output = database->GetOutput();
+  if (output->GetLargestPossibleRegion().GetSize()[0] != 20
+    || output->GetSpacing()[1] != 1.5 || output->GetOrigin()[2] != 2.5)
+    {
+    std::cerr << "Invalid geometry of image " << image << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it(output, output->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() != ExpectedValue(it.GetIndex(), image))
+      {
+      std::cerr << "Image " << image << " voxel " << it.GetIndex() << " is " << it.Get()
+                << ", expected " << ExpectedValue(it.GetIndex(), image) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CheckVoxelTimeSeries(DatabaseType* database)
+{
+  ImageType::IndexType indexes[3] = {{{ 0, 0, 0 }}, {{ 19, 16, 4 }}, {{ 17, 3, 2 }}};
+  for (int n = 0; n < 3; ++n)
+    {
+    DatabaseType::ArrayType timeSeries;
+    database->GetVoxelTimeSeries(indexes[n], timeSeries);
+    if (timeSeries.GetSize() != NumberOfImages)
+      {
+      std::cerr << "Invalid time series length " << timeSeries.GetSize() << std::endl;
+      return false;
+      }
+    for (unsigned int image = 0; image < NumberOfImages; ++image)
+      {
+      if (timeSeries[image] != ExpectedValue(indexes[n], image))
+        {
+        std::cerr << "Time series of voxel " << indexes[n] << " at image " << image << " is "
+                  << timeSeries[image] << ", expected " << ExpectedValue(indexes[n], image) << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Read all the images back and forth
+bool CheckAllImages(DatabaseType* database)
+{
+  for (unsigned int image = 0; image < NumberOfImages; ++image)
+    {
+    if (!CheckImage(database, image))
+      {
+      return false;
+      }
+    }
+  for (int image = NumberOfImages - 1; image >= 0; --image)
+    {
+    if (!CheckImage(database, image))
+      {
+      return false;
+      }
+    }
+  return CheckVoxelTimeSeries(database);
+}
+
+//----------------------------------------------------------------------------
+bool WaitForCachedImage(DatabaseType* database, unsigned int image)
+{
+  for (int attempt = 0; attempt < 500; ++attempt)
+    {
+    if (database->IsImageCached(image))
+      {
+      return true;
+      }
+    itksys::SystemTools::Delay(10);
+    }
+  std::cerr << "Image " << image << " has not been prefetched" << std::endl;
+  return false;
+}
+
+//----------------------------------------------------------------------------
+ITK_THREAD_RETURN_TYPE NoOpThreaderCallback(void*)
+{
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  itk::itkFactoryRegistration();
+
+  if (argc < 2)
+    {
+    std::cout << "ERROR: need to specify a temporary directory on the command line." << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = std::string(argv[1]) + "/itkTimeSeriesDatabaseTest";
+  itksys::SystemTools::RemoveADirectory(directory.c_str());
+  itksys::SystemTools::MakeDirectory(directory.c_str());
+  if (!WriteImages(directory))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Small files: images are split between files
+  const std::string databaseFileName = directory + "/database.tsd";
+  const unsigned long blocksPerFile = 3;
+  try
+    {
+    DatabaseType::CreateFromFileArchetype(databaseFileName.c_str(), (directory + "/volume_0.nrrd").c_str(),
+      blocksPerFile * TimeSeriesVolumeBlockSize * sizeof(PixelType));
+    }
+  catch (itk::ExceptionObject& err)
+    {
+    std::cerr << "Failed to create the database: " << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Mapped files
+  DatabaseType::Pointer mappedDatabase = DatabaseType::New();
+  mappedDatabase->Connect(databaseFileName.c_str());
+  if (mappedDatabase->GetNumberOfVolumes() != static_cast<int>(NumberOfImages))
+    {
+    std::cerr << "Database has " << mappedDatabase->GetNumberOfVolumes() << " images, expected " << NumberOfImages << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!mappedDatabase->IsMapped())
+    {
+    std::cout << "Database files are not mapped, mapped reads are not tested" << std::endl;
+    }
+  if (!CheckAllImages(mappedDatabase))
+    {
+    std::cerr << "Mapped reads failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Streams and block cache, without prefetching
+  DatabaseType::Pointer cachedDatabase = DatabaseType::New();
+  cachedDatabase->UseMemoryMappingOff();
+  cachedDatabase->SetNumberOfPrefetchedImages(0);
+  cachedDatabase->Connect(databaseFileName.c_str());
+  if (cachedDatabase->IsMapped() || !CheckAllImages(cachedDatabase))
+    {
+    std::cerr << "Cached reads failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (cachedDatabase->IsPrefetchThreadActive())
+    {
+    std::cerr << "Prefetch thread started while prefetching is disabled" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Cache smaller than an image: blocks are evicted while images are generated
+  cachedDatabase->SetCacheSizeInMiB(0.01);
+  if (!CheckAllImages(cachedDatabase))
+    {
+    std::cerr << "Cached reads with block eviction failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  cachedDatabase->Disconnect();
+
+  // Prefetching in the browsing direction
+  DatabaseType::Pointer prefetchedDatabase = DatabaseType::New();
+  prefetchedDatabase->UseMemoryMappingOff();
+  prefetchedDatabase->SetNumberOfPrefetchedImages(2);
+  prefetchedDatabase->Connect(databaseFileName.c_str());
+  if (!CheckImage(prefetchedDatabase, 1)
+    || !prefetchedDatabase->IsPrefetchThreadActive()
+    || !WaitForCachedImage(prefetchedDatabase, 2)
+    || !WaitForCachedImage(prefetchedDatabase, 3)
+    || prefetchedDatabase->IsImageCached(0)
+    || !CheckImage(prefetchedDatabase, 2)
+    || !CheckImage(prefetchedDatabase, 3))
+    {
+    std::cerr << "Forward prefetch failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Disconnect clears the cache
+  prefetchedDatabase->Disconnect();
+  prefetchedDatabase->Connect(databaseFileName.c_str());
+  if (!CheckImage(prefetchedDatabase, 5)
+    || !CheckImage(prefetchedDatabase, 4)
+    || !WaitForCachedImage(prefetchedDatabase, 3)
+    || !WaitForCachedImage(prefetchedDatabase, 2)
+    || prefetchedDatabase->IsImageCached(1)
+    || !CheckImage(prefetchedDatabase, 3))
+    {
+    std::cerr << "Backward prefetch failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CheckAllImages(prefetchedDatabase))
+    {
+    std::cerr << "Prefetched reads failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Disconnect stops the prefetch thread
+  prefetchedDatabase->Disconnect();
+  if (prefetchedDatabase->IsPrefetchThreadActive())
+    {
+    std::cerr << "Prefetch thread still active after Disconnect" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Destruction stops the prefetch thread, even while it is prefetching
+  prefetchedDatabase->SetNumberOfPrefetchedImages(NumberOfImages);
+  prefetchedDatabase->Connect(databaseFileName.c_str());
+  if (!CheckImage(prefetchedDatabase, 0) || !prefetchedDatabase->IsPrefetchThreadActive())
+    {
+    std::cerr << "Prefetch thread not started" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::MultiThreader::Pointer prefetchThreader = prefetchedDatabase->GetPrefetchThreader();
+  itk::ThreadIdType prefetchThreadId = prefetchedDatabase->GetPrefetchThreadId();
+  prefetchedDatabase = ITK_NULLPTR;
+  // The slot of a thread is reused only once the thread has been terminated
+  itk::ThreadIdType threadId = prefetchThreader->SpawnThread(NoOpThreaderCallback, ITK_NULLPTR);
+  prefetchThreader->TerminateThread(threadId);
+  if (threadId != prefetchThreadId)
+    {
+    std::cerr << "Prefetch thread " << prefetchThreadId << " not terminated on destruction" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  mappedDatabase = ITK_NULLPTR;
+  cachedDatabase = ITK_NULLPTR;
+  itksys::SystemTools::RemoveADirectory(directory.c_str());
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
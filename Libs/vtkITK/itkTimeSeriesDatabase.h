@@ -5,8 +5,12 @@
 #include <itkImage.h>
 #include <itkArray.h>
 #include <itkImageSource.h>
+#include <itkConditionVariable.h>
+#include <itkMultiThreader.h>
+#include <itkMutexLock.h>
 #include <iostream>
 #include <fstream>
+#include <vector>
 #include <itkTimeSeriesDatabaseHelper.h>
 
 #define TimeSeriesBlockSize 16
@@ -24,6 +28,12 @@ namespace itk
  * The main idea behind TimeSeriesDatabase is to have a representation of a 4 dimensional dataset that
  * is larger than main memory, but may still be accessed in a rapid manner.  Though not strictly
  * ITK conforming, this initial pass is strictly 4 dimensional datasets.
+ *
+ * The database files are memory mapped when possible (see UseMemoryMapping),
+ * otherwise blocks are read with streams into a LRU cache shared by all
+ * threads. Images are generated by multiple threads, and the images that
+ * follow the current one in the browsing direction are read ahead by a
+ * background thread (see NumberOfPrefetchedImages).
  */
 template <class TPixel> class TimeSeriesDatabase : public ImageSource<Image<TPixel,3> > {
 public:
@@ -65,6 +75,7 @@ public:
    * into a series of files.  The default filesize is 1 GiB, but may
    * be changed using the overloaded method.
    * A call to Connect in required to open the newly created TimeSeriesDatabase.
+   * Volumes are read and written by multiple threads.
    */
   static void CreateFromFileArchetype ( const char* filename, const char* archetype );
   static void CreateFromFileArchetype ( const char* filename, const char* archetype, unsigned long BlocksPerFile );
@@ -86,7 +97,9 @@ public:
 
   /** Standard method for a ImageSource object */
   virtual void GenerateOutputInformation(void) ITK_OVERRIDE;
-  virtual void GenerateData(void) ITK_OVERRIDE;
+  virtual void BeforeThreadedGenerateData(void) ITK_OVERRIDE;
+  virtual void ThreadedGenerateData(const typename OutputImageType::RegionType& outputRegionForThread,
+                                    ThreadIdType threadId) ITK_OVERRIDE;
 
   /** A convience method for reading a voxel's time course
    * Subsequent calls to voxels in the immediate region of this will be
@@ -101,6 +114,19 @@ public:
    */
   float GetCacheSizeInMiB ();
 
+  /** Map the database files in memory instead of reading them with
+   * streams.  Takes effect on the next call to Connect.  On by default.
+   */
+  itkSetMacro ( UseMemoryMapping, bool );
+  itkGetConstMacro ( UseMemoryMapping, bool );
+  itkBooleanMacro ( UseMemoryMapping );
+
+  /** Number of images read in the background after the current one, in
+   * the direction the images are browsed.  0 disables prefetching.
+   */
+  itkSetMacro ( NumberOfPrefetchedImages, unsigned int );
+  itkGetConstMacro ( NumberOfPrefetchedImages, unsigned int );
+
 
 protected:
   TimeSeriesDatabase();
@@ -116,6 +142,7 @@ protected:
   typename OutputImageType::DirectionType m_OutputDirection;
 
   typedef itk::TimeSeriesDatabaseHelper::counted_ptr<std::fstream> StreamPtr;
+  typedef itk::TimeSeriesDatabaseHelper::counted_ptr<itk::TimeSeriesDatabaseHelper::MappedFile> MappedFilePtr;
 
   static std::streampos CalculatePosition ( unsigned long index, unsigned long BlocksPerFile );
 
@@ -136,9 +163,12 @@ protected:
   std::string  m_Filename;
   unsigned int m_CurrentImage;
 
-  std::vector<StreamPtr>   m_DatabaseFiles;
-  std::vector<std::string> m_DatabaseFileNames;
-  unsigned long            m_BlocksPerFile;
+  std::vector<StreamPtr>     m_DatabaseFiles;
+  /// Same size as m_DatabaseFiles, null for the files that are not mapped
+  std::vector<MappedFilePtr> m_MappedFiles;
+  std::vector<std::string>   m_DatabaseFileNames;
+  unsigned long              m_BlocksPerFile;
+  bool                       m_UseMemoryMapping;
 
   /// our cache
   struct CacheBlock
@@ -146,7 +176,50 @@ protected:
     TPixel data[TimeSeriesBlockSize*TimeSeriesBlockSize*TimeSeriesBlockSize];
   };
   TimeSeriesDatabaseHelper::LRUCache<unsigned long, CacheBlock> m_Cache;
-  CacheBlock* GetCacheBlock ( unsigned long index );
+  /// Protects the cache and the streams
+  SimpleMutexLock m_CacheLock;
+
+  /// Return the voxels of a block.  The returned pointer points either in the
+  /// mapped file or to scratch, where the block is copied.  Thread safe.
+  const TPixel* GetBlockData ( unsigned long index, CacheBlock& scratch );
+  /// Read the block in the cache if it is not there already.  Thread safe.
+  void CacheBlockData ( unsigned long index );
+
+  /// Background prefetching of the images that follow the current one
+  unsigned int               m_NumberOfPrefetchedImages;
+  int                        m_LastGeneratedImage;
+  MultiThreader::Pointer     m_PrefetchThreader;
+  ThreadIdType               m_PrefetchThreadId;
+  bool                       m_PrefetchThreadActive;
+  std::vector<unsigned int>  m_PrefetchQueue;
+  /// Incremented for every new request, so that stale requests are abandoned
+  unsigned long              m_PrefetchRequest;
+  SimpleMutexLock            m_PrefetchLock;
+  ConditionVariable::Pointer m_PrefetchCondition;
+
+  void RequestPrefetch ( unsigned int image, int direction );
+  void StopPrefetchThread ();
+  bool IsPrefetchRequestStale ( unsigned long request );
+  void PrefetchImage ( unsigned int image, unsigned long request );
+  void ProcessPrefetchRequests ();
+  static ITK_THREAD_RETURN_TYPE PrefetchThreaderCallback ( void* arg );
+
+  /// Multithreaded conversion of volumes to blocks, used by CreateFromFileArchetype
+  struct ArchetypeJob
+  {
+    std::vector<std::string> Filenames;
+    std::vector<StreamPtr>   Files;
+    unsigned long            BlocksPerFile;
+    unsigned int             Dimensions[3];
+    unsigned int             BlocksPerImage[3];
+    SimpleMutexLock          Lock; // protects the files, the next volume and the error
+    unsigned int             NextVolume;
+    std::string              Error;
+  };
+  static ITK_THREAD_RETURN_TYPE ArchetypeThreaderCallback ( void* arg );
+  static void CopyVolumeToBlocks ( const OutputImageType* image, const unsigned int BlocksPerImage[3], TPixel* blocks );
+  static void WriteBlocks ( std::vector<StreamPtr>& files, unsigned long index, unsigned long numberOfBlocks,
+                            const TPixel* blocks, unsigned long BlocksPerFile );
 };
 
 } // end namespace itk
@@ -11,6 +11,8 @@
 #include <itkImageFileReader.h>
 #include <itksys/SystemTools.hxx>
 #include "itkArchetypeSeriesFileNames.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <vector>
 
@@ -60,12 +62,19 @@ bool TimeSeriesDatabase<TPixel>::IsOpen () const
 template <class TPixel>
 void TimeSeriesDatabase<TPixel>::Disconnect ()
 {
-  for ( int idx = 0; idx < this->m_DatabaseFiles.size(); idx++ )
+  // The prefetch thread reads the files
+  this->StopPrefetchThread();
+  for ( ::size_t idx = 0; idx < this->m_DatabaseFiles.size(); idx++ )
     {
     this->m_DatabaseFiles[idx]->close();
     }
   this->m_DatabaseFiles.clear();
+  this->m_MappedFiles.clear();
   this->m_DatabaseFileNames.clear();
+  this->m_CacheLock.Lock();
+  this->m_Cache.clear();
+  this->m_CacheLock.Unlock();
+  this->m_LastGeneratedImage = -1;
 }
 
 template <class TPixel>
@@ -121,7 +130,10 @@ void TimeSeriesDatabase<TPixel>::Connect ( const char* filename )
   // Read the "Filenames:" line
   o >> dummy;
   this->m_DatabaseFiles.clear();
+  this->m_MappedFiles.clear();
   this->m_DatabaseFileNames.clear();
+  this->m_Cache.clear();
+  this->m_LastGeneratedImage = -1;
   // Read and open the files
   for ( int idx = 0; idx < NumberOfFiles; idx++ )
     {
@@ -130,6 +142,17 @@ void TimeSeriesDatabase<TPixel>::Connect ( const char* filename )
     // std::cout << "Reading file " << idx << " " << Filename << std::endl;
     this->m_DatabaseFileNames.push_back ( Filename );
     this->m_DatabaseFiles.push_back ( StreamPtr ( new std::fstream ( Filename.c_str(), ::std::ios::in | ::std::ios::binary ) ) );
+    MappedFilePtr mapped;
+    if ( this->m_UseMemoryMapping )
+      {
+      mapped = MappedFilePtr ( new TimeSeriesDatabaseHelper::MappedFile ( Filename.c_str() ) );
+      if ( mapped->data() == 0 )
+        {
+        itkWarningMacro ( "TimeSeriesDatabase::Connect: failed to map " << Filename << ", reading it with a stream" );
+        mapped = MappedFilePtr();
+        }
+      }
+    this->m_MappedFiles.push_back ( mapped );
     }
   /*
   std::cout << "ImageSize: " << m_OutputRegion.GetSize() << endl;
@@ -184,20 +207,51 @@ template <class TPixel>
 
 
 template <class TPixel>
-typename TimeSeriesDatabase<TPixel>::CacheBlock* TimeSeriesDatabase<TPixel>::GetCacheBlock ( unsigned long index )
+const TPixel* TimeSeriesDatabase<TPixel>::GetBlockData ( unsigned long index, CacheBlock& scratch )
 {
+  const ::size_t BlockBytes = TimeSeriesVolumeBlockSize * sizeof ( TPixel );
+  int FileIdx = this->CalculateFileIndex ( index );
+  TimeSeriesDatabaseHelper::MappedFile* mapped = this->m_MappedFiles[FileIdx].get();
+  ::size_t position = static_cast< ::size_t > ( this->CalculatePosition ( index, this->m_BlocksPerFile ) );
+  if ( mapped && position + BlockBytes <= mapped->size() )
+    {
+    // Blocks are aligned on their size in the file, so they can be used in place
+    return reinterpret_cast<const TPixel*> ( mapped->data() + position );
+    }
+
+  this->m_CacheLock.Lock();
   CacheBlock* Buffer = this->m_Cache.find ( index );
-  if ( Buffer == 0 ) {
+  if ( Buffer == 0 )
+    {
     // Fill it in
+    this->m_DatabaseFiles[FileIdx]->clear();
+    this->m_DatabaseFiles[FileIdx]->seekg ( this->CalculatePosition ( index, this->m_BlocksPerFile ) );
+    this->m_DatabaseFiles[FileIdx]->read ( reinterpret_cast<char*> ( scratch.data ), BlockBytes );
+    this->m_Cache.insert ( index, scratch );
+    }
+  else
+    {
+    // The cached block may be evicted by another thread once unlocked
+    memcpy ( scratch.data, Buffer->data, BlockBytes );
+    }
+  this->m_CacheLock.Unlock();
+  return scratch.data;
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::CacheBlockData ( unsigned long index )
+{
+  this->m_CacheLock.Lock();
+  if ( this->m_Cache.find ( index ) == 0 )
+    {
     CacheBlock B;
     int FileIdx = this->CalculateFileIndex ( index );
-
+    this->m_DatabaseFiles[FileIdx]->clear();
     this->m_DatabaseFiles[FileIdx]->seekg ( this->CalculatePosition ( index, this->m_BlocksPerFile ) );
     this->m_DatabaseFiles[FileIdx]->read ( reinterpret_cast<char*> ( B.data ), TimeSeriesVolumeBlockSize * sizeof ( TPixel ) );
     this->m_Cache.insert ( index, B );
-    Buffer = this->m_Cache.find ( index );
-  }
-  return Buffer;
+    }
+  this->m_CacheLock.Unlock();
 }
 
 
@@ -209,17 +263,18 @@ void TimeSeriesDatabase<TPixel>::GetVoxelTimeSeries ( typename OutputImageType::
   Size<3> CurrentBlock;
   Size<3> Offset;
   for ( int i = 0; i < 3; i++ ) {
-    if ( idx[i] < 0 || idx[i] > this->m_OutputRegion.Size[i] ) {
-      throw 1;
+    if ( idx[i] < 0 || idx[i] >= static_cast<IndexValueType> ( this->m_Dimensions[i] ) ) {
+      itkExceptionMacro ( "TimeSeriesDatabase::GetVoxelTimeSeries: index " << idx << " is outside of the volume" );
     }
-    CurrentBlock[i] = reinterpret_cast<unsigned long> ( idx[i] / (double)TimeSeriesBlockSize );
+    CurrentBlock[i] = idx[i] / TimeSeriesBlockSize;
     Offset[i] = idx[i] % TimeSeriesBlockSize;
   }
   unsigned long offset = Offset[0] + Offset[1] * TimeSeriesBlockSize + Offset[2] * TimeSeriesBlockSizeP2;
   array = ArrayType ( this->m_Dimensions[3] );
-  for ( int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
-    CacheBlock* cache = this->GetCacheBlock ( CurrentBlock, volume );
-    array[volume] = cache->data[offset];
+  CacheBlock scratch;
+  for ( unsigned int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
+    const TPixel* data = this->GetBlockData ( this->CalculateIndex ( CurrentBlock, volume ), scratch );
+    array[volume] = data[offset];
   }
 }
 
@@ -235,19 +290,31 @@ void TimeSeriesDatabase<TPixel>::GenerateOutputInformation ( )
 }
 
 template <class TPixel>
-void TimeSeriesDatabase<TPixel>::GenerateData()
+void TimeSeriesDatabase<TPixel>::BeforeThreadedGenerateData()
 {
-  typename OutputImageType::Pointer output = this->GetOutput();
-  typename OutputImageType::RegionType Region;
-  itkDebugMacro ( << "TimeSeriesDatabase::GenerateData()  Allocating" );
-  Region = output->GetRequestedRegion();
-  output->SetBufferedRegion ( Region );
-  output->Allocate();
-
   if ( !this->IsOpen() )
   {
-    itkGenericExceptionMacro ( "TimeSeriesDatabase::GenerateOutputInformation: not open for reading" );
+    itkGenericExceptionMacro ( "TimeSeriesDatabase::GenerateData: not open for reading" );
   }
+  if ( this->m_CurrentImage >= this->m_Dimensions[3] )
+  {
+    itkExceptionMacro ( "TimeSeriesDatabase::GenerateData: image " << this->m_CurrentImage
+                        << " requested, the database has " << this->m_Dimensions[3] << " images" );
+  }
+
+  // Read ahead in the direction the images are browsed, while this one is generated
+  int direction = ( this->m_LastGeneratedImage > static_cast<int> ( this->m_CurrentImage ) ) ? -1 : 1;
+  this->m_LastGeneratedImage = this->m_CurrentImage;
+  this->RequestPrefetch ( this->m_CurrentImage, direction );
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::ThreadedGenerateData ( const typename OutputImageType::RegionType& outputRegionForThread,
+                                                        ThreadIdType itkNotUsed(threadId) )
+{
+  typename OutputImageType::Pointer output = this->GetOutput();
+  typename OutputImageType::RegionType Region = outputRegionForThread;
+  CacheBlock scratch;
 
   Size<3> BlockStart, BlockCount;
   for ( unsigned int i = 0; i < 3; i++ ) {
@@ -275,7 +342,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
         typename OutputImageType::RegionType BR, IR;
         if ( print ) {  std::cout << "For Block Index: " << CurrentBlock << std::endl; }
         unsigned long index = this->CalculateIndex ( CurrentBlock, this->m_CurrentImage );
-        CacheBlock* Buffer = this->GetCacheBlock ( index );
+        const TPixel* Buffer = this->GetBlockData ( index, scratch );
         if ( this->CalculateIntersection ( CurrentBlock, Region, BR, IR ) ) {
           // Just iterate over whole block
           // Good we can use an iterator!
@@ -290,7 +357,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
           BlockRegion.SetIndex ( BlockIndex );
           ImageRegionIterator<OutputImageType> it ( output, IR );
           it.GoToBegin();
-          TPixel* ptr = Buffer->data;
+          const TPixel* ptr = Buffer;
           while ( !it.IsAtEnd() ) {
             it.Set ( *ptr );
             ++it;
@@ -305,7 +372,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
             std::cout << "Count: " << Count << std::endl;
             std::cout << "Block Region: " << BR;
             std::cout << "Image Region: " << IR;
-            std::cout << "First voxel: " << Buffer->data[0] << std::endl;
+            std::cout << "First voxel: " << Buffer[0] << std::endl;
           }
           unsigned int bx, by, bz, x, y, z;
           for ( z = 0; z < Count[2]; z++ ) {
@@ -325,7 +392,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
                 }
                 */
 
-                output->SetPixel ( ImageIndex, Buffer->data[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
+                output->SetPixel ( ImageIndex, Buffer[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
                 }
               }
             }
@@ -390,139 +457,55 @@ void TimeSeriesDatabase<TPixel>::CreateFromFileArchetype ( const char* TSDFilena
   m_OutputDirection = reader->GetOutput()->GetDirection();
 
 
-  // Make our array, and open it
-  std::vector<StreamPtr> db;
-  db.push_back ( StreamPtr ( new std::fstream ( TSDFilename, ::std::ios::out | ::std::ios::binary ) ) );
-
-  // Filenames
-  std::vector<std::string> Filenames;
-  Filenames.push_back ( std::string ( TSDFilename ) );
-
-  // Start reading and writing out the images, 16x16x16 blocks at a time.
+  // Make our array, and open it.  All the files are opened up front,
+  // so that the threads only seek and write.
+  ArchetypeJob job;
+  job.BlocksPerFile = BlocksPerFile;
+  job.NextVolume = 0;
+  unsigned long BlocksPerVolume = 1;
+  for ( int idx = 0; idx < 3; idx++ )
+    {
+    job.Dimensions[idx] = m_Dimensions[idx];
+    job.BlocksPerImage[idx] = (unsigned int) ceil ( m_Dimensions[idx] / (float)TimeSeriesBlockSize );
+    BlocksPerVolume *= job.BlocksPerImage[idx];
+    }
   for ( unsigned int i = 0; i < candidateFiles.size(); i++ )
     {
-    reader->SetFileName ( itksys::SystemTools::CollapseFullPath ( candidateFiles[i].c_str() ) );
-    try {
-      reader->Update();
-    } catch ( ExceptionObject& e ) {
-      itkGenericExceptionMacro ( << "Failed to read " << candidateFiles[i] << " caught " << e );
+    job.Filenames.push_back ( itksys::SystemTools::CollapseFullPath ( candidateFiles[i].c_str() ) );
     }
-    // Verify that we have the same size as expected
-    region = reader->GetOutput()->GetLargestPossibleRegion();
-    if ( m_Dimensions[0] != region.GetSize()[0]
-         || m_Dimensions[1] != region.GetSize()[1]
-         || m_Dimensions[2] != region.GetSize()[2] ) {
 
-      // close them all
-    for ( int idx = 0; idx < (int)(db.size()); idx++ )
+  // Filenames, remember that the first block is the header
+  std::vector<std::string> Filenames;
+  std::vector<StreamPtr>& db = job.Files;
+  unsigned long NumberOfFiles = CalculateFileIndex ( BlocksPerVolume * candidateFiles.size(), BlocksPerFile ) + 1;
+  for ( unsigned long FileIndex = 0; FileIndex < NumberOfFiles; FileIndex++ )
+    {
+    ::std::ostringstream newFN;
+    newFN << TSDFilename;
+    if ( FileIndex > 0 )
       {
-      db[idx]->close();
+      newFN << FileIndex;
       }
-    itkGenericExceptionMacro ( << " size of the data in " << candidateFiles[i] << " is ("
-                               << region.GetSize()[0] << ", "
-                               << region.GetSize()[1] << ", "
-                               << region.GetSize()[2] << ") "
-                               << " and does not match the expectected size ("
-                               << m_Dimensions[0] << ", "
-                               << m_Dimensions[1] << ", "
-                               << m_Dimensions[2] << ")" );
+    db.push_back ( StreamPtr ( new std::fstream ( newFN.str().c_str(), ::std::ios::out | ::std::ios::binary ) ) );
+    Filenames.push_back ( newFN.str() );
     }
 
-    // Build and write our blocks
-    TPixel buffer[TimeSeriesBlockSize*TimeSeriesBlockSize*TimeSeriesBlockSize];
-    Size<3> BlockSize = { {TimeSeriesBlockSize, TimeSeriesBlockSize, TimeSeriesBlockSize }};
-    ImageRegion<3> BlockRegion;
-    unsigned int m_BlocksPerImage[3];
-
-    BlockRegion.SetSize ( BlockSize );
-    for ( int idx = 0; idx < 3; idx++ )
-      {
-      m_BlocksPerImage[idx] = (unsigned int) ceil ( m_Dimensions[idx] / (float)TimeSeriesBlockSize );
-      }
-    Size<3> CurrentBlock;
-    for ( CurrentBlock[2] = 0; CurrentBlock[2] < m_BlocksPerImage[2]; CurrentBlock[2]++ )
+  // Start reading and writing out the images, 16x16x16 blocks at a time.
+  // Each thread reads whole volumes, so reading, rearranging and writing overlap.
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads ( TSD_MAX<int> ( 1, TSD_MIN<int> ( threader->GetNumberOfThreads(), candidateFiles.size() ) ) );
+  threader->SetSingleMethod ( ArchetypeThreaderCallback, &job );
+  threader->SingleMethodExecute();
+  if ( !job.Error.empty() )
+    {
+    // close them all
+    for ( int idx = 0; idx < (int)(db.size()); idx++ )
       {
-      for ( CurrentBlock[1] = 0; CurrentBlock[1] < m_BlocksPerImage[1]; CurrentBlock[1]++ )
-        {
-        for ( CurrentBlock[0] = 0; CurrentBlock[0] < m_BlocksPerImage[0]; CurrentBlock[0]++ )
-          {
-          /*
-          std::cout << "Reading/Writing Block: " << CurrentBlock[0] << ", " << CurrentBlock[1] << ", " << CurrentBlock[2] << endl;
-          std::cout << "Debug: " << ( ( CurrentBlock[2] * TimeSeriesBlockSize + TimeSeriesBlockSize ) < region.GetSize()[2] ) << endl;
-          std::cout << "Debug: " << CurrentBlock[2] * TimeSeriesBlockSize + TimeSeriesBlockSize << " Region size  " << region.GetSize()[2] << endl;
-          */
-          // Load up the block, and save it at the proper index
-          // Is this block fully within the image?
-          if ( ( ( CurrentBlock[0] * TimeSeriesBlockSize + TimeSeriesBlockSize ) < region.GetSize()[0] )
-               && ( ( CurrentBlock[1] * TimeSeriesBlockSize + TimeSeriesBlockSize ) < region.GetSize()[1] )
-               && ( ( CurrentBlock[2] * TimeSeriesBlockSize + TimeSeriesBlockSize ) < region.GetSize()[2] ) )
-            {
-            // Good we can use an iterator!
-            Index<3> BlockIndex = { {
-               static_cast<IndexValueType>(CurrentBlock[0] * TimeSeriesBlockSize),
-               static_cast<IndexValueType>(CurrentBlock[1] * TimeSeriesBlockSize),
-               static_cast<IndexValueType>(CurrentBlock[2] * TimeSeriesBlockSize) } };
-            BlockRegion.SetIndex ( BlockIndex );
-            ImageRegionIteratorWithIndex<ImageType> it ( reader->GetOutput(), BlockRegion );
-            it.GoToBegin();
-            TPixel* ptr = buffer;
-            while ( !it.IsAtEnd() )
-              {
-              *ptr = it.Value();
-              ++it;
-              ++ptr;
-              }
-            }
-          else
-            {
-            // cout << "The Hard way" << std::endl;
-            // Now we do it the hard way...
-            Index<3> BlockIndex;
-            Size<3> StartIndex, EndIndex;
-            for ( int ii = 0; ii < 3; ii++ )
-              {
-              StartIndex[ii] = CurrentBlock[ii]*TimeSeriesBlockSize;
-              EndIndex[ii] = TSD_MIN ( StartIndex[ii] + TimeSeriesBlockSize, region.GetSize()[ii] );
-              }
-            for ( unsigned int bz = StartIndex[2]; bz < EndIndex[2]; bz++ )
-              {
-              BlockIndex[2] = bz;
-              for ( unsigned int by = StartIndex[1]; by < EndIndex[1]; by++ )
-                {
-                BlockIndex[1] = by;
-                for ( unsigned int bx = StartIndex[0]; bx < EndIndex[0]; bx++ )
-                  {
-                  // Put bx,by,bz into bx-xoff,by-yoff,bz-zoff
-                  BlockIndex[0] = bx;
-                  TPixel value = reader->GetOutput()->GetPixel ( BlockIndex );
-                  buffer[bx-StartIndex[0] + TimeSeriesBlockSize*(by-StartIndex[1]) + TimeSeriesBlockSize*TimeSeriesBlockSize*(bz-StartIndex[2])] = value;
-                  }
-                }
-              }
-            }
-          // Calculate where to write...  This code is copied from CalculatePosition and CalculateIndex
-          unsigned long index = CalculateIndex ( CurrentBlock, i, m_BlocksPerImage );
-          // Adjust the position, based on the FileIndex
-          ::std::streampos position = CalculatePosition ( index, BlocksPerFile );
-          unsigned long FileIndex = CalculateFileIndex ( index, BlocksPerFile );
-          // std::cout << "Found FileIndex : " << FileIndex << " For index: " << index << " position: " << position << std::endl;
-
-          while ( FileIndex >= db.size() )
-            {
-            // push on the next one.
-            ::std::ostringstream newFN;
-            newFN << TSDFilename << FileIndex;
-            // ::std::cout << "opening new file : " << newFN.str() << std::endl;
-            db.push_back ( StreamPtr ( new std::fstream ( newFN.str().c_str(), ::std::ios::out | ::std::ios::binary ) ) );
-            Filenames.push_back ( newFN.str() );
-            }
-
-          db[FileIndex]->seekp ( position );
-          db[FileIndex]->write ( reinterpret_cast<char*> ( buffer ), TimeSeriesBlockSize*TimeSeriesBlockSize*TimeSeriesBlockSize*sizeof(TPixel) );
-          }
-        }
+      db[idx]->close();
       }
+    itkGenericExceptionMacro ( << job.Error );
     }
+
   // Write the header
   db[0]->seekp ( 0 );
   ::std::ostringstream b;
@@ -557,6 +540,243 @@ void TimeSeriesDatabase<TPixel>::CreateFromFileArchetype ( const char* TSDFilena
     }
 }
 
+template <class TPixel>
+ITK_THREAD_RETURN_TYPE TimeSeriesDatabase<TPixel>::ArchetypeThreaderCallback ( void* arg )
+{
+  ArchetypeJob* job = static_cast<ArchetypeJob*> ( static_cast<MultiThreader::ThreadInfoStruct*> ( arg )->UserData );
+
+  typedef ImageFileReader<OutputImageType> ReaderType;
+  typename ReaderType::Pointer reader = ReaderType::New();
+  unsigned long BlocksPerVolume = job->BlocksPerImage[0] * job->BlocksPerImage[1] * job->BlocksPerImage[2];
+  // Padding of the blocks on the border of the volume stays zero
+  std::vector<TPixel> blocks ( BlocksPerVolume * TimeSeriesVolumeBlockSize, TPixel() );
+  while ( true )
+    {
+    job->Lock.Lock();
+    unsigned int i = job->NextVolume++;
+    bool done = ( i >= job->Filenames.size() || !job->Error.empty() );
+    job->Lock.Unlock();
+    if ( done )
+      {
+      break;
+      }
+
+    ::std::ostringstream error;
+    reader->SetFileName ( job->Filenames[i] );
+    try {
+      reader->Update();
+    } catch ( ExceptionObject& e ) {
+      error << "Failed to read " << job->Filenames[i] << " caught " << e;
+    }
+    // Verify that we have the same size as expected
+    typename OutputImageType::RegionType region = reader->GetOutput()->GetLargestPossibleRegion();
+    if ( error.str().empty()
+         && ( job->Dimensions[0] != region.GetSize()[0]
+              || job->Dimensions[1] != region.GetSize()[1]
+              || job->Dimensions[2] != region.GetSize()[2] ) ) {
+      error << " size of the data in " << job->Filenames[i] << " is ("
+            << region.GetSize()[0] << ", "
+            << region.GetSize()[1] << ", "
+            << region.GetSize()[2] << ") "
+            << " and does not match the expectected size ("
+            << job->Dimensions[0] << ", "
+            << job->Dimensions[1] << ", "
+            << job->Dimensions[2] << ")";
+    }
+    if ( !error.str().empty() )
+      {
+      job->Lock.Lock();
+      if ( job->Error.empty() )
+        {
+        job->Error = error.str();
+        }
+      job->Lock.Unlock();
+      break;
+      }
+
+    // Build and write our blocks, the blocks of a volume are contiguous
+    CopyVolumeToBlocks ( reader->GetOutput(), job->BlocksPerImage, &blocks[0] );
+    Size<3> FirstBlock = {{ 0, 0, 0 }};
+    unsigned long index = CalculateIndex ( FirstBlock, i, job->BlocksPerImage );
+    job->Lock.Lock();
+    WriteBlocks ( job->Files, index, BlocksPerVolume, &blocks[0], job->BlocksPerFile );
+    job->Lock.Unlock();
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::CopyVolumeToBlocks ( const OutputImageType* image, const unsigned int BlocksPerImage[3], TPixel* blocks )
+{
+  const TPixel* buffer = image->GetBufferPointer();
+  typename OutputImageType::RegionType region = image->GetBufferedRegion();
+  Size<3> CurrentBlock;
+  for ( CurrentBlock[2] = 0; CurrentBlock[2] < BlocksPerImage[2]; CurrentBlock[2]++ )
+    {
+    for ( CurrentBlock[1] = 0; CurrentBlock[1] < BlocksPerImage[1]; CurrentBlock[1]++ )
+      {
+      for ( CurrentBlock[0] = 0; CurrentBlock[0] < BlocksPerImage[0]; CurrentBlock[0]++ )
+        {
+        TPixel* block = blocks + TimeSeriesVolumeBlockSize
+          * ( CurrentBlock[0] + BlocksPerImage[0] * ( CurrentBlock[1] + BlocksPerImage[1] * CurrentBlock[2] ) );
+        Size<3> StartIndex, EndIndex;
+        for ( int ii = 0; ii < 3; ii++ )
+          {
+          StartIndex[ii] = CurrentBlock[ii]*TimeSeriesBlockSize;
+          EndIndex[ii] = TSD_MIN<SizeValueType> ( StartIndex[ii] + TimeSeriesBlockSize, region.GetSize()[ii] );
+          }
+        // Copy the block row by row
+        Index<3> RowIndex;
+        RowIndex[0] = region.GetIndex(0) + StartIndex[0];
+        for ( SizeValueType bz = StartIndex[2]; bz < EndIndex[2]; bz++ )
+          {
+          RowIndex[2] = region.GetIndex(2) + bz;
+          for ( SizeValueType by = StartIndex[1]; by < EndIndex[1]; by++ )
+            {
+            RowIndex[1] = region.GetIndex(1) + by;
+            const TPixel* row = buffer + image->ComputeOffset ( RowIndex );
+            std::copy ( row, row + ( EndIndex[0] - StartIndex[0] ),
+                        block + TimeSeriesBlockSize*(by-StartIndex[1]) + TimeSeriesBlockSize*TimeSeriesBlockSize*(bz-StartIndex[2]) );
+            }
+          }
+        }
+      }
+    }
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::WriteBlocks ( std::vector<StreamPtr>& files, unsigned long index, unsigned long numberOfBlocks,
+                                               const TPixel* blocks, unsigned long BlocksPerFile )
+{
+  // Write as few large chunks as possible, one per file
+  while ( numberOfBlocks > 0 )
+    {
+    unsigned long FileIndex = CalculateFileIndex ( index, BlocksPerFile );
+    unsigned long count = TSD_MIN ( numberOfBlocks, BlocksPerFile - index % BlocksPerFile );
+    files[FileIndex]->seekp ( CalculatePosition ( index, BlocksPerFile ) );
+    files[FileIndex]->write ( reinterpret_cast<const char*> ( blocks ), count * TimeSeriesVolumeBlockSize * sizeof(TPixel) );
+    index += count;
+    numberOfBlocks -= count;
+    blocks += count * TimeSeriesVolumeBlockSize;
+    }
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::RequestPrefetch ( unsigned int image, int direction )
+{
+  if ( this->m_NumberOfPrefetchedImages == 0 )
+    {
+    return;
+    }
+  this->m_PrefetchLock.Lock();
+  // Pending requests are replaced, only the images after the current one matter
+  this->m_PrefetchQueue.clear();
+  this->m_PrefetchRequest++;
+  for ( unsigned int offset = 1; offset <= this->m_NumberOfPrefetchedImages; offset++ )
+    {
+    int next = static_cast<int> ( image ) + direction * static_cast<int> ( offset );
+    if ( next < 0 || next >= static_cast<int> ( this->m_Dimensions[3] ) )
+      {
+      break;
+      }
+    this->m_PrefetchQueue.push_back ( next );
+    }
+  if ( !this->m_PrefetchThreadActive && !this->m_PrefetchQueue.empty() )
+    {
+    this->m_PrefetchThreadActive = true;
+    this->m_PrefetchThreadId = this->m_PrefetchThreader->SpawnThread ( PrefetchThreaderCallback, this );
+    }
+  this->m_PrefetchLock.Unlock();
+  this->m_PrefetchCondition->Signal();
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::StopPrefetchThread ()
+{
+  this->m_PrefetchLock.Lock();
+  bool running = this->m_PrefetchThreadActive;
+  this->m_PrefetchThreadActive = false;
+  this->m_PrefetchQueue.clear();
+  this->m_PrefetchRequest++;
+  this->m_PrefetchLock.Unlock();
+  if ( running )
+    {
+    this->m_PrefetchCondition->Broadcast();
+    // Wait for the thread to exit
+    this->m_PrefetchThreader->TerminateThread ( this->m_PrefetchThreadId );
+    }
+}
+
+template <class TPixel>
+bool TimeSeriesDatabase<TPixel>::IsPrefetchRequestStale ( unsigned long request )
+{
+  this->m_PrefetchLock.Lock();
+  bool stale = ( request != this->m_PrefetchRequest );
+  this->m_PrefetchLock.Unlock();
+  return stale;
+}
+
+template <class TPixel>
+ITK_THREAD_RETURN_TYPE TimeSeriesDatabase<TPixel>::PrefetchThreaderCallback ( void* arg )
+{
+  Self* self = static_cast<Self*> ( static_cast<MultiThreader::ThreadInfoStruct*> ( arg )->UserData );
+  self->ProcessPrefetchRequests();
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::ProcessPrefetchRequests ()
+{
+  this->m_PrefetchLock.Lock();
+  while ( true )
+    {
+    while ( this->m_PrefetchThreadActive && this->m_PrefetchQueue.empty() )
+      {
+      this->m_PrefetchCondition->Wait ( &this->m_PrefetchLock );
+      }
+    if ( !this->m_PrefetchThreadActive )
+      {
+      break;
+      }
+    unsigned int image = this->m_PrefetchQueue.front();
+    this->m_PrefetchQueue.erase ( this->m_PrefetchQueue.begin() );
+    unsigned long request = this->m_PrefetchRequest;
+    this->m_PrefetchLock.Unlock();
+    this->PrefetchImage ( image, request );
+    this->m_PrefetchLock.Lock();
+    }
+  this->m_PrefetchLock.Unlock();
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::PrefetchImage ( unsigned int image, unsigned long request )
+{
+  // The blocks of an image are contiguous, possibly split between two files
+  const ::size_t BlockBytes = TimeSeriesVolumeBlockSize * sizeof ( TPixel );
+  Size<3> FirstBlock = {{ 0, 0, 0 }};
+  unsigned long index = this->CalculateIndex ( FirstBlock, image );
+  unsigned long numberOfBlocks = this->m_BlocksPerImage[0] * this->m_BlocksPerImage[1] * this->m_BlocksPerImage[2];
+  while ( numberOfBlocks > 0 && !this->IsPrefetchRequestStale ( request ) )
+    {
+    unsigned int FileIdx = this->CalculateFileIndex ( index );
+    TimeSeriesDatabaseHelper::MappedFile* mapped = this->m_MappedFiles[FileIdx].get();
+    if ( mapped )
+      {
+      // Fault in the pages, they are then shared with the threads generating the image
+      unsigned long count = TSD_MIN ( numberOfBlocks, this->m_BlocksPerFile - index % this->m_BlocksPerFile );
+      mapped->will_need ( static_cast< ::size_t > ( this->CalculatePosition ( index, this->m_BlocksPerFile ) ), count * BlockBytes );
+      index += count;
+      numberOfBlocks -= count;
+      }
+    else
+      {
+      this->CacheBlockData ( index );
+      index++;
+      numberOfBlocks--;
+      }
+    }
+}
+
 template <class TPixel>
 float TimeSeriesDatabase<TPixel>::GetCacheSizeInMiB()
 {
@@ -569,18 +789,33 @@ void TimeSeriesDatabase<TPixel>::SetCacheSizeInMiB ( float sz )
 {
   // How many blocks is this?
   double BlockSizeInMiB = sizeof ( TPixel ) * TimeSeriesVolumeBlockSize / ( 1024*1024.);
-  unsigned long int blocks = (unsigned long int) ceil ( sz * BlockSizeInMiB );
+  unsigned long int blocks = (unsigned long int) ceil ( sz / BlockSizeInMiB );
+  this->m_CacheLock.Lock();
   this->m_Cache.set_maxsize ( blocks );
+  this->m_CacheLock.Unlock();
 }
 
 template <class TPixel>
 TimeSeriesDatabase<TPixel>::TimeSeriesDatabase () : m_Cache ( 1024 ){
   this->m_Dimensions.SetSize ( 4 );
+  this->m_Dimensions.Fill ( 0 );
   this->m_BlocksPerImage.SetSize ( 4 );
+  this->m_BlocksPerImage.Fill ( 0 );
+  this->m_CurrentImage = 0;
+  this->m_BlocksPerFile = 0;
+  this->m_UseMemoryMapping = true;
+  this->m_NumberOfPrefetchedImages = 2;
+  this->m_LastGeneratedImage = -1;
+  this->m_PrefetchThreader = MultiThreader::New();
+  this->m_PrefetchThreadId = 0;
+  this->m_PrefetchThreadActive = false;
+  this->m_PrefetchRequest = 0;
+  this->m_PrefetchCondition = ConditionVariable::New();
 }
 
 template <class TPixel>
 TimeSeriesDatabase<TPixel>::~TimeSeriesDatabase () {
+  this->StopPrefetchThread();
   // m_Cache.statistics ( std::cout );
 }
 
@@ -598,13 +833,16 @@ TimeSeriesDatabase<TPixel>
   os << indent << "OutputRegion: " << m_OutputRegion;
   os << indent << "OutputOrigin: " << m_OutputOrigin << "\n";
   os << indent << "OutputDirection: " << m_OutputDirection << "\n";
+  os << indent << "UseMemoryMapping: " << m_UseMemoryMapping << "\n";
+  os << indent << "NumberOfPrefetchedImages: " << m_NumberOfPrefetchedImages << "\n";
   if ( this->IsOpen() ) {
     os << indent << "Database is open." << "\n";
     os << indent << "Blocks per file: " << this->m_BlocksPerFile << "\n";
     os << indent << "File names: " << "\n";
     for ( ::size_t idx = 0; idx < this->m_DatabaseFileNames.size(); idx++ )
       {
-      os << indent << this->m_DatabaseFileNames[idx] << "\n";
+      os << indent << this->m_DatabaseFileNames[idx]
+         << ( this->m_MappedFiles[idx].get() ? " (mapped)" : "" ) << "\n";
       }
   } else {
     os << indent << "Database is closed." << "\n";
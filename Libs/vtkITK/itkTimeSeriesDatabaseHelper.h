@@ -6,6 +6,16 @@
 #include <string>
 #include <cstdarg>
 #include <cassert>
+#include <cstddef>
+
+#ifdef _WIN32
+# include <itkWindows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
 
 namespace itk {
   namespace TimeSeriesDatabaseHelper {
@@ -68,6 +78,115 @@ namespace itk {
         }
       };
 
+    /*
+     * MappedFile - read-only memory mapping of a whole file.
+     *
+     * data() is 0 if the file could not be mapped (e.g., address space
+     * exhausted on 32 bit systems), the caller then reads the file with
+     * a stream instead. The mapping is immutable, so it can be read from
+     * any number of threads without locking.
+     */
+    class MappedFile
+      {
+      public:
+
+        explicit MappedFile(const char* filename)
+          : m_Data(0), m_Size(0)
+#ifdef _WIN32
+          , m_File(INVALID_HANDLE_VALUE), m_Mapping(0)
+#endif
+        {
+#ifdef _WIN32
+          m_File = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ,
+                               0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+          LARGE_INTEGER fileSize;
+          if (m_File == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_File, &fileSize)
+              || fileSize.QuadPart == 0)
+            {
+            return;
+            }
+          m_Mapping = CreateFileMappingA(m_File, 0, PAGE_READONLY, 0, 0, 0);
+          if (m_Mapping)
+            {
+            m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+            }
+          if (m_Data)
+            {
+            m_Size = static_cast<size_t>(fileSize.QuadPart);
+            }
+#else
+          int fd = open(filename, O_RDONLY);
+          if (fd < 0)
+            {
+            return;
+            }
+          struct stat fileStat;
+          if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+            {
+            void* data = mmap(0, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if (data != MAP_FAILED)
+              {
+              m_Data = static_cast<const char*>(data);
+              m_Size = static_cast<size_t>(fileStat.st_size);
+              }
+            }
+          /// the mapping remains valid after the file is closed
+          close(fd);
+#endif
+        }
+
+        ~MappedFile()
+        {
+#ifdef _WIN32
+          if (m_Data) UnmapViewOfFile(m_Data);
+          if (m_Mapping) CloseHandle(m_Mapping);
+          if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+#else
+          if (m_Data) munmap(const_cast<char*>(m_Data), m_Size);
+#endif
+        }
+
+        const char* data() const {return m_Data;}
+        size_t      size() const {return m_Size;}
+
+        /// Bring a range of the file into memory, blocks until it is resident.
+        /// Meant to be called from a background thread.
+        void will_need(size_t offset, size_t length) const
+        {
+          if (!m_Data || offset >= m_Size)
+            {
+            return;
+            }
+          if (length > m_Size - offset)
+            {
+            length = m_Size - offset;
+            }
+          const size_t page = 4096;
+          size_t begin = offset - offset % page;
+#ifndef _WIN32
+          /// start the read ahead of the whole range at once
+          madvise(const_cast<char*>(m_Data) + begin, offset + length - begin, MADV_WILLNEED);
+#endif
+          volatile char touch = 0;
+          for (size_t position = begin; position < offset + length; position += page)
+            {
+            touch += m_Data[position];
+            }
+          (void)touch;
+        }
+
+      private:
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+
+        const char* m_Data;
+        size_t      m_Size;
+#ifdef _WIN32
+        HANDLE      m_File;
+        HANDLE      m_Mapping;
+#endif
+      };
+
     /// LRU Cache
 
     using namespace std;
@@ -66,6 +66,13 @@ public:
   int GetNumberOfVolumes()
   { DelegateITKOutputMacro ( GetNumberOfVolumes ); };
 
+  /// Get/Set the number of images read in the background after the current
+  /// one, so that browsing the images keeps up with playback
+  void SetNumberOfPrefetchedImages ( unsigned int value )
+  { DelegateITKInputMacro ( SetNumberOfPrefetchedImages, value); };
+  unsigned int GetNumberOfPrefetchedImages()
+  { DelegateITKOutputMacro ( GetNumberOfPrefetchedImages ); };
+
 protected:
   vtkITKTimeSeriesDatabase()
     {
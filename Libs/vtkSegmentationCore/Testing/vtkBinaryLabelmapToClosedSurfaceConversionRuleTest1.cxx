@@ -0,0 +1,217 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// SegmentationCore includes
+#include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkOrientedImageData.h"
+#include "vtkSegmentationConverter.h"
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void FillSphere(vtkOrientedImageData* labelmap, int center[3], int radius, unsigned char value)
+{
+  int* extent = labelmap->GetExtent();
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    for (int y = extent[2]; y <= extent[3]; ++y)
+      {
+      for (int x = extent[0]; x <= extent[1]; ++x)
+        {
+        int dx = x - center[0];
+        int dy = y - center[1];
+        int dz = z - center[2];
+        if (dx * dx + dy * dy + dz * dz <= radius * radius)
+          {
+          *static_cast<unsigned char*>(labelmap->GetScalarPointer(x, y, z)) = value;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Return true if the two surfaces have exactly the same points and cells
+bool AreSurfacesIdentical(vtkPolyData* surface1, vtkPolyData* surface2)
+{
+  if (surface1->GetNumberOfPoints() != surface2->GetNumberOfPoints())
+    {
+    std::cerr << "Number of points mismatch: " << surface1->GetNumberOfPoints()
+      << " != " << surface2->GetNumberOfPoints() << std::endl;
+    return false;
+    }
+  if (surface1->GetNumberOfPolys() != surface2->GetNumberOfPolys())
+    {
+    std::cerr << "Number of polygons mismatch: " << surface1->GetNumberOfPolys()
+      << " != " << surface2->GetNumberOfPolys() << std::endl;
+    return false;
+    }
+  for (vtkIdType pointId = 0; pointId < surface1->GetNumberOfPoints(); ++pointId)
+    {
+    double point1[3] = { 0.0, 0.0, 0.0 };
+    double point2[3] = { 0.0, 0.0, 0.0 };
+    surface1->GetPoint(pointId, point1);
+    surface2->GetPoint(pointId, point2);
+    if (point1[0] != point2[0] || point1[1] != point2[1] || point1[2] != point2[2])
+      {
+      std::cerr << "Point " << pointId << " mismatch" << std::endl;
+      return false;
+      }
+    }
+  vtkCellArray* polys1 = surface1->GetPolys();
+  vtkCellArray* polys2 = surface2->GetPolys();
+  vtkIdType numberOfCellPoints1 = 0;
+  vtkIdType* cellPointIds1 = NULL;
+  vtkIdType numberOfCellPoints2 = 0;
+  vtkIdType* cellPointIds2 = NULL;
+  polys1->InitTraversal();
+  polys2->InitTraversal();
+  while (polys1->GetNextCell(numberOfCellPoints1, cellPointIds1))
+    {
+    polys2->GetNextCell(numberOfCellPoints2, cellPointIds2);
+    if (numberOfCellPoints1 != numberOfCellPoints2)
+      {
+      std::cerr << "Polygon size mismatch" << std::endl;
+      return false;
+      }
+    for (vtkIdType i = 0; i < numberOfCellPoints1; ++i)
+      {
+      if (cellPointIds1[i] != cellPointIds2[i])
+        {
+        std::cerr << "Polygon point mismatch" << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CompareConversions(vtkOrientedImageData* labelmap, vtkBinaryLabelmapToClosedSurfaceConversionRule* wholeRule,
+  vtkBinaryLabelmapToClosedSurfaceConversionRule* blockwiseRule)
+{
+  vtkNew<vtkPolyData> wholeSurface;
+  vtkNew<vtkPolyData> blockwiseSurface;
+  if (!wholeRule->Convert(labelmap, wholeSurface.GetPointer())
+    || !blockwiseRule->Convert(labelmap, blockwiseSurface.GetPointer()))
+    {
+    std::cerr << "Conversion failed" << std::endl;
+    return false;
+    }
+  if (wholeSurface->GetNumberOfPolys() == 0)
+    {
+    std::cerr << "Empty surface" << std::endl;
+    return false;
+    }
+  return AreSurfacesIdentical(wholeSurface.GetPointer(), blockwiseSurface.GetPointer());
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkBinaryLabelmapToClosedSurfaceConversionRuleTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  // Labelmap with negative extent start and foreground voxels on its border, which requires padding
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(-5, 70, 2, 61, 0, 40);
+  labelmap->SetSpacing(0.5, 0.75, 1.2);
+  labelmap->SetOrigin(10.0, -20.0, 5.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  labelmap->GetPointData()->GetScalars()->FillComponent(0, 0);
+  int center1[3] = { 20, 30, 20 };
+  FillSphere(labelmap.GetPointer(), center1, 15, 1);
+  int center2[3] = { 62, 55, 36 };
+  FillSphere(labelmap.GetPointer(), center2, 10, 1);
+
+  vtkNew<vtkBinaryLabelmapToClosedSurfaceConversionRule> wholeRule;
+  wholeRule->SetBlockwiseConversionMinimumNumberOfVoxels(VTK_ID_MAX);
+  vtkNew<vtkBinaryLabelmapToClosedSurfaceConversionRule> blockwiseRule;
+  blockwiseRule->SetBlockwiseConversionMinimumNumberOfVoxels(0);
+
+  // Default parameters (smoothing, no decimation)
+  if (!CompareConversions(labelmap.GetPointer(), wholeRule.GetPointer(), blockwiseRule.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Blockwise conversion differs from whole labelmap conversion" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Decimation
+  std::string decimationFactorName = vtkBinaryLabelmapToClosedSurfaceConversionRule::GetDecimationFactorParameterName();
+  wholeRule->SetConversionParameter(decimationFactorName, "0.3");
+  blockwiseRule->SetConversionParameter(decimationFactorName, "0.3");
+  if (!CompareConversions(labelmap.GetPointer(), wholeRule.GetPointer(), blockwiseRule.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Blockwise conversion with decimation differs from whole labelmap conversion" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Local modification with recorded modified extent: only the blocks in that extent are updated
+  vtkMTimeType previousModifiedTime = labelmap->GetMTime();
+  int center3[3] = { 40, 20, 10 };
+  FillSphere(labelmap.GetPointer(), center3, 6, 1);
+  labelmap->Modified();
+  int modifiedExtent[6] = { 34, 46, 14, 26, 4, 16 };
+  vtkSegmentationConverter::SetModifiedExtent(labelmap.GetPointer(), previousModifiedTime, modifiedExtent);
+  int recordedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (!vtkSegmentationConverter::GetModifiedExtent(labelmap.GetPointer(), previousModifiedTime, recordedExtent)
+    || recordedExtent[0] != 34 || recordedExtent[5] != 16)
+    {
+    std::cerr << __LINE__ << ": Modified extent is not recorded" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CompareConversions(labelmap.GetPointer(), wholeRule.GetPointer(), blockwiseRule.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Blockwise conversion after recorded modification differs from whole labelmap conversion" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Modification that is not recorded: all blocks are checked
+  previousModifiedTime = labelmap->GetMTime();
+  FillSphere(labelmap.GetPointer(), center2, 5, 0);
+  labelmap->Modified();
+  if (vtkSegmentationConverter::GetModifiedExtent(labelmap.GetPointer(), previousModifiedTime, recordedExtent))
+    {
+    std::cerr << __LINE__ << ": Unrecorded modification is reported as recorded" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CompareConversions(labelmap.GetPointer(), wholeRule.GetPointer(), blockwiseRule.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Blockwise conversion after unrecorded modification differs from whole labelmap conversion" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Without cache (cache size limit exceeded) the result is the same
+  blockwiseRule->SetMaximumNumberOfCachedTriangles(0);
+  wholeRule->SetConversionParameter(decimationFactorName, "0.0");
+  blockwiseRule->SetConversionParameter(decimationFactorName, "0.0");
+  if (!CompareConversions(labelmap.GetPointer(), wholeRule.GetPointer(), blockwiseRule.GetPointer())
+    || !CompareConversions(labelmap.GetPointer(), wholeRule.GetPointer(), blockwiseRule.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Blockwise conversion without cache differs from whole labelmap conversion" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkIdTypeArray.h>
+#include <vtkImageAccumulate.h>
+#include <vtkImageData.h>
+#include <vtkImageThreshold.h>
+#include <vtkImageToImageStencil.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+// SegmentationCore includes
+#include "vtkCalculateLabelStatistics.h"
+
+namespace
+{
+
+const int NumberOfLabels = 5;
+const int NumberOfScalarValues = 100;
+
+//----------------------------------------------------------------------------
+bool AreEqual(double value1, double value2)
+{
+  return fabs(value1 - value2) <= 1e-6 * std::max(1.0, std::max(fabs(value1), fabs(value2)));
+}
+
+//----------------------------------------------------------------------------
+/// Compare statistics of one label with the result of vtkImageAccumulate masked by the label
+bool CompareWithAccumulate(vtkCalculateLabelStatistics* statistics, vtkImageData* labelImage, vtkImageData* scalarImage, int label)
+{
+  vtkNew<vtkImageThreshold> threshold;
+  threshold->SetInputData(labelImage);
+  threshold->ThresholdBetween(label, label);
+  threshold->SetInValue(1);
+  threshold->SetOutValue(0);
+  threshold->SetOutputScalarTypeToUnsignedChar();
+
+  vtkNew<vtkImageToImageStencil> stencil;
+  stencil->SetInputConnection(threshold->GetOutputPort());
+  stencil->ThresholdBetween(1, 1);
+
+  vtkNew<vtkImageAccumulate> accumulate;
+  accumulate->SetInputData(scalarImage);
+  accumulate->SetStencilConnection(stencil->GetOutputPort());
+  accumulate->SetComponentExtent(0, NumberOfScalarValues - 1, 0, 0, 0, 0);
+  accumulate->SetComponentOrigin(0, 0, 0);
+  accumulate->SetComponentSpacing(1, 1, 1);
+  accumulate->Update();
+
+  if (statistics->GetVoxelCount(label) != accumulate->GetVoxelCount())
+    {
+    std::cerr << "Label " << label << ": voxel count " << statistics->GetVoxelCount(label)
+      << " != " << accumulate->GetVoxelCount() << std::endl;
+    return false;
+    }
+  if (!AreEqual(statistics->GetMinimum(label), accumulate->GetMin()[0])
+    || !AreEqual(statistics->GetMaximum(label), accumulate->GetMax()[0])
+    || !AreEqual(statistics->GetMean(label), accumulate->GetMean()[0])
+    || !AreEqual(statistics->GetStandardDeviation(label), accumulate->GetStandardDeviation()[0]))
+    {
+    std::cerr << "Label " << label << ": intensity statistics mismatch"
+      << " min " << statistics->GetMinimum(label) << " / " << accumulate->GetMin()[0]
+      << " max " << statistics->GetMaximum(label) << " / " << accumulate->GetMax()[0]
+      << " mean " << statistics->GetMean(label) << " / " << accumulate->GetMean()[0]
+      << " stdev " << statistics->GetStandardDeviation(label) << " / " << accumulate->GetStandardDeviation()[0] << std::endl;
+    return false;
+    }
+
+  vtkNew<vtkIdTypeArray> histogram;
+  statistics->GetHistogram(label, histogram.GetPointer());
+  if (histogram->GetNumberOfValues() != NumberOfScalarValues)
+    {
+    std::cerr << "Label " << label << ": invalid number of histogram bins " << histogram->GetNumberOfValues() << std::endl;
+    return false;
+    }
+  for (int bin = 0; bin < NumberOfScalarValues; ++bin)
+    {
+    vtkIdType expectedCount = static_cast<vtkIdType>(accumulate->GetOutput()->GetScalarComponentAsDouble(bin, 0, 0, 0));
+    if (histogram->GetValue(bin) != expectedCount)
+      {
+      std::cerr << "Label " << label << ": histogram bin " << bin << " count " << histogram->GetValue(bin)
+        << " != " << expectedCount << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkCalculateLabelStatisticsTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  // Random labels and intensities
+  vtkNew<vtkImageData> labelImage;
+  labelImage->SetExtent(0, 39, 0, 29, 0, 19);
+  labelImage->AllocateScalars(VTK_SHORT, 1);
+  vtkNew<vtkImageData> scalarImage;
+  scalarImage->SetExtent(0, 39, 0, 29, 0, 19);
+  scalarImage->AllocateScalars(VTK_SHORT, 1);
+  vtkMath::RandomSeed(5678);
+  short* labelPtr = static_cast<short*>(labelImage->GetScalarPointer());
+  short* scalarPtr = static_cast<short*>(scalarImage->GetScalarPointer());
+  for (vtkIdType index = 0; index < labelImage->GetNumberOfPoints(); ++index)
+    {
+    labelPtr[index] = static_cast<short>(vtkMath::Floor(vtkMath::Random(0.0, NumberOfLabels)));
+    scalarPtr[index] = static_cast<short>(vtkMath::Floor(vtkMath::Random(0.0, NumberOfScalarValues)));
+    }
+
+  // Multi-threaded statistics of all labels in one pass
+  vtkNew<vtkCalculateLabelStatistics> statistics;
+  statistics->SetLabelImageData(labelImage.GetPointer());
+  statistics->SetScalarImageData(scalarImage.GetPointer());
+  statistics->SetNumberOfHistogramBins(NumberOfScalarValues);
+  statistics->SetHistogramRange(0.0, NumberOfScalarValues);
+  statistics->SetNumberOfThreads(4);
+  if (!statistics->Calculate())
+    {
+    std::cerr << __LINE__ << ": Failed to calculate statistics" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (statistics->GetNumberOfLabels() != NumberOfLabels)
+    {
+    std::cerr << __LINE__ << ": Invalid number of labels: " << statistics->GetNumberOfLabels() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int n = 0; n < NumberOfLabels; ++n)
+    {
+    if (statistics->GetNthLabel(n) != n)
+      {
+      std::cerr << __LINE__ << ": Labels are not sorted" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (!CompareWithAccumulate(statistics.GetPointer(), labelImage.GetPointer(), scalarImage.GetPointer(), n))
+      {
+      std::cerr << __LINE__ << ": Statistics differ from vtkImageAccumulate" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Single-threaded computation gives the same result
+  vtkNew<vtkCalculateLabelStatistics> singleThreadStatistics;
+  singleThreadStatistics->SetLabelImageData(labelImage.GetPointer());
+  singleThreadStatistics->SetScalarImageData(scalarImage.GetPointer());
+  singleThreadStatistics->SetNumberOfHistogramBins(NumberOfScalarValues);
+  singleThreadStatistics->SetHistogramRange(0.0, NumberOfScalarValues);
+  singleThreadStatistics->SetNumberOfThreads(1);
+  singleThreadStatistics->Calculate();
+  for (int label = 0; label < NumberOfLabels; ++label)
+    {
+    if (singleThreadStatistics->GetVoxelCount(label) != statistics->GetVoxelCount(label)
+      || !AreEqual(singleThreadStatistics->GetMean(label), statistics->GetMean(label))
+      || !AreEqual(singleThreadStatistics->GetStandardDeviation(label), statistics->GetStandardDeviation(label)))
+      {
+      std::cerr << __LINE__ << ": Single-threaded statistics differ for label " << label << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Merged non-zero labels: voxel count is the same as vtkImageAccumulate of the label image
+  vtkNew<vtkImageAccumulate> labelAccumulate;
+  labelAccumulate->SetInputData(labelImage.GetPointer());
+  labelAccumulate->IgnoreZeroOn();
+  labelAccumulate->Update();
+  vtkNew<vtkCalculateLabelStatistics> mergedStatistics;
+  mergedStatistics->SetLabelImageData(labelImage.GetPointer());
+  mergedStatistics->MergeNonZeroLabelsOn();
+  mergedStatistics->SetVoxelVolume(0.5);
+  mergedStatistics->Calculate();
+  if (mergedStatistics->GetVoxelCount(1) != labelAccumulate->GetVoxelCount()
+    || !AreEqual(mergedStatistics->GetVolume(1), 0.5 * labelAccumulate->GetVoxelCount()))
+    {
+    std::cerr << __LINE__ << ": Merged label voxel count " << mergedStatistics->GetVoxelCount(1)
+      << " != " << labelAccumulate->GetVoxelCount() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <sstream>
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationHistory.h"
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* GetLabelmap(vtkSegmentation* segmentation, const std::string& segmentId)
+{
+  vtkSegment* segment = segmentation->GetSegment(segmentId);
+  if (!segment)
+    {
+    return NULL;
+    }
+  return vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+}
+
+//----------------------------------------------------------------------------
+void Paint(vtkOrientedImageData* labelmap, int corner[3], int size, unsigned char value)
+{
+  for (int z = corner[2]; z < corner[2] + size; ++z)
+    {
+    for (int y = corner[1]; y < corner[1] + size; ++y)
+      {
+      for (int x = corner[0]; x < corner[0] + size; ++x)
+        {
+        *static_cast<unsigned char*>(labelmap->GetScalarPointer(x, y, z)) = value;
+        }
+      }
+    }
+  labelmap->Modified();
+}
+
+//----------------------------------------------------------------------------
+int GetVoxel(vtkSegmentation* segmentation, const std::string& segmentId, int x, int y, int z)
+{
+  vtkOrientedImageData* labelmap = GetLabelmap(segmentation, segmentId);
+  if (!labelmap || !labelmap->GetPointData()->GetScalars())
+    {
+    return -1;
+    }
+  return *static_cast<unsigned char*>(labelmap->GetScalarPointer(x, y, z));
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentationHistoryTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkSegmentation> segmentation;
+  segmentation->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+
+  std::vector<std::string> segmentIds;
+  for (int segmentIndex = 0; segmentIndex < 3; ++segmentIndex)
+    {
+    vtkNew<vtkOrientedImageData> labelmap;
+    labelmap->SetExtent(0, 63, 0, 63, 0, 63);
+    labelmap->SetSpacing(0.5, 0.5, 1.0);
+    labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    labelmap->GetPointData()->GetScalars()->FillComponent(0, 0);
+    int corner[3] = { 10 * segmentIndex, 10, 10 };
+    Paint(labelmap.GetPointer(), corner, 20, 1);
+    vtkNew<vtkSegment> segment;
+    segment->AddRepresentation(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap.GetPointer());
+    std::stringstream segmentId;
+    segmentId << "Segment_" << segmentIndex;
+    segmentIds.push_back(segmentId.str());
+    segmentation->AddSegment(segment.GetPointer(), segmentId.str());
+    }
+
+  vtkNew<vtkSegmentationHistory> history;
+  history->SetSegmentation(segmentation.GetPointer());
+  history->SetMaximumNumberOfStates(10);
+
+  // State 0: initial segments
+  if (!history->SaveState())
+    {
+    std::cerr << __LINE__ << ": Failed to save state" << std::endl;
+    return EXIT_FAILURE;
+    }
+  unsigned long initialMemorySize = history->GetMemorySize();
+
+  // State 1: paint stroke in the first segment
+  int strokeA[3] = { 40, 40, 40 };
+  Paint(GetLabelmap(segmentation.GetPointer(), segmentIds[0]), strokeA, 4, 1);
+  history->SaveState();
+
+  // Only the modified extent of the painted segment is stored, the other segments are shared
+  unsigned long strokeMemorySize = history->GetMemorySize() - initialMemorySize;
+  if (strokeMemorySize > initialMemorySize / 3)
+    {
+    std::cerr << __LINE__ << ": Stored state is too large: " << strokeMemorySize
+      << " kB, initial state: " << initialMemorySize << " kB" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Current state: another paint stroke, erase in the second segment
+  int strokeB[3] = { 50, 50, 50 };
+  Paint(GetLabelmap(segmentation.GetPointer(), segmentIds[0]), strokeB, 3, 1);
+  int eraseC[3] = { 15, 15, 15 };
+  Paint(GetLabelmap(segmentation.GetPointer(), segmentIds[1]), eraseC, 5, 0);
+
+  // Undo: state 1
+  if (!history->RestorePreviousState())
+    {
+    std::cerr << __LINE__ << ": RestorePreviousState failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (GetVoxel(segmentation.GetPointer(), segmentIds[0], 41, 41, 41) != 1
+    || GetVoxel(segmentation.GetPointer(), segmentIds[0], 51, 51, 51) != 0
+    || GetVoxel(segmentation.GetPointer(), segmentIds[1], 16, 16, 16) != 1)
+    {
+    std::cerr << __LINE__ << ": Restored state 1 is incorrect" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Undo: state 0
+  history->RestorePreviousState();
+  if (GetVoxel(segmentation.GetPointer(), segmentIds[0], 41, 41, 41) != 0
+    || GetVoxel(segmentation.GetPointer(), segmentIds[0], 11, 11, 11) != 1
+    || GetVoxel(segmentation.GetPointer(), segmentIds[2], 25, 25, 25) != 1)
+    {
+    std::cerr << __LINE__ << ": Restored state 0 is incorrect" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (history->IsRestorePreviousStateAvailable())
+    {
+    std::cerr << __LINE__ << ": No previous state is expected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Redo twice: state before the first undo
+  history->RestoreNextState();
+  history->RestoreNextState();
+  if (GetVoxel(segmentation.GetPointer(), segmentIds[0], 41, 41, 41) != 1
+    || GetVoxel(segmentation.GetPointer(), segmentIds[0], 51, 51, 51) != 1
+    || GetVoxel(segmentation.GetPointer(), segmentIds[1], 16, 16, 16) != 0
+    || GetVoxel(segmentation.GetPointer(), segmentIds[1], 12, 12, 12) != 1)
+    {
+    std::cerr << __LINE__ << ": Restored last state is incorrect" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (history->IsRestoreNextStateAvailable())
+    {
+    std::cerr << __LINE__ << ": No next state is expected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Memory limit removes the oldest states but keeps the last one
+  for (int strokeIndex = 0; strokeIndex < 5; ++strokeIndex)
+    {
+    int stroke[3] = { 2 * strokeIndex, 50, 2 };
+    Paint(GetLabelmap(segmentation.GetPointer(), segmentIds[2]), stroke, 2, 1);
+    history->SaveState();
+    }
+  unsigned long memorySizeBeforeLimit = history->GetMemorySize();
+  history->SetMaximumMemorySize(1);
+  if (history->GetMemorySize() >= memorySizeBeforeLimit)
+    {
+    std::cerr << __LINE__ << ": Oldest states are expected to be removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  history->SetMaximumMemorySize(0);
+
+  // Saving after removal of old states, then undo
+  int strokeD[3] = { 30, 30, 30 };
+  Paint(GetLabelmap(segmentation.GetPointer(), segmentIds[2]), strokeD, 2, 1);
+  history->SaveState();
+  int strokeE[3] = { 60, 60, 60 };
+  Paint(GetLabelmap(segmentation.GetPointer(), segmentIds[2]), strokeE, 2, 1);
+  history->RestorePreviousState();
+  if (GetVoxel(segmentation.GetPointer(), segmentIds[2], 61, 61, 61) != 0
+    || GetVoxel(segmentation.GetPointer(), segmentIds[2], 31, 31, 31) != 1
+    || GetVoxel(segmentation.GetPointer(), segmentIds[2], 8, 51, 3) != 1
+    || GetVoxel(segmentation.GetPointer(), segmentIds[0], 51, 51, 51) != 1)
+    {
+    std::cerr << __LINE__ << ": Restored state after memory limit is incorrect" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
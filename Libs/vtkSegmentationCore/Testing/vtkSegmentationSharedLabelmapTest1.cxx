@@ -0,0 +1,313 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <sstream>
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationHistory.h"
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* GetLabelmap(vtkSegment* segment)
+{
+  return vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+}
+
+//----------------------------------------------------------------------------
+/// Create a labelmap of the common geometry, with a box of ones from corner to corner + size - 1
+vtkSmartPointer<vtkOrientedImageData> CreateLabelmap(int corner[3], int size[3])
+{
+  vtkSmartPointer<vtkOrientedImageData> labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  labelmap->SetExtent(0, 29, 0, 29, 0, 29);
+  labelmap->SetSpacing(0.5, 0.5, 1.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  labelmap->GetPointData()->GetScalars()->FillComponent(0, 0);
+  for (int z = corner[2]; z < corner[2] + size[2]; ++z)
+    {
+    for (int y = corner[1]; y < corner[1] + size[1]; ++y)
+      {
+      for (int x = corner[0]; x < corner[0] + size[0]; ++x)
+        {
+        *static_cast<unsigned char*>(labelmap->GetScalarPointer(x, y, z)) = 1;
+        }
+      }
+    }
+  return labelmap;
+}
+
+//----------------------------------------------------------------------------
+/// Voxel of the extracted binary labelmap representation, 0 outside its extent
+int GetVoxel(vtkSegment* segment, int x, int y, int z)
+{
+  vtkNew<vtkOrientedImageData> labelmap;
+  if (!segment->ExtractBinaryLabelmapRepresentation(labelmap.GetPointer()))
+    {
+    return -1;
+    }
+  int* extent = labelmap->GetExtent();
+  if (x < extent[0] || x > extent[1] || y < extent[2] || y > extent[3] || z < extent[4] || z > extent[5]
+    || !labelmap->GetPointData()->GetScalars())
+    {
+    return 0;
+    }
+  return static_cast<int>(labelmap->GetScalarComponentAsDouble(x, y, z, 0));
+}
+
+//----------------------------------------------------------------------------
+int CountLabel(vtkOrientedImageData* sharedLabelmap, int labelValue)
+{
+  vtkDataArray* scalars = sharedLabelmap->GetPointData()->GetScalars();
+  int count = 0;
+  for (vtkIdType index = 0; index < scalars->GetNumberOfTuples(); ++index)
+    {
+    if (static_cast<int>(scalars->GetTuple1(index)) == labelValue)
+      {
+      ++count;
+      }
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------------
+int MasterRepresentationModifiedCount = 0;
+void CountMasterRepresentationModified(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+  void* vtkNotUsed(clientData), void* vtkNotUsed(callData))
+{
+  ++MasterRepresentationModifiedCount;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentationSharedLabelmapTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkSegmentation> segmentation;
+  segmentation->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+
+  // Segment_0, Segment_1, Segment_2 are side by side, Segment_3 overlaps Segment_0 and Segment_1
+  int corners[4][3] = { { 0, 0, 0 }, { 10, 0, 0 }, { 20, 0, 0 }, { 5, 0, 0 } };
+  int size[3] = { 10, 10, 10 };
+  std::vector<std::string> segmentIds;
+  for (int segmentIndex = 0; segmentIndex < 4; ++segmentIndex)
+    {
+    vtkSmartPointer<vtkOrientedImageData> labelmap = CreateLabelmap(corners[segmentIndex], size);
+    vtkNew<vtkSegment> segment;
+    segment->AddRepresentation(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap);
+    std::stringstream segmentId;
+    segmentId << "Segment_" << segmentIndex;
+    segmentIds.push_back(segmentId.str());
+    segmentation->AddSegment(segment.GetPointer(), segmentId.str());
+    }
+  vtkSegment* segment0 = segmentation->GetSegment(segmentIds[0]);
+  vtkSegment* segment1 = segmentation->GetSegment(segmentIds[1]);
+  vtkSegment* segment2 = segmentation->GetSegment(segmentIds[2]);
+  vtkSegment* segment3 = segmentation->GetSegment(segmentIds[3]);
+
+  vtkNew<vtkCallbackCommand> masterRepresentationModifiedCallback;
+  masterRepresentationModifiedCallback->SetCallback(CountMasterRepresentationModified);
+  segmentation->AddObserver(vtkSegmentation::MasterRepresentationModified, masterRepresentationModifiedCallback.GetPointer());
+
+  //
+  // Collapse
+  //
+  if (segmentation->CollapseBinaryLabelmaps() != 2)
+    {
+    std::cerr << __LINE__ << ": Two shared labelmaps are expected" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkOrientedImageData* sharedLabelmap = segment0->GetSharedLabelmap();
+  if (!sharedLabelmap || segment1->GetSharedLabelmap() != sharedLabelmap || segment2->GetSharedLabelmap() != sharedLabelmap
+    || !segment3->GetSharedLabelmap() || segment3->GetSharedLabelmap() == sharedLabelmap)
+    {
+    std::cerr << __LINE__ << ": Overlapping segment is expected in a separate shared labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (segment0->GetSharedLabelValue() == segment1->GetSharedLabelValue()
+    || segment0->GetSharedLabelValue() == segment2->GetSharedLabelValue()
+    || segment1->GetSharedLabelValue() == segment2->GetSharedLabelValue()
+    || CountLabel(sharedLabelmap, segment1->GetSharedLabelValue()) != 1000)
+    {
+    std::cerr << __LINE__ << ": Segments are expected to have distinct labels in the shared labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // The shared labelmaps replace the binary labelmap representations
+  if (GetLabelmap(segment0) != sharedLabelmap || GetLabelmap(segment1) != sharedLabelmap
+    || GetLabelmap(segment3) != segment3->GetSharedLabelmap())
+    {
+    std::cerr << __LINE__ << ": Binary labelmap representation is expected to be the shared labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Extraction does not modify the segment or the shared labelmap
+  vtkMTimeType sharedLabelmapMTime = sharedLabelmap->GetMTime();
+  vtkMTimeType segment1MTime = segment1->GetMTime();
+  if (GetVoxel(segment1, 12, 5, 5) != 1 || GetVoxel(segment1, 5, 5, 5) != 0
+    || GetVoxel(segment3, 7, 5, 5) != 1 || GetVoxel(segment0, 7, 5, 5) != 1
+    || sharedLabelmap->GetMTime() != sharedLabelmapMTime || segment1->GetMTime() != segment1MTime
+    || GetLabelmap(segment1) != sharedLabelmap || MasterRepresentationModifiedCount != 0)
+    {
+    std::cerr << __LINE__ << ": Extracted binary labelmap is incorrect" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Modify: Segment_0 overwrites part of Segment_1 by a single write into the shared labelmap
+  //
+  int strokeCorner[3] = { 15, 0, 0 };
+  int strokeSize[3] = { 5, 10, 10 };
+  vtkSmartPointer<vtkOrientedImageData> stroke = CreateLabelmap(strokeCorner, strokeSize);
+  std::vector<std::string> modifiedSegmentIds;
+  if (!segmentation->SetBinaryLabelmapToSharedSegment(segmentIds[0], stroke, false, NULL, modifiedSegmentIds))
+    {
+    std::cerr << __LINE__ << ": SetBinaryLabelmapToSharedSegment failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (modifiedSegmentIds.size() != 2 || modifiedSegmentIds[0] != segmentIds[0] || modifiedSegmentIds[1] != segmentIds[1])
+    {
+    std::cerr << __LINE__ << ": Segment_0 and Segment_1 are expected to be modified" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (GetVoxel(segment0, 17, 5, 5) != 1 || GetVoxel(segment0, 5, 5, 5) != 1
+    || GetVoxel(segment1, 17, 5, 5) != 0 || GetVoxel(segment1, 12, 5, 5) != 1
+    || GetVoxel(segment2, 25, 5, 5) != 1 || segment1->GetSharedLabelmap() != sharedLabelmap)
+    {
+    std::cerr << __LINE__ << ": Modified shared labelmap is incorrect" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Copy: sharing is kept, the copy is independent of the source
+  //
+  vtkNew<vtkSegmentation> segmentationCopy;
+  segmentationCopy->DeepCopy(segmentation.GetPointer());
+  std::vector<std::string> copySegmentIds;
+  segmentationCopy->GetSegmentIDs(copySegmentIds);
+  if (copySegmentIds.size() != 4)
+    {
+    std::cerr << __LINE__ << ": Copy is expected to have 4 segments" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkSegment* copySegment0 = segmentationCopy->GetSegment(copySegmentIds[0]);
+  vtkSegment* copySegment1 = segmentationCopy->GetSegment(copySegmentIds[1]);
+  vtkOrientedImageData* copySharedLabelmap = copySegment0->GetSharedLabelmap();
+  if (!copySharedLabelmap || copySharedLabelmap == sharedLabelmap || copySegment1->GetSharedLabelmap() != copySharedLabelmap
+    || copySegment1->GetSharedLabelValue() != segment1->GetSharedLabelValue()
+    || !segmentationCopy->GetSegment(copySegmentIds[3])->GetSharedLabelmap())
+    {
+    std::cerr << __LINE__ << ": Copied segments are expected to share a copy of the shared labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int copyStrokeCorner[3] = { 0, 0, 0 };
+  int copyStrokeSize[3] = { 5, 10, 10 };
+  vtkSmartPointer<vtkOrientedImageData> copyStroke = CreateLabelmap(copyStrokeCorner, copyStrokeSize);
+  segmentationCopy->SetBinaryLabelmapToSharedSegment(copySegmentIds[1], copyStroke, false, NULL, modifiedSegmentIds);
+  if (GetVoxel(copySegment1, 2, 5, 5) != 1 || GetVoxel(copySegment0, 2, 5, 5) != 0
+    || GetVoxel(segment1, 2, 5, 5) != 0 || GetVoxel(segment0, 2, 5, 5) != 1)
+    {
+    std::cerr << __LINE__ << ": Modifying the copy is expected not to change the source" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Undo: sharing is kept when a state is restored
+  //
+  vtkNew<vtkSegmentationHistory> history;
+  history->SetSegmentation(segmentation.GetPointer());
+  history->SaveState();
+  segmentation->SetBinaryLabelmapToSharedSegment(segmentIds[1], copyStroke, false, NULL, modifiedSegmentIds);
+  if (GetVoxel(segment1, 2, 5, 5) != 1)
+    {
+    std::cerr << __LINE__ << ": Modification before undo failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!history->RestorePreviousState())
+    {
+    std::cerr << __LINE__ << ": RestorePreviousState failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  sharedLabelmap = segment0->GetSharedLabelmap();
+  if (!sharedLabelmap || segment1->GetSharedLabelmap() != sharedLabelmap || segment2->GetSharedLabelmap() != sharedLabelmap
+    || GetVoxel(segment1, 2, 5, 5) != 0 || GetVoxel(segment0, 2, 5, 5) != 1 || GetVoxel(segment1, 12, 5, 5) != 1)
+    {
+    std::cerr << __LINE__ << ": Restored state is expected to use a shared labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+  history->SetSegmentation(NULL);
+
+  //
+  // Remove: voxels of the removed segment are cleared in the shared labelmap
+  //
+  vtkSmartPointer<vtkSegment> removedSegment = segment1;
+  int removedLabelValue = segment1->GetSharedLabelValue();
+  segmentation->RemoveSegment(segmentIds[1]);
+  if (CountLabel(sharedLabelmap, removedLabelValue) != 0)
+    {
+    std::cerr << __LINE__ << ": Voxels of the removed segment are expected to be cleared" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (removedSegment->GetSharedLabelmap() || GetVoxel(removedSegment, 12, 5, 5) != 1
+    || GetVoxel(segment0, 17, 5, 5) != 1 || GetVoxel(segment2, 25, 5, 5) != 1)
+    {
+    std::cerr << __LINE__ << ": Removed segment is expected to keep its own labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Set a separate binary labelmap: the segment stops sharing
+  //
+  int segment2LabelValue = segment2->GetSharedLabelValue();
+  vtkSmartPointer<vtkOrientedImageData> segment2Labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  segment2->ExtractBinaryLabelmapRepresentation(segment2Labelmap);
+  *static_cast<unsigned char*>(segment2Labelmap->GetScalarPointer(25, 5, 5)) = 0;
+  segment2->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), segment2Labelmap);
+  if (segment2->GetSharedLabelmap() || GetLabelmap(segment2) != segment2Labelmap
+    || CountLabel(sharedLabelmap, segment2LabelValue) != 0
+    || GetVoxel(segment2, 25, 5, 5) != 0 || GetVoxel(segment2, 22, 5, 5) != 1
+    || GetVoxel(segment0, 5, 5, 5) != 1)
+    {
+    std::cerr << __LINE__ << ": Segment with a separate labelmap is expected to stop sharing" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Expand: each segment stores its labelmap separately
+  //
+  segmentation->ExpandBinaryLabelmaps();
+  if (segment0->GetSharedLabelmap() || segment3->GetSharedLabelmap()
+    || GetVoxel(segment0, 17, 5, 5) != 1 || GetVoxel(segment3, 7, 5, 5) != 1)
+    {
+    std::cerr << __LINE__ << ": Expanded segments are incorrect" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
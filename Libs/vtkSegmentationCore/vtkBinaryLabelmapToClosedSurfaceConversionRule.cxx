@@ -22,8 +22,10 @@
 #include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
 
 #include "vtkOrientedImageData.h"
+#include "vtkSegmentationConverter.h"
 
 // VTK includes
+#include <vtkCellArray.h>
 #include <vtkDecimatePro.h>
 #include <vtkDiscreteMarchingCubes.h>
 #include <vtkImageChangeInformation.h>
@@ -31,16 +33,217 @@
 #include <vtkImageThreshold.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkVersion.h>
+#include <vtkWeakPointer.h>
 #include <vtkWindowedSincPolyDataFilter.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
 //----------------------------------------------------------------------------
 vtkSegmentationConverterRuleNewMacro(vtkBinaryLabelmapToClosedSurfaceConversionRule);
 
+namespace
+{
+/// Number of marching cubes cells along each axis of a block
+const int BLOCK_SIZE = 32;
+/// Offset that makes index components non-negative in keys
+const vtkTypeInt64 KEY_OFFSET = 1 << 20;
+/// Mask of one index component in keys
+const vtkTypeInt64 KEY_MASK = (1 << 21) - 1;
+
+//----------------------------------------------------------------------------
+int FloorDivide(int a, int b)
+{
+  return (a >= 0 ? a / b : -((-a + b - 1) / b));
+}
+
+//----------------------------------------------------------------------------
+/// Keys are ordered the same way as marching cubes visits the cells (k, then j, then i)
+vtkTypeInt64 GetIndexKey(const int index[3])
+{
+  return ((index[2] + KEY_OFFSET) << 42) | ((index[1] + KEY_OFFSET) << 21) | (index[0] + KEY_OFFSET);
+}
+
+//----------------------------------------------------------------------------
+/// Marching cubes points are at voxel corners or edge midpoints, so doubled coordinates identify them
+vtkTypeInt64 GetPointKey(const double point[3])
+{
+  int doubledCoordinates[3] = { 0, 0, 0 };
+  for (int i = 0; i < 3; i++)
+    {
+    doubledCoordinates[i] = static_cast<int>(floor(point[i] * 2.0 + 0.5));
+    }
+  return GetIndexKey(doubledCoordinates);
+}
+
+//----------------------------------------------------------------------------
+void GetDoubledCoordinatesFromPointKey(vtkTypeInt64 key, int doubledCoordinates[3])
+{
+  for (int i = 0; i < 3; i++)
+    {
+    doubledCoordinates[i] = static_cast<int>((key & KEY_MASK) - KEY_OFFSET);
+    key >>= 21;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool DoExtentsIntersect(const int extent1[6], const int extent2[6])
+{
+  for (int axis = 0; axis < 3; axis++)
+    {
+    if (std::max(extent1[axis * 2], extent2[axis * 2]) > std::min(extent1[axis * 2 + 1], extent2[axis * 2 + 1]))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Compute a hash of the non-zero voxels of binaryLabelMap within extent and
+/// determine if there are any non-zero voxels.
+template<class ImageScalarType>
+void HashVoxelsGeneric(vtkImageData* binaryLabelMap, const int extent[6], vtkTypeUInt64& hash, bool& nonEmpty)
+{
+  const vtkTypeUInt64 prime = 1099511628211ULL;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      ImageScalarType* voxel = static_cast<ImageScalarType*>(binaryLabelMap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, voxel++)
+        {
+        if (*voxel == 0)
+          {
+          continue;
+          }
+        hash = (hash ^ static_cast<vtkTypeUInt64>(i)) * prime;
+        hash = (hash ^ static_cast<vtkTypeUInt64>(j)) * prime;
+        hash = (hash ^ static_cast<vtkTypeUInt64>(k)) * prime;
+        hash = (hash ^ static_cast<vtkTypeUInt64>(*voxel)) * prime;
+        nonEmpty = true;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> RunMarchingCubes(vtkImageData* binaryLabelMap, int labelmapFillValue)
+{
+  vtkSmartPointer<vtkDiscreteMarchingCubes> marchingCubes = vtkSmartPointer<vtkDiscreteMarchingCubes>::New();
+  marchingCubes->SetInputData(binaryLabelMap);
+  marchingCubes->GenerateValues(1, labelmapFillValue, labelmapFillValue);
+  marchingCubes->ComputeGradientsOff();
+  marchingCubes->ComputeNormalsOff();
+  marchingCubes->ComputeScalarsOff();
+  marchingCubes->Update();
+  return marchingCubes->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+/// Reference to a triangle of a block surface patch, used for restoring marching cubes triangle order
+struct PatchTriangle
+{
+  vtkTypeInt64 CellKey;
+  const vtkTypeInt64* PointKeys;
+};
+
+//----------------------------------------------------------------------------
+bool ComparePatchTriangleCells(const PatchTriangle& triangle1, const PatchTriangle& triangle2)
+{
+  return triangle1.CellKey < triangle2.CellKey;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkBinaryLabelmapToClosedSurfaceConversionRule::SurfacePatchCache
+{
+public:
+  /// Marching cubes triangles of the cells of a labelmap block
+  struct BlockPatch
+    {
+    vtkTypeUInt64 Hash;
+    /// Key of the marching cubes cell of each triangle
+    std::vector<vtkTypeInt64> CellKeys;
+    /// Keys of the three points of each triangle
+    std::vector<vtkTypeInt64> PointKeys;
+    };
+  struct LabelmapPatches
+    {
+    LabelmapPatches() : FillValue(0), ConvertedTime(0), LastUsed(0), NumberOfTriangles(0) { }
+    vtkWeakPointer<vtkOrientedImageData> Labelmap;
+    int FillValue;
+    /// Modified time of the labelmap when it was last converted
+    vtkMTimeType ConvertedTime;
+    unsigned long LastUsed;
+    vtkIdType NumberOfTriangles;
+    std::map<vtkTypeInt64, BlockPatch> Blocks;
+    };
+
+  SurfacePatchCache() : UseCounter(0) { }
+
+  std::map<vtkOrientedImageData*, LabelmapPatches> Labelmaps;
+  unsigned long UseCounter;
+
+  /// Remove patches of labelmaps that have been deleted
+  void RemoveDeletedLabelmaps()
+    {
+    std::map<vtkOrientedImageData*, LabelmapPatches>::iterator labelmapIt = this->Labelmaps.begin();
+    while (labelmapIt != this->Labelmaps.end())
+      {
+      if (labelmapIt->second.Labelmap.GetPointer() == NULL)
+        {
+        this->Labelmaps.erase(labelmapIt++);
+        }
+      else
+        {
+        ++labelmapIt;
+        }
+      }
+    }
+
+  /// Remove patches of the least recently converted labelmaps until the total number of triangles is
+  /// below maximumNumberOfTriangles. Patches of the most recently converted labelmap are always kept.
+  void Shrink(vtkIdType maximumNumberOfTriangles)
+    {
+    vtkIdType numberOfTriangles = 0;
+    std::map<vtkOrientedImageData*, LabelmapPatches>::iterator labelmapIt;
+    for (labelmapIt = this->Labelmaps.begin(); labelmapIt != this->Labelmaps.end(); ++labelmapIt)
+      {
+      numberOfTriangles += labelmapIt->second.NumberOfTriangles;
+      }
+    while (numberOfTriangles > maximumNumberOfTriangles && this->Labelmaps.size() > 1)
+      {
+      std::map<vtkOrientedImageData*, LabelmapPatches>::iterator leastRecentlyUsedIt = this->Labelmaps.begin();
+      for (labelmapIt = this->Labelmaps.begin(); labelmapIt != this->Labelmaps.end(); ++labelmapIt)
+        {
+        if (labelmapIt->second.LastUsed < leastRecentlyUsedIt->second.LastUsed)
+          {
+          leastRecentlyUsedIt = labelmapIt;
+          }
+        }
+      numberOfTriangles -= leastRecentlyUsedIt->second.NumberOfTriangles;
+      this->Labelmaps.erase(leastRecentlyUsedIt);
+      }
+    if (numberOfTriangles > maximumNumberOfTriangles)
+      {
+      // A single labelmap with more triangles than the limit is not cached
+      this->Labelmaps.clear();
+      }
+    }
+};
+
 //----------------------------------------------------------------------------
 vtkBinaryLabelmapToClosedSurfaceConversionRule::vtkBinaryLabelmapToClosedSurfaceConversionRule()
 {
@@ -52,11 +255,24 @@ vtkBinaryLabelmapToClosedSurfaceConversionRule::vtkBinaryLabelmapToClosedSurface
   this->ConversionParameters[GetComputeSurfaceNormalsParameterName()] = std::make_pair("1",
     "Compute surface normals. 1 (default) = surface normals are computed. "
     "0 = surface normals are not computed (slightly faster but produces less smooth surface display).");
+  this->BlockwiseConversionMinimumNumberOfVoxels = 64 * 64 * 64;
+  this->MaximumNumberOfCachedTriangles = 10000000;
+  this->PatchCache = new SurfacePatchCache;
 }
 
 //----------------------------------------------------------------------------
 vtkBinaryLabelmapToClosedSurfaceConversionRule::~vtkBinaryLabelmapToClosedSurfaceConversionRule()
 {
+  delete this->PatchCache;
+  this->PatchCache = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkBinaryLabelmapToClosedSurfaceConversionRule::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "BlockwiseConversionMinimumNumberOfVoxels: " << this->BlockwiseConversionMinimumNumberOfVoxels << "\n";
+  os << indent << "MaximumNumberOfCachedTriangles: " << this->MaximumNumberOfCachedTriangles << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -137,42 +353,47 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkDataObject* sour
     return true;
     }
 
-  /// If input labelmap has non-background border voxels, then those regions remain open in the output closed surface.
-  /// This function adds a 1 voxel padding to the labelmap in these cases.
-  bool paddingNecessary = this->IsLabelmapPaddingNecessary(binaryLabelMap);
-  if (paddingNecessary)
-    {
-    vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
-    padder->SetInputData(binaryLabelMap);
-    int extent[6] = { 0, -1, 0, -1, 0, -1 };
-    binaryLabelMap->GetExtent(extent);
-    // Set the output extent to the new size
-    padder->SetOutputWholeExtent(extent[0] - 1, extent[1] + 1, extent[2] - 1, extent[3] + 1, extent[4] - 1, extent[5] + 1);
-    padder->Update();
-    binaryLabelMap = padder->GetOutput();
-    }
-  // Clone labelmap and set identity geometry so that the whole transform can be done in IJK space and then
-  // the whole transform can be applied on the poly data to transform it to the world coordinate system
-  vtkSmartPointer<vtkImageData> binaryLabelmapWithIdentityGeometry = vtkSmartPointer<vtkImageData>::New();
-  binaryLabelmapWithIdentityGeometry->ShallowCopy(binaryLabelMap);
-  binaryLabelmapWithIdentityGeometry->SetOrigin(0, 0, 0);
-  binaryLabelmapWithIdentityGeometry->SetSpacing(1.0, 1.0, 1.0);
-
   // Get conversion parameters
   double decimationFactor = vtkVariant(this->ConversionParameters[GetDecimationFactorParameterName()].first).ToDouble();
   double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
   int computeSurfaceNormals = vtkVariant(this->ConversionParameters[GetComputeSurfaceNormalsParameterName()].first).ToInt();
 
-  // Run marching cubes
-  vtkSmartPointer<vtkDiscreteMarchingCubes> marchingCubes = vtkSmartPointer<vtkDiscreteMarchingCubes>::New();
-  marchingCubes->SetInputData(binaryLabelmapWithIdentityGeometry);
-  const int labelmapFillValue = binaryLabelmapWithIdentityGeometry->GetScalarRange()[1]; // max value
-  marchingCubes->GenerateValues(1, labelmapFillValue, labelmapFillValue);
-  marchingCubes->ComputeGradientsOff();
-  marchingCubes->ComputeNormalsOff();
-  marchingCubes->ComputeScalarsOff();
-  marchingCubes->Update();
-  vtkSmartPointer<vtkPolyData> processingResult = marchingCubes->GetOutput();
+  const int labelmapFillValue = binaryLabelMap->GetScalarRange()[1]; // max value
+  vtkSmartPointer<vtkPolyData> processingResult;
+  if (binaryLabelMap->GetNumberOfPoints() >= this->BlockwiseConversionMinimumNumberOfVoxels)
+    {
+    // Large labelmaps are converted block by block, so that marching cubes only has to be run in the modified
+    // blocks when the labelmap is converted again after an edit. The result is the same as marching cubes
+    // output of the whole (padded) labelmap.
+    processingResult = vtkSmartPointer<vtkPolyData>::New();
+    this->ConvertBlocks(orientedBinaryLabelMap, labelmapFillValue, processingResult);
+    }
+  else
+    {
+    /// If input labelmap has non-background border voxels, then those regions remain open in the output closed surface.
+    /// This function adds a 1 voxel padding to the labelmap in these cases.
+    bool paddingNecessary = this->IsLabelmapPaddingNecessary(binaryLabelMap);
+    if (paddingNecessary)
+      {
+      vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
+      padder->SetInputData(binaryLabelMap);
+      int extent[6] = { 0, -1, 0, -1, 0, -1 };
+      binaryLabelMap->GetExtent(extent);
+      // Set the output extent to the new size
+      padder->SetOutputWholeExtent(extent[0] - 1, extent[1] + 1, extent[2] - 1, extent[3] + 1, extent[4] - 1, extent[5] + 1);
+      padder->Update();
+      binaryLabelMap = padder->GetOutput();
+      }
+    // Clone labelmap and set identity geometry so that the whole transform can be done in IJK space and then
+    // the whole transform can be applied on the poly data to transform it to the world coordinate system
+    vtkSmartPointer<vtkImageData> binaryLabelmapWithIdentityGeometry = vtkSmartPointer<vtkImageData>::New();
+    binaryLabelmapWithIdentityGeometry->ShallowCopy(binaryLabelMap);
+    binaryLabelmapWithIdentityGeometry->SetOrigin(0, 0, 0);
+    binaryLabelmapWithIdentityGeometry->SetSpacing(1.0, 1.0, 1.0);
+
+    // Run marching cubes
+    processingResult = RunMarchingCubes(binaryLabelmapWithIdentityGeometry, labelmapFillValue);
+    }
   if (processingResult->GetNumberOfPolys() == 0)
     {
     vtkDebugMacro("Convert: No polygons can be created, probably all voxels are empty");
@@ -240,6 +461,201 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkDataObject* sour
   return true;
 }
 
+//----------------------------------------------------------------------------
+void vtkBinaryLabelmapToClosedSurfaceConversionRule::ConvertBlocks(vtkOrientedImageData* binaryLabelMap,
+  int labelmapFillValue, vtkPolyData* surface)
+{
+  this->PatchCache->RemoveDeletedLabelmaps();
+  SurfacePatchCache::LabelmapPatches& patches = this->PatchCache->Labelmaps[binaryLabelMap];
+  if (patches.Labelmap.GetPointer() != binaryLabelMap || patches.FillValue != labelmapFillValue)
+    {
+    patches.Blocks.clear();
+    patches.Labelmap = binaryLabelMap;
+    patches.FillValue = labelmapFillValue;
+    patches.ConvertedTime = 0;
+    }
+  patches.LastUsed = ++this->PatchCache->UseCounter;
+
+  // If the voxels modified since the last conversion are known then only the blocks
+  // that overlap with the modified extent have to be checked
+  int modifiedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool modifiedExtentKnown = (patches.ConvertedTime > 0
+    && vtkSegmentationConverter::GetModifiedExtent(binaryLabelMap, patches.ConvertedTime, modifiedExtent));
+
+  // Block b contains marching cubes cells [b*BLOCK_SIZE, (b+1)*BLOCK_SIZE-1]. Cell i is between voxels i and i+1.
+  // Voxels outside the labelmap extent are treated as background, as in the padded labelmap that is converted
+  // by the non-blockwise method, therefore the surface is always closed.
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  binaryLabelMap->GetExtent(extent);
+  int firstBlock[3] = { 0, 0, 0 };
+  int lastBlock[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; axis++)
+    {
+    firstBlock[axis] = FloorDivide(extent[axis * 2] - 1, BLOCK_SIZE);
+    lastBlock[axis] = FloorDivide(extent[axis * 2 + 1], BLOCK_SIZE);
+    }
+
+  std::map<vtkTypeInt64, SurfacePatchCache::BlockPatch> updatedBlocks;
+  vtkIdType numberOfTriangles = 0;
+  int blockIndex[3] = { 0, 0, 0 };
+  for (blockIndex[2] = firstBlock[2]; blockIndex[2] <= lastBlock[2]; blockIndex[2]++)
+    {
+    for (blockIndex[1] = firstBlock[1]; blockIndex[1] <= lastBlock[1]; blockIndex[1]++)
+      {
+      for (blockIndex[0] = firstBlock[0]; blockIndex[0] <= lastBlock[0]; blockIndex[0]++)
+        {
+        // Cells of the block depend on the voxels in blockExtent
+        int blockExtent[6] = { 0, -1, 0, -1, 0, -1 };
+        int hashExtent[6] = { 0, -1, 0, -1, 0, -1 };
+        bool hashExtentValid = true;
+        for (int axis = 0; axis < 3; axis++)
+          {
+          blockExtent[axis * 2] = blockIndex[axis] * BLOCK_SIZE;
+          blockExtent[axis * 2 + 1] = (blockIndex[axis] + 1) * BLOCK_SIZE;
+          hashExtent[axis * 2] = std::max(blockExtent[axis * 2], extent[axis * 2]);
+          hashExtent[axis * 2 + 1] = std::min(blockExtent[axis * 2 + 1], extent[axis * 2 + 1]);
+          hashExtentValid = hashExtentValid && hashExtent[axis * 2] <= hashExtent[axis * 2 + 1];
+          }
+        vtkTypeInt64 blockKey = GetIndexKey(blockIndex);
+        std::map<vtkTypeInt64, SurfacePatchCache::BlockPatch>::iterator cachedBlockIt = patches.Blocks.find(blockKey);
+        if (cachedBlockIt != patches.Blocks.end() && modifiedExtentKnown && !DoExtentsIntersect(blockExtent, modifiedExtent))
+          {
+          // Voxels of the block have not been modified since the last conversion
+          SurfacePatchCache::BlockPatch& blockPatch = updatedBlocks[blockKey];
+          blockPatch.Hash = cachedBlockIt->second.Hash;
+          blockPatch.CellKeys.swap(cachedBlockIt->second.CellKeys);
+          blockPatch.PointKeys.swap(cachedBlockIt->second.PointKeys);
+          numberOfTriangles += static_cast<vtkIdType>(blockPatch.CellKeys.size());
+          continue;
+          }
+        vtkTypeUInt64 hash = 14695981039346656037ULL;
+        bool nonEmpty = false;
+        if (hashExtentValid)
+          {
+          switch (binaryLabelMap->GetScalarType())
+            {
+            vtkTemplateMacro(HashVoxelsGeneric<VTK_TT>(binaryLabelMap, hashExtent, hash, nonEmpty));
+            default:
+              vtkErrorMacro("ConvertBlocks: Unknown image scalar type!");
+              // Cached patches may have been moved already
+              this->PatchCache->Labelmaps.erase(binaryLabelMap);
+              return;
+            }
+          }
+        SurfacePatchCache::BlockPatch& blockPatch = updatedBlocks[blockKey];
+        blockPatch.Hash = hash;
+        if (cachedBlockIt != patches.Blocks.end() && cachedBlockIt->second.Hash == hash)
+          {
+          // Voxels have not changed since the last conversion
+          blockPatch.CellKeys.swap(cachedBlockIt->second.CellKeys);
+          blockPatch.PointKeys.swap(cachedBlockIt->second.PointKeys);
+          numberOfTriangles += static_cast<vtkIdType>(blockPatch.CellKeys.size());
+          continue;
+          }
+        if (!nonEmpty)
+          {
+          // There is no foreground voxel at any corner of the cells of this block
+          continue;
+          }
+
+        // Extract surface from the cells of the block
+        vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
+        padder->SetInputData(binaryLabelMap);
+        padder->SetOutputWholeExtent(blockExtent);
+        padder->Update();
+        vtkSmartPointer<vtkImageData> blockLabelmap = vtkSmartPointer<vtkImageData>::New();
+        blockLabelmap->ShallowCopy(padder->GetOutput());
+        blockLabelmap->SetOrigin(0, 0, 0);
+        blockLabelmap->SetSpacing(1.0, 1.0, 1.0);
+        vtkSmartPointer<vtkPolyData> marchingCubesResult = RunMarchingCubes(blockLabelmap, labelmapFillValue);
+
+        // Store the cell and point keys of the triangles. Marching cubes points lie on the edges of their cell,
+        // so the cell index along an axis is determined by a point that is halfway between two voxels.
+        vtkPoints* points = marchingCubesResult->GetPoints();
+        vtkCellArray* polys = marchingCubesResult->GetPolys();
+        blockPatch.CellKeys.reserve(polys->GetNumberOfCells());
+        blockPatch.PointKeys.reserve(polys->GetNumberOfCells() * 3);
+        vtkIdType numberOfCellPoints = 0;
+        vtkIdType* cellPointIds = NULL;
+        for (polys->InitTraversal(); polys->GetNextCell(numberOfCellPoints, cellPointIds);)
+          {
+          if (numberOfCellPoints != 3)
+            {
+            continue;
+            }
+          int cellIndex[3] = { blockExtent[0], blockExtent[2], blockExtent[4] };
+          bool cellIndexFound[3] = { false, false, false };
+          for (vtkIdType i = 0; i < 3; i++)
+            {
+            vtkTypeInt64 pointKey = GetPointKey(points->GetPoint(cellPointIds[i]));
+            blockPatch.PointKeys.push_back(pointKey);
+            int doubledCoordinates[3] = { 0, 0, 0 };
+            GetDoubledCoordinatesFromPointKey(pointKey, doubledCoordinates);
+            for (int axis = 0; axis < 3; axis++)
+              {
+              if (!cellIndexFound[axis] && (doubledCoordinates[axis] & 1))
+                {
+                cellIndex[axis] = FloorDivide(doubledCoordinates[axis], 2);
+                cellIndexFound[axis] = true;
+                }
+              }
+            }
+          blockPatch.CellKeys.push_back(GetIndexKey(cellIndex));
+          }
+        numberOfTriangles += static_cast<vtkIdType>(blockPatch.CellKeys.size());
+        }
+      }
+    }
+  patches.Blocks.swap(updatedBlocks);
+  patches.ConvertedTime = binaryLabelMap->GetMTime();
+  patches.NumberOfTriangles = numberOfTriangles;
+
+  // Stitch patches. Marching cubes of the whole labelmap visits the cells in (k, j, i) order and inserts points
+  // when they are first used by a triangle. The same order is restored here, so that decimation and smoothing
+  // give exactly the same result as for the whole labelmap.
+  std::vector<PatchTriangle> triangles;
+  triangles.reserve(numberOfTriangles);
+  for (std::map<vtkTypeInt64, SurfacePatchCache::BlockPatch>::iterator blockIt = patches.Blocks.begin();
+    blockIt != patches.Blocks.end(); ++blockIt)
+    {
+    SurfacePatchCache::BlockPatch& blockPatch = blockIt->second;
+    for (size_t triangleIndex = 0; triangleIndex < blockPatch.CellKeys.size(); triangleIndex++)
+      {
+      PatchTriangle triangle;
+      triangle.CellKey = blockPatch.CellKeys[triangleIndex];
+      triangle.PointKeys = &(blockPatch.PointKeys[triangleIndex * 3]);
+      triangles.push_back(triangle);
+      }
+    }
+  // Triangles of a cell are in one block, in marching cubes order, which the stable sort preserves
+  std::stable_sort(triangles.begin(), triangles.end(), ComparePatchTriangleCells);
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+  std::map<vtkTypeInt64, vtkIdType> pointIdsByKey;
+  for (std::vector<PatchTriangle>::iterator triangleIt = triangles.begin(); triangleIt != triangles.end(); ++triangleIt)
+    {
+    cells->InsertNextCell(3);
+    for (int i = 0; i < 3; i++)
+      {
+      std::map<vtkTypeInt64, vtkIdType>::iterator pointIt = pointIdsByKey.find(triangleIt->PointKeys[i]);
+      if (pointIt == pointIdsByKey.end())
+        {
+        int doubledCoordinates[3] = { 0, 0, 0 };
+        GetDoubledCoordinatesFromPointKey(triangleIt->PointKeys[i], doubledCoordinates);
+        vtkIdType pointId = points->InsertNextPoint(doubledCoordinates[0] * 0.5, doubledCoordinates[1] * 0.5, doubledCoordinates[2] * 0.5);
+        pointIt = pointIdsByKey.insert(std::make_pair(triangleIt->PointKeys[i], pointId)).first;
+        }
+      cells->InsertCellPoint(pointIt->second);
+      }
+    }
+  surface->Initialize();
+  surface->SetPoints(points);
+  surface->SetPolys(cells);
+
+  this->PatchCache->Shrink(this->MaximumNumberOfCachedTriangles);
+}
+
 //----------------------------------------------------------------------------
 template<class ImageScalarType>
 void IsLabelmapPaddingNecessaryGeneric(vtkImageData* binaryLabelMap, bool &paddingNecessary)
@@ -27,11 +27,21 @@
 
 #include "vtkSegmentationCoreConfigure.h"
 
+class vtkOrientedImageData;
+class vtkPolyData;
+
 /// \ingroup SegmentationCore
 /// \brief Convert binary labelmap representation (vtkOrientedImageData type) to
 ///   closed surface representation (vtkPolyData type). The conversion algorithm
 ///   performs a marching cubes operation on the image data followed by an optional
 ///   decimation step.
+/// \details Marching cubes runs block by block on large labelmaps. Surface patches of the blocks are
+///   cached for each labelmap and only the blocks whose voxels have changed since the last conversion
+///   are extracted again. If the extent of the modified voxels is recorded in the labelmap
+///   (see vtkSegmentationConverter::SetModifiedExtent) then only the blocks in that extent are checked.
+///   Patches are stitched in the order of whole-image marching cubes, then decimated and smoothed,
+///   therefore the result is identical to converting the whole labelmap at once.
+///   Only marching cubes is incremental: decimation and smoothing always process the whole surface.
 class vtkSegmentationCore_EXPORT vtkBinaryLabelmapToClosedSurfaceConversionRule
   : public vtkSegmentationConverterRule
 {
@@ -46,6 +56,7 @@ public:
 public:
   static vtkBinaryLabelmapToClosedSurfaceConversionRule* New();
   vtkTypeMacro(vtkBinaryLabelmapToClosedSurfaceConversionRule, vtkSegmentationConverterRule);
+  void PrintSelf(ostream& os, vtkIndent indent);
   virtual vtkSegmentationConverterRule* CreateRuleInstance();
 
   /// Constructs representation object from representation name for the supported representation classes
@@ -73,15 +84,35 @@ public:
   /// Human-readable name of the target representation
   virtual const char* GetTargetRepresentationName() { return vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(); };
 
+  /// Labelmaps with at least this many voxels are converted block by block. Default: 64^3.
+  vtkSetMacro(BlockwiseConversionMinimumNumberOfVoxels, vtkIdType);
+  vtkGetMacro(BlockwiseConversionMinimumNumberOfVoxels, vtkIdType);
+
+  /// Maximum total number of triangles in the cached block surface patches. Patches of the least
+  /// recently converted labelmaps are removed from the cache above this limit. Default: 10 million.
+  vtkSetMacro(MaximumNumberOfCachedTriangles, vtkIdType);
+  vtkGetMacro(MaximumNumberOfCachedTriangles, vtkIdType);
+
 protected:
   /// If input labelmap has non-background border voxels, then those regions remain open in the output closed surface.
   /// This function checks whether this is the case.
   bool IsLabelmapPaddingNecessary(vtkImageData* binaryLabelMap);
 
+  /// Create marching cubes surface in IJK coordinate system of the labelmap block by block, reusing
+  /// the cached surface patches of blocks that have not changed since the last conversion.
+  void ConvertBlocks(vtkOrientedImageData* binaryLabelMap, int labelmapFillValue, vtkPolyData* surface);
+
 protected:
   vtkBinaryLabelmapToClosedSurfaceConversionRule();
   ~vtkBinaryLabelmapToClosedSurfaceConversionRule();
   void operator=(const vtkBinaryLabelmapToClosedSurfaceConversionRule&);
+
+  vtkIdType BlockwiseConversionMinimumNumberOfVoxels;
+  vtkIdType MaximumNumberOfCachedTriangles;
+
+  /// Surface patches of labelmap blocks from previous conversions. Defined in the implementation file.
+  class SurfacePatchCache;
+  SurfacePatchCache* PatchCache;
 };
 
 #endif // __vtkBinaryLabelmapToClosedSurfaceConversionRule_h
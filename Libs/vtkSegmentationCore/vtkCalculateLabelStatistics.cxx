@@ -0,0 +1,498 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SegmentationCore includes
+#include "vtkCalculateLabelStatistics.h"
+
+// VTK includes
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace
+{
+/// Label images with a label value range at most this large are accumulated in a dense array,
+/// images with larger label range use a map
+const double MAXIMUM_DENSE_LABEL_RANGE = 65536;
+}
+
+//----------------------------------------------------------------------------
+class vtkCalculateLabelStatistics::LabelStatisticsTable
+{
+public:
+  /// Accumulated statistics of a single label
+  struct LabelStatistics
+    {
+    LabelStatistics()
+      : VoxelCount(0)
+      , Sum(0.0)
+      , SumOfSquares(0.0)
+      , Minimum(VTK_DOUBLE_MAX)
+      , Maximum(-VTK_DOUBLE_MAX)
+      {
+      }
+
+    /// Add statistics of the same label accumulated from another part of the image
+    void Merge(const LabelStatistics& other)
+      {
+      this->VoxelCount += other.VoxelCount;
+      this->Sum += other.Sum;
+      this->SumOfSquares += other.SumOfSquares;
+      this->Minimum = std::min(this->Minimum, other.Minimum);
+      this->Maximum = std::max(this->Maximum, other.Maximum);
+      if (this->Histogram.size() < other.Histogram.size())
+        {
+        this->Histogram.resize(other.Histogram.size(), 0);
+        }
+      for (size_t bin = 0; bin < other.Histogram.size(); ++bin)
+        {
+        this->Histogram[bin] += other.Histogram[bin];
+        }
+      }
+
+    vtkIdType VoxelCount;
+    double Sum;
+    double SumOfSquares;
+    double Minimum;
+    double Maximum;
+    std::vector<vtkIdType> Histogram;
+    };
+
+  /// Statistics accumulated by a single thread
+  struct ThreadStatistics
+    {
+    ThreadStatistics()
+      : UseDense(false)
+      , MinimumLabel(0)
+      , LastLabel(0)
+      , LastStatistics(NULL)
+      {
+      }
+
+    LabelStatistics& Get(int label)
+      {
+      if (this->UseDense)
+        {
+        return this->Dense[label - this->MinimumLabel];
+        }
+      // Labelmaps usually contain long runs of the same label
+      if (!this->LastStatistics || label != this->LastLabel)
+        {
+        this->LastLabel = label;
+        this->LastStatistics = &this->Sparse[label];
+        }
+      return *this->LastStatistics;
+      }
+
+    bool UseDense;
+    int MinimumLabel;
+    std::vector<LabelStatistics> Dense;
+    std::map<int, LabelStatistics> Sparse;
+    int LastLabel;
+    LabelStatistics* LastStatistics;
+    };
+
+  /// Parameters shared by all threads
+  struct ThreadParameters
+    {
+    vtkImageData* LabelImage;
+    vtkImageData* ScalarImage;
+    int Extent[6];
+    bool MergeNonZeroLabels;
+    int NumberOfHistogramBins;
+    double HistogramMinimum;
+    double HistogramBinWidth;
+    int NumberOfThreads;
+    std::vector<ThreadStatistics>* Statistics;
+    };
+
+  /// Accumulate statistics of the rows [firstRow, lastRow) of the extent
+  template <class LabelType, class ScalarType>
+  static void AccumulateGeneric(ThreadParameters* parameters, vtkIdType firstRow, vtkIdType lastRow,
+    ThreadStatistics& statistics)
+    {
+    const int* extent = parameters->Extent;
+    int numberOfRowsPerSlice = extent[3] - extent[2] + 1;
+    int numberOfScalarComponents = (parameters->ScalarImage ? parameters->ScalarImage->GetNumberOfScalarComponents() : 0);
+    bool mergeNonZeroLabels = parameters->MergeNonZeroLabels;
+    int numberOfBins = parameters->NumberOfHistogramBins;
+    for (vtkIdType row = firstRow; row < lastRow; ++row)
+      {
+      int j = extent[2] + static_cast<int>(row % numberOfRowsPerSlice);
+      int k = extent[4] + static_cast<int>(row / numberOfRowsPerSlice);
+      LabelType* labelVoxel = static_cast<LabelType*>(parameters->LabelImage->GetScalarPointer(extent[0], j, k));
+      ScalarType* scalarVoxel = NULL;
+      if (parameters->ScalarImage)
+        {
+        scalarVoxel = static_cast<ScalarType*>(parameters->ScalarImage->GetScalarPointer(extent[0], j, k));
+        }
+      for (int i = extent[0]; i <= extent[1]; ++i, ++labelVoxel)
+        {
+        int label = static_cast<int>(*labelVoxel);
+        if (mergeNonZeroLabels && label != 0)
+          {
+          label = 1;
+          }
+        LabelStatistics& labelStatistics = statistics.Get(label);
+        labelStatistics.VoxelCount++;
+        if (!scalarVoxel)
+          {
+          continue;
+          }
+        double value = static_cast<double>(*scalarVoxel);
+        scalarVoxel += numberOfScalarComponents;
+        labelStatistics.Sum += value;
+        labelStatistics.SumOfSquares += value * value;
+        if (value < labelStatistics.Minimum)
+          {
+          labelStatistics.Minimum = value;
+          }
+        if (value > labelStatistics.Maximum)
+          {
+          labelStatistics.Maximum = value;
+          }
+        if (numberOfBins > 0)
+          {
+          if (labelStatistics.Histogram.empty())
+            {
+            labelStatistics.Histogram.resize(numberOfBins, 0);
+            }
+          int bin = static_cast<int>(floor((value - parameters->HistogramMinimum) / parameters->HistogramBinWidth));
+          bin = std::max(0, std::min(numberOfBins - 1, bin));
+          labelStatistics.Histogram[bin]++;
+          }
+        }
+      }
+    }
+
+  /// Dispatch on scalar type of the scalar image
+  template <class LabelType>
+  static void AccumulateLabelType(ThreadParameters* parameters, vtkIdType firstRow, vtkIdType lastRow,
+    ThreadStatistics& statistics)
+    {
+    if (!parameters->ScalarImage)
+      {
+      AccumulateGeneric<LabelType, double>(parameters, firstRow, lastRow, statistics);
+      return;
+      }
+    switch (parameters->ScalarImage->GetScalarType())
+      {
+      vtkTemplateMacro((AccumulateGeneric<LabelType, VTK_TT>(parameters, firstRow, lastRow, statistics)));
+      default:
+        vtkGenericWarningMacro("vtkCalculateLabelStatistics: Unknown scalar type of scalar image");
+      }
+    }
+
+  static VTK_THREAD_RETURN_TYPE ThreadFunction(void* arg)
+    {
+    vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    ThreadParameters* parameters = static_cast<ThreadParameters*>(info->UserData);
+    const int* extent = parameters->Extent;
+    vtkIdType numberOfRows = static_cast<vtkIdType>(extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+    vtkIdType firstRow = numberOfRows * info->ThreadID / parameters->NumberOfThreads;
+    vtkIdType lastRow = numberOfRows * (info->ThreadID + 1) / parameters->NumberOfThreads;
+    ThreadStatistics& statistics = (*parameters->Statistics)[info->ThreadID];
+    switch (parameters->LabelImage->GetScalarType())
+      {
+      vtkTemplateMacro(AccumulateLabelType<VTK_TT>(parameters, firstRow, lastRow, statistics));
+      default:
+        vtkGenericWarningMacro("vtkCalculateLabelStatistics: Unknown scalar type of label image");
+      }
+    return VTK_THREAD_RETURN_VALUE;
+    }
+
+  void Clear()
+    {
+    this->Statistics.clear();
+    this->Labels.clear();
+    }
+
+  /// Computed statistics for each label value
+  std::map<int, LabelStatistics> Statistics;
+  /// Label values in ascending order
+  std::vector<int> Labels;
+};
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkCalculateLabelStatistics);
+
+//----------------------------------------------------------------------------
+vtkCalculateLabelStatistics::vtkCalculateLabelStatistics()
+{
+  this->LabelImageData = NULL;
+  this->ScalarImageData = NULL;
+  this->VoxelVolume = 1.0;
+  this->MergeNonZeroLabels = false;
+  this->NumberOfHistogramBins = 0;
+  this->HistogramRange[0] = 0.0;
+  this->HistogramRange[1] = -1.0;
+  this->NumberOfThreads = 0;
+  this->Statistics = new LabelStatisticsTable;
+}
+
+//----------------------------------------------------------------------------
+vtkCalculateLabelStatistics::~vtkCalculateLabelStatistics()
+{
+  this->SetLabelImageData(NULL);
+  this->SetScalarImageData(NULL);
+  delete this->Statistics;
+  this->Statistics = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkCalculateLabelStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "LabelImageData: " << this->LabelImageData << "\n";
+  os << indent << "ScalarImageData: " << this->ScalarImageData << "\n";
+  os << indent << "VoxelVolume: " << this->VoxelVolume << "\n";
+  os << indent << "MergeNonZeroLabels: " << (this->MergeNonZeroLabels ? "true" : "false") << "\n";
+  os << indent << "NumberOfHistogramBins: " << this->NumberOfHistogramBins << "\n";
+  os << indent << "HistogramRange: " << this->HistogramRange[0] << ", " << this->HistogramRange[1] << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "NumberOfLabels: " << this->Statistics->Labels.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkCalculateLabelStatistics::Calculate()
+{
+  this->Statistics->Clear();
+  if (!this->LabelImageData || !this->LabelImageData->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("Calculate: Invalid label image");
+    return false;
+    }
+  if (this->ScalarImageData && !this->ScalarImageData->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("Calculate: Invalid scalar image");
+    return false;
+    }
+
+  LabelStatisticsTable::ThreadParameters parameters;
+  parameters.LabelImage = this->LabelImageData;
+  parameters.ScalarImage = this->ScalarImageData;
+  parameters.MergeNonZeroLabels = this->MergeNonZeroLabels;
+  this->LabelImageData->GetExtent(parameters.Extent);
+  if (this->ScalarImageData)
+    {
+    int* scalarExtent = this->ScalarImageData->GetExtent();
+    for (int i = 0; i < 3; ++i)
+      {
+      parameters.Extent[i * 2] = std::max(parameters.Extent[i * 2], scalarExtent[i * 2]);
+      parameters.Extent[i * 2 + 1] = std::min(parameters.Extent[i * 2 + 1], scalarExtent[i * 2 + 1]);
+      }
+    }
+  if (parameters.Extent[0] > parameters.Extent[1] || parameters.Extent[2] > parameters.Extent[3]
+    || parameters.Extent[4] > parameters.Extent[5])
+    {
+    // Empty region, there are no labels
+    return true;
+    }
+
+  parameters.NumberOfHistogramBins = (this->ScalarImageData ? this->NumberOfHistogramBins : 0);
+  parameters.HistogramMinimum = 0.0;
+  parameters.HistogramBinWidth = 1.0;
+  if (parameters.NumberOfHistogramBins > 0)
+    {
+    double histogramRange[2] = { this->HistogramRange[0], this->HistogramRange[1] };
+    if (histogramRange[0] > histogramRange[1])
+      {
+      this->ScalarImageData->GetScalarRange(histogramRange);
+      }
+    parameters.HistogramMinimum = histogramRange[0];
+    parameters.HistogramBinWidth = (histogramRange[1] - histogramRange[0]) / parameters.NumberOfHistogramBins;
+    if (parameters.HistogramBinWidth <= 0.0)
+      {
+      parameters.HistogramBinWidth = 1.0;
+      }
+    }
+
+  // Use a dense array of accumulators if the label range is small, as it is faster than map lookups
+  double labelRange[2] = { 0.0, 1.0 };
+  if (!this->MergeNonZeroLabels)
+    {
+    this->LabelImageData->GetScalarRange(labelRange);
+    }
+  bool useDense = (labelRange[1] - labelRange[0] < MAXIMUM_DENSE_LABEL_RANGE
+    && labelRange[0] >= VTK_INT_MIN && labelRange[1] <= VTK_INT_MAX);
+
+  vtkIdType numberOfRows = static_cast<vtkIdType>(parameters.Extent[3] - parameters.Extent[2] + 1)
+    * (parameters.Extent[5] - parameters.Extent[4] + 1);
+  int numberOfThreads = (this->NumberOfThreads > 0 ? this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  numberOfThreads = static_cast<int>(std::max<vtkIdType>(1, std::min<vtkIdType>(numberOfThreads, numberOfRows)));
+  numberOfThreads = std::min(numberOfThreads, VTK_MAX_THREADS);
+  parameters.NumberOfThreads = numberOfThreads;
+
+  std::vector<LabelStatisticsTable::ThreadStatistics> threadStatistics(numberOfThreads);
+  for (std::vector<LabelStatisticsTable::ThreadStatistics>::iterator threadIt = threadStatistics.begin();
+    threadIt != threadStatistics.end(); ++threadIt)
+    {
+    threadIt->UseDense = useDense;
+    if (useDense)
+      {
+      threadIt->MinimumLabel = static_cast<int>(labelRange[0]);
+      threadIt->Dense.resize(static_cast<size_t>(labelRange[1] - labelRange[0]) + 1);
+      }
+    }
+  parameters.Statistics = &threadStatistics;
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(LabelStatisticsTable::ThreadFunction, &parameters);
+  threader->SingleMethodExecute();
+
+  // Merge the results of the threads
+  for (std::vector<LabelStatisticsTable::ThreadStatistics>::iterator threadIt = threadStatistics.begin();
+    threadIt != threadStatistics.end(); ++threadIt)
+    {
+    if (threadIt->UseDense)
+      {
+      for (size_t labelIndex = 0; labelIndex < threadIt->Dense.size(); ++labelIndex)
+        {
+        if (threadIt->Dense[labelIndex].VoxelCount > 0)
+          {
+          int label = threadIt->MinimumLabel + static_cast<int>(labelIndex);
+          this->Statistics->Statistics[label].Merge(threadIt->Dense[labelIndex]);
+          }
+        }
+      }
+    else
+      {
+      for (std::map<int, LabelStatisticsTable::LabelStatistics>::iterator labelIt = threadIt->Sparse.begin();
+        labelIt != threadIt->Sparse.end(); ++labelIt)
+        {
+        this->Statistics->Statistics[labelIt->first].Merge(labelIt->second);
+        }
+      }
+    }
+  for (std::map<int, LabelStatisticsTable::LabelStatistics>::iterator labelIt = this->Statistics->Statistics.begin();
+    labelIt != this->Statistics->Statistics.end(); ++labelIt)
+    {
+    this->Statistics->Labels.push_back(labelIt->first);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkCalculateLabelStatistics::GetNumberOfLabels()
+{
+  return static_cast<int>(this->Statistics->Labels.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkCalculateLabelStatistics::GetNthLabel(int n)
+{
+  if (n < 0 || n >= static_cast<int>(this->Statistics->Labels.size()))
+    {
+    vtkErrorMacro("GetNthLabel: Invalid label index " << n);
+    return 0;
+    }
+  return this->Statistics->Labels[n];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkCalculateLabelStatistics::GetVoxelCount(int label)
+{
+  std::map<int, LabelStatisticsTable::LabelStatistics>::iterator labelIt = this->Statistics->Statistics.find(label);
+  return (labelIt != this->Statistics->Statistics.end() ? labelIt->second.VoxelCount : 0);
+}
+
+//----------------------------------------------------------------------------
+double vtkCalculateLabelStatistics::GetVolume(int label)
+{
+  return this->GetVoxelCount(label) * this->VoxelVolume;
+}
+
+//----------------------------------------------------------------------------
+double vtkCalculateLabelStatistics::GetMinimum(int label)
+{
+  std::map<int, LabelStatisticsTable::LabelStatistics>::iterator labelIt = this->Statistics->Statistics.find(label);
+  if (labelIt == this->Statistics->Statistics.end() || !this->ScalarImageData)
+    {
+    return 0.0;
+    }
+  return labelIt->second.Minimum;
+}
+
+//----------------------------------------------------------------------------
+double vtkCalculateLabelStatistics::GetMaximum(int label)
+{
+  std::map<int, LabelStatisticsTable::LabelStatistics>::iterator labelIt = this->Statistics->Statistics.find(label);
+  if (labelIt == this->Statistics->Statistics.end() || !this->ScalarImageData)
+    {
+    return 0.0;
+    }
+  return labelIt->second.Maximum;
+}
+
+//----------------------------------------------------------------------------
+double vtkCalculateLabelStatistics::GetMean(int label)
+{
+  std::map<int, LabelStatisticsTable::LabelStatistics>::iterator labelIt = this->Statistics->Statistics.find(label);
+  if (labelIt == this->Statistics->Statistics.end() || !this->ScalarImageData)
+    {
+    return 0.0;
+    }
+  return labelIt->second.Sum / labelIt->second.VoxelCount;
+}
+
+//----------------------------------------------------------------------------
+double vtkCalculateLabelStatistics::GetStandardDeviation(int label)
+{
+  std::map<int, LabelStatisticsTable::LabelStatistics>::iterator labelIt = this->Statistics->Statistics.find(label);
+  if (labelIt == this->Statistics->Statistics.end() || !this->ScalarImageData || labelIt->second.VoxelCount < 2)
+    {
+    return 0.0;
+    }
+  double n = static_cast<double>(labelIt->second.VoxelCount);
+  double mean = labelIt->second.Sum / n;
+  double variance = (labelIt->second.SumOfSquares - mean * mean * n) / (n - 1.0);
+  return (variance > 0.0 ? sqrt(variance) : 0.0);
+}
+
+//----------------------------------------------------------------------------
+void vtkCalculateLabelStatistics::GetHistogram(int label, vtkIdTypeArray* histogram)
+{
+  if (!histogram)
+    {
+    vtkErrorMacro("GetHistogram: Invalid histogram array");
+    return;
+    }
+  histogram->Reset();
+  histogram->SetNumberOfValues(this->NumberOfHistogramBins);
+  for (int bin = 0; bin < this->NumberOfHistogramBins; ++bin)
+    {
+    histogram->SetValue(bin, 0);
+    }
+  std::map<int, LabelStatisticsTable::LabelStatistics>::iterator labelIt = this->Statistics->Statistics.find(label);
+  if (labelIt == this->Statistics->Statistics.end())
+    {
+    return;
+    }
+  std::vector<vtkIdType>& bins = labelIt->second.Histogram;
+  for (size_t bin = 0; bin < bins.size() && bin < static_cast<size_t>(this->NumberOfHistogramBins); ++bin)
+    {
+    histogram->SetValue(static_cast<vtkIdType>(bin), bins[bin]);
+    }
+}
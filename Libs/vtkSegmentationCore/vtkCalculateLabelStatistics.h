@@ -0,0 +1,124 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkCalculateLabelStatistics_h
+#define __vtkCalculateLabelStatistics_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSegmentationCoreConfigure.h"
+
+class vtkIdTypeArray;
+class vtkImageData;
+
+/// \ingroup SegmentationCore
+/// \brief Calculate statistics of all labels of a labelmap in a single pass
+/// \details Voxel count of each label value and, if a scalar image is specified, minimum, maximum,
+///   mean, standard deviation and optionally histogram of the scalar values within each label are
+///   computed. The labelmap is traversed only once (split between threads), regardless of the
+///   number of labels. Statistics are computed in the intersection of the extents of the label
+///   image and the scalar image, voxels are matched by their IJK index.
+class vtkSegmentationCore_EXPORT vtkCalculateLabelStatistics : public vtkObject
+{
+public:
+  static vtkCalculateLabelStatistics *New();
+  vtkTypeMacro(vtkCalculateLabelStatistics, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+public:
+  /// Compute statistics of all labels.
+  /// \return False if the inputs are invalid.
+  bool Calculate();
+
+  /// Get number of label values that occur in the label image (after last Calculate)
+  int GetNumberOfLabels();
+  /// Get n-th label value that occurs in the label image. Label values are sorted in ascending order.
+  int GetNthLabel(int n);
+
+  /// Get number of voxels that have the given label value. 0 if the label does not occur in the label image.
+  vtkIdType GetVoxelCount(int label);
+  /// Get total volume of voxels that have the given label value (voxel count multiplied by VoxelVolume)
+  double GetVolume(int label);
+  /// Get minimum scalar value within the label
+  double GetMinimum(int label);
+  /// Get maximum scalar value within the label
+  double GetMaximum(int label);
+  /// Get mean scalar value within the label
+  double GetMean(int label);
+  /// Get standard deviation of scalar values within the label (sample standard deviation,
+  /// same as computed by vtkImageAccumulate)
+  double GetStandardDeviation(int label);
+  /// Get histogram of scalar values within the label.
+  /// Only available if NumberOfHistogramBins is larger than 0.
+  void GetHistogram(int label, vtkIdTypeArray* histogram);
+
+public:
+  /// Label image. Label values are cast to int.
+  vtkGetObjectMacro(LabelImageData, vtkImageData);
+  vtkSetObjectMacro(LabelImageData, vtkImageData);
+
+  /// Scalar image that the intensity statistics are computed from (first component is used).
+  /// If not set, then only voxel counts are computed.
+  vtkGetObjectMacro(ScalarImageData, vtkImageData);
+  vtkSetObjectMacro(ScalarImageData, vtkImageData);
+
+  /// Volume of a single voxel, used for computing label volumes. Default is 1.
+  vtkGetMacro(VoxelVolume, double);
+  vtkSetMacro(VoxelVolume, double);
+
+  /// If enabled then all non-zero voxels of the label image are counted as label 1.
+  /// Useful for computing statistics of binary labelmaps. Disabled by default.
+  vtkGetMacro(MergeNonZeroLabels, bool);
+  vtkSetMacro(MergeNonZeroLabels, bool);
+  vtkBooleanMacro(MergeNonZeroLabels, bool);
+
+  /// Number of histogram bins. No histogram is computed if 0 (default).
+  vtkGetMacro(NumberOfHistogramBins, int);
+  vtkSetClampMacro(NumberOfHistogramBins, int, 0, VTK_INT_MAX);
+
+  /// Range of scalar values covered by the histogram. Values outside the range are counted
+  /// in the first or last bin. If invalid (minimum > maximum) then the scalar range of the scalar image is used.
+  vtkGetVector2Macro(HistogramRange, double);
+  vtkSetVector2Macro(HistogramRange, double);
+
+  /// Number of threads used for the computation. If 0 (default) then the global default
+  /// number of threads of vtkMultiThreader is used.
+  vtkGetMacro(NumberOfThreads, int);
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX);
+
+protected:
+  vtkImageData* LabelImageData;
+  vtkImageData* ScalarImageData;
+  double VoxelVolume;
+  bool MergeNonZeroLabels;
+  int NumberOfHistogramBins;
+  double HistogramRange[2];
+  int NumberOfThreads;
+
+  /// Statistics of all labels. Defined in the implementation file.
+  class LabelStatisticsTable;
+  LabelStatisticsTable* Statistics;
+
+protected:
+  vtkCalculateLabelStatistics();
+  virtual ~vtkCalculateLabelStatistics();
+
+private:
+  vtkCalculateLabelStatistics(const vtkCalculateLabelStatistics&); // Not implemented
+  void operator=(const vtkCalculateLabelStatistics&);               // Not implemented
+};
+
+#endif
@@ -21,6 +21,7 @@
 // SegmentationCore includes
 #include "vtkSegment.h"
 
+#include "vtkSegmentationConverter.h"
 #include "vtkSegmentationConverterFactory.h"
 #include "vtkOrientedImageData.h"
 #include "vtkOrientedImageDataResample.h"
@@ -35,12 +36,141 @@
 #include <vtkSmartPointer.h>
 #include <vtkMath.h>
 #include <vtkDataSet.h>
+#include <vtkPointData.h>
 
 // STD includes
 #include <algorithm>
 #include <set>
 #include <sstream>
 
+namespace
+{
+//----------------------------------------------------------------------------
+bool IntersectExtents(const int extent1[6], const int extent2[6], int intersection[6])
+{
+  bool empty = false;
+  for (int i = 0; i < 3; i++)
+    {
+    intersection[i * 2] = std::max(extent1[i * 2], extent2[i * 2]);
+    intersection[i * 2 + 1] = std::min(extent1[i * 2 + 1], extent2[i * 2 + 1]);
+    if (intersection[i * 2] > intersection[i * 2 + 1])
+      {
+      empty = true;
+      }
+    }
+  return !empty;
+}
+
+//----------------------------------------------------------------------------
+/// Get the extent of voxels in sharedLabelmap within extent that have labelValue.
+/// \return False if there are no such voxels
+template <class T>
+bool GetLabelExtentGeneric(vtkImageData* sharedLabelmap, int labelValue, const int extent[6], int labelExtent[6])
+{
+  T value = static_cast<T>(labelValue);
+  labelExtent[0] = labelExtent[2] = labelExtent[4] = VTK_INT_MAX;
+  labelExtent[1] = labelExtent[3] = labelExtent[5] = VTK_INT_MIN;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* voxel = static_cast<T*>(sharedLabelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, voxel++)
+        {
+        if (*voxel != value)
+          {
+          continue;
+          }
+        labelExtent[0] = std::min(labelExtent[0], i);
+        labelExtent[1] = std::max(labelExtent[1], i);
+        labelExtent[2] = std::min(labelExtent[2], j);
+        labelExtent[3] = std::max(labelExtent[3], j);
+        labelExtent[4] = std::min(labelExtent[4], k);
+        labelExtent[5] = std::max(labelExtent[5], k);
+        }
+      }
+    }
+  return labelExtent[0] <= labelExtent[1];
+}
+
+//----------------------------------------------------------------------------
+/// Set voxels of binaryLabelmap within extent to 1 where sharedLabelmap has labelValue, 0 elsewhere
+template <class T>
+void ExtractLabelGeneric(vtkImageData* sharedLabelmap, int labelValue, const int extent[6], vtkImageData* binaryLabelmap)
+{
+  T value = static_cast<T>(labelValue);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* voxel = static_cast<T*>(sharedLabelmap->GetScalarPointer(extent[0], j, k));
+      unsigned char* binaryVoxel = static_cast<unsigned char*>(binaryLabelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        *(binaryVoxel++) = (*(voxel++) == value ? 1 : 0);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Set voxels of sharedLabelmap within extent that have labelValue to 0
+template <class T>
+void ClearLabelGeneric(vtkImageData* sharedLabelmap, int labelValue, const int extent[6])
+{
+  T value = static_cast<T>(labelValue);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* voxel = static_cast<T*>(sharedLabelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, voxel++)
+        {
+        if (*voxel == value)
+          {
+          *voxel = 0;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool GetLabelExtent(vtkImageData* sharedLabelmap, int labelValue, const int extent[6], int labelExtent[6])
+{
+  switch (sharedLabelmap->GetScalarType())
+    {
+    vtkTemplateMacro(return GetLabelExtentGeneric<VTK_TT>(sharedLabelmap, labelValue, extent, labelExtent));
+    default:
+      vtkGenericWarningMacro("GetLabelExtent: Unknown scalar type");
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void ExtractLabel(vtkImageData* sharedLabelmap, int labelValue, const int extent[6], vtkImageData* binaryLabelmap)
+{
+  switch (sharedLabelmap->GetScalarType())
+    {
+    vtkTemplateMacro(ExtractLabelGeneric<VTK_TT>(sharedLabelmap, labelValue, extent, binaryLabelmap));
+    default:
+      vtkGenericWarningMacro("ExtractLabel: Unknown scalar type");
+    }
+}
+
+//----------------------------------------------------------------------------
+void ClearLabel(vtkImageData* sharedLabelmap, int labelValue, const int extent[6])
+{
+  switch (sharedLabelmap->GetScalarType())
+    {
+    vtkTemplateMacro(ClearLabelGeneric<VTK_TT>(sharedLabelmap, labelValue, extent));
+    default:
+      vtkGenericWarningMacro("ClearLabel: Unknown scalar type");
+    }
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 const double vtkSegment::SEGMENT_COLOR_INVALID[3] = {0.5, 0.5, 0.5};
 
@@ -59,6 +189,7 @@ vtkSegment::vtkSegment()
 
   this->NameAutoGenerated = true;
   this->ColorAutoGenerated = true;
+  this->SharedLabelValue = 0;
 
   // Set default terminology Tissue/Tissue from the default Slicer terminology dictionary
   this->SetTag( vtkSegment::GetTerminologyEntryTagName(),
@@ -68,6 +199,8 @@ vtkSegment::vtkSegment()
 //----------------------------------------------------------------------------
 vtkSegment::~vtkSegment()
 {
+  // Voxels are left in the shared labelmap, the segment has already been removed from the segmentation
+  this->StopSharingLabelmap(false, false);
   this->RemoveAllRepresentations();
   this->Representations.clear();
 }
@@ -83,6 +216,8 @@ void vtkSegment::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "Name: " << (this->Name ? this->Name : "NULL") << "\n";
   os << indent << "Color: (" << this->Color[0] << ", " << this->Color[1] << ", " << this->Color[2] << ")\n";
+  os << indent << "SharedLabelmap: " << (this->SharedLabelmap.GetPointer() ? "yes" : "no") << "\n";
+  os << indent << "SharedLabelValue: " << this->SharedLabelValue << "\n";
 
   RepresentationMap::iterator reprIt;
   os << indent << "Representations:\n";
@@ -158,13 +293,60 @@ void vtkSegment::DeepCopy(vtkSegment* source)
     return;
     }
 
+  // All representations are replaced, including the one stored in the shared labelmap
+  this->StopSharingLabelmap(false, false);
+
+  this->DeepCopyMetadata(source);
+
+  // The copy stores the binary labelmap separately
+  vtkSmartPointer<vtkOrientedImageData> sourceSharedLabelmap = source->GetSharedLabelmap();
+  this->DeepCopyRepresentations(source, sourceSharedLabelmap.GetPointer() == NULL);
+  if (sourceSharedLabelmap.GetPointer())
+    {
+    vtkSmartPointer<vtkOrientedImageData> binaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    source->ExtractBinaryLabelmapRepresentation(binaryLabelmap);
+    this->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), binaryLabelmap);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSegment::DeepCopyWithSharedLabelmap(vtkSegment* source, vtkOrientedImageData* sharedLabelmap)
+{
+  if (!source)
+    {
+    vtkErrorMacro("vtkSegment::DeepCopyWithSharedLabelmap failed: sourceSegment is invalid")
+    return;
+    }
+  if (!source->GetSharedLabelmap() || !sharedLabelmap)
+    {
+    this->DeepCopy(source);
+    return;
+    }
+
+  this->StopSharingLabelmap(false, false);
   this->DeepCopyMetadata(source);
+  this->DeepCopyRepresentations(source, false);
+  this->SetSharedLabelmap(sharedLabelmap, source->SharedLabelValue);
+}
+
+//----------------------------------------------------------------------------
+void vtkSegment::DeepCopyRepresentations(vtkSegment* source, bool copyBinaryLabelmap)
+{
+  std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
 
   // Deep copy representations
   std::set<std::string> representationNamesToKeep;
+  if (!copyBinaryLabelmap)
+    {
+    representationNamesToKeep.insert(binaryLabelmapName);
+    }
   RepresentationMap::iterator reprIt;
   for (reprIt=source->Representations.begin(); reprIt!=source->Representations.end(); ++reprIt)
     {
+    if (!copyBinaryLabelmap && reprIt->first == binaryLabelmapName)
+      {
+      continue;
+      }
     vtkDataObject* representationCopy =
       vtkSegmentationConverterFactory::GetInstance()->ConstructRepresentationObjectByClass( reprIt->second->GetClassName() );
     if (!representationCopy)
@@ -220,10 +402,27 @@ void vtkSegment::GetBounds(double bounds[6])
   RepresentationMap::iterator reprIt;
   for (reprIt=this->Representations.begin(); reprIt!=this->Representations.end(); ++reprIt)
     {
+    double representationBounds[6] = { 1, -1, 1, -1, 1, -1 };
+    if (this->SharedLabelmap.GetPointer() && reprIt->second.GetPointer() == this->SharedLabelmap.GetPointer())
+      {
+      // Only the voxels of this segment are taken into account
+      int labelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      if (!this->GetSharedLabelExtent(labelExtent))
+        {
+        continue;
+        }
+      vtkNew<vtkOrientedImageData> labelGeometry;
+      labelGeometry->CopyDirections(this->SharedLabelmap);
+      labelGeometry->SetSpacing(this->SharedLabelmap->GetSpacing());
+      labelGeometry->SetOrigin(this->SharedLabelmap->GetOrigin());
+      labelGeometry->SetExtent(labelExtent);
+      labelGeometry->GetBounds(representationBounds);
+      boundingBox.AddBounds(representationBounds);
+      continue;
+      }
     vtkDataSet* representationDataSet = vtkDataSet::SafeDownCast(reprIt->second);
     if (representationDataSet)
       {
-      double representationBounds[6] = { 1, -1, 1, -1, 1, -1 };
       representationDataSet->GetBounds(representationBounds);
       boundingBox.AddBounds(representationBounds);
       }
@@ -253,6 +452,12 @@ void vtkSegment::AddRepresentation(std::string name, vtkDataObject* representati
     {
     return;
     }
+  if (this->SharedLabelmap.GetPointer()
+    && name == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    {
+    // The new binary labelmap is stored in the segment instead of the shared labelmap
+    this->StopSharingLabelmap(false, true);
+    }
 
   this->Representations[name] = representation; // Representations stores the pointer in a smart pointer, which makes sure the object is not deleted
   this->Modified();
@@ -261,8 +466,16 @@ void vtkSegment::AddRepresentation(std::string name, vtkDataObject* representati
 //---------------------------------------------------------------------------
 void vtkSegment::RemoveRepresentation(std::string name)
 {
-  vtkDataObject* representation = this->GetRepresentation(name);
-  if (representation)
+  if (this->SharedLabelmap.GetPointer()
+    && name == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    {
+    // Removes the shared labelmap from the representations
+    this->StopSharingLabelmap(false, true);
+    this->Modified();
+    return;
+    }
+  RepresentationMap::iterator reprIt = this->Representations.find(name);
+  if (reprIt != this->Representations.end())
     {
     this->Representations.erase(name);
     this->Modified();
@@ -272,6 +485,11 @@ void vtkSegment::RemoveRepresentation(std::string name)
 //---------------------------------------------------------------------------
 void vtkSegment::RemoveAllRepresentations(std::string exceptionRepresentationName/*=""*/)
 {
+  if (this->SharedLabelmap.GetPointer()
+    && exceptionRepresentationName != vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    {
+    this->StopSharingLabelmap(false, true);
+    }
   bool modified = false;
   RepresentationMap::iterator reprIt = this->Representations.begin();
   while (reprIt != this->Representations.end())
@@ -305,6 +523,146 @@ void vtkSegment::GetContainedRepresentationNames(std::vector<std::string>& repre
     }
 }
 
+//---------------------------------------------------------------------------
+vtkOrientedImageData* vtkSegment::GetSharedLabelmap()
+{
+  return this->SharedLabelmap.GetPointer();
+}
+
+//---------------------------------------------------------------------------
+void vtkSegment::SetSharedLabelmap(vtkOrientedImageData* sharedLabelmap, int labelValue)
+{
+  if (sharedLabelmap == this->SharedLabelmap.GetPointer() && labelValue == this->SharedLabelValue)
+    {
+    return;
+    }
+  if (!sharedLabelmap)
+    {
+    this->StopSharingLabelmap(true, false);
+    this->Modified();
+    return;
+    }
+  if (this->SharedLabelmap.GetPointer())
+    {
+    // The segment has been written to the new shared labelmap
+    this->StopSharingLabelmap(false, true);
+    }
+
+  // The separate binary labelmap is released, the shared labelmap is used instead
+  this->SharedLabelmap = sharedLabelmap;
+  this->SharedLabelValue = labelValue;
+  this->Representations[vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()] = sharedLabelmap;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegment::ExtractBinaryLabelmapRepresentation(vtkOrientedImageData* binaryLabelmap)
+{
+  if (!binaryLabelmap)
+    {
+    vtkErrorMacro("ExtractBinaryLabelmapRepresentation: Invalid output labelmap");
+    return false;
+    }
+  if (!this->SharedLabelmap.GetPointer())
+    {
+    vtkOrientedImageData* representation = vtkOrientedImageData::SafeDownCast(
+      this->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+    if (!representation)
+      {
+      return false;
+      }
+    binaryLabelmap->DeepCopy(representation);
+    return true;
+    }
+
+  binaryLabelmap->SetOrigin(this->SharedLabelmap->GetOrigin());
+  binaryLabelmap->SetSpacing(this->SharedLabelmap->GetSpacing());
+  binaryLabelmap->CopyDirections(this->SharedLabelmap);
+  int labelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (this->GetSharedLabelExtent(labelExtent))
+    {
+    binaryLabelmap->SetExtent(labelExtent);
+    binaryLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    ExtractLabel(this->SharedLabelmap, this->SharedLabelValue, labelExtent, binaryLabelmap);
+    }
+  else
+    {
+    binaryLabelmap->SetExtent(0, -1, 0, -1, 0, -1);
+    binaryLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSegment::StopSharingLabelmap(bool extract, bool clearLabel)
+{
+  if (!this->SharedLabelmap.GetPointer())
+    {
+    return;
+    }
+  vtkSmartPointer<vtkOrientedImageData> extractedLabelmap;
+  if (extract)
+    {
+    extractedLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    this->ExtractBinaryLabelmapRepresentation(extractedLabelmap);
+    }
+  if (clearLabel && this->SharedLabelmap->GetPointData()->GetScalars())
+    {
+    int labelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    if (this->GetSharedLabelExtent(labelExtent))
+      {
+      this->ClearSharedLabel(labelExtent);
+      this->SharedLabelmap->Modified();
+      }
+    }
+
+  // The shared labelmap is not a representation of this segment anymore
+  RepresentationMap::iterator reprIt = this->Representations.find(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  if (reprIt != this->Representations.end() && reprIt->second.GetPointer() == this->SharedLabelmap.GetPointer())
+    {
+    if (extractedLabelmap.GetPointer())
+      {
+      reprIt->second = extractedLabelmap;
+      }
+    else
+      {
+      this->Representations.erase(reprIt);
+      }
+    }
+  this->SharedLabelmap = NULL;
+  this->SharedLabelValue = 0;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegment::GetSharedLabelExtent(int extent[6])
+{
+  if (!this->SharedLabelmap.GetPointer() || !this->SharedLabelmap->GetPointData()->GetScalars())
+    {
+    return false;
+    }
+  int* sharedExtent = this->SharedLabelmap->GetExtent();
+  if (sharedExtent[0] > sharedExtent[1] || sharedExtent[2] > sharedExtent[3] || sharedExtent[4] > sharedExtent[5])
+    {
+    return false;
+    }
+  return GetLabelExtent(this->SharedLabelmap, this->SharedLabelValue, sharedExtent, extent);
+}
+
+//---------------------------------------------------------------------------
+void vtkSegment::ClearSharedLabel(const int extent[6])
+{
+  if (!this->SharedLabelmap.GetPointer() || !this->SharedLabelmap->GetPointData()->GetScalars())
+    {
+    return;
+    }
+  int clearExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (IntersectExtents(extent, this->SharedLabelmap->GetExtent(), clearExtent))
+    {
+    ClearLabel(this->SharedLabelmap, this->SharedLabelValue, clearExtent);
+    }
+}
+
 //---------------------------------------------------------------------------
 void vtkSegment::SetTag(std::string tag, std::string value)
 {
@@ -33,6 +33,8 @@
 // Segmentation includes
 #include "vtkSegmentationCoreConfigure.h"
 
+class vtkOrientedImageData;
+
 /// \ingroup SegmentationCore
 /// \brief This class encapsulates a segment that is part of a segmentation
 /// \details
@@ -74,7 +76,8 @@ public:
   /// Get representation of a given type. This class is not responsible for conversion, only storage!
   /// \param name Representation name. Default representation names can be queried from \sa vtkSegmentationConverter,
   ///   for example by calling vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()
-  /// \return The specified representation object, NULL if not present
+  /// \return The specified representation object, NULL if not present. If the segment uses a shared labelmap
+  ///   then the binary labelmap representation is the shared labelmap (\sa SetSharedLabelmap).
   vtkDataObject* GetRepresentation(std::string name);
 
   /// Add representation
@@ -109,6 +112,37 @@ public:
   /// Get representation names present in this segment in an output string vector
   void GetContainedRepresentationNames(std::vector<std::string>& representationNames);
 
+  /// Store the binary labelmap representation of this segment in a labelmap that is shared with
+  /// other, non-overlapping segments. Voxels of this segment have the value labelValue in the shared labelmap.
+  /// The segment has to be already written into sharedLabelmap (with the same content as the current
+  /// binary labelmap representation).
+  /// The shared labelmap replaces the binary labelmap representation of the segment, so voxels of the segment
+  /// are not stored separately: \sa GetRepresentation returns the shared labelmap, which also contains the other
+  /// segments. Use \sa ExtractBinaryLabelmapRepresentation to get a labelmap that only contains this segment.
+  /// Setting or removing the binary labelmap representation of the segment makes it stop using the shared
+  /// labelmap, and its voxels are removed from the shared labelmap.
+  /// If sharedLabelmap is NULL then the segment stops using the shared labelmap and its voxels are
+  /// extracted into a separate binary labelmap representation.
+  /// \sa vtkSegmentation::CollapseBinaryLabelmaps
+  void SetSharedLabelmap(vtkOrientedImageData* sharedLabelmap, int labelValue);
+  /// Get labelmap that stores the binary labelmap representation, NULL if the segment stores it separately
+  vtkOrientedImageData* GetSharedLabelmap();
+  /// Get value of the voxels of this segment in the shared labelmap
+  vtkGetMacro(SharedLabelValue, int);
+
+  /// Get binary labelmap of this segment, which contains 1 inside the segment and 0 elsewhere.
+  /// If the segment uses a shared labelmap then voxels of the segment are extracted from the shared labelmap,
+  /// and binaryLabelmap is cropped to the extent of the segment. Otherwise the binary labelmap representation is copied.
+  /// The segment is not modified.
+  /// \return False if the segment has no binary labelmap representation
+  bool ExtractBinaryLabelmapRepresentation(vtkOrientedImageData* binaryLabelmap);
+
+  /// Deep copy a segment that may use a shared labelmap. If the source segment uses a shared labelmap
+  /// then the copy uses sharedLabelmap (a copy of the shared labelmap of the source segment) with the same
+  /// label value, otherwise it is the same as \sa DeepCopy.
+  /// \sa vtkSegmentation::DeepCopy
+  void DeepCopyWithSharedLabelmap(vtkSegment* source, vtkOrientedImageData* sharedLabelmap);
+
 public:
   vtkGetStringMacro(Name);
   vtkSetStringMacro(Name);
@@ -129,6 +163,24 @@ protected:
   ~vtkSegment();
   void operator=(const vtkSegment&);
 
+  /// Deep copy representations of the source segment
+  /// \param copyBinaryLabelmap If false then the binary labelmap representation is neither copied nor removed
+  void DeepCopyRepresentations(vtkSegment* source, bool copyBinaryLabelmap);
+
+  /// Stop using the shared labelmap.
+  /// \param extract If true then voxels of the segment are extracted into a separate binary labelmap representation,
+  ///   otherwise the binary labelmap representation is removed.
+  /// \param clearLabel If true then voxels of the segment are removed from the shared labelmap.
+  ///   Otherwise they are left in the shared labelmap, but the label value is not used by any segment anymore.
+  void StopSharingLabelmap(bool extract, bool clearLabel);
+
+  /// Get the extent that contains all voxels of the segment in the shared labelmap
+  /// \return False if the segment has no voxels
+  bool GetSharedLabelExtent(int extent[6]);
+
+  /// Set voxels of the segment within extent to 0 in the shared labelmap. The shared labelmap is not marked modified.
+  void ClearSharedLabel(const int extent[6]);
+
 protected:
   /// Stored representations. Map from type string to data object
   RepresentationMap Representations;
@@ -149,6 +201,13 @@ protected:
   bool NameAutoGenerated;
   /// Flag indicating whether color was automatically generated. False after user manually overrides. True by default
   bool ColorAutoGenerated;
+
+  /// Labelmap that stores the binary labelmap representation of this segment and other segments
+  vtkSmartPointer<vtkOrientedImageData> SharedLabelmap;
+  /// Value of the voxels of this segment in SharedLabelmap
+  int SharedLabelValue;
+
+  friend class vtkSegmentation;
 };
 
 #endif // __vtkSegment_h
@@ -41,11 +41,13 @@
 #include <vtkTransform.h>
 #include <vtkPolyData.h>
 #include <vtkTransformPolyDataFilter.h>
+#include <vtkPointData.h>
 
 // STD includes
 #include <sstream>
 #include <algorithm>
 #include <functional>
+#include <set>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSegmentation);
@@ -61,6 +63,155 @@ public:
     }
 };
 
+namespace
+{
+//----------------------------------------------------------------------------
+bool IsExtentValid(const int extent[6])
+{
+  return extent[0] <= extent[1] && extent[2] <= extent[3] && extent[4] <= extent[5];
+}
+
+//----------------------------------------------------------------------------
+void UniteExtents(const int extent[6], int union_[6])
+{
+  if (!IsExtentValid(extent))
+    {
+    return;
+    }
+  if (!IsExtentValid(union_))
+    {
+    std::copy(extent, extent + 6, union_);
+    return;
+    }
+  for (int i = 0; i < 3; i++)
+    {
+    union_[i * 2] = std::min(union_[i * 2], extent[i * 2]);
+    union_[i * 2 + 1] = std::max(union_[i * 2 + 1], extent[i * 2 + 1]);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool IntersectExtents(const int extent1[6], const int extent2[6], int intersection[6])
+{
+  for (int i = 0; i < 3; i++)
+    {
+    intersection[i * 2] = std::max(extent1[i * 2], extent2[i * 2]);
+    intersection[i * 2 + 1] = std::min(extent1[i * 2 + 1], extent2[i * 2 + 1]);
+    }
+  return IsExtentValid(intersection);
+}
+
+//----------------------------------------------------------------------------
+/// Set voxels of sharedLabelmap within extent to labelValue where labelmap is non-zero.
+/// Labels that are overwritten are flagged in overwrittenLabels.
+template <class SharedType, class LabelmapType>
+void WriteLabelGeneric(vtkImageData* sharedLabelmap, vtkImageData* labelmap, const int extent[6],
+  int labelValue, std::vector<char>& overwrittenLabels)
+{
+  SharedType value = static_cast<SharedType>(labelValue);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      SharedType* sharedVoxel = static_cast<SharedType*>(sharedLabelmap->GetScalarPointer(extent[0], j, k));
+      LabelmapType* labelmapVoxel = static_cast<LabelmapType*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, sharedVoxel++, labelmapVoxel++)
+        {
+        if (*labelmapVoxel == 0 || *sharedVoxel == value)
+          {
+          continue;
+          }
+        overwrittenLabels[*sharedVoxel] = 1;
+        *sharedVoxel = value;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Determine if any non-zero voxel of labelmap within extent is already labeled in sharedLabelmap
+template <class SharedType, class LabelmapType>
+bool IsOverlappingGeneric(vtkImageData* sharedLabelmap, vtkImageData* labelmap, const int extent[6])
+{
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      SharedType* sharedVoxel = static_cast<SharedType*>(sharedLabelmap->GetScalarPointer(extent[0], j, k));
+      LabelmapType* labelmapVoxel = static_cast<LabelmapType*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, sharedVoxel++, labelmapVoxel++)
+        {
+        if (*labelmapVoxel != 0 && *sharedVoxel != 0)
+          {
+          return true;
+          }
+        }
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+// Shared labelmaps are always unsigned char or unsigned short, labelmaps may be of any type.
+bool WriteLabel(vtkImageData* sharedLabelmap, vtkImageData* labelmap, const int extent[6],
+  int labelValue, std::vector<char>& overwrittenLabels)
+{
+  if (sharedLabelmap->GetScalarType() == VTK_UNSIGNED_CHAR)
+    {
+    switch (labelmap->GetScalarType())
+      {
+      vtkTemplateMacro((WriteLabelGeneric<unsigned char, VTK_TT>(sharedLabelmap, labelmap, extent, labelValue, overwrittenLabels)));
+      default:
+        return false;
+      }
+    return true;
+    }
+  if (sharedLabelmap->GetScalarType() == VTK_UNSIGNED_SHORT)
+    {
+    switch (labelmap->GetScalarType())
+      {
+      vtkTemplateMacro((WriteLabelGeneric<unsigned short, VTK_TT>(sharedLabelmap, labelmap, extent, labelValue, overwrittenLabels)));
+      default:
+        return false;
+      }
+    return true;
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+bool IsOverlapping(vtkImageData* sharedLabelmap, vtkImageData* labelmap, const int extent[6])
+{
+  if (sharedLabelmap->GetScalarType() == VTK_UNSIGNED_CHAR)
+    {
+    switch (labelmap->GetScalarType())
+      {
+      vtkTemplateMacro(return (IsOverlappingGeneric<unsigned char, VTK_TT>(sharedLabelmap, labelmap, extent)));
+      default:
+        break;
+      }
+    }
+  else if (sharedLabelmap->GetScalarType() == VTK_UNSIGNED_SHORT)
+    {
+    switch (labelmap->GetScalarType())
+      {
+      vtkTemplateMacro(return (IsOverlappingGeneric<unsigned short, VTK_TT>(sharedLabelmap, labelmap, extent)));
+      default:
+        break;
+      }
+    }
+  // Unknown scalar type, treat it as overlapping so that it is not collapsed
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool HasVoxels(vtkOrientedImageData* labelmap)
+{
+  return labelmap && labelmap->GetPointData()->GetScalars() && IsExtentValid(labelmap->GetExtent());
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkSegmentation::vtkSegmentation()
 {
@@ -144,11 +295,27 @@ void vtkSegmentation::DeepCopy(vtkSegmentation* aSegmentation)
   // Copy conversion parameters
   this->Converter->DeepCopy(aSegmentation->Converter);
 
-  // Deep copy segments list
+  // Deep copy segments list. Segments that share a labelmap in the source share a copy of it.
+  std::map<vtkOrientedImageData*, vtkSmartPointer<vtkOrientedImageData> > sharedLabelmapCopies;
   for (std::deque< std::string >::iterator segmentIdIt = aSegmentation->SegmentIds.begin(); segmentIdIt != aSegmentation->SegmentIds.end(); ++segmentIdIt)
     {
+    vtkSegment* sourceSegment = aSegmentation->Segments[*segmentIdIt];
     vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
-    segment->DeepCopy(aSegmentation->Segments[*segmentIdIt]);
+    vtkOrientedImageData* sourceSharedLabelmap = sourceSegment->GetSharedLabelmap();
+    if (sourceSharedLabelmap)
+      {
+      vtkSmartPointer<vtkOrientedImageData>& sharedLabelmapCopy = sharedLabelmapCopies[sourceSharedLabelmap];
+      if (!sharedLabelmapCopy)
+        {
+        sharedLabelmapCopy = vtkSmartPointer<vtkOrientedImageData>::New();
+        sharedLabelmapCopy->DeepCopy(sourceSharedLabelmap);
+        }
+      segment->DeepCopyWithSharedLabelmap(sourceSegment, sharedLabelmapCopy);
+      }
+    else
+      {
+      segment->DeepCopy(sourceSegment);
+      }
     this->AddSegment(segment);
     }
 }
@@ -516,8 +683,27 @@ void vtkSegmentation::RemoveSegment(SegmentMap::iterator segmentIt)
 
   // Remove observation of segment modified event
   segmentIt->second.GetPointer()->RemoveObservers(vtkCommand::ModifiedEvent, this->SegmentCallbackCommand);
-  // Remove observation of master representation of removed segment
-  vtkDataObject* masterRepresentation = segmentIt->second->GetRepresentation(this->MasterRepresentationName);
+  // The removed segment may still be used elsewhere, so it keeps its voxels in a separate binary labelmap,
+  // and they are removed from the shared labelmap
+  // (voxels of the other segments do not change, so master representation modified event is not invoked).
+  vtkSegment* segment = segmentIt->second;
+  vtkSmartPointer<vtkOrientedImageData> sharedLabelmap = segment->GetSharedLabelmap();
+  if (sharedLabelmap.GetPointer())
+    {
+    std::vector<std::string> sharedSegmentIds;
+    this->GetSegmentIDsSharingBinaryLabelmap(segmentId, sharedSegmentIds);
+    bool wasMasterRepresentationModifiedEnabled = this->SetMasterRepresentationModifiedEnabled(false);
+    segment->StopSharingLabelmap(true, true);
+    this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+    if (sharedSegmentIds.size() < 2)
+      {
+      // No other segment uses the shared labelmap
+      sharedLabelmap->RemoveObservers(vtkCommand::ModifiedEvent, this->MasterRepresentationCallbackCommand);
+      }
+    }
+  // Remove observation of master representation of removed segment,
+  // the shared labelmap is still observed if other segments use it
+  vtkDataObject* masterRepresentation = segment->GetRepresentation(this->MasterRepresentationName);
   if (masterRepresentation)
     {
     masterRepresentation->RemoveObservers(vtkCommand::ModifiedEvent, this->MasterRepresentationCallbackCommand);
@@ -821,6 +1007,7 @@ void vtkSegmentation::ApplyLinearTransform(vtkAbstractTransform* transform)
 
   // Apply linear transform for each segment:
   // Harden transform on master representation if poly data, apply directions if oriented image data
+  std::set<vtkDataObject*> transformedRepresentations;
   for (SegmentMap::iterator it = this->Segments.begin(); it != this->Segments.end(); ++it)
     {
     vtkDataObject* currentMasterRepresentation = it->second->GetRepresentation(this->MasterRepresentationName);
@@ -829,6 +1016,11 @@ void vtkSegmentation::ApplyLinearTransform(vtkAbstractTransform* transform)
       vtkErrorMacro("ApplyLinearTransform: Cannot get master representation (" << this->MasterRepresentationName << ") from segment!");
       return;
       }
+    if (!transformedRepresentations.insert(currentMasterRepresentation).second)
+      {
+      // Shared labelmap that has been already transformed
+      continue;
+      }
 
     vtkPolyData* currentMasterRepresentationPolyData = vtkPolyData::SafeDownCast(currentMasterRepresentation);
     vtkOrientedImageData* currentMasterRepresentationOrientedImageData = vtkOrientedImageData::SafeDownCast(currentMasterRepresentation);
@@ -868,6 +1060,7 @@ void vtkSegmentation::ApplyNonLinearTransform(vtkAbstractTransform* transform)
   this->Converter->ApplyTransformOnReferenceImageGeometry(transform);
 
   // Harden transform on master representation (both image data and poly data) for each segment individually
+  std::set<vtkDataObject*> transformedRepresentations;
   for (SegmentMap::iterator it = this->Segments.begin(); it != this->Segments.end(); ++it)
     {
     vtkDataObject* currentMasterRepresentation = it->second->GetRepresentation(this->MasterRepresentationName);
@@ -876,6 +1069,11 @@ void vtkSegmentation::ApplyNonLinearTransform(vtkAbstractTransform* transform)
       vtkErrorMacro("ApplyNonLinearTransform: Cannot get master representation (" << this->MasterRepresentationName << ") from segment!");
       return;
       }
+    if (!transformedRepresentations.insert(currentMasterRepresentation).second)
+      {
+      // Shared labelmap that has been already transformed
+      continue;
+      }
 
     vtkPolyData* currentMasterRepresentationPolyData = vtkPolyData::SafeDownCast(currentMasterRepresentation);
     vtkOrientedImageData* currentMasterRepresentationOrientedImageData = vtkOrientedImageData::SafeDownCast(currentMasterRepresentation);
@@ -915,13 +1113,20 @@ bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentati
       }
 
     // Get source representation from segment. It is expected to exist
-    vtkDataObject* sourceRepresentation = segment->GetRepresentation(
+    vtkSmartPointer<vtkDataObject> sourceRepresentation = segment->GetRepresentation(
       currentConversionRule->GetSourceRepresentationName() );
     if (!sourceRepresentation)
       {
       vtkErrorMacro("ConvertSegmentUsingPath: Source representation does not exist!");
       return false;
       }
+    if (segment->GetSharedLabelmap() && sourceRepresentation.GetPointer() == segment->GetSharedLabelmap())
+      {
+      // Only the voxels of this segment are converted
+      vtkSmartPointer<vtkOrientedImageData> binaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      segment->ExtractBinaryLabelmapRepresentation(binaryLabelmap);
+      sourceRepresentation = binaryLabelmap;
+      }
 
     // Get target representation
     vtkSmartPointer<vtkDataObject> targetRepresentation = segment->GetRepresentation(
@@ -1304,6 +1509,19 @@ bool vtkSegmentation::CopySegmentFromSegmentation(vtkSegmentation* fromSegmentat
   // If move, then just add segment to target and remove from source (ownership is transferred)
   else
     {
+    vtkSmartPointer<vtkSegment> movedSegment = segment;
+    if (segment->GetSharedLabelmap())
+      {
+      // The shared labelmap stays in the source segmentation. Removing the segment from the source
+      // extracts its voxels into a separate binary labelmap, which is then observed by this segmentation.
+      fromSegmentation->RemoveSegment(segmentId);
+      if (!this->AddSegment(movedSegment, targetSegmentId))
+        {
+        vtkErrorMacro("CopySegmentFromSegmentation: Failed to add segment '" << targetSegmentId << "' to segmentation");
+        return false;
+        }
+      return true;
+      }
     if (!this->AddSegment(segment, targetSegmentId))
       {
       vtkErrorMacro("CopySegmentFromSegmentation: Failed to add segment '" << targetSegmentId << "' to segmentation");
@@ -1315,6 +1533,240 @@ bool vtkSegmentation::CopySegmentFromSegmentation(vtkSegmentation* fromSegmentat
   return true;
 }
 
+//-----------------------------------------------------------------------------
+int vtkSegmentation::CollapseBinaryLabelmaps()
+{
+  std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  if (this->MasterRepresentationName != binaryLabelmapName)
+    {
+    vtkErrorMacro("CollapseBinaryLabelmaps: Master representation must be binary labelmap");
+    return 0;
+    }
+
+  this->ExpandBinaryLabelmaps();
+
+  // Segments are collapsed if their labelmap has the same lattice as the first non-empty one.
+  // Empty segments can be stored in any of the shared labelmaps.
+  vtkOrientedImageData* referenceLabelmap = NULL;
+  std::vector<std::string> segmentIdsToCollapse;
+  int sharedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (std::deque<std::string>::iterator segmentIdIt = this->SegmentIds.begin(); segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
+    {
+    vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(
+      this->GetSegment(*segmentIdIt)->GetRepresentation(binaryLabelmapName));
+    if (!labelmap)
+      {
+      continue;
+      }
+    if (HasVoxels(labelmap))
+      {
+      if (labelmap->GetNumberOfScalarComponents() != 1)
+        {
+        continue;
+        }
+      if (!referenceLabelmap)
+        {
+        referenceLabelmap = labelmap;
+        }
+      else if (!vtkOrientedImageDataResample::DoGeometriesMatch(labelmap, referenceLabelmap))
+        {
+        continue;
+        }
+      UniteExtents(labelmap->GetExtent(), sharedExtent);
+      }
+    segmentIdsToCollapse.push_back(*segmentIdIt);
+    }
+  if (!referenceLabelmap)
+    {
+    // Only empty segments, there is nothing to save
+    return 0;
+    }
+  // Labelmaps are released when they are collapsed, so the geometry is stored separately
+  vtkNew<vtkOrientedImageData> referenceGeometry;
+  referenceGeometry->CopyDirections(referenceLabelmap);
+  referenceGeometry->SetSpacing(referenceLabelmap->GetSpacing());
+  referenceGeometry->SetOrigin(referenceLabelmap->GetOrigin());
+
+  int sharedScalarType = VTK_UNSIGNED_CHAR;
+  int maximumLabelValue = VTK_UNSIGNED_CHAR_MAX;
+  if (segmentIdsToCollapse.size() > VTK_UNSIGNED_CHAR_MAX)
+    {
+    sharedScalarType = VTK_UNSIGNED_SHORT;
+    maximumLabelValue = VTK_UNSIGNED_SHORT_MAX;
+    }
+
+  bool wasMasterRepresentationModifiedEnabled = this->SetMasterRepresentationModifiedEnabled(false);
+
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > sharedLabelmaps;
+  std::vector<int> numberOfLabels;
+  std::vector<char> overwrittenLabels(maximumLabelValue + 1, 0);
+  std::vector<std::string> collapsedSegmentIds;
+  for (std::vector<std::string>::iterator segmentIdIt = segmentIdsToCollapse.begin(); segmentIdIt != segmentIdsToCollapse.end(); ++segmentIdIt)
+    {
+    vtkSegment* segment = this->GetSegment(*segmentIdIt);
+    vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(binaryLabelmapName));
+    bool empty = !HasVoxels(labelmap);
+
+    // Store the segment in the first shared labelmap that has a free label value and no overlapping voxels
+    size_t sharedIndex = 0;
+    for (; sharedIndex < sharedLabelmaps.size(); ++sharedIndex)
+      {
+      if (numberOfLabels[sharedIndex] >= maximumLabelValue)
+        {
+        continue;
+        }
+      if (empty || !IsOverlapping(sharedLabelmaps[sharedIndex], labelmap, labelmap->GetExtent()))
+        {
+        break;
+        }
+      }
+    if (sharedIndex == sharedLabelmaps.size())
+      {
+      vtkSmartPointer<vtkOrientedImageData> sharedLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      sharedLabelmap->CopyDirections(referenceGeometry.GetPointer());
+      sharedLabelmap->SetSpacing(referenceGeometry->GetSpacing());
+      sharedLabelmap->SetOrigin(referenceGeometry->GetOrigin());
+      sharedLabelmap->SetExtent(sharedExtent);
+      sharedLabelmap->AllocateScalars(sharedScalarType, 1);
+      vtkOrientedImageDataResample::FillImage(sharedLabelmap, 0);
+      sharedLabelmaps.push_back(sharedLabelmap);
+      numberOfLabels.push_back(0);
+      }
+
+    int labelValue = ++numberOfLabels[sharedIndex];
+    if (!empty)
+      {
+      WriteLabel(sharedLabelmaps[sharedIndex], labelmap, labelmap->GetExtent(), labelValue, overwrittenLabels);
+      sharedLabelmaps[sharedIndex]->Modified();
+      }
+    // Voxels of the segment are released, only the shared labelmap is kept
+    segment->SetSharedLabelmap(sharedLabelmaps[sharedIndex], labelValue);
+    collapsedSegmentIds.push_back(*segmentIdIt);
+    }
+
+  this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+  this->Modified();
+
+  // Binary labelmap representations have been replaced by the shared labelmaps
+  // (content of the segments has not changed, so other representations are kept)
+  for (std::vector<std::string>::iterator segmentIdIt = collapsedSegmentIds.begin(); segmentIdIt != collapsedSegmentIds.end(); ++segmentIdIt)
+    {
+    this->InvokeEvent(vtkSegmentation::RepresentationModified, (void*)segmentIdIt->c_str());
+    }
+  return static_cast<int>(sharedLabelmaps.size());
+}
+
+//-----------------------------------------------------------------------------
+void vtkSegmentation::ExpandBinaryLabelmaps()
+{
+  // Master representation of the segments is replaced by the separate labelmaps, which are observed instead
+  bool wasMasterRepresentationModifiedEnabled = this->SetMasterRepresentationModifiedEnabled(false);
+  for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt)
+    {
+    if (segmentIt->second->GetSharedLabelmap())
+      {
+      segmentIt->second->SetSharedLabelmap(NULL, 0);
+      }
+    }
+  this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+}
+
+//-----------------------------------------------------------------------------
+void vtkSegmentation::GetSegmentIDsSharingBinaryLabelmap(const std::string& segmentId, std::vector<std::string>& sharedSegmentIds)
+{
+  sharedSegmentIds.clear();
+  vtkSegment* segment = this->GetSegment(segmentId);
+  if (!segment)
+    {
+    return;
+    }
+  vtkOrientedImageData* sharedLabelmap = segment->GetSharedLabelmap();
+  if (!sharedLabelmap)
+    {
+    return;
+    }
+  for (std::deque<std::string>::iterator segmentIdIt = this->SegmentIds.begin(); segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
+    {
+    if (this->GetSegment(*segmentIdIt)->GetSharedLabelmap() == sharedLabelmap)
+      {
+      sharedSegmentIds.push_back(*segmentIdIt);
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSegmentation::SetBinaryLabelmapToSharedSegment(const std::string& segmentId, vtkOrientedImageData* labelmap,
+  bool replace, const int extent[6], std::vector<std::string>& modifiedSegmentIds)
+{
+  modifiedSegmentIds.clear();
+  if (!labelmap || !labelmap->GetPointData()->GetScalars() || labelmap->GetNumberOfScalarComponents() != 1)
+    {
+    return false;
+    }
+  std::vector<std::string> sharedSegmentIds;
+  this->GetSegmentIDsSharingBinaryLabelmap(segmentId, sharedSegmentIds);
+  if (sharedSegmentIds.empty())
+    {
+    return false;
+    }
+  vtkSegment* segment = this->GetSegment(segmentId);
+  vtkOrientedImageData* sharedLabelmap = segment->GetSharedLabelmap();
+  if (!vtkOrientedImageDataResample::DoGeometriesMatch(sharedLabelmap, labelmap))
+    {
+    return false;
+    }
+
+  int writeExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (extent)
+    {
+    IntersectExtents(labelmap->GetExtent(), extent, writeExtent);
+    }
+  else
+    {
+    labelmap->GetExtent(writeExtent);
+    }
+
+  // Make sure the shared labelmap contains the written region
+  if (IsExtentValid(writeExtent))
+    {
+    int unionExtent[6];
+    sharedLabelmap->GetExtent(unionExtent);
+    UniteExtents(writeExtent, unionExtent);
+    int* sharedExtent = sharedLabelmap->GetExtent();
+    if (!std::equal(unionExtent, unionExtent + 6, sharedExtent))
+      {
+      vtkOrientedImageDataResample::PadImageToContainImage(sharedLabelmap, labelmap, sharedLabelmap, unionExtent);
+      }
+    }
+
+  int maximumLabelValue = (sharedLabelmap->GetScalarType() == VTK_UNSIGNED_CHAR ? VTK_UNSIGNED_CHAR_MAX : VTK_UNSIGNED_SHORT_MAX);
+  std::vector<char> overwrittenLabels(maximumLabelValue + 1, 0);
+  int labelValue = segment->GetSharedLabelValue();
+  if (replace)
+    {
+    segment->ClearSharedLabel(sharedLabelmap->GetExtent());
+    }
+  if (IsExtentValid(writeExtent))
+    {
+    if (!WriteLabel(sharedLabelmap, labelmap, writeExtent, labelValue, overwrittenLabels))
+      {
+      vtkErrorMacro("SetBinaryLabelmapToSharedSegment: Unsupported scalar type");
+      }
+    }
+  sharedLabelmap->Modified();
+
+  // The modified segment and the segments that lost voxels
+  for (std::vector<std::string>::iterator segmentIdIt = sharedSegmentIds.begin(); segmentIdIt != sharedSegmentIds.end(); ++segmentIdIt)
+    {
+    vtkSegment* currentSegment = this->GetSegment(*segmentIdIt);
+    if (currentSegment == segment || overwrittenLabels[currentSegment->GetSharedLabelValue()])
+      {
+      modifiedSegmentIds.push_back(*segmentIdIt);
+      }
+    }
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 std::string vtkSegmentation::DetermineCommonLabelmapGeometry(int extentComputationMode, vtkStringArray* segmentIds)
 {
@@ -1473,7 +1925,12 @@ void vtkSegmentation::DetermineCommonLabelmapExtent(int commonGeometryExtent[6],
 
     int currentBinaryLabelmapExtent[6] = { 0, -1, 0, -1, 0, -1 };
     bool validExtent = true;
-    if (computeEffectiveExtent)
+    if (currentSegment->GetSharedLabelmap())
+      {
+      // The shared labelmap contains other segments as well
+      validExtent = currentSegment->GetSharedLabelExtent(currentBinaryLabelmapExtent);
+      }
+    else if (computeEffectiveExtent)
       {
       validExtent = vtkOrientedImageDataResample::CalculateEffectiveExtent(currentBinaryLabelmap, currentBinaryLabelmapExtent);
       }
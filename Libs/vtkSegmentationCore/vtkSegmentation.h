@@ -262,7 +262,8 @@ public:
   /// \return Vector of segments containing the requested tag
   std::vector<vtkSegment*> GetSegmentsByTag(std::string tag, std::string value="");
 
-  /// Get representation from segment
+  /// Get representation from segment. For segments that use a shared labelmap the binary labelmap
+  /// representation is the shared labelmap (\sa vtkSegment::GetRepresentation)
   vtkDataObject* GetSegmentRepresentation(std::string segmentId, std::string representationName);
 
   /// Copy segment from one segmentation to this one
@@ -273,6 +274,43 @@ public:
   /// \return Success flag
   bool CopySegmentFromSegmentation(vtkSegmentation* fromSegmentation, std::string segmentId, bool removeFromSource=false);
 
+// Shared labelmap related methods
+
+  /// Store binary labelmaps of non-overlapping segments in shared labelmaps. Each shared labelmap
+  /// contains a group of segments that do not overlap each other, with a different label value for each segment.
+  /// Only segments that have the same image lattice as the first non-empty segment are collapsed.
+  /// Only applicable if the master representation is binary labelmap.
+  /// The binary labelmap representation of each collapsed segment is replaced by its shared labelmap, so voxels
+  /// of the segment are not stored separately. \sa vtkSegment::ExtractBinaryLabelmapRepresentation gives the
+  /// binary labelmap of a single segment. RepresentationModified event is invoked for each collapsed segment.
+  /// Sharing is optional, it is not enabled automatically.
+  /// Shared labelmaps are kept when the segmentation is copied (\sa DeepCopy) and by \sa vtkSegmentationHistory.
+  /// Voxels of removed segments are cleared in the shared labelmap.
+  /// \return Number of shared labelmaps created
+  /// \sa vtkSegment::SetSharedLabelmap
+  int CollapseBinaryLabelmaps();
+
+  /// Store binary labelmap of each segment separately
+  void ExpandBinaryLabelmaps();
+
+#ifndef __VTK_WRAP__
+  /// Get IDs of all segments stored in the same shared labelmap as the given segment (including the given segment).
+  /// Empty if the segment does not use a shared labelmap.
+  void GetSegmentIDsSharingBinaryLabelmap(const std::string& segmentId, std::vector<std::string>& sharedSegmentIds);
+
+  /// Modify a segment stored in a shared labelmap by a single write into the shared labelmap.
+  /// Non-zero voxels of labelmap (within extent, if specified) are set to the segment, therefore these voxels
+  /// are removed from all other segments in the same shared labelmap.
+  /// Other representations of the modified segments are not converted.
+  /// Master representation modified events should be disabled by the caller.
+  /// \param replace If true, then voxels of the segment outside the non-zero voxels of labelmap are removed
+  /// \param modifiedSegmentIds IDs of segments whose voxels have changed
+  /// \return False if the segment does not use a shared labelmap or the labelmap geometry does not match it
+  /// \sa vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSharedSegment
+  bool SetBinaryLabelmapToSharedSegment(const std::string& segmentId, vtkOrientedImageData* labelmap, bool replace,
+    const int extent[6], std::vector<std::string>& modifiedSegmentIds);
+#endif // __VTK_WRAP__
+
 // Representation related methods
 
   /// Get representation names present in this segmentation in an output string vector
@@ -26,14 +26,17 @@
 #include "vtkSegmentationConverterRule.h"
 
 // VTK includes
+#include <vtkFieldData.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkMatrix4x4.h>
 #include <vtkImageData.h>
 #include <vtkTransform.h>
+#include <vtkTypeInt64Array.h>
 #include <vtkVariant.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 
 //----------------------------------------------------------------------------
@@ -561,3 +564,86 @@ void vtkSegmentationConverter::ApplyTransformOnReferenceImageGeometry(vtkAbstrac
   this->SetConversionParameter(
     vtkSegmentationConverter::GetReferenceImageGeometryParameterName(), newGeometryString );
 }
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConverter::SetModifiedExtent(vtkImageData* image, vtkMTimeType previousModifiedTime, const int modifiedExtent[6])
+{
+  if (!image || !modifiedExtent)
+    {
+    return;
+    }
+  // Record: modified extent, modified time before the first and after the last recorded modification
+  int extent[6] = { modifiedExtent[0], modifiedExtent[1], modifiedExtent[2], modifiedExtent[3], modifiedExtent[4], modifiedExtent[5] };
+  vtkMTimeType firstModifiedTime = previousModifiedTime;
+  vtkTypeInt64Array* previousRecord = vtkTypeInt64Array::SafeDownCast(
+    image->GetFieldData()->GetAbstractArray(vtkSegmentationConverter::GetModifiedExtentFieldName()));
+  if (previousRecord && previousRecord->GetNumberOfValues() == 8
+    && static_cast<vtkMTimeType>(previousRecord->GetValue(7)) == previousModifiedTime)
+    {
+    // The image has not changed since the previous recorded modification, merge the records
+    bool extentEmpty = (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5]);
+    bool previousExtentEmpty = (previousRecord->GetValue(0) > previousRecord->GetValue(1)
+      || previousRecord->GetValue(2) > previousRecord->GetValue(3) || previousRecord->GetValue(4) > previousRecord->GetValue(5));
+    for (int i = 0; i < 3; i++)
+      {
+      if (extentEmpty)
+        {
+        extent[i * 2] = static_cast<int>(previousRecord->GetValue(i * 2));
+        extent[i * 2 + 1] = static_cast<int>(previousRecord->GetValue(i * 2 + 1));
+        }
+      else if (!previousExtentEmpty)
+        {
+        extent[i * 2] = std::min(extent[i * 2], static_cast<int>(previousRecord->GetValue(i * 2)));
+        extent[i * 2 + 1] = std::max(extent[i * 2 + 1], static_cast<int>(previousRecord->GetValue(i * 2 + 1)));
+        }
+      }
+    firstModifiedTime = static_cast<vtkMTimeType>(previousRecord->GetValue(6));
+    }
+
+  vtkSmartPointer<vtkTypeInt64Array> record = vtkSmartPointer<vtkTypeInt64Array>::New();
+  record->SetName(vtkSegmentationConverter::GetModifiedExtentFieldName());
+  record->SetNumberOfValues(8);
+  for (int i = 0; i < 6; i++)
+    {
+    record->SetValue(i, extent[i]);
+    }
+  record->SetValue(6, static_cast<vtkTypeInt64>(firstModifiedTime));
+  record->SetValue(7, 0);
+  image->GetFieldData()->AddArray(record);
+  // Setting a value does not change the modified time, so the current time can be stored
+  record->SetValue(7, static_cast<vtkTypeInt64>(image->GetMTime()));
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentationConverter::GetModifiedExtent(vtkImageData* image, vtkMTimeType sinceModifiedTime, int modifiedExtent[6])
+{
+  if (!image || !image->GetFieldData())
+    {
+    return false;
+    }
+  vtkTypeInt64Array* record = vtkTypeInt64Array::SafeDownCast(
+    image->GetFieldData()->GetAbstractArray(vtkSegmentationConverter::GetModifiedExtentFieldName()));
+  if (!record || record->GetNumberOfValues() != 8)
+    {
+    return false;
+    }
+  vtkMTimeType firstModifiedTime = static_cast<vtkMTimeType>(record->GetValue(6));
+  vtkMTimeType lastModifiedTime = static_cast<vtkMTimeType>(record->GetValue(7));
+  if (lastModifiedTime != image->GetMTime() || sinceModifiedTime < firstModifiedTime || sinceModifiedTime > lastModifiedTime)
+    {
+    // The image has been modified without recording the modification,
+    // or the state at sinceModifiedTime is not covered by the record
+    return false;
+    }
+  for (int i = 0; i < 6; i++)
+    {
+    modifiedExtent[i] = static_cast<int>(record->GetValue(i));
+    }
+  if (sinceModifiedTime == lastModifiedTime)
+    {
+    // Not modified since then
+    modifiedExtent[0] = modifiedExtent[2] = modifiedExtent[4] = 0;
+    modifiedExtent[1] = modifiedExtent[3] = modifiedExtent[5] = -1;
+    }
+  return true;
+}
@@ -70,6 +70,8 @@ public:
   static const char* GetScalarRangeFieldName() {return "ScalarRange";};
   static const char* GetThresholdValueFieldName() {return "ThresholdValue";};
   static const char* GetInterpolationTypeFieldName() {return "InterpolationType";};
+  /// Field name of the record of the voxels modified in a binary labelmap, \sa SetModifiedExtent
+  static const char* GetModifiedExtentFieldName() {return "ModifiedExtent";};
 
 public:
   static vtkSegmentationConverter* New();
@@ -148,6 +150,16 @@ public:
   /// \return Success flag
   static bool DeserializeImageGeometry(std::string geometryString, vtkMatrix4x4* geometryMatrix, int extent[6]);
 
+  /// Record in the field data of an image that its voxels have only changed within modifiedExtent
+  /// since its modified time was previousModifiedTime. Must be called right after the modification.
+  /// If the previous modification was recorded as well then the two records are merged.
+  /// Conversion rules use the record to process only the modified part of the image.
+  static void SetModifiedExtent(vtkImageData* image, vtkMTimeType previousModifiedTime, const int modifiedExtent[6]);
+
+  /// Get the extent of the voxels that have changed in an image since its modified time was sinceModifiedTime.
+  /// \return False if the changes have not been recorded by SetModifiedExtent (then any voxel may have changed)
+  static bool GetModifiedExtent(vtkImageData* image, vtkMTimeType sinceModifiedTime, int modifiedExtent[6]);
+
 protected:
   /// Build a graph from ConverterRules list to facilitate faster finding of rules from a specific representation
   void RebuildRulesGraph();
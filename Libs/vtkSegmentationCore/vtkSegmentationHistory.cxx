@@ -22,11 +22,332 @@
 #include "vtkSegmentationHistory.h"
 #include "vtkSegmentationConverterFactory.h"
 #include "vtkSegmentation.h"
+#include "vtkOrientedImageData.h"
 
 // VTK includes
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkZLibDataCompressor.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+namespace
+{
+
+/// Delta chains are not extended beyond this length, the labelmap is stored in full instead.
+/// This bounds the time needed for reconstructing a labelmap.
+const int MAXIMUM_DELTA_CHAIN_LENGTH = 16;
+
+//----------------------------------------------------------------------------
+bool IsExtentEmpty(const int extent[6])
+{
+  return extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5];
+}
+
+//----------------------------------------------------------------------------
+size_t GetExtentSize(const int extent[6], int voxelSize)
+{
+  if (IsExtentEmpty(extent))
+    {
+    return 0;
+    }
+  return static_cast<size_t>(extent[1] - extent[0] + 1) * static_cast<size_t>(extent[3] - extent[2] + 1)
+    * static_cast<size_t>(extent[5] - extent[4] + 1) * static_cast<size_t>(voxelSize);
+}
+
+//----------------------------------------------------------------------------
+int GetVoxelSize(vtkImageData* image)
+{
+  return image->GetScalarSize() * image->GetNumberOfScalarComponents();
+}
+
+//----------------------------------------------------------------------------
+/// Returns true if the two images have the same extent, spacing, origin, and axis directions
+bool HaveSameGeometry(vtkOrientedImageData* image1, vtkOrientedImageData* image2)
+{
+  int* extent1 = image1->GetExtent();
+  int* extent2 = image2->GetExtent();
+  double* spacing1 = image1->GetSpacing();
+  double* spacing2 = image2->GetSpacing();
+  double* origin1 = image1->GetOrigin();
+  double* origin2 = image2->GetOrigin();
+  double directions1[3][3] = {{0.0}};
+  double directions2[3][3] = {{0.0}};
+  image1->GetDirections(directions1);
+  image2->GetDirections(directions2);
+  for (int i = 0; i < 3; ++i)
+    {
+    if (extent1[2 * i] != extent2[2 * i] || extent1[2 * i + 1] != extent2[2 * i + 1]
+      || spacing1[i] != spacing2[i] || origin1[i] != origin2[i])
+      {
+      return false;
+      }
+    for (int j = 0; j < 3; ++j)
+      {
+      if (directions1[i][j] != directions2[i][j])
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Computes the bounding box of the voxels that are different in the two images.
+/// The images must have the same extent and scalar type.
+/// \return False if the images are identical
+bool GetModifiedExtent(vtkImageData* image1, vtkImageData* image2, int modifiedExtent[6])
+{
+  int* extent = image1->GetExtent();
+  int voxelSize = GetVoxelSize(image1);
+  size_t rowSize = static_cast<size_t>(extent[1] - extent[0] + 1) * voxelSize;
+  bool modified = false;
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    for (int y = extent[2]; y <= extent[3]; ++y)
+      {
+      const char* row1 = static_cast<const char*>(image1->GetScalarPointer(extent[0], y, z));
+      const char* row2 = static_cast<const char*>(image2->GetScalarPointer(extent[0], y, z));
+      if (memcmp(row1, row2, rowSize) == 0)
+        {
+        continue;
+        }
+      size_t first = 0;
+      while (row1[first] == row2[first])
+        {
+        ++first;
+        }
+      size_t last = rowSize - 1;
+      while (row1[last] == row2[last])
+        {
+        --last;
+        }
+      int firstX = extent[0] + static_cast<int>(first / voxelSize);
+      int lastX = extent[0] + static_cast<int>(last / voxelSize);
+      if (!modified)
+        {
+        modifiedExtent[0] = firstX;
+        modifiedExtent[1] = lastX;
+        modifiedExtent[2] = y;
+        modifiedExtent[3] = y;
+        modifiedExtent[4] = z;
+        modified = true;
+        }
+      modifiedExtent[0] = std::min(modifiedExtent[0], firstX);
+      modifiedExtent[1] = std::max(modifiedExtent[1], lastX);
+      modifiedExtent[2] = std::min(modifiedExtent[2], y);
+      modifiedExtent[3] = std::max(modifiedExtent[3], y);
+      modifiedExtent[5] = z;
+      }
+    }
+  return modified;
+}
+
+//----------------------------------------------------------------------------
+/// Copies the voxels of extent to a contiguous buffer
+void CopyExtent(vtkImageData* image, const int extent[6], unsigned char* buffer)
+{
+  size_t rowSize = static_cast<size_t>(extent[1] - extent[0] + 1) * GetVoxelSize(image);
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    for (int y = extent[2]; y <= extent[3]; ++y)
+      {
+      memcpy(buffer, image->GetScalarPointer(extent[0], y, z), rowSize);
+      buffer += rowSize;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Copies the voxels of extent from a contiguous buffer
+void PasteExtent(const unsigned char* buffer, const int extent[6], vtkImageData* image)
+{
+  size_t rowSize = static_cast<size_t>(extent[1] - extent[0] + 1) * GetVoxelSize(image);
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    for (int y = extent[2]; y <= extent[3]; ++y)
+      {
+      memcpy(image->GetScalarPointer(extent[0], y, z), buffer, rowSize);
+      buffer += rowSize;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Returns a new array that has to be deleted
+vtkUnsignedCharArray* CompressScalars(const unsigned char* data, size_t size)
+{
+  vtkNew<vtkZLibDataCompressor> compressor;
+  compressor->SetCompressionLevel(1); // corresponds to Z_BEST_SPEED
+  return compressor->Compress(data, size);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+/// Labelmap representation stored in an undo state.
+///
+/// Only the voxels of ModifiedExtent are stored (compressed), the other voxels are the same
+/// as in Base. If there is no base then ModifiedExtent is the whole extent of the labelmap.
+class vtkSegmentationHistory::StoredLabelmap : public vtkObject
+{
+public:
+  static StoredLabelmap* New()
+    {
+    return new StoredLabelmap;
+    }
+  vtkTypeMacro(StoredLabelmap, vtkObject);
+
+  /// Extent, spacing, origin, and directions of the labelmap. Has no scalars.
+  vtkSmartPointer<vtkOrientedImageData> Geometry;
+  int ScalarType;
+  int NumberOfScalarComponents;
+
+  /// Stored labelmap this is a delta of, NULL if all voxels are stored
+  vtkSmartPointer<StoredLabelmap> Base;
+  /// Number of stored labelmaps that have to be applied to reconstruct this one
+  int DeltaChainLength;
+
+  int ModifiedExtent[6];
+  /// Size of the voxels of ModifiedExtent in bytes
+  size_t ScalarsSize;
+  /// Compressed voxels of ModifiedExtent
+  vtkSmartPointer<vtkUnsignedCharArray> CompressedScalars;
+  /// Voxels of ModifiedExtent that are waiting for compression
+  vtkSmartPointer<vtkDataArray> PendingScalars;
+
+  /// Uncompressed copy of the labelmap. It is kept for the latest stored labelmap of the segment
+  /// so that the next state can be computed without decompression. It may be released any time.
+  vtkSmartPointer<vtkOrientedImageData> Image;
+
+  //----------------------------------------------------------------------------
+  void Reconstruct(vtkOrientedImageData* output)
+    {
+    if (this->Image)
+      {
+      output->DeepCopy(this->Image);
+      return;
+      }
+    if (this->Base)
+      {
+      this->Base->Reconstruct(output);
+      }
+    else
+      {
+      output->DeepCopy(this->Geometry);
+      if (this->ScalarsSize == 0)
+        {
+        return;
+        }
+      output->AllocateScalars(this->ScalarType, this->NumberOfScalarComponents);
+      }
+    if (this->ScalarsSize == 0)
+      {
+      return;
+      }
+    if (this->PendingScalars)
+      {
+      PasteExtent(static_cast<unsigned char*>(this->PendingScalars->GetVoidPointer(0)), this->ModifiedExtent, output);
+      return;
+      }
+    vtkNew<vtkZLibDataCompressor> compressor;
+    if (this->Base)
+      {
+      std::vector<unsigned char> buffer(this->ScalarsSize);
+      compressor->Uncompress(this->CompressedScalars->GetPointer(0), this->CompressedScalars->GetNumberOfTuples(),
+        &buffer[0], this->ScalarsSize);
+      PasteExtent(&buffer[0], this->ModifiedExtent, output);
+      }
+    else
+      {
+      // All voxels are stored, decompress directly into the output
+      compressor->Uncompress(this->CompressedScalars->GetPointer(0), this->CompressedScalars->GetNumberOfTuples(),
+        static_cast<unsigned char*>(output->GetScalarPointer()), this->ScalarsSize);
+      }
+    }
+
+  //----------------------------------------------------------------------------
+  /// Store all voxels, so that this labelmap does not depend on earlier states anymore
+  void RemoveBase()
+    {
+    if (!this->Base)
+      {
+      return;
+      }
+    vtkSmartPointer<vtkOrientedImageData> image = this->Image;
+    if (!image)
+      {
+      image = vtkSmartPointer<vtkOrientedImageData>::New();
+      this->Reconstruct(image);
+      }
+    this->Base = NULL;
+    this->DeltaChainLength = 0;
+    image->GetExtent(this->ModifiedExtent);
+    this->ScalarsSize = GetExtentSize(this->ModifiedExtent, GetVoxelSize(image));
+    this->CompressedScalars.TakeReference(
+      CompressScalars(static_cast<unsigned char*>(image->GetScalarPointer()), this->ScalarsSize));
+    this->PendingScalars = NULL;
+    }
+
+  //----------------------------------------------------------------------------
+  /// Memory used by the labelmap and its bases, in kilobytes.
+  /// Objects in alreadyCounted are skipped, counted objects are added to it.
+  unsigned long GetMemorySize(std::set<vtkObject*>& alreadyCounted)
+    {
+    if (!alreadyCounted.insert(this).second)
+      {
+      return 0;
+      }
+    unsigned long size = 0;
+    if (this->CompressedScalars)
+      {
+      size += this->CompressedScalars->GetActualMemorySize();
+      }
+    if (this->PendingScalars && alreadyCounted.insert(this->PendingScalars).second)
+      {
+      size += this->PendingScalars->GetActualMemorySize();
+      }
+    if (this->Image && this->Image->GetPointData()->GetScalars()
+      && alreadyCounted.insert(this->Image->GetPointData()->GetScalars()).second)
+      {
+      size += this->Image->GetPointData()->GetScalars()->GetActualMemorySize();
+      }
+    if (this->Base)
+      {
+      size += this->Base->GetMemorySize(alreadyCounted);
+      }
+    return size;
+    }
+
+protected:
+  StoredLabelmap()
+    {
+    this->ScalarType = VTK_UNSIGNED_CHAR;
+    this->NumberOfScalarComponents = 1;
+    this->DeltaChainLength = 0;
+    this->ScalarsSize = 0;
+    for (int i = 0; i < 3; ++i)
+      {
+      this->ModifiedExtent[2 * i] = 0;
+      this->ModifiedExtent[2 * i + 1] = -1;
+      }
+    }
+  ~StoredLabelmap()
+    {
+    }
+
+private:
+  StoredLabelmap(const StoredLabelmap&);  // Not implemented.
+  void operator=(const StoredLabelmap&);  // Not implemented.
+};
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSegmentationHistory);
@@ -37,6 +358,10 @@ vtkSegmentationHistory::vtkSegmentationHistory()
   this->Segmentation = NULL;
 
   this->MaximumNumberOfStates = 5;
+  this->MaximumMemorySize = 0;
+
+  this->CompressionThreader = vtkMultiThreader::New();
+  this->CompressionThreadID = -1;
 
   this->LastRestoredState = 0;
   this->RestoreStateInProgress = false;
@@ -50,6 +375,12 @@ vtkSegmentationHistory::vtkSegmentationHistory()
 vtkSegmentationHistory::~vtkSegmentationHistory()
 {
   this->SetSegmentation(NULL);
+  this->WaitForCompression();
+  if (this->CompressionThreader)
+    {
+    this->CompressionThreader->Delete();
+    this->CompressionThreader = NULL;
+    }
 
   if (this->SegmentationModifiedCallbackCommand)
     {
@@ -95,6 +426,8 @@ void vtkSegmentationHistory::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Modified Time: " << this->GetMTime() << "\n";
 
   os << indent << "Number of saved states:  " << this->SegmentationStates.size() << "\n";
+  os << indent << "MaximumNumberOfStates:  " << this->MaximumNumberOfStates << "\n";
+  os << indent << "MaximumMemorySize:  " << this->MaximumMemorySize << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -112,9 +445,13 @@ bool vtkSegmentationHistory::SaveState()
     return false;
     }
 
+  // Baseline labelmaps are read and their uncompressed copies are modified
+  this->WaitForCompression();
   this->RemoveAllNextStates();
 
   SegmentationState newSegmentationState;
+  // Index of each shared labelmap in newSegmentationState.SharedLabelmaps
+  std::map<vtkOrientedImageData*, int> sharedLabelmapIndices;
 
   std::vector<std::string> segmentIDs;
   this->Segmentation->GetSegmentIDs(segmentIDs);
@@ -130,16 +467,56 @@ bool vtkSegmentationHistory::SaveState()
     // Previous saved state of the segment
     // (if the new state has exactly the same representation then only a shallow copy will be made)
     vtkSegment* baselineSegment = NULL;
+    LabelmapsMap* baselineLabelmaps = NULL;
     if (this->SegmentationStates.size() > 0)
       {
-      SegmentsMap::iterator baselineSegmentIt = this->SegmentationStates.back().Segments.find(*segmentIDIt);
-      if (baselineSegmentIt != this->SegmentationStates.back().Segments.end())
+      SegmentationState& baselineState = this->SegmentationStates.back();
+      SegmentsMap::iterator baselineSegmentIt = baselineState.Segments.find(*segmentIDIt);
+      if (baselineSegmentIt != baselineState.Segments.end())
         {
         baselineSegment = baselineSegmentIt->second.GetPointer();
         }
+      std::map<std::string, LabelmapsMap>::iterator baselineLabelmapsIt = baselineState.Labelmaps.find(*segmentIDIt);
+      if (baselineLabelmapsIt != baselineState.Labelmaps.end())
+        {
+        baselineLabelmaps = &(baselineLabelmapsIt->second);
+        }
+      }
+    vtkOrientedImageData* sharedLabelmap = segment->GetSharedLabelmap();
+    if (sharedLabelmap)
+      {
+      // The shared labelmap is stored once for all its segments
+      std::map<vtkOrientedImageData*, int>::iterator sharedIndexIt = sharedLabelmapIndices.find(sharedLabelmap);
+      int sharedIndex = 0;
+      if (sharedIndexIt != sharedLabelmapIndices.end())
+        {
+        sharedIndex = sharedIndexIt->second;
+        }
+      else
+        {
+        sharedIndex = static_cast<int>(newSegmentationState.SharedLabelmaps.size());
+        // Baseline is the same shared labelmap in the previous state
+        StoredLabelmap* baselineSharedLabelmap = NULL;
+        if (this->SegmentationStates.size() > 0)
+          {
+          SegmentationState& baselineState = this->SegmentationStates.back();
+          for (size_t baselineIndex = 0; baselineIndex < baselineState.SharedLabelmapSources.size(); ++baselineIndex)
+            {
+            if (baselineState.SharedLabelmapSources[baselineIndex].GetPointer() == sharedLabelmap)
+              {
+              baselineSharedLabelmap = baselineState.SharedLabelmaps[baselineIndex];
+              break;
+              }
+            }
+          }
+        newSegmentationState.SharedLabelmaps.push_back(this->StoreLabelmap(sharedLabelmap, baselineSharedLabelmap));
+        newSegmentationState.SharedLabelmapSources.push_back(sharedLabelmap);
+        sharedLabelmapIndices[sharedLabelmap] = sharedIndex;
+        }
+      newSegmentationState.SharedLabels[*segmentIDIt] = std::make_pair(sharedIndex, segment->GetSharedLabelValue());
       }
     vtkSmartPointer<vtkSegment> segmentClone = vtkSmartPointer<vtkSegment>::New();
-    CopySegment(segmentClone, segment, baselineSegment);
+    CopySegment(segmentClone, segment, baselineSegment, newSegmentationState.Labelmaps[*segmentIDIt], baselineLabelmaps);
     newSegmentationState.Segments[*segmentIDIt] = segmentClone;
     }
   this->SegmentationStates.push_back(newSegmentationState);
@@ -148,12 +525,51 @@ bool vtkSegmentationHistory::SaveState()
   this->LastRestoredState = this->SegmentationStates.size();
   this->RemoveAllObsoleteStates();
 
+  // Compress the modified voxels in the background
+  if (!this->CompressionQueue.empty())
+    {
+    this->CompressionThreadID = this->CompressionThreader->SpawnThread(
+      (vtkThreadFunctionType)&vtkSegmentationHistory::CompressionThreadFunction, this);
+    }
+
   this->Modified();
   return true;
 }
 
 //---------------------------------------------------------------------------
-void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline)
+VTK_THREAD_RETURN_TYPE vtkSegmentationHistory::CompressionThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkSegmentationHistory* self = static_cast<vtkSegmentationHistory*>(info->UserData);
+  for (std::vector<vtkSmartPointer<StoredLabelmap> >::iterator labelmapIt = self->CompressionQueue.begin();
+    labelmapIt != self->CompressionQueue.end(); ++labelmapIt)
+    {
+    StoredLabelmap* labelmap = *labelmapIt;
+    if (!labelmap->PendingScalars)
+      {
+      continue;
+      }
+    labelmap->CompressedScalars.TakeReference(CompressScalars(
+      static_cast<unsigned char*>(labelmap->PendingScalars->GetVoidPointer(0)), labelmap->ScalarsSize));
+    labelmap->PendingScalars = NULL;
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//---------------------------------------------------------------------------
+void vtkSegmentationHistory::WaitForCompression()
+{
+  if (this->CompressionThreadID >= 0)
+    {
+    this->CompressionThreader->TerminateThread(this->CompressionThreadID);
+    this->CompressionThreadID = -1;
+    this->CompressionQueue.clear();
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline,
+  LabelmapsMap& destinationLabelmaps, LabelmapsMap* baselineLabelmaps)
 {
   destination->RemoveAllRepresentations();
   destination->DeepCopyMetadata(source);
@@ -164,7 +580,28 @@ void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* so
   for (std::vector<std::string>::iterator representationNameIt = representationNames.begin();
     representationNameIt != representationNames.end(); ++representationNameIt)
     {
+    if (source->GetSharedLabelmap()
+      && *representationNameIt == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+      {
+      // Stored in the shared labelmap, it is not extracted
+      continue;
+      }
     vtkDataObject* sourceRepresentation = source->GetRepresentation(*representationNameIt);
+    vtkOrientedImageData* sourceLabelmap = vtkOrientedImageData::SafeDownCast(sourceRepresentation);
+    if (sourceLabelmap)
+      {
+      StoredLabelmap* baselineLabelmap = NULL;
+      if (baselineLabelmaps)
+        {
+        LabelmapsMap::iterator baselineLabelmapIt = baselineLabelmaps->find(*representationNameIt);
+        if (baselineLabelmapIt != baselineLabelmaps->end())
+          {
+          baselineLabelmap = baselineLabelmapIt->second;
+          }
+        }
+      destinationLabelmaps[*representationNameIt] = this->StoreLabelmap(sourceLabelmap, baselineLabelmap);
+      continue;
+      }
     vtkDataObject* baselineRepresentation = NULL;
     if (baseline)
       {
@@ -193,6 +630,80 @@ void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* so
     }
 }
 
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkSegmentationHistory::StoredLabelmap> vtkSegmentationHistory::StoreLabelmap(
+  vtkOrientedImageData* labelmap, StoredLabelmap* baseline)
+{
+  if (baseline && baseline->GetMTime() > labelmap->GetMTime())
+    {
+    // we already have an up-to-date copy in the baseline, so reuse that
+    return baseline;
+    }
+
+  vtkSmartPointer<StoredLabelmap> storedLabelmap = vtkSmartPointer<StoredLabelmap>::New();
+  storedLabelmap->Geometry = vtkSmartPointer<vtkOrientedImageData>::New();
+  storedLabelmap->Geometry->SetExtent(labelmap->GetExtent());
+  storedLabelmap->Geometry->SetSpacing(labelmap->GetSpacing());
+  storedLabelmap->Geometry->SetOrigin(labelmap->GetOrigin());
+  storedLabelmap->Geometry->CopyDirections(labelmap);
+
+  vtkDataArray* scalars = labelmap->GetPointData()->GetScalars();
+  if (!scalars || IsExtentEmpty(labelmap->GetExtent())
+    || scalars->GetNumberOfTuples() < labelmap->GetNumberOfPoints())
+    {
+    // No voxels to store
+    return storedLabelmap;
+    }
+  storedLabelmap->ScalarType = scalars->GetDataType();
+  storedLabelmap->NumberOfScalarComponents = scalars->GetNumberOfComponents();
+
+  if (baseline && baseline->ScalarsSize > 0
+    && baseline->ScalarType == storedLabelmap->ScalarType
+    && baseline->NumberOfScalarComponents == storedLabelmap->NumberOfScalarComponents
+    && baseline->DeltaChainLength < MAXIMUM_DELTA_CHAIN_LENGTH
+    && HaveSameGeometry(baseline->Geometry, labelmap))
+    {
+    // Only store the voxels that are different from baseline
+    vtkSmartPointer<vtkOrientedImageData> baselineImage = baseline->Image;
+    if (!baselineImage)
+      {
+      baselineImage = vtkSmartPointer<vtkOrientedImageData>::New();
+      baseline->Reconstruct(baselineImage);
+      }
+    if (!GetModifiedExtent(labelmap, baselineImage, storedLabelmap->ModifiedExtent))
+      {
+      // Voxels have not changed, reuse baseline and mark it up-to-date
+      baseline->Image = baselineImage;
+      baseline->Modified();
+      return baseline;
+      }
+    storedLabelmap->Base = baseline;
+    storedLabelmap->DeltaChainLength = baseline->DeltaChainLength + 1;
+    storedLabelmap->ScalarsSize = GetExtentSize(storedLabelmap->ModifiedExtent, GetVoxelSize(labelmap));
+    vtkSmartPointer<vtkUnsignedCharArray> modifiedScalars = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    modifiedScalars->SetNumberOfValues(storedLabelmap->ScalarsSize);
+    CopyExtent(labelmap, storedLabelmap->ModifiedExtent, modifiedScalars->GetPointer(0));
+    storedLabelmap->PendingScalars = modifiedScalars;
+
+    // Update the uncompressed copy and hand it over to the new latest labelmap
+    PasteExtent(modifiedScalars->GetPointer(0), storedLabelmap->ModifiedExtent, baselineImage);
+    storedLabelmap->Image = baselineImage;
+    baseline->Image = NULL;
+    }
+  else
+    {
+    // Store all voxels
+    storedLabelmap->Image = vtkSmartPointer<vtkOrientedImageData>::New();
+    storedLabelmap->Image->DeepCopy(labelmap);
+    labelmap->GetExtent(storedLabelmap->ModifiedExtent);
+    storedLabelmap->ScalarsSize = GetExtentSize(storedLabelmap->ModifiedExtent, GetVoxelSize(labelmap));
+    storedLabelmap->PendingScalars = storedLabelmap->Image->GetPointData()->GetScalars();
+    }
+
+  this->CompressionQueue.push_back(storedLabelmap);
+  return storedLabelmap;
+}
+
 //---------------------------------------------------------------------------
 bool vtkSegmentationHistory::RestorePreviousState()
 {
@@ -243,26 +754,55 @@ bool vtkSegmentationHistory::RestoreNextState()
 //---------------------------------------------------------------------------
 bool vtkSegmentationHistory::RestoreState(unsigned int stateIndex)
 {
+  // Labelmaps may be waiting for compression
+  this->WaitForCompression();
+
   this->RestoreStateInProgress = true;
 
   SegmentationState restoredState = this->SegmentationStates[stateIndex];
 
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > sharedLabelmaps;
+  for (std::vector<vtkSmartPointer<StoredLabelmap> >::iterator sharedLabelmapIt = restoredState.SharedLabelmaps.begin();
+    sharedLabelmapIt != restoredState.SharedLabelmaps.end(); ++sharedLabelmapIt)
+    {
+    vtkSmartPointer<vtkOrientedImageData> sharedLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    (*sharedLabelmapIt)->Reconstruct(sharedLabelmap);
+    sharedLabelmaps.push_back(sharedLabelmap);
+    }
+  // Restored shared labelmaps are stored as a delta if this state is the baseline of the next saved state
+  this->SegmentationStates[stateIndex].SharedLabelmapSources.assign(sharedLabelmaps.begin(), sharedLabelmaps.end());
+
   std::set<std::string> segmentIDsToKeep;
   for (SegmentsMap::iterator restoredSegmentsIt = restoredState.Segments.begin();
     restoredSegmentsIt != restoredState.Segments.end(); ++restoredSegmentsIt)
     {
     segmentIDsToKeep.insert(restoredSegmentsIt->first);
-    vtkSegment* segment = this->Segmentation->GetSegment(restoredSegmentsIt->first);
-    if (segment != NULL)
+    vtkSmartPointer<vtkSegment> segment = this->Segmentation->GetSegment(restoredSegmentsIt->first);
+    bool newSegment = (segment.GetPointer() == NULL);
+    if (newSegment)
       {
-      segment->DeepCopy(restoredSegmentsIt->second);
-      segment->Modified();
+      segment = vtkSmartPointer<vtkSegment>::New();
+      }
+    segment->DeepCopy(restoredSegmentsIt->second);
+    LabelmapsMap& labelmaps = restoredState.Labelmaps[restoredSegmentsIt->first];
+    for (LabelmapsMap::iterator labelmapIt = labelmaps.begin(); labelmapIt != labelmaps.end(); ++labelmapIt)
+      {
+      vtkSmartPointer<vtkOrientedImageData> labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      labelmapIt->second->Reconstruct(labelmap);
+      segment->AddRepresentation(labelmapIt->first, labelmap);
+      }
+    std::map<std::string, std::pair<int, int> >::iterator sharedLabelIt = restoredState.SharedLabels.find(restoredSegmentsIt->first);
+    if (sharedLabelIt != restoredState.SharedLabels.end())
+      {
+      segment->SetSharedLabelmap(sharedLabelmaps[sharedLabelIt->second.first], sharedLabelIt->second.second);
+      }
+    if (newSegment)
+      {
+      this->Segmentation->AddSegment(segment);
       }
     else
       {
-      vtkSmartPointer<vtkSegment> newSegment = vtkSmartPointer<vtkSegment>::New();
-      newSegment->DeepCopy(restoredSegmentsIt->second);
-      this->Segmentation->AddSegment(newSegment);
+      segment->Modified();
       }
     }
 
@@ -325,6 +865,7 @@ void vtkSegmentationHistory::RemoveAllNextStates()
 //---------------------------------------------------------------------------
 void vtkSegmentationHistory::RemoveAllObsoleteStates()
 {
+  this->WaitForCompression();
   bool modified = false;
   while ((this->SegmentationStates.size() > this->MaximumNumberOfStates) && (!this->SegmentationStates.empty()))
     {
@@ -332,6 +873,52 @@ void vtkSegmentationHistory::RemoveAllObsoleteStates()
     this->LastRestoredState--;
     modified = true;
    }
+  if (this->MaximumMemorySize > 0 && this->GetMemorySize() > this->MaximumMemorySize)
+    {
+    // Uncompressed copies only make saving faster, release them first
+    for (std::deque<SegmentationState>::iterator stateIt = this->SegmentationStates.begin();
+      stateIt != this->SegmentationStates.end(); ++stateIt)
+      {
+      for (std::map<std::string, LabelmapsMap>::iterator segmentIt = stateIt->Labelmaps.begin();
+        segmentIt != stateIt->Labelmaps.end(); ++segmentIt)
+        {
+        for (LabelmapsMap::iterator labelmapIt = segmentIt->second.begin(); labelmapIt != segmentIt->second.end(); ++labelmapIt)
+          {
+          labelmapIt->second->Image = NULL;
+          }
+        }
+      for (std::vector<vtkSmartPointer<StoredLabelmap> >::iterator sharedLabelmapIt = stateIt->SharedLabelmaps.begin();
+        sharedLabelmapIt != stateIt->SharedLabelmaps.end(); ++sharedLabelmapIt)
+        {
+        (*sharedLabelmapIt)->Image = NULL;
+        }
+      }
+    while (this->SegmentationStates.size() > 1 && this->GetMemorySize() > this->MaximumMemorySize)
+      {
+      this->SegmentationStates.pop_front();
+      if (this->LastRestoredState > 0)
+        {
+        this->LastRestoredState--;
+        }
+      modified = true;
+      // Labelmaps of the oldest state must not depend on removed states,
+      // otherwise memory of the removed states would not be released.
+      SegmentationState& oldestState = this->SegmentationStates.front();
+      for (std::map<std::string, LabelmapsMap>::iterator segmentIt = oldestState.Labelmaps.begin();
+        segmentIt != oldestState.Labelmaps.end(); ++segmentIt)
+        {
+        for (LabelmapsMap::iterator labelmapIt = segmentIt->second.begin(); labelmapIt != segmentIt->second.end(); ++labelmapIt)
+          {
+          labelmapIt->second->RemoveBase();
+          }
+        }
+      for (std::vector<vtkSmartPointer<StoredLabelmap> >::iterator sharedLabelmapIt = oldestState.SharedLabelmaps.begin();
+        sharedLabelmapIt != oldestState.SharedLabelmaps.end(); ++sharedLabelmapIt)
+        {
+        (*sharedLabelmapIt)->RemoveBase();
+        }
+      }
+    }
   if (modified)
     {
     this->Modified();
@@ -350,6 +937,58 @@ void vtkSegmentationHistory::SetMaximumNumberOfStates(unsigned int maximumNumber
   this->Modified();
 }
 
+//---------------------------------------------------------------------------
+void vtkSegmentationHistory::SetMaximumMemorySize(unsigned long maximumMemorySizeKiB)
+{
+  if (maximumMemorySizeKiB == this->MaximumMemorySize)
+    {
+    return;
+    }
+  this->MaximumMemorySize = maximumMemorySizeKiB;
+  this->RemoveAllObsoleteStates();
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+unsigned long vtkSegmentationHistory::GetMemorySize()
+{
+  this->WaitForCompression();
+  std::set<vtkObject*> alreadyCounted;
+  unsigned long size = 0;
+  for (std::deque<SegmentationState>::iterator stateIt = this->SegmentationStates.begin();
+    stateIt != this->SegmentationStates.end(); ++stateIt)
+    {
+    for (SegmentsMap::iterator segmentIt = stateIt->Segments.begin(); segmentIt != stateIt->Segments.end(); ++segmentIt)
+      {
+      std::vector<std::string> representationNames;
+      segmentIt->second->GetContainedRepresentationNames(representationNames);
+      for (std::vector<std::string>::iterator representationNameIt = representationNames.begin();
+        representationNameIt != representationNames.end(); ++representationNameIt)
+        {
+        vtkDataObject* representation = segmentIt->second->GetRepresentation(*representationNameIt);
+        if (representation && alreadyCounted.insert(representation).second)
+          {
+          size += representation->GetActualMemorySize();
+          }
+        }
+      }
+    for (std::map<std::string, LabelmapsMap>::iterator segmentIt = stateIt->Labelmaps.begin();
+      segmentIt != stateIt->Labelmaps.end(); ++segmentIt)
+      {
+      for (LabelmapsMap::iterator labelmapIt = segmentIt->second.begin(); labelmapIt != segmentIt->second.end(); ++labelmapIt)
+        {
+        size += labelmapIt->second->GetMemorySize(alreadyCounted);
+        }
+      }
+    for (std::vector<vtkSmartPointer<StoredLabelmap> >::iterator sharedLabelmapIt = stateIt->SharedLabelmaps.begin();
+      sharedLabelmapIt != stateIt->SharedLabelmaps.end(); ++sharedLabelmapIt)
+      {
+      size += (*sharedLabelmapIt)->GetMemorySize(alreadyCounted);
+      }
+    }
+  return size;
+}
+
 //---------------------------------------------------------------------------
 void vtkSegmentationHistory::OnSegmentationModified(vtkObject* vtkNotUsed(caller),
   unsigned long vtkNotUsed(eid),
@@ -378,6 +1017,7 @@ void vtkSegmentationHistory::OnSegmentationModified(vtkObject* vtkNotUsed(caller
 //---------------------------------------------------------------------------
 void vtkSegmentationHistory::RemoveAllStates()
 {
+  this->WaitForCompression();
   this->SegmentationStates.clear();
   this->LastRestoredState = 0;
   this->Modified();
@@ -24,6 +24,8 @@
 // VTK includes
 #include <vtkObject.h>
 #include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+#include <vtkMultiThreader.h>
 
 // STD includes
 #include <deque>
@@ -33,10 +35,18 @@
 #include "vtkSegmentationCoreConfigure.h"
 
 class vtkCallbackCommand;
+class vtkOrientedImageData;
 class vtkSegment;
 class vtkSegmentation;
 
 /// \ingroup SegmentationCore
+/// \brief Undo/redo history of a segmentation.
+///
+/// Labelmap representations are stored compressed. When a labelmap is changed only in a small
+/// region (e.g., by a paint stroke), only the modified extent is stored, as a delta over the
+/// labelmap of the previous state. Representations that did not change are shared between states.
+/// Compression runs on a background thread, so SaveState returns as soon as the modified voxels
+/// are copied.
 class vtkSegmentationCore_EXPORT vtkSegmentationHistory : public vtkObject
 {
 public:
@@ -82,6 +92,18 @@ public:
   /// Get the limit of how many states may be stored.
   vtkGetMacro(MaximumNumberOfStates, unsigned int);
 
+  /// Limits how much memory (in kilobytes) the stored states may use. 0 means no limit.
+  /// If the limit is exceeded then the oldest states are removed. The last saved state is always kept.
+  /// Default is 0.
+  void SetMaximumMemorySize(unsigned long maximumMemorySizeKiB);
+
+  /// Get the limit of memory (in kilobytes) the stored states may use.
+  vtkGetMacro(MaximumMemorySize, unsigned long);
+
+  /// Get the memory (in kilobytes) used by the stored states.
+  /// Data shared between states is only counted once.
+  unsigned long GetMemorySize();
+
 protected:
   /// Callback function called when the segmentation has been modified.
   /// It clears all states that are more recent than the last restored state.
@@ -91,8 +113,12 @@ protected:
   void RemoveAllNextStates();
 
   /// Delete all old states so that we keep only up to MaximumNumberOfStates states
+  /// and the memory used does not exceed MaximumMemorySize
   void RemoveAllObsoleteStates();
 
+  /// Wait until the background compression of the last saved state is completed
+  void WaitForCompression();
+
   /// Restores a state defined by stateIndex.
   bool RestoreState(unsigned int stateIndex);
 
@@ -101,23 +127,50 @@ protected:
   ~vtkSegmentationHistory();
   void operator=(const vtkSegmentationHistory&);
 
+  /// Labelmap representation stored in compressed form. Defined in the implementation file.
+  class StoredLabelmap;
+  /// Container type for stored labelmaps. Maps representation names to stored labelmaps
+  typedef std::map<std::string, vtkSmartPointer<StoredLabelmap> > LabelmapsMap;
+
   /// Deep copies source segment to destination segment. If the same representation is found in baseline
   /// with up-to-date timestamp then the representation is reused from baseline.
-  void CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline);
+  /// Labelmap representations are not added to the destination segment but stored in destinationLabelmaps,
+  /// as a delta over the corresponding labelmap in baselineLabelmaps if possible.
+  /// Binary labelmap representation of a segment that uses a shared labelmap is not copied,
+  /// the shared labelmap is stored instead.
+  void CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline,
+    LabelmapsMap& destinationLabelmaps, LabelmapsMap* baselineLabelmaps);
+
+  /// Store a labelmap. Uses baseline if the labelmap is not modified since baseline was stored,
+  /// stores the modified extent only if baseline has the same geometry.
+  vtkSmartPointer<StoredLabelmap> StoreLabelmap(vtkOrientedImageData* labelmap, StoredLabelmap* baseline);
+
+  /// Compresses the scalars of the stored labelmaps that are waiting for compression.
+  static VTK_THREAD_RETURN_TYPE CompressionThreadFunction(void* arg);
 
 protected:  /// Container type for segments. Maps segment IDs to segment objects
   typedef std::map<std::string, vtkSmartPointer<vtkSegment> > SegmentsMap;
 
   struct SegmentationState
     {
-    SegmentsMap Segments;
+    SegmentsMap Segments; // segments without labelmap representations
+    std::map<std::string, LabelmapsMap> Labelmaps; // labelmap representations of each segment
     std::vector<std::string> SegmentIds; // order of segments
+    std::vector<vtkSmartPointer<StoredLabelmap> > SharedLabelmaps; // shared binary labelmaps
+    std::vector<vtkWeakPointer<vtkOrientedImageData> > SharedLabelmapSources; // labelmaps SharedLabelmaps were stored from
+    std::map<std::string, std::pair<int, int> > SharedLabels; // index in SharedLabelmaps and label value of each segment using a shared labelmap
     };
 
   vtkSegmentation* Segmentation;
   vtkCallbackCommand* SegmentationModifiedCallbackCommand;
   std::deque<SegmentationState> SegmentationStates;
   unsigned int MaximumNumberOfStates;
+  unsigned long MaximumMemorySize;
+
+  /// Labelmaps of the last saved state that are compressed by the background thread
+  std::vector<vtkSmartPointer<StoredLabelmap> > CompressionQueue;
+  vtkMultiThreader* CompressionThreader;
+  int CompressionThreadID;
 
   // Index of the state in SegmentationStates that was restored last.
   // If index == size of states then it means that the segmentation has changed
@@ -0,0 +1,274 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkDiffusionTensorEigensystemCache.h>
+#include <vtkDiffusionTensorMathematics.h>
+
+// VTK includes
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Random symmetric tensor with DTI-like eigenvalues. Some tensors have
+// repeated eigenvalues, which are the difficult cases for closed-form solvers.
+void RandomTensor(int index, float tensor[9])
+{
+  double l[3] = { vtkMath::Random(0.5e-3, 2e-3), vtkMath::Random(0.1e-3, 1e-3), vtkMath::Random(0.0, 0.5e-3) };
+  if (index % 4 == 1)
+    {
+    l[1] = l[0];
+    }
+  else if (index % 4 == 2)
+    {
+    l[2] = l[1];
+    }
+  // random rotation
+  double axis0[3] = { vtkMath::Random(-1, 1), vtkMath::Random(-1, 1), vtkMath::Random(-1, 1) };
+  double axis1[3] = { 0.0, 0.0, 0.0 };
+  double axis2[3] = { 0.0, 0.0, 0.0 };
+  vtkMath::Normalize(axis0);
+  vtkMath::Perpendiculars(axis0, axis1, axis2, vtkMath::Random(0, vtkMath::Pi()));
+  double* axes[3] = { axis0, axis1, axis2 };
+  for (int i = 0; i < 3; i++)
+    {
+    for (int j = 0; j < 3; j++)
+      {
+      tensor[3*i+j] = static_cast<float>(
+        l[0]*axes[0][i]*axes[0][j] + l[1]*axes[1][i]*axes[1][j] + l[2]*axes[2][i]*axes[2][j]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool CheckEigensystem(const float tensor[9], const double w[3], double v[3][3], double tolerance)
+{
+  if (w[0] < w[1] || w[1] < w[2])
+    {
+    std::cerr << "Eigenvalues are not sorted: " << w[0] << " " << w[1] << " " << w[2] << std::endl;
+    return false;
+    }
+  for (int c = 0; c < 3; c++)
+    {
+    // residual of A v = w v
+    for (int i = 0; i < 3; i++)
+      {
+      double residual = tensor[3*i]*v[0][c] + tensor[3*i+1]*v[1][c] + tensor[3*i+2]*v[2][c] - w[c]*v[i][c];
+      if (fabs(residual) > tolerance)
+        {
+        std::cerr << "Eigenvector " << c << " residual is too large: " << residual << std::endl;
+        return false;
+        }
+      }
+    // orthonormality
+    for (int d = 0; d < 3; d++)
+      {
+      double dot = v[0][c]*v[0][d] + v[1][c]*v[1][d] + v[2][c]*v[2][d];
+      if (fabs(dot - (c == d ? 1.0 : 0.0)) > 1e-5)
+        {
+        std::cerr << "Eigenvectors " << c << " and " << d << " are not orthonormal: " << dot << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorEigensystemCacheTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  const int numberOfTensors = 10000;
+  vtkNew<vtkFloatArray> tensors;
+  tensors->SetNumberOfComponents(9);
+  tensors->SetNumberOfTuples(numberOfTensors);
+  vtkMath::RandomSeed(1);
+  for (int tensorId = 0; tensorId < numberOfTensors; tensorId++)
+    {
+    RandomTensor(tensorId, tensors->GetPointer(9*tensorId));
+    }
+
+  // Closed-form eigensolver gives the same eigenvalues as teem
+  double m0[3], m1[3], m2[3], v0[3], v1[3], v2[3];
+  double *m[3] = { m0, m1, m2 };
+  double *v[3] = { v0, v1, v2 };
+  double w[3], teemW[3];
+  for (int tensorId = 0; tensorId < numberOfTensors; tensorId++)
+    {
+    float* tensor = tensors->GetPointer(9*tensorId);
+    for (int i = 0; i < 9; i++)
+      {
+      m[i/3][i%3] = tensor[i];
+      }
+    vtkDiffusionTensorMathematics::TeemEigenSolver(m, teemW, v);
+    vtkDiffusionTensorMathematics::ClosedFormEigenSolver(m, w, v);
+    for (int i = 0; i < 3; i++)
+      {
+      if (fabs(w[i] - teemW[i]) > 1e-9)
+        {
+        std::cerr << "Eigenvalue " << i << " of tensor " << tensorId << " is " << w[i]
+                  << ", teem eigenvalue is " << teemW[i] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    double eigenvectors[3][3] = { { v0[0], v0[1], v0[2] }, { v1[0], v1[1], v1[2] }, { v2[0], v2[1], v2[2] } };
+    if (!CheckEigensystem(tensor, w, eigenvectors, 1e-9))
+      {
+      std::cerr << "Invalid eigensystem for tensor " << tensorId << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Cache is computed once and matches the closed-form eigensolver
+  if (vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors.GetPointer()) != NULL)
+    {
+    std::cerr << "Cache should not exist before it is requested" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkDiffusionTensorEigensystemCache* cache = vtkDiffusionTensorEigensystemCache::GetCache(tensors.GetPointer());
+  if (cache == NULL || cache->GetNumberOfTensors() != numberOfTensors
+    || vtkDiffusionTensorEigensystemCache::GetCache(tensors.GetPointer()) != cache
+    || vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors.GetPointer()) != cache)
+    {
+    std::cerr << "Cache is not reused" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int tensorId = 0; tensorId < numberOfTensors; tensorId++)
+    {
+    const float* cachedW = cache->GetEigenvalues(tensorId);
+    const float* cachedV = cache->GetEigenvectors(tensorId);
+    double cachedEigenvalues[3] = { cachedW[0], cachedW[1], cachedW[2] };
+    double cachedEigenvectors[3][3] =
+      {
+      { cachedV[0], cachedV[1], cachedV[2] },
+      { cachedV[3], cachedV[4], cachedV[5] },
+      { cachedV[6], cachedV[7], cachedV[8] }
+      };
+    if (!CheckEigensystem(tensors->GetPointer(9*tensorId), cachedEigenvalues, cachedEigenvectors, 1e-8))
+      {
+      std::cerr << "Invalid cached eigensystem for tensor " << tensorId << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Cache is updated when the tensors are modified
+  float* tensor = tensors->GetPointer(0);
+  for (int i = 0; i < 9; i++)
+    {
+    tensor[i] = (i % 4 == 0 ? 1e-3f : 0.f);
+    }
+  tensor[8] = 2e-3f;
+  tensors->Modified();
+  if (vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors.GetPointer()) != NULL)
+    {
+    std::cerr << "Cache is not invalidated by modifying the tensors" << std::endl;
+    return EXIT_FAILURE;
+    }
+  cache = vtkDiffusionTensorEigensystemCache::GetCache(tensors.GetPointer());
+  if (fabs(cache->GetEigenvalues(0)[0] - 2e-3) > 1e-9 || fabs(fabs(cache->GetEigenvectors(0)[8]) - 1.0) > 1e-6)
+    {
+    std::cerr << "Cache is not updated: max eigenvalue is " << cache->GetEigenvalues(0)[0] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Filter output is the same with and without eigensystem cache
+  vtkNew<vtkImageData> tensorImage;
+  tensorImage->SetDimensions(100, 100, 1);
+  tensorImage->GetPointData()->SetTensors(tensors.GetPointer());
+  vtkNew<vtkDiffusionTensorMathematics> filter;
+  filter->SetInputData(tensorImage.GetPointer());
+  filter->SetOperationToFractionalAnisotropy();
+  filter->Update();
+  vtkNew<vtkFloatArray> faWithCache;
+  faWithCache->DeepCopy(filter->GetOutput()->GetPointData()->GetScalars());
+
+  vtkDiffusionTensorEigensystemCache::RemoveCache(tensors.GetPointer());
+  for (int tensorId = 0; tensorId < numberOfTensors; tensorId++)
+    {
+    float* t = tensors->GetPointer(9*tensorId);
+    for (int i = 0; i < 9; i++)
+      {
+      m[i/3][i%3] = t[i];
+      }
+    vtkDiffusionTensorMathematics::TeemEigenSolver(m, teemW, v);
+    double fa = vtkDiffusionTensorMathematics::FractionalAnisotropy(teemW);
+    if (fabs(fa - faWithCache->GetValue(tensorId)) > 1e-4)
+      {
+      std::cerr << "FA of tensor " << tensorId << " is " << faWithCache->GetValue(tensorId)
+                << ", expected " << fa << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Cache requested by the filter is invalidated when only the image is marked as modified
+  filter->Modified();
+  filter->Update();
+  if (vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors.GetPointer(), tensorImage.GetPointer()) == NULL)
+    {
+    std::cerr << "Filter does not cache the eigensystem" << std::endl;
+    return EXIT_FAILURE;
+    }
+  tensorImage->Modified();
+  if (vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors.GetPointer(), tensorImage.GetPointer()) != NULL)
+    {
+    std::cerr << "Cache is not invalidated by modifying the image" << std::endl;
+    return EXIT_FAILURE;
+    }
+  filter->Update();
+  if (vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors.GetPointer(), tensorImage.GetPointer()) == NULL)
+    {
+    std::cerr << "Cache is not recomputed after modifying the image" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Cache is dropped with the output of the filter
+  filter->ReleaseDataFlagOn();
+  filter->Modified();
+  filter->Update();
+  if (vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors.GetPointer()) != NULL)
+    {
+    std::cerr << "Cache is not released with the filter output" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Cache is dropped with the filter
+    {
+    vtkNew<vtkDiffusionTensorMathematics> scopedFilter;
+    scopedFilter->SetInputData(tensorImage.GetPointer());
+    scopedFilter->SetOperationToMode();
+    scopedFilter->Update();
+    if (vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors.GetPointer()) == NULL)
+      {
+      std::cerr << "Filter does not cache the eigensystem" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors.GetPointer()) != NULL)
+    {
+    std::cerr << "Cache is not released with the filter" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+// vtkTeem includes
+#include <vtkDiffusionTensorGlyph.h>
+
+// VTK includes
+#include <vtkArrowSource.h>
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Random symmetric positive definite tensors on a 4x3 slice
+void CreateTensorImage(vtkImageData* image)
+{
+  image->SetDimensions(4, 3, 1);
+  image->SetSpacing(1.5, 2.0, 1.0);
+  vtkNew<vtkFloatArray> tensors;
+  tensors->SetNumberOfComponents(9);
+  tensors->SetNumberOfTuples(image->GetNumberOfPoints());
+  vtkMath::RandomSeed(42);
+  for (vtkIdType tensorId = 0; tensorId < image->GetNumberOfPoints(); tensorId++)
+    {
+    double m[3][3];
+    for (int i = 0; i < 3; i++)
+      {
+      for (int j = 0; j < 3; j++)
+        {
+        m[i][j] = vtkMath::Random(-1.0, 1.0);
+        }
+      }
+    float* tensor = tensors->GetPointer(9*tensorId);
+    for (int i = 0; i < 3; i++)
+      {
+      for (int j = 0; j < 3; j++)
+        {
+        // M * M^T + I, scaled to typical diffusivities
+        double value = m[i][0]*m[j][0] + m[i][1]*m[j][1] + m[i][2]*m[j][2] + (i == j ? 0.1 : 0.0);
+        tensor[3*i+j] = static_cast<float>(value * 1e-3);
+        }
+      }
+    }
+  image->GetPointData()->SetTensors(tensors.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+/// Place the glyph source at each instance the same way as vtkGlyph3DMapper
+/// (ROTATION orientation mode, SCALE_BY_VECTORCOMPONENTS scale mode) and compare
+/// it with the glyph geometry.
+bool CompareInstancesWithGlyphs(vtkPolyData* instances, vtkPolyData* glyphs, vtkPolyData* source)
+{
+  vtkIdType numberOfInstances = instances->GetNumberOfPoints();
+  vtkIdType numberOfSourcePoints = source->GetNumberOfPoints();
+  if (numberOfInstances == 0 || glyphs->GetNumberOfPoints() != numberOfInstances * numberOfSourcePoints)
+    {
+    std::cerr << "Number of glyph points " << glyphs->GetNumberOfPoints() << " does not match "
+              << numberOfInstances << " instances of " << numberOfSourcePoints << " points" << std::endl;
+    return false;
+    }
+  vtkDataArray* scales = instances->GetPointData()->GetArray(vtkDiffusionTensorGlyph::GetGlyphScaleArrayName());
+  vtkDataArray* orientations = instances->GetPointData()->GetArray(vtkDiffusionTensorGlyph::GetGlyphOrientationArrayName());
+  if (!scales || !orientations)
+    {
+    std::cerr << "Missing instance scale or orientation" << std::endl;
+    return false;
+    }
+  for (vtkIdType instanceId = 0; instanceId < numberOfInstances; instanceId++)
+    {
+    double position[3];
+    double scale[3];
+    double orientation[3];
+    instances->GetPoint(instanceId, position);
+    scales->GetTuple(instanceId, scale);
+    orientations->GetTuple(instanceId, orientation);
+    vtkNew<vtkTransform> transform;
+    transform->Translate(position);
+    transform->RotateZ(orientation[2]);
+    transform->RotateX(orientation[0]);
+    transform->RotateY(orientation[1]);
+    transform->Scale(scale);
+    for (vtkIdType sourcePointId = 0; sourcePointId < numberOfSourcePoints; sourcePointId++)
+      {
+      double instancePoint[3];
+      double glyphPoint[3];
+      transform->TransformPoint(source->GetPoint(sourcePointId), instancePoint);
+      glyphs->GetPoint(instanceId * numberOfSourcePoints + sourcePointId, glyphPoint);
+      if (sqrt(vtkMath::Distance2BetweenPoints(instancePoint, glyphPoint)) > 1e-3)
+        {
+        std::cerr << "Point " << sourcePointId << " of instance " << instanceId << " is ("
+                  << instancePoint[0] << ", " << instancePoint[1] << ", " << instancePoint[2]
+                  << "), glyph point is (" << glyphPoint[0] << ", " << glyphPoint[1] << ", "
+                  << glyphPoint[2] << ")" << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CompareGlyphFilters(vtkDiffusionTensorGlyph* glyphFilter, vtkDiffusionTensorGlyph* instancesFilter,
+                         vtkPolyData* source)
+{
+  glyphFilter->Update();
+  instancesFilter->Update();
+  return CompareInstancesWithGlyphs(instancesFilter->GetOutput(), glyphFilter->GetOutput(), source);
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorGlyphTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkImageData> tensorImage;
+  CreateTensorImage(tensorImage.GetPointer());
+
+  // Arrows are not symmetric, so shifts and mirroring are visible
+  vtkNew<vtkArrowSource> arrow;
+  arrow->Update();
+  vtkPolyData* source = arrow->GetOutput();
+
+  vtkNew<vtkDiffusionTensorGlyph> glyphFilter;
+  vtkNew<vtkDiffusionTensorGlyph> instancesFilter;
+  if (glyphFilter->GetOutputGlyphInstances() != 0)
+    {
+    std::cerr << "Glyph instances should be disabled by default" << std::endl;
+    return EXIT_FAILURE;
+    }
+  instancesFilter->OutputGlyphInstancesOn();
+  vtkDiffusionTensorGlyph* filters[2] = { glyphFilter.GetPointer(), instancesFilter.GetPointer() };
+  for (int i = 0; i < 2; i++)
+    {
+    filters[i]->SetInputData(tensorImage.GetPointer());
+    filters[i]->SetSourceConnection(arrow->GetOutputPort());
+    filters[i]->SetDimensionResolution(1, 1);
+    filters[i]->ColorGlyphsByFractionalAnisotropy();
+    }
+
+  // One glyph per tensor
+  if (!CompareGlyphFilters(glyphFilter.GetPointer(), instancesFilter.GetPointer(), source)
+    || instancesFilter->GetOutput()->GetNumberOfPoints() != tensorImage->GetNumberOfPoints())
+    {
+    std::cerr << __LINE__ << ": Glyph instances differ from glyphs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Three symmetric glyphs per tensor: mirrored glyphs have a negative scale
+  for (int i = 0; i < 2; i++)
+    {
+    filters[i]->ThreeGlyphsOn();
+    filters[i]->SymmetricOn();
+    }
+  if (!CompareGlyphFilters(glyphFilter.GetPointer(), instancesFilter.GetPointer(), source)
+    || instancesFilter->GetOutput()->GetNumberOfPoints() != 6 * tensorImage->GetNumberOfPoints())
+    {
+    std::cerr << __LINE__ << ": Symmetric glyph instances differ from glyphs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Negative scale factor: glyphs are shifted to reverse their direction
+  for (int i = 0; i < 2; i++)
+    {
+    filters[i]->SetScaleFactor(-800.0);
+    filters[i]->SetLength(0.7);
+    }
+  if (!CompareGlyphFilters(glyphFilter.GetPointer(), instancesFilter.GetPointer(), source))
+    {
+    std::cerr << __LINE__ << ": Shifted glyph instances differ from glyphs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Tensor rotation with a reflection and positioned glyphs
+  vtkNew<vtkMatrix4x4> tensorRotation;
+  tensorRotation->SetElement(0, 0, 0.0);
+  tensorRotation->SetElement(0, 1, 1.0);
+  tensorRotation->SetElement(1, 0, 1.0);
+  tensorRotation->SetElement(1, 1, 0.0);
+  vtkNew<vtkMatrix4x4> volumePosition;
+  volumePosition->SetElement(0, 3, 10.0);
+  volumePosition->SetElement(1, 3, -5.0);
+  volumePosition->SetElement(2, 2, -1.0);
+  for (int i = 0; i < 2; i++)
+    {
+    filters[i]->SetTensorRotationMatrix(tensorRotation.GetPointer());
+    filters[i]->SetVolumePositionMatrix(volumePosition.GetPointer());
+    }
+  if (!CompareGlyphFilters(glyphFilter.GetPointer(), instancesFilter.GetPointer(), source))
+    {
+    std::cerr << __LINE__ << ": Reflected glyph instances differ from glyphs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Single glyph per tensor with reflection
+  for (int i = 0; i < 2; i++)
+    {
+    filters[i]->ThreeGlyphsOff();
+    filters[i]->SymmetricOff();
+    filters[i]->SetScaleFactor(1000.0);
+    }
+  if (!CompareGlyphFilters(glyphFilter.GetPointer(), instancesFilter.GetPointer(), source))
+    {
+    std::cerr << __LINE__ << ": Reflected single glyph instances differ from glyphs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkDiffusionTensorEigensystemCache.h"
+#include "vtkDiffusionTensorMathematics.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkDataObject.h>
+#include <vtkInformation.h>
+#include <vtkInformationObjectBaseKey.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+
+vtkStandardNewMacro(vtkDiffusionTensorEigensystemCache);
+vtkInformationKeyMacro(vtkDiffusionTensorEigensystemCache, EIGENSYSTEM_CACHE, ObjectBase);
+
+namespace
+{
+
+struct EigensystemJob
+{
+  vtkDataArray* Tensors;
+  const float* FloatTensors; // set if tensors can be read directly
+  vtkIdType NumberOfTensors;
+  float* Eigenvalues;
+  float* Eigenvectors;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ComputeEigensystemsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  EigensystemJob* job = static_cast<EigensystemJob*>(info->UserData);
+  vtkIdType begin = job->NumberOfTensors * info->ThreadID / info->NumberOfThreads;
+  vtkIdType end = job->NumberOfTensors * (info->ThreadID + 1) / info->NumberOfThreads;
+
+  if (job->FloatTensors)
+    {
+    vtkDiffusionTensorMathematics::ComputeEigensystems(job->FloatTensors + 9*begin, end - begin,
+      job->Eigenvalues + 3*begin, job->Eigenvectors + 9*begin);
+    return VTK_THREAD_RETURN_VALUE;
+    }
+
+  // convert tensors to float in small blocks
+  const vtkIdType blockSize = 256;
+  float block[9*blockSize];
+  double tensor[9];
+  for (vtkIdType blockStart = begin; blockStart < end; blockStart += blockSize)
+    {
+    vtkIdType blockEnd = (blockStart + blockSize < end ? blockStart + blockSize : end);
+    for (vtkIdType tensorId = blockStart; tensorId < blockEnd; tensorId++)
+      {
+      job->Tensors->GetTuple(tensorId, tensor);
+      for (int i = 0; i < 9; i++)
+        {
+        block[9*(tensorId - blockStart) + i] = static_cast<float>(tensor[i]);
+        }
+      }
+    vtkDiffusionTensorMathematics::ComputeEigensystems(block, blockEnd - blockStart,
+      job->Eigenvalues + 3*blockStart, job->Eigenvectors + 9*blockStart);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
+
+//----------------------------------------------------------------------------
+vtkDiffusionTensorEigensystemCache::vtkDiffusionTensorEigensystemCache()
+{
+  this->NumberOfTensors = 0;
+  this->Tensors = NULL;
+  this->TensorsMTime = 0;
+  this->DataObject = NULL;
+  this->DataObjectMTime = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkDiffusionTensorEigensystemCache::~vtkDiffusionTensorEigensystemCache()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkDiffusionTensorEigensystemCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "NumberOfTensors: " << this->NumberOfTensors << "\n";
+  os << indent << "TensorsMTime: " << this->TensorsMTime << "\n";
+  os << indent << "DataObjectMTime: " << this->DataObjectMTime << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkDiffusionTensorEigensystemCache* vtkDiffusionTensorEigensystemCache::GetCache(vtkDataArray* tensors,
+                                                                                 vtkDataObject* dataObject)
+{
+  if (tensors == NULL || tensors->GetNumberOfComponents() != 9)
+    {
+    return NULL;
+    }
+  vtkDiffusionTensorEigensystemCache* cache = vtkDiffusionTensorEigensystemCache::GetUpToDateCache(tensors, dataObject);
+  if (cache)
+    {
+    return cache;
+    }
+
+  // The cache object may be shared with copies of the array (information is copied
+  // along with the array), so a new one is created instead of updating it.
+  vtkNew<vtkDiffusionTensorEigensystemCache> newCache;
+  newCache->Compute(tensors, dataObject);
+  tensors->GetInformation()->Set(vtkDiffusionTensorEigensystemCache::EIGENSYSTEM_CACHE(), newCache.GetPointer());
+  return newCache.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+vtkDiffusionTensorEigensystemCache* vtkDiffusionTensorEigensystemCache::GetUpToDateCache(vtkDataArray* tensors,
+                                                                                         vtkDataObject* dataObject)
+{
+  if (tensors == NULL || !tensors->HasInformation())
+    {
+    return NULL;
+    }
+  vtkDiffusionTensorEigensystemCache* cache = vtkDiffusionTensorEigensystemCache::SafeDownCast(
+    tensors->GetInformation()->Get(vtkDiffusionTensorEigensystemCache::EIGENSYSTEM_CACHE()));
+  if (cache == NULL || !cache->IsUpToDate(tensors, dataObject))
+    {
+    return NULL;
+    }
+  return cache;
+}
+
+//----------------------------------------------------------------------------
+void vtkDiffusionTensorEigensystemCache::RemoveCache(vtkDataArray* tensors)
+{
+  if (tensors == NULL || !tensors->HasInformation())
+    {
+    return;
+    }
+  tensors->GetInformation()->Remove(vtkDiffusionTensorEigensystemCache::EIGENSYSTEM_CACHE());
+}
+
+//----------------------------------------------------------------------------
+bool vtkDiffusionTensorEigensystemCache::IsUpToDate(vtkDataArray* tensors, vtkDataObject* dataObject)
+{
+  if (this->Tensors != tensors
+    || this->TensorsMTime != tensors->GetMTime()
+    || this->NumberOfTensors != tensors->GetNumberOfTuples())
+    {
+    return false;
+    }
+  // The data object MTime is only known if it was specified when the cache was computed
+  if (dataObject
+    && (this->DataObject != dataObject || this->DataObjectMTime != dataObject->GetMTime()))
+    {
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkDiffusionTensorEigensystemCache::Compute(vtkDataArray* tensors, vtkDataObject* dataObject)
+{
+  this->Tensors = tensors;
+  this->TensorsMTime = tensors->GetMTime();
+  this->DataObject = dataObject;
+  this->DataObjectMTime = (dataObject ? dataObject->GetMTime() : 0);
+  this->NumberOfTensors = tensors->GetNumberOfTuples();
+  this->Eigenvalues.resize(3*this->NumberOfTensors);
+  this->Eigenvectors.resize(9*this->NumberOfTensors);
+  if (this->NumberOfTensors == 0)
+    {
+    return;
+    }
+
+  EigensystemJob job;
+  job.Tensors = tensors;
+  job.FloatTensors = (tensors->GetDataType() == VTK_FLOAT ?
+    static_cast<const float*>(tensors->GetVoidPointer(0)) : NULL);
+  job.NumberOfTensors = this->NumberOfTensors;
+  job.Eigenvalues = &this->Eigenvalues[0];
+  job.Eigenvectors = &this->Eigenvectors[0];
+
+  vtkNew<vtkMultiThreader> threader;
+  int numberOfThreads = threader->GetNumberOfThreads();
+  if (this->NumberOfTensors < 4096)
+    {
+    // not worth starting threads (e.g., probing a single tensor)
+    numberOfThreads = 1;
+    }
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ComputeEigensystemsThread, &job);
+  threader->SingleMethodExecute();
+}
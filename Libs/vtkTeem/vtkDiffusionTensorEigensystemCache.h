@@ -0,0 +1,112 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+///  vtkDiffusionTensorEigensystemCache - Eigenvalues and eigenvectors of a tensor array
+///
+/// The eigensystem of every tensor of an array is computed once (in parallel,
+/// with vtkDiffusionTensorMathematics::ComputeEigensystems) and stored in the
+/// information of the tensor array, so all filters that process the same tensors
+/// (scalar invariants, color by orientation, glyphs) share it. The cache is
+/// recomputed when the tensor array or the image that contains it is modified
+/// (their MTime changes). It is released with the array, or earlier by the filter
+/// that requested it. It takes 48 bytes per tensor.
+//
+
+#ifndef __vtkDiffusionTensorEigensystemCache_h
+#define __vtkDiffusionTensorEigensystemCache_h
+
+// vtkTeem includes
+#include "vtkTeemConfigure.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <vector>
+
+class vtkDataArray;
+class vtkDataObject;
+class vtkInformationObjectBaseKey;
+
+class VTK_Teem_EXPORT vtkDiffusionTensorEigensystemCache : public vtkObject
+{
+public:
+  static vtkDiffusionTensorEigensystemCache *New();
+  vtkTypeMacro(vtkDiffusionTensorEigensystemCache,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  ///
+  /// Get the eigensystem of the tensors. It is computed if it has not been
+  /// computed yet or the tensors have been modified since.
+  /// If the data object that contains the tensors is specified then its
+  /// modification also invalidates the eigensystem, as tensor values are often
+  /// changed in place and only the image is marked as modified.
+  static vtkDiffusionTensorEigensystemCache* GetCache(vtkDataArray* tensors,
+                                                      vtkDataObject* dataObject = NULL);
+
+  ///
+  /// Get the eigensystem of the tensors if it is up-to-date, NULL otherwise.
+  /// Useful for consumers that only process a few tensors.
+  /// \sa GetCache
+  static vtkDiffusionTensorEigensystemCache* GetUpToDateCache(vtkDataArray* tensors,
+                                                              vtkDataObject* dataObject = NULL);
+
+  ///
+  /// Release the cached eigensystem of the tensors.
+  static void RemoveCache(vtkDataArray* tensors);
+
+  ///
+  /// Key of the cache in the information of the tensor array
+  static vtkInformationObjectBaseKey* EIGENSYSTEM_CACHE();
+
+  ///
+  /// Eigenvalues of a tensor, sorted in decreasing order
+  const float* GetEigenvalues(vtkIdType tensorId)
+    {
+    return &this->Eigenvalues[3*tensorId];
+    }
+
+  ///
+  /// Eigenvectors of a tensor: columns of a row-major 3x3 matrix,
+  /// in the order of the eigenvalues
+  const float* GetEigenvectors(vtkIdType tensorId)
+    {
+    return &this->Eigenvectors[9*tensorId];
+    }
+
+  vtkIdType GetNumberOfTensors()
+    {
+    return this->NumberOfTensors;
+    }
+
+protected:
+  vtkDiffusionTensorEigensystemCache();
+  ~vtkDiffusionTensorEigensystemCache();
+
+  /// Returns true if the cache was computed from the current content of the tensors
+  bool IsUpToDate(vtkDataArray* tensors, vtkDataObject* dataObject);
+  void Compute(vtkDataArray* tensors, vtkDataObject* dataObject);
+
+  std::vector<float> Eigenvalues;
+  std::vector<float> Eigenvectors;
+  vtkIdType NumberOfTensors;
+
+  /// Tensors the eigensystem was computed from (not referenced, the cache is owned by the array)
+  vtkDataArray* Tensors;
+  unsigned long TensorsMTime;
+
+  /// Data object that contained the tensors (not referenced, only used as a key)
+  vtkDataObject* DataObject;
+  unsigned long DataObjectMTime;
+
+private:
+  vtkDiffusionTensorEigensystemCache(const vtkDiffusionTensorEigensystemCache&);
+  void operator=(const vtkDiffusionTensorEigensystemCache&);
+};
+
+#endif
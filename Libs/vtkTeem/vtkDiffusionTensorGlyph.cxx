@@ -18,16 +18,20 @@
 #include "vtkMath.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
-#include <vtkStreamingDemandDrivenPipeline.h>
-#include "vtkTransform.h"
+#include <vtkSmartPointer.h>
 
 #include "vtkImageData.h"
+#include "vtkDiffusionTensorEigensystemCache.h"
 #include "vtkDiffusionTensorMathematics.h"
 
+#include <cmath>
 #include <ctime>
+#include <vector>
 
 vtkCxxSetObjectMacro(vtkDiffusionTensorGlyph,Mask,vtkImageData);
 vtkCxxSetObjectMacro(vtkDiffusionTensorGlyph,VolumePositionMatrix,vtkMatrix4x4);
@@ -56,6 +60,11 @@ vtkDiffusionTensorGlyph::vtkDiffusionTensorGlyph()
   this->DimensionResolution[0] = 20;
   this->DimensionResolution[1] = 20;
 
+  this->MaximumNumberOfGlyphs = 0;
+  this->MaximumGlyphDensity = 0.0;
+  this->OutputGlyphInstances = 0;
+  this->NumberOfThreads = 0;
+
   // Default large scalar factor for diffusion data.
   // Display small magnitude eigenvalues in mm space.
   this->ScaleFactor = 1000;
@@ -138,620 +147,944 @@ void vtkDiffusionTensorGlyph::ColorGlyphsBy(int invariant) {
     }
 }
 
-// TO DO: make input mask a point data object or scalars
-
-int vtkDiffusionTensorGlyph::RequestData(
-                                         vtkInformation *vtkNotUsed(request),
-                                         vtkInformationVector **inputVector,
-                                         vtkInformationVector *outputVector)
+namespace
 {
-  // get the info objects
-  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
-  vtkInformation *sourceInfo = inputVector[1]->GetInformationObject(0);
-  vtkInformation *outInfo = outputVector->GetInformationObject(0);
 
-  // get the input and ouptut
-  vtkDataSet *input = vtkDataSet::SafeDownCast(
-                                               inInfo->Get(vtkDataObject::DATA_OBJECT()));
-  vtkPolyData *source = vtkPolyData::SafeDownCast(
-                                                  sourceInfo->Get(vtkDataObject::DATA_OBJECT()));
-  vtkPolyData *output = vtkPolyData::SafeDownCast(
-                                                  outInfo->Get(vtkDataObject::DATA_OBJECT()));
+//----------------------------------------------------------------------------
+// c = a * b for row-major 4x4 matrices (c may be a or b)
+void MultiplyMatrix4x4(const double a[16], const double b[16], double c[16])
+{
+  double result[16];
+  for (int i = 0; i < 4; i++)
+    {
+    for (int j = 0; j < 4; j++)
+      {
+      result[4*i+j] = a[4*i]*b[j] + a[4*i+1]*b[4+j] + a[4*i+2]*b[8+j] + a[4*i+3]*b[12+j];
+      }
+    }
+  for (int i = 0; i < 16; i++)
+    {
+    c[i] = result[i];
+    }
+}
 
-  vtkDataArray *inTensors;
-  vtkDataArray *inScalars;
-  vtkIdType numPts, numSourcePts, numSourceCells, inPtId, i;
-  int j;
-  vtkPoints *sourcePts;
-  vtkDataArray *sourceNormals;
-  vtkCellArray *sourceCells, *cells;
-  vtkPoints *newPts;
-  vtkFloatArray *newScalars=NULL;
-  vtkFloatArray *newNormals=NULL;
-  double x[3], x2[3], s;
-  vtkTransform *trans;
-  vtkCell *cell;
-  vtkIdList *cellPts;
-  int npts;
-  vtkIdType *pts;
-  vtkIdType cellId;
-  vtkIdType subIncr;
-  int numDirs, dir, eigen_dir, symmetric_dir;
-  vtkMatrix4x4 *matrix;
-  double *m[3], w[3], *v[3];
-  double m0[3], m1[3], m2[3];
-  double v0[3], v1[3], v2[3];
-  double xv[3], yv[3], zv[3];
-  double maxScale;
-  vtkPointData *pd, *outPD;
+//----------------------------------------------------------------------------
+void TransformAffine(const double m[16], const double in[3], double out[3])
+{
+  double x = in[0], y = in[1], z = in[2];
+  out[0] = m[0]*x + m[1]*y + m[2]*z + m[3];
+  out[1] = m[4]*x + m[5]*y + m[6]*z + m[7];
+  out[2] = m[8]*x + m[9]*y + m[10]*z + m[11];
+}
 
-  // Keeps track of the number of points added to the output polydata so far.
-  // this replaces variable ptIncr in superclass vtkTensorGlyph.
-  vtkIdType ptOffset = 0;
+//----------------------------------------------------------------------------
+// Rotation angles (in degrees) of a rotation matrix in the convention of
+// vtkProp3D and vtkGlyph3DMapper: rotations about Z, then X, then Y.
+void GetOrientation(const double r[3][3], double orientation[3])
+{
+  double sinX = (r[2][1] > 1.0 ? 1.0 : (r[2][1] < -1.0 ? -1.0 : r[2][1]));
+  double x = asin(sinX);
+  double y = 0.0;
+  double z = 0.0;
+  if (cos(x) > 1e-6)
+    {
+    y = atan2(-r[2][0], r[2][2]);
+    z = atan2(-r[0][1], r[1][1]);
+    }
+  else
+    {
+    // gimbal lock: only Y+Z (or Y-Z) is defined
+    z = atan2(r[1][0], r[0][0]);
+    }
+  orientation[0] = vtkMath::DegreesFromRadians(x);
+  orientation[1] = vtkMath::DegreesFromRadians(y);
+  orientation[2] = vtkMath::DegreesFromRadians(z);
+}
 
-  // coordinate systems for DTI
-  vtkTransform *userVolumeTransform = NULL;
-  // masking of glyphs
-  vtkDataArray *inMask;
-  // glyph timing
-#ifndef NDEBUG
-  clock_t tStart = clock();
-#endif
+//----------------------------------------------------------------------------
+// Everything the glyph threads need. Glyphs are independent and each of them
+// has a known number of output points, so each thread processes a range of the
+// selected glyphs and writes them directly at their place in the output arrays.
+struct GlyphJob
+{
+  vtkDiffusionTensorGlyph* Self;
+  vtkDataSet* Input;
+  vtkDataArray* Tensors;
+  vtkDataArray* InputScalars; // set if coloring by input scalars
+  vtkDiffusionTensorEigensystemCache* EigensystemCache;
+  const vtkIdType* GlyphPointIds;
+  vtkIdType NumberOfGlyphs;
+
+  int NumberOfDirections;
+  int ComputeScalars;
+  double VolumePosition[16];
+  bool HasVolumePosition;
+  double TensorRotation[16];
+  bool HasTensorRotation;
+  bool FlipNormals;
+
+  // Glyph geometry (not used for instances)
+  std::vector<double> SourcePoints;
+  std::vector<double> SourceNormals;
+  vtkIdType NumberOfSourcePoints;
+  std::vector<vtkIdType> SourceCells[4]; // connectivity of verts, lines, polys, strips of one glyph
+  vtkIdType NumberOfGlyphCells[4];
+
+  // Output
+  bool Instances;
+  float* Points;
+  float* Normals;
+  float* Scalars;
+  float* Scales;
+  float* Orientations;
+  vtkIdType* Cells[4];
+};
 
-  // use simpler 3x3 array, not 9D as in vtkTensorGlyph class
+//----------------------------------------------------------------------------
+// Compute for each glyph direction the transform of the glyph (without the
+// position and the scaling) and the scaling. Returns the scalar of the glyph.
+double ComputeGlyph(const GlyphJob& job, vtkIdType inPtId,
+                    double transforms[6][16], double scales[6][3], bool shifts[6])
+{
+  vtkDiffusionTensorGlyph* self = job.Self;
   double tensor[3][3];
+  double w[3];
+  double xv[3], yv[3], zv[3];
+  double v0[3], v1[3], v2[3];
+  double *v[3] = { v0, v1, v2 };
+  int i;
 
-  // the number of eigenvectors to glyph * if there are two glyphs per vector
-  numDirs = (this->ThreeGlyphs?3:1)*(this->Symmetric+1);
+  job.Tensors->GetTuple(inPtId, (double *)tensor);
+
+  // compute orientation vectors and scale factors from tensor
+  if ( self->GetExtractEigenvalues() ) // extract appropriate eigenfunctions
+    {
+    if (job.EigensystemCache)
+      {
+      const float* cachedEigenvalues = job.EigensystemCache->GetEigenvalues(inPtId);
+      const float* cachedEigenvectors = job.EigensystemCache->GetEigenvectors(inPtId);
+      for (i=0; i<3; i++)
+        {
+        w[i] = cachedEigenvalues[i];
+        v[i][0] = cachedEigenvectors[3*i];
+        v[i][1] = cachedEigenvectors[3*i+1];
+        v[i][2] = cachedEigenvectors[3*i+2];
+        }
+      }
+    else
+      {
+      double m0[3], m1[3], m2[3];
+      double *m[3] = { m0, m1, m2 };
+      for (int j=0; j<3; j++)
+        {
+        for (i=0; i<3; i++)
+          {
+          m[i][j] = tensor[j][i];
+          }
+        }
+      vtkDiffusionTensorMathematics::ClosedFormEigenSolver(m,w,v);
+      }
 
-  pts = new vtkIdType[source->GetMaxCellSize()];
-  trans = vtkTransform::New();
-  matrix = vtkMatrix4x4::New();
+    //copy eigenvectors
+    xv[0] = v[0][0]; xv[1] = v[1][0]; xv[2] = v[2][0];
+    yv[0] = v[0][1]; yv[1] = v[1][1]; yv[2] = v[2][1];
+    zv[0] = v[0][2]; zv[1] = v[1][2]; zv[2] = v[2][2];
+    }
+  else //use tensor columns as eigenvectors
+    {
+    for (i=0; i<3; i++)
+      {
+      xv[i] = tensor[0][i];
+      yv[i] = tensor[1][i];
+      zv[i] = tensor[2][i];
+      }
+    w[0] = vtkMath::Normalize(xv);
+    w[1] = vtkMath::Normalize(yv);
+    w[2] = vtkMath::Normalize(zv);
+    v[0][0] = xv[0]; v[1][0] = xv[1]; v[2][0] = xv[2];
+    }
 
-  // set up working matrices
-  m[0] = m0; m[1] = m1; m[2] = m2;
-  v[0] = v0; v[1] = v1; v[2] = v2;
+  // Calculate output scalars before computing glyph scale factors from eigenvalues.
+  // First, pass through input scalars if requested.
+  double s = 0;
+  if ( job.InputScalars )
+    {
+    s = job.InputScalars->GetComponent(inPtId, 0);
+    }
+  // Output scalar invariants if requested
+  else if ( job.ComputeScalars )
+    {
+    // Correct for negative eigenvalues: use logic coded in vtkDiffusionTensorMathematics
+    vtkDiffusionTensorMathematics::FixNegativeEigenvaluesMethod(w);
 
-  vtkDebugMacro(<<"Generating tensor glyphs");
+    switch (self->GetScalarInvariant())
+      {
+      case vtkDiffusionTensorMathematics::VTK_TENS_LINEAR_MEASURE:
+        s = vtkDiffusionTensorMathematics::LinearMeasure(w);
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_PLANAR_MEASURE:
+        s = vtkDiffusionTensorMathematics::PlanarMeasure(w);
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_SPHERICAL_MEASURE:
+        s = vtkDiffusionTensorMathematics::SphericalMeasure(w);
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_MAX_EIGENVALUE:
+        s = w[0];
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_MID_EIGENVALUE:
+        s = w[1];
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_MIN_EIGENVALUE:
+        s = w[2];
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_PARALLEL_DIFFUSIVITY:
+        s = w[0];
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
+        s = 0.5*(w[1]+w[2]);
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_COLOR_ORIENTATION:
+        {
+        double v_maj[3];
+        v_maj[0]=v[0][0];
+        v_maj[1]=v[1][0];
+        v_maj[2]=v[2][0];
+        if (job.HasTensorRotation)
+          {
+          TransformAffine(job.TensorRotation, v_maj, v_maj);
+          }
+        // TO DO: here output as RGB. Need to allocate 3-component scalars first.
+        vtkDiffusionTensorMathematics::RGBToIndex(fabs(v_maj[0]),fabs(v_maj[1]),fabs(v_maj[2]),s);
+        }
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_RELATIVE_ANISOTROPY:
+        s = vtkDiffusionTensorMathematics::RelativeAnisotropy(w);
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY:
+        s = vtkDiffusionTensorMathematics::FractionalAnisotropy(w);
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_TRACE:
+        s = vtkDiffusionTensorMathematics::Trace(w);
+        break;
+      default:
+        s = 0;
+        break;
+      }
+    }
 
-  pd = input->GetPointData();
-  outPD = output->GetPointData();
-  inTensors = pd->GetTensors();
-  inScalars = pd->GetScalars();
-  numPts = input->GetNumberOfPoints();
-  if ( !inTensors || numPts < 1 )
+  // Use the square root of the eigenvalues for scaling
+  // for DTI, and compute scale factors (this modifies eigenvalues so
+  // scalar invariants were computed already above)
+  double scaleFactor = self->GetScaleFactor();
+  for (i=0; i<3; i++)
     {
-    vtkErrorMacro(<<"No data to glyph!");
-    trans->Delete();
-    matrix->Delete();
-    return 1;
+    w[i] = sqrt( w[i] ) * scaleFactor;
     }
 
-  // Compute steps along dimensions
-  // and real number of input points
-  int numInputPts = numPts;
-  int skipRows = 0;
-  int skipCols = this->Resolution;
-  int rowLength = numPts;
-  int row = 0;
-  int col = 0;
-  // TODO: use UpdateExtent not WholeExtent
-  int inWholeExtent[6];
-  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), inWholeExtent);
-  int dimensions[3];
-  dimensions[0] = inWholeExtent[1] - inWholeExtent[0] + 1;
-  dimensions[1] = inWholeExtent[3] - inWholeExtent[2] + 1;
-  dimensions[2] = inWholeExtent[5] - inWholeExtent[4] + 1;
-  if (dimensions[0] > 1 && dimensions[1] > 1)
+  double maxScale;
+  if ( self->GetClampScaling() )
     {
-    skipRows = DimensionResolution[1];
-    skipCols = DimensionResolution[0];
-    rowLength = dimensions[0];
-    if (skipCols)
+    for (maxScale=0.0, i=0; i<3; i++)
       {
-      numInputPts = (numInputPts+1)/skipCols;
+      if ( maxScale < fabs(w[i]) )
+        {
+        maxScale = fabs(w[i]);
+        }
       }
-    if (skipRows)
+    if ( maxScale > self->GetMaxScaleFactor() )
       {
-      numInputPts = (numInputPts+1)/skipRows;
+      maxScale = self->GetMaxScaleFactor() / maxScale;
+      for (i=0; i<3; i++)
+        {
+        w[i] *= maxScale; //preserve overall shape of glyph
+        }
       }
     }
 
-  //
-  // Allocate storage for output PolyData
-  //
-  sourcePts = source->GetPoints();
-  numSourcePts = sourcePts->GetNumberOfPoints();
-  numSourceCells = source->GetNumberOfCells();
-
-  newPts = vtkPoints::New();
-  // Allocate as if we will glyph every point
-  // If some are masked/skipped for Resolution this will be fixed later with Squeeze
-  // TO DO allocate less for lower resolution
-  newPts->Allocate(numDirs*numInputPts*numSourcePts);
-
-  // Setting up for calls to PolyData::InsertNextCell()
-  if ( (sourceCells=source->GetVerts())->GetNumberOfCells() > 0 )
-    {
-    cells = vtkCellArray::New();
-    cells->Allocate(numDirs*numInputPts*sourceCells->GetSize());
-    output->SetVerts(cells);
-    cells->Delete();
-    }
-  if ( (sourceCells=this->GetSource()->GetLines())->GetNumberOfCells() > 0 )
+  // make sure scale is okay (non-zero) and scale data
+  // this scale checking is from superclass code
+  for (maxScale=0.0, i=0; i<3; i++)
     {
-    cells = vtkCellArray::New();
-    cells->Allocate(numDirs*numInputPts*sourceCells->GetSize());
-    output->SetLines(cells);
-    cells->Delete();
+    if ( w[i] > maxScale )
+      {
+      maxScale = w[i];
+      }
     }
-  if ( (sourceCells=this->GetSource()->GetPolys())->GetNumberOfCells() > 0 )
+  if ( maxScale == 0.0 )
     {
-    cells = vtkCellArray::New();
-    cells->Allocate(numDirs*numInputPts*sourceCells->GetSize());
-    output->SetPolys(cells);
-    cells->Delete();
+    maxScale = 1.0;
     }
-  if ( (sourceCells=this->GetSource()->GetStrips())->GetNumberOfCells() > 0 )
+  for (i=0; i<3; i++)
     {
-    cells = vtkCellArray::New();
-    cells->Allocate(numDirs*numInputPts*sourceCells->GetSize());
-    output->SetStrips(cells);
-    cells->Delete();
+    if ( w[i] == 0.0 )
+      {
+      w[i] = maxScale * 1.0e-06;
+      }
     }
 
-  // Get point data, decide how to allocate scalars
-  pd = this->GetSource()->GetPointData();
-
-  // generate scalars if eigenvalues are chosen or if scalars exist.
-  if (this->ColorGlyphs &&
-      ((this->ColorMode == COLOR_BY_EIGENVALUES) ||
-       (inScalars && (this->ColorMode == COLOR_BY_SCALARS)) ) )
+  // normalized eigenvectors rotate object for eigen direction 0
+  double eigenvectors[16] =
     {
-    newScalars = vtkFloatArray::New();
-    newScalars->Allocate(numDirs*numInputPts*numSourcePts);
-    }
-  else
-    {
-    // only copy scalar data through
-    // (superclass does this but why? if user has not asked for ColorGlyphs)
-    outPD->CopyAllOff();
-    outPD->CopyScalarsOn();
-    outPD->CopyAllocate(pd,numDirs*numInputPts*numSourcePts);
-    }
-  if ( (sourceNormals = pd->GetNormals()) )
+    xv[0], yv[0], zv[0], 0.,
+    xv[1], yv[1], zv[1], 0.,
+    xv[2], yv[2], zv[2], 0.,
+    0., 0., 0., 1.
+    };
+  if (job.HasTensorRotation)
     {
-    newNormals = vtkFloatArray::New();
-    newNormals->SetNumberOfComponents(3);
-    newNormals->Allocate(numDirs*3*numInputPts*numSourcePts);
+    MultiplyMatrix4x4(job.TensorRotation, eigenvectors, eigenvectors);
     }
 
-  // Don't copy all topology here as in superclass because
-  // we are not necessarily outputting a glyph for every point.
+  // Separate glyph for each eigenvector (or two per eigenvector
+  // for two symmetric glyphs)
+  int threeGlyphs = self->GetThreeGlyphs();
+  for (int dir=0; dir < job.NumberOfDirections; dir++)
+    {
+    int eigen_dir = dir%(threeGlyphs?3:1);
+    int symmetric_dir = dir/(threeGlyphs?3:1);
 
-  // Figure out if we are masking some of the glyphs
-  inMask = NULL;
+    double* transform = transforms[dir];
+    if (eigen_dir == 1)
+      {
+      // RotateZ(90.0)
+      const double rotateZ[16] = { 0., -1., 0., 0., 1., 0., 0., 0., 0., 0., 1., 0., 0., 0., 0., 1. };
+      MultiplyMatrix4x4(eigenvectors, rotateZ, transform);
+      }
+    else if (eigen_dir == 2)
+      {
+      // RotateY(-90.0)
+      const double rotateY[16] = { 0., 0., -1., 0., 0., 1., 0., 0., 1., 0., 0., 0., 0., 0., 0., 1. };
+      MultiplyMatrix4x4(eigenvectors, rotateY, transform);
+      }
+    else
+      {
+      for (i=0; i<16; i++)
+        {
+        transform[i] = eigenvectors[i];
+        }
+      }
 
-  if (this->MaskGlyphs)
-    {
-    if (this->Mask != NULL)
+    if (threeGlyphs)
       {
-      inMask = this->Mask->GetPointData()->GetScalars();
+      scales[dir][0] = w[eigen_dir];
+      scales[dir][1] = scaleFactor;
+      scales[dir][2] = scaleFactor;
       }
     else
       {
-      vtkErrorMacro("User has not set input mask, but has requested MaskGlyphs");
+      scales[dir][0] = w[0];
+      scales[dir][1] = w[1];
+      scales[dir][2] = w[2];
       }
-    }
 
-  // Figure out if we are transforming output point locations
-  if (this->VolumePositionMatrix)
-    {
-    // user transform to move points
-    userVolumeTransform = vtkTransform::New();
+    // Mirror second set to the symmetric position
+    if (symmetric_dir == 1)
+      {
+      scales[dir][0] = -scales[dir][0];
+      }
 
-    userVolumeTransform->SetMatrix(this->VolumePositionMatrix);
-    userVolumeTransform->PreMultiply();
+    // if the eigenvalue is negative, shift to reverse direction.
+    // The && is there to ensure that we do not change the
+    // old behaviour of vtkTensorGlyphs (which only used one dir),
+    // in case there is an oriented glyph, e.g. an arrow.
+    shifts[dir] = (w[eigen_dir] < 0 && job.NumberOfDirections > 1);
     }
 
-  vtkDebugMacro(<<"Generating tensor glyphs: TRAVERSE POINTS");
-
-  vtkDebugMacro("Scalar coloring (" <<  this->ColorMode << ")  ["<< vtkTensorGlyph::COLOR_BY_EIGENVALUES << "] is evals. Scalar Invariant (" << this->ScalarInvariant << ")") ;
-
-  //
-  // Traverse all Input points, transforming glyph in this->Source by tensor,
-  // and outputting it at each point.  (Input points are not all used, only
-  // those not masked and included by this->Resolution.)
-  //
-  trans->PreMultiply();
+  return s;
+}
 
-  for (inPtId=0; inPtId < numPts; inPtId += skipCols)
+//----------------------------------------------------------------------------
+void GenerateGlyphs(GlyphJob& job, vtkIdType begin, vtkIdType end, bool reportProgress)
+{
+  vtkDiffusionTensorGlyph* self = job.Self;
+  double transforms[6][16];
+  double scales[6][3];
+  bool shifts[6];
+  double x[3];
+  const int numDirs = job.NumberOfDirections;
+  const vtkIdType numSourcePts = job.NumberOfSourcePoints;
+
+  for (vtkIdType glyphId = begin; glyphId < end; glyphId++)
     {
-    if (col >= rowLength)
+    if ( ((glyphId - begin) % 1000) == 0 )
       {
-      row += skipRows;
-      inPtId = row * rowLength;
-      col = 0;
-      if (inPtId >= numPts)
+      if (self->GetAbortExecute())
         {
-        break;
+        return;
         }
-      }
-    col += skipCols;
-    // progress notification
-    if ( ! (inPtId % 10000) )
-      {
-      this->UpdateProgress ((double)inPtId/numPts);
-
-      vtkDebugMacro(<<"Generating diffusion tensor glyphs: PROGRESS" << (double)inPtId/numPts);
-      if (this->GetAbortExecute())
+      if (reportProgress)
         {
-        break;
+        self->UpdateProgress(static_cast<double>(glyphId - begin) / (end - begin));
         }
       }
 
-    inTensors->GetTuple(inPtId, (double *)tensor);
+    vtkIdType inPtId = job.GlyphPointIds[glyphId];
+    double s = ComputeGlyph(job, inPtId, transforms, scales, shifts);
 
-    // Decide whether this tensor will be glyphed:
-    // Threshold by trace ( must be > 0)
-    double trace = vtkDiffusionTensorMathematics::Trace(tensor);
+    // translate Source to Input point
+    job.Input->GetPoint(inPtId, x);
+    // If we have a user-specified matrix modifying the output point locations
+    if (job.HasVolumePosition)
+      {
+      TransformAffine(job.VolumePosition, x, x);
+      }
 
-    // Only display this glyph if either:
-    // a) we are masking and the mask is 1 at this location.
-    // b) the trace is positive and we are not masking (default).
-    if (( ( inMask != NULL ) && inMask->GetTuple1( inPtId ) ) || ( !this->MaskGlyphs && trace > 0 ))
+    for (int dir=0; dir < numDirs; dir++)
       {
-      // copy topology of output glyph for this point
-      for (cellId=0; cellId < numSourceCells; cellId++)
+      double* transform = transforms[dir];
+      vtkIdType outId = glyphId*numDirs + dir;
+
+      if (job.Instances)
         {
-        cell = this->GetSource()->GetCell(cellId);
-        cellPts = cell->GetPointIds();
-        npts = cellPts->GetNumberOfIds();
-        for (dir=0; dir < numDirs; dir++)
+        double rotation[3][3];
+        double scale[3] = { scales[dir][0], scales[dir][1], scales[dir][2] };
+        for (int i = 0; i < 3; i++)
           {
-          // This variable may be removed, but that
-          // will not improve readability
-          //subIncr = ptIncr + dir*numSourcePts;
-
-          // Add offset calculated from all non-masked points added to output so far
-          subIncr = ptOffset + dir*numSourcePts;
-
-          for (i=0; i < npts; i++)
+          for (int j = 0; j < 3; j++)
             {
-            pts[i] = cellPts->GetId(i) + subIncr;
+            rotation[i][j] = transform[4*i+j];
             }
-          output->InsertNextCell(cell->GetCellType(),npts,pts);
           }
-        }
-
-      // compute orientation vectors and scale factors from tensor
-      if ( this->ExtractEigenvalues ) // extract appropriate eigenfunctions
-        {
-        for (j=0; j<3; j++)
+        // a mirroring is expressed as a negative scale
+        if (vtkMath::Determinant3x3(rotation) < 0)
           {
-          for (i=0; i<3; i++)
+          for (int i = 0; i < 3; i++)
             {
-            // this line from vtkTensorGlyph actually transposes
-            //m[i][j] = tensor[i+3*j];
-            // simpler code with 3x3 array:
-            m[i][j] = tensor[j][i];
+            rotation[i][2] = -rotation[i][2];
             }
+          scale[2] = -scale[2];
           }
-
-        //vtkMath::Jacobi(m, w, v);
-        // Use superior eigensolve from teem.
-        vtkDiffusionTensorMathematics::TeemEigenSolver(m,w,v);
-
-        //copy eigenvectors
-        xv[0] = v[0][0]; xv[1] = v[1][0]; xv[2] = v[2][0];
-        yv[0] = v[0][1]; yv[1] = v[1][1]; yv[2] = v[2][1];
-        zv[0] = v[0][2]; zv[1] = v[1][2]; zv[2] = v[2][2];
-        }
-      else //use tensor columns as eigenvectors
-        {
-        for (i=0; i<3; i++)
+        double orientation[3];
+        GetOrientation(rotation, orientation);
+        for (int i = 0; i < 3; i++)
           {
-          //xv[i] = tensor[i]; // from vtkTensorGlyph
-          //yv[i] = tensor[i+3];
-          //zv[i] = tensor[i+6];
-          xv[i] = tensor[0][i]; // with 3x3 matrix
-          yv[i] = tensor[1][i];
-          zv[i] = tensor[2][i];
+          double position = x[i] + transform[4*i+3];
+          if (shifts[dir])
+            {
+            // same shift as the glyph geometry below
+            position -= transform[4*i] * scales[dir][0] * self->GetLength();
+            }
+          job.Points[3*outId+i] = static_cast<float>(position);
+          job.Scales[3*outId+i] = static_cast<float>(scale[i]);
+          job.Orientations[3*outId+i] = static_cast<float>(orientation[i]);
+          }
+        if (job.Scalars)
+          {
+          job.Scalars[outId] = static_cast<float>(s);
           }
-        w[0] = vtkMath::Normalize(xv);
-        w[1] = vtkMath::Normalize(yv);
-        w[2] = vtkMath::Normalize(zv);
+        continue;
         }
 
-      // Calculate output scalars before computing glyph scale factors from eigenvalues.
-      // First, pass through input scalars if requested.
-      if ( inScalars && this->ColorGlyphs && ( this->ColorMode == vtkTensorGlyph::COLOR_BY_SCALARS ) )
+      // final transform: translation * transform * scale (* shift)
+      double matrix[3][4];
+      for (int i = 0; i < 3; i++)
         {
-        // Copy point data from source
-        s = inScalars->GetComponent(inPtId, 0);
+        for (int j = 0; j < 3; j++)
+          {
+          matrix[i][j] = transform[4*i+j] * scales[dir][j];
+          }
+        matrix[i][3] = x[i] + transform[4*i+3];
+        if (shifts[dir])
+          {
+          matrix[i][3] -= matrix[i][0] * self->GetLength();
+          }
         }
 
-      // Output scalar invariants if requested
-      else if ( this->ColorGlyphs && ( this->ColorMode == vtkTensorGlyph::COLOR_BY_EIGENVALUES ) )
+      vtkIdType outPtOffset = outId * numSourcePts;
+      const double* sourcePt = &job.SourcePoints[0];
+      float* outPt = job.Points + 3*outPtOffset;
+      for (vtkIdType i = 0; i < numSourcePts; i++, sourcePt += 3, outPt += 3)
         {
-        // Correct for negative eigenvalues: use logic coded in vtkDiffusionTensorMathematics
-        vtkDiffusionTensorMathematics::FixNegativeEigenvaluesMethod(w);
-
-        switch (this->ScalarInvariant)
+        for (int k = 0; k < 3; k++)
           {
-          case vtkDiffusionTensorMathematics::VTK_TENS_LINEAR_MEASURE:
-            s = vtkDiffusionTensorMathematics::LinearMeasure(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_PLANAR_MEASURE:
-            s = vtkDiffusionTensorMathematics::PlanarMeasure(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_SPHERICAL_MEASURE:
-            s = vtkDiffusionTensorMathematics::SphericalMeasure(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_MAX_EIGENVALUE:
-            s = w[0];
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_MID_EIGENVALUE:
-            s = w[1];
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_MIN_EIGENVALUE:
-            s = w[2];
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_PARALLEL_DIFFUSIVITY:
-            s = w[0];
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
-            s = 0.5*(w[1]+w[2]);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_COLOR_ORIENTATION:
-            double v_maj[3];
-            v_maj[0]=v[0][0];
-            v_maj[1]=v[1][0];
-            v_maj[2]=v[2][0];
-            if (this->TensorRotationMatrix)
-              {
-              vtkNew<vtkTransform> rotate;
-              rotate->SetMatrix(this->TensorRotationMatrix);
-              rotate->TransformPoint(v_maj,v_maj);
-              }
-            // TO DO: here output as RGB. Need to allocate 3-component scalars first.
-            s = 0;
-            vtkDiffusionTensorMathematics::RGBToIndex(fabs(v_maj[0]),fabs(v_maj[1]),fabs(v_maj[2]),s);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_RELATIVE_ANISOTROPY:
-            s = vtkDiffusionTensorMathematics::RelativeAnisotropy(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY:
-            s = vtkDiffusionTensorMathematics::FractionalAnisotropy(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_TRACE:
-            s = vtkDiffusionTensorMathematics::Trace(w);
-            break;
-          default:
-            s = 0;
-            break;
+          outPt[k] = static_cast<float>(matrix[k][0]*sourcePt[0] + matrix[k][1]*sourcePt[1]
+                                        + matrix[k][2]*sourcePt[2] + matrix[k][3]);
           }
         }
 
-      // Use the square root of the eigenvalues for scaling
-      // for DTI
-      w[0] = sqrt( w[0] );
-      w[1] = sqrt( w[1] );
-      w[2] = sqrt( w[2] );
-
-      // compute scale factors (this modifies eigenvalues so
-      // scalar invariants were computed already above)
-      w[0] *= this->ScaleFactor;
-      w[1] *= this->ScaleFactor;
-      w[2] *= this->ScaleFactor;
-
-      if ( this->ClampScaling )
+      if (job.Normals)
         {
-        for (maxScale=0.0, i=0; i<3; i++)
+        // normals are transformed by the inverse transpose
+        double linear[3][3];
+        double inverse[3][3];
+        for (int i = 0; i < 3; i++)
           {
-          if ( maxScale < fabs(w[i]) )
+          for (int j = 0; j < 3; j++)
             {
-            maxScale = fabs(w[i]);
+            linear[i][j] = matrix[i][j];
             }
           }
-        if ( maxScale > this->MaxScaleFactor )
+        vtkMath::Invert3x3(linear, inverse);
+        double normalSign = (job.FlipNormals ? -1.0 : 1.0);
+        const double* sourceNormal = &job.SourceNormals[0];
+        float* outNormal = job.Normals + 3*outPtOffset;
+        for (vtkIdType i = 0; i < numSourcePts; i++, sourceNormal += 3, outNormal += 3)
           {
-          maxScale = this->MaxScaleFactor / maxScale;
-          for (i=0; i<3; i++)
+          double normal[3];
+          for (int k = 0; k < 3; k++)
+            {
+            normal[k] = inverse[0][k]*sourceNormal[0] + inverse[1][k]*sourceNormal[1]
+              + inverse[2][k]*sourceNormal[2];
+            }
+          vtkMath::Normalize(normal);
+          for (int k = 0; k < 3; k++)
             {
-            w[i] *= maxScale; //preserve overall shape of glyph
+            outNormal[k] = static_cast<float>(normalSign * normal[k]);
             }
           }
         }
 
-      // normalization is postponed
-
-      // make sure scale is okay (non-zero) and scale data
-      // this scale checking is from superclass code
-      for (maxScale=0.0, i=0; i<3; i++)
+      if (job.Scalars)
         {
-        if ( w[i] > maxScale )
+        float scalar = static_cast<float>(s);
+        float* outScalar = job.Scalars + outPtOffset;
+        for (vtkIdType i = 0; i < numSourcePts; i++)
           {
-          maxScale = w[i];
+          outScalar[i] = scalar;
           }
         }
-      if ( maxScale == 0.0 )
+      }
+
+    if (job.Instances)
+      {
+      continue;
+      }
+
+    // copy topology of output glyph for this point
+    vtkIdType ptOffset = glyphId * numDirs * numSourcePts;
+    for (int type = 0; type < 4; type++)
+      {
+      const std::vector<vtkIdType>& sourceCells = job.SourceCells[type];
+      if (sourceCells.empty())
         {
-        maxScale = 1.0;
+        continue;
         }
-      for (i=0; i<3; i++)
+      vtkIdType* outCell = job.Cells[type] + glyphId * sourceCells.size();
+      for (size_t c = 0; c < sourceCells.size(); )
         {
-        if ( w[i] == 0.0 )
+        vtkIdType npts = sourceCells[c];
+        *(outCell++) = npts;
+        for (vtkIdType i = 1; i <= npts; i++)
           {
-          w[i] = maxScale * 1.0e-06;
+          *(outCell++) = sourceCells[c+i] + ptOffset;
           }
+        c += npts + 1;
         }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE GenerateGlyphsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  GlyphJob* job = static_cast<GlyphJob*>(info->UserData);
+  vtkIdType begin = job->NumberOfGlyphs * info->ThreadID / info->NumberOfThreads;
+  vtkIdType end = job->NumberOfGlyphs * (info->ThreadID + 1) / info->NumberOfThreads;
+  GenerateGlyphs(*job, begin, end, info->ThreadID == 0);
+  return VTK_THREAD_RETURN_VALUE;
+}
 
-      // Now do the real work for each "direction"
-      // This is a loop over each eigenvector allowing
-      // a separate glyph for each (or two loops per eigenvector
-      // allowing two symmetric glyphs for each)
+}
 
-      int flipNormals = 0;
-      if ( this->TensorRotationMatrix && this->TensorRotationMatrix->Determinant() < 0 )
-        {
-        flipNormals = 1;
-        }
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorGlyph::RequestData(
+                                         vtkInformation *vtkNotUsed(request),
+                                         vtkInformationVector **inputVector,
+                                         vtkInformationVector *outputVector)
+{
+  // get the info objects
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *sourceInfo = inputVector[1]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
 
-      for (dir=0; dir < numDirs; dir++)
-        {
-        eigen_dir = dir%(this->ThreeGlyphs?3:1);
-        symmetric_dir = dir/(this->ThreeGlyphs?3:1);
+  // get the input and ouptut
+  vtkDataSet *input = vtkDataSet::SafeDownCast(
+                                               inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkPolyData *source = sourceInfo ? vtkPolyData::SafeDownCast(
+                                                  sourceInfo->Get(vtkDataObject::DATA_OBJECT())) : NULL;
+  vtkPolyData *output = vtkPolyData::SafeDownCast(
+                                                  outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
-        // Remove previous scales ...
-        trans->Identity();
+  // glyph timing
+#ifndef NDEBUG
+  clock_t tStart = clock();
+#endif
 
-        // Actually output the scalar invariant calculated above
-        if ( newScalars != NULL )
-          {
-          for (i=0; i < numSourcePts; i++)
-            {
-            newScalars->InsertTuple(ptOffset+i, &s);
-            }
-          }
-        else
-          {
-          for (i=0; i < numSourcePts; i++)
-            {
-            // TO DO: why does superclass have this if no scalar output?
-            // in this case it appears copy scalars is on (above in
-            // scalar allocation section).
-            outPD->CopyData(pd,i,ptOffset+i);
-            }
-          }
+  vtkDebugMacro(<<"Generating tensor glyphs");
 
-        // translate Source to Input point
-        input->GetPoint(inPtId, x);
+  vtkPointData *pd = input->GetPointData();
+  vtkPointData *outPD = output->GetPointData();
+  vtkDataArray *inTensors = pd->GetTensors();
+  vtkDataArray *inScalars = pd->GetScalars();
+  vtkIdType numPts = input->GetNumberOfPoints();
+  if ( !inTensors || numPts < 1 )
+    {
+    vtkErrorMacro(<<"No data to glyph!");
+    return 1;
+    }
+  if ( !this->OutputGlyphInstances && (!source || !source->GetPoints()) )
+    {
+    vtkErrorMacro(<<"No glyph source!");
+    return 1;
+    }
 
-        // If we have a user-specified matrix modifying the output point locations
-        if ( userVolumeTransform != NULL )
-          {
-          userVolumeTransform->TransformPoint(x,x2);
-          trans->Translate(x2[0], x2[1], x2[2]);
-          }
-        else
-          {
-          trans->Translate(x[0], x[1], x[2]);
-          }
+  // the number of eigenvectors to glyph * if there are two glyphs per vector
+  int numDirs = (this->ThreeGlyphs?3:1)*(this->Symmetric+1);
 
-        // If we have a user-specified matrix rotating each tensor
-        if (this->TensorRotationMatrix)
-          {
-          trans->Concatenate(this->TensorRotationMatrix);
-          }
+  //
+  // Select the points to glyph: sample the input points according to
+  // the resolution, and keep those that are not masked out.
+  //
+  vtkIdType skipRows = 0;
+  vtkIdType skipCols = this->Resolution;
+  vtkIdType rowLength = numPts;
+  int dimensions[3] = { 1, 1, 1 };
+  vtkImageData* inputImage = vtkImageData::SafeDownCast(input);
+  if (inputImage)
+    {
+    // The input is a slice of the view for glyphs displayed in slice views,
+    // so only visible voxels are glyphed.
+    inputImage->GetDimensions(dimensions);
+    }
+  if (dimensions[0] > 1 && dimensions[1] > 1)
+    {
+    skipRows = (this->DimensionResolution[1] > 1 ? this->DimensionResolution[1] : 1);
+    skipCols = (this->DimensionResolution[0] > 1 ? this->DimensionResolution[0] : 1);
+    rowLength = dimensions[0];
+    }
+  vtkIdType numRows = (numPts + rowLength - 1) / rowLength;
 
-        // normalized eigenvectors rotate object for eigen direction 0
-        matrix->Element[0][0] = xv[0];
-        matrix->Element[0][1] = yv[0];
-        matrix->Element[0][2] = zv[0];
-        matrix->Element[1][0] = xv[1];
-        matrix->Element[1][1] = yv[1];
-        matrix->Element[1][2] = zv[1];
-        matrix->Element[2][0] = xv[2];
-        matrix->Element[2][1] = yv[2];
-        matrix->Element[2][2] = zv[2];
-        trans->Concatenate(matrix);
-
-        if (eigen_dir == 1)
-          {
-          trans->RotateZ(90.0);
-          }
+  // Level of detail: coarsen the sampling uniformly if there are too many glyphs
+  // to be useful on screen.
+  double maxNumberOfGlyphs = static_cast<double>(this->MaximumNumberOfGlyphs);
+  if (this->MaximumGlyphDensity > 0.0)
+    {
+    double maxNumberOfGlyphsForDensity = numPts * this->MaximumGlyphDensity;
+    if (maxNumberOfGlyphs <= 0.0 || maxNumberOfGlyphsForDensity < maxNumberOfGlyphs)
+      {
+      maxNumberOfGlyphs = (maxNumberOfGlyphsForDensity > 1.0 ? maxNumberOfGlyphsForDensity : 1.0);
+      }
+    }
+  if (maxNumberOfGlyphs > 0.0)
+    {
+    vtkIdType numCols = (rowLength + skipCols - 1) / skipCols;
+    vtkIdType numSampledRows = (skipRows ? (numRows + skipRows - 1) / skipRows : 1);
+    double ratio = static_cast<double>(numCols * numSampledRows) / maxNumberOfGlyphs;
+    if (ratio > 1.0)
+      {
+      if (skipRows)
+        {
+        vtkIdType factor = static_cast<vtkIdType>(ceil(sqrt(ratio)));
+        skipCols *= factor;
+        skipRows *= factor;
+        }
+      else
+        {
+        skipCols *= static_cast<vtkIdType>(ceil(ratio));
+        }
+      }
+    }
 
-        if (eigen_dir == 2)
-          {
-          trans->RotateY(-90.0);
-          }
+  // Figure out if we are masking some of the glyphs
+  vtkDataArray *inMask = NULL;
+  if (this->MaskGlyphs)
+    {
+    if (this->Mask != NULL)
+      {
+      inMask = this->Mask->GetPointData()->GetScalars();
+      }
+    else
+      {
+      vtkErrorMacro("User has not set input mask, but has requested MaskGlyphs");
+      }
+    }
 
-        if (this->ThreeGlyphs)
-          {
-          trans->Scale(w[eigen_dir], this->ScaleFactor, this->ScaleFactor);
-          }
-        else
+  std::vector<vtkIdType> glyphPointIds;
+  double tensor[3][3];
+  for (vtkIdType row = 0; row < numRows; row += (skipRows ? skipRows : numRows))
+    {
+    vtkIdType rowStart = row * rowLength;
+    vtkIdType rowEnd = (rowStart + rowLength < numPts ? rowStart + rowLength : numPts);
+    for (vtkIdType inPtId = rowStart; inPtId < rowEnd; inPtId += skipCols)
+      {
+      // Only display this glyph if either:
+      // a) we are masking and the mask is 1 at this location.
+      // b) the trace is positive and we are not masking (default).
+      if (this->MaskGlyphs)
+        {
+        if ( inMask != NULL && inMask->GetTuple1( inPtId ) )
           {
-          trans->Scale(w[0], w[1], w[2]);
+          glyphPointIds.push_back(inPtId);
           }
+        continue;
+        }
+      // Threshold by trace ( must be > 0)
+      inTensors->GetTuple(inPtId, (double *)tensor);
+      if (vtkDiffusionTensorMathematics::Trace(tensor) > 0)
+        {
+        glyphPointIds.push_back(inPtId);
+        }
+      }
+    }
+  vtkIdType numGlyphs = static_cast<vtkIdType>(glyphPointIds.size());
 
-        // Mirror second set to the symmetric position
-        if (symmetric_dir == 1)
-          {
-          trans->Scale(-1.,1.,1.);
-          }
+  //
+  // Set up the job and allocate storage for output PolyData
+  //
+  GlyphJob job;
+  job.Self = this;
+  job.Input = input;
+  job.Tensors = inTensors;
+  job.GlyphPointIds = (numGlyphs > 0 ? &glyphPointIds[0] : NULL);
+  job.NumberOfGlyphs = numGlyphs;
+  job.NumberOfDirections = numDirs;
+  job.Instances = (this->OutputGlyphInstances != 0);
+  job.Points = NULL;
+  job.Normals = NULL;
+  job.Scalars = NULL;
+  job.Scales = NULL;
+  job.Orientations = NULL;
+  job.NumberOfSourcePoints = (job.Instances ? 1 : source->GetNumberOfPoints());
+  for (int type = 0; type < 4; type++)
+    {
+    job.Cells[type] = NULL;
+    job.NumberOfGlyphCells[type] = 0;
+    }
 
-        // if the eigenvalue is negative, shift to reverse direction.
-        // The && is there to ensure that we do not change the
-        // old behaviour of vtkTensorGlyphs (which only used one dir),
-        // in case there is an oriented glyph, e.g. an arrow.
-        if (w[eigen_dir] < 0 && numDirs > 1)
-          {
-          trans->Translate(-this->Length, 0., 0.);
-          }
+  // Reuse eigensystems if they have been computed for these tensors already
+  // (e.g., for displaying a scalar invariant). Only a subset of the tensors is
+  // glyphed, so they are not computed for all the tensors here.
+  job.EigensystemCache = vtkDiffusionTensorEigensystemCache::GetUpToDateCache(inTensors, input);
 
-        // multiply points (and normals if available) by resulting
-        // matrix.
-        // This also appends them to the output "new" data.
-        trans->TransformPoints(sourcePts,newPts);
+  // Figure out if we are transforming output point locations
+  job.HasVolumePosition = (this->VolumePositionMatrix != NULL);
+  if (job.HasVolumePosition)
+    {
+    vtkMatrix4x4::DeepCopy(job.VolumePosition, this->VolumePositionMatrix);
+    }
+  job.HasTensorRotation = (this->TensorRotationMatrix != NULL);
+  if (job.HasTensorRotation)
+    {
+    vtkMatrix4x4::DeepCopy(job.TensorRotation, this->TensorRotationMatrix);
+    }
+  job.FlipNormals = ( this->TensorRotationMatrix && this->TensorRotationMatrix->Determinant() < 0 );
+
+  vtkIdType numOutPts = numGlyphs * numDirs * job.NumberOfSourcePoints;
+  vtkNew<vtkPoints> newPts;
+  newPts->SetDataTypeToFloat();
+  newPts->SetNumberOfPoints(numOutPts);
+  job.Points = vtkFloatArray::SafeDownCast(newPts->GetData())->GetPointer(0);
+
+  // generate scalars if eigenvalues are chosen or if scalars exist.
+  vtkSmartPointer<vtkFloatArray> newScalars;
+  job.InputScalars = NULL;
+  job.ComputeScalars = 0;
+  if (this->ColorGlyphs &&
+      ((this->ColorMode == COLOR_BY_EIGENVALUES) ||
+       (inScalars && (this->ColorMode == COLOR_BY_SCALARS)) ) )
+    {
+    if (inScalars && this->ColorMode == COLOR_BY_SCALARS)
+      {
+      job.InputScalars = inScalars;
+      }
+    else
+      {
+      job.ComputeScalars = 1;
+      }
+    newScalars = vtkSmartPointer<vtkFloatArray>::New();
+    newScalars->SetNumberOfTuples(numOutPts);
+    job.Scalars = newScalars->GetPointer(0);
+    }
+
+  vtkSmartPointer<vtkFloatArray> newNormals;
+  vtkSmartPointer<vtkFloatArray> newScales;
+  vtkSmartPointer<vtkFloatArray> newOrientations;
+  vtkNew<vtkCellArray> cells[4];
+  if (job.Instances)
+    {
+    newScales = vtkSmartPointer<vtkFloatArray>::New();
+    newScales->SetName(vtkDiffusionTensorGlyph::GetGlyphScaleArrayName());
+    newScales->SetNumberOfComponents(3);
+    newScales->SetNumberOfTuples(numOutPts);
+    job.Scales = newScales->GetPointer(0);
+    newOrientations = vtkSmartPointer<vtkFloatArray>::New();
+    newOrientations->SetName(vtkDiffusionTensorGlyph::GetGlyphOrientationArrayName());
+    newOrientations->SetNumberOfComponents(3);
+    newOrientations->SetNumberOfTuples(numOutPts);
+    job.Orientations = newOrientations->GetPointer(0);
+    }
+  else
+    {
+    vtkPoints* sourcePts = source->GetPoints();
+    job.SourcePoints.resize(3*job.NumberOfSourcePoints);
+    for (vtkIdType i = 0; i < job.NumberOfSourcePoints; i++)
+      {
+      sourcePts->GetPoint(i, &job.SourcePoints[3*i]);
+      }
+    vtkDataArray* sourceNormals = source->GetPointData()->GetNormals();
+    if (sourceNormals)
+      {
+      job.SourceNormals.resize(3*job.NumberOfSourcePoints);
+      for (vtkIdType i = 0; i < job.NumberOfSourcePoints; i++)
+        {
+        sourceNormals->GetTuple(i, &job.SourceNormals[3*i]);
+        }
+      newNormals = vtkSmartPointer<vtkFloatArray>::New();
+      newNormals->SetNumberOfComponents(3);
+      newNormals->SetNumberOfTuples(numOutPts);
+      job.Normals = newNormals->GetPointer(0);
+      }
 
-        // Apply the transformation to a series of points,
-        // and append the results to outPts.
-        if ( newNormals )
+    // Connectivity of one glyph: same cell order as inserting each source cell
+    // for each direction.
+    vtkCellArray* sourceCells[4] = { source->GetVerts(), source->GetLines(), source->GetPolys(), source->GetStrips() };
+    for (int type = 0; type < 4; type++)
+      {
+      if (!sourceCells[type] || sourceCells[type]->GetNumberOfCells() == 0)
+        {
+        continue;
+        }
+      vtkIdType npts;
+      vtkIdType *pts;
+      for (sourceCells[type]->InitTraversal(); sourceCells[type]->GetNextCell(npts, pts); )
+        {
+        for (int dir = 0; dir < numDirs; dir++)
           {
-          if ( flipNormals )
+          job.SourceCells[type].push_back(npts);
+          for (vtkIdType i = 0; i < npts; i++)
             {
-            trans->Scale(-1.,-1.,-1.);
-            trans->TransformNormals(sourceNormals,newNormals);
-            trans->Scale(-1.,-1.,-1.);
-            }
-          else
-            {
-            trans->TransformNormals(sourceNormals,newNormals);
+            job.SourceCells[type].push_back(pts[i] + dir*job.NumberOfSourcePoints);
             }
           }
+        }
+      job.NumberOfGlyphCells[type] = numDirs * sourceCells[type]->GetNumberOfCells();
+      job.Cells[type] = cells[type]->WritePointer(numGlyphs * job.NumberOfGlyphCells[type],
+        numGlyphs * static_cast<vtkIdType>(job.SourceCells[type].size()));
+      }
+    }
 
-        // Keep track of the number of points output so far.
-        ptOffset += numSourcePts;
-        } // end for number of dirs
-      } // end if mask is 1 OR trace is ok (so tensor was glyphed)
-    } // end loop over input points
-
-  vtkDebugMacro(<<"Generated " << numInputPts <<" tensor glyphs");
+  vtkDebugMacro(<<"Generating tensor glyphs: TRAVERSE POINTS");
+  vtkDebugMacro("Scalar coloring (" <<  this->ColorMode << ")  ["<< vtkTensorGlyph::COLOR_BY_EIGENVALUES << "] is evals. Scalar Invariant (" << this->ScalarInvariant << ")") ;
 
   //
-  // Update output and release memory
+  // Generate the glyphs in parallel
   //
-  delete [] pts;
+  if (numGlyphs > 0)
+    {
+    vtkNew<vtkMultiThreader> threader;
+    int numberOfThreads = (this->NumberOfThreads > 0 ? this->NumberOfThreads : threader->GetNumberOfThreads());
+    // a few hundred glyphs are not worth starting a thread
+    vtkIdType maxNumberOfThreads = numGlyphs / 256 + 1;
+    if (numberOfThreads > maxNumberOfThreads)
+      {
+      numberOfThreads = static_cast<int>(maxNumberOfThreads);
+      }
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(GenerateGlyphsThread, &job);
+    threader->SingleMethodExecute();
+    }
+  if (this->GetAbortExecute())
+    {
+    output->Initialize();
+    return 1;
+    }
+  this->UpdateProgress(1.0);
 
-  output->SetPoints(newPts);
-  newPts->Delete();
+  vtkDebugMacro(<<"Generated " << numGlyphs <<" tensor glyphs");
+
+  //
+  // Update output
+  //
+  output->SetPoints(newPts.GetPointer());
+  if (job.Instances)
+    {
+    vtkIdType* verts = cells[0]->WritePointer(numOutPts, 2*numOutPts);
+    for (vtkIdType i = 0; i < numOutPts; i++)
+      {
+      verts[2*i] = 1;
+      verts[2*i+1] = i;
+      }
+    output->SetVerts(cells[0].GetPointer());
+    outPD->AddArray(newScales);
+    outPD->AddArray(newOrientations);
+    }
+  else
+    {
+    if (job.NumberOfGlyphCells[0] > 0)
+      {
+      output->SetVerts(cells[0].GetPointer());
+      }
+    if (job.NumberOfGlyphCells[1] > 0)
+      {
+      output->SetLines(cells[1].GetPointer());
+      }
+    if (job.NumberOfGlyphCells[2] > 0)
+      {
+      output->SetPolys(cells[2].GetPointer());
+      }
+    if (job.NumberOfGlyphCells[3] > 0)
+      {
+      output->SetStrips(cells[3].GetPointer());
+      }
+    }
 
   if ( newScalars )
     {
     int idx = outPD->AddArray(newScalars);
     outPD->SetActiveAttribute(idx, vtkDataSetAttributes::SCALARS);
-    newScalars->Delete();
+    }
+  else if ( !job.Instances )
+    {
+    // only copy scalar data through
+    // (superclass does this but why? if user has not asked for ColorGlyphs)
+    vtkPointData* sourcePD = source->GetPointData();
+    outPD->CopyAllOff();
+    outPD->CopyScalarsOn();
+    outPD->CopyAllocate(sourcePD, numOutPts);
+    for (vtkIdType ptOffset = 0; ptOffset < numOutPts; ptOffset += job.NumberOfSourcePoints)
+      {
+      for (vtkIdType i = 0; i < job.NumberOfSourcePoints; i++)
+        {
+        outPD->CopyData(sourcePD, i, ptOffset+i);
+        }
+      }
     }
 
   if ( newNormals )
     {
     outPD->SetNormals(newNormals);
-    newNormals->Delete();
     }
 
-  output->Squeeze();
-  trans->Delete();
-  matrix->Delete();
+  vtkDebugMacro("glyph time: " << clock() - tStart );
 
-  if ( userVolumeTransform )
-    {
-    userVolumeTransform->Delete();
-    }
+  return 1;
+}
 
-  vtkDebugMacro("glyph time: " << clock() - tStart );
+//----------------------------------------------------------------------------
+const char* vtkDiffusionTensorGlyph::GetGlyphScaleArrayName()
+{
+  return "GlyphScale";
+}
+
+//----------------------------------------------------------------------------
+const char* vtkDiffusionTensorGlyph::GetGlyphOrientationArrayName()
+{
+  return "GlyphOrientation";
+}
 
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorGlyph::FillInputPortInformation(int port, vtkInformation *info)
+{
+  if (!this->Superclass::FillInputPortInformation(port, info))
+    {
+    return 0;
+    }
+  if (port == 1)
+    {
+    // glyph geometry is not needed for generating glyph instances
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+    }
   return 1;
 }
 
@@ -762,6 +1095,10 @@ void vtkDiffusionTensorGlyph::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Color Glyphs by Scalar Invariant: " << this->ScalarInvariant << "\n";
   os << indent << "Mask Glyphs: " << (this->MaskGlyphs ? "On\n" : "Off\n");
   os << indent << "Resolution: " << this->Resolution << endl;
+  os << indent << "MaximumNumberOfGlyphs: " << this->MaximumNumberOfGlyphs << endl;
+  os << indent << "MaximumGlyphDensity: " << this->MaximumGlyphDensity << endl;
+  os << indent << "OutputGlyphInstances: " << (this->OutputGlyphInstances ? "On\n" : "Off\n");
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
 
   // print objects
   if ( this->VolumePositionMatrix )
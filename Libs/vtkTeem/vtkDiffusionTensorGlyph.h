@@ -65,6 +65,11 @@ class vtkMatrix4x4;
 /// functions are scalar invariants of the diffusion tensor.  They are selected
 /// by calling ColorGlyphsByFractionalAnisotropy, etc.
 ///
+/// Glyphs are generated in parallel. Instead of the glyph geometry, the output
+/// can contain one point per glyph with the orientation and the scale of the
+/// glyph (see OutputGlyphInstances), to render them with instancing
+/// (vtkGlyph3DMapper).
+///
 /// \sa vtkTensorGlyph
 /// \sa vtkDiffusionTensorMathematics
 /// \sa vtkSuperquadricTensorGlyph
@@ -107,6 +112,12 @@ public:
   void ColorGlyphsByFractionalAnisotropy();
   void ColorGlyphsByTrace();
 
+  ///
+  /// Output one component scalars according to a scalar invariant
+  /// (see vtkDiffusionTensorMathematics operations)
+  void ColorGlyphsBy(int measure);
+  vtkGetMacro(ScalarInvariant, int);
+
   ///
   /// Output R,G,B scalars according to orientation of max eigenvalue
   void ColorGlyphsByOrientation();
@@ -161,6 +172,42 @@ public:
   vtkGetVector2Macro(DimensionResolution, int);
   vtkSetVector2Macro(DimensionResolution, int);
 
+  ///
+  /// Maximum number of glyphs. If sampling the input with the resolution would
+  /// produce more glyphs, the sampling is coarsened uniformly. When the input is
+  /// a slice of a view, this limits the glyph density on screen.
+  /// 0 (default) means no limit.
+  vtkSetClampMacro(MaximumNumberOfGlyphs, vtkIdType, 0, VTK_ID_MAX);
+  vtkGetMacro(MaximumNumberOfGlyphs, vtkIdType);
+
+  ///
+  /// Maximum number of glyphs per input point, applied the same way as
+  /// MaximumNumberOfGlyphs. For example, 1/16 allows at most one glyph per 4x4
+  /// pixels of a slice. 0 (default) means no limit.
+  vtkSetClampMacro(MaximumGlyphDensity, double, 0.0, 1.0);
+  vtkGetMacro(MaximumGlyphDensity, double);
+
+  ///
+  /// If enabled, the output contains one vertex per glyph instead of the glyph
+  /// geometry, with the scale (GetGlyphScaleArrayName()) and the orientation
+  /// (GetGlyphOrientationArrayName(), rotation angles in degrees about the X, Y, Z
+  /// axes as in vtkProp3D) of the glyph. It can be rendered with a vtkGlyph3DMapper
+  /// using the glyph source, in ROTATION orientation mode and
+  /// SCALE_BY_VECTORCOMPONENTS scale mode. Glyph source is not required.
+  /// Disabled by default.
+  vtkSetMacro(OutputGlyphInstances, int);
+  vtkGetMacro(OutputGlyphInstances, int);
+  vtkBooleanMacro(OutputGlyphInstances, int);
+
+  static const char* GetGlyphScaleArrayName();
+  static const char* GetGlyphOrientationArrayName();
+
+  ///
+  /// Number of threads used for generating glyphs.
+  /// If 0 (default) then the global default number of threads is used.
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX);
+  vtkGetMacro(NumberOfThreads, int);
+
   ///
   /// When determining the modified time of the filter,
   /// this checks the modified time of the mask input,
@@ -172,8 +219,7 @@ protected:
   ~vtkDiffusionTensorGlyph();
 
   virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
-
-  void ColorGlyphsBy(int measure);
+  virtual int FillInputPortInformation(int port, vtkInformation *info);
 
   int ScalarInvariant;  /// which function of eigenvalues to use for coloring
   int MaskGlyphs;  /// mask glyphs outside of the brain for example, using the Mask
@@ -181,6 +227,11 @@ protected:
 
   int DimensionResolution[2];
 
+  vtkIdType MaximumNumberOfGlyphs;
+  double MaximumGlyphDensity;
+  int OutputGlyphInstances;
+  int NumberOfThreads;
+
   vtkMatrix4x4 *VolumePositionMatrix;
   vtkMatrix4x4 *TensorRotationMatrix;
 
@@ -20,9 +20,11 @@
 // But, if you are on VS6.0 you don't get the define...
 #include "vtkDataArray.h"
 #include "vtkInformation.h"
+#include "vtkInformationObjectBaseKey.h"
 #include "vtkInformationVector.h"
 #include "vtkImageData.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkDiffusionTensorEigensystemCache.h"
 #include "vtkDiffusionTensorMathematics.h"
 #include "vtkMath.h"
 #include "vtkObjectFactory.h"
@@ -79,6 +81,7 @@ vtkDiffusionTensorMathematics::vtkDiffusionTensorMathematics()
      {
      this->ScalarMask->Delete();
      }
+   this->ReleaseEigensystemCache();
  }
 
 //----------------------------------------------------------------------------
@@ -143,7 +146,28 @@ int vtkDiffusionTensorMathematics
 ::RequestData(vtkInformation* request, vtkInformationVector** inputVector,
               vtkInformationVector* outputVector)
 {
+  // Compute the eigensystem of all input tensors before the threads start (or reuse
+  // it if it was computed for another operation or by another filter).
+  vtkImageData* inData = vtkImageData::GetData(inputVector[0]);
+  vtkDataArray* inTensors = (inData && inData->GetPointData() ? inData->GetPointData()->GetTensors() : NULL);
+  if (inTensors != this->EigensystemCacheTensors.GetPointer())
+    {
+    this->ReleaseEigensystemCache();
+    }
+  if (inTensors && this->ExtractEigenvalues && this->IsEigenOperation(this->Operation))
+    {
+    this->EigensystemCache = vtkDiffusionTensorEigensystemCache::GetCache(inTensors, inData);
+    this->EigensystemCacheTensors = inTensors;
+    }
+
   int res = this->Superclass::RequestData(request, inputVector, outputVector);
+
+  // The output is released after it has been consumed, the eigensystems
+  // should not outlive it.
+  if (this->GetReleaseDataFlag())
+    {
+    this->ReleaseEigensystemCache();
+    }
   for (int i = 0; i < this->GetNumberOfOutputPorts(); ++i)
     {
     vtkInformation* info = outputVector->GetInformationObject(i);
@@ -154,6 +178,22 @@ int vtkDiffusionTensorMathematics
   return res;
 }
 
+//----------------------------------------------------------------------------
+void vtkDiffusionTensorMathematics::ReleaseEigensystemCache()
+{
+  vtkDataArray* tensors = this->EigensystemCacheTensors.GetPointer();
+  // Other filters may have replaced the cache since, it is theirs then
+  if (tensors && this->EigensystemCache.GetPointer()
+    && tensors->HasInformation()
+    && tensors->GetInformation()->Get(vtkDiffusionTensorEigensystemCache::EIGENSYSTEM_CACHE())
+       == this->EigensystemCache.GetPointer())
+    {
+    vtkDiffusionTensorEigensystemCache::RemoveCache(tensors);
+    }
+  this->EigensystemCache = NULL;
+  this->EigensystemCacheTensors = NULL;
+}
+
 //----------------------------------------------------------------------------
 static void GetContinuousIncrements(vtkImageData* img, int extent[6], vtkIdType &incX,
                                     vtkIdType &incY, vtkIdType &incZ)
@@ -451,6 +491,11 @@ static void vtkDiffusionTensorMathematicsExecute1Eigen(vtkDiffusionTensorMathema
 
   // decide whether to extract eigenfunctions or just use input cols
   extractEigenvalues = self->GetExtractEigenvalues();
+  // eigensystems computed in RequestData
+  vtkDiffusionTensorEigensystemCache* eigensystemCache = (extractEigenvalues ?
+    vtkDiffusionTensorEigensystemCache::GetUpToDateCache(inTensors, in1Data) : NULL);
+  vtkIdType ptId = 0;
+  int rowStart[3] = { outExt[0], outExt[2], outExt[4] };
 
   // transformation of tensor orientations for coloring
   vtkTransform *trans = vtkTransform::New();
@@ -494,7 +539,14 @@ static void vtkDiffusionTensorMathematicsExecute1Eigen(vtkDiffusionTensorMathema
         count++;
         }
 
-      for (idxR = 0; idxR < rowLength; idxR++)
+      if (eigensystemCache)
+        {
+        rowStart[1] = outExt[2] + idxY;
+        rowStart[2] = outExt[4] + idxZ;
+        ptId = in1Data->ComputePointId(rowStart);
+        }
+
+      for (idxR = 0; idxR < rowLength; idxR++, ptId++)
         {
         if (doMasking && *inMaskPtr != self->GetMaskLabelValue())
           {
@@ -524,7 +576,19 @@ static void vtkDiffusionTensorMathematicsExecute1Eigen(vtkDiffusionTensorMathema
           tensor[2][2] = static_cast<double>(inPtr[8]);
 
           // get eigenvalues and eigenvectors appropriately
-          if (extractEigenvalues)
+          if (eigensystemCache)
+            {
+            const float* cachedEigenvalues = eigensystemCache->GetEigenvalues(ptId);
+            const float* cachedEigenvectors = eigensystemCache->GetEigenvectors(ptId);
+            for (i=0; i<3; i++)
+              {
+              w[i] = cachedEigenvalues[i];
+              v[i][0] = cachedEigenvectors[3*i];
+              v[i][1] = cachedEigenvectors[3*i+1];
+              v[i][2] = cachedEigenvectors[3*i+2];
+              }
+            }
+          else if (extractEigenvalues)
             {
             for (j=0; j<3; j++)
               {
@@ -536,7 +600,7 @@ static void vtkDiffusionTensorMathematicsExecute1Eigen(vtkDiffusionTensorMathema
               }
             // compute eigensystem
             //vtkMath::Jacobi(m, w, v);
-            vtkDiffusionTensorMathematics::TeemEigenSolver(m,w,v);
+            vtkDiffusionTensorMathematics::ClosedFormEigenSolver(m,w,v);
             }
           else
             {
@@ -908,6 +972,36 @@ void vtkDiffusionTensorMathematics::ThreadedRequestData(
 }
 
 
+//----------------------------------------------------------------------------
+bool vtkDiffusionTensorMathematics::IsEigenOperation(int operation)
+{
+  switch (operation)
+    {
+    case VTK_TENS_RELATIVE_ANISOTROPY:
+    case VTK_TENS_FRACTIONAL_ANISOTROPY:
+    case VTK_TENS_LINEAR_MEASURE:
+    case VTK_TENS_PLANAR_MEASURE:
+    case VTK_TENS_SPHERICAL_MEASURE:
+    case VTK_TENS_MAX_EIGENVALUE:
+    case VTK_TENS_MID_EIGENVALUE:
+    case VTK_TENS_MIN_EIGENVALUE:
+    case VTK_TENS_MAX_EIGENVALUE_PROJX:
+    case VTK_TENS_MAX_EIGENVALUE_PROJY:
+    case VTK_TENS_MAX_EIGENVALUE_PROJZ:
+    case VTK_TENS_RAI_MAX_EIGENVEC_PROJX:
+    case VTK_TENS_RAI_MAX_EIGENVEC_PROJY:
+    case VTK_TENS_RAI_MAX_EIGENVEC_PROJZ:
+    case VTK_TENS_COLOR_ORIENTATION:
+    case VTK_TENS_MODE:
+    case VTK_TENS_COLOR_MODE:
+    case VTK_TENS_PARALLEL_DIFFUSIVITY:
+    case VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
+      return true;
+    default:
+      return false;
+    }
+}
+
 //Fix negative Eigen with a shift
 /*
 int  vtkDiffusionTensorMathematics::FixNegativeEigenvaluesMethod(double w[3])
@@ -1354,3 +1448,175 @@ int vtkDiffusionTensorMathematics::TeemEigenSolver(double **m, double *w, double
     return res;
 
 }
+
+
+//----------------------------------------------------------------------------
+// Eigenvalues are computed by the trigonometric solution of the characteristic
+// polynomial. The eigenvector of the eigenvalue that is farthest from the two
+// others is the cross product of two rows of (A - lambda I); the two other
+// eigenvectors are found in its orthogonal plane, where the problem is 2x2.
+// This remains accurate for repeated eigenvalues (where the cross product
+// would be degenerate). a contains the upper triangle of the matrix
+// (xx, xy, xz, yy, yz, zz), e[c] is the c-th eigenvector.
+static inline void vtkDiffusionTensorMathematicsEigensystem(const double a[6], double w[3], double e[3][3])
+{
+  const double a00 = a[0], a01 = a[1], a02 = a[2], a11 = a[3], a12 = a[4], a22 = a[5];
+  const double q = (a00 + a11 + a22) / 3.0;
+  const double b00 = a00 - q;
+  const double b11 = a11 - q;
+  const double b22 = a22 - q;
+  const double p1 = a01*a01 + a02*a02 + a12*a12;
+  const double p2 = b00*b00 + b11*b11 + b22*b22 + 2.0*p1;
+  if (!(p2 > 1e-30 * (q*q)) || p2 == 0.0)
+    {
+    // isotropic tensor, any orthonormal basis is an eigenbasis
+    w[0] = w[1] = w[2] = q;
+    e[0][0] = 1.0; e[0][1] = 0.0; e[0][2] = 0.0;
+    e[1][0] = 0.0; e[1][1] = 1.0; e[1][2] = 0.0;
+    e[2][0] = 0.0; e[2][1] = 0.0; e[2][2] = 1.0;
+    return;
+    }
+  const double p = sqrt(p2 / 6.0);
+  const double detB = b00*(b11*b22 - a12*a12) - a01*(a01*b22 - a12*a02) + a02*(a01*a12 - b11*a02);
+  double r = detB / (2.0*p*p*p);
+  r = (r < -1.0 ? -1.0 : (r > 1.0 ? 1.0 : r));
+  const double phi = acos(r) / 3.0;
+  const double cosPhi = cos(phi);
+  const double sinPhi = sqrt(1.0 - cosPhi*cosPhi); // phi is in [0, pi/3]
+  w[0] = q + 2.0*p*cosPhi;
+  // cos(phi + 2pi/3) = -cos(phi)/2 - sqrt(3)/2 sin(phi)
+  w[2] = q - p*(cosPhi + 1.7320508075688772*sinPhi);
+  w[1] = 3.0*q - w[0] - w[2];
+  // keep the order when rounding moves the middle eigenvalue past a repeated one
+  w[1] = (w[1] > w[0] ? w[0] : (w[1] < w[2] ? w[2] : w[1]));
+
+  // eigenvector of the eigenvalue that is farther from the others is computed from
+  // the cross products of rows of (A - lambda I), the two others in its orthogonal plane
+  const int first = ((w[0] - w[1]) >= (w[1] - w[2])) ? 0 : 2;
+  const double lambda = w[first];
+  const double r0[3] = { a00 - lambda, a01, a02 };
+  const double r1[3] = { a01, a11 - lambda, a12 };
+  const double r2[3] = { a02, a12, a22 - lambda };
+  double c[3][3] =
+    {
+    { r0[1]*r1[2] - r0[2]*r1[1], r0[2]*r1[0] - r0[0]*r1[2], r0[0]*r1[1] - r0[1]*r1[0] },
+    { r0[1]*r2[2] - r0[2]*r2[1], r0[2]*r2[0] - r0[0]*r2[2], r0[0]*r2[1] - r0[1]*r2[0] },
+    { r1[1]*r2[2] - r1[2]*r2[1], r1[2]*r2[0] - r1[0]*r2[2], r1[0]*r2[1] - r1[1]*r2[0] }
+    };
+  double n[3] =
+    {
+    c[0][0]*c[0][0] + c[0][1]*c[0][1] + c[0][2]*c[0][2],
+    c[1][0]*c[1][0] + c[1][1]*c[1][1] + c[1][2]*c[1][2],
+    c[2][0]*c[2][0] + c[2][1]*c[2][1] + c[2][2]*c[2][2]
+    };
+  int best = (n[0] >= n[1]) ? 0 : 1;
+  best = (n[best] >= n[2]) ? best : 2;
+  double* v = e[first];
+  const double invNorm = 1.0 / sqrt(n[best]);
+  v[0] = c[best][0] * invNorm;
+  v[1] = c[best][1] * invNorm;
+  v[2] = c[best][2] * invNorm;
+
+  // orthonormal basis (u, t) of the plane orthogonal to v
+  double u[3];
+  if (fabs(v[0]) > fabs(v[1]))
+    {
+    const double s = 1.0 / sqrt(v[0]*v[0] + v[2]*v[2]);
+    u[0] = -v[2]*s; u[1] = 0.0; u[2] = v[0]*s;
+    }
+  else
+    {
+    const double s = 1.0 / sqrt(v[1]*v[1] + v[2]*v[2]);
+    u[0] = 0.0; u[1] = v[2]*s; u[2] = -v[1]*s;
+    }
+  const double t[3] = { v[1]*u[2] - v[2]*u[1], v[2]*u[0] - v[0]*u[2], v[0]*u[1] - v[1]*u[0] };
+
+  // restriction of A to the plane, its largest eigenvalue is w[1] (first=0) or w[0] (first=2)
+  const double Au[3] = { a00*u[0] + a01*u[1] + a02*u[2], a01*u[0] + a11*u[1] + a12*u[2], a02*u[0] + a12*u[1] + a22*u[2] };
+  const double At[3] = { a00*t[0] + a01*t[1] + a02*t[2], a01*t[0] + a11*t[1] + a12*t[2], a02*t[0] + a12*t[1] + a22*t[2] };
+  const double m00 = u[0]*Au[0] + u[1]*Au[1] + u[2]*Au[2];
+  const double m01 = u[0]*At[0] + u[1]*At[1] + u[2]*At[2];
+  const double m11 = t[0]*At[0] + t[1]*At[1] + t[2]*At[2];
+  // eigenvector of the largest eigenvalue of [m00 m01; m01 m11]: (m01, l-m00) or (l-m11, m01)
+  const double halfDiff = 0.5*(m00 - m11);
+  const double l = 0.5*(m00 + m11) + sqrt(halfDiff*halfDiff + m01*m01);
+  double cu = m01, ct = l - m00;
+  if (cu*cu + ct*ct < (l - m11)*(l - m11) + m01*m01)
+    {
+    cu = l - m11;
+    ct = m01;
+    }
+  const double norm2 = cu*cu + ct*ct;
+  if (norm2 > 0.0)
+    {
+    const double s = 1.0 / sqrt(norm2);
+    cu *= s;
+    ct *= s;
+    }
+  else
+    {
+    // repeated eigenvalue in the plane, any direction is an eigenvector
+    cu = 1.0;
+    ct = 0.0;
+    }
+  double* vLarge = (first == 0) ? e[1] : e[0];
+  double* vOther = (first == 0) ? e[2] : e[1];
+  vLarge[0] = cu*u[0] + ct*t[0];
+  vLarge[1] = cu*u[1] + ct*t[1];
+  vLarge[2] = cu*u[2] + ct*t[2];
+  // right-handed eigenbasis: e2 = e0 x e1
+  const double* x = (first == 0) ? e[0] : e[2];
+  const double* y = (first == 0) ? e[1] : e[0];
+  vOther[0] = x[1]*y[2] - x[2]*y[1];
+  vOther[1] = x[2]*y[0] - x[0]*y[2];
+  vOther[2] = x[0]*y[1] - x[1]*y[0];
+}
+
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorMathematics::ClosedFormEigenSolver(double **m, double *w, double **v)
+{
+  double a[6] = { m[0][0], m[0][1], m[0][2], m[1][1], m[1][2], m[2][2] };
+  double e[3][3];
+  vtkDiffusionTensorMathematicsEigensystem(a, w, e);
+  if (v != NULL)
+    {
+    for (int c = 0; c < 3; c++)
+      {
+      v[0][c] = e[c][0];
+      v[1][c] = e[c][1];
+      v[2][c] = e[c][2];
+      }
+    }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkDiffusionTensorMathematics::ComputeEigensystems(const float* tensors, vtkIdType numberOfTensors,
+                                                        float* eigenvalues, float* eigenvectors)
+{
+  double a[6];
+  double w[3];
+  double e[3][3];
+  for (vtkIdType tensorId = 0; tensorId < numberOfTensors; tensorId++)
+    {
+    a[0] = tensors[0];
+    a[1] = tensors[1];
+    a[2] = tensors[2];
+    a[3] = tensors[4];
+    a[4] = tensors[5];
+    a[5] = tensors[8];
+    vtkDiffusionTensorMathematicsEigensystem(a, w, e);
+    eigenvalues[0] = static_cast<float>(w[0]);
+    eigenvalues[1] = static_cast<float>(w[1]);
+    eigenvalues[2] = static_cast<float>(w[2]);
+    for (int c = 0; c < 3; c++)
+      {
+      eigenvectors[c] = static_cast<float>(e[c][0]);
+      eigenvectors[3+c] = static_cast<float>(e[c][1]);
+      eigenvectors[6+c] = static_cast<float>(e[c][2]);
+      }
+    tensors += 9;
+    eigenvalues += 3;
+    eigenvectors += 9;
+    }
+}
@@ -31,7 +31,10 @@
 
 // VTK includes
 #include <vtkThreadedImageAlgorithm.h>
+#include <vtkWeakPointer.h>
 
+class vtkDataArray;
+class vtkDiffusionTensorEigensystemCache;
 class vtkMatrix4x4;
 class vtkImageData;
 class VTK_Teem_EXPORT vtkDiffusionTensorMathematics : public vtkThreadedImageAlgorithm
@@ -236,6 +239,10 @@ public:
   static void RGBToIndex(double R, double G,
                   double B, double &index);
 
+  ///
+  /// Returns true if the operation requires the eigensystem of the tensors
+  static bool IsEigenOperation(int operation);
+
   ///
   /// Helper functions to perform operations pixel-wise
   static int FixNegativeEigenvaluesMethod(double w[3]);
@@ -267,6 +274,19 @@ public:
   //Description
   //Wrap function to teem eigen solver
   static int TeemEigenSolver(double **m, double *w, double **v);
+
+  ///
+  /// Closed-form (non-iterative) eigensolver for symmetric 3x3 matrices.
+  /// Same conventions as TeemEigenSolver: eigenvalues are sorted in decreasing
+  /// order and eigenvectors are the columns of v. Only the upper triangle of m is used.
+  static int ClosedFormEigenSolver(double **m, double *w, double **v);
+
+  ///
+  /// Compute eigensystems of consecutive tensors (9 values each) with the closed-form
+  /// eigensolver. Eigenvalues (3 values per tensor) are sorted in decreasing order,
+  /// eigenvectors (9 values per tensor) are the columns of a row-major 3x3 matrix.
+  static void ComputeEigensystems(const float* tensors, vtkIdType numberOfTensors,
+                                  float* eigenvalues, float* eigenvectors);
   void ComputeTensorIncrements(vtkImageData *imageData, vtkIdType incr[3]);
 
 protected:
@@ -284,6 +304,13 @@ protected:
   vtkMatrix4x4 *TensorRotationMatrix;
   int FixNegativeEigenvalues;
 
+  /// Eigensystem cache requested by this filter and the tensors that store it.
+  /// The cache is removed from the tensors when the output of the filter is
+  /// released, the input tensors change, or the filter is deleted.
+  vtkWeakPointer<vtkDiffusionTensorEigensystemCache> EigensystemCache;
+  vtkWeakPointer<vtkDataArray> EigensystemCacheTensors;
+  void ReleaseEigensystemCache();
+
   virtual int RequestInformation (vtkInformation*,
                                   vtkInformationVector**,
                                   vtkInformationVector*);
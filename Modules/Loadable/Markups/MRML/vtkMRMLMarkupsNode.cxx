@@ -33,6 +33,7 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkStringArray.h>
 
@@ -735,6 +736,71 @@ void vtkMRMLMarkupsNode::SetMarkupPoint(const int markupIndex, const int pointIn
   this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointModifiedEvent, (void*)&markupIndex);
 }
 
+//-----------------------------------------------------------
+void vtkMRMLMarkupsNode::GetMarkupPoints(vtkPoints* points)
+{
+  if (!points)
+    {
+    vtkErrorMacro("GetMarkupPoints: invalid points");
+    return;
+    }
+  vtkIdType numberOfPoints = 0;
+  for (std::vector<Markup>::iterator markupIt = this->Markups.begin(); markupIt != this->Markups.end(); ++markupIt)
+    {
+    numberOfPoints += static_cast<vtkIdType>(markupIt->points.size());
+    }
+  points->SetNumberOfPoints(numberOfPoints);
+  vtkIdType pointId = 0;
+  for (std::vector<Markup>::iterator markupIt = this->Markups.begin(); markupIt != this->Markups.end(); ++markupIt)
+    {
+    for (std::vector<vtkVector3d>::iterator pointIt = markupIt->points.begin(); pointIt != markupIt->points.end(); ++pointIt)
+      {
+      points->SetPoint(pointId++, pointIt->GetData());
+      }
+    }
+}
+
+//-----------------------------------------------------------
+void vtkMRMLMarkupsNode::SetMarkupPoints(vtkPoints* points)
+{
+  if (!points)
+    {
+    vtkErrorMacro("SetMarkupPoints: invalid points");
+    return;
+    }
+  int wasModifying = this->StartModify();
+  vtkIdType numberOfPoints = 0;
+  for (std::vector<Markup>::iterator markupIt = this->Markups.begin(); markupIt != this->Markups.end(); ++markupIt)
+    {
+    numberOfPoints += static_cast<vtkIdType>(markupIt->points.size());
+    }
+  if (numberOfPoints == points->GetNumberOfPoints())
+    {
+    vtkIdType pointId = 0;
+    for (std::vector<Markup>::iterator markupIt = this->Markups.begin(); markupIt != this->Markups.end(); ++markupIt)
+      {
+      for (std::vector<vtkVector3d>::iterator pointIt = markupIt->points.begin(); pointIt != markupIt->points.end(); ++pointIt)
+        {
+        double* position = points->GetPoint(pointId++);
+        pointIt->Set(position[0], position[1], position[2]);
+        }
+      }
+    }
+  else
+    {
+    this->RemoveAllMarkups();
+    for (vtkIdType pointId = 0; pointId < points->GetNumberOfPoints(); ++pointId)
+      {
+      double* position = points->GetPoint(pointId);
+      this->AddPointToNewMarkup(vtkVector3d(position[0], position[1], position[2]));
+      }
+    }
+  // Observers update all the points on ModifiedEvent, PointModifiedEvent
+  // would require an event per markup.
+  this->Modified();
+  this->EndModify(wasModifying);
+}
+
 //-----------------------------------------------------------
 void vtkMRMLMarkupsNode::SetMarkupPointLPS(const int markupIndex, const int pointIndex,
                                         const double x, const double y, const double z)
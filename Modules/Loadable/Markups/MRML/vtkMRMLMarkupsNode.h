@@ -28,8 +28,9 @@
 #include <vtkSmartPointer.h>
 #include <vtkVector.h>
 
-class vtkStringArray;
 class vtkMatrix4x4;
+class vtkPoints;
+class vtkStringArray;
 
 /// see doxygen enabled comment in class description
 typedef struct
@@ -207,6 +208,18 @@ public:
   /// Returns 0 on failure, 1 on success.
   int GetMarkupPointWorld(int markupIndex, int pointIndex, double worldxyz[4]);
 
+  /// Get the positions of the points of all markups: all the points of the
+  /// first markup, then all the points of the second markup, etc.
+  /// Positions are copied, markup points are not stored in a contiguous buffer.
+  /// \sa SetMarkupPoints
+  void GetMarkupPoints(vtkPoints* points);
+  /// Set the positions of the points of all markups, in the order of GetMarkupPoints.
+  /// If the number of points is different from the current total number of points
+  /// then all markups are removed and a single point markup is added for each point.
+  /// Only one ModifiedEvent is invoked (plus markup added/removed events if the number changes).
+  /// \sa GetMarkupPoints
+  void SetMarkupPoints(vtkPoints* points);
+
   /// Remove a markup
   void RemoveMarkup(int m);
 
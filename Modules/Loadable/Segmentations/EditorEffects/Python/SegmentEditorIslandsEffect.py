@@ -2,7 +2,6 @@ import os
 import vtk, qt, ctk, slicer
 import logging
 from SegmentEditorEffects import *
-import vtkITK
 
 class SegmentEditorIslandsEffect(AbstractScriptedSegmentEditorEffect):
   """ Operate on connected components (islands) within a segment
@@ -130,39 +129,36 @@ class SegmentEditorIslandsEffect(AbstractScriptedSegmentEditorEffect):
     # Get modifier labelmap
     selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
 
-    castIn = vtk.vtkImageCast()
-    castIn.SetInputData(selectedSegmentLabelmap)
-    castIn.SetOutputScalarTypeToUnsignedInt()
-
-    # Identify the islands in the inverted volume and
-    # find the pixel that corresponds to the background
-    islandMath = vtkITK.vtkITKIslandMath()
-    islandMath.SetInputConnection(castIn.GetOutputPort())
-    islandMath.SetFullyConnected(False)
-    islandMath.SetMinimumSize(minimumSize)
-    islandMath.Update()
-
-    # Create a separate image for the first (largest) island
-    labelValue = 1
-    backgroundValue = 0
-    thresh = vtk.vtkImageThreshold()
+    # Identify the islands. If islands are not split to segments then the filter directly
+    # outputs the islands to keep (largest or larger than minimum size) as a binary labelmap.
+    import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+    islandFilter = vtkSlicerSegmentationsModuleLogic.vtkImageConnectedComponents()
+    islandFilter.SetInputData(selectedSegmentLabelmap)
+    islandFilter.SetConnectivity(6)
+    islandFilter.SetMinimumSize(minimumSize)
+    islandFilter.SetMaximumNumberOfIslands(maxNumberOfSegments)
+    islandFilter.SetBinaryOutput(not split)
+    islandFilter.Update()
+
     if split:
+      # Create a separate image for the first (largest) island
+      labelValue = 1
+      backgroundValue = 0
+      thresh = vtk.vtkImageThreshold()
       thresh.ThresholdBetween(1, 1)
+      thresh.SetInputData(islandFilter.GetOutput())
+      thresh.SetOutValue(backgroundValue)
+      thresh.SetInValue(labelValue)
+      thresh.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
+      thresh.Update()
+      largestIslandImageData = thresh.GetOutput()
     else:
-      if maxNumberOfSegments != 0:
-        thresh.ThresholdBetween(1, maxNumberOfSegments)
-      else:
-        thresh.ThresholdByUpper(1)
-
-    thresh.SetInputData(islandMath.GetOutput())
-    thresh.SetOutValue(backgroundValue)
-    thresh.SetInValue(labelValue)
-    thresh.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
-    thresh.Update()
+      largestIslandImageData = islandFilter.GetOutput()
+
     # Create oriented image data from output
     import vtkSegmentationCorePython as vtkSegmentationCore
     largestIslandImage = vtkSegmentationCore.vtkOrientedImageData()
-    largestIslandImage.ShallowCopy(thresh.GetOutput())
+    largestIslandImage.ShallowCopy(largestIslandImageData)
     selectedSegmentLabelmapImageToWorldMatrix = vtk.vtkMatrix4x4()
     selectedSegmentLabelmap.GetImageToWorldMatrix(selectedSegmentLabelmapImageToWorldMatrix)
     largestIslandImage.SetImageToWorldMatrix(selectedSegmentLabelmapImageToWorldMatrix)
@@ -171,17 +167,14 @@ class SegmentEditorIslandsEffect(AbstractScriptedSegmentEditorEffect):
 
       thresh2 = vtk.vtkImageThreshold()
       # 0 is background, 1 is largest island; we need label 2 and higher
-      if maxNumberOfSegments != 0:
-        thresh2.ThresholdBetween(2, maxNumberOfSegments)
-      else:
-        thresh2.ThresholdByUpper(2)
-      thresh2.SetInputData(islandMath.GetOutput())
+      thresh2.ThresholdByUpper(2)
+      thresh2.SetInputData(islandFilter.GetOutput())
       thresh2.SetOutValue(backgroundValue)
       thresh2.ReplaceInOff()
       thresh2.Update()
 
-      islandCount = islandMath.GetNumberOfIslands()
-      islandOrigCount = islandMath.GetOriginalNumberOfIslands()
+      islandCount = islandFilter.GetNumberOfIslands()
+      islandOrigCount = islandFilter.GetOriginalNumberOfIslands()
       ignoredIslands = islandOrigCount - islandCount
       logging.info( "%d islands created (%d ignored)" % (islandCount, ignoredIslands) )
 
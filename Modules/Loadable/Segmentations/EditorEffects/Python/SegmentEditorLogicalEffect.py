@@ -199,7 +199,9 @@ class SegmentEditorLogicalEffect(AbstractScriptedSegmentEditorEffect):
         logging.error("Operation {0} requires a selected modifier segment".format(operation))
         return
       modifierSegment = segmentation.GetSegment(modifierSegmentID)
-      modifierSegmentLabelmap = modifierSegment.GetRepresentation(vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
+      # The modifier segment may be stored in a labelmap shared with other segments, only use its own voxels
+      modifierSegmentLabelmap = vtkSegmentationCore.vtkOrientedImageData()
+      modifierSegment.ExtractBinaryLabelmapRepresentation(modifierSegmentLabelmap)
 
       if operation == LOGICAL_COPY:
         if bypassMasking:
@@ -134,35 +134,22 @@ class SegmentEditorMarginEffect(AbstractScriptedSegmentEditorEffect):
     selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
 
     marginSizeMm = self.scriptedEffect.doubleParameter("MarginSizeMm")
-    kernelSizePixel = self.getKernelSizePixel()
-
-    # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-    labelValue = 1
-    backgroundValue = 0
-    thresh = vtk.vtkImageThreshold()
-    thresh.SetInputData(selectedSegmentLabelmap)
-    thresh.ThresholdByLower(0)
-    thresh.SetInValue(backgroundValue)
-    thresh.SetOutValue(labelValue)
-    thresh.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
-
-    erodeDilate = vtk.vtkImageDilateErode3D()
-    erodeDilate.SetInputConnection(thresh.GetOutputPort())
+    # Exact margin is computed from the distance transform of the segment.
+    # Computation time does not depend on the margin size.
+    import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+    marginFilter = vtkSlicerSegmentationsModuleLogic.vtkImageDistanceMorphology()
+    marginFilter.SetInputData(selectedSegmentLabelmap)
     if marginSizeMm>0:
-      # grow
-      erodeDilate.SetDilateValue(labelValue)
-      erodeDilate.SetErodeValue(backgroundValue)
+      marginFilter.SetOperationToGrow()
     else:
-      # shrink
-      erodeDilate.SetDilateValue(backgroundValue)
-      erodeDilate.SetErodeValue(labelValue)
+      marginFilter.SetOperationToShrink()
+    marginFilter.SetDistance(abs(marginSizeMm))
 
     # This can be a long operation - indicate it to the user
     qt.QApplication.setOverrideCursor(qt.Qt.WaitCursor)
 
-    erodeDilate.SetKernelSize(kernelSizePixel[0],kernelSizePixel[1],kernelSizePixel[2])
-    erodeDilate.Update()
-    modifierLabelmap.DeepCopy(erodeDilate.GetOutput())
+    marginFilter.Update()
+    modifierLabelmap.DeepCopy(marginFilter.GetOutput())
 
     # Apply changes
     self.scriptedEffect.modifySelectedSegmentByLabelmap(modifierLabelmap, slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
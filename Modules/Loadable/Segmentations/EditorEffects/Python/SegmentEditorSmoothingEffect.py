@@ -228,28 +228,20 @@ If segments overlap, segment higher in the segments table will have priority. <b
           # Median filter does not require a particular label value
           smoothingFilter = vtk.vtkImageMedian3D()
           smoothingFilter.SetInputData(selectedSegmentLabelmap)
+          smoothingFilter.SetKernelSize(kernelSizePixel[0],kernelSizePixel[1],kernelSizePixel[2])
 
         else:
-          # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-          labelValue = 1
-          backgroundValue = 0
-          thresh = vtk.vtkImageThreshold()
-          thresh.SetInputData(selectedSegmentLabelmap)
-          thresh.ThresholdByLower(0)
-          thresh.SetInValue(backgroundValue)
-          thresh.SetOutValue(labelValue)
-          thresh.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
-
-          smoothingFilter = vtk.vtkImageOpenClose3D()
-          smoothingFilter.SetInputConnection(thresh.GetOutputPort())
+          # Opening and closing with a spherical kernel, computed from the distance transform of the segment.
+          # Computation time does not depend on the kernel size.
+          import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+          smoothingFilter = vtkSlicerSegmentationsModuleLogic.vtkImageDistanceMorphology()
+          smoothingFilter.SetInputData(selectedSegmentLabelmap)
           if smoothingMethod == MORPHOLOGICAL_OPENING:
-            smoothingFilter.SetOpenValue(labelValue)
-            smoothingFilter.SetCloseValue(backgroundValue)
+            smoothingFilter.SetOperationToOpening()
           else: # must be smoothingMethod == MORPHOLOGICAL_CLOSING:
-            smoothingFilter.SetOpenValue(backgroundValue)
-            smoothingFilter.SetCloseValue(labelValue)
+            smoothingFilter.SetOperationToClosing()
+          smoothingFilter.SetDistance(self.scriptedEffect.doubleParameter("KernelSizeMm")/2.0)
 
-        smoothingFilter.SetKernelSize(kernelSizePixel[0],kernelSizePixel[1],kernelSizePixel[2])
         smoothingFilter.Update()
         modifierLabelmap.DeepCopy(smoothingFilter.GetOutput())
 
@@ -53,12 +53,14 @@
 #include "vtkMRMLViewNode.h"
 
 // VTK includes
+#include <vtkDataArray.h>
 #include <vtkImageConstantPad.h>
 #include <vtkImageMask.h>
 #include <vtkImageShiftScale.h>
 #include <vtkImageThreshold.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
+#include <vtkPointData.h>
 #include <vtkProp.h>
 #include <vtkRenderer.h>
 #include <vtkRendererCollection.h>
@@ -69,6 +71,154 @@
 
 #include <vtkOrientedImageDataResample.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+/// Clears paintAllowed flags in a row of voxels where the mask is non-zero
+template <class MaskScalarType>
+void ApplyMaskRow(void* maskRowPtr, int numberOfVoxels, int numberOfComponents, unsigned char* paintAllowed)
+{
+  MaskScalarType* maskPtr = static_cast<MaskScalarType*>(maskRowPtr);
+  for (int i = 0; i < numberOfVoxels; ++i, maskPtr += numberOfComponents)
+    {
+    if (*maskPtr != 0)
+      {
+      paintAllowed[i] = 0;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Clears paintAllowed flags in a row of voxels where the intensity is outside the range
+template <class MasterScalarType>
+void ApplyIntensityRangeRow(void* masterRowPtr, int numberOfVoxels, int numberOfComponents,
+  double minimumValue, double maximumValue, unsigned char* paintAllowed)
+{
+  MasterScalarType* masterPtr = static_cast<MasterScalarType*>(masterRowPtr);
+  for (int i = 0; i < numberOfVoxels; ++i, masterPtr += numberOfComponents)
+    {
+    double value = static_cast<double>(*masterPtr);
+    if (value < minimumValue || value > maximumValue)
+      {
+      paintAllowed[i] = 0;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Sets voxels in a row to eraseValue where paint is not allowed
+template <class LabelmapScalarType>
+void EraseRow(void* labelmapRowPtr, int numberOfVoxels, int numberOfComponents,
+  const unsigned char* paintAllowed, double eraseValue)
+{
+  LabelmapScalarType* labelmapPtr = static_cast<LabelmapScalarType*>(labelmapRowPtr);
+  LabelmapScalarType eraseScalar = static_cast<LabelmapScalarType>(eraseValue);
+  for (int i = 0; i < numberOfVoxels; ++i)
+    {
+    if (paintAllowed[i])
+      {
+      labelmapPtr += numberOfComponents;
+      continue;
+      }
+    for (int component = 0; component < numberOfComponents; ++component)
+      {
+      *(labelmapPtr++) = eraseScalar;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Sets voxels of the labelmap within extent to eraseValue where painting is not allowed.
+/// Painting is not allowed where maskImage is non-zero (voxels outside the mask extent are allowed)
+/// and where the intensity of masterVolume is outside intensityRange (voxels outside the master volume extent
+/// are not allowed). maskImage and masterVolume are optional, they must have the same geometry as the labelmap.
+void EraseNotAllowedVoxels(vtkImageData* labelmap, const int extent[6],
+  vtkImageData* maskImage, vtkImageData* masterVolume, const double intensityRange[2], double eraseValue)
+{
+  int numberOfVoxelsInRow = extent[1] - extent[0] + 1;
+  std::vector<unsigned char> paintAllowed(numberOfVoxelsInRow);
+  int maskExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (maskImage && maskImage->GetPointData()->GetScalars())
+    {
+    maskImage->GetExtent(maskExtent);
+    }
+  int masterExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (masterVolume && masterVolume->GetPointData()->GetScalars())
+    {
+    masterVolume->GetExtent(masterExtent);
+    }
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    for (int y = extent[2]; y <= extent[3]; ++y)
+      {
+      std::fill(paintAllowed.begin(), paintAllowed.end(), 1);
+
+      if (maskImage && y >= maskExtent[2] && y <= maskExtent[3] && z >= maskExtent[4] && z <= maskExtent[5])
+        {
+        int firstX = std::max(extent[0], maskExtent[0]);
+        int lastX = std::min(extent[1], maskExtent[1]);
+        if (firstX <= lastX)
+          {
+          void* maskRowPtr = maskImage->GetScalarPointer(firstX, y, z);
+          switch (maskImage->GetScalarType())
+            {
+            vtkTemplateMacro(ApplyMaskRow<VTK_TT>(maskRowPtr, lastX - firstX + 1,
+              maskImage->GetNumberOfScalarComponents(), &paintAllowed[firstX - extent[0]]));
+            }
+          }
+        }
+
+      if (masterVolume)
+        {
+        int firstX = extent[0];
+        int lastX = extent[1];
+        if (y < masterExtent[2] || y > masterExtent[3] || z < masterExtent[4] || z > masterExtent[5])
+          {
+          lastX = firstX - 1;
+          }
+        else
+          {
+          firstX = std::max(firstX, masterExtent[0]);
+          lastX = std::min(lastX, masterExtent[1]);
+          }
+        // Voxels outside the master volume are not in the intensity range
+        for (int x = extent[0]; x <= extent[1]; ++x)
+          {
+          if (x < firstX || x > lastX)
+            {
+            paintAllowed[x - extent[0]] = 0;
+            }
+          }
+        if (firstX <= lastX)
+          {
+          void* masterRowPtr = masterVolume->GetScalarPointer(firstX, y, z);
+          switch (masterVolume->GetScalarType())
+            {
+            vtkTemplateMacro(ApplyIntensityRangeRow<VTK_TT>(masterRowPtr, lastX - firstX + 1,
+              masterVolume->GetNumberOfScalarComponents(), intensityRange[0], intensityRange[1],
+              &paintAllowed[firstX - extent[0]]));
+            }
+          }
+        }
+
+      void* labelmapRowPtr = labelmap->GetScalarPointer(extent[0], y, z);
+      switch (labelmap->GetScalarType())
+        {
+        vtkTemplateMacro(EraseRow<VTK_TT>(labelmapRowPtr, numberOfVoxelsInRow,
+          labelmap->GetNumberOfScalarComponents(), &paintAllowed[0], eraseValue));
+        }
+      }
+    }
+  labelmap->Modified();
+}
+
+} // end of anonymous namespace
+
 //-----------------------------------------------------------------------------
 // qSlicerSegmentEditorAbstractEffectPrivate methods
 
@@ -269,62 +419,81 @@ void qSlicerSegmentEditorAbstractEffect::modifySelectedSegmentByLabelmap(vtkOrie
 
   vtkSmartPointer<vtkOrientedImageData> modifierLabelmap = modifierLabelmapInput;
 
+  const int* extent = modificationExtent;
+  if (extent[0]>extent[1] || extent[2]>extent[3] || extent[4]>extent[5])
+    {
+    // invalid extent, it means we have to work with the entire modifier labelmap
+    extent = NULL;
+    }
+
   // Apply mask to modifier labelmap if paint over is turned off
-  if (parameterSetNode->GetMaskMode() != vtkMRMLSegmentEditorNode::PaintAllowedEverywhere)
+  // and threshold mask if paint threshold is turned on
+  bool paintMaskEnabled = (parameterSetNode->GetMaskMode() != vtkMRMLSegmentEditorNode::PaintAllowedEverywhere);
+  bool intensityMaskEnabled = parameterSetNode->GetMasterVolumeIntensityMask();
+  if (modifierLabelmap && (paintMaskEnabled || intensityMaskEnabled))
     {
-    vtkOrientedImageData* maskImage = this->maskLabelmap();
+    vtkOrientedImageData* maskImage = NULL;
+    if (paintMaskEnabled)
+      {
+      // Mask labelmap is only regenerated if segments or mask settings have changed since the last stroke
+      maskImage = this->maskLabelmap();
+      if (maskImage && !vtkOrientedImageDataResample::DoGeometriesMatch(modifierLabelmap, maskImage))
+        {
+        qCritical() << Q_FUNC_INFO << ": Modifier labelmap and mask labelmap geometry mismatch";
+        maskImage = NULL;
+        }
+      }
 
-    if (modifierLabelmap.GetPointer() == modifierLabelmapInput)
+    vtkOrientedImageData* masterVolumeOrientedImageData = NULL;
+    if (intensityMaskEnabled)
       {
-      // make a copy to not modify the input
-      vtkNew<vtkOrientedImageData> maskedModifierLabelmap;
-      maskedModifierLabelmap->DeepCopy(modifierLabelmap);
-      modifierLabelmap = maskedModifierLabelmap.GetPointer();
+      masterVolumeOrientedImageData = this->masterVolumeImageData();
+      if (!masterVolumeOrientedImageData)
+        {
+        qCritical() << Q_FUNC_INFO << ": Unable to get master volume image";
+        this->defaultModifierLabelmap();
+        return;
+        }
+      // Make sure the modifier labelmap has the same geometry as the master volume
+      if (!vtkOrientedImageDataResample::DoGeometriesMatch(modifierLabelmap, masterVolumeOrientedImageData))
+        {
+        qCritical() << Q_FUNC_INFO << ": Modifier labelmap should have the same geometry as the master volume";
+        this->defaultModifierLabelmap();
+        return;
+        }
       }
-    this->applyImageMask(modifierLabelmap, maskImage, this->m_EraseValue, true);
-    }
 
-  // Apply threshold mask if paint threshold is turned on
-  if (parameterSetNode->GetMasterVolumeIntensityMask())
-    {
-    vtkOrientedImageData* masterVolumeOrientedImageData = this->masterVolumeImageData();
-    if (!masterVolumeOrientedImageData)
+    // Make a copy to not modify the input. Segments are only modified within the modification extent,
+    // so it is enough to copy that region (except in set mode, which replaces the entire segment).
+    vtkNew<vtkOrientedImageData> maskedModifierLabelmap;
+    if (extent && modificationMode != qSlicerSegmentEditorAbstractEffect::ModificationModeSet)
       {
-      qCritical() << Q_FUNC_INFO << ": Unable to get master volume image";
-      this->defaultModifierLabelmap();
-      return;
+      vtkOrientedImageDataResample::CopyImage(modifierLabelmap, maskedModifierLabelmap.GetPointer(), extent);
       }
-    // Make sure the modifier labelmap has the same geometry as the master volume
-    if (!vtkOrientedImageDataResample::DoGeometriesMatch(modifierLabelmap, masterVolumeOrientedImageData))
+    else
       {
-      qCritical() << Q_FUNC_INFO << ": Modifier labelmap should have the same geometry as the master volume";
-      this->defaultModifierLabelmap();
-      return;
+      maskedModifierLabelmap->DeepCopy(modifierLabelmap);
       }
+    modifierLabelmap = maskedModifierLabelmap.GetPointer();
 
-    // Create threshold image
-    vtkSmartPointer<vtkImageThreshold> threshold = vtkSmartPointer<vtkImageThreshold>::New();
-    threshold->SetInputData(masterVolumeOrientedImageData);
-    threshold->ThresholdBetween(parameterSetNode->GetMasterVolumeIntensityMaskRange()[0], parameterSetNode->GetMasterVolumeIntensityMaskRange()[1]);
-    threshold->SetInValue(1);
-    threshold->SetOutValue(0);
-    threshold->SetOutputScalarType(modifierLabelmap->GetScalarType());
-    threshold->Update();
-
-    vtkSmartPointer<vtkOrientedImageData> thresholdMask = vtkSmartPointer<vtkOrientedImageData>::New();
-    thresholdMask->DeepCopy(threshold->GetOutput());
-    vtkSmartPointer<vtkMatrix4x4> modifierLabelmapToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-    modifierLabelmap->GetImageToWorldMatrix(modifierLabelmapToWorldMatrix);
-    thresholdMask->SetGeometryFromImageToWorldMatrix(modifierLabelmapToWorldMatrix);
-
-    if (modifierLabelmap.GetPointer() == modifierLabelmapInput)
+    // Masks are only applied within the modification extent. In set mode the entire modifier labelmap
+    // is written to the segment, so voxels outside the modification extent must be masked as well.
+    int maskedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    modifierLabelmap->GetExtent(maskedExtent);
+    if (extent && modificationMode != qSlicerSegmentEditorAbstractEffect::ModificationModeSet)
       {
-      // make a copy to not modify the input
-      vtkNew<vtkOrientedImageData> maskedModifierLabelmap;
-      maskedModifierLabelmap->DeepCopy(modifierLabelmap);
-      modifierLabelmap = maskedModifierLabelmap.GetPointer();
+      for (int i = 0; i < 3; ++i)
+        {
+        maskedExtent[i * 2] = std::max(maskedExtent[i * 2], extent[i * 2]);
+        maskedExtent[i * 2 + 1] = std::min(maskedExtent[i * 2 + 1], extent[i * 2 + 1]);
+        }
+      }
+    if (maskedExtent[0] <= maskedExtent[1] && maskedExtent[2] <= maskedExtent[3] && maskedExtent[4] <= maskedExtent[5]
+      && modifierLabelmap->GetPointData()->GetScalars())
+      {
+      EraseNotAllowedVoxels(modifierLabelmap, maskedExtent, maskImage, masterVolumeOrientedImageData,
+        parameterSetNode->GetMasterVolumeIntensityMaskRange(), this->m_EraseValue);
       }
-    this->applyImageMask(modifierLabelmap.GetPointer(), thresholdMask, this->m_EraseValue);
     }
 
   if (!d->ParameterSetNode)
@@ -356,16 +525,8 @@ void qSlicerSegmentEditorAbstractEffect::modifySelectedSegmentByLabelmap(vtkOrie
 
   // Copy the temporary padded modifier labelmap to the segment.
   // Mask and threshold was already applied on modifier labelmap at this point if requested.
-  const int* extent = modificationExtent;
-  if (extent[0]>extent[1] || extent[2]>extent[3] || extent[4]>extent[5])
-    {
-    // invalid extent, it means we have to work with the entire modifier labelmap
-    extent = NULL;
-    }
 
-  // TODO: composite modifierLabelmap with threshold mask
-
-  // Create inverted binary labelmap
+  // Create inverted binary labelmap. It is only computed within the modification extent.
   vtkSmartPointer<vtkImageThreshold> inverter = vtkSmartPointer<vtkImageThreshold>::New();
   inverter->SetInputData(modifierLabelmap);
   inverter->SetInValue(m_FillValue);
@@ -373,41 +534,26 @@ void qSlicerSegmentEditorAbstractEffect::modifySelectedSegmentByLabelmap(vtkOrie
   inverter->ReplaceInOn();
   inverter->ThresholdByLower(0);
   inverter->SetOutputScalarType(VTK_UNSIGNED_CHAR);
-
-  if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeSet)
+  int inverterExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  modifierLabelmap->GetExtent(inverterExtent);
+  if (extent)
     {
-    if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
-      modifierLabelmap, segmentationNode, selectedSegmentID, vtkSlicerSegmentationsModuleLogic::MODE_REPLACE, extent))
+    int intersectionExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    for (int i = 0; i < 3; ++i)
       {
-      qCritical() << Q_FUNC_INFO << ": Failed to set modifier labelmap to selected segment";
+      intersectionExtent[i * 2] = std::max(inverterExtent[i * 2], extent[i * 2]);
+      intersectionExtent[i * 2 + 1] = std::min(inverterExtent[i * 2 + 1], extent[i * 2 + 1]);
       }
-    }
-  else if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeAdd)
-    {
-    if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
-      modifierLabelmap, segmentationNode, selectedSegmentID, vtkSlicerSegmentationsModuleLogic::MODE_MERGE_MAX, extent))
+    if (intersectionExtent[0] <= intersectionExtent[1] && intersectionExtent[2] <= intersectionExtent[3]
+      && intersectionExtent[4] <= intersectionExtent[5])
       {
-      qCritical() << Q_FUNC_INFO << ": Failed to add modifier labelmap to selected segment";
-      }
-    }
-  else if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeRemove)
-    {
-    inverter->Update();
-    vtkNew<vtkOrientedImageData> invertedModifierLabelmap;
-    invertedModifierLabelmap->ShallowCopy(inverter->GetOutput());
-    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
-    modifierLabelmap->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
-    invertedModifierLabelmap->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix.GetPointer());
-    if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
-      invertedModifierLabelmap.GetPointer(), segmentationNode, selectedSegmentID, vtkSlicerSegmentationsModuleLogic::MODE_MERGE_MIN, extent))
-      {
-      qCritical() << Q_FUNC_INFO << ": Failed to remove modifier labelmap from selected segment";
+      std::copy(intersectionExtent, intersectionExtent + 6, inverterExtent);
       }
     }
 
   std::vector<std::string> allSegmentIDs;
   segmentationNode->GetSegmentation()->GetSegmentIDs(allSegmentIDs);
-  // remove selected segment, that is already handled
+  // remove selected segment, that is handled separately
   allSegmentIDs.erase(std::remove(allSegmentIDs.begin(), allSegmentIDs.end(), selectedSegmentID), allSegmentIDs.end());
 
   std::vector<std::string> visibleSegmentIDs;
@@ -437,12 +583,81 @@ void qSlicerSegmentEditorAbstractEffect::modifySelectedSegmentByLabelmap(vtkOrie
     break;
     }
 
+  // If the selected segment shares its labelmap with other segments and all of those would be overwritten anyway
+  // then the modification is a single write into the shared labelmap.
+  bool sharedLabelmapModified = false;
+  if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeSet
+    || modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeAdd)
+    {
+    std::vector<std::string> sharedSegmentIDs;
+    segmentationNode->GetSegmentation()->GetSegmentIDsSharingBinaryLabelmap(selectedSegmentID, sharedSegmentIDs);
+    bool allSharedSegmentsOverwritten = !sharedSegmentIDs.empty();
+    for (std::vector<std::string>::iterator segmentIDIt = sharedSegmentIDs.begin(); segmentIDIt != sharedSegmentIDs.end(); ++segmentIDIt)
+      {
+      if (*segmentIDIt != selectedSegmentID
+        && std::find(segmentIDsToOverwrite.begin(), segmentIDsToOverwrite.end(), *segmentIDIt) == segmentIDsToOverwrite.end())
+        {
+        allSharedSegmentsOverwritten = false;
+        break;
+        }
+      }
+    if (allSharedSegmentsOverwritten)
+      {
+      std::vector<std::string> modifiedSegmentIDs;
+      sharedLabelmapModified = vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSharedSegment(
+        modifierLabelmap, segmentationNode, selectedSegmentID,
+        modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeSet
+          ? vtkSlicerSegmentationsModuleLogic::MODE_REPLACE : vtkSlicerSegmentationsModuleLogic::MODE_MERGE_MAX,
+        extent, modifiedSegmentIDs);
+      }
+    if (sharedLabelmapModified)
+      {
+      // Segments in the shared labelmap have been already overwritten
+      for (std::vector<std::string>::iterator segmentIDIt = sharedSegmentIDs.begin(); segmentIDIt != sharedSegmentIDs.end(); ++segmentIDIt)
+        {
+        segmentIDsToOverwrite.erase(std::remove(segmentIDsToOverwrite.begin(), segmentIDsToOverwrite.end(), *segmentIDIt),
+          segmentIDsToOverwrite.end());
+        }
+      }
+    }
+
+  if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeSet && !sharedLabelmapModified)
+    {
+    if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
+      modifierLabelmap, segmentationNode, selectedSegmentID, vtkSlicerSegmentationsModuleLogic::MODE_REPLACE, extent))
+      {
+      qCritical() << Q_FUNC_INFO << ": Failed to set modifier labelmap to selected segment";
+      }
+    }
+  else if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeAdd && !sharedLabelmapModified)
+    {
+    if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
+      modifierLabelmap, segmentationNode, selectedSegmentID, vtkSlicerSegmentationsModuleLogic::MODE_MERGE_MAX, extent))
+      {
+      qCritical() << Q_FUNC_INFO << ": Failed to add modifier labelmap to selected segment";
+      }
+    }
+  else if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeRemove)
+    {
+    inverter->UpdateExtent(inverterExtent);
+    vtkNew<vtkOrientedImageData> invertedModifierLabelmap;
+    invertedModifierLabelmap->ShallowCopy(inverter->GetOutput());
+    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+    modifierLabelmap->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+    invertedModifierLabelmap->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+    if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
+      invertedModifierLabelmap.GetPointer(), segmentationNode, selectedSegmentID, vtkSlicerSegmentationsModuleLogic::MODE_MERGE_MIN, extent))
+      {
+      qCritical() << Q_FUNC_INFO << ": Failed to remove modifier labelmap from selected segment";
+      }
+    }
+
   if (!segmentIDsToOverwrite.empty())
     {
     if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeSet
       || modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeAdd)
       {
-      inverter->Update();
+      inverter->UpdateExtent(inverterExtent);
       vtkNew<vtkOrientedImageData> invertedModifierLabelmap;
       invertedModifierLabelmap->ShallowCopy(inverter->GetOutput());
       vtkNew<vtkMatrix4x4> imageToWorldMatrix;
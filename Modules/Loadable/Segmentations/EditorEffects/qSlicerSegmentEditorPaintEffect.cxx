@@ -36,6 +36,7 @@
 // VTK includes
 #include <vtkActor.h>
 #include <vtkActor2D.h>
+#include <vtkAlgorithmOutput.h>
 #include <vtkBoundingBox.h>
 #include <vtkCamera.h>
 #include <vtkCellArray.h>
@@ -91,6 +92,9 @@
 #include "vtkMRMLSliceLayerLogic.h"
 #include "vtkOrientedImageDataResample.h"
 
+// STD includes
+#include <algorithm>
+
 //-----------------------------------------------------------------------------
 /// Visualization objects and pipeline for each slice view for the paint brush
 class BrushPipeline
@@ -210,6 +214,132 @@ public:
 };
 
 
+namespace
+{
+//-----------------------------------------------------------------------------
+/// Sphere or cylinder brush swept along a line segment, in world coordinates
+struct SweptBrush
+{
+  bool Cylinder;
+  double Radius;
+  /// Half of the cylinder height
+  double HalfHeight;
+  /// Unit vector of the cylinder axis
+  double Axis[3];
+  double Start[3];
+  double End[3];
+};
+
+//-----------------------------------------------------------------------------
+bool IsInsideSweptBrush(const SweptBrush& brush, const double point[3])
+{
+  double segment[3] = { brush.End[0] - brush.Start[0], brush.End[1] - brush.Start[1], brush.End[2] - brush.Start[2] };
+  double startToPoint[3] = { point[0] - brush.Start[0], point[1] - brush.Start[1], point[2] - brush.Start[2] };
+  if (brush.Cylinder)
+    {
+    // The cylinder is moved in the plane orthogonal to its axis, so the closest
+    // brush position is found on the segment projected to that plane
+    double segmentAxial = vtkMath::Dot(segment, brush.Axis);
+    double pointAxial = vtkMath::Dot(startToPoint, brush.Axis);
+    for (int i = 0; i < 3; i++)
+      {
+      segment[i] -= segmentAxial * brush.Axis[i];
+      startToPoint[i] -= pointAxial * brush.Axis[i];
+      }
+    }
+  double segmentLength2 = vtkMath::Dot(segment, segment);
+  double t = (segmentLength2 > 0 ? vtkMath::Dot(startToPoint, segment) / segmentLength2 : 0.0);
+  t = std::max(0.0, std::min(1.0, t));
+  double centerToPoint[3] =
+    {
+    point[0] - brush.Start[0] - t * (brush.End[0] - brush.Start[0]),
+    point[1] - brush.Start[1] - t * (brush.End[1] - brush.Start[1]),
+    point[2] - brush.Start[2] - t * (brush.End[2] - brush.Start[2])
+    };
+  double distance2 = vtkMath::Dot(centerToPoint, centerToPoint);
+  if (!brush.Cylinder)
+    {
+    return distance2 <= brush.Radius * brush.Radius;
+    }
+  // Half-open along the axis so that a cylinder as high as the slice spacing
+  // paints exactly one layer of voxels
+  double axial = vtkMath::Dot(centerToPoint, brush.Axis);
+  if (axial < -brush.HalfHeight || axial >= brush.HalfHeight)
+    {
+    return false;
+    }
+  return distance2 - axial * axial <= brush.Radius * brush.Radius;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the extent of the labelmap voxels that may be inside the swept brush
+void GetSweptBrushExtent(const SweptBrush& brush, vtkMatrix4x4* worldToIjk, int extent[6])
+{
+  double boundingRadius = brush.Radius;
+  if (brush.Cylinder)
+    {
+    boundingRadius = sqrt(brush.Radius * brush.Radius + brush.HalfHeight * brush.HalfHeight);
+    }
+  double bounds_World[6] = { 0.0 };
+  for (int i = 0; i < 3; i++)
+    {
+    bounds_World[i * 2] = std::min(brush.Start[i], brush.End[i]) - boundingRadius;
+    bounds_World[i * 2 + 1] = std::max(brush.Start[i], brush.End[i]) + boundingRadius;
+    }
+  double bounds_Ijk[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+  for (int corner = 0; corner < 8; corner++)
+    {
+    double corner_World[4] = { bounds_World[corner & 1], bounds_World[2 + ((corner >> 1) & 1)], bounds_World[4 + ((corner >> 2) & 1)], 1.0 };
+    double corner_Ijk[4] = { 0.0, 0.0, 0.0, 1.0 };
+    worldToIjk->MultiplyPoint(corner_World, corner_Ijk);
+    for (int i = 0; i < 3; i++)
+      {
+      bounds_Ijk[i * 2] = std::min(bounds_Ijk[i * 2], corner_Ijk[i]);
+      bounds_Ijk[i * 2 + 1] = std::max(bounds_Ijk[i * 2 + 1], corner_Ijk[i]);
+      }
+    }
+  for (int i = 0; i < 3; i++)
+    {
+    extent[i * 2] = static_cast<int>(floor(bounds_Ijk[i * 2]));
+    extent[i * 2 + 1] = static_cast<int>(ceil(bounds_Ijk[i * 2 + 1]));
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Set fillValue in voxels of the labelmap extent that are inside the swept brush
+/// (voxels that already have a higher value are kept).
+template <class T>
+void PaintSweptBrushGeneric(vtkImageData* labelmap, const int extent[6], const SweptBrush& brush,
+  vtkMatrix4x4* ijkToWorld, double fillValue)
+{
+  T fill = static_cast<T>(fillValue);
+  int numberOfComponents = labelmap->GetNumberOfScalarComponents();
+  // World position is incremented by the first column of the matrix when stepping along a row
+  double step_World[3] = { ijkToWorld->GetElement(0, 0), ijkToWorld->GetElement(1, 0), ijkToWorld->GetElement(2, 0) };
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      double position_Ijk[4] = { static_cast<double>(extent[0]), static_cast<double>(j), static_cast<double>(k), 1.0 };
+      double position_World[4] = { 0.0, 0.0, 0.0, 1.0 };
+      ijkToWorld->MultiplyPoint(position_Ijk, position_World);
+      T* voxel = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, voxel += numberOfComponents)
+        {
+        if (*voxel < fill && IsInsideSweptBrush(brush, position_World))
+          {
+          *voxel = fill;
+          }
+        position_World[0] += step_World[0];
+        position_World[1] += step_World[1];
+        position_World[2] += step_World[2];
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
 //-----------------------------------------------------------------------------
 // qSlicerSegmentEditorPaintEffectPrivate methods
 
@@ -218,6 +348,7 @@ qSlicerSegmentEditorPaintEffectPrivate::qSlicerSegmentEditorPaintEffectPrivate(q
   : q_ptr(&object)
   , DelayedPaint(true)
   , IsPainting(false)
+  , LastPaintPositionValid(false)
   , ActiveViewWidget(NULL)
   , BrushDiameterFrame(NULL)
   , BrushDiameterSpinBox(NULL)
@@ -227,6 +358,7 @@ qSlicerSegmentEditorPaintEffectPrivate::qSlicerSegmentEditorPaintEffectPrivate(q
   , ColorSmudgeCheckbox(NULL)
   , BrushPixelModeCheckbox(NULL)
 {
+  this->LastPaintPosition_World[0] = this->LastPaintPosition_World[1] = this->LastPaintPosition_World[2] = 0.0;
   this->PaintCoordinates_World = vtkSmartPointer<vtkPoints>::New();
   this->FeedbackPointsPolyData = vtkSmartPointer<vtkPolyData>::New();
   this->FeedbackPointsPolyData->SetPoints(this->PaintCoordinates_World);
@@ -346,23 +478,15 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintApply(qMRMLWidget* viewWidget)
     return;
     }
 
-  q->saveStateForUndo();
-
   QList<int> updateExtentList;
 
   if (q->integerParameter("BrushPixelMode"))
     {
+    q->saveStateForUndo();
     this->paintPixels(viewWidget, this->PaintCoordinates_World);
     }
   else
     {
-    this->updateBrushStencil(viewWidget);
-
-    this->BrushPolyDataToStencil->Update();
-    vtkImageStencilData* stencilData = this->BrushPolyDataToStencil->GetOutput();
-    int stencilExtent[6]={0,-1,0,-1,0,-1};
-    stencilData->GetExtent(stencilExtent);
-
     vtkNew<vtkTransform> worldToModifierLabelmapIjkTransform;
 
     vtkNew<vtkMatrix4x4> segmentationToSegmentationIjkTransformMatrix;
@@ -375,52 +499,20 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintApply(qMRMLWidget* viewWidget)
     vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(NULL, segmentationNode->GetParentTransformNode(), worldToSegmentationTransformMatrix.GetPointer());
     worldToModifierLabelmapIjkTransform->Concatenate(worldToSegmentationTransformMatrix.GetPointer());
 
-    vtkNew<vtkPoints> paintCoordinates_Ijk;
-    worldToModifierLabelmapIjkTransform->TransformPoints(this->PaintCoordinates_World, paintCoordinates_Ijk.GetPointer());
-
-    vtkNew<vtkImageStencilToImage> stencilToImage;
-    stencilToImage->SetInputConnection(this->BrushPolyDataToStencil->GetOutputPort());
-    stencilToImage->SetInsideValue(q->m_FillValue);
-    stencilToImage->SetOutsideValue(q->m_EraseValue);
-    stencilToImage->SetOutputScalarType(modifierLabelmap->GetScalarType());
-
-    vtkNew<vtkImageChangeInformation> brushPositioner;
-    brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
-    brushPositioner->SetOutputSpacing(modifierLabelmap->GetSpacing());
-    brushPositioner->SetOutputOrigin(modifierLabelmap->GetOrigin());
-
-    vtkIdType numberOfPoints = this->PaintCoordinates_World->GetNumberOfPoints();
     int updateExtent[6] = { 0, -1, 0, -1, 0, -1 };
-    for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    if (!this->paintBrushShapes(modifierLabelmap, worldToModifierLabelmapIjkTransform->GetMatrix(), updateExtent))
       {
-      double* shiftDouble = paintCoordinates_Ijk->GetPoint(pointIndex);
-      int shift[3] = {int(shiftDouble[0]+0.5), int(shiftDouble[1]+0.5), int(shiftDouble[2]+0.5)};
-      brushPositioner->SetExtentTranslation(shift);
-      brushPositioner->Update();
-      vtkNew<vtkOrientedImageData> orientedBrushPositionerOutput;
-      orientedBrushPositionerOutput->ShallowCopy(brushPositioner->GetOutput());
-      orientedBrushPositionerOutput->CopyDirections(modifierLabelmap);
-      if (pointIndex == 0)
-        {
-        orientedBrushPositionerOutput->GetExtent(updateExtent);
-        }
-      else
-        {
-        int* brushExtent = orientedBrushPositionerOutput->GetExtent();
-        for (int i = 0; i < 3; i++)
-          {
-          if (brushExtent[i * 2] < updateExtent[i * 2])
-            {
-            updateExtent[i * 2] = brushExtent[i * 2];
-            }
-          if (brushExtent[i * 2 + 1] > updateExtent[i * 2 + 1])
-            {
-            updateExtent[i * 2 + 1] = brushExtent[i * 2 + 1];
-            }
-          }
-        }
-      vtkOrientedImageDataResample::ModifyImage(modifierLabelmap, orientedBrushPositionerOutput.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
+      // Custom brush shape, rasterize the brush polydata
+      this->paintBrushStencil(viewWidget, modifierLabelmap, worldToModifierLabelmapIjkTransform.GetPointer(), updateExtent);
       }
+    this->PaintCoordinates_World->Reset();
+    if (updateExtent[0] > updateExtent[1] || updateExtent[2] > updateExtent[3] || updateExtent[4] > updateExtent[5])
+      {
+      // Brush did not touch the modifier labelmap (e.g., painted outside the segmentation),
+      // an empty extent would mean modifying the entire segment.
+      return;
+      }
+    q->saveStateForUndo();
     modifierLabelmap->Modified();
     for (int i = 0; i < 6; i++)
       {
@@ -434,6 +526,183 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintApply(qMRMLWidget* viewWidget)
   q->modifySelectedSegmentByLabelmap(modifierLabelmap, modificationMode, updateExtentList);
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerSegmentEditorPaintEffectPrivate::paintBrushStencil(qMRMLWidget* viewWidget, vtkOrientedImageData* modifierLabelmap,
+  vtkTransform* worldToModifierLabelmapIjkTransform, int updateExtent[6])
+{
+  Q_Q(qSlicerSegmentEditorPaintEffect);
+
+  this->updateBrushStencil(viewWidget);
+  this->BrushPolyDataToStencil->Update();
+
+  vtkNew<vtkPoints> paintCoordinates_Ijk;
+  worldToModifierLabelmapIjkTransform->TransformPoints(this->PaintCoordinates_World, paintCoordinates_Ijk.GetPointer());
+
+  vtkNew<vtkImageStencilToImage> stencilToImage;
+  stencilToImage->SetInputConnection(this->BrushPolyDataToStencil->GetOutputPort());
+  stencilToImage->SetInsideValue(q->m_FillValue);
+  stencilToImage->SetOutsideValue(q->m_EraseValue);
+  stencilToImage->SetOutputScalarType(modifierLabelmap->GetScalarType());
+
+  vtkNew<vtkImageChangeInformation> brushPositioner;
+  brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
+  brushPositioner->SetOutputSpacing(modifierLabelmap->GetSpacing());
+  brushPositioner->SetOutputOrigin(modifierLabelmap->GetOrigin());
+
+  vtkIdType numberOfPoints = this->PaintCoordinates_World->GetNumberOfPoints();
+  for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    double* shiftDouble = paintCoordinates_Ijk->GetPoint(pointIndex);
+    int shift[3] = {int(shiftDouble[0]+0.5), int(shiftDouble[1]+0.5), int(shiftDouble[2]+0.5)};
+    brushPositioner->SetExtentTranslation(shift);
+    brushPositioner->Update();
+    vtkNew<vtkOrientedImageData> orientedBrushPositionerOutput;
+    orientedBrushPositionerOutput->ShallowCopy(brushPositioner->GetOutput());
+    orientedBrushPositionerOutput->CopyDirections(modifierLabelmap);
+    if (pointIndex == 0)
+      {
+      orientedBrushPositionerOutput->GetExtent(updateExtent);
+      }
+    else
+      {
+      int* brushExtent = orientedBrushPositionerOutput->GetExtent();
+      for (int i = 0; i < 3; i++)
+        {
+        if (brushExtent[i * 2] < updateExtent[i * 2])
+          {
+          updateExtent[i * 2] = brushExtent[i * 2];
+          }
+        if (brushExtent[i * 2 + 1] > updateExtent[i * 2 + 1])
+          {
+          updateExtent[i * 2 + 1] = brushExtent[i * 2 + 1];
+          }
+        }
+      }
+    vtkOrientedImageDataResample::ModifyImage(modifierLabelmap, orientedBrushPositionerOutput.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerSegmentEditorPaintEffectPrivate::paintBrushShapes(vtkOrientedImageData* modifierLabelmap,
+  vtkMatrix4x4* worldToModifierLabelmapIjk, int updateExtent[6])
+{
+  Q_Q(qSlicerSegmentEditorPaintEffect);
+
+  if (this->BrushToWorldOriginTransformer->GetNumberOfInputConnections(0) < 1)
+    {
+    return false;
+    }
+  vtkAlgorithmOutput* brushSourcePort = this->BrushToWorldOriginTransformer->GetInputConnection(0, 0);
+
+  // Get brush shape from the brush model source
+  SweptBrush brush;
+  brush.HalfHeight = 0.0;
+  brush.Axis[0] = brush.Axis[1] = brush.Axis[2] = 0.0;
+  double brushCenter_Brush[3] = { 0.0, 0.0, 0.0 };
+  if (brushSourcePort == this->BrushSphereSource->GetOutputPort())
+    {
+    brush.Cylinder = false;
+    brush.Radius = this->BrushSphereSource->GetRadius();
+    this->BrushSphereSource->GetCenter(brushCenter_Brush);
+    }
+  else if (brushSourcePort == this->BrushCylinderSource->GetOutputPort())
+    {
+    brush.Cylinder = true;
+    brush.Radius = this->BrushCylinderSource->GetRadius();
+    brush.HalfHeight = this->BrushCylinderSource->GetHeight() / 2.0;
+    this->BrushCylinderSource->GetCenter(brushCenter_Brush);
+    // vtkCylinderSource axis is the y axis
+    double axis_Brush[3] = { 0.0, 1.0, 0.0 };
+    this->BrushToWorldOriginTransform->TransformVector(axis_Brush, brush.Axis);
+    vtkMath::Normalize(brush.Axis);
+    }
+  else
+    {
+    // Custom brush shape
+    return false;
+    }
+  double brushCenterOffset_World[3] = { 0.0, 0.0, 0.0 };
+  this->BrushToWorldOriginTransform->TransformPoint(brushCenter_Brush, brushCenterOffset_World);
+
+  vtkNew<vtkMatrix4x4> modifierLabelmapIjkToWorld;
+  vtkMatrix4x4::Invert(worldToModifierLabelmapIjk, modifierLabelmapIjkToWorld.GetPointer());
+
+  // Brush positions. The last painted position of the stroke is prepended so that
+  // positions that are painted one by one are connected, too.
+  vtkNew<vtkPoints> brushPositions_World;
+  if (this->IsPainting && this->LastPaintPositionValid)
+    {
+    brushPositions_World->InsertNextPoint(this->LastPaintPosition_World);
+    }
+  for (vtkIdType pointIndex = 0; pointIndex < this->PaintCoordinates_World->GetNumberOfPoints(); pointIndex++)
+    {
+    brushPositions_World->InsertNextPoint(this->PaintCoordinates_World->GetPoint(pointIndex));
+    }
+  vtkIdType numberOfBrushPositions = brushPositions_World->GetNumberOfPoints();
+
+  int* labelmapExtent = modifierLabelmap->GetExtent();
+  bool updateExtentValid = false;
+  // A single position is painted as a segment of zero length
+  for (vtkIdType pointIndex = (numberOfBrushPositions > 1 ? 1 : 0); pointIndex < numberOfBrushPositions; pointIndex++)
+    {
+    double* start_World = brushPositions_World->GetPoint(pointIndex > 0 ? pointIndex - 1 : 0);
+    double* end_World = brushPositions_World->GetPoint(pointIndex);
+    for (int i = 0; i < 3; i++)
+      {
+      brush.Start[i] = start_World[i] + brushCenterOffset_World[i];
+      brush.End[i] = end_World[i] + brushCenterOffset_World[i];
+      }
+
+    int brushExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    GetSweptBrushExtent(brush, worldToModifierLabelmapIjk, brushExtent);
+    bool brushExtentEmpty = false;
+    for (int i = 0; i < 3; i++)
+      {
+      brushExtent[i * 2] = std::max(brushExtent[i * 2], labelmapExtent[i * 2]);
+      brushExtent[i * 2 + 1] = std::min(brushExtent[i * 2 + 1], labelmapExtent[i * 2 + 1]);
+      if (brushExtent[i * 2] > brushExtent[i * 2 + 1])
+        {
+        brushExtentEmpty = true;
+        }
+      }
+    if (brushExtentEmpty)
+      {
+      continue;
+      }
+
+    switch (modifierLabelmap->GetScalarType())
+      {
+      vtkTemplateMacro(PaintSweptBrushGeneric<VTK_TT>(modifierLabelmap, brushExtent, brush,
+        modifierLabelmapIjkToWorld.GetPointer(), q->m_FillValue));
+      default:
+        qCritical() << Q_FUNC_INFO << ": Unsupported modifier labelmap scalar type";
+        return true;
+      }
+
+    if (!updateExtentValid)
+      {
+      std::copy(brushExtent, brushExtent + 6, updateExtent);
+      updateExtentValid = true;
+      }
+    else
+      {
+      for (int i = 0; i < 3; i++)
+        {
+        updateExtent[i * 2] = std::min(updateExtent[i * 2], brushExtent[i * 2]);
+        updateExtent[i * 2 + 1] = std::max(updateExtent[i * 2 + 1], brushExtent[i * 2 + 1]);
+        }
+      }
+    }
+
+  // Remember the last position for connecting it to positions painted later in this stroke
+  this->LastPaintPositionValid = (this->IsPainting && numberOfBrushPositions > 0);
+  if (this->LastPaintPositionValid)
+    {
+    brushPositions_World->GetPoint(numberOfBrushPositions - 1, this->LastPaintPosition_World);
+    }
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerSegmentEditorPaintEffectPrivate::updateBrushStencil(qMRMLWidget* viewWidget)
 {
@@ -890,6 +1159,31 @@ void qSlicerSegmentEditorPaintEffect::deactivate()
   d->ActiveViewWidget = NULL;
 }
 
+//---------------------------------------------------------------------------
+void qSlicerSegmentEditorPaintEffect::paintAt(QVector3D brushPosition_World)
+{
+  Q_D(qSlicerSegmentEditorPaintEffect);
+  double brushPosition[3] = { brushPosition_World.x(), brushPosition_World.y(), brushPosition_World.z() };
+  // Without a slice widget the brush model is a sphere
+  d->updateBrushModel(NULL, brushPosition);
+  d->PaintCoordinates_World->Reset();
+  d->PaintCoordinates_World->InsertNextPoint(brushPosition);
+  d->paintApply(NULL);
+}
+
+//---------------------------------------------------------------------------
+void qSlicerSegmentEditorPaintEffect::paintStroke(vtkPoints* brushPositions_World, qMRMLWidget* viewWidget)
+{
+  Q_D(qSlicerSegmentEditorPaintEffect);
+  if (!brushPositions_World || brushPositions_World->GetNumberOfPoints() < 1)
+    {
+    return;
+    }
+  d->updateBrushModel(viewWidget, brushPositions_World->GetPoint(0));
+  d->PaintCoordinates_World->DeepCopy(brushPositions_World);
+  d->paintApply(viewWidget);
+}
+
 
 //---------------------------------------------------------------------------
 bool qSlicerSegmentEditorPaintEffectPrivate::brushPositionInWorld(qMRMLWidget* viewWidget, int brushPositionInView[2], double brushPosition_World[3])
@@ -1067,6 +1361,7 @@ bool qSlicerSegmentEditorPaintEffect::processInteractionEvents(
   if (eid == vtkCommand::LeftButtonPressEvent && !shiftKeyPressed)
     {
     d->IsPainting = true;
+    d->LastPaintPositionValid = false;
     if (!this->integerParameter("BrushPixelMode"))
       {
       //this->cursorOff(sliceWidget);
@@ -27,6 +27,7 @@
 #include "qSlicerSegmentEditorAbstractLabelEffect.h"
 
 class qSlicerSegmentEditorPaintEffectPrivate;
+class vtkPoints;
 class vtkPolyData;
 
 /// \ingroup SlicerRt_QtModules_Segmentations
@@ -54,6 +55,18 @@ public:
   /// Perform actions to deactivate the effect (such as destroy actors, etc.)
   Q_INVOKABLE virtual void deactivate();
 
+  /// Paint a single position with a sphere brush, without using a view.
+  /// The brush diameter is the current absolute brush diameter. Used for scripted painting and testing.
+  /// \param brushPosition_World Brush center position in world coordinates
+  Q_INVOKABLE void paintAt(QVector3D brushPosition_World);
+
+  /// Paint a stroke without interaction: the brush is swept between consecutive positions.
+  /// The brush diameter is the current absolute brush diameter. Used for scripted painting and testing.
+  /// \param brushPositions_World Brush center positions in world coordinates
+  /// \param viewWidget If it is a slice widget and BrushSphere is disabled then the brush is a cylinder
+  ///   aligned with the slice, otherwise a sphere
+  Q_INVOKABLE void paintStroke(vtkPoints* brushPositions_World, qMRMLWidget* viewWidget = NULL);
+
   /// Callback function invoked when interaction happens
   /// \param callerInteractor Interactor object that was observed to catch the event
   /// \param eid Event identifier
@@ -62,6 +62,8 @@ class qMRMLSliceWidget;
 class qMRMLSpinBox;
 class vtkActor2D;
 class vtkGlyph3D;
+class vtkMatrix4x4;
+class vtkOrientedImageData;
 class vtkPoints;
 class vtkPolyDataNormals;
 class vtkPolyDataToImageStencil;
@@ -96,6 +98,20 @@ public:
   /// modifierLabelmap at many different positions.
   void updateBrushStencil(qMRMLWidget* viewWidget);
 
+  /// Paints sphere or cylinder brush into modifierLabelmap at each paint position by testing
+  /// voxel positions against the brush shape. Consecutive positions of a stroke are connected
+  /// by sweeping the brush between them.
+  /// \param updateExtent Extent of modifierLabelmap that has been painted
+  /// \return False if the brush is not a sphere or cylinder (then brush stencil has to be used instead)
+  bool paintBrushShapes(vtkOrientedImageData* modifierLabelmap, vtkMatrix4x4* worldToModifierLabelmapIjk,
+    int updateExtent[6]);
+
+  /// Paints brush into modifierLabelmap at each paint position by rasterizing the brush polydata.
+  /// Used for brush shapes that paintBrushShapes() does not support.
+  /// \param updateExtent Extent of modifierLabelmap that has been painted
+  void paintBrushStencil(qMRMLWidget* viewWidget, vtkOrientedImageData* modifierLabelmap,
+    vtkTransform* worldToModifierLabelmapIjkTransform, int updateExtent[6]);
+
 protected:
   /// Get brush object for widget. Create if does not exist
   BrushPipeline* brushForWidget(qMRMLWidget* viewWidget);
@@ -148,6 +164,11 @@ public:
   bool DelayedPaint;
   bool IsPainting;
 
+  /// Last painted position of the current stroke. Positions that are painted later
+  /// in the same stroke are connected to it.
+  double LastPaintPosition_World[3];
+  bool LastPaintPositionValid;
+
   // Observed view node
   qMRMLWidget* ActiveViewWidget;
   int ActiveViewLastInteractionPosition[2];
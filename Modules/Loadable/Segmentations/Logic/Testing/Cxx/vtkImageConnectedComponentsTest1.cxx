@@ -0,0 +1,280 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageConnectedComponents.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Reference connected components computed by flood fill
+struct ReferenceComponents
+{
+  std::vector<int> Labels; // -1 for background, component index otherwise
+  std::vector<vtkIdType> Sizes;
+};
+
+//----------------------------------------------------------------------------
+void CreateInput(vtkImageData* image)
+{
+  image->SetExtent(-4, 25, 3, 27, 0, 19);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(image->GetScalarPointer());
+  vtkMath::RandomSeed(2468);
+  for (vtkIdType index = 0; index < image->GetNumberOfPoints(); ++index)
+    {
+    // Sparse random voxels form many islands that are connected differently with different connectivity
+    voxels[index] = (vtkMath::Random() < 0.3 ? static_cast<short>(vtkMath::Random(1.0, 5.0)) : 0);
+    }
+}
+
+//----------------------------------------------------------------------------
+ReferenceComponents FloodFill(vtkImageData* image, int connectivity)
+{
+  int dimensions[3] = { 0, 0, 0 };
+  image->GetDimensions(dimensions);
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  ReferenceComponents components;
+  components.Labels.resize(image->GetNumberOfPoints(), -1);
+  std::vector<int> stack;
+  for (int seed = 0; seed < static_cast<int>(components.Labels.size()); ++seed)
+    {
+    if (scalars->GetComponent(seed, 0) == 0 || components.Labels[seed] >= 0)
+      {
+      continue;
+      }
+    int component = static_cast<int>(components.Sizes.size());
+    components.Sizes.push_back(0);
+    components.Labels[seed] = component;
+    stack.push_back(seed);
+    while (!stack.empty())
+      {
+      int index = stack.back();
+      stack.pop_back();
+      components.Sizes[component]++;
+      int x = index % dimensions[0];
+      int y = (index / dimensions[0]) % dimensions[1];
+      int z = index / (dimensions[0] * dimensions[1]);
+      for (int dz = -1; dz <= 1; ++dz)
+        {
+        for (int dy = -1; dy <= 1; ++dy)
+          {
+          for (int dx = -1; dx <= 1; ++dx)
+            {
+            int offsetCount = abs(dx) + abs(dy) + abs(dz);
+            if (offsetCount == 0 || (connectivity == 6 && offsetCount > 1) || (connectivity == 18 && offsetCount > 2))
+              {
+              continue;
+              }
+            int nx = x + dx;
+            int ny = y + dy;
+            int nz = z + dz;
+            if (nx < 0 || nx >= dimensions[0] || ny < 0 || ny >= dimensions[1] || nz < 0 || nz >= dimensions[2])
+              {
+              continue;
+              }
+            int neighbor = nx + (ny + nz * dimensions[1]) * dimensions[0];
+            if (scalars->GetComponent(neighbor, 0) != 0 && components.Labels[neighbor] < 0)
+              {
+              components.Labels[neighbor] = component;
+              stack.push_back(neighbor);
+              }
+            }
+          }
+        }
+      }
+    }
+  return components;
+}
+
+//----------------------------------------------------------------------------
+/// Check that each island of the output is exactly one reference component and that island statistics are correct
+bool CheckIslands(vtkImageConnectedComponents* connectedComponents, const ReferenceComponents& reference)
+{
+  vtkImageData* output = connectedComponents->GetOutput();
+  vtkDataArray* outputScalars = output->GetPointData()->GetScalars();
+  int* extent = output->GetExtent();
+  int dimensions[3] = { 0, 0, 0 };
+  output->GetDimensions(dimensions);
+
+  if (connectedComponents->GetOriginalNumberOfIslands() != static_cast<int>(reference.Sizes.size()))
+    {
+    std::cerr << "Number of islands: " << connectedComponents->GetOriginalNumberOfIslands()
+      << " != " << reference.Sizes.size() << std::endl;
+    return false;
+    }
+
+  // Rank of each island in the output <-> reference component
+  std::map<int, int> componentOfRank;
+  std::map<int, int> rankOfComponent;
+  for (int index = 0; index < static_cast<int>(reference.Labels.size()); ++index)
+    {
+    int rank = static_cast<int>(outputScalars->GetComponent(index, 0));
+    int component = reference.Labels[index];
+    if ((rank == 0) != (component < 0))
+      {
+      std::cerr << "Voxel " << index << " foreground mismatch" << std::endl;
+      return false;
+      }
+    if (rank == 0)
+      {
+      continue;
+      }
+    std::map<int, int>::iterator componentIt = componentOfRank.find(rank);
+    std::map<int, int>::iterator rankIt = rankOfComponent.find(component);
+    if ((componentIt != componentOfRank.end() && componentIt->second != component)
+      || (rankIt != rankOfComponent.end() && rankIt->second != rank))
+      {
+      std::cerr << "Island " << rank << " does not match a single connected component" << std::endl;
+      return false;
+      }
+    componentOfRank[rank] = component;
+    rankOfComponent[component] = rank;
+    }
+
+  // Sizes are sorted in decreasing order, extents and centroids match the reference components
+  std::vector<vtkIdType> sortedSizes(reference.Sizes);
+  std::sort(sortedSizes.begin(), sortedSizes.end(), std::greater<vtkIdType>());
+  for (int n = 0; n < static_cast<int>(sortedSizes.size()); ++n)
+    {
+    if (connectedComponents->GetIslandSize(n) != sortedSizes[n])
+      {
+      std::cerr << "Size of island " << n << ": " << connectedComponents->GetIslandSize(n)
+        << " != " << sortedSizes[n] << std::endl;
+      return false;
+      }
+    }
+  for (std::map<int, int>::iterator rankIt = componentOfRank.begin(); rankIt != componentOfRank.end(); ++rankIt)
+    {
+    int n = rankIt->first - 1;
+    int component = rankIt->second;
+    int expectedExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+    double expectedCentroid[3] = { 0.0, 0.0, 0.0 };
+    for (int index = 0; index < static_cast<int>(reference.Labels.size()); ++index)
+      {
+      if (reference.Labels[index] != component)
+        {
+        continue;
+        }
+      int ijk[3] = { extent[0] + index % dimensions[0], extent[2] + (index / dimensions[0]) % dimensions[1],
+        extent[4] + index / (dimensions[0] * dimensions[1]) };
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        expectedExtent[axis * 2] = std::min(expectedExtent[axis * 2], ijk[axis]);
+        expectedExtent[axis * 2 + 1] = std::max(expectedExtent[axis * 2 + 1], ijk[axis]);
+        expectedCentroid[axis] += ijk[axis];
+        }
+      }
+    int islandExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    double islandCentroid[3] = { 0.0, 0.0, 0.0 };
+    connectedComponents->GetIslandExtent(n, islandExtent);
+    connectedComponents->GetIslandCentroid(n, islandCentroid);
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      expectedCentroid[axis] /= reference.Sizes[component];
+      if (islandExtent[axis * 2] != expectedExtent[axis * 2] || islandExtent[axis * 2 + 1] != expectedExtent[axis * 2 + 1]
+        || fabs(islandCentroid[axis] - expectedCentroid[axis]) > 1e-6)
+        {
+        std::cerr << "Extent or centroid of island " << n << " mismatch" << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageConnectedComponentsTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkImageData> input;
+  CreateInput(input.GetPointer());
+
+  vtkNew<vtkImageConnectedComponents> connectedComponents;
+  connectedComponents->SetInputData(input.GetPointer());
+  CHECK_INT(connectedComponents->GetConnectivity(), 6);
+
+  const int connectivities[] = { 6, 18, 26 };
+  int previousNumberOfIslands = VTK_INT_MAX;
+  for (int connectivityIndex = 0; connectivityIndex < 3; ++connectivityIndex)
+    {
+    ReferenceComponents reference = FloodFill(input.GetPointer(), connectivities[connectivityIndex]);
+    // More neighbors merge islands
+    CHECK_BOOL(static_cast<int>(reference.Sizes.size()) <= previousNumberOfIslands, true);
+    previousNumberOfIslands = static_cast<int>(reference.Sizes.size());
+
+    connectedComponents->SetConnectivity(connectivities[connectivityIndex]);
+    connectedComponents->BinaryOutputOff();
+    connectedComponents->SetMinimumSize(0);
+    connectedComponents->SetMaximumNumberOfIslands(0);
+
+    // Slabs labeled in parallel and merged
+    connectedComponents->SetNumberOfThreads(4);
+    connectedComponents->Update();
+    CHECK_INT(connectedComponents->GetNumberOfIslands(), static_cast<int>(reference.Sizes.size()));
+    CHECK_BOOL(CheckIslands(connectedComponents.GetPointer(), reference), true);
+
+    connectedComponents->SetNumberOfThreads(1);
+    connectedComponents->Update();
+    CHECK_BOOL(CheckIslands(connectedComponents.GetPointer(), reference), true);
+
+    // Small islands are removed
+    const vtkIdType minimumSize = 3;
+    connectedComponents->SetNumberOfThreads(4);
+    connectedComponents->SetMinimumSize(minimumSize);
+    connectedComponents->BinaryOutputOn();
+    connectedComponents->Update();
+    vtkDataArray* binaryScalars = connectedComponents->GetOutput()->GetPointData()->GetScalars();
+    int numberOfKeptIslands = 0;
+    for (size_t component = 0; component < reference.Sizes.size(); ++component)
+      {
+      numberOfKeptIslands += (reference.Sizes[component] >= minimumSize ? 1 : 0);
+      }
+    CHECK_INT(connectedComponents->GetNumberOfIslands(), numberOfKeptIslands);
+    int differentVoxels = 0;
+    for (int index = 0; index < static_cast<int>(reference.Labels.size()); ++index)
+      {
+      int component = reference.Labels[index];
+      int expectedValue = (component >= 0 && reference.Sizes[component] >= minimumSize ? 1 : 0);
+      if (static_cast<int>(binaryScalars->GetComponent(index, 0)) != expectedValue)
+        {
+        ++differentVoxels;
+        }
+      }
+    CHECK_INT(differentVoxels, 0);
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageDistanceMorphology.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Random blobs, some of them touching the image boundary
+void CreateLabelmap(vtkImageData* labelmap)
+{
+  labelmap->SetExtent(-3, 20, 0, 17, 2, 15);
+  labelmap->SetSpacing(1.0, 1.5, 2.0);
+  labelmap->AllocateScalars(VTK_SHORT, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+  int* extent = labelmap->GetExtent();
+  vtkMath::RandomSeed(4321);
+  for (int blob = 0; blob < 6; ++blob)
+    {
+    int center[3] = { 0, 0, 0 };
+    int radius[3] = { 0, 0, 0 };
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      center[axis] = static_cast<int>(vtkMath::Random(extent[axis * 2], extent[axis * 2 + 1] + 1));
+      radius[axis] = static_cast<int>(vtkMath::Random(1, 4));
+      }
+    for (int k = center[2] - radius[2]; k <= center[2] + radius[2]; ++k)
+      {
+      for (int j = center[1] - radius[1]; j <= center[1] + radius[1]; ++j)
+        {
+        for (int i = center[0] - radius[0]; i <= center[0] + radius[0]; ++i)
+          {
+          if (i >= extent[0] && i <= extent[1] && j >= extent[2] && j <= extent[3] && k >= extent[4] && k <= extent[5])
+            {
+            // labels other than 1 are foreground, too
+            labelmap->SetScalarComponentFromDouble(i, j, k, 0, blob + 1);
+            }
+          }
+        }
+      }
+    }
+  // Single isolated voxel
+  labelmap->SetScalarComponentFromDouble(10, 8, 8, 0, 1);
+}
+
+//----------------------------------------------------------------------------
+/// Brute-force reference: set voxels to siteValue where the physical distance from the
+/// nearest voxel that has siteValue is at most the specified distance.
+std::vector<unsigned char> BruteForceDistanceThreshold(const std::vector<unsigned char>& mask,
+  vtkImageData* geometry, unsigned char siteValue, double distance)
+{
+  int dimensions[3] = { 0, 0, 0 };
+  geometry->GetDimensions(dimensions);
+  double* spacing = geometry->GetSpacing();
+  std::vector<int> sites;
+  for (int index = 0; index < static_cast<int>(mask.size()); ++index)
+    {
+    if (mask[index] == siteValue)
+      {
+      sites.push_back(index);
+      }
+    }
+  double maximumSquaredDistance = distance * distance * (1.0 + 1e-6);
+  std::vector<unsigned char> result(mask);
+  for (int index = 0; index < static_cast<int>(mask.size()); ++index)
+    {
+    if (mask[index] == siteValue)
+      {
+      continue;
+      }
+    int i = index % dimensions[0];
+    int j = (index / dimensions[0]) % dimensions[1];
+    int k = index / (dimensions[0] * dimensions[1]);
+    for (std::vector<int>::iterator siteIt = sites.begin(); siteIt != sites.end(); ++siteIt)
+      {
+      double di = (i - (*siteIt) % dimensions[0]) * spacing[0];
+      double dj = (j - ((*siteIt) / dimensions[0]) % dimensions[1]) * spacing[1];
+      double dk = (k - (*siteIt) / (dimensions[0] * dimensions[1])) * spacing[2];
+      if (di * di + dj * dj + dk * dk <= maximumSquaredDistance)
+        {
+        result[index] = siteValue;
+        break;
+        }
+      }
+    }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+std::vector<unsigned char> GetMask(vtkImageData* image)
+{
+  std::vector<unsigned char> mask(image->GetNumberOfPoints(), 0);
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  for (vtkIdType index = 0; index < image->GetNumberOfPoints(); ++index)
+    {
+    mask[index] = (scalars->GetComponent(index, 0) != 0 ? 1 : 0);
+    }
+  return mask;
+}
+
+//----------------------------------------------------------------------------
+std::vector<unsigned char> ComputeReference(const std::vector<unsigned char>& mask, vtkImageData* geometry,
+  int operation, double distance)
+{
+  switch (operation)
+    {
+    case vtkImageDistanceMorphology::OperationGrow:
+      return BruteForceDistanceThreshold(mask, geometry, 1, distance);
+    case vtkImageDistanceMorphology::OperationShrink:
+      return BruteForceDistanceThreshold(mask, geometry, 0, distance);
+    case vtkImageDistanceMorphology::OperationOpening:
+      return BruteForceDistanceThreshold(BruteForceDistanceThreshold(mask, geometry, 0, distance), geometry, 1, distance);
+    case vtkImageDistanceMorphology::OperationClosing:
+    default:
+      return BruteForceDistanceThreshold(BruteForceDistanceThreshold(mask, geometry, 1, distance), geometry, 0, distance);
+    }
+}
+
+//----------------------------------------------------------------------------
+int CountDifferentVoxels(const std::vector<unsigned char>& mask1, const std::vector<unsigned char>& mask2)
+{
+  int differentVoxels = 0;
+  for (size_t index = 0; index < mask1.size() && index < mask2.size(); ++index)
+    {
+    if (mask1[index] != mask2[index])
+      {
+      ++differentVoxels;
+      }
+    }
+  return differentVoxels + static_cast<int>(std::max(mask1.size(), mask2.size()) - std::min(mask1.size(), mask2.size()));
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageDistanceMorphologyTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkImageData> labelmap;
+  CreateLabelmap(labelmap.GetPointer());
+  std::vector<unsigned char> inputMask = GetMask(labelmap.GetPointer());
+
+  vtkNew<vtkImageDistanceMorphology> morphology;
+  morphology->SetInputData(labelmap.GetPointer());
+  CHECK_INT(morphology->GetOperation(), vtkImageDistanceMorphology::OperationGrow);
+
+  // Distances that are exactly achievable between voxel centers (2.0, 3.0) and that are not (2.3, 4.7)
+  const double distances[] = { 2.0, 2.3, 3.0, 4.7 };
+  const int operations[] = { vtkImageDistanceMorphology::OperationGrow, vtkImageDistanceMorphology::OperationShrink,
+    vtkImageDistanceMorphology::OperationOpening, vtkImageDistanceMorphology::OperationClosing };
+  for (int distanceIndex = 0; distanceIndex < 4; ++distanceIndex)
+    {
+    for (int operationIndex = 0; operationIndex < 4; ++operationIndex)
+      {
+      std::vector<unsigned char> expectedMask = ComputeReference(inputMask, labelmap.GetPointer(),
+        operations[operationIndex], distances[distanceIndex]);
+      morphology->SetOperation(operations[operationIndex]);
+      morphology->SetDistance(distances[distanceIndex]);
+
+      morphology->SetNumberOfThreads(4);
+      morphology->Update();
+      vtkImageData* output = morphology->GetOutput();
+      CHECK_INT(output->GetScalarType(), VTK_UNSIGNED_CHAR);
+      CHECK_INT(output->GetNumberOfPoints(), labelmap->GetNumberOfPoints());
+      CHECK_INT(CountDifferentVoxels(GetMask(output), expectedMask), 0);
+
+      morphology->SetNumberOfThreads(1);
+      morphology->Update();
+      CHECK_INT(CountDifferentVoxels(GetMask(morphology->GetOutput()), expectedMask), 0);
+      }
+    }
+
+  // Margin of 0 does not change the labelmap
+  morphology->SetOperationToGrow();
+  morphology->SetDistance(0.0);
+  morphology->Update();
+  CHECK_INT(CountDifferentVoxels(GetMask(morphology->GetOutput()), inputMask), 0);
+
+  // Empty input gives empty output
+  vtkNew<vtkImageData> emptyLabelmap;
+  emptyLabelmap->SetExtent(0, 9, 0, 9, 0, 9);
+  emptyLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  emptyLabelmap->GetPointData()->GetScalars()->Fill(0);
+  morphology->SetInputData(emptyLabelmap.GetPointer());
+  morphology->SetDistance(3.0);
+  morphology->Update();
+  CHECK_INT(CountDifferentVoxels(GetMask(morphology->GetOutput()), GetMask(emptyLabelmap.GetPointer())), 0);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageGrowCutSegment.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+namespace
+{
+
+const int Dimension = 24;
+
+//----------------------------------------------------------------------------
+/// Random intensities make paths of exactly equal length (where the queue
+/// types could break ties differently) practically impossible.
+void CreateIntensityVolume(vtkImageData* intensityVolume)
+{
+  intensityVolume->SetDimensions(Dimension, Dimension, Dimension);
+  intensityVolume->AllocateScalars(VTK_FLOAT, 1);
+  float* intensityPtr = static_cast<float*>(intensityVolume->GetScalarPointer());
+  vtkMath::RandomSeed(1234);
+  for (vtkIdType index = 0; index < intensityVolume->GetNumberOfPoints(); ++index)
+    {
+    // smooth gradient along x with noise, so that labels form distinct regions
+    int x = index % Dimension;
+    intensityPtr[index] = static_cast<float>(x * 10.0 + vtkMath::Random(0.0, 25.0));
+    }
+}
+
+//----------------------------------------------------------------------------
+void SetSeed(vtkImageData* seedVolume, int x, int y, int z, short label)
+{
+  seedVolume->SetScalarComponentFromDouble(x, y, z, 0, label);
+  seedVolume->Modified();
+}
+
+//----------------------------------------------------------------------------
+int CountDifferentVoxels(vtkImageData* image1, vtkImageData* image2)
+{
+  short* voxels1 = static_cast<short*>(image1->GetScalarPointer());
+  short* voxels2 = static_cast<short*>(image2->GetScalarPointer());
+  int differentVoxels = 0;
+  for (vtkIdType index = 0; index < image1->GetNumberOfPoints(); ++index)
+    {
+    if (voxels1[index] != voxels2[index])
+      {
+      ++differentVoxels;
+      }
+    }
+  return differentVoxels;
+}
+
+//----------------------------------------------------------------------------
+int CountLabel(vtkImageData* image, short label)
+{
+  short* voxels = static_cast<short*>(image->GetScalarPointer());
+  int count = 0;
+  for (vtkIdType index = 0; index < image->GetNumberOfPoints(); ++index)
+    {
+    if (voxels[index] == label)
+      {
+      ++count;
+      }
+    }
+  return count;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageGrowCutSegmentTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkImageData> intensityVolume;
+  CreateIntensityVolume(intensityVolume.GetPointer());
+
+  vtkNew<vtkImageData> seedVolume;
+  seedVolume->SetDimensions(Dimension, Dimension, Dimension);
+  seedVolume->AllocateScalars(VTK_SHORT, 1);
+  seedVolume->GetPointData()->GetScalars()->Fill(0);
+  SetSeed(seedVolume.GetPointer(), 3, 12, 12, 1);
+  SetSeed(seedVolume.GetPointer(), 20, 12, 12, 2);
+  SetSeed(seedVolume.GetPointer(), 12, 3, 20, 3);
+
+  // Reference result: Fibonacci heap
+  vtkNew<vtkImageGrowCutSegment> fibonacciGrowCut;
+  fibonacciGrowCut->SetQueueType(vtkImageGrowCutSegment::QueueFibonacciHeap);
+  fibonacciGrowCut->SetIntensityVolume(intensityVolume.GetPointer());
+  fibonacciGrowCut->SetSeedLabelVolume(seedVolume.GetPointer());
+  fibonacciGrowCut->Update();
+  vtkImageData* fibonacciResult = fibonacciGrowCut->GetOutput();
+
+  vtkNew<vtkImageGrowCutSegment> radixGrowCut;
+  CHECK_INT(radixGrowCut->GetQueueType(), vtkImageGrowCutSegment::QueueRadixHeap);
+  radixGrowCut->SetNumberOfThreads(4);
+  radixGrowCut->SetIntensityVolume(intensityVolume.GetPointer());
+  radixGrowCut->SetSeedLabelVolume(seedVolume.GetPointer());
+  radixGrowCut->Update();
+  vtkImageData* radixResult = radixGrowCut->GetOutput();
+
+  // All labels are grown and the two queues give the same labels
+  CHECK_BOOL(CountLabel(fibonacciResult, 1) > 0, true);
+  CHECK_BOOL(CountLabel(fibonacciResult, 2) > 0, true);
+  CHECK_BOOL(CountLabel(fibonacciResult, 3) > 0, true);
+  CHECK_INT(CountDifferentVoxels(fibonacciResult, radixResult), 0);
+
+  // Single-threaded initialization gives the same result
+  vtkNew<vtkImageGrowCutSegment> singleThreadRadixGrowCut;
+  singleThreadRadixGrowCut->SetNumberOfThreads(1);
+  singleThreadRadixGrowCut->SetIntensityVolume(intensityVolume.GetPointer());
+  singleThreadRadixGrowCut->SetSeedLabelVolume(seedVolume.GetPointer());
+  singleThreadRadixGrowCut->Update();
+  CHECK_INT(CountDifferentVoxels(fibonacciResult, singleThreadRadixGrowCut->GetOutput()), 0);
+
+  // Incremental update after adding seeds: the new label takes over the same region
+  SetSeed(seedVolume.GetPointer(), 12, 20, 5, 4);
+  SetSeed(seedVolume.GetPointer(), 8, 12, 12, 2);
+  fibonacciGrowCut->Update();
+  radixGrowCut->Update();
+  CHECK_BOOL(CountLabel(fibonacciGrowCut->GetOutput(), 4) > 0, true);
+  CHECK_INT(CountDifferentVoxels(fibonacciGrowCut->GetOutput(), radixGrowCut->GetOutput()), 0);
+
+  // Full recomputation with the same seeds
+  fibonacciGrowCut->Reset();
+  fibonacciGrowCut->Modified();
+  fibonacciGrowCut->Update();
+  radixGrowCut->Reset();
+  radixGrowCut->Modified();
+  radixGrowCut->Update();
+  CHECK_INT(CountDifferentVoxels(fibonacciGrowCut->GetOutput(), radixGrowCut->GetOutput()), 0);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,644 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageConnectedComponents.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
+
+vtkStandardNewMacro(vtkImageConnectedComponents);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct IslandStatistics
+{
+  IslandStatistics()
+    : Size(0)
+    {
+    Extent[0] = Extent[2] = Extent[4] = VTK_INT_MAX;
+    Extent[1] = Extent[3] = Extent[5] = VTK_INT_MIN;
+    Sum[0] = Sum[1] = Sum[2] = 0.0;
+    }
+  vtkIdType Size;
+  int Extent[6];
+  double Sum[3];
+};
+
+//----------------------------------------------------------------------------
+/// Foreground mask and union-find forest of the processed region.
+/// Each foreground voxel is a node of the forest, identified by its index in the region.
+/// The root of each tree is always the node with the lowest index.
+struct Region
+{
+  int Dimensions[3];
+  std::vector<unsigned char> Mask;
+  std::vector<vtkTypeUInt32> Parent;
+  /// Offsets (dx, dy, dz) of the neighbors that precede a voxel in raster order
+  std::vector<int> NeighborOffsets;
+
+  vtkTypeUInt32 Find(vtkTypeUInt32 node)
+    {
+    // Path halving
+    while (this->Parent[node] != node)
+      {
+      this->Parent[node] = this->Parent[this->Parent[node]];
+      node = this->Parent[node];
+      }
+    return node;
+    }
+
+  void Union(vtkTypeUInt32 node1, vtkTypeUInt32 node2)
+    {
+    vtkTypeUInt32 root1 = this->Find(node1);
+    vtkTypeUInt32 root2 = this->Find(node2);
+    if (root1 < root2)
+      {
+      this->Parent[root2] = root1;
+      }
+    else if (root2 < root1)
+      {
+      this->Parent[root1] = root2;
+      }
+    }
+
+  /// Merge voxel with its foreground neighbors that precede it in raster order.
+  /// Neighbors in slices before minimumZ are ignored.
+  void MergeWithNeighbors(int x, int y, int z, int minimumZ, bool previousSliceOnly)
+    {
+    vtkTypeUInt32 node = static_cast<vtkTypeUInt32>(x + this->Dimensions[0] * (y + static_cast<vtkIdType>(this->Dimensions[1]) * z));
+    for (size_t offsetIndex = 0; offsetIndex < this->NeighborOffsets.size(); offsetIndex += 3)
+      {
+      int dx = this->NeighborOffsets[offsetIndex];
+      int dy = this->NeighborOffsets[offsetIndex + 1];
+      int dz = this->NeighborOffsets[offsetIndex + 2];
+      if (previousSliceOnly && dz == 0)
+        {
+        continue;
+        }
+      int nx = x + dx;
+      int ny = y + dy;
+      int nz = z + dz;
+      if (nx < 0 || nx >= this->Dimensions[0] || ny < 0 || ny >= this->Dimensions[1] || nz < minimumZ)
+        {
+        continue;
+        }
+      vtkTypeUInt32 neighbor = static_cast<vtkTypeUInt32>(nx + this->Dimensions[0] * (ny + static_cast<vtkIdType>(this->Dimensions[1]) * nz));
+      if (this->Mask[neighbor])
+        {
+        this->Union(node, neighbor);
+        }
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+/// Operation that is run in parallel on slabs of z slices of the region
+class SliceRangeFunctor
+{
+public:
+  virtual ~SliceRangeFunctor() {}
+  virtual void Execute(int zBegin, int zEnd) = 0;
+  int DimZ;
+  int NumberOfSlabs;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE SliceRangeThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SliceRangeFunctor* functor = static_cast<SliceRangeFunctor*>(info->UserData);
+  int zBegin = static_cast<int>(static_cast<vtkIdType>(functor->DimZ) * info->ThreadID / functor->NumberOfSlabs);
+  int zEnd = static_cast<int>(static_cast<vtkIdType>(functor->DimZ) * (info->ThreadID + 1) / functor->NumberOfSlabs);
+  functor->Execute(zBegin, zEnd);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Split the region to slabs and run the functor on them in parallel. Slab i contains slices
+/// [dimZ * i / numberOfSlabs, dimZ * (i + 1) / numberOfSlabs).
+void ParallelForSlabs(SliceRangeFunctor& functor, int dimZ, int numberOfSlabs)
+{
+  functor.DimZ = dimZ;
+  functor.NumberOfSlabs = numberOfSlabs;
+  if (numberOfSlabs <= 1)
+    {
+    functor.Execute(0, dimZ);
+    return;
+    }
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfSlabs);
+  threader->SetSingleMethod(SliceRangeThreadFunction, &functor);
+  threader->SingleMethodExecute();
+}
+
+//----------------------------------------------------------------------------
+/// Label each slab independently. Trees of different slabs are disjoint, therefore slabs can be processed in parallel.
+class LabelSlabFunctor : public SliceRangeFunctor
+{
+public:
+  virtual void Execute(int zBegin, int zEnd)
+  {
+    Region& region = *this->RegionData;
+    for (int z = zBegin; z < zEnd; ++z)
+      {
+      for (int y = 0; y < region.Dimensions[1]; ++y)
+        {
+        vtkIdType node = region.Dimensions[0] * (y + static_cast<vtkIdType>(region.Dimensions[1]) * z);
+        for (int x = 0; x < region.Dimensions[0]; ++x, ++node)
+          {
+          if (!region.Mask[node])
+            {
+            continue;
+            }
+          region.Parent[node] = static_cast<vtkTypeUInt32>(node);
+          region.MergeWithNeighbors(x, y, z, zBegin, false);
+          }
+        }
+      }
+  }
+  Region* RegionData;
+};
+
+//----------------------------------------------------------------------------
+/// Find index of the island that the root belongs to. Roots are sorted, so binary search can be used.
+/// Consecutive voxels usually belong to the same island, so the last result is cached.
+class IslandIndexLookup
+{
+public:
+  IslandIndexLookup(const std::vector<vtkTypeUInt32>& roots)
+    : Roots(roots)
+    , LastRoot(0)
+    , LastIndex(-1)
+    {
+    }
+  int GetIslandIndex(vtkTypeUInt32 root)
+    {
+    if (this->LastIndex < 0 || root != this->LastRoot)
+      {
+      this->LastRoot = root;
+      this->LastIndex = static_cast<int>(std::lower_bound(this->Roots.begin(), this->Roots.end(), root) - this->Roots.begin());
+      }
+    return this->LastIndex;
+    }
+private:
+  const std::vector<vtkTypeUInt32>& Roots;
+  vtkTypeUInt32 LastRoot;
+  int LastIndex;
+};
+
+//----------------------------------------------------------------------------
+/// Write output label of each voxel of the region
+template <class T>
+class WriteOutputFunctor : public SliceRangeFunctor
+{
+public:
+  virtual void Execute(int zBegin, int zEnd)
+  {
+    Region& region = *this->RegionData;
+    IslandIndexLookup lookup(*this->Roots);
+    for (int z = zBegin; z < zEnd; ++z)
+      {
+      for (int y = 0; y < region.Dimensions[1]; ++y)
+        {
+        vtkIdType node = region.Dimensions[0] * (y + static_cast<vtkIdType>(region.Dimensions[1]) * z);
+        T* outputVoxel = static_cast<T*>(this->Output->GetScalarPointer(
+          this->RegionExtent[0], this->RegionExtent[2] + y, this->RegionExtent[4] + z));
+        for (int x = 0; x < region.Dimensions[0]; ++x, ++node, ++outputVoxel)
+          {
+          if (!region.Mask[node])
+            {
+            continue;
+            }
+          int rank = (*this->RankOfIsland)[lookup.GetIslandIndex(region.Parent[node])];
+          if (rank >= this->NumberOfKeptIslands)
+            {
+            continue;
+            }
+          *outputVoxel = static_cast<T>(this->BinaryOutput ? 1 : rank + 1);
+          }
+        }
+      }
+  }
+  Region* RegionData;
+  const std::vector<vtkTypeUInt32>* Roots;
+  const std::vector<int>* RankOfIsland;
+  int NumberOfKeptIslands;
+  bool BinaryOutput;
+  vtkImageData* Output;
+  int RegionExtent[6];
+};
+
+//----------------------------------------------------------------------------
+/// Get bounding box of non-zero voxels. Returns false if there are no such voxels.
+template <class T>
+bool GetForegroundExtent(vtkImageData* image, int foregroundExtent[6])
+{
+  int* extent = image->GetExtent();
+  foregroundExtent[0] = foregroundExtent[2] = foregroundExtent[4] = VTK_INT_MAX;
+  foregroundExtent[1] = foregroundExtent[3] = foregroundExtent[5] = VTK_INT_MIN;
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  T* voxel = static_cast<T*>(image->GetScalarPointerForExtent(extent));
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i, voxel += numberOfComponents)
+        {
+        if (*voxel == 0)
+          {
+          continue;
+          }
+        foregroundExtent[0] = std::min(foregroundExtent[0], i);
+        foregroundExtent[1] = std::max(foregroundExtent[1], i);
+        foregroundExtent[2] = std::min(foregroundExtent[2], j);
+        foregroundExtent[3] = std::max(foregroundExtent[3], j);
+        foregroundExtent[4] = std::min(foregroundExtent[4], k);
+        foregroundExtent[5] = std::max(foregroundExtent[5], k);
+        }
+      }
+    }
+  return foregroundExtent[0] <= foregroundExtent[1];
+}
+
+//----------------------------------------------------------------------------
+/// Copy foreground mask of the region from the input image
+template <class T>
+void GetMask(vtkImageData* image, const int regionExtent[6], Region& region)
+{
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  unsigned char* mask = &region.Mask[0];
+  for (int k = regionExtent[4]; k <= regionExtent[5]; ++k)
+    {
+    for (int j = regionExtent[2]; j <= regionExtent[3]; ++j)
+      {
+      T* voxel = static_cast<T*>(image->GetScalarPointer(regionExtent[0], j, k));
+      for (int i = regionExtent[0]; i <= regionExtent[1]; ++i, voxel += numberOfComponents)
+        {
+        *(mask++) = (*voxel != 0 ? 1 : 0);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Orders islands by decreasing size. Islands of equal size are kept in raster order of their first voxel.
+struct IslandSizeGreater
+{
+  IslandSizeGreater(const std::vector<IslandStatistics>& islands) : Islands(islands) {}
+  bool operator()(int a, int b) const
+    {
+    return this->Islands[a].Size > this->Islands[b].Size;
+    }
+  const std::vector<IslandStatistics>& Islands;
+};
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkImageConnectedComponents::vtkInternal
+{
+public:
+  /// Statistics of all islands, sorted by decreasing size, in input image IJK coordinates
+  std::vector<IslandStatistics> Islands;
+  int NumberOfKeptIslands;
+};
+
+//-----------------------------------------------------------------------------
+vtkImageConnectedComponents::vtkImageConnectedComponents()
+{
+  this->Internal = new vtkInternal();
+  this->Internal->NumberOfKeptIslands = 0;
+  this->Connectivity = 6;
+  this->MinimumSize = 0;
+  this->MaximumNumberOfIslands = 0;
+  this->BinaryOutput = false;
+  this->NumberOfThreads = 0;
+}
+
+//-----------------------------------------------------------------------------
+vtkImageConnectedComponents::~vtkImageConnectedComponents()
+{
+  delete this->Internal;
+}
+
+//-----------------------------------------------------------------------------
+int vtkImageConnectedComponents::RequestInformation(
+  vtkInformation * request,
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  this->Superclass::RequestInformation(request, inputVector, outputVector);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, this->BinaryOutput ? VTK_UNSIGNED_CHAR : VTK_UNSIGNED_INT, 1);
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+void vtkImageConnectedComponents::ExecuteDataWithInformation(
+  vtkDataObject *outputDataObject, vtkInformation* vtkNotUsed(outputInfo))
+{
+  this->Internal->Islands.clear();
+  this->Internal->NumberOfKeptIslands = 0;
+
+  vtkImageData *input = vtkImageData::SafeDownCast(this->GetInput());
+  vtkImageData *output = vtkImageData::SafeDownCast(outputDataObject);
+  if (!input || !output)
+    {
+    vtkErrorMacro("ExecuteDataWithInformation: Invalid input or output");
+    return;
+    }
+  if (this->Connectivity != 6 && this->Connectivity != 18 && this->Connectivity != 26)
+    {
+    vtkErrorMacro("ExecuteDataWithInformation: Invalid connectivity " << this->Connectivity << ", must be 6, 18, or 26");
+    return;
+    }
+
+  vtkNew<vtkTimerLog> logger;
+  logger->StartTimer();
+
+  int* extent = input->GetExtent();
+  output->SetExtent(extent);
+  output->AllocateScalars(this->BinaryOutput ? VTK_UNSIGNED_CHAR : VTK_UNSIGNED_INT, 1);
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return;
+    }
+  memset(output->GetScalarPointerForExtent(extent), 0,
+    static_cast<size_t>(output->GetNumberOfPoints()) * output->GetScalarSize());
+
+  // Limit processing to the bounding box of the foreground
+  int regionExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool foregroundFound = false;
+  switch (input->GetScalarType())
+    {
+    vtkTemplateMacro(foregroundFound = GetForegroundExtent<VTK_TT>(input, regionExtent));
+    default:
+      vtkErrorMacro("ExecuteDataWithInformation: Unknown scalar type");
+      return;
+    }
+  if (!foregroundFound)
+    {
+    return;
+    }
+  Region region;
+  vtkIdType numberOfVoxels = 1;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    region.Dimensions[axis] = regionExtent[axis * 2 + 1] - regionExtent[axis * 2] + 1;
+    numberOfVoxels *= region.Dimensions[axis];
+    }
+  if (numberOfVoxels >= static_cast<vtkIdType>(VTK_TYPE_UINT32_MAX))
+    {
+    vtkErrorMacro("ExecuteDataWithInformation: Region of non-zero voxels is too large (" << numberOfVoxels << " voxels)");
+    return;
+    }
+  region.Mask.resize(numberOfVoxels);
+  region.Parent.resize(numberOfVoxels);
+  switch (input->GetScalarType())
+    {
+    vtkTemplateMacro(GetMask<VTK_TT>(input, regionExtent, region));
+    }
+
+  // Neighbors that precede a voxel in raster order
+  for (int dz = -1; dz <= 0; ++dz)
+    {
+    for (int dy = -1; dy <= 1; ++dy)
+      {
+      for (int dx = -1; dx <= 1; ++dx)
+        {
+        if (dz == 0 && (dy > 0 || (dy == 0 && dx >= 0)))
+          {
+          continue;
+          }
+        int numberOfNonZeroOffsets = (dx != 0 ? 1 : 0) + (dy != 0 ? 1 : 0) + (dz != 0 ? 1 : 0);
+        if ((this->Connectivity == 6 && numberOfNonZeroOffsets > 1)
+          || (this->Connectivity == 18 && numberOfNonZeroOffsets > 2))
+          {
+          continue;
+          }
+        region.NeighborOffsets.push_back(dx);
+        region.NeighborOffsets.push_back(dy);
+        region.NeighborOffsets.push_back(dz);
+        }
+      }
+    }
+
+  // Label slabs in parallel
+  int numberOfThreads = (this->NumberOfThreads > 0 ? this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  int numberOfSlabs = std::max(1, std::min(std::min(numberOfThreads, region.Dimensions[2]), VTK_MAX_THREADS));
+  LabelSlabFunctor labelSlabFunctor;
+  labelSlabFunctor.RegionData = &region;
+  ParallelForSlabs(labelSlabFunctor, region.Dimensions[2], numberOfSlabs);
+
+  // Merge slabs along their boundaries
+  for (int slabIndex = 1; slabIndex < numberOfSlabs; ++slabIndex)
+    {
+    int z = static_cast<int>(static_cast<vtkIdType>(region.Dimensions[2]) * slabIndex / numberOfSlabs);
+    for (int y = 0; y < region.Dimensions[1]; ++y)
+      {
+      vtkIdType node = region.Dimensions[0] * (y + static_cast<vtkIdType>(region.Dimensions[1]) * z);
+      for (int x = 0; x < region.Dimensions[0]; ++x, ++node)
+        {
+        if (region.Mask[node])
+          {
+          region.MergeWithNeighbors(x, y, z, z - 1, true);
+          }
+        }
+      }
+    }
+
+  // Point each node directly to its root and compute island statistics.
+  // Parent of a node always has lower index, so it is already resolved when the node is visited.
+  std::vector<vtkTypeUInt32> roots;
+  std::vector<IslandStatistics> islands;
+  {
+  IslandIndexLookup lookup(roots);
+  vtkIdType node = 0;
+  for (int z = 0; z < region.Dimensions[2]; ++z)
+    {
+    for (int y = 0; y < region.Dimensions[1]; ++y)
+      {
+      for (int x = 0; x < region.Dimensions[0]; ++x, ++node)
+        {
+        if (!region.Mask[node])
+          {
+          continue;
+          }
+        vtkTypeUInt32 root = region.Parent[region.Parent[node]];
+        region.Parent[node] = root;
+        int islandIndex = 0;
+        if (root == static_cast<vtkTypeUInt32>(node))
+          {
+          islandIndex = static_cast<int>(islands.size());
+          roots.push_back(root);
+          islands.push_back(IslandStatistics());
+          }
+        else
+          {
+          islandIndex = lookup.GetIslandIndex(root);
+          }
+        IslandStatistics& island = islands[islandIndex];
+        island.Size++;
+        island.Extent[0] = std::min(island.Extent[0], x);
+        island.Extent[1] = std::max(island.Extent[1], x);
+        island.Extent[2] = std::min(island.Extent[2], y);
+        island.Extent[3] = std::max(island.Extent[3], y);
+        island.Extent[4] = std::min(island.Extent[4], z);
+        island.Extent[5] = std::max(island.Extent[5], z);
+        island.Sum[0] += x;
+        island.Sum[1] += y;
+        island.Sum[2] += z;
+        }
+      }
+    }
+  }
+
+  // Sort islands by size and determine which ones are kept
+  std::vector<int> islandOrder(islands.size());
+  for (size_t islandIndex = 0; islandIndex < islands.size(); ++islandIndex)
+    {
+    islandOrder[islandIndex] = static_cast<int>(islandIndex);
+    }
+  std::stable_sort(islandOrder.begin(), islandOrder.end(), IslandSizeGreater(islands));
+  std::vector<int> rankOfIsland(islands.size());
+  int numberOfKeptIslands = 0;
+  this->Internal->Islands.resize(islands.size());
+  for (size_t rank = 0; rank < islandOrder.size(); ++rank)
+    {
+    rankOfIsland[islandOrder[rank]] = static_cast<int>(rank);
+    IslandStatistics& island = this->Internal->Islands[rank];
+    island = islands[islandOrder[rank]];
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      island.Extent[axis * 2] += regionExtent[axis * 2];
+      island.Extent[axis * 2 + 1] += regionExtent[axis * 2];
+      island.Sum[axis] += static_cast<double>(island.Size) * regionExtent[axis * 2];
+      }
+    // Islands are sorted by size, therefore kept islands are always the first ones
+    if (island.Size >= this->MinimumSize
+      && (this->MaximumNumberOfIslands == 0 || numberOfKeptIslands < this->MaximumNumberOfIslands))
+      {
+      numberOfKeptIslands++;
+      }
+    }
+  this->Internal->NumberOfKeptIslands = numberOfKeptIslands;
+
+  // Write output in parallel
+  if (this->BinaryOutput)
+    {
+    WriteOutputFunctor<unsigned char> writeOutputFunctor;
+    writeOutputFunctor.RegionData = &region;
+    writeOutputFunctor.Roots = &roots;
+    writeOutputFunctor.RankOfIsland = &rankOfIsland;
+    writeOutputFunctor.NumberOfKeptIslands = numberOfKeptIslands;
+    writeOutputFunctor.BinaryOutput = true;
+    writeOutputFunctor.Output = output;
+    std::copy(regionExtent, regionExtent + 6, writeOutputFunctor.RegionExtent);
+    ParallelForSlabs(writeOutputFunctor, region.Dimensions[2], numberOfSlabs);
+    }
+  else
+    {
+    WriteOutputFunctor<unsigned int> writeOutputFunctor;
+    writeOutputFunctor.RegionData = &region;
+    writeOutputFunctor.Roots = &roots;
+    writeOutputFunctor.RankOfIsland = &rankOfIsland;
+    writeOutputFunctor.NumberOfKeptIslands = numberOfKeptIslands;
+    writeOutputFunctor.BinaryOutput = false;
+    writeOutputFunctor.Output = output;
+    std::copy(regionExtent, regionExtent + 6, writeOutputFunctor.RegionExtent);
+    ParallelForSlabs(writeOutputFunctor, region.Dimensions[2], numberOfSlabs);
+    }
+
+  logger->StopTimer();
+  vtkDebugMacro(<< "vtkImageConnectedComponents execution time: " << logger->GetElapsedTime()
+    << ", found " << islands.size() << " islands");
+}
+
+//-----------------------------------------------------------------------------
+int vtkImageConnectedComponents::GetNumberOfIslands()
+{
+  return this->Internal->NumberOfKeptIslands;
+}
+
+//-----------------------------------------------------------------------------
+int vtkImageConnectedComponents::GetOriginalNumberOfIslands()
+{
+  return static_cast<int>(this->Internal->Islands.size());
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkImageConnectedComponents::GetIslandSize(int n)
+{
+  if (n < 0 || n >= static_cast<int>(this->Internal->Islands.size()))
+    {
+    vtkErrorMacro("GetIslandSize: Invalid island index " << n);
+    return 0;
+    }
+  return this->Internal->Islands[n].Size;
+}
+
+//-----------------------------------------------------------------------------
+void vtkImageConnectedComponents::GetIslandExtent(int n, int extent[6])
+{
+  if (n < 0 || n >= static_cast<int>(this->Internal->Islands.size()))
+    {
+    vtkErrorMacro("GetIslandExtent: Invalid island index " << n);
+    extent[0] = extent[2] = extent[4] = 0;
+    extent[1] = extent[3] = extent[5] = -1;
+    return;
+    }
+  std::copy(this->Internal->Islands[n].Extent, this->Internal->Islands[n].Extent + 6, extent);
+}
+
+//-----------------------------------------------------------------------------
+void vtkImageConnectedComponents::GetIslandCentroid(int n, double centroidIjk[3])
+{
+  if (n < 0 || n >= static_cast<int>(this->Internal->Islands.size()))
+    {
+    vtkErrorMacro("GetIslandCentroid: Invalid island index " << n);
+    centroidIjk[0] = centroidIjk[1] = centroidIjk[2] = 0.0;
+    return;
+    }
+  IslandStatistics& island = this->Internal->Islands[n];
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    centroidIjk[axis] = island.Sum[axis] / island.Size;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkImageConnectedComponents::PrintSelf(ostream &os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Connectivity: " << this->Connectivity << "\n";
+  os << indent << "MinimumSize: " << this->MinimumSize << "\n";
+  os << indent << "MaximumNumberOfIslands: " << this->MaximumNumberOfIslands << "\n";
+  os << indent << "BinaryOutput: " << (this->BinaryOutput ? "true" : "false") << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "NumberOfIslands: " << this->GetNumberOfIslands() << "\n";
+  os << indent << "OriginalNumberOfIslands: " << this->GetOriginalNumberOfIslands() << "\n";
+}
@@ -0,0 +1,98 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkImageConnectedComponents_h
+#define __vtkImageConnectedComponents_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+#include <vtkImageAlgorithm.h>
+
+/// \ingroup Segmentations
+/// \brief Find islands (connected components) of non-zero voxels of an image
+/// \details Islands are labeled using union-find: slabs of slices are labeled in parallel,
+///   then the slabs are merged along their boundaries. Processing is limited to the bounding
+///   box of the non-zero voxels. Size, extent, and centroid of each island are computed
+///   during labeling.
+///
+///   Islands are sorted by decreasing size. Islands that are smaller than MinimumSize or
+///   beyond MaximumNumberOfIslands are removed. The output either contains the rank of each
+///   kept island (1 = largest island, unsigned int scalars) or, if BinaryOutput is enabled,
+///   1 in all voxels of kept islands (unsigned char scalars).
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageConnectedComponents : public vtkImageAlgorithm
+{
+public:
+  static vtkImageConnectedComponents* New();
+  vtkTypeMacro(vtkImageConnectedComponents, vtkImageAlgorithm);
+  void PrintSelf(ostream &os, vtkIndent indent);
+
+  // Number of neighbors that are considered connected: 6 (face), 18 (face and edge),
+  // or 26 (face, edge, and corner). Default is 6.
+  vtkSetMacro(Connectivity, int);
+  vtkGetMacro(Connectivity, int);
+
+  // Islands with fewer voxels than this are removed. Default is 0 (all islands are kept).
+  vtkSetClampMacro(MinimumSize, vtkIdType, 0, VTK_ID_MAX);
+  vtkGetMacro(MinimumSize, vtkIdType);
+
+  // Only this many of the largest islands are kept. Default is 0 (all islands are kept).
+  vtkSetClampMacro(MaximumNumberOfIslands, int, 0, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfIslands, int);
+
+  // If enabled then all kept islands are set to 1 in the output. If disabled (default) then
+  // voxels of each kept island are set to the rank of the island (largest island is 1).
+  vtkSetMacro(BinaryOutput, bool);
+  vtkGetMacro(BinaryOutput, bool);
+  vtkBooleanMacro(BinaryOutput, bool);
+
+  // Number of threads used for labeling. If 0 (default) then the global default number of threads is used.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Number of islands that are kept in the output (after last update)
+  int GetNumberOfIslands();
+  /// Number of islands found in the input (after last update)
+  int GetOriginalNumberOfIslands();
+
+  /// Number of voxels of the n-th largest island. Islands that are not kept in the output are included,
+  /// too (n >= GetNumberOfIslands()).
+  vtkIdType GetIslandSize(int n);
+  /// Bounding extent of the n-th largest island
+  void GetIslandExtent(int n, int extent[6]);
+  /// Centroid of the n-th largest island in IJK coordinates
+  void GetIslandCentroid(int n, double centroidIjk[3]);
+
+protected:
+  vtkImageConnectedComponents();
+  virtual ~vtkImageConnectedComponents();
+
+  virtual void ExecuteDataWithInformation(vtkDataObject *outData, vtkInformation *outInfo);
+  virtual int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+
+  int Connectivity;
+  vtkIdType MinimumSize;
+  int MaximumNumberOfIslands;
+  bool BinaryOutput;
+  int NumberOfThreads;
+
+private:
+  vtkImageConnectedComponents(const vtkImageConnectedComponents&); // Not implemented
+  void operator=(const vtkImageConnectedComponents&);              // Not implemented
+
+  class vtkInternal;
+  vtkInternal * Internal;
+};
+
+#endif
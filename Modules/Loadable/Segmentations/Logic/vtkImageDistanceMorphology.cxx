@@ -0,0 +1,413 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageDistanceMorphology.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
+
+vtkStandardNewMacro(vtkImageDistanceMorphology);
+
+namespace
+{
+
+/// Squared distance of voxels that are not reachable from any site
+const float INFINITE_DISTANCE = VTK_FLOAT_MAX;
+
+//----------------------------------------------------------------------------
+/// Binary mask and distance buffer of the processed region
+struct Region
+{
+  int Dimensions[3];
+  double Spacing[3];
+  std::vector<unsigned char> Mask;
+  std::vector<float> SquaredDistance;
+};
+
+//----------------------------------------------------------------------------
+/// Operation that is run in parallel on ranges of image lines
+class LineRangeFunctor
+{
+public:
+  virtual ~LineRangeFunctor() {}
+  virtual void Execute(vtkIdType lineBegin, vtkIdType lineEnd) = 0;
+  vtkIdType NumberOfLines;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE LineRangeThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  LineRangeFunctor* functor = static_cast<LineRangeFunctor*>(info->UserData);
+  vtkIdType lineBegin = functor->NumberOfLines * info->ThreadID / info->NumberOfThreads;
+  vtkIdType lineEnd = functor->NumberOfLines * (info->ThreadID + 1) / info->NumberOfThreads;
+  functor->Execute(lineBegin, lineEnd);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void ParallelForLines(LineRangeFunctor& functor, vtkIdType numberOfLines, int numberOfThreads)
+{
+  functor.NumberOfLines = numberOfLines;
+  if (numberOfThreads > numberOfLines)
+    {
+    numberOfThreads = static_cast<int>(numberOfLines);
+    }
+  if (numberOfThreads <= 1)
+    {
+    functor.Execute(0, numberOfLines);
+    return;
+    }
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::min(numberOfThreads, VTK_MAX_THREADS));
+  threader->SetSingleMethod(LineRangeThreadFunction, &functor);
+  threader->SingleMethodExecute();
+}
+
+//----------------------------------------------------------------------------
+/// Compute squared distance transform along lines of one axis.
+/// Each line is replaced by the lower envelope of parabolas rooted at its samples
+/// (Felzenszwalb and Huttenlocher, Distance Transforms of Sampled Functions, 2012).
+class DistanceTransformLinesFunctor : public LineRangeFunctor
+{
+public:
+  virtual void Execute(vtkIdType lineBegin, vtkIdType lineEnd)
+  {
+    const int* dims = this->RegionData->Dimensions;
+    int n = dims[this->Axis];
+    double spacing = this->RegionData->Spacing[this->Axis];
+    vtkIdType stride = (this->Axis == 0 ? 1 : (this->Axis == 1 ? dims[0] : static_cast<vtkIdType>(dims[0]) * dims[1]));
+    std::vector<double> f(n);
+    std::vector<int> v(n);
+    std::vector<double> z(n + 1);
+    float* distances = &this->RegionData->SquaredDistance[0];
+    for (vtkIdType line = lineBegin; line < lineEnd; ++line)
+      {
+      vtkIdType start = 0;
+      if (this->Axis == 0)
+        {
+        start = line * dims[0];
+        }
+      else if (this->Axis == 1)
+        {
+        start = (line % dims[0]) + (line / dims[0]) * dims[0] * dims[1];
+        }
+      else
+        {
+        start = line;
+        }
+      float* lineDistances = distances + start;
+
+      // Build lower envelope of the parabolas of the finite samples
+      int k = -1;
+      for (int q = 0; q < n; ++q)
+        {
+        f[q] = lineDistances[q * stride];
+        if (f[q] >= INFINITE_DISTANCE)
+          {
+          continue;
+          }
+        if (k < 0)
+          {
+          k = 0;
+          v[0] = q;
+          z[0] = -VTK_DOUBLE_MAX;
+          continue;
+          }
+        double xq = q * spacing;
+        double s = 0;
+        while (true)
+          {
+          double xv = v[k] * spacing;
+          s = ((f[q] + xq * xq) - (f[v[k]] + xv * xv)) / (2.0 * (xq - xv));
+          if (s > z[k])
+            {
+            break;
+            }
+          --k; // z[0] is -infinity, so k never goes below 0
+          }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        }
+      if (k < 0)
+        {
+        // No sites in this line, distances remain infinite
+        continue;
+        }
+      z[k + 1] = VTK_DOUBLE_MAX;
+
+      // Sample the lower envelope
+      int j = 0;
+      for (int p = 0; p < n; ++p)
+        {
+        double xp = p * spacing;
+        while (z[j + 1] < xp)
+          {
+          ++j;
+          }
+        double dx = xp - v[j] * spacing;
+        lineDistances[p * stride] = static_cast<float>(dx * dx + f[v[j]]);
+        }
+      }
+  }
+
+  Region* RegionData;
+  int Axis;
+};
+
+//----------------------------------------------------------------------------
+/// Compute squared distance of each voxel from the nearest voxel that has the specified mask value
+void ComputeSquaredDistance(Region& region, unsigned char siteValue, int numberOfThreads)
+{
+  size_t numberOfVoxels = region.Mask.size();
+  region.SquaredDistance.resize(numberOfVoxels);
+  for (size_t i = 0; i < numberOfVoxels; ++i)
+    {
+    region.SquaredDistance[i] = (region.Mask[i] == siteValue ? 0.0f : INFINITE_DISTANCE);
+    }
+  const int* dims = region.Dimensions;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    DistanceTransformLinesFunctor functor;
+    functor.RegionData = &region;
+    functor.Axis = axis;
+    vtkIdType numberOfLines = static_cast<vtkIdType>(numberOfVoxels) / dims[axis];
+    ParallelForLines(functor, numberOfLines, numberOfThreads);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Set mask to foreground where squared distance from foreground is within the margin
+void Grow(Region& region, double distance, int numberOfThreads)
+{
+  ComputeSquaredDistance(region, 1, numberOfThreads);
+  // Tolerance makes voxels exactly at the specified distance included reliably
+  double maximumSquaredDistance = distance * distance * (1.0 + 1e-6);
+  for (size_t i = 0; i < region.Mask.size(); ++i)
+    {
+    region.Mask[i] = (region.SquaredDistance[i] <= maximumSquaredDistance ? 1 : 0);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Set mask to background where squared distance from background is within the margin
+void Shrink(Region& region, double distance, int numberOfThreads)
+{
+  ComputeSquaredDistance(region, 0, numberOfThreads);
+  double maximumSquaredDistance = distance * distance * (1.0 + 1e-6);
+  for (size_t i = 0; i < region.Mask.size(); ++i)
+    {
+    region.Mask[i] = (region.SquaredDistance[i] <= maximumSquaredDistance ? 0 : 1);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Get bounding box of non-zero voxels. Returns false if there are no such voxels.
+template <class T>
+bool GetForegroundExtent(vtkImageData* image, int foregroundExtent[6])
+{
+  int* extent = image->GetExtent();
+  foregroundExtent[0] = foregroundExtent[2] = foregroundExtent[4] = VTK_INT_MAX;
+  foregroundExtent[1] = foregroundExtent[3] = foregroundExtent[5] = VTK_INT_MIN;
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  T* voxel = static_cast<T*>(image->GetScalarPointerForExtent(extent));
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i, voxel += numberOfComponents)
+        {
+        if (*voxel == 0)
+          {
+          continue;
+          }
+        foregroundExtent[0] = std::min(foregroundExtent[0], i);
+        foregroundExtent[1] = std::max(foregroundExtent[1], i);
+        foregroundExtent[2] = std::min(foregroundExtent[2], j);
+        foregroundExtent[3] = std::max(foregroundExtent[3], j);
+        foregroundExtent[4] = std::min(foregroundExtent[4], k);
+        foregroundExtent[5] = std::max(foregroundExtent[5], k);
+        }
+      }
+    }
+  return foregroundExtent[0] <= foregroundExtent[1];
+}
+
+//----------------------------------------------------------------------------
+/// Copy foreground mask of the region from the input image
+template <class T>
+void GetMask(vtkImageData* image, const int regionExtent[6], Region& region)
+{
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  unsigned char* mask = &region.Mask[0];
+  for (int k = regionExtent[4]; k <= regionExtent[5]; ++k)
+    {
+    for (int j = regionExtent[2]; j <= regionExtent[3]; ++j)
+      {
+      T* voxel = static_cast<T*>(image->GetScalarPointer(regionExtent[0], j, k));
+      for (int i = regionExtent[0]; i <= regionExtent[1]; ++i, voxel += numberOfComponents)
+        {
+        *(mask++) = (*voxel != 0 ? 1 : 0);
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+vtkImageDistanceMorphology::vtkImageDistanceMorphology()
+{
+  this->Operation = OperationGrow;
+  this->Distance = 1.0;
+  this->NumberOfThreads = 0;
+}
+
+//-----------------------------------------------------------------------------
+vtkImageDistanceMorphology::~vtkImageDistanceMorphology()
+{
+}
+
+//-----------------------------------------------------------------------------
+int vtkImageDistanceMorphology::RequestInformation(
+  vtkInformation * request,
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  this->Superclass::RequestInformation(request, inputVector, outputVector);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_UNSIGNED_CHAR, 1);
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+void vtkImageDistanceMorphology::ExecuteDataWithInformation(
+  vtkDataObject *outputDataObject, vtkInformation* vtkNotUsed(outputInfo))
+{
+  vtkImageData *input = vtkImageData::SafeDownCast(this->GetInput());
+  vtkImageData *output = vtkImageData::SafeDownCast(outputDataObject);
+  if (!input || !output)
+    {
+    vtkErrorMacro("ExecuteDataWithInformation: Invalid input or output");
+    return;
+    }
+
+  vtkNew<vtkTimerLog> logger;
+  logger->StartTimer();
+
+  int* extent = input->GetExtent();
+  output->SetExtent(extent);
+  output->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return;
+    }
+  memset(output->GetScalarPointerForExtent(extent), 0,
+    static_cast<size_t>(output->GetNumberOfPoints()) * sizeof(unsigned char));
+
+  int foregroundExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool foregroundFound = false;
+  switch (input->GetScalarType())
+    {
+    vtkTemplateMacro(foregroundFound = GetForegroundExtent<VTK_TT>(input, foregroundExtent));
+    default:
+      vtkErrorMacro("ExecuteDataWithInformation: Unknown scalar type");
+      return;
+    }
+  if (!foregroundFound)
+    {
+    // Empty input, all operations result in empty output
+    return;
+    }
+
+  // Limit processing to the region that the operation may modify, with one voxel of background around it
+  // so that shrinking is not limited by the region boundary.
+  Region region;
+  double* spacing = input->GetSpacing();
+  bool growing = (this->Operation == OperationGrow || this->Operation == OperationClosing);
+  int regionExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    region.Spacing[axis] = fabs(spacing[axis]) > 0 ? fabs(spacing[axis]) : 1.0;
+    int padding = 1;
+    if (growing)
+      {
+      padding += static_cast<int>(ceil(this->Distance / region.Spacing[axis]));
+      }
+    regionExtent[axis * 2] = std::max(extent[axis * 2], foregroundExtent[axis * 2] - padding);
+    regionExtent[axis * 2 + 1] = std::min(extent[axis * 2 + 1], foregroundExtent[axis * 2 + 1] + padding);
+    region.Dimensions[axis] = regionExtent[axis * 2 + 1] - regionExtent[axis * 2] + 1;
+    }
+  region.Mask.resize(static_cast<size_t>(region.Dimensions[0]) * region.Dimensions[1] * region.Dimensions[2]);
+  switch (input->GetScalarType())
+    {
+    vtkTemplateMacro(GetMask<VTK_TT>(input, regionExtent, region));
+    }
+
+  int numberOfThreads = (this->NumberOfThreads > 0 ? this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  switch (this->Operation)
+    {
+    case OperationGrow:
+      Grow(region, this->Distance, numberOfThreads);
+      break;
+    case OperationShrink:
+      Shrink(region, this->Distance, numberOfThreads);
+      break;
+    case OperationOpening:
+      Shrink(region, this->Distance, numberOfThreads);
+      Grow(region, this->Distance, numberOfThreads);
+      break;
+    case OperationClosing:
+      Grow(region, this->Distance, numberOfThreads);
+      Shrink(region, this->Distance, numberOfThreads);
+      break;
+    }
+
+  unsigned char* mask = &region.Mask[0];
+  for (int k = regionExtent[4]; k <= regionExtent[5]; ++k)
+    {
+    for (int j = regionExtent[2]; j <= regionExtent[3]; ++j)
+      {
+      unsigned char* outputVoxel = static_cast<unsigned char*>(output->GetScalarPointer(regionExtent[0], j, k));
+      memcpy(outputVoxel, mask, region.Dimensions[0]);
+      mask += region.Dimensions[0];
+      }
+    }
+
+  logger->StopTimer();
+  vtkDebugMacro(<< "vtkImageDistanceMorphology execution time: " << logger->GetElapsedTime());
+}
+
+//-----------------------------------------------------------------------------
+void vtkImageDistanceMorphology::PrintSelf(ostream &os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  const char* operationNames[] = { "Grow", "Shrink", "Opening", "Closing" };
+  os << indent << "Operation: " << operationNames[this->Operation] << "\n";
+  os << indent << "Distance: " << this->Distance << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
@@ -0,0 +1,87 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkImageDistanceMorphology_h
+#define __vtkImageDistanceMorphology_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+#include <vtkImageAlgorithm.h>
+
+/// \ingroup Segmentations
+/// \brief Grow, shrink, open, or close a binary labelmap by an exact physical distance
+/// \details All non-zero voxels of the input are considered foreground. The output is an
+///   unsigned char image with the same geometry as the input, containing 1 in foreground
+///   and 0 in background voxels.
+///
+///   A voxel is added by growing if its distance from the nearest foreground voxel is at most
+///   Distance, and removed by shrinking if its distance from the nearest background voxel is at
+///   most Distance. Distances are computed by a separable squared Euclidean distance transform
+///   (lower envelope of parabolas along each axis), so computation time does not depend on the
+///   distance, and anisotropic spacing is taken into account exactly. Processing is limited to
+///   the bounding box of the foreground padded by the distance.
+///
+///   Similarly to vtkImageDilateErode3D, voxels outside the image extent are ignored, i.e.,
+///   shrinking does not remove voxels along the edge of the image.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageDistanceMorphology : public vtkImageAlgorithm
+{
+public:
+  static vtkImageDistanceMorphology* New();
+  vtkTypeMacro(vtkImageDistanceMorphology, vtkImageAlgorithm);
+  void PrintSelf(ostream &os, vtkIndent indent);
+
+  enum
+    {
+    OperationGrow,
+    OperationShrink,
+    OperationOpening, ///< shrink then grow, removes extrusions smaller than the distance
+    OperationClosing  ///< grow then shrink, fills holes and gaps smaller than the distance
+    };
+
+  // Morphological operation. Default is OperationGrow.
+  vtkSetClampMacro(Operation, int, OperationGrow, OperationClosing);
+  vtkGetMacro(Operation, int);
+  void SetOperationToGrow() { this->SetOperation(OperationGrow); }
+  void SetOperationToShrink() { this->SetOperation(OperationShrink); }
+  void SetOperationToOpening() { this->SetOperation(OperationOpening); }
+  void SetOperationToClosing() { this->SetOperation(OperationClosing); }
+
+  // Margin (for grow and shrink) or kernel radius (for opening and closing)
+  // in physical units (same as image spacing). Default is 1.
+  vtkSetClampMacro(Distance, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(Distance, double);
+
+  // Number of threads used for computing the distance transform.
+  // If 0 (default) then the global default number of threads is used.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+protected:
+  vtkImageDistanceMorphology();
+  virtual ~vtkImageDistanceMorphology();
+
+  virtual void ExecuteDataWithInformation(vtkDataObject *outData, vtkInformation *outInfo);
+  virtual int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+
+  int Operation;
+  double Distance;
+  int NumberOfThreads;
+
+private:
+  vtkImageDistanceMorphology(const vtkImageDistanceMorphology&); // Not implemented
+  void operator=(const vtkImageDistanceMorphology&);             // Not implemented
+};
+
+#endif
@@ -1,11 +1,14 @@
 #include "vtkImageGrowCutSegment.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
 #include <vtkLoggingMacros.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
@@ -75,6 +78,253 @@ protected:
   long m_Index;
 };
 
+//----------------------------------------------------------------------------
+/// Monotone priority queue of voxel indices, keyed by non-negative distance.
+///
+/// Entries are stored in flat arrays, in buckets determined by the highest bit
+/// of the key that differs from the last extracted key. The bit patterns of
+/// non-negative floating-point numbers are ordered the same way as their values,
+/// therefore the distance bits are used as key directly. The extracted keys must
+/// never decrease, which is guaranteed by Dijkstra propagation with non-negative
+/// edge weights.
+///
+/// Decreasing the key of a voxel is done by pushing it again, outdated entries
+/// have to be skipped by the caller (their key is larger than the current distance).
+class RadixHeap
+{
+public:
+  RadixHeap()
+  : m_LastKey(0)
+  , m_Size(0)
+  {
+  }
+
+  void Clear()
+  {
+    for (int bucketIndex = 0; bucketIndex < NumberOfBuckets; bucketIndex++)
+      {
+      std::vector<Entry>().swap(m_Buckets[bucketIndex]);
+      }
+    m_LastKey = 0;
+    m_Size = 0;
+  }
+
+  inline bool IsEmpty() const { return m_Size == 0; }
+
+  inline void Push(DistancePixelType distance, long index)
+  {
+    Entry entry;
+    entry.Key = GetKey(distance);
+    entry.Index = index;
+    m_Buckets[GetBucketIndex(entry.Key)].push_back(entry);
+    m_Size++;
+  }
+
+  inline void Pop(DistancePixelType& distance, long& index)
+  {
+    if (m_Buckets[0].empty())
+      {
+      // Find the first non-empty bucket, its minimum is the new last key,
+      // and all its entries go to lower buckets.
+      int bucketIndex = 1;
+      while (m_Buckets[bucketIndex].empty())
+        {
+        bucketIndex++;
+        }
+      std::vector<Entry>& bucket = m_Buckets[bucketIndex];
+      vtkTypeUInt32 minimumKey = bucket[0].Key;
+      for (size_t i = 1; i < bucket.size(); i++)
+        {
+        if (bucket[i].Key < minimumKey)
+          {
+          minimumKey = bucket[i].Key;
+          }
+        }
+      m_LastKey = minimumKey;
+      for (size_t i = 0; i < bucket.size(); i++)
+        {
+        m_Buckets[GetBucketIndex(bucket[i].Key)].push_back(bucket[i]);
+        }
+      bucket.clear();
+      }
+    const Entry& entry = m_Buckets[0].back();
+    memcpy(&distance, &entry.Key, sizeof(distance));
+    index = entry.Index;
+    m_Buckets[0].pop_back();
+    m_Size--;
+  }
+
+protected:
+  struct Entry
+  {
+    vtkTypeUInt32 Key;
+    long Index;
+  };
+
+  static const int NumberOfBuckets = 33;
+
+  static inline vtkTypeUInt32 GetKey(DistancePixelType distance)
+  {
+    vtkTypeUInt32 key = 0;
+    memcpy(&key, &distance, sizeof(key));
+    return key;
+  }
+
+  /// Returns 0 if key equals the last key, otherwise the position of the
+  /// highest differing bit (1-32)
+  inline int GetBucketIndex(vtkTypeUInt32 key) const
+  {
+    vtkTypeUInt32 difference = key ^ m_LastKey;
+    int bucketIndex = 0;
+    if (difference >> 16) { difference >>= 16; bucketIndex += 16; }
+    if (difference >> 8) { difference >>= 8; bucketIndex += 8; }
+    if (difference >> 4) { difference >>= 4; bucketIndex += 4; }
+    if (difference >> 2) { difference >>= 2; bucketIndex += 2; }
+    if (difference >> 1) { difference >>= 1; bucketIndex += 1; }
+    return bucketIndex + static_cast<int>(difference);
+  }
+
+  std::vector<Entry> m_Buckets[NumberOfBuckets];
+  vtkTypeUInt32 m_LastKey;
+  size_t m_Size;
+};
+
+//----------------------------------------------------------------------------
+/// Operation that is run in parallel on ranges of z slices of the volume
+class SliceRangeFunctor
+{
+public:
+  virtual ~SliceRangeFunctor() {}
+  virtual void Execute(long zBegin, long zEnd, int threadId) = 0;
+  long DimZ;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE SliceRangeThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SliceRangeFunctor* functor = static_cast<SliceRangeFunctor*>(info->UserData);
+  long zBegin = functor->DimZ * info->ThreadID / info->NumberOfThreads;
+  long zEnd = functor->DimZ * (info->ThreadID + 1) / info->NumberOfThreads;
+  functor->Execute(zBegin, zEnd, info->ThreadID);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Split the volume to slabs of z slices and run the functor on them in parallel.
+/// Returns the number of threads used.
+int ParallelForSlices(SliceRangeFunctor& functor, long dimZ, int numberOfThreads)
+{
+  functor.DimZ = dimZ;
+  if (numberOfThreads > dimZ)
+    {
+    numberOfThreads = static_cast<int>(dimZ);
+    }
+  if (numberOfThreads <= 1)
+    {
+    functor.Execute(0, dimZ, 0);
+    return 1;
+    }
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(SliceRangeThreadFunction, &functor);
+  threader->SingleMethodExecute();
+  return numberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+/// Set number of neighbors: all neighbors inside the volume, 0 on the boundary
+class NeighborCountFunctor : public SliceRangeFunctor
+{
+public:
+  virtual void Execute(long zBegin, long zEnd, int vtkNotUsed(threadId))
+  {
+    for (long z = zBegin; z < zEnd; z++)
+      {
+      bool zEdge = (z == 0 || z == DimZ - 1);
+      unsigned char* nbSizePtr = NumberOfNeighbors + z * DimX * DimY;
+      for (long y = 0; y < DimY; y++)
+        {
+        bool yEdge = (y == 0 || y == DimY - 1);
+        *(nbSizePtr++) = 0; // x == 0
+        unsigned char nbSize = (zEdge || yEdge) ? 0 : NeighborhoodSize;
+        for (long x = DimX - 2; x > 0; x--)
+          {
+          *(nbSizePtr++) = nbSize;
+          }
+        *(nbSizePtr++) = 0; // x == DimX-1
+        }
+      }
+  }
+  unsigned char* NumberOfNeighbors;
+  unsigned char NeighborhoodSize;
+  long DimX;
+  long DimY;
+};
+
+//----------------------------------------------------------------------------
+/// Initialize distance and label volumes from the seeds and collect
+/// the voxels that the propagation starts from.
+template<typename LabelPixelType>
+class SeedInitializationFunctor : public SliceRangeFunctor
+{
+public:
+  virtual void Execute(long zBegin, long zEnd, int threadId)
+  {
+    std::vector<long>& startIndices = StartIndices[threadId];
+    long sliceSize = DimX * DimY;
+    for (long index = zBegin * sliceSize; index < zEnd * sliceSize; index++)
+      {
+      LabelPixelType seedValue = SeedLabels[index];
+      if (seedValue == 0)
+        {
+        DistanceVolume[index] = DIST_INF;
+        ResultLabels[index] = 0;
+        }
+      else if (!Incremental || ResultLabels[index] != seedValue)
+        {
+        // In incremental mode only new/changed seeds are grown from
+        DistanceVolume[index] = DIST_EPSILON;
+        ResultLabels[index] = seedValue;
+        startIndices.push_back(index);
+        }
+      }
+  }
+  LabelPixelType* SeedLabels;
+  LabelPixelType* ResultLabels;
+  DistancePixelType* DistanceVolume;
+  std::vector< std::vector<long> > StartIndices;
+  bool Incremental;
+  long DimX;
+  long DimY;
+};
+
+//----------------------------------------------------------------------------
+/// Restore the previous result in voxels that the incremental update did not reach
+template<typename LabelPixelType>
+class RestoreUnreachedFunctor : public SliceRangeFunctor
+{
+public:
+  virtual void Execute(long zBegin, long zEnd, int vtkNotUsed(threadId))
+  {
+    long sliceSize = DimX * DimY;
+    for (long index = zBegin * sliceSize; index < zEnd * sliceSize; index++)
+      {
+      if (ResultLabels[index] == 0)
+        {
+        ResultLabels[index] = ResultLabelsPre[index];
+        DistanceVolume[index] = DistanceVolumePre[index];
+        }
+      }
+  }
+  LabelPixelType* ResultLabels;
+  LabelPixelType* ResultLabelsPre;
+  DistancePixelType* DistanceVolume;
+  DistancePixelType* DistanceVolumePre;
+  long DimX;
+  long DimY;
+};
+
 //----------------------------------------------------------------------------
 class vtkImageGrowCutSegment::vtkInternal
 {
@@ -90,6 +340,15 @@ public:
   template<typename IntensityPixelType, typename LabelPixelType>
   void DijkstraBasedClassificationAHP(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume);
 
+  template<typename LabelPixelType>
+  void AllocateBuffers(vtkImageData *seedLabelVolume);
+
+  template<typename LabelPixelType>
+  void InitializationRadixHeap(vtkImageData *seedLabelVolume);
+
+  template<typename IntensityPixelType, typename LabelPixelType>
+  void DijkstraBasedClassificationRadixHeap(vtkImageData *intensityVolume);
+
   template <class SourceVolType>
   bool ExecuteGrowCut(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *resultLabelVolume);
 
@@ -109,7 +368,11 @@ public:
 
   FibHeap *m_Heap;
   HeapNode *m_HeapNodes;
+  RadixHeap m_RadixHeap;
   bool m_bSegInitialized;
+
+  int m_QueueType;
+  int m_NumberOfThreads;
 };
 
 //-----------------------------------------------------------------------------
@@ -118,6 +381,8 @@ vtkImageGrowCutSegment::vtkInternal::vtkInternal()
   m_Heap = NULL;
   m_HeapNodes = NULL;
   m_bSegInitialized = false;
+  m_QueueType = vtkImageGrowCutSegment::QueueRadixHeap;
+  m_NumberOfThreads = 1;
   m_DistanceVolume = vtkSmartPointer<vtkImageData>::New();
   m_DistanceVolumePre = vtkSmartPointer<vtkImageData>::New();
   m_ResultLabelVolume = vtkSmartPointer<vtkImageData>::New();
@@ -143,6 +408,7 @@ void vtkImageGrowCutSegment::vtkInternal::Reset()
     delete[]m_HeapNodes;
     m_HeapNodes = NULL;
     }
+  m_RadixHeap.Clear();
   m_bSegInitialized = false;
   m_DistanceVolume->Initialize();
   m_DistanceVolumePre->Initialize();
@@ -167,66 +433,10 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
 
   if (!m_bSegInitialized)
     {
-    m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
-    m_ResultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
-    m_ResultLabelVolume->SetExtent(seedLabelVolume->GetExtent());
-    m_ResultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
-    m_DistanceVolume->SetOrigin(seedLabelVolume->GetOrigin());
-    m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
-    m_DistanceVolume->SetExtent(seedLabelVolume->GetExtent());
-    m_DistanceVolume->AllocateScalars(DistancePixelTypeID, 1);
-    m_ResultLabelVolumePre->SetExtent(0, -1, 0, -1, 0, -1);
-    m_ResultLabelVolumePre->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
-    m_DistanceVolumePre->SetExtent(0, -1, 0, -1, 0, -1);
-    m_DistanceVolumePre->AllocateScalars(DistancePixelTypeID, 1);
+    this->AllocateBuffers<LabelPixelType>(seedLabelVolume);
     LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
     DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
 
-    // Compute index offset
-    m_NeighborIndexOffsets.clear();
-    // Neighbors are traversed in the order of m_NeighborIndexOffsets,
-    // therefore one would expect that the offsets should
-    // be as continuous as possible (e.g., x coordinate
-    // should change most quickly), but that resulted in
-    // about 5-6% longer computation time. Therefore,
-    // we put indices in order x1y1z1, x1y1z2, x1y1z3, etc.
-    for (int ix = -1; ix <= 1; ix++)
-      {
-      for (int iy = -1; iy <= 1; iy++)
-        {
-        for (int iz = -1; iz <= 1; iz++)
-          {
-          if (ix == 0 && iy == 0 && iz == 0)
-            {
-            continue;
-            }
-          m_NeighborIndexOffsets.push_back(long(ix) + m_DimX*(long(iy) + m_DimY*long(iz)));
-          }
-        }
-      }
-
-    // Determine neighborhood size for computation at each voxel.
-    // The neighborhood size is everwhere the same (size of m_NeighborIndexOffsets)
-    // except at the edges of the volume, where the neighborhood size is 0.
-    m_NumberOfNeighbors.resize(dimXYZ);
-    const unsigned char numberOfNeighbors = m_NeighborIndexOffsets.size();
-    unsigned char* nbSizePtr = &(m_NumberOfNeighbors[0]);
-    for (int z = 0; z < m_DimZ; z++)
-      {
-      bool zEdge = (z == 0 || z == m_DimZ - 1);
-      for (int y = 0; y < m_DimY; y++)
-        {
-        bool yEdge = (y == 0 || y == m_DimY - 1);
-        *(nbSizePtr++) = 0; // x == 0 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>0)
-        unsigned char nbSize = (zEdge || yEdge) ? 0 : numberOfNeighbors;
-        for (int x = m_DimX-2; x > 0; x--)
-          {
-          *(nbSizePtr++) = nbSize;
-          }
-        *(nbSizePtr++) = 0; // x == m_DimX-1 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>1)
-        }
-      }
-
     for (long index = 0; index < dimXYZ; index++)
       {
       LabelPixelType seedValue = seedLabelVolumePtr[index];
@@ -411,6 +621,165 @@ void vtkImageGrowCutSegment::vtkInternal::DijkstraBasedClassificationAHP(
     }
 }
 
+//-----------------------------------------------------------------------------
+template<typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::AllocateBuffers(vtkImageData *seedLabelVolume)
+{
+  m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
+  m_ResultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
+  m_ResultLabelVolume->SetExtent(seedLabelVolume->GetExtent());
+  m_ResultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
+  m_DistanceVolume->SetOrigin(seedLabelVolume->GetOrigin());
+  m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
+  m_DistanceVolume->SetExtent(seedLabelVolume->GetExtent());
+  m_DistanceVolume->AllocateScalars(DistancePixelTypeID, 1);
+  m_ResultLabelVolumePre->SetExtent(0, -1, 0, -1, 0, -1);
+  m_ResultLabelVolumePre->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
+  m_DistanceVolumePre->SetExtent(0, -1, 0, -1, 0, -1);
+  m_DistanceVolumePre->AllocateScalars(DistancePixelTypeID, 1);
+
+  // Compute index offset
+  m_NeighborIndexOffsets.clear();
+  // Neighbors are traversed in the order of m_NeighborIndexOffsets,
+  // therefore one would expect that the offsets should
+  // be as continuous as possible (e.g., x coordinate
+  // should change most quickly), but that resulted in
+  // about 5-6% longer computation time. Therefore,
+  // we put indices in order x1y1z1, x1y1z2, x1y1z3, etc.
+  for (int ix = -1; ix <= 1; ix++)
+    {
+    for (int iy = -1; iy <= 1; iy++)
+      {
+      for (int iz = -1; iz <= 1; iz++)
+        {
+        if (ix == 0 && iy == 0 && iz == 0)
+          {
+          continue;
+          }
+        m_NeighborIndexOffsets.push_back(long(ix) + m_DimX*(long(iy) + m_DimY*long(iz)));
+        }
+      }
+    }
+
+  // Determine neighborhood size for computation at each voxel.
+  // The neighborhood size is everwhere the same (size of m_NeighborIndexOffsets)
+  // except at the edges of the volume, where the neighborhood size is 0.
+  // There is always padding, so we don't need to check if m_DimX>1.
+  m_NumberOfNeighbors.resize(m_DimX * m_DimY * m_DimZ);
+  NeighborCountFunctor neighborCounter;
+  neighborCounter.NumberOfNeighbors = &(m_NumberOfNeighbors[0]);
+  neighborCounter.NeighborhoodSize = static_cast<unsigned char>(m_NeighborIndexOffsets.size());
+  neighborCounter.DimX = m_DimX;
+  neighborCounter.DimY = m_DimY;
+  ParallelForSlices(neighborCounter, m_DimZ, m_NumberOfThreads);
+}
+
+//-----------------------------------------------------------------------------
+template<typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::InitializationRadixHeap(vtkImageData *seedLabelVolume)
+{
+  if (!m_bSegInitialized)
+    {
+    this->AllocateBuffers<LabelPixelType>(seedLabelVolume);
+    }
+
+  SeedInitializationFunctor<LabelPixelType> seedInitializer;
+  seedInitializer.SeedLabels = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer());
+  seedInitializer.ResultLabels = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  seedInitializer.DistanceVolume = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
+  seedInitializer.StartIndices.resize(std::max(m_NumberOfThreads, 1));
+  seedInitializer.Incremental = m_bSegInitialized;
+  seedInitializer.DimX = m_DimX;
+  seedInitializer.DimY = m_DimY;
+  int numberOfThreadsUsed = ParallelForSlices(seedInitializer, m_DimZ, m_NumberOfThreads);
+
+  // All start voxels have the same distance, push them in index order
+  m_RadixHeap.Clear();
+  for (int threadId = 0; threadId < numberOfThreadsUsed; threadId++)
+    {
+    const std::vector<long>& startIndices = seedInitializer.StartIndices[threadId];
+    for (std::vector<long>::const_iterator indexIt = startIndices.begin(); indexIt != startIndices.end(); ++indexIt)
+      {
+      m_RadixHeap.Push(DIST_EPSILON, *indexIt);
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+template<typename IntensityPixelType, typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::DijkstraBasedClassificationRadixHeap(vtkImageData *intensityVolume)
+{
+  IntensityPixelType* imSrc = static_cast<IntensityPixelType*>(intensityVolume->GetScalarPointer());
+  LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
+  LabelPixelType* resultLabelVolumePrePtr = NULL;
+  DistancePixelType* distanceVolumePrePtr = NULL;
+  if (m_bSegInitialized)
+    {
+    resultLabelVolumePrePtr = static_cast<LabelPixelType*>(m_ResultLabelVolumePre->GetScalarPointer());
+    distanceVolumePrePtr = static_cast<DistancePixelType*>(m_DistanceVolumePre->GetScalarPointer());
+    }
+
+  const long* neighborIndexOffsets = &(m_NeighborIndexOffsets[0]);
+  const unsigned char* numberOfNeighbors = &(m_NumberOfNeighbors[0]);
+  while (!m_RadixHeap.IsEmpty())
+    {
+    DistancePixelType currentDistance = 0;
+    long index = 0;
+    m_RadixHeap.Pop(currentDistance, index);
+    if (currentDistance != distanceVolumePtr[index])
+      {
+      // Distance of the voxel has been decreased since it was queued
+      continue;
+      }
+
+    // Quick update: stop propagation when the new distance is larger than the previous one
+    if (distanceVolumePrePtr && currentDistance > distanceVolumePrePtr[index])
+      {
+      distanceVolumePtr[index] = distanceVolumePrePtr[index];
+      resultLabelVolumePtr[index] = resultLabelVolumePrePtr[index];
+      continue;
+      }
+
+    // Update neighbors
+    LabelPixelType currentLabel = resultLabelVolumePtr[index];
+    DistancePixelType pixCenter = imSrc[index];
+    unsigned char nbSize = numberOfNeighbors[index];
+    for (unsigned char i = 0; i < nbSize; i++)
+      {
+      long indexNgbh = index + neighborIndexOffsets[i];
+      DistancePixelType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance;
+      if (distanceVolumePtr[indexNgbh] > neighborNewDistance)
+        {
+        distanceVolumePtr[indexNgbh] = neighborNewDistance;
+        resultLabelVolumePtr[indexNgbh] = currentLabel;
+        m_RadixHeap.Push(neighborNewDistance, indexNgbh);
+        }
+      }
+    }
+
+  if (m_bSegInitialized)
+    {
+    // Voxels that the update did not reach keep their previous result
+    RestoreUnreachedFunctor<LabelPixelType> restorer;
+    restorer.ResultLabels = resultLabelVolumePtr;
+    restorer.ResultLabelsPre = resultLabelVolumePrePtr;
+    restorer.DistanceVolume = distanceVolumePtr;
+    restorer.DistanceVolumePre = distanceVolumePrePtr;
+    restorer.DimX = m_DimX;
+    restorer.DimY = m_DimY;
+    ParallelForSlices(restorer, m_DimZ, m_NumberOfThreads);
+    }
+
+  // Update previous labels and distance information
+  m_ResultLabelVolumePre->DeepCopy(m_ResultLabelVolume);
+  m_DistanceVolumePre->DeepCopy(m_DistanceVolume);
+  m_bSegInitialized = true;
+
+  // Release memory
+  m_RadixHeap.Clear();
+}
+
 //-----------------------------------------------------------------------------
 template< class IntensityPixelType, class LabelPixelType>
 bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume)
@@ -427,6 +796,13 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensit
     return false;
     }
 
+  if (m_QueueType == vtkImageGrowCutSegment::QueueRadixHeap)
+    {
+    InitializationRadixHeap<LabelPixelType>(seedLabelVolume);
+    DijkstraBasedClassificationRadixHeap<IntensityPixelType, LabelPixelType>(intensityVolume);
+    return true;
+    }
+
   if (!InitializationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume))
     {
     return false;
@@ -507,6 +883,8 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensity
 vtkImageGrowCutSegment::vtkImageGrowCutSegment()
 {
   this->Internal = new vtkInternal();
+  this->QueueType = QueueRadixHeap;
+  this->NumberOfThreads = 0;
   this->SetNumberOfInputPorts(2);
   this->SetNumberOfOutputPorts(1);
 }
@@ -528,6 +906,10 @@ void vtkImageGrowCutSegment::ExecuteDataWithInformation(
   vtkNew<vtkTimerLog> logger;
   logger->StartTimer();
 
+  this->Internal->m_QueueType = this->QueueType;
+  this->Internal->m_NumberOfThreads = (this->NumberOfThreads > 0 ?
+    this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+
   switch (intensityVolume->GetScalarType())
     {
     vtkTemplateMacro(this->Internal->ExecuteGrowCut<VTK_TT>(intensityVolume, seedLabelVolume, resultLabelVolume));
@@ -563,4 +945,6 @@ void vtkImageGrowCutSegment::PrintSelf(ostream &os, vtkIndent indent)
 {
   // XXX Implement this function
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "QueueType: " << (this->QueueType == QueueRadixHeap ? "RadixHeap" : "FibonacciHeap") << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 }
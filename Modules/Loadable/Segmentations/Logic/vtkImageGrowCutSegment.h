@@ -19,6 +19,25 @@ public:
   // Set input seed label volume (input 1)
   void SetSeedLabelVolume(vtkImageData* labelImage) { this->SetInputData(1, labelImage); }
 
+  enum
+    {
+    QueueFibonacciHeap,
+    QueueRadixHeap
+    };
+
+  // Priority queue used for propagating the seeds.
+  // QueueRadixHeap (default) keeps the queue, distances, and labels in flat arrays.
+  // QueueFibonacciHeap allocates a heap node for each voxel, it needs more time and memory
+  // and is only kept for comparison. Both give the same result (except where a voxel is
+  // at exactly the same distance from multiple labels).
+  vtkSetClampMacro(QueueType, int, QueueFibonacciHeap, QueueRadixHeap);
+  vtkGetMacro(QueueType, int);
+
+  // Number of threads used for initialization and finalization of the result.
+  // Seed propagation is sequential. If 0 (default) then the global default number of threads is used.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
   // Reset to initial state. This forces full recomputation of the result label volume.
   // This method has to be called if intensity volume changes or if seeds are deleted after initial computation.
   void Reset();
@@ -30,6 +49,9 @@ protected:
   virtual void ExecuteDataWithInformation(vtkDataObject *outData, vtkInformation *outInfo);
   virtual int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
 
+  int QueueType;
+  int NumberOfThreads;
+
 private:
   class vtkInternal;
   vtkInternal * Internal;
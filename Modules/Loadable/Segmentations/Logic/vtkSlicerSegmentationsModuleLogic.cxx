@@ -68,6 +68,7 @@
 #include <vtkMRMLTransformNode.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 
 //----------------------------------------------------------------------------
@@ -725,8 +726,14 @@ bool vtkSlicerSegmentationsModuleLogic::ExportSegmentToRepresentationNode(vtkSeg
       }
 
     // Export binary labelmap representation into labelmap volume node
-    vtkOrientedImageData* orientedImageData = vtkOrientedImageData::SafeDownCast(
+    vtkSmartPointer<vtkOrientedImageData> orientedImageData = vtkOrientedImageData::SafeDownCast(
       segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+    if (segment->GetSharedLabelmap())
+      {
+      // The shared labelmap contains other segments as well
+      orientedImageData = vtkSmartPointer<vtkOrientedImageData>::New();
+      segment->ExtractBinaryLabelmapRepresentation(orientedImageData);
+      }
     bool success = vtkSlicerSegmentationsModuleLogic::CreateLabelmapVolumeFromOrientedImageData(orientedImageData, labelmapNode);
     if (!success)
       {
@@ -1422,7 +1429,21 @@ bool vtkSlicerSegmentationsModuleLogic::GetSegmentRepresentation(vtkMRMLSegmenta
       vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::GetSegmentRepresentation: Unable to get '" << representationName << "' representation from segment with ID " << segmentID << " in segmentation " << segmentationNode->GetName());
       return false;
       }
-    segmentRepresentation->DeepCopy(representationObject);
+    if (representationObject == segment->GetSharedLabelmap())
+      {
+      // The shared labelmap contains other segments as well, only copy voxels of this segment
+      vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast(segmentRepresentation);
+      if (!segmentLabelmap)
+        {
+        vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::GetSegmentRepresentation: Output must be an oriented image data for segment with ID " << segmentID << " in segmentation " << segmentationNode->GetName());
+        return false;
+        }
+      segment->ExtractBinaryLabelmapRepresentation(segmentLabelmap);
+      }
+    else
+      {
+      segmentRepresentation->DeepCopy(representationObject);
+      }
     }
   else // Need to convert
     {
@@ -1523,6 +1544,15 @@ bool vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(vtkOrientedIm
     vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment: Failed to get binary labelmap representation in segmentation " << segmentationNode->GetName());
     return false;
     }
+  vtkSmartPointer<vtkOrientedImageData> extractedSegmentLabelmap;
+  if (selectedSegment->GetSharedLabelmap())
+    {
+    // Voxels of the other segments in the shared labelmap must not be overwritten, therefore the segment
+    // is edited in a separate labelmap, which then replaces the shared labelmap in the segment.
+    extractedSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    selectedSegment->ExtractBinaryLabelmapRepresentation(extractedSegmentLabelmap);
+    segmentLabelmap = extractedSegmentLabelmap;
+    }
 
   // 1. Append input labelmap to the segment labelmap if requested
   vtkSmartPointer<vtkOrientedImageData> newSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
@@ -1532,6 +1562,25 @@ bool vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(vtkOrientedIm
   bool segmentLabelmapEmpty = (segmentLabelmapExtent[0] > segmentLabelmapExtent[1] ||
     segmentLabelmapExtent[2] > segmentLabelmapExtent[3] ||
     segmentLabelmapExtent[4] > segmentLabelmapExtent[5]);
+
+  // Voxels can only change within the modifier extent, and in replace mode within the current segment extent.
+  // It is recorded in the segment labelmap so that representations can be updated in that region only.
+  vtkMTimeType previousSegmentLabelmapTime = segmentLabelmap->GetMTime();
+  bool modifiedExtentKnown = (extent != NULL && vtkOrientedImageDataResample::DoGeometriesMatch(segmentLabelmap, labelmap));
+  int modifiedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (modifiedExtentKnown)
+    {
+    for (int i = 0; i < 3; i++)
+      {
+      modifiedExtent[i * 2] = extent[i * 2];
+      modifiedExtent[i * 2 + 1] = extent[i * 2 + 1];
+      if (mergeMode == MODE_REPLACE && !segmentLabelmapEmpty)
+        {
+        modifiedExtent[i * 2] = std::min(modifiedExtent[i * 2], segmentLabelmapExtent[i * 2]);
+        modifiedExtent[i * 2 + 1] = std::max(modifiedExtent[i * 2 + 1], segmentLabelmapExtent[i * 2 + 1]);
+        }
+      }
+    }
   if (segmentLabelmapEmpty)
     {
     if (mergeMode == MODE_MERGE_MIN)
@@ -1606,6 +1655,15 @@ bool vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(vtkOrientedIm
     padder->Update();
     segmentLabelmap->DeepCopy(padder->GetOutput());
     }
+  if (extractedSegmentLabelmap)
+    {
+    // The segment stops using the shared labelmap, its voxels are removed from the shared labelmap
+    selectedSegment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), segmentLabelmap);
+    }
+  if (modifiedExtentKnown)
+    {
+    vtkSegmentationConverter::SetModifiedExtent(segmentLabelmap, previousSegmentLabelmapTime, modifiedExtent);
+    }
   // 4. Re-convert all other representations
   std::vector<std::string> representationNames;
   selectedSegment->GetContainedRepresentationNames(representationNames);
@@ -1629,3 +1687,58 @@ bool vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(vtkOrientedIm
 
   return true;
 }
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSharedSegment(vtkOrientedImageData* labelmap, vtkMRMLSegmentationNode* segmentationNode,
+  std::string segmentID, int mergeMode, const int extent[6], std::vector<std::string>& modifiedSegmentIDs)
+{
+  modifiedSegmentIDs.clear();
+  if (!segmentationNode || segmentID.empty() || !labelmap)
+    {
+    vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSharedSegment: Invalid inputs");
+    return false;
+    }
+  if (mergeMode != MODE_REPLACE && mergeMode != MODE_MERGE_MAX)
+    {
+    // Removing voxels from a segment would leave them unassigned, which is not faster than the generic method
+    return false;
+    }
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  if (!segmentation->GetSegment(segmentID) || !segmentation->GetSegment(segmentID)->GetSharedLabelmap())
+    {
+    return false;
+    }
+
+  // Disable modified event so that the other representations in all segments are not removed,
+  // representations of the modified segments are re-converted instead
+  bool wasMasterRepresentationModifiedEnabled = segmentation->SetMasterRepresentationModifiedEnabled(false);
+  if (!segmentation->SetBinaryLabelmapToSharedSegment(segmentID, labelmap, mergeMode == MODE_REPLACE, extent, modifiedSegmentIDs))
+    {
+    segmentation->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+    return false;
+    }
+
+  for (std::vector<std::string>::iterator segmentIdIt = modifiedSegmentIDs.begin(); segmentIdIt != modifiedSegmentIDs.end(); ++segmentIdIt)
+    {
+    std::vector<std::string> representationNames;
+    segmentation->GetSegment(*segmentIdIt)->GetContainedRepresentationNames(representationNames);
+    for (std::vector<std::string>::iterator reprIt = representationNames.begin(); reprIt != representationNames.end(); ++reprIt)
+      {
+      if (reprIt->compare(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+        {
+        segmentation->ConvertSingleSegment(*segmentIdIt, *reprIt);
+        }
+      }
+    }
+
+  // Re-enable master representation modified event
+  segmentation->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+  for (std::vector<std::string>::iterator segmentIdIt = modifiedSegmentIDs.begin(); segmentIdIt != modifiedSegmentIDs.end(); ++segmentIdIt)
+    {
+    const char* segmentIdChar = segmentIdIt->c_str();
+    segmentation->InvokeEvent(vtkSegmentation::MasterRepresentationModified, (void*)segmentIdChar);
+    segmentation->InvokeEvent(vtkSegmentation::RepresentationModified, (void*)segmentIdChar);
+    }
+
+  return true;
+}
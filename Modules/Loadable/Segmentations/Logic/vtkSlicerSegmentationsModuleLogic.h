@@ -262,6 +262,18 @@ public:
     };
   static bool SetBinaryLabelmapToSegment(vtkOrientedImageData* labelmap, vtkMRMLSegmentationNode* segmentationNode, std::string segmentID, int mergeMode=MODE_REPLACE, const int extent[6]=0);
 
+#ifndef __VTK_WRAP__
+  /// Set a labelmap image into a segment that is stored in a shared labelmap (\sa vtkSegmentation::CollapseBinaryLabelmaps)
+  /// by a single write into the shared labelmap. Voxels set in the segment are removed from all the other segments that
+  /// share the same labelmap. Representations of all the modified segments are re-converted and events are invoked for each.
+  /// Only MODE_REPLACE and MODE_MERGE_MAX are supported.
+  /// \param modifiedSegmentIDs IDs of segments that changed, including segmentID
+  /// \return False if the segment does not use a shared labelmap or the labelmap cannot be written into it directly,
+  ///   in that case the segmentation is not modified.
+  static bool SetBinaryLabelmapToSharedSegment(vtkOrientedImageData* labelmap, vtkMRMLSegmentationNode* segmentationNode,
+    std::string segmentID, int mergeMode, const int extent[6], std::vector<std::string>& modifiedSegmentIDs);
+#endif // __VTK_WRAP__
+
 protected:
   virtual void SetMRMLSceneInternal(vtkMRMLScene * newScene);
 
@@ -177,6 +177,7 @@ public:
       this->LookupTableOutline = vtkSmartPointer<vtkLookupTable>::New();
       this->LookupTableFill = vtkSmartPointer<vtkLookupTable>::New();
       this->ImageThreshold = vtkSmartPointer<vtkImageThreshold>::New();
+      this->SharedLabelThreshold = vtkSmartPointer<vtkImageThreshold>::New();
 
       // Set up image pipeline
       this->Reslice->SetBackgroundColor(0.0, 0.0, 0.0, 0.0);
@@ -204,6 +205,12 @@ public:
       this->ImageThreshold->SetOutValue(1);
       this->ImageThreshold->SetInValue(0);
 
+      // Select voxels of the segment if it is stored in a shared labelmap
+      this->SharedLabelThreshold->SetInputConnection(this->Reslice->GetOutputPort());
+      this->SharedLabelThreshold->SetInValue(1);
+      this->SharedLabelThreshold->SetOutValue(0);
+      this->SharedLabelThreshold->SetOutputScalarTypeToUnsignedChar();
+
       // Image outline
       this->LabelOutline->SetInputConnection(this->Reslice->GetOutputPort());
       vtkSmartPointer<vtkImageMapToRGBA> outlineColorMapper = vtkSmartPointer<vtkImageMapToRGBA>::New();
@@ -251,6 +258,7 @@ public:
     vtkSmartPointer<vtkLookupTable> LookupTableOutline;
     vtkSmartPointer<vtkLookupTable> LookupTableFill;
     vtkSmartPointer<vtkImageThreshold> ImageThreshold;
+    vtkSmartPointer<vtkImageThreshold> SharedLabelThreshold;
       };
 
   typedef std::map<std::string, const Pipeline*> PipelineMapType; // first: segment ID; second: display pipeline
@@ -920,9 +928,21 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
         pipeline->ImageThreshold->ThresholdByLower(thresholdValue->GetValue(0));
         }
 
+      // The shared labelmap contains other segments as well, only voxels of this segment are shown
+      vtkSegment* segment = segmentation->GetSegment(pipelineIt->first);
+      bool sharedLabelmap = (segment && imageData == segment->GetSharedLabelmap());
+      if (sharedLabelmap)
+        {
+        pipeline->SharedLabelThreshold->ThresholdBetween(segment->GetSharedLabelValue(), segment->GetSharedLabelValue());
+        }
+
       // Smooth the border of fractional labelmaps
       pipeline->ImageFillActor->GetMapper()->GetInputAlgorithm()->SetInputConnection(pipeline->Reslice->GetOutputPort());
-      if (this->SmoothFractionalLabelMapBorder && thresholdValue && thresholdValue->GetNumberOfValues() == 1)
+      if (sharedLabelmap)
+        {
+        pipeline->ImageFillActor->GetMapper()->GetInputAlgorithm()->SetInputConnection(pipeline->SharedLabelThreshold->GetOutputPort());
+        }
+      else if (this->SmoothFractionalLabelMapBorder && thresholdValue && thresholdValue->GetNumberOfValues() == 1)
         {
           pipeline->ImageFillActor->GetMapper()->GetInputAlgorithm()->SetInputConnection(pipeline->ImageThreshold->GetOutputPort());
         }
@@ -933,7 +953,11 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
         pipeline->LabelOutline->SetInputConnection(pipeline->Reslice->GetOutputPort());
 
         // Set the outline threshold from the ThresholdValue field if it exists
-        if (thresholdValue && thresholdValue->GetNumberOfValues() == 1)
+        if (sharedLabelmap)
+          {
+          pipeline->LabelOutline->SetInputConnection(pipeline->SharedLabelThreshold->GetOutputPort());
+          }
+        else if (thresholdValue && thresholdValue->GetNumberOfValues() == 1)
           {
           pipeline->LabelOutline->SetInputConnection(pipeline->ImageThreshold->GetOutputPort());
           }
@@ -1387,6 +1411,17 @@ std::string vtkMRMLSegmentationsDisplayableManager2D::GetDataProbeInfoStringForP
         double voxelValue = imageData->GetScalarComponentAsDouble(
           ijk[0], ijk[1], ijk[2], 0);
 
+        vtkSegment* segment = segmentation->GetSegment(pipelineIt->first);
+        if (segment && imageData == segment->GetSharedLabelmap())
+          {
+          // The shared labelmap contains other segments as well
+          if (voxelValue == segment->GetSharedLabelValue())
+            {
+            segmentIDsAtPosition.insert(pipelineIt->first);
+            }
+          continue;
+          }
+
         vtkDoubleArray* scalarRange = vtkDoubleArray::SafeDownCast(
           imageData->GetFieldData()->GetAbstractArray(vtkSegmentationConverter::GetScalarRangeFieldName()));
 
@@ -0,0 +1,290 @@
+import unittest
+import vtk, qt, slicer
+import logging
+import math
+
+import vtkSegmentationCorePython as vtkSegmentationCore
+from vtk.util import numpy_support
+
+class SegmentEditorModifySegmentTest1(unittest.TestCase):
+  def setUp(self):
+    """ Do whatever is needed to reset the state - typically a scene clear will be enough.
+    """
+    slicer.mrmlScene.Clear(0)
+
+  def runTest(self):
+    """Run as few or as many tests as needed here.
+    """
+    self.setUp()
+    self.test_SegmentEditorModifySegmentTest1()
+
+  #------------------------------------------------------------------------------
+  def test_SegmentEditorModifySegmentTest1(self):
+    # Check for modules
+    self.assertIsNotNone( slicer.modules.segmentations )
+
+    self.TestSection_00_SetupSegmentEditor()
+    self.TestSection_01_SetModeMasksOutsideExtent()
+    self.TestSection_02_PaintOutsideSegmentation()
+    self.TestSection_03_SetupAnisotropicVolume()
+    self.TestSection_04_BrushCenterNotSnapped()
+    self.TestSection_05_SphereBrushMatchesStencil()
+    self.TestSection_06_SweptBrush()
+
+    logging.info('Test finished')
+
+  #------------------------------------------------------------------------------
+  def TestSection_00_SetupSegmentEditor(self):
+    imageData = vtk.vtkImageData()
+    imageData.SetDimensions(20, 20, 20)
+    imageData.AllocateScalars(vtk.VTK_SHORT, 1)
+    imageData.GetPointData().GetScalars().Fill(0)
+    self.masterVolumeNode = slicer.vtkMRMLScalarVolumeNode()
+    self.masterVolumeNode.SetAndObserveImageData(imageData)
+    slicer.mrmlScene.AddNode(self.masterVolumeNode)
+
+    self.segmentationNode = slicer.vtkMRMLSegmentationNode()
+    slicer.mrmlScene.AddNode(self.segmentationNode)
+    self.segmentationNode.CreateDefaultDisplayNodes()
+    self.segmentationNode.SetReferenceImageGeometryParameterFromVolumeNode(self.masterVolumeNode)
+    self.segmentationNode.GetSegmentation().AddEmptySegment('blocker')
+    self.segmentationNode.GetSegmentation().AddEmptySegment('painted')
+
+    self.segmentEditorWidget = slicer.qMRMLSegmentEditorWidget()
+    self.segmentEditorWidget.setMRMLScene(slicer.mrmlScene)
+    self.segmentEditorNode = slicer.vtkMRMLSegmentEditorNode()
+    slicer.mrmlScene.AddNode(self.segmentEditorNode)
+    self.segmentEditorWidget.setMRMLSegmentEditorNode(self.segmentEditorNode)
+    self.segmentEditorWidget.setSegmentationNode(self.segmentationNode)
+    self.segmentEditorWidget.setMasterVolumeNode(self.masterVolumeNode)
+    self.segmentEditorWidget.setActiveEffectByName('Paint')
+    self.effect = self.segmentEditorWidget.activeEffect()
+    self.assertIsNotNone(self.effect)
+
+  #------------------------------------------------------------------------------
+  def modifierLabelmapFilledBelowX(self, maxX):
+    """Return the default modifier labelmap filled where the voxel index along X is below maxX"""
+    modifierLabelmap = self.effect.defaultModifierLabelmap()
+    dims = modifierLabelmap.GetDimensions()
+    voxels = numpy_support.vtk_to_numpy(modifierLabelmap.GetPointData().GetScalars()).reshape(dims[2], dims[1], dims[0])
+    voxels[:] = 0
+    voxels[:, :, :maxX - modifierLabelmap.GetExtent()[0]] = 1
+    modifierLabelmap.Modified()
+    return modifierLabelmap
+
+  #------------------------------------------------------------------------------
+  def segmentVoxel(self, segmentID, ijk):
+    labelmap = self.segmentationNode.GetBinaryLabelmapRepresentation(segmentID)
+    extent = labelmap.GetExtent()
+    for axis in range(3):
+      if ijk[axis] < extent[axis * 2] or ijk[axis] > extent[axis * 2 + 1]:
+        return 0
+    return int(labelmap.GetScalarComponentAsDouble(ijk[0], ijk[1], ijk[2], 0))
+
+  #------------------------------------------------------------------------------
+  def segmentVoxels(self, segmentID):
+    """Return the set of (i, j, k) indices of the voxels of the segment"""
+    labelmap = self.segmentationNode.GetBinaryLabelmapRepresentation(segmentID)
+    extent = labelmap.GetExtent()
+    if extent[0] > extent[1] or extent[2] > extent[3] or extent[4] > extent[5]:
+      return set()
+    dims = labelmap.GetDimensions()
+    voxels = numpy_support.vtk_to_numpy(labelmap.GetPointData().GetScalars()).reshape(dims[2], dims[1], dims[0])
+    return set((int(i) + extent[0], int(j) + extent[2], int(k) + extent[4]) for k, j, i in zip(*voxels.nonzero()))
+
+  #------------------------------------------------------------------------------
+  def voxelCenter(self, ijk):
+    """World position of the center of a voxel of the master volume"""
+    ijkToRas = vtk.vtkMatrix4x4()
+    self.masterVolumeNode.GetIJKToRASMatrix(ijkToRas)
+    return ijkToRas.MultiplyPoint([ijk[0], ijk[1], ijk[2], 1.0])[:3]
+
+  #------------------------------------------------------------------------------
+  def paintNewSegment(self, segmentName, brushPositions, viewWidget=None):
+    """Paint a stroke into a new segment and return the ID of the segment"""
+    segmentID = self.segmentationNode.GetSegmentation().AddEmptySegment(segmentName)
+    self.segmentEditorWidget.setCurrentSegmentID(segmentID)
+    points = vtk.vtkPoints()
+    for brushPosition in brushPositions:
+      points.InsertNextPoint(brushPosition)
+    self.effect.paintStroke(points, viewWidget)
+    return segmentID
+
+  #------------------------------------------------------------------------------
+  def stencilSphereVoxels(self, center, radius):
+    """Return the voxels painted by the previous brush rasterization: the sphere polydata
+    is converted to a stencil in the labelmap IJK coordinate system, then shifted to
+    the voxel nearest to the brush center."""
+    labelmap = self.effect.defaultModifierLabelmap()
+    sphere = vtk.vtkSphereSource()
+    sphere.SetRadius(radius)
+    sphere.SetPhiResolution(32)
+    sphere.SetThetaResolution(32)
+    worldToIjk = vtk.vtkMatrix4x4()
+    labelmap.GetWorldToImageMatrix(worldToIjk)
+    for i in range(3):
+      worldToIjk.SetElement(i, 3, 0)
+    worldOriginToIjk = vtk.vtkTransform()
+    worldOriginToIjk.Concatenate(worldToIjk)
+    transformer = vtk.vtkTransformPolyDataFilter()
+    transformer.SetTransform(worldOriginToIjk)
+    transformer.SetInputConnection(sphere.GetOutputPort())
+    transformer.Update()
+    bounds = transformer.GetOutput().GetBounds()
+    polyDataToStencil = vtk.vtkPolyDataToImageStencil()
+    polyDataToStencil.SetOutputSpacing(1.0, 1.0, 1.0)
+    polyDataToStencil.SetOutputWholeExtent(int(math.floor(bounds[0]))-1, int(math.ceil(bounds[1]))+1,
+      int(math.floor(bounds[2]))-1, int(math.ceil(bounds[3]))+1, int(math.floor(bounds[4]))-1, int(math.ceil(bounds[5]))+1)
+    polyDataToStencil.SetInputConnection(transformer.GetOutputPort())
+    stencilToImage = vtk.vtkImageStencilToImage()
+    stencilToImage.SetInputConnection(polyDataToStencil.GetOutputPort())
+    stencilToImage.SetInsideValue(1)
+    stencilToImage.SetOutsideValue(0)
+    stencilToImage.SetOutputScalarTypeToUnsignedChar()
+    stencilToImage.Update()
+    brush = stencilToImage.GetOutput()
+    worldToIjk = vtk.vtkMatrix4x4()
+    labelmap.GetWorldToImageMatrix(worldToIjk)
+    center_Ijk = worldToIjk.MultiplyPoint([center[0], center[1], center[2], 1.0])
+    shift = [int(center_Ijk[i] + 0.5) for i in range(3)]
+    extent = brush.GetExtent()
+    dims = brush.GetDimensions()
+    voxels = numpy_support.vtk_to_numpy(brush.GetPointData().GetScalars()).reshape(dims[2], dims[1], dims[0])
+    return set((int(i) + extent[0] + shift[0], int(j) + extent[2] + shift[1], int(k) + extent[4] + shift[2])
+      for k, j, i in zip(*voxels.nonzero()))
+
+  #------------------------------------------------------------------------------
+  def TestSection_01_SetModeMasksOutsideExtent(self):
+    logging.info('Test section 1: set mode masks the entire modifier labelmap')
+
+    self.segmentEditorNode.SetMaskMode(slicer.vtkMRMLSegmentEditorNode.PaintAllowedEverywhere)
+    self.segmentEditorWidget.setCurrentSegmentID('blocker')
+    self.effect.modifySelectedSegmentByLabelmap(self.modifierLabelmapFilledBelowX(10),
+      slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
+    self.assertEqual(self.segmentVoxel('blocker', [2, 2, 2]), 1)
+
+    # Fill the whole modifier labelmap but only declare a small modification extent.
+    # Voxels inside the blocker segment must not be painted, not even outside the extent.
+    self.segmentEditorNode.SetMaskMode(slicer.vtkMRMLSegmentEditorNode.PaintAllowedOutsideAllSegments)
+    self.segmentEditorWidget.setCurrentSegmentID('painted')
+    self.effect.modifySelectedSegmentByLabelmap(self.modifierLabelmapFilledBelowX(20),
+      slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet, [5, 14, 5, 14, 5, 14])
+    self.assertEqual(self.segmentVoxel('painted', [2, 2, 2]), 0)
+    self.assertEqual(self.segmentVoxel('painted', [7, 7, 7]), 0)
+    self.assertEqual(self.segmentVoxel('painted', [12, 7, 7]), 1)
+    self.assertEqual(self.segmentVoxel('blocker', [7, 7, 7]), 1)
+
+  #------------------------------------------------------------------------------
+  def TestSection_02_PaintOutsideSegmentation(self):
+    logging.info('Test section 2: painting outside the segmentation does not modify the segment')
+
+    self.segmentEditorNode.SetMaskMode(slicer.vtkMRMLSegmentEditorNode.PaintAllowedEverywhere)
+    self.segmentationNode.GetSegmentation().AddEmptySegment('brush')
+    self.segmentEditorWidget.setCurrentSegmentID('brush')
+    self.segmentEditorWidget.setUndoEnabled(True)
+    undoButton = slicer.util.findChild(self.segmentEditorWidget, 'UndoButton')
+    self.assertFalse(undoButton.enabled)
+
+    self.effect.setCommonParameter('BrushDiameterIsRelative', 0)
+    self.effect.setCommonParameter('BrushAbsoluteDiameter', 3.0)
+    brushLabelmap = self.segmentationNode.GetBinaryLabelmapRepresentation('brush')
+    labelmapModifiedTime = brushLabelmap.GetMTime()
+
+    # Brush extent is empty, neither the segment nor the undo history may change
+    self.effect.paintAt(qt.QVector3D(1000.0, 1000.0, 1000.0))
+    self.assertFalse(undoButton.enabled)
+    self.assertEqual(brushLabelmap.GetMTime(), labelmapModifiedTime)
+
+    self.effect.paintAt(qt.QVector3D(10.0, 10.0, 10.0))
+    self.assertTrue(undoButton.enabled)
+    self.assertEqual(self.segmentVoxel('brush', [10, 10, 10]), 1)
+    self.assertEqual(self.segmentVoxel('brush', [2, 2, 2]), 0)
+
+  #------------------------------------------------------------------------------
+  def TestSection_03_SetupAnisotropicVolume(self):
+    logging.info('Test section 3: anisotropic master volume')
+
+    imageData = vtk.vtkImageData()
+    imageData.SetDimensions(30, 24, 12)
+    imageData.AllocateScalars(vtk.VTK_SHORT, 1)
+    imageData.GetPointData().GetScalars().Fill(0)
+    self.masterVolumeNode = slicer.vtkMRMLScalarVolumeNode()
+    self.masterVolumeNode.SetSpacing(0.7, 1.0, 2.5)
+    self.masterVolumeNode.SetAndObserveImageData(imageData)
+    slicer.mrmlScene.AddNode(self.masterVolumeNode)
+
+    self.segmentationNode = slicer.vtkMRMLSegmentationNode()
+    slicer.mrmlScene.AddNode(self.segmentationNode)
+    self.segmentationNode.CreateDefaultDisplayNodes()
+    self.segmentationNode.SetReferenceImageGeometryParameterFromVolumeNode(self.masterVolumeNode)
+    self.segmentEditorWidget.setSegmentationNode(self.segmentationNode)
+    self.segmentEditorWidget.setMasterVolumeNode(self.masterVolumeNode)
+    self.segmentEditorNode.SetMaskMode(slicer.vtkMRMLSegmentEditorNode.PaintAllowedEverywhere)
+    self.effect.setCommonParameter('BrushDiameterIsRelative', 0)
+    self.effect.setCommonParameter('BrushSphere', 1)
+
+  #------------------------------------------------------------------------------
+  def TestSection_04_BrushCenterNotSnapped(self):
+    logging.info('Test section 4: brush centers are not snapped to voxel centers')
+
+    # Brush center is 0.4 voxel away from the center of voxel (10, 12, 6) along I.
+    # A brush snapped to that voxel would paint voxels 8 and 12 along I (both at 1.4mm);
+    # the exact brush reaches voxel 12 (1.12mm) but not voxel 8 (1.68mm).
+    self.effect.setCommonParameter('BrushAbsoluteDiameter', 2.8)
+    center = self.voxelCenter([10.4, 12, 6])
+    segmentID = self.paintNewSegment('not snapped', [center])
+    self.assertEqual(self.segmentVoxel(segmentID, [12, 12, 6]), 1)
+    self.assertEqual(self.segmentVoxel(segmentID, [8, 12, 6]), 0)
+    self.assertEqual(self.segmentVoxel(segmentID, [10, 12, 6]), 1)
+
+  #------------------------------------------------------------------------------
+  def TestSection_05_SphereBrushMatchesStencil(self):
+    logging.info('Test section 5: sphere brush matches the stencil rasterization of the sphere polydata')
+
+    # At a voxel center snapping has no effect, so the two rasterizations may only differ
+    # at the brush boundary: the polydata is inscribed in the sphere.
+    radius = 4.3
+    self.effect.setCommonParameter('BrushAbsoluteDiameter', radius * 2.0)
+    center = self.voxelCenter([15, 12, 6])
+    directVoxels = self.segmentVoxels(self.paintNewSegment('sphere', [center]))
+    stencilVoxels = self.stencilSphereVoxels(center, radius)
+    self.assertTrue(len(stencilVoxels) > 100)
+    self.assertTrue(stencilVoxels.issubset(directVoxels))
+    spacing = self.masterVolumeNode.GetSpacing()
+    for voxel in directVoxels - stencilVoxels:
+      offset = [(voxel[i] - [15, 12, 6][i]) * spacing[i] for i in range(3)]
+      distance = math.sqrt(sum(component * component for component in offset))
+      self.assertTrue(distance <= radius)
+      self.assertTrue(distance > radius * math.cos(math.pi / 16.0))
+
+  #------------------------------------------------------------------------------
+  def TestSection_06_SweptBrush(self):
+    logging.info('Test section 6: brush is swept between consecutive positions')
+
+    # Sphere: a capsule between the two positions, without gaps although
+    # the positions are much farther from each other than the brush diameter
+    self.effect.setCommonParameter('BrushSphere', 1)
+    self.effect.setCommonParameter('BrushAbsoluteDiameter', 3.0)
+    segmentID = self.paintNewSegment('capsule', [self.voxelCenter([3, 12, 6]), self.voxelCenter([26, 12, 6])])
+    for i in range(3, 27):
+      self.assertEqual(self.segmentVoxel(segmentID, [i, 12, 6]), 1)
+      self.assertEqual(self.segmentVoxel(segmentID, [i, 14, 6]), 0)
+      self.assertEqual(self.segmentVoxel(segmentID, [i, 12, 5]), 0)
+    self.assertEqual(self.segmentVoxel(segmentID, [1, 12, 6]), 0)
+    self.assertEqual(self.segmentVoxel(segmentID, [28, 12, 6]), 0)
+
+    # Cylinder: a slab of the thickness of the slice, swept in the slice plane
+    sliceWidget = slicer.app.layoutManager().sliceWidget('Red')
+    sliceNode = sliceWidget.mrmlSliceNode()
+    sliceNode.SetOrientationToAxial()
+    sliceNode.SetSliceSpacingModeToPrescribed()
+    sliceNode.SetPrescribedSliceSpacing(1.0, 1.0, 2.5)
+    self.effect.setCommonParameter('BrushSphere', 0)
+    self.effect.setCommonParameter('BrushAbsoluteDiameter', 6.0)
+    segmentID = self.paintNewSegment('swept cylinder', [self.voxelCenter([3, 12, 6]), self.voxelCenter([26, 12, 6])], sliceWidget)
+    for i in range(3, 27):
+      self.assertEqual(self.segmentVoxel(segmentID, [i, 12, 6]), 1)
+      # a sphere of this diameter would reach the neighbor slices
+      self.assertEqual(self.segmentVoxel(segmentID, [i, 12, 5]), 0)
+      self.assertEqual(self.segmentVoxel(segmentID, [i, 12, 7]), 0)
+    self.assertEqual(self.segmentVoxel(segmentID, [14, 20, 6]), 0)
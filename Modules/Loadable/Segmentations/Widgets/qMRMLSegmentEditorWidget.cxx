@@ -222,6 +222,12 @@ public:
   vtkMRMLTransformNode* AlignedMasterVolumeUpdateMasterVolumeNodeTransform;
   vtkMRMLTransformNode* AlignedMasterVolumeUpdateSegmentationNodeTransform;
 
+  /// Input data that is used for computing MaskLabelmap.
+  /// It is stored so that the mask is only regenerated if segments or mask settings change.
+  vtkMRMLSegmentationNode* MaskLabelmapUpdateSegmentationNode;
+  std::vector<std::string> MaskLabelmapUpdateSegmentIDs;
+  bool MaskLabelmapUpdatePaintInsideSegments;
+
   int MaskModeComboBoxFixedItemsCount;
 
   /// If reference geometry changes compared to this value then we notify effects and
@@ -247,6 +253,8 @@ qMRMLSegmentEditorWidgetPrivate::qMRMLSegmentEditorWidgetPrivate(qMRMLSegmentEdi
   , AlignedMasterVolumeUpdateMasterVolumeNode(NULL)
   , AlignedMasterVolumeUpdateMasterVolumeNodeTransform(NULL)
   , AlignedMasterVolumeUpdateSegmentationNodeTransform(NULL)
+  , MaskLabelmapUpdateSegmentationNode(NULL)
+  , MaskLabelmapUpdatePaintInsideSegments(false)
   , MaskModeComboBoxFixedItemsCount(0)
   , EffectButtonStyle(Qt::ToolButtonTextUnderIcon)
 {
@@ -573,6 +581,14 @@ bool qMRMLSegmentEditorWidgetPrivate::updateSelectedSegmentLabelmap()
     qCritical() << Q_FUNC_INFO << ": Failed to get binary labelmap representation in segmentation " << segmentationNode->GetName();
     return false;
     }
+  vtkSmartPointer<vtkOrientedImageData> extractedSegmentLabelmap;
+  if (selectedSegment->GetSharedLabelmap())
+    {
+    // The shared labelmap contains other segments as well
+    extractedSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    selectedSegment->ExtractBinaryLabelmapRepresentation(extractedSegmentLabelmap);
+    segmentLabelmap = extractedSegmentLabelmap;
+    }
   int* extent = segmentLabelmap->GetExtent();
   if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
     {
@@ -757,6 +773,33 @@ bool qMRMLSegmentEditorWidgetPrivate::updateMaskLabelmap()
     maskSegmentIDs.erase(std::remove(maskSegmentIDs.begin(), maskSegmentIDs.end(), editedSegmentID), maskSegmentIDs.end());
     }
 
+  // If mask settings and geometry did not change and none of the mask segments have been modified
+  // since the last update then the mask is still valid. This avoids merging all the segments on each stroke.
+  if (this->MaskLabelmapUpdateSegmentationNode == segmentationNode
+    && this->MaskLabelmapUpdateSegmentIDs == maskSegmentIDs
+    && this->MaskLabelmapUpdatePaintInsideSegments == paintInsideSegments
+    && maskImage->GetPointData()->GetScalars() != NULL
+    && vtkOrientedImageDataResample::DoGeometriesMatch(this->ModifierLabelmap, maskImage)
+    && vtkOrientedImageDataResample::DoExtentsMatch(this->ModifierLabelmap, maskImage))
+    {
+    bool updateMaskLabelmapRequired = false;
+    for (std::vector<std::string>::iterator segmentIDIt = maskSegmentIDs.begin(); segmentIDIt != maskSegmentIDs.end(); ++segmentIDIt)
+      {
+      vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIDIt);
+      vtkDataObject* segmentLabelmap = segment ? segment->GetRepresentation(
+        vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) : NULL;
+      if (!segmentLabelmap || segmentLabelmap->GetMTime() > maskImage->GetMTime())
+        {
+        updateMaskLabelmapRequired = true;
+        break;
+        }
+      }
+    if (!updateMaskLabelmapRequired)
+      {
+      return true;
+      }
+    }
+
   // Update mask if modifier labelmap is valid
   int modifierLabelmapExtent[6] = { 0, -1, 0, -1, 0, -1 };
   this->ModifierLabelmap->GetExtent(modifierLabelmapExtent);
@@ -782,6 +825,10 @@ bool qMRMLSegmentEditorWidgetPrivate::updateMaskLabelmap()
 
     maskImage->DeepCopy(threshold->GetOutput());
     maskImage->SetImageToWorldMatrix(mergedImageToWorldMatrix);
+
+    this->MaskLabelmapUpdateSegmentationNode = segmentationNode;
+    this->MaskLabelmapUpdateSegmentIDs = maskSegmentIDs;
+    this->MaskLabelmapUpdatePaintInsideSegments = paintInsideSegments;
     }
   return true;
 }
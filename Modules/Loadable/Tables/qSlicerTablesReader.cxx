@@ -103,6 +103,7 @@ QStringList qSlicerTablesReader::extensions()const
     << "Table (*.tsv)"
     << "Table (*.csv)"
     << "Table (*.txt)"
+    << "Table (*.stbl)"
     << "Table (*.db)"
     << "Table (*.db3)"
     << "Table (*.sqlite)"
@@ -0,0 +1,254 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Terminologies includes
+#include "vtkSlicerTerminologiesModuleLogic.h"
+#include "vtkSlicerTerminologyCategory.h"
+#include "vtkSlicerTerminologyType.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkDirectory.h>
+#include <vtkNew.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef vtkSlicerTerminologiesModuleLogic::CodeIdentifier CodeIdentifier;
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+std::string ReadFile(const std::string& filePath)
+{
+  std::ifstream file(filePath.c_str(), std::ios::in | std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+//----------------------------------------------------------------------------
+bool WriteFile(const std::string& filePath, const std::string& content)
+{
+  std::ofstream file(filePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write(content.c_str(), content.size());
+  return file.good();
+}
+
+//----------------------------------------------------------------------------
+/// Return the path of the only cache file in the cache directory
+std::string GetCacheFilePath(const std::string& cacheDirectory)
+{
+  std::string cacheFilePath;
+  vtkNew<vtkDirectory> directory;
+  if (!directory->Open(cacheDirectory.c_str()))
+    {
+    return cacheFilePath;
+    }
+  for (vtkIdType index = 0; index < directory->GetNumberOfFiles(); ++index)
+    {
+    std::string fileName = directory->GetFile(index);
+    if (vtksys::SystemTools::GetFilenameLastExtension(fileName) != ".cache")
+      {
+      continue;
+      }
+    if (!cacheFilePath.empty())
+      {
+      std::cerr << "More than one cache file in " << cacheDirectory << std::endl;
+      return std::string();
+      }
+    cacheFilePath = cacheDirectory + "/" + fileName;
+    }
+  return cacheFilePath;
+}
+
+//----------------------------------------------------------------------------
+std::string CodeToString(const CodeIdentifier& code)
+{
+  return code.CodingSchemeDesignator + ":" + code.CodeValue + ":" + code.CodeMeaning;
+}
+
+//----------------------------------------------------------------------------
+/// List the categories, types and type modifiers of a terminology.
+/// Each code is also looked up by identifier, the result of the lookup is
+/// added to the list.
+std::vector<std::string> GetTerminologyCodes(vtkSlicerTerminologiesModuleLogic* logic, const std::string& terminologyName)
+{
+  std::vector<std::string> codes;
+  std::vector<CodeIdentifier> categories;
+  logic->GetCategoriesInTerminology(terminologyName, categories);
+  for (std::vector<CodeIdentifier>::iterator categoryIt = categories.begin(); categoryIt != categories.end(); ++categoryIt)
+    {
+    vtkNew<vtkSlicerTerminologyCategory> category;
+    if (!logic->GetCategoryInTerminology(terminologyName, *categoryIt, category.GetPointer()))
+      {
+      codes.push_back("Missing category " + CodeToString(*categoryIt));
+      continue;
+      }
+    codes.push_back("Category " + CodeToString(*categoryIt) + " -> "
+      + CodeToString(vtkSlicerTerminologiesModuleLogic::CodeIdentifierFromTerminologyCategory(category.GetPointer())));
+
+    std::vector<CodeIdentifier> types;
+    logic->GetTypesInTerminologyCategory(terminologyName, *categoryIt, types);
+    for (std::vector<CodeIdentifier>::iterator typeIt = types.begin(); typeIt != types.end(); ++typeIt)
+      {
+      vtkNew<vtkSlicerTerminologyType> type;
+      if (!logic->GetTypeInTerminologyCategory(terminologyName, *categoryIt, *typeIt, type.GetPointer()))
+        {
+        codes.push_back("Missing type " + CodeToString(*typeIt));
+        continue;
+        }
+      codes.push_back("Type " + CodeToString(*typeIt) + " -> "
+        + CodeToString(vtkSlicerTerminologiesModuleLogic::CodeIdentifierFromTerminologyType(type.GetPointer())));
+      if (!type->GetHasModifiers())
+        {
+        continue;
+        }
+
+      std::vector<CodeIdentifier> modifiers;
+      logic->GetTypeModifiersInTerminologyType(terminologyName, *categoryIt, *typeIt, modifiers);
+      for (std::vector<CodeIdentifier>::iterator modifierIt = modifiers.begin(); modifierIt != modifiers.end(); ++modifierIt)
+        {
+        vtkNew<vtkSlicerTerminologyType> modifier;
+        if (!logic->GetTypeModifierInTerminologyType(terminologyName, *categoryIt, *typeIt, *modifierIt, modifier.GetPointer()))
+          {
+          codes.push_back("Missing modifier " + CodeToString(*modifierIt));
+          continue;
+          }
+        codes.push_back("Modifier " + CodeToString(*modifierIt) + " -> "
+          + CodeToString(vtkSlicerTerminologiesModuleLogic::CodeIdentifierFromTerminologyType(modifier.GetPointer())));
+        }
+      }
+    }
+
+  // Search uses the same index as the lookups
+  std::vector<CodeIdentifier> foundCategories;
+  logic->FindCategoriesInTerminology(terminologyName, foundCategories, "tis");
+  for (std::vector<CodeIdentifier>::iterator categoryIt = foundCategories.begin(); categoryIt != foundCategories.end(); ++categoryIt)
+    {
+    codes.push_back("Found category " + CodeToString(*categoryIt));
+    }
+  return codes;
+}
+
+//----------------------------------------------------------------------------
+/// Load the terminology into a new logic and return its codes.
+/// Return an empty list if the terminology cannot be loaded.
+std::vector<std::string> LoadTerminologyCodes(const std::string& filePath, const std::string& cacheDirectory)
+{
+  vtkNew<vtkSlicerTerminologiesModuleLogic> logic;
+  logic->SetContextCachePath(cacheDirectory.empty() ? NULL : cacheDirectory.c_str());
+  std::string terminologyName = logic->LoadTerminologyFromFile(filePath);
+  if (terminologyName.empty())
+    {
+    return std::vector<std::string>();
+    }
+  return GetTerminologyCodes(logic.GetPointer(), terminologyName);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerTerminologiesModuleLogicCacheTest(int argc, char * argv[])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: vtkSlicerTerminologiesModuleLogicCacheTest /path/to/terminology.json /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string tempDirectory = argv[2];
+  const std::string filePath = tempDirectory + "/vtkSlicerTerminologiesModuleLogicCacheTest.json";
+  const std::string fileTimeReferencePath = tempDirectory + "/vtkSlicerTerminologiesModuleLogicCacheTest-time.json";
+  const std::string cacheDirectory = tempDirectory + "/vtkSlicerTerminologiesModuleLogicCacheTest";
+  vtksys::SystemTools::RemoveADirectory(cacheDirectory.c_str());
+
+  const std::string content = ReadFile(argv[1]);
+  CHECK_BOOL(content.empty(), false);
+  CHECK_BOOL(WriteFile(filePath, content), true);
+  CHECK_BOOL(WriteFile(fileTimeReferencePath, content), true);
+  CHECK_BOOL(vtksys::SystemTools::CopyFileTime(filePath.c_str(), fileTimeReferencePath.c_str()), true);
+
+  // Reference codes, parsed without cache
+  std::vector<std::string> referenceCodes = LoadTerminologyCodes(filePath, "");
+  CHECK_BOOL(referenceCodes.empty(), false);
+  for (std::vector<std::string>::iterator codeIt = referenceCodes.begin(); codeIt != referenceCodes.end(); ++codeIt)
+    {
+    CHECK_BOOL(codeIt->compare(0, 7, "Missing") == 0, false);
+    }
+
+  // First load parses the file and writes the cache
+  CHECK_BOOL(LoadTerminologyCodes(filePath, cacheDirectory) == referenceCodes, true);
+  const std::string cacheFilePath = GetCacheFilePath(cacheDirectory);
+  CHECK_BOOL(cacheFilePath.empty(), false);
+  const std::string cacheContent = ReadFile(cacheFilePath);
+  CHECK_BOOL(cacheContent.empty(), false);
+
+  // Replace the file by invalid Json of the same size and modification time:
+  // it can only be loaded from the cache, with the same lookups.
+  CHECK_BOOL(WriteFile(filePath, std::string(content.size(), ' ')), true);
+  CHECK_BOOL(vtksys::SystemTools::CopyFileTime(fileTimeReferencePath.c_str(), filePath.c_str()), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(LoadTerminologyCodes(filePath, "").empty(), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_BOOL(LoadTerminologyCodes(filePath, cacheDirectory) == referenceCodes, true);
+  CHECK_STD_STRING(ReadFile(cacheFilePath), cacheContent);
+
+  // Cache of another format version is rejected
+  std::string otherVersionCacheContent = cacheContent;
+  const size_t versionOffset = sizeof(vtkTypeUInt32) + strlen("SlicerTerminologyCache");
+  otherVersionCacheContent[versionOffset] ^= 0x7f;
+  CHECK_BOOL(WriteFile(cacheFilePath, otherVersionCacheContent), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(LoadTerminologyCodes(filePath, cacheDirectory).empty(), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  // Truncated cache is rejected
+  CHECK_BOOL(WriteFile(cacheFilePath, cacheContent.substr(0, cacheContent.size() / 2)), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(LoadTerminologyCodes(filePath, cacheDirectory).empty(), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  // Cache of a previous version of the file is rejected and rewritten
+  std::string modifiedContent = content;
+  const std::string codeMeaning = "\"CodeMeaning\": \"Artery\"";
+  size_t codeMeaningPosition = modifiedContent.find(codeMeaning);
+  CHECK_BOOL(codeMeaningPosition != std::string::npos, true);
+  modifiedContent.replace(codeMeaningPosition, codeMeaning.size(), "\"CodeMeaning\": \"Arteries\"");
+  CHECK_BOOL(WriteFile(cacheFilePath, cacheContent), true);
+  CHECK_BOOL(WriteFile(filePath, modifiedContent), true);
+  std::vector<std::string> modifiedCodes = LoadTerminologyCodes(filePath, "");
+  CHECK_BOOL(modifiedCodes.empty(), false);
+  CHECK_BOOL(modifiedCodes == referenceCodes, false);
+  CHECK_BOOL(LoadTerminologyCodes(filePath, cacheDirectory) == modifiedCodes, true);
+  CHECK_STD_STRING_DIFFERENT(ReadFile(cacheFilePath), cacheContent);
+  CHECK_BOOL(LoadTerminologyCodes(filePath, cacheDirectory) == modifiedCodes, true);
+
+  vtksys::SystemTools::RemoveADirectory(cacheDirectory.c_str());
+  vtksys::SystemTools::RemoveFile(filePath.c_str());
+  vtksys::SystemTools::RemoveFile(fileTimeReferencePath.c_str());
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -43,6 +43,10 @@
 
 // STD includes
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
 
 #include "rapidjson/document.h"     // rapidjson's DOM-style API
 #include "rapidjson/prettywriter.h" // for stringify JSON
@@ -52,6 +56,240 @@ static rapidjson::Value JSON_EMPTY_VALUE;
 static std::string ANATOMIC_CONTEXT_SCHEMA = "https://raw.githubusercontent.com/qiicr/dcmqi/master/doc/anatomic-context-schema.json#";
 static std::string TERMINOLOGY_CONTEXT_SCHEMA = "https://raw.githubusercontent.com/qiicr/dcmqi/master/doc/segment-context-schema.json#";
 
+//----------------------------------------------------------------------------
+// Binary cache of the context files
+//
+// The Json document of a context file is stored in a binary form next to the
+// file information it was created from, so that it can be loaded on startup
+// without parsing Json. Cache files are machine specific (native byte order)
+// and are recreated when the context file or the cache format changes.
+namespace
+{
+const char TERMINOLOGY_CACHE_MAGIC[] = "SlicerTerminologyCache";
+/// Increment when the layout of the cache files changes
+const vtkTypeUInt32 TERMINOLOGY_CACHE_VERSION = 1;
+const vtkTypeUInt32 TERMINOLOGY_CACHE_BYTE_ORDER_MARK = 0x01020304;
+/// Maximum nesting of Json values in a cache file (protects against corrupt files)
+const int TERMINOLOGY_CACHE_MAX_DEPTH = 64;
+
+enum CachedValueType
+{
+  CachedNull = 0,
+  CachedFalse,
+  CachedTrue,
+  CachedString,
+  CachedInt64,
+  CachedUint64,
+  CachedDouble,
+  CachedArray,
+  CachedObject,
+  CachedEnd
+};
+
+//----------------------------------------------------------------------------
+template<class T> void WriteCacheScalar(std::ostream& stream, T value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+//----------------------------------------------------------------------------
+void WriteCacheString(std::ostream& stream, const char* str, vtkTypeUInt32 length)
+{
+  WriteCacheScalar<vtkTypeUInt32>(stream, length);
+  stream.write(str, length);
+}
+
+//----------------------------------------------------------------------------
+void WriteCacheValue(std::ostream& stream, const rapidjson::Value& value)
+{
+  switch (value.GetType())
+    {
+    case rapidjson::kFalseType:
+      WriteCacheScalar<unsigned char>(stream, CachedFalse);
+      break;
+    case rapidjson::kTrueType:
+      WriteCacheScalar<unsigned char>(stream, CachedTrue);
+      break;
+    case rapidjson::kStringType:
+      WriteCacheScalar<unsigned char>(stream, CachedString);
+      WriteCacheString(stream, value.GetString(), value.GetStringLength());
+      break;
+    case rapidjson::kNumberType:
+      if (value.IsInt64())
+        {
+        WriteCacheScalar<unsigned char>(stream, CachedInt64);
+        WriteCacheScalar<vtkTypeInt64>(stream, value.GetInt64());
+        }
+      else if (value.IsUint64())
+        {
+        WriteCacheScalar<unsigned char>(stream, CachedUint64);
+        WriteCacheScalar<vtkTypeUInt64>(stream, value.GetUint64());
+        }
+      else
+        {
+        WriteCacheScalar<unsigned char>(stream, CachedDouble);
+        WriteCacheScalar<double>(stream, value.GetDouble());
+        }
+      break;
+    case rapidjson::kArrayType:
+      WriteCacheScalar<unsigned char>(stream, CachedArray);
+      WriteCacheScalar<vtkTypeUInt32>(stream, value.Size());
+      for (rapidjson::SizeType index = 0; index < value.Size(); ++index)
+        {
+        WriteCacheValue(stream, value[index]);
+        }
+      break;
+    case rapidjson::kObjectType:
+      {
+      WriteCacheScalar<unsigned char>(stream, CachedObject);
+      vtkTypeUInt32 numberOfMembers = 0;
+      for (rapidjson::Value::ConstMemberIterator memberIt = value.MemberBegin(); memberIt != value.MemberEnd(); ++memberIt)
+        {
+        ++numberOfMembers;
+        }
+      WriteCacheScalar<vtkTypeUInt32>(stream, numberOfMembers);
+      for (rapidjson::Value::ConstMemberIterator memberIt = value.MemberBegin(); memberIt != value.MemberEnd(); ++memberIt)
+        {
+        WriteCacheString(stream, memberIt->name.GetString(), memberIt->name.GetStringLength());
+        WriteCacheValue(stream, memberIt->value);
+        }
+      }
+      break;
+    default:
+      WriteCacheScalar<unsigned char>(stream, CachedNull);
+      break;
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Decode values from a cache file loaded in memory
+class CacheReader
+{
+public:
+  CacheReader(const std::vector<char>& buffer)
+    : Buffer(buffer)
+    , Position(0)
+    , Failed(false)
+    {
+    }
+
+  template<class T> T ReadScalar()
+    {
+    T value = T();
+    if (this->Failed || this->Position + sizeof(T) > this->Buffer.size())
+      {
+      this->Failed = true;
+      return value;
+      }
+    memcpy(&value, &this->Buffer[this->Position], sizeof(T));
+    this->Position += sizeof(T);
+    return value;
+    }
+
+  /// Returns a pointer into the buffer, the string is not null-terminated
+  const char* ReadString(vtkTypeUInt32& length)
+    {
+    length = this->ReadScalar<vtkTypeUInt32>();
+    if (this->Failed || this->Position + length > this->Buffer.size())
+      {
+      this->Failed = true;
+      length = 0;
+      return "";
+      }
+    const char* str = (length > 0 ? &this->Buffer[this->Position] : "");
+    this->Position += length;
+    return str;
+    }
+
+  bool ReadValue(rapidjson::Value& value, rapidjson::Document::AllocatorType& allocator, int depth = 0)
+    {
+    if (depth > TERMINOLOGY_CACHE_MAX_DEPTH)
+      {
+      this->Failed = true;
+      return false;
+      }
+    unsigned char type = this->ReadScalar<unsigned char>();
+    vtkTypeUInt32 length = 0;
+    switch (type)
+      {
+      case CachedNull:
+        value.SetNull();
+        break;
+      case CachedFalse:
+        value.SetBool(false);
+        break;
+      case CachedTrue:
+        value.SetBool(true);
+        break;
+      case CachedString:
+        {
+        const char* str = this->ReadString(length);
+        value.SetString(str, length, allocator);
+        }
+        break;
+      case CachedInt64:
+        value.SetInt64(this->ReadScalar<vtkTypeInt64>());
+        break;
+      case CachedUint64:
+        value.SetUint64(this->ReadScalar<vtkTypeUInt64>());
+        break;
+      case CachedDouble:
+        value.SetDouble(this->ReadScalar<double>());
+        break;
+      case CachedArray:
+        length = this->ReadScalar<vtkTypeUInt32>();
+        value.SetArray();
+        for (vtkTypeUInt32 index = 0; index < length && !this->Failed; ++index)
+          {
+          rapidjson::Value element;
+          this->ReadValue(element, allocator, depth + 1);
+          value.PushBack(element, allocator);
+          }
+        break;
+      case CachedObject:
+        length = this->ReadScalar<vtkTypeUInt32>();
+        value.SetObject();
+        for (vtkTypeUInt32 index = 0; index < length && !this->Failed; ++index)
+          {
+          vtkTypeUInt32 nameLength = 0;
+          const char* nameStr = this->ReadString(nameLength);
+          rapidjson::Value name(nameStr, nameLength, allocator);
+          rapidjson::Value member;
+          this->ReadValue(member, allocator, depth + 1);
+          value.AddMember(name, member, allocator);
+          }
+        break;
+      default:
+        this->Failed = true;
+      }
+    return !this->Failed;
+    }
+
+  bool AtEnd()
+    {
+    return this->Position == this->Buffer.size();
+    }
+
+  const std::vector<char>& Buffer;
+  size_t Position;
+  bool Failed;
+};
+
+//----------------------------------------------------------------------------
+/// FNV-1a hash, used to make cache file names unique for the context file paths
+vtkTypeUInt32 HashString(const std::string& str)
+{
+  vtkTypeUInt32 hash = 2166136261u;
+  for (std::string::const_iterator charIt = str.begin(); charIt != str.end(); ++charIt)
+    {
+    hash ^= static_cast<unsigned char>(*charIt);
+    hash *= 16777619u;
+    }
+  return hash;
+}
+
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerTerminologiesModuleLogic);
 
@@ -71,6 +309,36 @@ public:
   /// \return Json object if found, otherwise null Json object
   rapidjson::Value& GetCodeInArray(CodeIdentifier codeId, rapidjson::Value& jsonArray, int &foundIndex);
 
+  /// Index of the codes in a Json array of a loaded context
+  struct CodeArrayIndex
+    {
+    /// Index of the code objects in the array. Key is (CodingSchemeDesignator, CodeValue)
+    std::map<std::pair<std::string, std::string>, rapidjson::SizeType> ArrayIndexByCode;
+    /// Identifiers of the valid code objects in array order
+    std::vector<CodeIdentifier> Codes;
+    /// Lowercase code meanings (same order as \sa Codes) for case-insensitive search
+    std::vector<std::string> LowerCaseCodeMeanings;
+    };
+  /// Get the index of the codes in a Json array of a loaded context. The index is
+  /// built on first access and released when a context is (re)loaded.
+  CodeArrayIndex& GetCodeArrayIndex(rapidjson::Value& jsonArray);
+  /// Indexed variant of \sa GetCodeInArray for Json arrays of loaded contexts
+  rapidjson::Value& FindCodeInArray(CodeIdentifier codeId, rapidjson::Value& jsonArray);
+  /// Get identifiers of the codes in a Json array of a loaded context with names containing a given string
+  /// \param search Lowercase search string. All codes are returned if empty
+  void FindCodesInArray(rapidjson::Value& jsonArray, const std::string& search, std::vector<CodeIdentifier>& codes);
+
+  /// Read Json document from a context file. If \a cacheDirectory is specified
+  /// then the document is read from the binary cache if it is up-to-date,
+  /// otherwise the file is parsed and the cache is updated.
+  /// \return Success flag
+  bool ReadJsonFile(const std::string& filePath, const char* cacheDirectory, rapidjson::Document& document);
+  /// Read Json document from the binary cache of a context file
+  /// \return Success flag. False if there is no up-to-date cache for the file.
+  bool ReadJsonFromCache(const std::string& filePath, const std::string& cacheFilePath, rapidjson::Document& document);
+  /// Write Json document into the binary cache of a context file
+  void WriteJsonToCache(const std::string& filePath, const std::string& cacheFilePath, rapidjson::Document& document);
+
   /// Get root Json value for the terminology with given name
   rapidjson::Value& GetTerminologyRootByName(std::string terminologyName);
 
@@ -135,8 +403,11 @@ public:
   void GetJsonCodeFromIdentifier(rapidjson::Value& code, CodeIdentifier idenfifier, rapidjson::Document::AllocatorType& allocator);
 
   /// Utility function for safe (memory-leak-free) setting of a document pointer in map
-  static void SetDocumentInTerminologyMap(TerminologyMap& terminologyMap, const std::string& name, rapidjson::Document* doc)
+  void SetDocumentInTerminologyMap(TerminologyMap& terminologyMap, const std::string& name, rapidjson::Document* doc)
     {
+    // The document may have been changed or deleted, indices are rebuilt on demand
+    this->CodeArrayIndices.clear();
+
     if (terminologyMap.find(name) != terminologyMap.end())
       {
       if (doc == terminologyMap[name])
@@ -157,6 +428,9 @@ public:
 
   /// Loaded anatomical region contexts. Key is the context name, value is the root item.
   TerminologyMap LoadedAnatomicContexts;
+
+  /// Indices of the code arrays of the loaded contexts. Key is the Json array.
+  std::map<const rapidjson::Value*, CodeArrayIndex> CodeArrayIndices;
 };
 
 //---------------------------------------------------------------------------
@@ -214,6 +488,196 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCodeInArray
   return JSON_EMPTY_VALUE;
 }
 
+//---------------------------------------------------------------------------
+vtkSlicerTerminologiesModuleLogic::vtkInternal::CodeArrayIndex&
+vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCodeArrayIndex(rapidjson::Value& jsonArray)
+{
+  std::map<const rapidjson::Value*, CodeArrayIndex>::iterator indexIt = this->CodeArrayIndices.find(&jsonArray);
+  if (indexIt != this->CodeArrayIndices.end())
+    {
+    return indexIt->second;
+    }
+
+  CodeArrayIndex& codeArrayIndex = this->CodeArrayIndices[&jsonArray];
+  if (!jsonArray.IsArray())
+    {
+    return codeArrayIndex;
+    }
+  for (rapidjson::SizeType index = 0; index < jsonArray.Size(); ++index)
+    {
+    rapidjson::Value& currentObject = jsonArray[index];
+    if (!currentObject.IsObject())
+      {
+      continue;
+      }
+    rapidjson::Value::MemberIterator codeMeaning = currentObject.FindMember("CodeMeaning");
+    rapidjson::Value::MemberIterator codingSchemeDesignator = currentObject.FindMember("CodingSchemeDesignator");
+    rapidjson::Value::MemberIterator codeValue = currentObject.FindMember("CodeValue");
+    if ( codingSchemeDesignator == currentObject.MemberEnd() || !codingSchemeDesignator->value.IsString()
+      || codeValue == currentObject.MemberEnd() || !codeValue->value.IsString() )
+      {
+      continue;
+      }
+    // First occurrence of a code is found, same as in GetCodeInArray
+    codeArrayIndex.ArrayIndexByCode.insert(std::make_pair(
+      std::make_pair(std::string(codingSchemeDesignator->value.GetString()), std::string(codeValue->value.GetString())), index));
+
+    if (codeMeaning == currentObject.MemberEnd() || !codeMeaning->value.IsString())
+      {
+      vtkGenericWarningMacro("GetCodeArrayIndex: Code '" << codeValue->value.GetString() << "' has no valid CodeMeaning");
+      continue;
+      }
+    std::string codeMeaningStr = codeMeaning->value.GetString();
+    codeArrayIndex.Codes.push_back(CodeIdentifier(
+      codingSchemeDesignator->value.GetString(), codeValue->value.GetString(), codeMeaningStr));
+    std::transform(codeMeaningStr.begin(), codeMeaningStr.end(), codeMeaningStr.begin(), ::tolower);
+    codeArrayIndex.LowerCaseCodeMeanings.push_back(codeMeaningStr);
+    }
+  return codeArrayIndex;
+}
+
+//---------------------------------------------------------------------------
+rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::FindCodeInArray(CodeIdentifier codeId, rapidjson::Value& jsonArray)
+{
+  if (!jsonArray.IsArray())
+    {
+    return JSON_EMPTY_VALUE;
+    }
+  CodeArrayIndex& codeArrayIndex = this->GetCodeArrayIndex(jsonArray);
+  std::map<std::pair<std::string, std::string>, rapidjson::SizeType>::iterator codeIt =
+    codeArrayIndex.ArrayIndexByCode.find(std::make_pair(codeId.CodingSchemeDesignator, codeId.CodeValue));
+  if (codeIt == codeArrayIndex.ArrayIndexByCode.end())
+    {
+    return JSON_EMPTY_VALUE;
+    }
+  return jsonArray[codeIt->second];
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::FindCodesInArray(
+  rapidjson::Value& jsonArray, const std::string& search, std::vector<CodeIdentifier>& codes)
+{
+  CodeArrayIndex& codeArrayIndex = this->GetCodeArrayIndex(jsonArray);
+  if (search.empty())
+    {
+    codes.insert(codes.end(), codeArrayIndex.Codes.begin(), codeArrayIndex.Codes.end());
+    return;
+    }
+  for (size_t index = 0; index < codeArrayIndex.Codes.size(); ++index)
+    {
+    if (codeArrayIndex.LowerCaseCodeMeanings[index].find(search) != std::string::npos)
+      {
+      codes.push_back(codeArrayIndex.Codes[index]);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerTerminologiesModuleLogic::vtkInternal::ReadJsonFile(
+  const std::string& filePath, const char* cacheDirectory, rapidjson::Document& document)
+{
+  std::string cacheFilePath;
+  if (cacheDirectory && strlen(cacheDirectory) > 0)
+    {
+    std::stringstream cacheFileName;
+    cacheFileName << vtksys::SystemTools::GetFilenameWithoutExtension(filePath)
+      << "-" << std::hex << HashString(vtksys::SystemTools::CollapseFullPath(filePath)) << ".cache";
+    cacheFilePath = std::string(cacheDirectory) + "/" + cacheFileName.str();
+    if (this->ReadJsonFromCache(filePath, cacheFilePath, document))
+      {
+      return true;
+      }
+    }
+
+  FILE *fp = fopen(filePath.c_str(), "r");
+  if (!fp)
+    {
+    return false;
+    }
+  char buffer[4096];
+  rapidjson::FileReadStream fs(fp, buffer, sizeof(buffer));
+  bool success = !document.ParseStream(fs).HasParseError();
+  fclose(fp);
+
+  if (success && !cacheFilePath.empty())
+    {
+    this->WriteJsonToCache(filePath, cacheFilePath, document);
+    }
+  return success;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerTerminologiesModuleLogic::vtkInternal::ReadJsonFromCache(
+  const std::string& filePath, const std::string& cacheFilePath, rapidjson::Document& document)
+{
+  std::ifstream cacheFile(cacheFilePath.c_str(), std::ios::in | std::ios::binary);
+  if (!cacheFile.is_open())
+    {
+    return false;
+    }
+  cacheFile.seekg(0, std::ios::end);
+  std::streamoff cacheFileSize = cacheFile.tellg();
+  if (cacheFileSize <= 0)
+    {
+    return false;
+    }
+  std::vector<char> buffer(static_cast<size_t>(cacheFileSize));
+  cacheFile.seekg(0, std::ios::beg);
+  if (!cacheFile.read(&buffer[0], cacheFileSize))
+    {
+    return false;
+    }
+
+  // Check that the cache was created by this version from the current file
+  CacheReader reader(buffer);
+  vtkTypeUInt32 length = 0;
+  const char* magic = reader.ReadString(length);
+  if ( length != strlen(TERMINOLOGY_CACHE_MAGIC) || strncmp(magic, TERMINOLOGY_CACHE_MAGIC, length)
+    || reader.ReadScalar<vtkTypeUInt32>() != TERMINOLOGY_CACHE_VERSION
+    || reader.ReadScalar<vtkTypeUInt32>() != TERMINOLOGY_CACHE_BYTE_ORDER_MARK
+    || reader.ReadScalar<vtkTypeUInt64>() != static_cast<vtkTypeUInt64>(vtksys::SystemTools::FileLength(filePath.c_str()))
+    || reader.ReadScalar<vtkTypeInt64>() != static_cast<vtkTypeInt64>(vtksys::SystemTools::ModifiedTime(filePath.c_str())) )
+    {
+    return false;
+    }
+  const char* cachedFilePath = reader.ReadString(length);
+  if (reader.Failed || std::string(cachedFilePath, length) != vtksys::SystemTools::CollapseFullPath(filePath))
+    {
+    return false;
+    }
+
+  // Decode document
+  if ( !reader.ReadValue(document, document.GetAllocator())
+    || reader.ReadScalar<unsigned char>() != CachedEnd || !reader.AtEnd() )
+    {
+    vtkGenericWarningMacro("ReadJsonFromCache: Invalid terminology cache file " << cacheFilePath);
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::WriteJsonToCache(
+  const std::string& filePath, const std::string& cacheFilePath, rapidjson::Document& document)
+{
+  vtksys::SystemTools::MakeDirectory(vtksys::SystemTools::GetFilenamePath(cacheFilePath).c_str());
+  std::ofstream cacheFile(cacheFilePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!cacheFile.is_open())
+    {
+    vtkGenericWarningMacro("WriteJsonToCache: Failed to write terminology cache file " << cacheFilePath);
+    return;
+    }
+  std::string fullFilePath = vtksys::SystemTools::CollapseFullPath(filePath);
+  WriteCacheString(cacheFile, TERMINOLOGY_CACHE_MAGIC, static_cast<vtkTypeUInt32>(strlen(TERMINOLOGY_CACHE_MAGIC)));
+  WriteCacheScalar<vtkTypeUInt32>(cacheFile, TERMINOLOGY_CACHE_VERSION);
+  WriteCacheScalar<vtkTypeUInt32>(cacheFile, TERMINOLOGY_CACHE_BYTE_ORDER_MARK);
+  WriteCacheScalar<vtkTypeUInt64>(cacheFile, vtksys::SystemTools::FileLength(filePath.c_str()));
+  WriteCacheScalar<vtkTypeInt64>(cacheFile, vtksys::SystemTools::ModifiedTime(filePath.c_str()));
+  WriteCacheString(cacheFile, fullFilePath.c_str(), static_cast<vtkTypeUInt32>(fullFilePath.size()));
+  WriteCacheValue(cacheFile, document);
+  WriteCacheScalar<unsigned char>(cacheFile, CachedEnd);
+}
+
 //---------------------------------------------------------------------------
 rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTerminologyRootByName(std::string terminologyName)
 {
@@ -270,8 +734,7 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCategoryInT
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(categoryId, categoryArray, index);
+  return this->FindCodeInArray(categoryId, categoryArray);
 }
 
 //---------------------------------------------------------------------------
@@ -369,8 +832,7 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTypeInTermi
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(typeId, typeArray, index);
+  return this->FindCodeInArray(typeId, typeArray);
 }
 
 //---------------------------------------------------------------------------
@@ -495,8 +957,7 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTypeModifie
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(modifierId, typeModifierArray, index);
+  return this->FindCodeInArray(modifierId, typeModifierArray);
 }
 
 //---------------------------------------------------------------------------
@@ -555,8 +1016,7 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetRegionInAna
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(regionId, regionArray, index);
+  return this->FindCodeInArray(regionId, regionArray);
 }
 
 //---------------------------------------------------------------------------
@@ -607,8 +1067,7 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetRegionModif
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(modifierId, regionModifierArray, index);
+  return this->FindCodeInArray(modifierId, regionModifierArray);
 }
 
 //---------------------------------------------------------------------------
@@ -990,6 +1449,7 @@ void vtkSlicerTerminologiesModuleLogic::vtkInternal::GetJsonCodeFromIdentifier(
 //----------------------------------------------------------------------------
 vtkSlicerTerminologiesModuleLogic::vtkSlicerTerminologiesModuleLogic()
   : UserContextsPath(NULL)
+  , ContextCachePath(NULL)
 {
   this->Internal = new vtkInternal();
 }
@@ -1001,12 +1461,16 @@ vtkSlicerTerminologiesModuleLogic::~vtkSlicerTerminologiesModuleLogic()
   this->Internal = NULL;
 
   this->SetUserContextsPath(NULL);
+  this->SetContextCachePath(NULL);
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerTerminologiesModuleLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "UserContextsPath: " << (this->UserContextsPath ? this->UserContextsPath : "(none)") << "\n";
+  os << indent << "ContextCachePath: " << (this->ContextCachePath ? this->ContextCachePath : "(none)") << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -1028,19 +1492,10 @@ void vtkSlicerTerminologiesModuleLogic::SetMRMLSceneInternal(vtkMRMLScene* newSc
 bool vtkSlicerTerminologiesModuleLogic::LoadContextFromFile(std::string filePath)
 {
   rapidjson::Document* jsonRoot = new rapidjson::Document;
-
-  FILE *fp = fopen(filePath.c_str(), "r");
-  if (!fp)
+  if (!this->Internal->ReadJsonFile(filePath, this->ContextCachePath, *jsonRoot))
     {
     vtkErrorMacro("LoadContextFromFile: Failed to load context from file '" << filePath);
-    return false;
-    }
-  char buffer[4096];
-  rapidjson::FileReadStream fs(fp, buffer, sizeof(buffer));
-  if (jsonRoot->ParseStream(fs).HasParseError())
-    {
-    vtkErrorMacro("LoadContextFromFile: Failed to load context from file '" << filePath);
-    fclose(fp);
+    delete jsonRoot;
     return false;
     }
 
@@ -1049,7 +1504,7 @@ bool vtkSlicerTerminologiesModuleLogic::LoadContextFromFile(std::string filePath
   if (schemaIt == jsonRoot->MemberEnd())
     {
     vtkErrorMacro("LoadContextFromFile: File " << filePath << " does not contain schema information");
-    fclose(fp);
+    delete jsonRoot;
     return false;
     }
   std::string schema = (*jsonRoot)["@schema"].GetString();
@@ -1057,7 +1512,7 @@ bool vtkSlicerTerminologiesModuleLogic::LoadContextFromFile(std::string filePath
     {
     // Store terminology
     std::string contextName = (*jsonRoot)["SegmentationCategoryTypeContextName"].GetString();
-    vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+    this->Internal->SetDocumentInTerminologyMap(
       this->Internal->LoadedTerminologies, contextName, jsonRoot);
     vtkDebugMacro("Terminology named '" << contextName << "' successfully loaded from file " << filePath);
     }
@@ -1065,18 +1520,17 @@ bool vtkSlicerTerminologiesModuleLogic::LoadContextFromFile(std::string filePath
     {
     // Store anatomic context
     std::string contextName = (*jsonRoot)["AnatomicContextName"].GetString();
-    vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+    this->Internal->SetDocumentInTerminologyMap(
       this->Internal->LoadedAnatomicContexts, contextName, jsonRoot);
     vtkDebugMacro("Anatomic context named '" << contextName << "' successfully loaded from file " << filePath);
     }
   else
     {
     vtkErrorMacro("LoadContextFromFile: File " << filePath << " is neither a terminology nor anatomic context file according to its schema");
-    fclose(fp);
+    delete jsonRoot;
     return false;
     }
 
-  fclose(fp);
   this->Modified();
   return true;
 }
@@ -1085,19 +1539,10 @@ bool vtkSlicerTerminologiesModuleLogic::LoadContextFromFile(std::string filePath
 std::string vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromFile(std::string filePath)
 {
   rapidjson::Document* terminologyRoot = new rapidjson::Document;
-
-  FILE *fp = fopen(filePath.c_str(), "r");
-  if (!fp)
+  if (!this->Internal->ReadJsonFile(filePath, this->ContextCachePath, *terminologyRoot))
     {
     vtkErrorMacro("LoadTerminologyFromFile: Failed to load terminology from file '" << filePath << "'");
-    return "";
-    }
-  char buffer[4096];
-  rapidjson::FileReadStream fs(fp, buffer, sizeof(buffer));
-  if (terminologyRoot->ParseStream(fs).HasParseError())
-    {
-    vtkErrorMacro("LoadTerminologyFromFile: Failed to load terminology from file '" << filePath << "'");
-    fclose(fp);
+    delete terminologyRoot;
     return "";
     }
 
@@ -1106,24 +1551,23 @@ std::string vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromFile(std::stri
   if (schemaIt == terminologyRoot->MemberEnd())
     {
     vtkErrorMacro("LoadTerminologyFromFile: File " << filePath << " does not contain schema information");
-    fclose(fp);
+    delete terminologyRoot;
     return "";
     }
   std::string schema = (*terminologyRoot)["@schema"].GetString();
   if (schema.compare(TERMINOLOGY_CONTEXT_SCHEMA))
     {
     vtkErrorMacro("LoadTerminologyFromFile: File " << filePath << " is not a terminology context file according to its schema");
-    fclose(fp);
+    delete terminologyRoot;
     return "";
     }
 
   // Store terminology
   std::string contextName = (*terminologyRoot)["SegmentationCategoryTypeContextName"].GetString();
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+  this->Internal->SetDocumentInTerminologyMap(
     this->Internal->LoadedTerminologies, contextName, terminologyRoot);
 
   vtkDebugMacro("Terminology named '" << contextName << "' successfully loaded from file " << filePath);
-  fclose(fp);
   this->Modified();
   return contextName;
 }
@@ -1169,7 +1613,7 @@ bool vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromSegmentDescriptorFile
     }
 
   // Store terminology
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+  this->Internal->SetDocumentInTerminologyMap(
     this->Internal->LoadedTerminologies, contextName, convertedDoc );
 
   vtkDebugMacro("Terminology named '" << contextName << "' successfully loaded from file " << filePath);
@@ -1198,20 +1642,10 @@ void vtkSlicerTerminologiesModuleLogic::LoadDefaultTerminologies()
 std::string vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromFile(std::string filePath)
 {
   rapidjson::Document* anatomicContextRoot = new rapidjson::Document;
-
-  FILE *fp = fopen(filePath.c_str(), "r");
-  if (!fp)
+  if (!this->Internal->ReadJsonFile(filePath, this->ContextCachePath, *anatomicContextRoot))
     {
     vtkErrorMacro("LoadAnatomicContextFromFile: Failed to load anatomic context from file " << filePath);
-    return "";
-    }
-
-  char buffer[4096];
-  rapidjson::FileReadStream fs(fp, buffer, sizeof(buffer));
-  if (anatomicContextRoot->ParseStream(fs).HasParseError())
-    {
-    vtkErrorMacro("LoadAnatomicContextFromFile: Failed to load anatomic context from file " << filePath);
-    fclose(fp);
+    delete anatomicContextRoot;
     return "";
     }
 
@@ -1220,24 +1654,23 @@ std::string vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromFile(std::
   if (schemaIt == anatomicContextRoot->MemberEnd())
     {
     vtkErrorMacro("LoadAnatomicContextFromFile: File " << filePath << " does not contain schema information");
-    fclose(fp);
+    delete anatomicContextRoot;
     return "";
     }
   std::string schema = (*anatomicContextRoot)["@schema"].GetString();
   if (schema.compare(ANATOMIC_CONTEXT_SCHEMA))
     {
     vtkErrorMacro("LoadAnatomicContextFromFile: File " << filePath << " is not an anatomic context file according to its schema");
-    fclose(fp);
+    delete anatomicContextRoot;
     return "";
     }
 
   // Store anatomic context
   std::string contextName = (*anatomicContextRoot)["AnatomicContextName"].GetString();
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+  this->Internal->SetDocumentInTerminologyMap(
     this->Internal->LoadedAnatomicContexts, contextName, anatomicContextRoot);
 
   vtkDebugMacro("Anatomic context named '" << contextName << "' successfully loaded from file " << filePath);
-  fclose(fp);
   this->Modified();
   return contextName;
 }
@@ -1283,7 +1716,7 @@ bool vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromSegmentDescriptor
     }
 
   // Store anatomic context
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+  this->Internal->SetDocumentInTerminologyMap(
     this->Internal->LoadedAnatomicContexts, contextName, convertedDoc );
 
   vtkDebugMacro("Anatomic context named '" << contextName << "' successfully loaded from file " << filePath);
@@ -1420,35 +1853,8 @@ bool vtkSlicerTerminologiesModuleLogic::FindCategoriesInTerminology(std::string
   // Make lowercase for case-insensitive comparison
   std::transform(search.begin(), search.end(), search.begin(), ::tolower);
 
-  // Traverse categories
-  rapidjson::SizeType index = 0;
-  while (index<categoryArray.Size())
-    {
-    rapidjson::Value& category = categoryArray[index];
-    if (category.IsObject())
-      {
-      rapidjson::Value& categoryName = category["CodeMeaning"];
-      rapidjson::Value& categoryCodingSchemeDesignator = category["CodingSchemeDesignator"];
-      rapidjson::Value& categoryCodeValue = category["CodeValue"];
-      if (categoryName.IsString() && categoryCodingSchemeDesignator.IsString() && categoryCodeValue.IsString())
-        {
-        // Add category to list if search string is empty or is contained by the current category name
-        std::string categoryNameStr = categoryName.GetString();
-        std::string categoryNameLowerCase(categoryNameStr);
-        std::transform(categoryNameLowerCase.begin(), categoryNameLowerCase.end(), categoryNameLowerCase.begin(), ::tolower);
-        if (search.empty() || categoryNameLowerCase.find(search) != std::string::npos)
-          {
-          CodeIdentifier categoryId(categoryCodingSchemeDesignator.GetString(), categoryCodeValue.GetString(), categoryNameStr);
-          categories.push_back(categoryId);
-          }
-        }
-      else
-        {
-        vtkErrorMacro("FindCategoriesInTerminology: Invalid category '" << categoryName.GetString() << "' in terminology '" << terminologyName << "'");
-        }
-      }
-    ++index;
-    }
+  // Add categories with names containing the search string (all categories if search string is empty)
+  this->Internal->FindCodesInArray(categoryArray, search, categories);
 
   return true;
 }
@@ -1495,36 +1901,8 @@ bool vtkSlicerTerminologiesModuleLogic::FindTypesInTerminologyCategory(
   // Make lowercase for case-insensitive comparison
   std::transform(search.begin(), search.end(), search.begin(), ::tolower);
 
-  // Traverse types
-  rapidjson::SizeType index = 0;
-  while (index<typeArray.Size())
-    {
-    rapidjson::Value& type = typeArray[index];
-    if (type.IsObject())
-      {
-      rapidjson::Value& typeName = type["CodeMeaning"];
-      rapidjson::Value& typeCodingSchemeDesignator = type["CodingSchemeDesignator"];
-      rapidjson::Value& typeCodeValue = type["CodeValue"];
-      if (typeName.IsString() && typeCodingSchemeDesignator.IsString() && typeCodeValue.IsString())
-        {
-        // Add type to list if search string is empty or is contained by the current type name
-        std::string typeNameStr = typeName.GetString();
-        std::string typeNameLowerCase(typeNameStr);
-        std::transform(typeNameLowerCase.begin(), typeNameLowerCase.end(), typeNameLowerCase.begin(), ::tolower);
-        if (search.empty() || typeNameLowerCase.find(search) != std::string::npos)
-          {
-          CodeIdentifier typeId(typeCodingSchemeDesignator.GetString(), typeCodeValue.GetString(), typeNameStr);
-          types.push_back(typeId);
-          }
-        }
-      else
-        {
-        vtkErrorMacro("FindTypesInTerminologyCategory: Invalid type '" << typeName.GetString() << "in category '"
-          << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
-        }
-      }
-    ++index;
-    }
+  // Add types with names containing the search string (all types if search string is empty)
+  this->Internal->FindCodesInArray(typeArray, search, types);
 
   return true;
 }
@@ -1565,24 +1943,7 @@ bool vtkSlicerTerminologiesModuleLogic::GetTypeModifiersInTerminologyType(
     }
 
   // Collect type modifiers
-  rapidjson::SizeType index = 0;
-  while (index<typeModifierArray.Size())
-    {
-    rapidjson::Value& typeModifier = typeModifierArray[index];
-    if (typeModifier.IsObject())
-      {
-      rapidjson::Value& typeModifierName = typeModifier["CodeMeaning"];
-      rapidjson::Value& typeModifierCodingSchemeDesignator = typeModifier["CodingSchemeDesignator"];
-      rapidjson::Value& typeModifierCodeValue = typeModifier["CodeValue"];
-      if (typeModifierName.IsString() && typeModifierCodingSchemeDesignator.IsString() && typeModifierCodeValue.IsString())
-        {
-        CodeIdentifier typeModifierId(typeModifierCodingSchemeDesignator.GetString(),
-          typeModifierCodeValue.GetString(), typeModifierName.GetString());
-        typeModifiers.push_back(typeModifierId);
-        }
-      }
-    ++index;
-    } // For each type index
+  this->Internal->FindCodesInArray(typeModifierArray, "", typeModifiers);
 
   return true;
 }
@@ -1629,36 +1990,8 @@ bool vtkSlicerTerminologiesModuleLogic::FindRegionsInAnatomicContext(std::string
   // Make lowercase for case-insensitive comparison
   std::transform(search.begin(), search.end(), search.begin(), ::tolower);
 
-  // Traverse regions
-  rapidjson::SizeType index = 0;
-  while (index<regionArray.Size())
-    {
-    rapidjson::Value& region = regionArray[index];
-    if (region.IsObject())
-      {
-      rapidjson::Value& regionName = region["CodeMeaning"];
-      rapidjson::Value& regionCodingSchemeDesignator = region["CodingSchemeDesignator"];
-      rapidjson::Value& regionCodeValue = region["CodeValue"];
-      if (regionName.IsString() && regionCodingSchemeDesignator.IsString() && regionCodeValue.IsString())
-        {
-        // Add region name to list if search string is empty or is contained by the current region name
-        std::string regionNameStr = regionName.GetString();
-        std::string regionNameLowerCase(regionNameStr);
-        std::transform(regionNameLowerCase.begin(), regionNameLowerCase.end(), regionNameLowerCase.begin(), ::tolower);
-        if (search.empty() || regionNameLowerCase.find(search) != std::string::npos)
-          {
-          CodeIdentifier regionId(regionCodingSchemeDesignator.GetString(), regionCodeValue.GetString(), regionNameStr);
-          regions.push_back(regionId);
-          }
-        }
-      else
-        {
-        vtkErrorMacro("FindRegionsInAnatomicContext: Invalid region '" << regionName.GetString()
-          << "' in anatomic context '" << anatomicContextName << "'");
-        }
-      }
-    ++index;
-    }
+  // Add regions with names containing the search string (all regions if search string is empty)
+  this->Internal->FindCodesInArray(regionArray, search, regions);
 
   return true;
 }
@@ -1697,24 +2030,7 @@ bool vtkSlicerTerminologiesModuleLogic::GetRegionModifiersInAnatomicRegion(
     }
 
   // Collect region modifiers
-  rapidjson::SizeType index = 0;
-  while (index<regionModifierArray.Size())
-    {
-    rapidjson::Value& regionModifier = regionModifierArray[index];
-    if (regionModifier.IsObject())
-      {
-      rapidjson::Value& regionModifierName = regionModifier["CodeMeaning"];
-      rapidjson::Value& regionModifierCodingSchemeDesignator = regionModifier["CodingSchemeDesignator"];
-      rapidjson::Value& regionModifierCodeValue = regionModifier["CodeValue"];
-      if (regionModifierName.IsString() && regionModifierCodingSchemeDesignator.IsString() && regionModifierCodeValue.IsString())
-        {
-        CodeIdentifier regionModifierId(regionModifierCodingSchemeDesignator.GetString(),
-          regionModifierCodeValue.GetString(), regionModifierName.GetString());
-          regionModifiers.push_back(regionModifierId);
-        }
-      }
-    ++index;
-    } // For each region index
+  this->Internal->FindCodesInArray(regionModifierArray, "", regionModifiers);
 
   return true;
 }
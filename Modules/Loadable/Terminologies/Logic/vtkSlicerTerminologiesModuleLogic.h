@@ -168,6 +168,12 @@ public:
   vtkGetStringMacro(UserContextsPath);
   vtkSetStringMacro(UserContextsPath);
 
+  /// Directory of the binary cache of the loaded context files.
+  /// Context files are loaded from the cache without parsing Json if the file
+  /// has not changed since the cache was written. No cache is used if empty.
+  vtkGetStringMacro(ContextCachePath);
+  vtkSetStringMacro(ContextCachePath);
+
 protected:
   vtkSlicerTerminologiesModuleLogic();
   virtual ~vtkSlicerTerminologiesModuleLogic();
@@ -185,6 +191,9 @@ protected:
   /// The path from which the json files are automatically loaded on startup
   char* UserContextsPath;
 
+  /// The path where the binary cache of the context files is stored
+  char* ContextCachePath;
+
 private:
   vtkSlicerTerminologiesModuleLogic(const vtkSlicerTerminologiesModuleLogic&); // Not implemented
   void operator=(const vtkSlicerTerminologiesModuleLogic&);              // Not implemented
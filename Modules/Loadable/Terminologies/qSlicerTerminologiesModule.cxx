@@ -127,6 +127,8 @@ vtkMRMLAbstractLogic* qSlicerTerminologiesModule::createLogic()
   // Setup logic
   vtkSlicerTerminologiesModuleLogic* logic = vtkSlicerTerminologiesModuleLogic::New();
   logic->SetUserContextsPath(settingsDirPath.toLatin1().constData());
+  logic->SetContextCachePath(QDir(qSlicerCoreApplication::application()->temporaryPath()).
+    absoluteFilePath("Terminologies").toLatin1().constData());
 
   return logic;
 }
@@ -22,16 +22,52 @@
 #include "vtkPichonFastMarching.h"
 #include "vtkPointData.h"
 #include "vtkDataArray.h"
+#include <vtkMultiThreader.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 
+#include <cstring>
+
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 
-// used to compute the median
-int compareInt(const void *a, const void *b)
+namespace
+{
+
+// compute median intensity and inhomogeneity of the 27-neighborhood of the given voxels
+struct MedianInhomoJob
+{
+  const short* indata;
+  const int* arrayShiftNeighbor;
+  std::vector<int> indices;
+  std::vector<int*> inhomo; // where to store the result for each index
+  std::vector<int*> median;
+};
+
+void computeMedianInhomo(const short* indata, const int* arrayShiftNeighbor, int index, int &med, int &inh)
 {
-  return  (*(int*)a) - (*(int*)b);
+  int neighborhood[27];
+  for(int k=0;k<=26;k++)
+    neighborhood[k] = (int)indata[index + arrayShiftNeighbor[k]];
+
+  std::sort( neighborhood, neighborhood+27 );
+
+  inh = (neighborhood[21] - neighborhood[5]);
+  med = neighborhood[13];
+}
+
+VTK_THREAD_RETURN_TYPE medianInhomoThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  MedianInhomoJob* job = static_cast<MedianInhomoJob*>(info->UserData);
+  size_t n = job->indices.size();
+  size_t begin = n * info->ThreadID / info->NumberOfThreads;
+  size_t end = n * (info->ThreadID + 1) / info->NumberOfThreads;
+  for(size_t k=begin;k<end;k++)
+    computeMedianInhomo(job->indata, job->arrayShiftNeighbor, job->indices[k], *(job->median[k]), *(job->inhomo[k]));
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -40,6 +76,115 @@ int compareInt(const void *a, const void *b)
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkPichonFastMarching);
 
+//------------------------------------------------------------------------------
+inline FMpage* vtkPichonFastMarching::getPage( int index )
+{
+  FMpage* page = pages[ index >> PAGE_SHIFT ];
+  if( page!=NULL )
+    return page;
+
+  // initialize the page: this was done for the whole volume in the first execution
+  // before, now only the region reached by the expansion is allocated
+  page = new FMpage;
+  pages[ index >> PAGE_SHIFT ] = page;
+  int firstIndex = (index >> PAGE_SHIFT) << PAGE_SHIFT;
+  for(int p=0;p<(1 << PAGE_SHIFT);p++)
+    {
+      int voxelIndex = firstIndex + p;
+      page->node[p].T=(float)INF;
+      page->inhomo[p]=-1; // meaning inhomo and median have not been computed there
+      page->median[p]=0;
+
+      if( voxelIndex>=dimXYZ )
+        {
+          page->node[p].status=fmsOUT;
+          continue;
+        }
+
+      int i = voxelIndex % dimX;
+      int j = (voxelIndex / dimX) % dimY;
+      int k = voxelIndex / dimXY;
+      if( isBoundary(i, j, k) )
+        {
+          page->node[p].status=fmsOUT;
+
+          // we should never have to look at these values anyway !
+          page->inhomo[p] = depth;
+          page->median[p] = 0;
+        }
+      else if( (outdata==NULL) || (outdata[voxelIndex]==0) )
+        page->node[p].status=fmsFAR;
+      else
+        page->node[p].status=fmsDONE;
+    }
+
+  return page;
+}
+
+//------------------------------------------------------------------------------
+inline FMnode& vtkPichonFastMarching::getNode( int index )
+{
+  return getPage(index)->node[ index & ((1 << PAGE_SHIFT)-1) ];
+}
+
+//------------------------------------------------------------------------------
+inline bool vtkPichonFastMarching::isBoundary(int i, int j, int k)
+{
+  return (i<BAND_OUT) || (j<BAND_OUT) ||  (k<BAND_OUT) ||
+    (i>=(dimX-BAND_OUT)) || (j>=(dimY-BAND_OUT)) || (k>=(dimZ-BAND_OUT));
+}
+
+//------------------------------------------------------------------------------
+void vtkPichonFastMarching::freePages( void )
+{
+  for(size_t p=0;p<pages.size();p++)
+    {
+      delete pages[p];
+      pages[p]=NULL;
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkPichonFastMarching::collectInfoSeeds( const VecInt& indices )
+{
+  // the neighborhood statistics are computed in parallel, then added to the
+  // pdfs in the original order, so the result is the same as calling
+  // collectInfoSeed for each index
+  MedianInhomoJob job;
+  job.indata = indata;
+  job.arrayShiftNeighbor = arrayShiftNeighbor;
+
+  VecInt uniqueIndices(indices);
+  std::sort(uniqueIndices.begin(), uniqueIndices.end());
+  uniqueIndices.erase(std::unique(uniqueIndices.begin(), uniqueIndices.end()), uniqueIndices.end());
+  for(size_t k=0;k<uniqueIndices.size();k++)
+    {
+      // pages are allocated here, threads only write the computed values
+      FMpage* page = getPage( uniqueIndices[k] );
+      int offset = uniqueIndices[k] & ((1 << PAGE_SHIFT)-1);
+      if( page->inhomo[offset] != (-1) )
+        continue;
+      job.indices.push_back( uniqueIndices[k] );
+      job.inhomo.push_back( &(page->inhomo[offset]) );
+      job.median.push_back( &(page->median[offset]) );
+    }
+
+  if( job.indices.size()>0 )
+    {
+      int nThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+      if( (int)job.indices.size() < nThreads*64 )
+        nThreads = 1;
+      vtkMultiThreader* threader = vtkMultiThreader::New();
+      threader->SetNumberOfThreads(nThreads);
+      threader->SetSingleMethod(medianInhomoThreadFunction, &job);
+      threader->SingleMethodExecute();
+      threader->Delete();
+    }
+
+  for(size_t k=0;k<indices.size();k++)
+    collectInfoSeed( indices[k] );
+}
+
 //------------------------------------------------------------------------------
 void vtkPichonFastMarching::collectInfoSeed( int index )
 {
@@ -103,15 +248,15 @@ void vtkPichonFastMarching::setSeed( int index )
       return;
     }
 
-  if( node[index].status!=fmsFAR )
+  if( getNode(index).status!=fmsFAR )
     {
       // this seed has already been planted
       return;
     }
 
   // by definition, T=0, and that voxel is known
-  node[index].T=0.0;
-  node[index].status=fmsKNOWN;
+  getNode(index).T=0.0;
+  getNode(index).status=fmsKNOWN;
 
   knownPoints.push_back(index);
 
@@ -120,12 +265,13 @@ void vtkPichonFastMarching::setSeed( int index )
     {
       FMleaf f;
       f.nodeIndex=index + shiftNeighbor(n);
-      if( node[ f.nodeIndex ].status==fmsFAR )
+      if( getNode( f.nodeIndex ).status==fmsFAR )
     {
-      node[f.nodeIndex].status=fmsTRIAL;
-      node[f.nodeIndex].T = (float) ( distanceNeighbor(n) / speed(f.nodeIndex) );
+      getNode(f.nodeIndex).status=fmsTRIAL;
+      getNode(f.nodeIndex).T = (float) ( distanceNeighbor(n) / speed(f.nodeIndex) );
+      f.T=getNode(f.nodeIndex).T;
 
-      insert( f ); // insert in minheap
+      insert( f ); // insert in narrow band
     }
     }
 }
@@ -134,22 +280,20 @@ inline void vtkPichonFastMarching::getMedianInhomo( int index, int &med, int &in
 {
   // assert( (index>=(1+dimX+dimXY)) && (index<(dimXYZ-1-dimX-dimXY)) );
 
-  inh = inhomo[index];
+  FMpage* page = getPage(index);
+  int offset = index & ((1 << PAGE_SHIFT)-1);
+  inh = page->inhomo[offset];
   if( inh != (-1) )
     // then the values have already been computed
     {
-      med = median[index];
+      med = page->median[offset];
       return;
     }
 
   // otherwise, just do it
-  for(int k=0;k<=26;k++)
-      tmpNeighborhood[k] = (int)indata[index + arrayShiftNeighbor[k]];
-
-  qsort( (void*)tmpNeighborhood, 27, sizeof(int), &compareInt );
-
-  inh = inhomo[ index ] = (tmpNeighborhood[21] - tmpNeighborhood[5]);
-  med = median[ index ] = tmpNeighborhood[13];
+  computeMedianInhomo( indata, arrayShiftNeighbor, index, med, inh );
+  page->inhomo[offset] = inh;
+  page->median[offset] = med;
 
   /*
     // same thing for 125-neighbors
@@ -165,8 +309,8 @@ inline void vtkPichonFastMarching::getMedianInhomo( int index, int &med, int &in
 
     qsort( (void*)tmpNeighborhood, 125, sizeof(int), &compareInt );
 
-    inh = inhomo[ index ] = (tmpNeighborhood[105] - tmpNeighborhood[20]);
-    med = median[ index ] = tmpNeighborhood[63];
+    inh = page->inhomo[offset] = (tmpNeighborhood[105] - tmpNeighborhood[20]);
+    med = page->median[offset] = tmpNeighborhood[63];
   */
 }
 
@@ -179,12 +323,17 @@ void vtkPichonFastMarching::initNewExpansion( void )
   pdfInhomoIn->reset();
 
   // empty interface points
-  while(tree.size()>0)
-    {
-      node[ tree[tree.size()-1].nodeIndex ].status=fmsFAR;
-      node[ tree[tree.size()-1].nodeIndex ].T=(float)INF;
-      tree.pop_back();
-    }
+  for(int b=0;b<33;b++)
+    for(size_t e=0;e<buckets[b].size();e++)
+      {
+        FMnode& n = getNode( buckets[b][e].nodeIndex );
+        if( n.status==fmsTRIAL )
+          {
+            n.status=fmsFAR;
+            n.T=(float)INF;
+          }
+      }
+  clearTree();
 
   // empty the list of known points
   while(knownPoints.size()>0)
@@ -198,14 +347,16 @@ void vtkPichonFastMarching::initNewExpansion( void )
   while(seedPoints.size()>0)
     seedPoints.pop_back();
 
+  VecInt labelPoints;
   int index=0;
   for(int k=0;k<dimZ;k++)
     for(int j=0;j<dimY;j++)
       for(int i=0;i<dimX;i++)
     {
-      if( (outdata[index]==label) && (node[index].status!=fmsOUT) )
+      // check the label first so that pages are only allocated around the label
+      if( (outdata[index]==label) && !isBoundary(i, j, k) )
         {
-            collectInfoSeed( index );
+            labelPoints.push_back( index );
             for(int n=1;n<nNeighbors;n++)
             if(outdata[index+shiftNeighbor(n)]==0)
               {
@@ -223,13 +374,13 @@ void vtkPichonFastMarching::initNewExpansion( void )
 
           if(hasIntensityZeroNeighbor)
         {
-          node[index].status=fmsFAR;
+          getNode(index).status=fmsFAR;
           seedPoints.push_back( index );
         }
           else
         {
-          node[index].status=fmsDONE;
-          node[index].T=0.0;
+          getNode(index).status=fmsDONE;
+          getNode(index).T=0.0;
         }
 */
 
@@ -237,6 +388,9 @@ void vtkPichonFastMarching::initNewExpansion( void )
 
       index++;
     }
+
+  // statistics of the labeled region
+  collectInfoSeeds( labelPoints );
 }
 
 int vtkPichonFastMarching::nValidSeeds( void )
@@ -244,7 +398,7 @@ int vtkPichonFastMarching::nValidSeeds( void )
   if(somethingReallyWrong)
     return 0;
 
-  return (int)(seedPoints.size()+tree.size());
+  return (int)(seedPoints.size()+queueSize);
 }
 
 int vtkPichonFastMarching::nKnownPoints(void)
@@ -271,46 +425,10 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
     {
     self->initialized = true;
 
-    int index=0;
-    int lastPercentageProgressBarUpdated=-1;
-
-
-    for(k=0;k<self->dimZ;k++)
-      for(int j=0;j<self->dimY;j++)
-        for(int i=0;i<self->dimX;i++)
-          {
-
-          self->node[index].T=(float)INF;
-
-          if(self->outdata[index]==0)
-            self->node[index].status=fmsFAR;
-          else
-            self->node[index].status=fmsDONE;
-
-          self->inhomo[index]=-1; // meaning inhomo and median have not been computed there
-
-          if( (i<BAND_OUT) || (j<BAND_OUT) ||  (k<BAND_OUT) ||
-            (i>=(self->dimX-BAND_OUT)) || (j>=(self->dimY-BAND_OUT)) || (k>=(self->dimZ-BAND_OUT)) )
-            {
-
-            // update progress bar
-            int currentPercentage = GRANULARITY_PROGRESS*index / self->dimXYZ;
-
-            if( currentPercentage > lastPercentageProgressBarUpdated )
-              {
-              lastPercentageProgressBarUpdated = currentPercentage;
-              self->UpdateProgress(float(currentPercentage)/float(GRANULARITY_PROGRESS));
-              }
-
-            self->node[index].status=fmsOUT;
-
-            // we should never have to look at these values anyway !
-            self->inhomo[ index ] = self->depth;
-            self->median[ index ] = 0;
-            }
-
-          index++;
-          }
+    // node data is initialized when the expansion first reaches it,
+    // discard what was computed before the input was available
+    self->freePages();
+    self->clearTree();
 
     return;
     }
@@ -327,12 +445,21 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
       self->firstCall=true; // we did not complete this step
       return;
       }
-    for(k=0;k<(int)self->seedPoints.size();k++)
-      self->collectInfoSeed( self->seedPoints[k] );
+    // statistics of seeds that were added before the input was available
+    self->collectInfoSeeds( self->pendingSeedInfo );
+    self->pendingSeedInfo.clear();
+
+    self->collectInfoSeeds( self->seedPoints );
 
     self->pdfIntensityIn->update();
     self->pdfInhomoIn->update();
     }
+  else if( self->pendingSeedInfo.size()>0 )
+    {
+    // seeds added after the first evolution
+    self->collectInfoSeeds( self->pendingSeedInfo );
+    self->pendingSeedInfo.clear();
+    }
 
   if(self->nPointsEvolution<=0)
     // then we have nothing to do and we have just been called to update the pipeline
@@ -343,26 +470,33 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
     if( (self->knownPoints.size()>1) &&
       ((signed)self->knownPoints.size()-1>self->nPointsBeforeLeakEvolution) )
       {
+      // arrival times of the points put back in the queue are lower than
+      // the last removed one, the queue has to accept them
+      self->rebuildTree(0);
+
       // reinitialize all the points
       for(k=self->nPointsBeforeLeakEvolution;k<(int)self->knownPoints.size();k++)
         {
         int index = self->knownPoints[k];
-        self->node[ index ].status = fmsFAR;
-        self->node[ index ].T = (float)INF;
+        self->getNode( index ).status = fmsFAR;
+        self->getNode( index ).T = (float)INF;
 
         /*
            we also want to remove the neighbors of these points that would be in TRIAL
-           as it is not trivial to remove points from the minheap, we will just set their T
-           to infinity to make sure they appear in the back of the heap
+           as it is not trivial to remove points from the queue, we will just set their T
+           to infinity to make sure they appear in the back of the queue
          */
 
         for(n=1;n<=self->nNeighbors;n++)
           {
           int indexN=index+self->shiftNeighbor(n);
-          if( self->node[indexN].status==fmsTRIAL )
+          if( (self->getNode(indexN).status==fmsTRIAL) && (self->getNode(indexN).T!=(float)INF) )
             {
-            self->node[indexN].T=(float)INF;
-            self->downTree( self->node[indexN].leafIndex );
+            FMleaf f;
+            self->getNode(indexN).T=(float)INF;
+            f.nodeIndex=indexN;
+            f.T=(float)INF;
+            self->updateTree( f );
             }
           }
         }
@@ -377,17 +511,18 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
         for(n=1;n<=self->nNeighbors;n++)
           {
           indexN=index+self->shiftNeighbor(n);
-          if( self->node[indexN].status==fmsKNOWN )
+          if( self->getNode(indexN).status==fmsKNOWN )
             hasKnownNeighbor=true;
           }
 
-        if( (hasKnownNeighbor) && (self->node[index].status!=fmsOUT) )
+        if( (hasKnownNeighbor) && (self->getNode(index).status!=fmsOUT) )
           {
           FMleaf f;
 
-          self->node[index].T=self->computeT(index);
-          self->node[index].status=fmsTRIAL;
+          self->getNode(index).T=self->computeT(index);
+          self->getNode(index).status=fmsTRIAL;
           f.nodeIndex=index;
+          f.T=self->getNode(index).T;
 
           self->insert( f );
           }
@@ -423,13 +558,18 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
   for(n=0;n<self->nPointsEvolution;n++)
     {
     if( (n*GRANULARITY_PROGRESS) % self->nPointsEvolution == 0 )
+      {
       self->UpdateProgress(float(n)/float(self->nPointsEvolution));
+      // allow the user to stop the expansion (e.g., when the target volume is reached)
+      if( self->GetAbortExecute() )
+        break;
+      }
 
     float T=self->step();
 
     // all the statistics should be gathered from a band 3 pixels from the interface
-    self->pdfIntensityIn->setMemory((int)(5*self->tree.size()));
-    self->pdfInhomoIn->setMemory((int)(5*self->tree.size()));
+    self->pdfIntensityIn->setMemory((int)(5*self->queueSize));
+    self->pdfInhomoIn->setMemory((int)(5*self->queueSize));
 
     if( T==INF )
       {
@@ -472,14 +612,14 @@ void vtkPichonFastMarching::show(float r)
   if( newIndex > oldIndex )
     for(int index=(oldIndex+1);index<=newIndex;index++)
       {
-    if( node[ knownPoints[index] ].status==fmsKNOWN )
+    if( getNode( knownPoints[index] ).status==fmsKNOWN )
         if(outdata[ knownPoints[index] ]==0)
           outdata[ knownPoints[index] ]=label;
       }
   else if( newIndex < oldIndex )
     for(int index=oldIndex;index>newIndex;index--)
       {
-    if(node[ knownPoints[index] ].status==fmsKNOWN )
+    if(getNode( knownPoints[index] ).status==fmsKNOWN )
         if(outdata[ knownPoints[index] ]==label)
           outdata[ knownPoints[index] ]=0;
       }
@@ -552,173 +692,246 @@ void vtkPichonFastMarching::PrintSelf(ostream& os, vtkIndent indent)
 
 bool vtkPichonFastMarching::emptyTree(void)
 {
-  return (tree.size()==0);
+  if( legacyNarrowBand )
+    return (tree.size()==0);
+  return (queueSize==0);
 }
 
-void vtkPichonFastMarching::insert(const FMleaf leaf) {
-
-  // insert element at the back
-  tree.push_back( leaf );
-  node[ leaf.nodeIndex ].leafIndex=(int)(tree.size()-1);
-
-  // trickle the element up until everything
-  // is sorted again
-  upTree( (int)(tree.size()-1) );
+/*
+ * The narrow band is a monotone radix bucket queue: arrival times of removed
+ * points never decrease, so entries only need to be sorted relative to the
+ * last removed key. Insertion is O(1) and each entry is moved at most 32 times
+ * before it is removed, instead of the O(log n) sift of a binary heap.
+ * Entries are not moved when the arrival time of a point decreases: a new entry
+ * is inserted and the old one is skipped when it is removed.
+ */
+
+static inline unsigned int floatKey(float T)
+{
+  // bit pattern of a non-negative float has the same order as its value
+  unsigned int key;
+  memcpy(&key, &T, sizeof(key));
+  return key;
 }
 
-bool vtkPichonFastMarching::minHeapIsSorted( void )
+inline int vtkPichonFastMarching::bucketIndex(unsigned int key)
 {
-  int N=(int)tree.size();
-  int k;
-
-  for(k=(N-1);k>=1;k--)
-    {
-      if(node[tree[k].nodeIndex].leafIndex!=k)
+  if( key<=lastKey )
+    return 0;
+  unsigned int diff = key ^ lastKey;
+  int b = 0;
+  while( diff!=0 )
     {
-      vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
-             << "tree[" << k << "] : pb leafIndex/nodeIndex (size="
-             << (unsigned int)tree.size() << ")" );
-    }
+      diff >>= 1;
+      b++;
     }
-  for(k=(N-1);k>=1;k--)
+  return b;
+}
+
+void vtkPichonFastMarching::insert(const FMleaf leaf)
+{
+  if( legacyNarrowBand )
     {
-      if( finite( node[tree[k].nodeIndex].T)==0 )
-    vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
-               << "NaN or Inf value in minHeap : " << node[tree[k].nodeIndex].T );
+      // insert element at the back and trickle it up
+      tree.push_back( leaf );
+      leafIndex[ leaf.nodeIndex ]=(int)(tree.size()-1);
+      upTree( (int)(tree.size()-1) );
+      queueSize++;
+      return;
+    }
+
+  // computed arrival times may be very slightly lower than the last removed one
+  // due to rounding, these points are removed next (as they would be from a heap)
+  buckets[ bucketIndex( floatKey(leaf.T) ) ].push_back( leaf );
+  queueSize++;
+}
 
-      if( node[tree[k].nodeIndex].T<node[ (int)(tree[(k-1)/2].nodeIndex) ].T )
+void vtkPichonFastMarching::updateTree(const FMleaf leaf)
+{
+  if( legacyNarrowBand )
     {
-      vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
-             << "minHeapIsSorted is false! : size=" << (unsigned int)tree.size() << "at leafIndex=" << k
-             << " node[tree[k].nodeIndex].T=" << node[tree[k].nodeIndex].T
-             << "<node[ (int)(tree[(k-1)/2].nodeIndex) ].T=" << node[ (int)(tree[(k-1)/2].nodeIndex) ].T);
+      // the arrival time of the node is already updated, move its leaf
+      upTree( leafIndex[ leaf.nodeIndex ] );
+      downTree( leafIndex[ leaf.nodeIndex ] );
+      return;
+    }
 
-      return false;
+  // the point is already in the narrow band, its previous entry becomes obsolete
+  insert( leaf );
+  queueSize--;
+}
+
+void vtkPichonFastMarching::clearTree(void)
+{
+  for(int b=0;b<33;b++)
+    buckets[b].clear();
+  tree.clear();
+  lastKey=0;
+  queueSize=0;
+}
+
+void vtkPichonFastMarching::rebuildTree(unsigned int newLastKey)
+{
+  // needed when points are put back in the queue with lower arrival time
+  // than the last removed point (user went back in the evolution)
+  if( legacyNarrowBand )
+    // the heap accepts any arrival time
+    return;
+
+  VecFMleaf entries;
+  for(int b=0;b<33;b++)
+    {
+      entries.insert( entries.end(), buckets[b].begin(), buckets[b].end() );
+      buckets[b].clear();
     }
+  lastKey=newLastKey;
+  for(size_t e=0;e<entries.size();e++)
+    buckets[ bucketIndex( floatKey(entries[e].T) ) ].push_back( entries[e] );
+}
+
+bool vtkPichonFastMarching::minHeapIsSorted( void )
+{
+  if( legacyNarrowBand )
+    {
+      for(int k=(int)tree.size()-1;k>=1;k--)
+        {
+          if( leafIndex[ tree[k].nodeIndex ]!=k )
+            vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
+                           << "tree[" << k << "] : pb leafIndex/nodeIndex (size="
+                           << (unsigned int)tree.size() << ")" );
+          if( getNode( tree[k].nodeIndex ).T<getNode( tree[(k-1)/2].nodeIndex ).T )
+            {
+              vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
+                             << "minHeapIsSorted is false! : size=" << (unsigned int)tree.size()
+                             << " at leafIndex=" << k );
+              return false;
+            }
+        }
+      return true;
     }
+
+  for(int b=0;b<33;b++)
+    for(size_t e=0;e<buckets[b].size();e++)
+      {
+        const FMleaf& f=buckets[b][e];
+        if( finite( f.T )==0 )
+          vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
+                         << "NaN or Inf value in queue : " << f.T );
+
+        if( (b>0) && (bucketIndex( floatKey(f.T) )!=b) )
+          {
+            vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
+                           << "queue is not sorted! : size=" << queueSize << " at bucket=" << b
+                           << " T=" << f.T << " is in bucket " << bucketIndex( floatKey(f.T) ) );
+            return false;
+          }
+      }
   return true;
 }
 
-void vtkPichonFastMarching::downTree(int index) {
-  /*
-   * This routine sweeps downward from leaf 'index',
-   * swapping child and parent if the value of the child
-   * is smaller than that of the parent. Note that this only
-   * guarantees the heap property if the value at the
-   * starting index is greater than all its parents.
-   */
-  int LeftChild = 2 * index + 1;
-  int RightChild = 2 * index + 2;
+FMleaf vtkPichonFastMarching::removeSmallest( void )
+{
+  if( legacyNarrowBand )
+    {
+      // move the bottom, rightmost, leaf to the root and trickle it down
+      FMleaf f=tree[0];
+      f.T=getNode( f.nodeIndex ).T;
+      tree[0]=tree[ tree.size()-1 ];
+      leafIndex[ tree[0].nodeIndex ]=0;
+      tree.pop_back();
+      downTree( 0 );
+      queueSize--;
+      return f;
+    }
 
-  while (LeftChild < (int)tree.size())
+  while( queueSize>0 )
     {
-      /*
-       * Terminate the process when the current leaf has no
-       * children. If no swap occurs at a higher leaf, this
-       * condition is forced.
-       */
+      if( buckets[0].empty() )
+        {
+          // find the first non-empty bucket, its smallest key becomes the last key
+          // and its entries are redistributed in lower buckets
+          int b=1;
+          while( (b<33) && buckets[b].empty() )
+            b++;
+          if( b==33 )
+            {
+              vtkErrorMacro( "Error in vtkPichonFastMarching::removeSmallest(): "
+                             << "queue is empty, size=" << queueSize );
+              queueSize=0;
+              break;
+            }
 
-      /*
-       * Find the child with the smallest value. The node has at least
-       * one child, and so has at least a left child.
-       */
-      int MinChild = LeftChild;
+          VecFMleaf entries;
+          entries.swap( buckets[b] );
+          unsigned int minKey=floatKey( entries[0].T );
+          for(size_t e=1;e<entries.size();e++)
+            if( floatKey( entries[e].T )<minKey )
+              minKey=floatKey( entries[e].T );
+          lastKey=minKey;
+          for(size_t e=0;e<entries.size();e++)
+            buckets[ bucketIndex( floatKey(entries[e].T) ) ].push_back( entries[e] );
+        }
 
-      /*
-       * If the node has a right child, and if the right child
-       * has smaller crossing time than the left child, then the
-       * right child is the MinChild.
-       */
-      if (RightChild < (int)tree.size()) {
+      FMleaf f=buckets[0].back();
+      buckets[0].pop_back();
 
-    if (node[tree[LeftChild].nodeIndex].T>
-        node[tree[RightChild].nodeIndex].T)
-      MinChild = RightChild;
-      }
+      // skip obsolete entries
+      FMnode& n=getNode( f.nodeIndex );
+      if( (n.status==fmsTRIAL) && (n.T==f.T) )
+        {
+          queueSize--;
+          return f;
+        }
+    }
 
-      /*
-       * If the MinChild has smaller T than the current leaf,
-       * swap them, and move the current leaf to the MinChild.
-       */
-      if (node[tree[MinChild].nodeIndex].T<
-      node[tree[index].nodeIndex].T)
+  FMleaf none;
+  none.nodeIndex=-1;
+  none.T=(float)INF;
+  return none;
+}
+
+void vtkPichonFastMarching::downTree(int index)
+{
+  // swap the leaf with its smallest child until it is not larger than its children
+  int LeftChild = 2 * index + 1;
+  while( LeftChild < (int)tree.size() )
     {
+      int MinChild = LeftChild;
+      if( (LeftChild + 1 < (int)tree.size())
+          && (getNode( tree[LeftChild].nodeIndex ).T > getNode( tree[LeftChild + 1].nodeIndex ).T) )
+        MinChild = LeftChild + 1;
+
+      if( getNode( tree[MinChild].nodeIndex ).T >= getNode( tree[index].nodeIndex ).T )
+        break;
+
       FMleaf tmp=tree[index];
       tree[index]=tree[MinChild];
       tree[MinChild]=tmp;
-
-      // make sure pointers remain correct
-      node[ tree[MinChild].nodeIndex ].leafIndex = MinChild;
-      node[ tree[index].nodeIndex ].leafIndex = index;
+      leafIndex[ tree[MinChild].nodeIndex ] = MinChild;
+      leafIndex[ tree[index].nodeIndex ] = index;
 
       index = MinChild;
-
       LeftChild = 2 * index + 1;
-      RightChild =  LeftChild + 1;
-    }
-      else
-    /*
-     * If the current leaf has a lower value than its
-     * MinChild, the job is done, force a stop.
-     */
-    break;
     }
 }
 
-void vtkPichonFastMarching::upTree(int index) {
-  /*
-   * This routine sweeps upward from leaf 'index',
-   * swapping child and parent if the value of the child
-   * is less than that of the parent. Note that this only
-   * guarantees the heap property if the value at the
-   * starting leaf is less than all its children.
-   */
+void vtkPichonFastMarching::upTree(int index)
+{
+  // swap the leaf with its parent until it is not smaller than its parent
   while( index>0 )
     {
-      int upIndex = (int) (index-1)/2;
-
-      if( node[tree[index].nodeIndex].T <
-      node[tree[upIndex].nodeIndex].T )
-    {
-      // then swap the 2 nodes
+      int upIndex = (index-1)/2;
+      if( getNode( tree[index].nodeIndex ).T >= getNode( tree[upIndex].nodeIndex ).T )
+        break;
 
       FMleaf tmp=tree[index];
       tree[index]=tree[upIndex];
       tree[upIndex]=tmp;
-
-      // make sure pointers remain correct
-      node[ tree[upIndex].nodeIndex ].leafIndex = upIndex;
-      node[ tree[index].nodeIndex ].leafIndex = index;
+      leafIndex[ tree[upIndex].nodeIndex ] = upIndex;
+      leafIndex[ tree[index].nodeIndex ] = index;
 
       index = upIndex;
     }
-      else
-    // then there is nothing left to do
-    // force stop
-    break;
-    }
-}
-
-FMleaf vtkPichonFastMarching::removeSmallest( void ) {
-
-  FMleaf f;
-  f=tree[0];
-
-  /*
-   * Now move the bottom, rightmost, leaf to the root.
-   */
-  tree[0]=tree[ tree.size()-1 ];
-
-  // make sure pointers remain correct
-  node[ tree[0].nodeIndex ].leafIndex = 0;
-
-  tree.pop_back();
-
-  // trickle the element down until everything
-  // is sorted again
-  downTree( 0 );
-
-  return f;
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -728,6 +941,12 @@ vtkPichonFastMarching::vtkPichonFastMarching()
 {
   initialized=false;
   somethingReallyWrong=true;
+  indata=NULL;
+  outdata=NULL;
+  lastKey=0;
+  queueSize=0;
+  dimXYZ=0;
+  legacyNarrowBand=false;
 }
 
 void vtkPichonFastMarching::init(int _dimX, int _dimY, int _dimZ, double _depth, double _dx, double _dy, double _dz)
@@ -814,29 +1033,13 @@ void vtkPichonFastMarching::init(int _dimX, int _dimY, int _dimZ, double _depth,
 
   this->depth = (int) _depth;
 
-  node = new FMnode[ dimX*dimY*dimZ ];
-  // assert( node!=NULL );
-  if(!(node!=NULL))
-    {
-      vtkErrorMacro("Error in void vtkPichonFastMarching::init(), not enough memory for allocation of 'node'");
-      return;
-    }
-
-  inhomo = new int[ dimX*dimY*dimZ ];
-  //  assert( inhomo!=NULL );
-  if(!(inhomo!=NULL))
-    {
-      vtkErrorMacro("Error in void vtkPichonFastMarching::init(), not enough memory for allocation of 'inhomo'");
-      return;
-    }
-
-  median = new int[ dimX*dimY*dimZ ];
-  //  assert( median!=NULL );
-  if(!(median!=NULL))
-    {
-      vtkErrorMacro("Error in void vtkPichonFastMarching::init(), not enough memory for allocation of 'median'");
-      return;
-    }
+  // node data is allocated by pages when the expansion reaches them
+  freePages();
+  pages.assign( (dimXYZ >> PAGE_SHIFT) + 1, (FMpage*)NULL );
+  if( legacyNarrowBand )
+    leafIndex.assign( dimXYZ, -1 );
+  clearTree();
+  pendingSeedInfo.clear();
 
   pdfIntensityIn = new vtkPichonFastMarchingPDF( (int) _depth );
   if(!(pdfIntensityIn!=NULL))
@@ -873,6 +1076,7 @@ void vtkPichonFastMarching::setOutData(short* data)
 vtkPichonFastMarching::~vtkPichonFastMarching()
 {
   /* all the delete are done by unInit() */
+  freePages();
 }
 
 inline int vtkPichonFastMarching::shiftNeighbor(int n)
@@ -901,9 +1105,9 @@ int vtkPichonFastMarching::indexFather(int n )
   for(int k=1;k<=6;k++)
   {
     index = n+shiftNeighbor(k);
-    if( node[index].T<Tmin )
+    if( getNode(index).T<Tmin )
     {
-      Tmin = node[index].T;
+      Tmin = getNode(index).T;
       indexMin = index;
     }
   }
@@ -940,9 +1144,13 @@ float vtkPichonFastMarching::step( void )
 
   min=removeSmallest();
 
-  if( node[min.nodeIndex].T>=INF )
+  if( min.nodeIndex<0 )
+    // only obsolete entries were left in the queue
+    return (float)INF;
+
+  if( getNode(min.nodeIndex).T>=INF )
     {
-      vtkErrorMacro( " node[min.nodeIndex].T>=INF " << endl );
+      vtkErrorMacro( " getNode(min.nodeIndex).T>=INF " << endl );
 
       // this would happen if the only points left were artificially put back
       // by the user playing with the slider
@@ -957,7 +1165,7 @@ float vtkPichonFastMarching::step( void )
   pdfIntensityIn->addRealization( I );
   pdfInhomoIn->addRealization( H );
 
-  node[min.nodeIndex].status=fmsKNOWN;
+  getNode(min.nodeIndex).status=fmsKNOWN;
   knownPoints.push_back(min.nodeIndex);
 
   /* then we consider all the neighbors */
@@ -970,39 +1178,43 @@ float vtkPichonFastMarching::step( void )
       /*
        * Check the status of the neighbors. If
        * they are fmsTRIAL, recompute their crossing time values and
-       * adjust their position in the tree with an UpHeap (Note that
+       * queue them again if it changed (Note that
        * recomputed value must be less than or equal to the original).
        * If they are fmsFAR, recompute their crossing times, and move
        * them into fmsTRIAL.
        */
-      if( node[indexN].status==fmsFAR )
+      if( getNode(indexN).status==fmsFAR )
     {
       FMleaf f;
-      node[indexN].T=computeT(indexN);
+      getNode(indexN).T=computeT(indexN);
       f.nodeIndex=indexN;
+      f.T=getNode(indexN).T;
 
       insert( f );
 
-      node[indexN].status=fmsTRIAL;
+      getNode(indexN).status=fmsTRIAL;
     }
-      else if( node[indexN].status==fmsTRIAL )
+      else if( getNode(indexN).status==fmsTRIAL )
     {
       float t1,  t2;
-      t1 = node[indexN].T;
+      t1 = getNode(indexN).T;
 
-      node[indexN].T=computeT(indexN);
+      getNode(indexN).T=computeT(indexN);
 
-      t2 = node[indexN].T;
+      t2 = getNode(indexN).T;
 
-      if( t2<t1 )
-          upTree( node[indexN].leafIndex );
-      else
-          downTree( node[indexN].leafIndex );
+      if( t2!=t1 )
+        {
+          FMleaf f;
+          f.nodeIndex=indexN;
+          f.T=t2;
+          updateTree( f );
+        }
 
     }
     }
 
-  return node[min.nodeIndex].T;
+  return getNode(min.nodeIndex).T;
 }
 
 float vtkPichonFastMarching::computeT(int index )
@@ -1027,16 +1239,16 @@ float vtkPichonFastMarching::computeT(int index )
 
   double Tij, Txm, Txp, Tym, Typ, Tzm, Tzp, TijNew;
 
-  Tij = node[index].T;
+  Tij = getNode(index).T;
 
   /* we know that all neighbors are defined
      because this node is not fmsOUT */
-  Txm = node[index+shiftNeighbor(4)].T;
-  Txp = node[index+shiftNeighbor(2)].T;
-  Tym = node[index+shiftNeighbor(1)].T;
-  Typ = node[index+shiftNeighbor(3)].T;
-  Tzm = node[index+shiftNeighbor(5)].T;
-  Tzp = node[index+shiftNeighbor(6)].T;
+  Txm = getNode(index+shiftNeighbor(4)).T;
+  Txp = getNode(index+shiftNeighbor(2)).T;
+  Tym = getNode(index+shiftNeighbor(1)).T;
+  Typ = getNode(index+shiftNeighbor(3)).T;
+  Tzm = getNode(index+shiftNeighbor(5)).T;
+  Tzp = getNode(index+shiftNeighbor(6)).T;
 
   double Dxm, Dxp, Dym, Dyp, Dzm, Dzp;
 
@@ -1099,10 +1311,10 @@ float vtkPichonFastMarching::computeT(int index )
     for(int n=1;n<=nNeighbors;n++)
       {
     candidateIndex = index + shiftNeighbor(n);
-    if( (node[candidateIndex].status==fmsTRIAL)
-        || (node[candidateIndex].status==fmsKNOWN) )
+    if( (getNode(candidateIndex).status==fmsTRIAL)
+        || (getNode(candidateIndex).status==fmsKNOWN) )
       {
-        candidateT = node[candidateIndex].T + distanceNeighbor(n)/s;
+        candidateT = getNode(candidateIndex).T + distanceNeighbor(n)/s;
 
         if( candidateT<Tij )
           Tij=candidateT;
@@ -1177,8 +1389,9 @@ int vtkPichonFastMarching::addSeed( float r, float a, float s )
       seedPoints.push_back( I+J*dimX+K*dimXY );
 
       // use neighbors to create statistics
+      // (collected at the next evolution, when input data is available)
       for(int n=0;n<=26;n++)
-    collectInfoSeed( I+J*dimX+K*dimXY+shiftNeighbor(n) );
+        pendingSeedInfo.push_back( I+J*dimX+K*dimXY+shiftNeighbor(n) );
 
       // note: the neighbors will be put in TRIAL by setseed
 
@@ -1205,8 +1418,9 @@ int vtkPichonFastMarching::addSeedIJK( int I, int J, int K )
       seedPoints.push_back( I+J*dimX+K*dimXY );
 
       // use neighbors to create statistics
+      // (collected at the next evolution, when input data is available)
       for(int n=0;n<=26;n++)
-        collectInfoSeed( I+J*dimX+K*dimXY+shiftNeighbor(n) );
+        pendingSeedInfo.push_back( I+J*dimX+K*dimXY+shiftNeighbor(n) );
 
       // note: the neighbors will be put in TRIAL by setseed
 
@@ -1269,9 +1483,7 @@ void vtkPichonFastMarching::unInit( void )
   if(somethingReallyWrong)
     return;
 
-  delete [] node;
-  delete [] inhomo;
-  delete [] median;
+  freePages();
 
   // these are VTK objects, they should be destroyed by VTK's
   // garbage collector
@@ -1282,8 +1494,8 @@ void vtkPichonFastMarching::unInit( void )
   //  delete pdfIntensityIn;
   //  delete pdfInhomoIn;
 
-  while(tree.size()>0)
-    tree.pop_back();
+  clearTree();
+  pendingSeedInfo.clear();
 
   while(knownPoints.size()>0)
     {
@@ -1322,6 +1534,17 @@ void vtkPichonFastMarching::tweak(char *name, double value)
       return;
     }
 
+  if( strcmp( name, "legacyNarrowBand" )==0 )
+    {
+      legacyNarrowBand=(value!=0);
+      if( legacyNarrowBand )
+        leafIndex.assign( dimXYZ, -1 );
+      else
+        VecInt().swap( leafIndex );
+      clearTree();
+      return;
+    }
+
 
   vtkErrorMacro("Error in vtkPichonFastMarching::tweak(...): '" << name << "' not recognized !");
 }
@@ -42,14 +42,25 @@
 typedef enum fmstatus { fmsDONE, fmsKNOWN, fmsTRIAL, fmsFAR, fmsOUT } FMstatus;
 #define MASK_BIT 256
 
+/// number of voxels in a page of node data is 2^PAGE_SHIFT
+#define PAGE_SHIFT 12
+
 struct FMnode {
   FMstatus status;
   float T;
-  int leafIndex;
 };
 
+/// entry of the narrow band queue
 struct FMleaf {
   int nodeIndex;
+  float T; /// arrival time when the entry was queued, entry is obsolete if node T changed since then
+};
+
+/// node data of a range of consecutive voxels, only allocated when the front reaches it
+struct FMpage {
+  FMnode node[1 << PAGE_SHIFT];
+  int inhomo[1 << PAGE_SHIFT]; /// inhomogeneity, -1 if not computed yet
+  int median[1 << PAGE_SHIFT]; /// median intensity
 };
 
 /// these typedef are for tclwrapper...
@@ -139,14 +150,14 @@ private:
   bool initialized;
   bool firstCall;
 
-  FMnode *node;  /// arrival time and status for all voxels
-  int *inhomo; /// inhomogeneity
-  int *median; /// medican intensity
+  /// arrival time, status, median intensity, and inhomogeneity of voxels,
+  /// in pages that are allocated when first accessed
+  std::vector<FMpage*> pages;
 
   short* outdata; /// output
   short* indata;  /// input
 
-  /// size of the indata (=size outdata, node, inhomo)
+  /// size of the indata (=size outdata)
   int dimX;
   int dimY;
   int dimZ;
@@ -186,19 +197,44 @@ private:
   VecInt seedPoints;
   /// vector<int> seedPoints
 
-  /// minheap used by the fast marching algorithm
+  /// narrow band of the fast marching algorithm: monotone radix bucket queue.
+  /// Bucket 0 contains entries with the same key as the last removed entry,
+  /// bucket b contains entries whose key differs from it first at bit b-1.
+  /// Keys are the bit patterns of the (non-negative) arrival times, which have the same order.
+  VecFMleaf buckets[33];
+  unsigned int lastKey;
+  int queueSize; /// number of points in the narrow band (obsolete entries are not counted)
+
+  /// legacy narrow band: binary min-heap sorted on the current arrival times and updated in place.
+  /// Only used to check the bucket queue against the previous implementation,
+  /// enabled by tweak("legacyNarrowBand", 1) before the expansion starts.
+  bool legacyNarrowBand;
   VecFMleaf tree;
-  ///  vector<FMleaf> tree;
+  VecInt leafIndex; /// position of each voxel in tree, for the whole volume
+
+  /// points that were added as seeds before input data was available,
+  /// their statistics are collected at the first evolution
+  VecInt pendingSeedInfo;
 
   vtkPichonFastMarchingPDF *pdfIntensityIn;
   vtkPichonFastMarchingPDF *pdfInhomoIn;
 
   bool firstPassThroughShow;
 
-  /// minheap methods
+  /// node data access, allocates and initializes the page if needed
+  FMnode& getNode(int index);
+  FMpage* getPage(int index);
+  void freePages( void );
+  bool isBoundary(int i, int j, int k);
+
+  /// narrow band queue methods
   bool emptyTree(void);
   void insert(const FMleaf leaf);
+  void updateTree(const FMleaf leaf);
   FMleaf removeSmallest( void );
+  void clearTree(void);
+  void rebuildTree(unsigned int newLastKey);
+  int bucketIndex(unsigned int key);
   void downTree(int index);
   void upTree(int index);
 
@@ -213,6 +249,7 @@ private:
   void setSeed(int index );
 
   void collectInfoSeed(int index );
+  void collectInfoSeeds(const VecInt& indices );
   void collectInfoAll( void );
 
   float speed(int index );
@@ -8,6 +8,48 @@
 =========================================================================auto=*/
 #include "vtkPichonFastMarchingPDF.h"
 #include "vtkObjectFactory.h"
+#include <vtkMultiThreader.h>
+
+namespace
+{
+
+struct SmoothBinsJob
+{
+  int realizationMax;
+  int nRealInBins;
+  const int* bins;
+  const double* coefGauss;
+  double* smoothedBins;
+};
+
+// each thread computes the smoothed histogram in a range of bins
+VTK_THREAD_RETURN_TYPE smoothBinsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SmoothBinsJob* job = static_cast<SmoothBinsJob*>(info->UserData);
+  int nBins = job->realizationMax+1;
+  int begin = (int)((long long)nBins * info->ThreadID / info->NumberOfThreads);
+  int end = (int)((long long)nBins * (info->ThreadID + 1) / info->NumberOfThreads);
+
+  for(int k=begin;k<end;k++)
+    {
+      double val=0.0;
+      double nval=0.0;
+
+      for(int j=0;j<=job->realizationMax;j++)
+        {
+          double coef=job->coefGauss[abs(k-j)];
+
+          val+=coef*double(job->bins[j]);
+          nval+=coef;
+        }
+
+      job->smoothedBins[k]=val/nval/double(job->nRealInBins);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
 
 vtkPichonFastMarchingPDF::vtkPichonFastMarchingPDF( int _realizationMax )
 {
@@ -163,28 +205,23 @@ void vtkPichonFastMarchingPDF::update( void )
   for(int k=0;k<=realizationMax;k++)
     coefGauss[k]=exp(-0.5*double(k*k)/sigma2Smooth);
 
-  {
-
-    double val;
-    double nval;
-    double coef;
-
-    for(int k=0;k<=realizationMax;k++)
-      {
-    val=0.0;
-    nval=0.0;
-
-    for(int j=0;j<=realizationMax;j++)
-      {
-        coef=coefGauss[abs(k-j)];
-
-        val+=coef*double(bins[j]);
-        nval+=coef;
-      }
-
-    smoothedBins[k]=val/nval/double(nRealInBins);
-      }
-  }
+  // smoothing is quadratic in the number of bins (intensity range),
+  // compute it in parallel for large ranges
+  SmoothBinsJob job;
+  job.realizationMax=realizationMax;
+  job.nRealInBins=nRealInBins;
+  job.bins=bins;
+  job.coefGauss=coefGauss;
+  job.smoothedBins=smoothedBins;
+
+  int nThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  if( realizationMax < 1024 )
+    nThreads = 1;
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(nThreads);
+  threader->SetSingleMethod(smoothBinsThreadFunction, &job);
+  threader->SingleMethodExecute();
+  threader->Delete();
 }
 
 void vtkPichonFastMarchingPDF::addRealization( int k )
@@ -0,0 +1,187 @@
+import unittest
+import numpy
+import vtk
+import vtk.util.numpy_support
+import slicer
+
+class FastMarching(unittest.TestCase):
+  """Check the output of vtkPichonFastMarching, which stores the node data
+  in pages that are allocated when the front reaches them.
+  The same object is placed at different positions in volumes of different
+  sizes, so that page boundaries cut it differently: the marched region has
+  to be the same in all cases.
+  The result is also compared to the binary heap narrow band that was used
+  before the bucket queue.
+  """
+
+  # object coordinates of the bright box and of the seed cube
+  boxExtent = (8, 31, 6, 25, 4, 23)
+  seedCenter = (20, 16, 14)
+
+  def setUp(self):
+    pass
+
+  def runTest(self):
+    self.test_PageAlignment()
+    self.test_EvolutionHistory()
+    self.test_LegacyNarrowBand()
+    self.test_Abort()
+
+  def createVolumes(self, dimensions, offset):
+    """Return background and seed label images of the given dimensions with
+    the object starting at offset (in IJK order).
+    """
+    shape = (dimensions[2], dimensions[1], dimensions[0])
+    k, j, i = numpy.indices(shape)
+    i = i - offset[0]
+    j = j - offset[1]
+    k = k - offset[2]
+    # texture depends only on the object coordinates
+    background = 20 + (i * 7 + j * 13 + k * 5) % 10
+    e = self.boxExtent
+    inBox = (i >= e[0]) & (i <= e[1]) & (j >= e[2]) & (j <= e[3]) & (k >= e[4]) & (k <= e[5])
+    background[inBox] += 180
+    c = self.seedCenter
+    label = numpy.zeros(shape, dtype=numpy.int16)
+    label[(abs(i - c[0]) <= 1) & (abs(j - c[1]) <= 1) & (abs(k - c[2]) <= 1)] = 1
+    return self.imageFromArray(background.astype(numpy.int16)), self.imageFromArray(label), inBox
+
+  def imageFromArray(self, array):
+    image = vtk.vtkImageData()
+    image.SetDimensions(array.shape[2], array.shape[1], array.shape[0])
+    scalars = vtk.util.numpy_support.numpy_to_vtk(array.ravel(), deep=True, array_type=vtk.VTK_SHORT)
+    image.GetPointData().SetScalars(scalars)
+    return image
+
+  def createFilter(self, background, label, legacyNarrowBand=False):
+    """Set up the filter the same way as FastMarchingEffectLogic"""
+    dimensions = background.GetDimensions()
+    scalarRange = background.GetScalarRange()
+    fm = slicer.vtkPichonFastMarching()
+    fm.init(dimensions[0], dimensions[1], dimensions[2], scalarRange[1] - scalarRange[0], 1, 1, 1)
+    if legacyNarrowBand:
+      fm.tweak('legacyNarrowBand', 1)
+    fm.SetInputData(background)
+    fm.setActiveLabel(1)
+    self.assertEqual(fm.addSeedsFromImage(label), 27)
+    # first update only initializes the filter
+    fm.Update()
+    return fm
+
+  def march(self, fm, numberOfPoints):
+    fm.setNPointsEvolution(numberOfPoints)
+    fm.Modified()
+    fm.Update()
+    return self.show(fm, 1)
+
+  def show(self, fm, fraction):
+    fm.show(fraction)
+    fm.Modified()
+    fm.Update()
+    output = fm.GetOutput()
+    dimensions = output.GetDimensions()
+    return vtk.util.numpy_support.vtk_to_numpy(output.GetPointData().GetScalars()).reshape(
+      dimensions[2], dimensions[1], dimensions[0]).copy()
+
+  def crop(self, array, offset, dimensions):
+    return array[offset[2]:offset[2] + dimensions[2], offset[1]:offset[1] + dimensions[1], offset[0]:offset[0] + dimensions[0]]
+
+  def test_PageAlignment(self):
+    """The marched region does not depend on the position of the object in the volume"""
+    dimensions = (40, 32, 28)
+    placements = [
+      ((40, 32, 28), (0, 0, 0)),
+      ((53, 41, 37), (5, 3, 6)),
+      ((97, 35, 30), (51, 1, 2)),
+      ]
+    numberOfPoints = 2000
+    reference = None
+    for volumeDimensions, offset in placements:
+      background, label, inBox = self.createVolumes(volumeDimensions, offset)
+      fm = self.createFilter(background, label)
+      output = self.march(fm, numberOfPoints)
+      self.assertEqual(fm.nKnownPoints(), 27 + numberOfPoints)
+      # every known point is labeled and the front did not leave the bright box
+      self.assertEqual(numpy.count_nonzero(output == 1), fm.nKnownPoints())
+      self.assertEqual(numpy.count_nonzero((output == 1) & ~inBox), 0)
+      objectOutput = self.crop(output, offset, dimensions)
+      self.assertEqual(numpy.count_nonzero(objectOutput == 1), fm.nKnownPoints())
+      if reference is None:
+        reference = objectOutput
+      else:
+        self.assertTrue(numpy.array_equal(objectOutput == 1, reference == 1))
+
+  def test_EvolutionHistory(self):
+    """Going back in the evolution and marching again gives the same result for any page alignment"""
+    dimensions = (40, 32, 28)
+    placements = [
+      ((40, 32, 28), (0, 0, 0)),
+      ((61, 39, 33), (13, 4, 3)),
+      ]
+    numberOfPoints = 2000
+    references = None
+    for volumeDimensions, offset in placements:
+      background, label, inBox = self.createVolumes(volumeDimensions, offset)
+      fm = self.createFilter(background, label)
+      fullOutput = self.march(fm, numberOfPoints)
+      numberOfKnownPoints = fm.nKnownPoints()
+
+      # showing part of the evolution removes the last known points from the label
+      halfOutput = self.show(fm, 0.5)
+      numberOfShownPoints = int((numberOfKnownPoints - 1) * 0.5) + 1
+      self.assertEqual(numpy.count_nonzero(halfOutput == 1), numberOfShownPoints)
+      self.assertEqual(numpy.count_nonzero((halfOutput == 1) & (fullOutput != 1)), 0)
+      self.assertTrue(numpy.array_equal(self.show(fm, 1) == 1, fullOutput == 1))
+
+      # marching from the middle of the evolution puts points back in the queue
+      self.show(fm, 0.5)
+      continuedOutput = self.march(fm, numberOfPoints)
+      self.assertEqual(fm.nKnownPoints(), numberOfShownPoints - 1 + numberOfPoints)
+      self.assertEqual(numpy.count_nonzero((continuedOutput == 1) & ~inBox), 0)
+
+      outputs = [self.crop(fullOutput, offset, dimensions) == 1, self.crop(continuedOutput, offset, dimensions) == 1]
+      if references is None:
+        references = outputs
+      else:
+        for output, reference in zip(outputs, references):
+          self.assertTrue(numpy.array_equal(output, reference))
+
+  def test_LegacyNarrowBand(self):
+    """The bucket queue marches the same region as the legacy binary heap from the same seeds.
+    Points with equal arrival times may be removed in a different order, which changes
+    the statistics used by the speed function slightly, so only a few points
+    at the border of the region may differ.
+    """
+    background, label, inBox = self.createVolumes((53, 41, 37), (5, 3, 6))
+    numberOfPoints = 2000
+    outputs = []
+    for legacyNarrowBand in [False, True]:
+      fm = self.createFilter(background, label, legacyNarrowBand)
+      fullOutput = self.march(fm, numberOfPoints)
+      self.assertEqual(fm.nKnownPoints(), 27 + numberOfPoints)
+      # going back in the evolution puts points back in the queue
+      self.show(fm, 0.5)
+      continuedOutput = self.march(fm, numberOfPoints)
+      numberOfContinuedPoints = fm.nKnownPoints()
+      self.assertEqual(numpy.count_nonzero((continuedOutput == 1) & ~inBox), 0)
+      outputs.append((fullOutput == 1, continuedOutput == 1, numberOfContinuedPoints))
+
+    (pagedFull, pagedContinued, pagedCount), (legacyFull, legacyContinued, legacyCount) = outputs
+    self.assertEqual(pagedCount, legacyCount)
+    maximumDifference = (27 + numberOfPoints) * 0.02
+    self.assertTrue(numpy.count_nonzero(pagedFull != legacyFull) <= maximumDifference)
+    self.assertTrue(numpy.count_nonzero(pagedContinued != legacyContinued) <= maximumDifference)
+
+  def test_Abort(self):
+    """Expansion stops when abort is requested from a progress observer"""
+    background, label, inBox = self.createVolumes((40, 32, 28), (0, 0, 0))
+    fm = self.createFilter(background, label)
+    def abortExpansion(caller, event):
+      if caller.GetProgress() >= 0.5:
+        caller.SetAbortExecute(1)
+    fm.AddObserver(vtk.vtkCommand.ProgressEvent, abortExpansion)
+    numberOfPoints = 2000
+    output = self.march(fm, numberOfPoints)
+    self.assertTrue(fm.nKnownPoints() > 27)
+    self.assertTrue(fm.nKnownPoints() < 27 + numberOfPoints)
+    self.assertEqual(numpy.count_nonzero(output == 1), fm.nKnownPoints())
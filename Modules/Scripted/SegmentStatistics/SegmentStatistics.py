@@ -198,6 +198,29 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
     self.addGrayscaleVolumeStatistics()
     self.addSegmentClosedSurfaceStatistics()
 
+  def getSegmentLabelmapGroups(self):
+    """Group segments by the labelmap that stores them, so that statistics of each group
+    can be computed in a single pass.
+    Returns list of (labelmap, {labelValue: segmentID}, mergeNonZeroLabels) tuples. Segments stored
+    in a shared multi-label labelmap are put in the same group, other segments are in a group of their
+    own with label value 1 and mergeNonZeroLabels enabled (all non-zero voxels belong to the segment).
+    """
+    import vtkSegmentationCorePython as vtkSegmentationCore
+    labelmapGroups = []
+    sharedLabelmapGroupIndices = {}
+    for segmentID in self.statistics["SegmentIDs"]:
+      segment = self.segmentationNode.GetSegmentation().GetSegment(segmentID)
+      sharedLabelmap = segment.GetSharedLabelmap()
+      if sharedLabelmap is not None:
+        if sharedLabelmap not in sharedLabelmapGroupIndices:
+          sharedLabelmapGroupIndices[sharedLabelmap] = len(labelmapGroups)
+          labelmapGroups.append((sharedLabelmap, {}, False))
+        labelmapGroups[sharedLabelmapGroupIndices[sharedLabelmap]][1][segment.GetSharedLabelValue()] = segmentID
+      else:
+        segmentLabelmap = segment.GetRepresentation(vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
+        labelmapGroups.append((segmentLabelmap, {1: segmentID}, True))
+    return labelmapGroups
+
   def addSegmentLabelmapStatistics(self):
     import vtkSegmentationCorePython as vtkSegmentationCore
 
@@ -206,38 +229,20 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
     if not containsLabelmapRepresentation:
       return
 
-    for segmentID in self.statistics["SegmentIDs"]:
-      segment = self.segmentationNode.GetSegmentation().GetSegment(segmentID)
-      segmentLabelmap = segment.GetRepresentation(vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
-
-      # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-      labelValue = 1
-      backgroundValue = 0
-      thresh = vtk.vtkImageThreshold()
-      thresh.SetInputData(segmentLabelmap)
-      thresh.ThresholdByLower(0)
-      thresh.SetInValue(backgroundValue)
-      thresh.SetOutValue(labelValue)
-      thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-      thresh.Update()
-
-      #  Use binary labelmap as a stencil
-      stencil = vtk.vtkImageToImageStencil()
-      stencil.SetInputData(thresh.GetOutput())
-      stencil.ThresholdByUpper(labelValue)
-      stencil.Update()
-
-      stat = vtk.vtkImageAccumulate()
-      stat.SetInputData(thresh.GetOutput())
-      stat.SetStencilData(stencil.GetOutput())
-      stat.Update()
+    ccPerCubicMM = 0.001
+    calculator = vtkSegmentationCore.vtkCalculateLabelStatistics()
+    for labelmap, segmentIDsByLabel, mergeNonZeroLabels in self.getSegmentLabelmapGroups():
+      # All segments stored in the same labelmap are computed in one pass
+      calculator.SetLabelImageData(labelmap)
+      calculator.SetMergeNonZeroLabels(mergeNonZeroLabels)
+      calculator.SetVoxelVolume(reduce(lambda x,y: x*y, labelmap.GetSpacing()))
+      calculator.Calculate()
 
       # Add data to statistics list
-      cubicMMPerVoxel = reduce(lambda x,y: x*y, segmentLabelmap.GetSpacing())
-      ccPerCubicMM = 0.001
-      self.statistics[segmentID,"LM voxel count"] = stat.GetVoxelCount()
-      self.statistics[segmentID,"LM volume mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-      self.statistics[segmentID,"LM volume cc"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
+      for labelValue, segmentID in segmentIDsByLabel.items():
+        self.statistics[segmentID,"LM voxel count"] = calculator.GetVoxelCount(labelValue)
+        self.statistics[segmentID,"LM volume mm3"] = calculator.GetVolume(labelValue)
+        self.statistics[segmentID,"LM volume cc"] = calculator.GetVolume(labelValue) * ccPerCubicMM
 
   def addSegmentClosedSurfaceStatistics(self):
     import vtkSegmentationCorePython as vtkSegmentationCore
@@ -287,48 +292,33 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
     cubicMMPerVoxel = reduce(lambda x,y: x*y, referenceGeometry_Reference.GetSpacing())
     ccPerCubicMM = 0.001
 
-    for segmentID in self.statistics["SegmentIDs"]:
-      segment = self.segmentationNode.GetSegmentation().GetSegment(segmentID)
-      segmentLabelmap = segment.GetRepresentation(vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
-
-      segmentLabelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
+    calculator = vtkSegmentationCore.vtkCalculateLabelStatistics()
+    calculator.SetScalarImageData(self.grayscaleNode.GetImageData())
+    calculator.SetVoxelVolume(cubicMMPerVoxel)
+    for labelmap, segmentIDsByLabel, mergeNonZeroLabels in self.getSegmentLabelmapGroups():
+      labelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
       vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
-        segmentLabelmap, referenceGeometry_Reference, segmentLabelmap_Reference,
+        labelmap, referenceGeometry_Reference, labelmap_Reference,
         False, # nearest neighbor interpolation
         False, # no padding
         segmentationToReferenceGeometryTransform)
 
-      # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-      labelValue = 1
-      backgroundValue = 0
-      thresh = vtk.vtkImageThreshold()
-      thresh.SetInputData(segmentLabelmap_Reference)
-      thresh.ThresholdByLower(0)
-      thresh.SetInValue(backgroundValue)
-      thresh.SetOutValue(labelValue)
-      thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-      thresh.Update()
-
-      #  Use binary labelmap as a stencil
-      stencil = vtk.vtkImageToImageStencil()
-      stencil.SetInputData(thresh.GetOutput())
-      stencil.ThresholdByUpper(labelValue)
-      stencil.Update()
-
-      stat = vtk.vtkImageAccumulate()
-      stat.SetInputData(self.grayscaleNode.GetImageData())
-      stat.SetStencilData(stencil.GetOutput())
-      stat.Update()
+      # All segments stored in the same labelmap are computed in one pass
+      calculator.SetLabelImageData(labelmap_Reference)
+      calculator.SetMergeNonZeroLabels(mergeNonZeroLabels)
+      calculator.Calculate()
 
       # Add data to statistics list
-      self.statistics[segmentID,"GS voxel count"] = stat.GetVoxelCount()
-      self.statistics[segmentID,"GS volume mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-      self.statistics[segmentID,"GS volume cc"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
-      if stat.GetVoxelCount()>0:
-        self.statistics[segmentID,"GS min"] = stat.GetMin()[0]
-        self.statistics[segmentID,"GS max"] = stat.GetMax()[0]
-        self.statistics[segmentID,"GS mean"] = stat.GetMean()[0]
-        self.statistics[segmentID,"GS stdev"] = stat.GetStandardDeviation()[0]
+      for labelValue, segmentID in segmentIDsByLabel.items():
+        voxelCount = calculator.GetVoxelCount(labelValue)
+        self.statistics[segmentID,"GS voxel count"] = voxelCount
+        self.statistics[segmentID,"GS volume mm3"] = voxelCount * cubicMMPerVoxel
+        self.statistics[segmentID,"GS volume cc"] = voxelCount * cubicMMPerVoxel * ccPerCubicMM
+        if voxelCount>0:
+          self.statistics[segmentID,"GS min"] = calculator.GetMinimum(labelValue)
+          self.statistics[segmentID,"GS max"] = calculator.GetMaximum(labelValue)
+          self.statistics[segmentID,"GS mean"] = calculator.GetMean(labelValue)
+          self.statistics[segmentID,"GS stdev"] = calculator.GetStandardDeviation(labelValue)
 
   def getStatisticsValueAsString(self, segmentID, key):
     if self.statistics.has_key((segmentID, key)):